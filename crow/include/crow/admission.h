@@ -0,0 +1,178 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <boost/asio/ip/address.hpp>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+
+namespace crow
+{
+
+struct AdmissionLimits
+{
+    // Open HTTP connections, from all clients
+    size_t maxConnections = 128;
+    // Open HTTP connections from one address
+    size_t maxConnectionsPerClient = 32;
+    // Requests read and not yet answered
+    size_t maxRequestsInFlight = 48;
+    // Of the connections and requests above, how many only interactive
+    // sessions may use, so that KVM and the host console can still connect
+    // while bulk traffic has the rest
+    size_t reservedConnections = 8;
+    size_t reservedRequests = 4;
+    // Sent with the 503 a shed request or refused connection gets
+    std::chrono::seconds retryAfter{5};
+    // Refused connections being answered with 503 at once; answering one
+    // over TLS takes a handshake, so past this they are closed unanswered
+    size_t maxRefusalsAnswered = 8;
+};
+
+// Totals since startup
+struct AdmissionCounters
+{
+    // Connections refused when accepted, over a connection limit
+    std::atomic<uint64_t> refusedConnections{0};
+    // Requests answered with 503
+    std::atomic<uint64_t> shedRequests{0};
+};
+
+// Counts open connections and requests in flight against AdmissionLimits.
+// Connections are counted when accepted, requests once their headers are
+// read.  Connections are accepted and served on several threads, so all of
+// it is under one lock.
+class AdmissionControl
+{
+  public:
+    void setLimits(const AdmissionLimits& newLimits)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentLimits = newLimits;
+    }
+
+    AdmissionLimits limits()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return currentLimits;
+    }
+
+    // For a connection just accepted from client.  When false, it should be
+    // refused without reading a request from it, and not passed to
+    // closeConnection().
+    bool openConnection(const boost::asio::ip::address& client)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t& fromClient = clients[client];
+        if (connections >= currentLimits.maxConnections ||
+            fromClient >= currentLimits.maxConnectionsPerClient)
+        {
+            if (fromClient == 0)
+            {
+                clients.erase(client);
+            }
+            counters.refusedConnections++;
+            return false;
+        }
+        connections++;
+        fromClient++;
+        return true;
+    }
+
+    void closeConnection(const boost::asio::ip::address& client)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        connections--;
+        auto it = clients.find(client);
+        if (it != clients.end() && --it->second == 0)
+        {
+            clients.erase(it);
+        }
+    }
+
+    // For a request whose headers were just read.  Bulk requests may only
+    // use the unreserved part of each limit; interactive ones, websocket
+    // upgrades for KVM and the console, may use all of it.  When false, the
+    // request should be answered with 503, and not passed to
+    // finishRequest().
+    bool startRequest(bool interactive)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t maxConnections = currentLimits.maxConnections;
+        size_t maxRequests = currentLimits.maxRequestsInFlight;
+        if (!interactive)
+        {
+            maxConnections -=
+                std::min(maxConnections, currentLimits.reservedConnections);
+            maxRequests -=
+                std::min(maxRequests, currentLimits.reservedRequests);
+        }
+        if (connections > maxConnections || requests >= maxRequests)
+        {
+            counters.shedRequests++;
+            return false;
+        }
+        requests++;
+        return true;
+    }
+
+    void finishRequest()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        requests--;
+    }
+
+    // For a refused connection about to be answered with 503.  When false,
+    // it should be closed unanswered, and not passed to finishRefusal().
+    bool startRefusal()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (refusals >= currentLimits.maxRefusalsAnswered)
+        {
+            return false;
+        }
+        refusals++;
+        return true;
+    }
+
+    void finishRefusal()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        refusals--;
+    }
+
+    size_t openConnections()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return connections;
+    }
+
+    size_t requestsInFlight()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return requests;
+    }
+
+    const AdmissionCounters& getCounters() const
+    {
+        return counters;
+    }
+
+  private:
+    std::mutex mutex;
+    AdmissionLimits currentLimits;
+    size_t connections{0};
+    size_t requests{0};
+    size_t refusals{0};
+    std::map<boost::asio::ip::address, size_t> clients;
+    AdmissionCounters counters;
+};
+
+inline AdmissionControl& admissionControl()
+{
+    static AdmissionControl control;
+    return control;
+}
+
+} // namespace crow
@@ -8,8 +8,10 @@
 #include <string>
 #include <utility>
 
+#include "crow/admission.h"
 #include "crow/http_request.h"
 #include "crow/http_server.h"
+#include "crow/keep_alive.h"
 #include "crow/logging.h"
 #include "crow/middleware_context.h"
 #include "crow/routing.h"
@@ -28,6 +30,7 @@ template <typename... Middlewares> class Crow
   public:
     using self_t = Crow;
     using server_t = Server<Crow, SocketAdaptor, Middlewares...>;
+    using local_server_t = Server<Crow, UnixSocketAdaptor, Middlewares...>;
 #ifdef BMCWEB_ENABLE_SSL
     using ssl_server_t = Server<Crow, SSLAdaptor, Middlewares...>;
 #endif
@@ -47,9 +50,25 @@ template <typename... Middlewares> class Crow
         router.handleUpgrade(req, res, adaptor);
     }
 
-    void handle(const Request& req, Response& res)
+    void handle(const Request& req, Response& res, unsigned* matched = nullptr)
     {
-        router.handle(req, res);
+        router.handle(req, res, matched);
+    }
+
+    RouteMetrics* routeMetrics(unsigned ruleIndex)
+    {
+        return router.routeMetrics(ruleIndex);
+    }
+
+    // Per route latencies and connection counters, in Prometheus text format
+    std::string metricsText() const
+    {
+        return router.metricsText();
+    }
+
+    const std::string* findBodyFileDirectory(const Request& req) const
+    {
+        return router.findBodyFileDirectory(req);
     }
 
     DynamicRule& routeDynamic(std::string&& rule)
@@ -70,6 +89,13 @@ template <typename... Middlewares> class Crow
         return *this;
     }
 
+    // A listening Unix socket to also serve, for clients on the BMC itself
+    self_t& localSocket(int existing_socket)
+    {
+        localSocketFd = existing_socket;
+        return *this;
+    }
+
     self_t& port(std::uint16_t port)
     {
         portUint = port;
@@ -82,6 +108,28 @@ template <typename... Middlewares> class Crow
         return *this;
     }
 
+#ifdef BMCWEB_ENABLE_IO_THREAD_POOL
+    // Service connection I/O (TLS, parsing, serialization) from this many
+    // worker threads.  Middlewares and handlers still run on the io_service
+    // given to the constructor.
+    self_t& workerThreads(size_t count)
+    {
+        workerThreadCount = count;
+        return *this;
+    }
+#else
+    template <typename T> self_t& workerThreads(T&&)
+    {
+        // We can't call .workerThreads() unless BMCWEB_ENABLE_IO_THREAD_POOL
+        // is defined.
+        static_assert(
+            // make static_assert dependent to T; always false
+            std::is_base_of<T, void>::value,
+            "Define BMCWEB_ENABLE_IO_THREAD_POOL to enable io worker threads.");
+        return *this;
+    }
+#endif
+
     void validate()
     {
         router.validate();
@@ -90,6 +138,12 @@ template <typename... Middlewares> class Crow
     void run()
     {
         validate();
+        if (-1 != localSocketFd)
+        {
+            localServer = std::make_unique<local_server_t>(
+                this, localSocketFd, &middlewares, nullptr, io);
+            localServer->run();
+        }
 #ifdef BMCWEB_ENABLE_SSL
         if (useSsl)
         {
@@ -105,6 +159,9 @@ template <typename... Middlewares> class Crow
                     this, socketFd, &middlewares, &sslContext, io));
             }
             sslServer->setTickFunction(tickInterval, tickFunction);
+#ifdef BMCWEB_ENABLE_IO_THREAD_POOL
+            sslServer->setWorkerThreads(workerThreadCount);
+#endif
             sslServer->run();
         }
         else
@@ -121,12 +178,29 @@ template <typename... Middlewares> class Crow
                     this, socketFd, &middlewares, nullptr, io));
             }
             server->setTickFunction(tickInterval, tickFunction);
+#ifdef BMCWEB_ENABLE_IO_THREAD_POOL
+            server->setWorkerThreads(workerThreadCount);
+#endif
             server->run();
         }
     }
 
     void stop()
     {
+#ifdef BMCWEB_ENABLE_SSL
+        if (sslServer != nullptr)
+        {
+            sslServer->stop();
+        }
+#endif
+        if (server != nullptr)
+        {
+            server->stop();
+        }
+        if (localServer != nullptr)
+        {
+            localServer->stop();
+        }
         io->stop();
     }
 
@@ -147,6 +221,11 @@ template <typename... Middlewares> class Crow
         return router.getRoutes(parent);
     }
 
+    std::vector<const std::string*> getAllRoutes() const
+    {
+        return router.getAllRoutes();
+    }
+
 #ifdef BMCWEB_ENABLE_SSL
     self_t& sslFile(const std::string& crt_filename,
                     const std::string& key_filename)
@@ -221,6 +300,22 @@ template <typename... Middlewares> class Crow
         return utility::getElementByType<T, Middlewares...>(middlewares);
     }
 
+    // How many connections and requests are served at once; past that,
+    // connections are refused and requests answered with 503
+    self_t& admissionLimits(const AdmissionLimits& limits)
+    {
+        admissionControl().setLimits(limits);
+        return *this;
+    }
+
+    // How long connections are kept open between requests, how many they
+    // serve, and how long reading a request may take
+    self_t& keepAlivePolicy(const KeepAlivePolicy& policy)
+    {
+        connectionReuse().setPolicy(policy);
+        return *this;
+    }
+
     template <typename Duration, typename Func> self_t& tick(Duration d, Func f)
     {
         tickInterval = std::chrono::duration_cast<std::chrono::milliseconds>(d);
@@ -233,10 +328,14 @@ template <typename... Middlewares> class Crow
     uint16_t portUint = 80;
     std::string bindaddrStr = "::";
     int socketFd = -1;
+    int localSocketFd = -1;
     Router router;
 
     std::chrono::milliseconds tickInterval{};
     std::function<void()> tickFunction;
+#ifdef BMCWEB_ENABLE_IO_THREAD_POOL
+    size_t workerThreadCount{0};
+#endif
 
     std::tuple<Middlewares...> middlewares;
 
@@ -244,6 +343,7 @@ template <typename... Middlewares> class Crow
     std::unique_ptr<ssl_server_t> sslServer;
 #endif
     std::unique_ptr<server_t> server;
+    std::unique_ptr<local_server_t> localServer;
 };
 template <typename... Middlewares> using App = Crow<Middlewares...>;
 using SimpleApp = Crow<>;
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace crow
+{
+
+/**
+ * @brief Hands out memory from a few large blocks, and takes it all back at
+ *        once
+ *
+ * Freeing a single allocation does nothing; reset() makes the whole arena
+ * free again.  After a reset the arena keeps one block as big as everything
+ * the last round used, up to maxRetained, so a connection serving the same
+ * kind of request over and over stops calling malloc after the first one.
+ *
+ * Not thread safe.  Everything allocated from the arena must be destroyed
+ * before reset() or the destructor.
+ */
+class Arena
+{
+  public:
+    static constexpr size_t defaultBlockSize = 16 * 1024;
+    static constexpr size_t maxRetained = 256 * 1024;
+
+    explicit Arena(size_t blockSize = defaultBlockSize) : blockSize(blockSize)
+    {
+    }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    ~Arena()
+    {
+        freeBlocks(head);
+    }
+
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+    {
+        uintptr_t start = (current + alignment - 1) & ~(alignment - 1);
+        if (head == nullptr || start + size > end)
+        {
+            addBlock(size + alignment);
+            start = (current + alignment - 1) & ~(alignment - 1);
+        }
+        current = start + size;
+        used += size;
+        return reinterpret_cast<void*>(start);
+    }
+
+    void reset()
+    {
+        if (head != nullptr && head->next != nullptr)
+        {
+            // Replace the chain with one block that would have held it all
+            size_t total = 0;
+            for (Block* block = head; block != nullptr; block = block->next)
+            {
+                total += block->size;
+            }
+            freeBlocks(head);
+            head = nullptr;
+            addBlock(std::min(total, maxRetained));
+        }
+        if (head != nullptr)
+        {
+            current = head->data();
+            end = current + head->size;
+        }
+        used = 0;
+    }
+
+    // Bytes handed out since the last reset
+    size_t bytesUsed() const
+    {
+        return used;
+    }
+
+    size_t blockCount() const
+    {
+        size_t count = 0;
+        for (Block* block = head; block != nullptr; block = block->next)
+        {
+            count++;
+        }
+        return count;
+    }
+
+  private:
+    struct Block
+    {
+        Block* next;
+        size_t size;
+
+        uintptr_t data()
+        {
+            return reinterpret_cast<uintptr_t>(this + 1);
+        }
+    };
+
+    void addBlock(size_t atLeast)
+    {
+        size_t size = std::max(blockSize, atLeast);
+        void* memory = std::malloc(sizeof(Block) + size);
+        if (memory == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        Block* block = new (memory) Block{head, size};
+        head = block;
+        current = block->data();
+        end = current + size;
+    }
+
+    static void freeBlocks(Block* block)
+    {
+        while (block != nullptr)
+        {
+            Block* next = block->next;
+            std::free(block);
+            block = next;
+        }
+    }
+
+    size_t blockSize;
+    Block* head = nullptr;
+    uintptr_t current = 0;
+    uintptr_t end = 0;
+    size_t used = 0;
+};
+
+/**
+ * @brief Allocates from an Arena, or from the heap when it has none, so
+ *        code can take an arena where there may not be one
+ */
+template <typename T> class ArenaAllocator
+{
+  public:
+    using value_type = T;
+
+    ArenaAllocator(Arena* arena = nullptr) : arena(arena)
+    {
+    }
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena)
+    {
+    }
+
+    T* allocate(size_t n)
+    {
+        if (arena == nullptr)
+        {
+            return std::allocator<T>().allocate(n);
+        }
+        return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, size_t n)
+    {
+        if (arena == nullptr)
+        {
+            std::allocator<T>().deallocate(p, n);
+        }
+    }
+
+    template <typename U> bool operator==(const ArenaAllocator<U>& other) const
+    {
+        return arena == other.arena;
+    }
+
+    template <typename U> bool operator!=(const ArenaAllocator<U>& other) const
+    {
+        return arena != other.arena;
+    }
+
+  private:
+    template <typename U> friend class ArenaAllocator;
+
+    Arena* arena;
+};
+
+/**
+ * @brief std::allocate_shared from arena, which may be null
+ */
+template <typename T, typename... Args>
+std::shared_ptr<T> allocateShared(Arena* arena, Args&&... args)
+{
+    return std::allocate_shared<T>(ArenaAllocator<T>(arena),
+                                   std::forward<Args>(args)...);
+}
+
+} // namespace crow
@@ -0,0 +1,265 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+/* Vector kernels for the bulk of base64 encoding and decoding.  They take
+ * whole blocks from the front of the input and leave the tail, padding and
+ * anything they don't recognise to the scalar code in utility.h.
+ *
+ * CROW_BASE64_SIMD is defined when the target has SSSE3 or NEON; defining
+ * CROW_BASE64_SCALAR forces the scalar code.  Plain x86-64 only guarantees
+ * SSE2, which has no byte shuffle, so x86 builds need -mssse3 or a -march
+ * that implies it to get the vector path.
+ */
+#if !defined(CROW_BASE64_SCALAR) && defined(__SSSE3__)
+#include <tmmintrin.h>
+#define CROW_BASE64_SIMD 1
+#elif !defined(CROW_BASE64_SCALAR) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define CROW_BASE64_SIMD 1
+#endif
+
+namespace crow
+{
+namespace base64_simd
+{
+
+// The kernels only know the standard alphabet, and alphabets that differ
+// from it in the last two characters, like the URL safe one
+inline bool isStandardBelow62(const char* key)
+{
+    static const char standard[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+    return std::memcmp(key, standard, 62) == 0;
+}
+
+#if defined(CROW_BASE64_SIMD) && defined(__SSSE3__)
+
+/* Encodes 12 byte blocks from the front of data into 16 characters each,
+ * while 16 bytes can be loaded.  Returns the number of bytes used.
+ */
+inline size_t encodeBlocks(const unsigned char* data, size_t size, char* out,
+                           const char* key)
+{
+    if (!isStandardBelow62(key))
+    {
+        return 0;
+    }
+    // Offsets from the 6 bit value to its character, indexed by the value
+    // folded into 0..13 below
+    const __m128i offsets = _mm_setr_epi8(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        static_cast<char>(key[62] - 62), static_cast<char>(key[63] - 63), 'A',
+        0, 0);
+    const unsigned char* in = data;
+    while (size >= 16)
+    {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+        // Each 32 bit lane gets one 3 byte group as b1 b0 b2 b1
+        bytes = _mm_shuffle_epi8(
+            bytes, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2,
+                                0, 1));
+        // Move the four 6 bit fields of each lane into a byte each
+        __m128i hi = _mm_mulhi_epu16(
+            _mm_and_si128(bytes, _mm_set1_epi32(0x0fc0fc00)),
+            _mm_set1_epi32(0x04000040));
+        __m128i lo = _mm_mullo_epi16(
+            _mm_and_si128(bytes, _mm_set1_epi32(0x003f03f0)),
+            _mm_set1_epi32(0x01000010));
+        __m128i values = _mm_or_si128(hi, lo);
+
+        // 52..63 fold to 1..12, 0..25 to 13 and 26..51 to 0
+        __m128i index = _mm_subs_epu8(values, _mm_set1_epi8(51));
+        __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), values);
+        index = _mm_or_si128(index,
+                             _mm_and_si128(upper, _mm_set1_epi8(13)));
+        __m128i chars =
+            _mm_add_epi8(values, _mm_shuffle_epi8(offsets, index));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), chars);
+
+        in += 12;
+        out += 16;
+        size -= 12;
+    }
+    return static_cast<size_t>(in - data);
+}
+
+/* Decodes 16 character blocks from the front of data into 12 bytes each,
+ * stopping at the first block with padding or a character outside the
+ * standard alphabet.  Returns the number of characters used.
+ */
+inline size_t decodeBlocks(const char* data, size_t size, char* out)
+{
+    // A character is valid when the bits its low and its high nibble look
+    // up have nothing in common
+    const __m128i lowBits =
+        _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                      0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    const __m128i highBits =
+        _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10,
+                      0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    // Offsets from a character to its value, indexed by its high nibble,
+    // with '/' moved to 1
+    const __m128i offsets = _mm_setr_epi8(0, 63 - '/', 62 - '+', 52 - '0',
+                                          -'A', -'A', 26 - 'a', 26 - 'a', 0,
+                                          0, 0, 0, 0, 0, 0, 0);
+    const __m128i slash = _mm_set1_epi8('/');
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+
+    const char* in = data;
+    while (size >= 16)
+    {
+        __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+        // Bytes over 127 have a high nibble of 8 or more, which finds 0x10
+        __m128i high = _mm_and_si128(_mm_srli_epi32(chars, 4), nibble);
+        __m128i low = _mm_and_si128(chars, nibble);
+        __m128i invalid = _mm_and_si128(_mm_shuffle_epi8(lowBits, low),
+                                        _mm_shuffle_epi8(highBits, high));
+        if (_mm_movemask_epi8(
+                _mm_cmpeq_epi8(invalid, _mm_setzero_si128())) != 0xffff)
+        {
+            break;
+        }
+        __m128i index = _mm_add_epi8(_mm_cmpeq_epi8(chars, slash), high);
+        __m128i values =
+            _mm_add_epi8(chars, _mm_shuffle_epi8(offsets, index));
+
+        // Pack each lane's four 6 bit values into three bytes, then put
+        // the bytes of all four lanes together in order
+        __m128i pairs =
+            _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+        __m128i groups = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+        __m128i bytes = _mm_shuffle_epi8(
+            groups, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1,
+                                  -1, -1, -1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out), bytes);
+        uint32_t last = static_cast<uint32_t>(
+            _mm_cvtsi128_si32(_mm_srli_si128(bytes, 8)));
+        std::memcpy(out + 8, &last, sizeof(last));
+
+        in += 16;
+        out += 12;
+        size -= 16;
+    }
+    return static_cast<size_t>(in - data);
+}
+
+#elif defined(CROW_BASE64_SIMD)
+
+/* Encodes 24 byte blocks from the front of data into 32 characters each.
+ * Returns the number of bytes used.
+ */
+inline size_t encodeBlocks(const unsigned char* data, size_t size, char* out,
+                           const char* key)
+{
+    if (!isStandardBelow62(key))
+    {
+        return 0;
+    }
+    const uint8x8_t mask = vdup_n_u8(0x3f);
+    const unsigned char* in = data;
+    while (size >= 24)
+    {
+        uint8x8x3_t bytes = vld3_u8(in);
+        uint8x8x4_t values;
+        values.val[0] = vshr_n_u8(bytes.val[0], 2);
+        values.val[1] = vand_u8(vorr_u8(vshl_n_u8(bytes.val[0], 4),
+                                        vshr_n_u8(bytes.val[1], 4)),
+                                mask);
+        values.val[2] = vand_u8(vorr_u8(vshl_n_u8(bytes.val[1], 2),
+                                        vshr_n_u8(bytes.val[2], 6)),
+                                mask);
+        values.val[3] = vand_u8(bytes.val[2], mask);
+        for (uint8x8_t& v : values.val)
+        {
+            // 'A' + v, moved up to 'a' from 26 and down to '0' from 52
+            uint8x8_t c = vadd_u8(v, vdup_n_u8('A'));
+            c = vadd_u8(c, vand_u8(vcge_u8(v, vdup_n_u8(26)),
+                                   vdup_n_u8('a' - 'A' - 26)));
+            c = vsub_u8(c, vand_u8(vcge_u8(v, vdup_n_u8(52)),
+                                   vdup_n_u8('a' + 26 - '0')));
+            c = vbsl_u8(vceq_u8(v, vdup_n_u8(62)),
+                        vdup_n_u8(static_cast<uint8_t>(key[62])), c);
+            c = vbsl_u8(vceq_u8(v, vdup_n_u8(63)),
+                        vdup_n_u8(static_cast<uint8_t>(key[63])), c);
+            v = c;
+        }
+        vst4_u8(reinterpret_cast<uint8_t*>(out), values);
+
+        in += 24;
+        out += 32;
+        size -= 24;
+    }
+    return static_cast<size_t>(in - data);
+}
+
+/* Decodes 32 character blocks from the front of data into 24 bytes each,
+ * stopping at the first block with padding or a character outside the
+ * standard alphabet.  Returns the number of characters used.
+ */
+inline size_t decodeBlocks(const char* data, size_t size, char* out)
+{
+    const char* in = data;
+    while (size >= 32)
+    {
+        uint8x8x4_t chars = vld4_u8(reinterpret_cast<const uint8_t*>(in));
+        uint8x8_t valid = vdup_n_u8(0xff);
+        for (uint8x8_t& c : chars.val)
+        {
+            uint8x8_t upper = vclt_u8(vsub_u8(c, vdup_n_u8('A')),
+                                      vdup_n_u8(26));
+            uint8x8_t lower = vclt_u8(vsub_u8(c, vdup_n_u8('a')),
+                                      vdup_n_u8(26));
+            uint8x8_t digit = vclt_u8(vsub_u8(c, vdup_n_u8('0')),
+                                      vdup_n_u8(10));
+            uint8x8_t plus = vceq_u8(c, vdup_n_u8('+'));
+            uint8x8_t slash = vceq_u8(c, vdup_n_u8('/'));
+            valid = vand_u8(valid, vorr_u8(vorr_u8(upper, lower),
+                                           vorr_u8(digit,
+                                                   vorr_u8(plus, slash))));
+            uint8x8_t v =
+                vand_u8(upper, vsub_u8(c, vdup_n_u8('A')));
+            v = vorr_u8(v, vand_u8(lower, vsub_u8(c, vdup_n_u8('a' - 26))));
+            v = vorr_u8(v, vand_u8(digit, vadd_u8(c, vdup_n_u8(52 - '0'))));
+            v = vorr_u8(v, vand_u8(plus, vdup_n_u8(62)));
+            c = vorr_u8(v, vand_u8(slash, vdup_n_u8(63)));
+        }
+        if (vget_lane_u64(vreinterpret_u64_u8(valid), 0) != ~uint64_t(0))
+        {
+            break;
+        }
+        uint8x8x3_t bytes;
+        bytes.val[0] = vorr_u8(vshl_n_u8(chars.val[0], 2),
+                               vshr_n_u8(chars.val[1], 4));
+        bytes.val[1] = vorr_u8(vshl_n_u8(chars.val[1], 4),
+                               vshr_n_u8(chars.val[2], 2));
+        bytes.val[2] = vorr_u8(vshl_n_u8(chars.val[2], 6), chars.val[3]);
+        vst3_u8(reinterpret_cast<uint8_t*>(out), bytes);
+
+        in += 32;
+        out += 24;
+        size -= 32;
+    }
+    return static_cast<size_t>(in - data);
+}
+
+#else
+
+inline size_t encodeBlocks(const unsigned char* /*data*/, size_t /*size*/,
+                           char* /*out*/, const char* /*key*/)
+{
+    return 0;
+}
+
+inline size_t decodeBlocks(const char* /*data*/, size_t /*size*/,
+                           char* /*out*/)
+{
+    return 0;
+}
+
+#endif
+
+} // namespace base64_simd
+} // namespace crow
@@ -0,0 +1,127 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+namespace crow
+{
+
+// What the read buffers of all HTTP and websocket connections may hold
+// together before idle connections have to give theirs back
+constexpr size_t connectionBufferBudgetBytes = 1024 * 1024;
+// Capacity an idle connection may keep while under budget; enough for the
+// headers of a typical request, so that keep-alive requests don't allocate
+constexpr size_t idleBufferBytes = 2048;
+
+// Bytes held by connection buffers, against a limit.  Exceeding the limit
+// is allowed; it only makes connections shed memory sooner.
+class BufferBudget
+{
+  public:
+    explicit BufferBudget(size_t limit) : limitBytes(limit)
+    {
+    }
+
+    void add(size_t bytes)
+    {
+        usedBytes += bytes;
+    }
+
+    void remove(size_t bytes)
+    {
+        usedBytes -= bytes;
+    }
+
+    size_t used() const
+    {
+        return usedBytes.load();
+    }
+
+    size_t limit() const
+    {
+        return limitBytes;
+    }
+
+    bool exhausted() const
+    {
+        return usedBytes.load() > limitBytes;
+    }
+
+  private:
+    std::atomic<size_t> usedBytes{0};
+    size_t limitBytes;
+};
+
+inline BufferBudget& connectionBufferBudget()
+{
+    static BufferBudget budget(connectionBufferBudgetBytes);
+    return budget;
+}
+
+// The part of a budget one connection holds, given back when it goes away
+class BufferShare
+{
+  public:
+    explicit BufferShare(BufferBudget& budget = connectionBufferBudget()) :
+        budget(budget)
+    {
+    }
+
+    ~BufferShare()
+    {
+        update(0);
+    }
+
+    BufferShare(const BufferShare&) = delete;
+    BufferShare& operator=(const BufferShare&) = delete;
+
+    // Sets what the connection holds now
+    void update(size_t bytes)
+    {
+        if (bytes > heldBytes)
+        {
+            budget.add(bytes - heldBytes);
+        }
+        else
+        {
+            budget.remove(heldBytes - bytes);
+        }
+        heldBytes = bytes;
+    }
+
+    size_t held() const
+    {
+        return heldBytes;
+    }
+
+    const BufferBudget& owner() const
+    {
+        return budget;
+    }
+
+  private:
+    BufferBudget& budget;
+    size_t heldBytes{0};
+};
+
+/**
+ * @brief Frees a dynamic buffer of a connection waiting for its next message
+ *
+ * Buffers grow to fit what is read.  Once nothing unread is left in one, it
+ * is freed if it grew past idleBufferBytes, or if the budget is spent, and
+ * starts over empty with the same size limit.  share is updated either way.
+ *
+ * @param[in] buffer  A beast flat_buffer, or another buffer with max_size()
+ * @param[in] share   What the connection holds of the budget
+ */
+template <typename Buffer>
+void releaseIdleBuffer(Buffer& buffer, BufferShare& share)
+{
+    if (buffer.size() == 0 && buffer.capacity() > 0 &&
+        (buffer.capacity() > idleBufferBytes || share.owner().exhausted()))
+    {
+        buffer = Buffer(buffer.max_size());
+    }
+    share.update(buffer.capacity());
+}
+
+} // namespace crow
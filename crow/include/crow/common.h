@@ -1,6 +1,8 @@
 #pragma once
 
 #include <boost/beast/http/verb.hpp>
+#include <boost/container/small_vector.hpp>
+#include <boost/utility/string_view.hpp>
 #include <iostream>
 #include <stdexcept>
 #include <string>
@@ -74,10 +76,13 @@ enum class ParamType
 
 struct RoutingParams
 {
-    std::vector<int64_t> intParams;
-    std::vector<uint64_t> uintParams;
-    std::vector<double> doubleParams;
-    std::vector<std::string> stringParams;
+    // Routes rarely have more than a couple of parameters, so keep them
+    // inline; matching a url then doesn't allocate.
+    boost::container::small_vector<int64_t, 4> intParams;
+    boost::container::small_vector<uint64_t, 4> uintParams;
+    boost::container::small_vector<double, 4> doubleParams;
+    // Views into the url being routed, which outlives the handler call
+    boost::container::small_vector<boost::string_view, 4> stringParams;
 
     void debugPrint() const
     {
@@ -125,7 +130,7 @@ template <> inline double RoutingParams::get<double>(unsigned index) const
 template <>
 inline std::string RoutingParams::get<std::string>(unsigned index) const
 {
-    return stringParams[index];
+    return std::string(stringParams[index]);
 }
 
 } // namespace crow
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <boost/utility/string_view.hpp>
+#include <ctime>
+
+namespace crow
+{
+namespace detail
+{
+// Value of the Date header, shared by every connection of a server.  Only
+// one timer calls update(); any io thread may call get() without locking or
+// copying.  Each update writes a different slot than the one being read, so a
+// view from get() stays intact for several seconds, long enough to copy it
+// into the response being built.
+class DateHeader
+{
+  public:
+    DateHeader()
+    {
+        update();
+    }
+
+    DateHeader(const DateHeader&) = delete;
+    DateHeader& operator=(const DateHeader&) = delete;
+
+    void update(std::time_t now = std::time(nullptr))
+    {
+        unsigned index = current.load(std::memory_order_relaxed);
+        if (slots[index].time == now && slots[index].size != 0)
+        {
+            return;
+        }
+        index = (index + 1) % slotCount;
+        Slot& slot = slots[index];
+        tm myTm{};
+        gmtime_r(&now, &myTm);
+        slot.size = strftime(slot.data.data(), slot.data.size(),
+                             "%a, %d %b %Y %H:%M:%S GMT", &myTm);
+        slot.time = now;
+        current.store(index, std::memory_order_release);
+    }
+
+    boost::string_view get() const
+    {
+        const Slot& slot = slots[current.load(std::memory_order_acquire)];
+        return {slot.data.data(), slot.size};
+    }
+
+  private:
+    enum : unsigned
+    {
+        slotCount = 4
+    };
+
+    struct Slot
+    {
+        std::array<char, 32> data{};
+        size_t size{};
+        std::time_t time{};
+    };
+
+    std::array<Slot, slotCount> slots;
+    std::atomic<unsigned> current{0};
+};
+} // namespace detail
+} // namespace crow
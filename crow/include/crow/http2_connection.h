@@ -0,0 +1,1002 @@
+#pragma once
+#include <nghttp2/nghttp2.h>
+
+#include <array>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/container/flat_map.hpp>
+#include <boost/optional.hpp>
+#include <boost/utility/string_view.hpp>
+#include <cctype>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "crow/http_connection.h"
+
+namespace crow
+{
+
+// Most streams a client may have open at once on one connection
+constexpr uint32_t http2MaxConcurrentStreams = 16;
+// How much of a request body a client may send on a stream before the
+// server has taken it in
+constexpr uint32_t http2InitialWindowSize = 1024 * 64;
+// Size of the HPACK dynamic table, for both directions
+constexpr uint32_t http2HeaderTableSize = 4096;
+// Most the headers of one request may take, counted the way HPACK does
+constexpr uint32_t http2MaxHeaderListSize = 1024 * 16;
+// Read size; one TLS record
+constexpr size_t http2ReadChunkSize = 1024 * 16;
+// Frames are gathered into writes of about this size
+constexpr size_t http2WriteChunkSize = 1024 * 16;
+
+namespace http2
+{
+
+// Fields that only mean something to one HTTP/1 connection, which HTTP/2
+// doesn't allow
+inline bool isConnectionSpecific(boost::string_view name)
+{
+    return boost::iequals(name, "connection") ||
+           boost::iequals(name, "keep-alive") ||
+           boost::iequals(name, "proxy-connection") ||
+           boost::iequals(name, "transfer-encoding") ||
+           boost::iequals(name, "upgrade");
+}
+
+/**
+ * @brief A header block the way nghttp2 takes it
+ *
+ * Names are lowercase, as HTTP/2 wants them, and the block owns the strings
+ * the nghttp2_nv entries point at.
+ */
+class HeaderBlock
+{
+  public:
+    void add(boost::string_view name, boost::string_view value)
+    {
+        std::string lowerName(name);
+        for (char& c : lowerName)
+        {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        fields.emplace_back(std::move(lowerName), std::string(value));
+    }
+
+    const std::vector<std::pair<std::string, std::string>>& getFields() const
+    {
+        return fields;
+    }
+
+    // Valid for as long as the block is, and isn't added to
+    std::vector<nghttp2_nv> nameValues() const
+    {
+        std::vector<nghttp2_nv> nv;
+        nv.reserve(fields.size());
+        for (const std::pair<std::string, std::string>& field : fields)
+        {
+            nv.push_back(
+                {reinterpret_cast<uint8_t*>(const_cast<char*>(
+                     field.first.data())),
+                 reinterpret_cast<uint8_t*>(const_cast<char*>(
+                     field.second.data())),
+                 field.first.size(), field.second.size(),
+                 NGHTTP2_NV_FLAG_NONE});
+        }
+        return nv;
+    }
+
+  private:
+    std::vector<std::pair<std::string, std::string>> fields;
+};
+
+/**
+ * @brief The header block of a response: the :status pseudo-header, then
+ *        the fields of header that HTTP/2 allows
+ *
+ * Content-Length is left out too; it is added for the body actually sent.
+ */
+inline HeaderBlock
+    responseHeaders(const boost::beast::http::response_header<>& header)
+{
+    HeaderBlock block;
+    block.add(":status", std::to_string(header.result_int()));
+    for (const auto& field : header)
+    {
+        if (isConnectionSpecific(field.name_string()) ||
+            field.name() == boost::beast::http::field::content_length)
+        {
+            continue;
+        }
+        block.add(field.name_string(), field.value());
+    }
+    return block;
+}
+
+} // namespace http2
+
+/**
+ * @brief An HTTP/2 connection, for a client that asked for h2 over ALPN
+ *
+ * Takes the socket from the Connection that did the TLS handshake.  Every
+ * stream is a request of its own, run through the same middlewares and
+ * handlers as an HTTP/1 one, and answered as soon as its handler is done,
+ * whatever the other streams are doing.  nghttp2 does the framing, HPACK
+ * and flow control; this class moves bytes between it and the socket.
+ *
+ * The connection keeps itself alive: reads, writes and requests in handlers
+ * each hold a reference, and it goes away when the last of them is done.
+ *
+ * Routes that stream their body to a file aren't served over HTTP/2; their
+ * streams are reset with HTTP_1_1_REQUIRED, which tells the client to send
+ * the request again over HTTP/1.1.
+ */
+template <typename Adaptor, typename Handler, typename... Middlewares>
+class HTTP2Connection :
+    public std::enable_shared_from_this<
+        HTTP2Connection<Adaptor, Handler, Middlewares...>>
+{
+  public:
+    HTTP2Connection(Adaptor&& adaptor, boost::asio::io_service& connectionIo,
+                    boost::asio::io_service& handlerIo, Handler* handler,
+                    const std::string& serverName,
+                    std::tuple<Middlewares...>* middlewares,
+                    const detail::DateHeader& dateHeader,
+                    detail::TimerQueue& timerQueue,
+                    boost::asio::ip::address clientAddress) :
+        adaptor(std::move(adaptor)),
+        connectionIo(connectionIo), handlerIo(handlerIo), handler(handler),
+        serverName(serverName), middlewares(middlewares),
+        dateHeader(dateHeader), timerQueue(timerQueue),
+        clientAddress(std::move(clientAddress))
+    {
+    }
+
+    ~HTTP2Connection()
+    {
+        cancelDeadlineTimer();
+        for (auto& stream : streams)
+        {
+            timerQueue.cancel(stream.second->readDeadline);
+        }
+        if (session != nullptr)
+        {
+            nghttp2_session_del(session);
+        }
+        // Taken over from the Connection that handed over the socket
+        serverCounters().activeConnections--;
+        admissionControl().closeConnection(clientAddress);
+        BMCWEB_LOG_DEBUG << this << " HTTP/2 connection closed";
+    }
+
+    HTTP2Connection(const HTTP2Connection&) = delete;
+    HTTP2Connection& operator=(const HTTP2Connection&) = delete;
+
+    void start()
+    {
+        BMCWEB_LOG_DEBUG << this << " HTTP/2 connection from "
+                         << adaptor.remoteEndpoint();
+        if (!startSession())
+        {
+            adaptor.close();
+            return;
+        }
+        policy = connectionReuse().policy();
+        startDeadline(policy.idleTimeout);
+        doWrite();
+        doRead();
+    }
+
+  private:
+    // One request and its response
+    struct Stream
+    {
+        explicit Stream(int32_t id) : id(id), req(message)
+        {
+        }
+
+        ~Stream()
+        {
+            if (admitted)
+            {
+                admissionControl().finishRequest();
+            }
+        }
+
+        Stream(const Stream&) = delete;
+        Stream& operator=(const Stream&) = delete;
+
+        int32_t id;
+        boost::beast::http::request<boost::beast::http::string_body> message;
+        crow::Request req;
+        crow::Response res;
+        detail::Context<Middlewares...> ctx;
+        std::function<void()> middlewaresDone;
+        std::string authority;
+        size_t headerBytes = 0;
+        // Answered with this status without going to a handler
+        boost::optional<boost::beast::http::status> rejection;
+        // Reset; whatever else comes on it is dropped
+        bool reset = false;
+        bool needToCallAfterHandlers = false;
+        // In the middlewares and handlers, which own req and res meanwhile
+        bool handling = false;
+        // Waiting on the next chunk of a generated body
+        bool pulling = false;
+        // nghttp2 is done with the stream
+        bool closed = false;
+        // Counted as a request in flight by admissionControl()
+        bool admitted = false;
+        // Until the request is all in
+        detail::TimerQueue::TimerId readDeadline = 0;
+        RequestTimer timer;
+        unsigned routeIndex = 0;
+
+        // Where the data provider is in the body
+        size_t bodyOffset = 0;
+        std::string chunk;
+        size_t chunkOffset = 0;
+        bool moreChunks = true;
+    };
+
+    using Streams =
+        boost::container::flat_map<int32_t, std::unique_ptr<Stream>>;
+
+    static HTTP2Connection& self(void* userData)
+    {
+        return *static_cast<HTTP2Connection*>(userData);
+    }
+
+    bool startSession()
+    {
+        nghttp2_session_callbacks* callbacks = nullptr;
+        if (nghttp2_session_callbacks_new(&callbacks) != 0)
+        {
+            return false;
+        }
+        nghttp2_session_callbacks_set_on_begin_headers_callback(
+            callbacks, onBeginHeaders);
+        nghttp2_session_callbacks_set_on_header_callback(callbacks, onHeader);
+        nghttp2_session_callbacks_set_on_frame_recv_callback(callbacks,
+                                                             onFrameRecv);
+        nghttp2_session_callbacks_set_on_data_chunk_recv_callback(
+            callbacks, onDataChunkRecv);
+        nghttp2_session_callbacks_set_on_stream_close_callback(callbacks,
+                                                               onStreamClose);
+
+        nghttp2_option* option = nullptr;
+        if (nghttp2_option_new(&option) != 0)
+        {
+            nghttp2_session_callbacks_del(callbacks);
+            return false;
+        }
+        // Our side of HPACK keeps no bigger a table than the client's
+        nghttp2_option_set_max_deflate_dynamic_table_size(
+            option, http2HeaderTableSize);
+
+        int rv = nghttp2_session_server_new2(&session, callbacks, this, option);
+        nghttp2_option_del(option);
+        nghttp2_session_callbacks_del(callbacks);
+        if (rv != 0)
+        {
+            session = nullptr;
+            return false;
+        }
+
+        const std::array<nghttp2_settings_entry, 4> settings{
+            {{NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS,
+              http2MaxConcurrentStreams},
+             {NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE, http2InitialWindowSize},
+             {NGHTTP2_SETTINGS_HEADER_TABLE_SIZE, http2HeaderTableSize},
+             {NGHTTP2_SETTINGS_MAX_HEADER_LIST_SIZE, http2MaxHeaderListSize}}};
+        return nghttp2_submit_settings(session, NGHTTP2_FLAG_NONE,
+                                       settings.data(), settings.size()) == 0;
+    }
+
+    Stream* findStream(int32_t id)
+    {
+        auto stream = streams.find(id);
+        if (stream == streams.end())
+        {
+            return nullptr;
+        }
+        return stream->second.get();
+    }
+
+    static int onBeginHeaders(nghttp2_session* /*session*/,
+                              const nghttp2_frame* frame, void* userData)
+    {
+        if (frame->hd.type != NGHTTP2_HEADERS ||
+            frame->headers.cat != NGHTTP2_HCAT_REQUEST)
+        {
+            return 0;
+        }
+        HTTP2Connection& conn = self(userData);
+        auto stream = conn.streams.emplace(
+            frame->hd.stream_id, std::make_unique<Stream>(frame->hd.stream_id));
+        conn.cancelDeadlineTimer();
+        conn.startReadDeadline(*stream.first->second,
+                               conn.policy.headerReadTimeout);
+        return 0;
+    }
+
+    static int onHeader(nghttp2_session* /*session*/,
+                        const nghttp2_frame* frame, const uint8_t* name,
+                        size_t nameLength, const uint8_t* value,
+                        size_t valueLength, uint8_t /*flags*/, void* userData)
+    {
+        if (frame->hd.type != NGHTTP2_HEADERS ||
+            frame->headers.cat != NGHTTP2_HCAT_REQUEST)
+        {
+            return 0;
+        }
+        Stream* stream = self(userData).findStream(frame->hd.stream_id);
+        if (stream == nullptr)
+        {
+            return 0;
+        }
+        // Counted as SETTINGS_MAX_HEADER_LIST_SIZE counts them
+        stream->headerBytes += nameLength + valueLength + 32;
+        if (stream->headerBytes > http2MaxHeaderListSize)
+        {
+            // Resets the stream
+            return NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE;
+        }
+        boost::string_view key(reinterpret_cast<const char*>(name),
+                               nameLength);
+        boost::string_view text(reinterpret_cast<const char*>(value),
+                                valueLength);
+        boost::beast::http::request<boost::beast::http::string_body>&
+            message = stream->message;
+        if (key == ":method")
+        {
+            message.method_string(text);
+        }
+        else if (key == ":path")
+        {
+            message.target(text);
+        }
+        else if (key == ":authority")
+        {
+            stream->authority = std::string(text);
+        }
+        else if (key.empty() || key.front() != ':')
+        {
+            // A cookie may be split into several fields, which HTTP/1 has
+            // as one
+            auto cookie = message.find(boost::beast::http::field::cookie);
+            if (key == "cookie" && cookie != message.end())
+            {
+                std::string joined(cookie->value());
+                joined += "; ";
+                joined.append(text.data(), text.size());
+                message.set(boost::beast::http::field::cookie, joined);
+            }
+            else
+            {
+                message.insert(key, text);
+            }
+        }
+        return 0;
+    }
+
+    static int onFrameRecv(nghttp2_session* /*session*/,
+                           const nghttp2_frame* frame, void* userData)
+    {
+        if (frame->hd.type != NGHTTP2_HEADERS &&
+            frame->hd.type != NGHTTP2_DATA)
+        {
+            return 0;
+        }
+        HTTP2Connection& conn = self(userData);
+        Stream* stream = conn.findStream(frame->hd.stream_id);
+        if (stream == nullptr || stream->reset)
+        {
+            return 0;
+        }
+        if (frame->hd.type == NGHTTP2_HEADERS &&
+            frame->headers.cat == NGHTTP2_HCAT_REQUEST)
+        {
+            conn.headersDone(*stream);
+            if (stream->reset)
+            {
+                return 0;
+            }
+            if ((frame->hd.flags & NGHTTP2_FLAG_END_STREAM) == 0)
+            {
+                conn.startReadDeadline(*stream, conn.policy.bodyReadTimeout);
+            }
+        }
+        if ((frame->hd.flags & NGHTTP2_FLAG_END_STREAM) != 0)
+        {
+            conn.dispatch(*stream);
+        }
+        return 0;
+    }
+
+    static int onDataChunkRecv(nghttp2_session* /*session*/, uint8_t /*flags*/,
+                               int32_t streamId, const uint8_t* data,
+                               size_t length, void* userData)
+    {
+        HTTP2Connection& conn = self(userData);
+        Stream* stream = conn.findStream(streamId);
+        if (stream == nullptr || stream->reset || stream->rejection)
+        {
+            return 0;
+        }
+        serverCounters().bytesIn += length;
+        // All bodies being received on the connection get what one HTTP/1
+        // request body may take
+        if (conn.bodyBytes + length > httpReqBodyLimit)
+        {
+            stream->rejection = boost::beast::http::status::payload_too_large;
+            return 0;
+        }
+        stream->message.body().append(reinterpret_cast<const char*>(data),
+                                      length);
+        conn.bodyBytes += length;
+        return 0;
+    }
+
+    static int onStreamClose(nghttp2_session* /*session*/, int32_t streamId,
+                             uint32_t /*errorCode*/, void* userData)
+    {
+        HTTP2Connection& conn = self(userData);
+        Stream* stream = conn.findStream(streamId);
+        if (stream == nullptr)
+        {
+            return 0;
+        }
+        stream->closed = true;
+        conn.releaseStream(*stream);
+        return 0;
+    }
+
+    // The request headers are all in
+    void headersDone(Stream& stream)
+    {
+        boost::beast::http::request<boost::beast::http::string_body>&
+            message = stream.message;
+        message.version(20);
+        if (!stream.authority.empty() &&
+            message.find(boost::beast::http::field::host) == message.end())
+        {
+            message.set(boost::beast::http::field::host, stream.authority);
+        }
+        crow::Request& req = stream.req;
+        req.url = req.target();
+        std::size_t index = req.url.find("?");
+        if (index != boost::string_view::npos)
+        {
+            req.url = req.url.substr(0, index);
+        }
+        req.urlParams = QueryString(req.target());
+        req.indexHeaders();
+
+        if (handler->findBodyFileDirectory(req) != nullptr)
+        {
+            BMCWEB_LOG_DEBUG << this << " Stream " << stream.id
+                             << " needs HTTP/1.1 for " << req.url;
+            stream.reset = true;
+            nghttp2_submit_rst_stream(session, NGHTTP2_FLAG_NONE, stream.id,
+                                      NGHTTP2_HTTP_1_1_REQUIRED);
+        }
+    }
+
+    // The request is all in; hands it to the middlewares and handlers
+    void dispatch(Stream& stream)
+    {
+        crow::Request& req = stream.req;
+        crow::Response& res = stream.res;
+        BMCWEB_LOG_INFO << "Request: " << adaptor.remoteEndpoint() << " "
+                        << this << " HTTP/2 stream " << stream.id << ' '
+                        << req.methodString() << " " << req.target();
+        cancelReadDeadline(stream);
+        stream.timer.start();
+        stream.timer.enter(RequestPhase::auth);
+
+        if (stream.rejection)
+        {
+            res.result(*stream.rejection);
+            submitResponse(stream);
+            return;
+        }
+        if (!admissionControl().startRequest(false))
+        {
+            BMCWEB_LOG_WARNING << this << " Overloaded, shedding request";
+            res.result(boost::beast::http::status::service_unavailable);
+            res.addHeader(
+                "Retry-After",
+                std::to_string(
+                    admissionControl().limits().retryAfter.count()));
+            submitResponse(stream);
+            return;
+        }
+        stream.admitted = true;
+        stream.handling = true;
+
+        std::shared_ptr<HTTP2Connection> keepAlive = this->shared_from_this();
+        std::weak_ptr<HTTP2Connection> weak = keepAlive;
+        // Holds the connection while the middlewares run
+        res.completeRequestHandler = [keepAlive] {};
+        res.isAliveHelper = [weak]() -> bool {
+            std::shared_ptr<HTTP2Connection> conn = weak.lock();
+            return conn != nullptr && conn->adaptor.isOpen();
+        };
+        stream.middlewaresDone = [this, &stream] { callRouteHandler(stream); };
+        req.middlewareContext = static_cast<void*>(&stream.ctx);
+        req.ioService = &handlerIo;
+        req.localUser = adaptor.localUser();
+        Priority priority = requestPriority(req.target(), req.body.size());
+        postWithPriority(handlerIo, priority, [keepAlive, &stream] {
+            keepAlive->callHandlers(stream);
+        });
+    }
+
+    void callHandlers(Stream& stream)
+    {
+        detail::MiddlewareResult result =
+            detail::middlewareCallHelper<0, decltype(stream.ctx),
+                                         decltype(*middlewares),
+                                         Middlewares...>(
+                *middlewares, stream.req, stream.res, stream.ctx,
+                stream.middlewaresDone);
+        if (result != detail::MiddlewareResult::deferred)
+        {
+            callRouteHandler(stream);
+        }
+    }
+
+    void callRouteHandler(Stream& stream)
+    {
+        if (stream.res.completed)
+        {
+            completeStream(stream);
+            return;
+        }
+        std::shared_ptr<HTTP2Connection> keepAlive = this->shared_from_this();
+        stream.res.completeRequestHandler = [keepAlive, &stream] {
+            keepAlive->completeStream(stream);
+        };
+        stream.needToCallAfterHandlers = true;
+        stream.timer.enter(RequestPhase::handler);
+        handler->handle(stream.req, stream.res, &stream.routeIndex);
+    }
+
+    // Runs on the handler thread once the response is ready
+    void completeStream(Stream& stream)
+    {
+        BMCWEB_LOG_INFO << "Response: " << this << " stream " << stream.id
+                        << ' ' << stream.req.url << ' '
+                        << stream.res.resultInt();
+        if (stream.needToCallAfterHandlers)
+        {
+            stream.needToCallAfterHandlers = false;
+            detail::afterHandlersCallHelper<((int)sizeof...(Middlewares) - 1),
+                                            decltype(stream.ctx),
+                                            decltype(*middlewares)>(
+                *middlewares, stream.ctx, stream.req, stream.res);
+        }
+        std::shared_ptr<HTTP2Connection> keepAlive = this->shared_from_this();
+        stream.res.completeRequestHandler = nullptr;
+        runOnConnectionThread([keepAlive, &stream] {
+            keepAlive->streamAnswered(stream);
+        });
+    }
+
+    void streamAnswered(Stream& stream)
+    {
+        stream.handling = false;
+        if (stream.closed || !adaptor.isOpen())
+        {
+            releaseStream(stream);
+            return;
+        }
+        submitResponse(stream);
+        doWrite();
+    }
+
+    // Queues the response; nghttp2 sends it as the socket and the client's
+    // window allow.  Not called from inside nghttp2, so the caller writes.
+    void submitResponse(Stream& stream)
+    {
+        stream.timer.enter(RequestPhase::write);
+        crow::Request& req = stream.req;
+        crow::Response& res = stream.res;
+        if (res.body().empty() && !res.jsonValue.empty() && !res.isStreamed())
+        {
+            if (http_helpers::requestPrefersHtml(req))
+            {
+                prettyPrintJson(res);
+            }
+            else
+            {
+                res.jsonMode();
+                detail::setJsonBody(res, true);
+            }
+        }
+        if (res.resultInt() >= 400 && res.body().empty() && !res.isStreamed())
+        {
+            res.body() = std::string(res.reason());
+        }
+
+        http2::HeaderBlock headers = http2::responseHeaders(*res.stringResponse);
+        headers.add("server", serverName);
+        headers.add("date", dateHeader.get());
+
+        bool hasBody = res.result() != boost::beast::http::status::not_modified &&
+                       res.result() != boost::beast::http::status::no_content;
+        if (hasBody && res.fileBody.isOpen())
+        {
+            headers.add("content-length",
+                        std::to_string(res.fileBody.length));
+        }
+        else if (hasBody && !res.bodyGenerator)
+        {
+            headers.add("content-length", std::to_string(res.body().size()));
+        }
+        if (req.method() == boost::beast::http::verb::head)
+        {
+            hasBody = false;
+        }
+
+        nghttp2_data_provider provider{};
+        provider.source.ptr = &stream;
+        provider.read_callback = onReadBody;
+        std::vector<nghttp2_nv> nv = headers.nameValues();
+        if (nghttp2_submit_response(session, stream.id, nv.data(), nv.size(),
+                                    hasBody ? &provider : nullptr) != 0)
+        {
+            nghttp2_submit_rst_stream(session, NGHTTP2_FLAG_NONE, stream.id,
+                                      NGHTTP2_INTERNAL_ERROR);
+        }
+    }
+
+    // Fills the next DATA frame of a response
+    static ssize_t onReadBody(nghttp2_session* /*session*/, int32_t /*streamId*/,
+                              uint8_t* buf, size_t length, uint32_t* dataFlags,
+                              nghttp2_data_source* source, void* userData)
+    {
+        Stream& stream = *static_cast<Stream*>(source->ptr);
+        crow::Response& res = stream.res;
+        if (res.fileBody.isOpen())
+        {
+            return readFileBody(res.fileBody, buf, length, dataFlags);
+        }
+        if (res.bodyGenerator)
+        {
+            if (stream.chunkOffset == stream.chunk.size())
+            {
+                if (!stream.moreChunks)
+                {
+                    *dataFlags |= NGHTTP2_DATA_FLAG_EOF;
+                    return 0;
+                }
+                if (!stream.pulling)
+                {
+                    self(userData).pullChunk(stream);
+                }
+                return NGHTTP2_ERR_DEFERRED;
+            }
+            size_t size = std::min(length, stream.chunk.size() -
+                                               stream.chunkOffset);
+            std::memcpy(buf, &stream.chunk[stream.chunkOffset], size);
+            stream.chunkOffset += size;
+            if (stream.chunkOffset == stream.chunk.size() &&
+                !stream.moreChunks)
+            {
+                *dataFlags |= NGHTTP2_DATA_FLAG_EOF;
+            }
+            return static_cast<ssize_t>(size);
+        }
+        const std::string& body = res.body();
+        size_t size = std::min(length, body.size() - stream.bodyOffset);
+        std::memcpy(buf, body.data() + stream.bodyOffset, size);
+        stream.bodyOffset += size;
+        if (stream.bodyOffset == body.size())
+        {
+            *dataFlags |= NGHTTP2_DATA_FLAG_EOF;
+        }
+        return static_cast<ssize_t>(size);
+    }
+
+    static ssize_t readFileBody(FileBody& fileBody, uint8_t* buf,
+                                size_t length, uint32_t* dataFlags)
+    {
+        if (fileBody.length == 0)
+        {
+            fileBody.close();
+            *dataFlags |= NGHTTP2_DATA_FLAG_EOF;
+            return 0;
+        }
+        ssize_t got;
+        do
+        {
+            got = ::pread(fileBody.fd, buf,
+                          std::min<uint64_t>(fileBody.length, length),
+                          static_cast<off_t>(fileBody.offset));
+        } while (got < 0 && errno == EINTR);
+        if (got <= 0)
+        {
+            // The file got shorter than the Content-Length sent
+            return NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE;
+        }
+        // A download is read once; don't let it push everything else out of
+        // the page cache
+        posix_fadvise(fileBody.fd, static_cast<off_t>(fileBody.offset), got,
+                      POSIX_FADV_DONTNEED);
+        fileBody.offset += static_cast<uint64_t>(got);
+        fileBody.length -= static_cast<uint64_t>(got);
+        if (fileBody.length == 0)
+        {
+            fileBody.close();
+            *dataFlags |= NGHTTP2_DATA_FLAG_EOF;
+        }
+        return got;
+    }
+
+    void pullChunk(Stream& stream)
+    {
+        stream.pulling = true;
+        std::shared_ptr<HTTP2Connection> keepAlive = this->shared_from_this();
+        // Each chunk is a slice of bulk work, so anything more urgent gets to
+        // run between them
+        postWithPriority(handlerIo, Priority::bulk, [keepAlive, &stream] {
+            stream.res.bodyGenerator(
+                [keepAlive, &stream](std::string&& chunk, bool more) {
+                    keepAlive->runOnConnectionThread(
+                        [keepAlive, &stream, chunk{std::move(chunk)},
+                         more]() mutable {
+                            keepAlive->chunkPulled(stream, std::move(chunk),
+                                                   more);
+                        });
+                });
+        });
+    }
+
+    void chunkPulled(Stream& stream, std::string&& chunk, bool more)
+    {
+        stream.pulling = false;
+        if (stream.closed || !adaptor.isOpen())
+        {
+            releaseStream(stream);
+            return;
+        }
+        stream.chunk = std::move(chunk);
+        stream.chunkOffset = 0;
+        stream.moreChunks = more;
+        nghttp2_session_resume_data(session, stream.id);
+        doWrite();
+    }
+
+    // Drops a stream nghttp2 and the handlers are both done with
+    void releaseStream(Stream& stream)
+    {
+        if (!stream.closed || stream.handling || stream.pulling)
+        {
+            return;
+        }
+        if (stream.timer.running())
+        {
+            RouteMetrics* metrics = handler->routeMetrics(stream.routeIndex);
+            if (metrics != nullptr)
+            {
+                stream.timer.finish(*metrics);
+            }
+        }
+        cancelReadDeadline(stream);
+        bodyBytes -= stream.message.body().size();
+        streams.erase(stream.id);
+        if (streams.empty() && adaptor.isOpen())
+        {
+            startDeadline(policy.idleTimeout);
+        }
+    }
+
+    void doRead()
+    {
+        readBuffer.resize(http2ReadChunkSize);
+        std::shared_ptr<HTTP2Connection> keepAlive = this->shared_from_this();
+        adaptor.socket().async_read_some(
+            boost::asio::buffer(readBuffer),
+            [keepAlive](const boost::system::error_code& ec,
+                        std::size_t bytesTransferred) {
+                keepAlive->afterRead(ec, bytesTransferred);
+            });
+    }
+
+    void afterRead(const boost::system::error_code& ec,
+                   std::size_t bytesTransferred)
+    {
+        if (ec || !adaptor.isOpen())
+        {
+            BMCWEB_LOG_DEBUG << this << " HTTP/2 read ended: " << ec.message();
+            close();
+            return;
+        }
+        ssize_t rv = nghttp2_session_mem_recv(session, readBuffer.data(),
+                                              bytesTransferred);
+        if (rv < 0)
+        {
+            BMCWEB_LOG_ERROR << this << " HTTP/2 protocol error: "
+                             << nghttp2_strerror(static_cast<int>(rv));
+            close();
+            return;
+        }
+        doWrite();
+        if (nghttp2_session_want_read(session) != 0)
+        {
+            doRead();
+        }
+    }
+
+    // Sends what nghttp2 has queued, a few frames at a time
+    void doWrite()
+    {
+        if (isWriting || !adaptor.isOpen())
+        {
+            return;
+        }
+        writeBuffer.clear();
+        while (writeBuffer.size() < http2WriteChunkSize)
+        {
+            const uint8_t* data = nullptr;
+            ssize_t size = nghttp2_session_mem_send(session, &data);
+            if (size < 0)
+            {
+                BMCWEB_LOG_ERROR << this << " HTTP/2 send error: "
+                                 << nghttp2_strerror(static_cast<int>(size));
+                close();
+                return;
+            }
+            if (size == 0)
+            {
+                break;
+            }
+            writeBuffer.insert(writeBuffer.end(), data, data + size);
+        }
+        if (writeBuffer.empty())
+        {
+            if (nghttp2_session_want_read(session) == 0 &&
+                nghttp2_session_want_write(session) == 0)
+            {
+                // Both sides said GOAWAY, and all is sent
+                close();
+            }
+            return;
+        }
+        isWriting = true;
+        std::shared_ptr<HTTP2Connection> keepAlive = this->shared_from_this();
+        boost::asio::async_write(
+            adaptor.socket(), boost::asio::buffer(writeBuffer),
+            [keepAlive](const boost::system::error_code& ec,
+                        std::size_t bytesTransferred) {
+                keepAlive->isWriting = false;
+                if (ec)
+                {
+                    keepAlive->close();
+                    return;
+                }
+                serverCounters().bytesOut += bytesTransferred;
+                keepAlive->doWrite();
+            });
+    }
+
+    void close()
+    {
+        cancelDeadlineTimer();
+        adaptor.close();
+    }
+
+    template <typename F> void runOnConnectionThread(F&& f)
+    {
+        if (&handlerIo == &connectionIo)
+        {
+            f();
+            return;
+        }
+        connectionIo.post(std::forward<F>(f));
+    }
+
+    void cancelDeadlineTimer()
+    {
+        if (timerCancelKey != 0)
+        {
+            timerQueue.cancel(timerCancelKey);
+            timerCancelKey = 0;
+        }
+    }
+
+    // A stream whose request isn't all in by then is reset, so a client
+    // can't hold a stream, and the connection with it, by stalling
+    void startReadDeadline(Stream& stream, std::chrono::milliseconds timeout)
+    {
+        cancelReadDeadline(stream);
+        int32_t id = stream.id;
+        stream.readDeadline = timerQueue.add(
+            [this, id] {
+                Stream* stream = findStream(id);
+                if (stream == nullptr)
+                {
+                    return;
+                }
+                stream->readDeadline = 0;
+                if (stream->reset || !adaptor.isOpen())
+                {
+                    return;
+                }
+                BMCWEB_LOG_DEBUG << this << " Stream " << id
+                                 << " timed out reading the request";
+                stream->reset = true;
+                nghttp2_submit_rst_stream(session, NGHTTP2_FLAG_NONE, id,
+                                          NGHTTP2_CANCEL);
+                doWrite();
+            },
+            timeout);
+    }
+
+    void cancelReadDeadline(Stream& stream)
+    {
+        if (stream.readDeadline != 0)
+        {
+            timerQueue.cancel(stream.readDeadline);
+            stream.readDeadline = 0;
+        }
+    }
+
+    // Without streams for timeout, the connection says GOAWAY; a client that
+    // doesn't let it go then is cut off
+    void startDeadline(std::chrono::milliseconds timeout)
+    {
+        cancelDeadlineTimer();
+        timerCancelKey = timerQueue.add(
+            [this] {
+                timerCancelKey = 0;
+                if (!adaptor.isOpen())
+                {
+                    return;
+                }
+                if (goingAway)
+                {
+                    adaptor.close();
+                    return;
+                }
+                goingAway = true;
+                nghttp2_session_terminate_session(session, NGHTTP2_NO_ERROR);
+                startDeadline(policy.headerReadTimeout);
+                doWrite();
+            },
+            timeout);
+    }
+
+    Adaptor adaptor;
+    boost::asio::io_service& connectionIo;
+    boost::asio::io_service& handlerIo;
+    Handler* handler;
+    const std::string& serverName;
+    std::tuple<Middlewares...>* middlewares;
+    const detail::DateHeader& dateHeader;
+    detail::TimerQueue& timerQueue;
+    boost::asio::ip::address clientAddress;
+    // Copied from connectionReuse() when the connection starts
+    KeepAlivePolicy policy;
+
+    nghttp2_session* session{nullptr};
+    Streams streams;
+    // Request body bytes held by all streams
+    size_t bodyBytes{0};
+
+    std::vector<uint8_t> readBuffer;
+    std::vector<uint8_t> writeBuffer;
+    bool isWriting{false};
+
+    detail::TimerQueue::TimerId timerCancelKey{0};
+    bool goingAway{false};
+};
+
+} // namespace crow
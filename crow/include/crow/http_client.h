@@ -0,0 +1,529 @@
+#pragma once
+
+#include <openssl/ssl.h>
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "crow/logging.h"
+
+namespace crow
+{
+namespace http_client
+{
+
+using Request = boost::beast::http::request<boost::beast::http::string_body>;
+using Response = boost::beast::http::response<boost::beast::http::string_body>;
+// Called once per request, with timed_out if it didn't finish in time
+using Callback =
+    std::function<void(const boost::system::error_code&, Response&)>;
+
+// A server requests go to.  Connections are pooled per endpoint.
+struct Endpoint
+{
+    std::string host;
+    uint16_t port = 443;
+    bool tls = true;
+    // Otherwise any certificate is taken, for servers that only have a
+    // self-signed one
+    bool verifyPeer = true;
+
+    std::string key() const
+    {
+        return (tls ? "https://" : "http://") + host + ":" +
+               std::to_string(port);
+    }
+};
+
+struct ClientCounters
+{
+    // New connections made
+    uint64_t connects = 0;
+    // Requests sent over an idle connection from the pool
+    uint64_t reused = 0;
+    // TLS handshakes that resumed an earlier session
+    uint64_t resumed = 0;
+    uint64_t timeouts = 0;
+};
+
+namespace detail
+{
+
+class Connection
+{
+  public:
+    using TlsStream =
+        boost::asio::ssl::stream<boost::asio::ip::tcp::socket&>;
+
+    Connection(boost::asio::io_service& io,
+               boost::asio::ssl::context* tlsContext) :
+        socket(io)
+    {
+        if (tlsContext != nullptr)
+        {
+            tls = std::make_unique<TlsStream>(socket, *tlsContext);
+        }
+    }
+
+    // Calls function with the stream to read and write
+    template <typename Function> void withStream(Function&& function)
+    {
+        if (tls != nullptr)
+        {
+            function(*tls);
+        }
+        else
+        {
+            function(socket);
+        }
+    }
+
+    void close()
+    {
+        boost::system::error_code ec;
+        socket.close(ec);
+    }
+
+    // Closes a connection that ended between requests.  OpenSSL won't
+    // resume the session of a connection dropped without a close_notify,
+    // so this one is marked as shut down properly first.
+    void release()
+    {
+        if (tls != nullptr)
+        {
+            SSL_set_shutdown(tls->native_handle(),
+                             SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+        }
+        close();
+    }
+
+    boost::asio::ip::tcp::socket socket;
+    std::unique_ptr<TlsStream> tls;
+    boost::beast::flat_buffer buffer;
+    std::chrono::steady_clock::time_point idleSince;
+};
+
+// The idle connections to one endpoint, and the TLS session to resume on
+// the next new one
+struct Pool
+{
+    Pool() = default;
+    Pool(const Pool&) = delete;
+    Pool& operator=(const Pool&) = delete;
+
+    ~Pool()
+    {
+        if (session != nullptr)
+        {
+            SSL_SESSION_free(session);
+        }
+    }
+
+    std::deque<std::shared_ptr<Connection>> idle;
+    SSL_SESSION* session = nullptr;
+};
+
+// Everything requests in flight need, so they can outlive the Client
+struct State
+{
+    State(boost::asio::io_service& io, size_t maxIdle,
+          std::chrono::seconds idleTimeout) :
+        io(io),
+        tlsContext(boost::asio::ssl::context::sslv23_client),
+        maxIdle(maxIdle), idleTimeout(idleTimeout)
+    {
+        tlsContext.set_options(boost::asio::ssl::context::default_workarounds |
+                               boost::asio::ssl::context::no_sslv2 |
+                               boost::asio::ssl::context::no_sslv3 |
+                               boost::asio::ssl::context::no_tlsv1 |
+                               boost::asio::ssl::context::no_tlsv1_1);
+        boost::system::error_code ec;
+        tlsContext.set_default_verify_paths(ec);
+    }
+
+    // The most recently used idle connection to key, if there is one that
+    // hasn't been idle too long
+    std::shared_ptr<Connection> checkout(const std::string& key)
+    {
+        auto pool = pools.find(key);
+        if (pool == pools.end())
+        {
+            return nullptr;
+        }
+        std::deque<std::shared_ptr<Connection>>& idle = pool->second.idle;
+        const std::chrono::steady_clock::time_point now =
+            std::chrono::steady_clock::now();
+        while (!idle.empty())
+        {
+            std::shared_ptr<Connection> connection = std::move(idle.back());
+            idle.pop_back();
+            if (connection->socket.is_open() &&
+                now - connection->idleSince < idleTimeout)
+            {
+                return connection;
+            }
+            connection->release();
+        }
+        return nullptr;
+    }
+
+    void checkin(const std::string& key,
+                 std::shared_ptr<Connection>&& connection)
+    {
+        if (stopped || maxIdle == 0)
+        {
+            connection->release();
+            return;
+        }
+        std::deque<std::shared_ptr<Connection>>& idle = pools[key].idle;
+        connection->idleSince = std::chrono::steady_clock::now();
+        idle.push_back(std::move(connection));
+        if (idle.size() > maxIdle)
+        {
+            idle.front()->release();
+            idle.pop_front();
+        }
+    }
+
+    boost::asio::io_service& io;
+    boost::asio::ssl::context tlsContext;
+    std::unordered_map<std::string, Pool> pools;
+    size_t maxIdle;
+    std::chrono::seconds idleTimeout;
+    ClientCounters counters;
+    bool stopped = false;
+};
+
+// One request, from finding a connection to calling back
+class Exchange : public std::enable_shared_from_this<Exchange>
+{
+  public:
+    Exchange(const std::shared_ptr<State>& state, const Endpoint& endpoint,
+             Request&& req, Callback&& callback) :
+        state(state),
+        endpoint(endpoint), key(endpoint.key()), req(std::move(req)),
+        callback(std::move(callback)), timer(state->io), resolver(state->io)
+    {
+    }
+
+    void start(std::chrono::milliseconds timeout)
+    {
+        auto self = shared_from_this();
+        timer.expires_after(timeout);
+        timer.async_wait([self](const boost::system::error_code& ec) {
+            if (ec || self->done)
+            {
+                return;
+            }
+            // Whatever is pending completes with operation_aborted
+            self->timedOut = true;
+            self->resolver.cancel();
+            if (self->connection != nullptr)
+            {
+                self->connection->close();
+            }
+        });
+
+        connection = state->checkout(key);
+        if (connection != nullptr)
+        {
+            reused = true;
+            state->counters.reused++;
+            send();
+            return;
+        }
+        connect();
+    }
+
+  private:
+    void connect()
+    {
+        connection = std::make_shared<Connection>(
+            state->io, endpoint.tls ? &state->tlsContext : nullptr);
+        auto self = shared_from_this();
+        resolver.async_resolve(
+            endpoint.host, std::to_string(endpoint.port),
+            [self](const boost::system::error_code& ec,
+                   boost::asio::ip::tcp::resolver::results_type results) {
+                if (self->failed(ec))
+                {
+                    return;
+                }
+                boost::asio::async_connect(
+                    self->connection->socket, results,
+                    [self](const boost::system::error_code& ec,
+                           const boost::asio::ip::tcp::endpoint&) {
+                        if (self->failed(ec))
+                        {
+                            return;
+                        }
+                        self->state->counters.connects++;
+                        boost::system::error_code ignored;
+                        self->connection->socket.set_option(
+                            boost::asio::ip::tcp::no_delay(true), ignored);
+                        if (self->connection->tls == nullptr)
+                        {
+                            self->send();
+                            return;
+                        }
+                        self->handshake();
+                    });
+            });
+    }
+
+    void handshake()
+    {
+        Connection::TlsStream& tls = *connection->tls;
+        SSL* ssl = tls.native_handle();
+        SSL_set_tlsext_host_name(ssl, endpoint.host.c_str());
+        if (endpoint.verifyPeer)
+        {
+            tls.set_verify_mode(boost::asio::ssl::verify_peer);
+            tls.set_verify_callback(
+                boost::asio::ssl::rfc2818_verification(endpoint.host));
+        }
+        else
+        {
+            tls.set_verify_mode(boost::asio::ssl::verify_none);
+        }
+        // Resuming skips the key exchange, which on a BMC is most of the
+        // cost of a new connection
+        auto pool = state->pools.find(key);
+        if (pool != state->pools.end() && pool->second.session != nullptr)
+        {
+            SSL_set_session(ssl, pool->second.session);
+        }
+        auto self = shared_from_this();
+        tls.async_handshake(boost::asio::ssl::stream_base::client,
+                            [self](const boost::system::error_code& ec) {
+                                if (self->failed(ec))
+                                {
+                                    return;
+                                }
+                                if (SSL_session_reused(
+                                        self->connection->tls->native_handle()))
+                                {
+                                    self->state->counters.resumed++;
+                                }
+                                self->send();
+                            });
+    }
+
+    void send()
+    {
+        auto self = shared_from_this();
+        connection->withStream([this, self](auto& stream) {
+            boost::beast::http::async_write(
+                stream, req,
+                [self](const boost::system::error_code& ec, std::size_t) {
+                    if (self->failed(ec))
+                    {
+                        return;
+                    }
+                    self->receive();
+                });
+        });
+    }
+
+    void receive()
+    {
+        auto self = shared_from_this();
+        connection->withStream([this, self](auto& stream) {
+            boost::beast::http::async_read(
+                stream, connection->buffer, res,
+                [self](const boost::system::error_code& ec, std::size_t) {
+                    if (self->failed(ec))
+                    {
+                        return;
+                    }
+                    self->finish(ec);
+                });
+        });
+    }
+
+    // Finishes with ec if there is one, or if the time is up.  A pooled
+    // connection the server has closed in the meantime fails like this,
+    // so a GET that fails on one is sent again on a new connection.
+    bool failed(const boost::system::error_code& ec)
+    {
+        if (!ec && !timedOut)
+        {
+            return false;
+        }
+        if (reused && !timedOut && isClosedByPeer(ec) &&
+            (req.method() == boost::beast::http::verb::get ||
+             req.method() == boost::beast::http::verb::head))
+        {
+            BMCWEB_LOG_DEBUG << "Pooled connection to " << key
+                             << " was closed, reconnecting";
+            reused = false;
+            connection->close();
+            res = Response();
+            connect();
+            return true;
+        }
+        finish(ec);
+        return true;
+    }
+
+    static bool isClosedByPeer(const boost::system::error_code& ec)
+    {
+        return ec == boost::beast::http::error::end_of_stream ||
+               ec == boost::asio::error::eof ||
+               ec == boost::asio::error::connection_reset ||
+               ec == boost::asio::error::connection_aborted ||
+               ec == boost::asio::error::broken_pipe;
+    }
+
+    void finish(boost::system::error_code ec)
+    {
+        done = true;
+        timer.cancel();
+        if (timedOut)
+        {
+            ec = boost::asio::error::timed_out;
+            state->counters.timeouts++;
+        }
+        if (!ec && connection->tls != nullptr)
+        {
+            // Read now, as TLS 1.3 servers send their tickets after the
+            // handshake
+            SSL_SESSION* session =
+                SSL_get1_session(connection->tls->native_handle());
+            if (session != nullptr)
+            {
+                Pool& pool = state->pools[key];
+                if (pool.session != nullptr)
+                {
+                    SSL_SESSION_free(pool.session);
+                }
+                pool.session = session;
+            }
+        }
+        if (ec)
+        {
+            connection->close();
+        }
+        else if (res.keep_alive())
+        {
+            state->checkin(key, std::move(connection));
+        }
+        else
+        {
+            connection->release();
+        }
+        connection.reset();
+        Callback handler = std::move(callback);
+        handler(ec, res);
+    }
+
+    std::shared_ptr<State> state;
+    Endpoint endpoint;
+    std::string key;
+    Request req;
+    Response res;
+    Callback callback;
+    boost::asio::steady_timer timer;
+    boost::asio::ip::tcp::resolver resolver;
+    std::shared_ptr<Connection> connection;
+    bool reused = false;
+    bool timedOut = false;
+    bool done = false;
+};
+
+} // namespace detail
+
+/**
+ * @brief Sends HTTP and HTTPS requests from the io_service, keeping the
+ *        connections open for the next request to the same endpoint
+ *
+ * Requests run in parallel, each on a connection of its own; only idle
+ * connections are shared.  Up to maxIdle of them are kept per endpoint, for
+ * no longer than idleTimeout.  New TLS connections resume the last session
+ * the endpoint gave out.
+ *
+ * Not thread safe; use it from the thread running the io_service.
+ */
+class Client
+{
+  public:
+    explicit Client(boost::asio::io_service& io, size_t maxIdle = 4,
+                    std::chrono::seconds idleTimeout = std::chrono::seconds(
+                        30)) :
+        state(std::make_shared<detail::State>(io, maxIdle, idleTimeout))
+    {
+    }
+
+    Client(const Client&) = delete;
+    Client& operator=(const Client&) = delete;
+
+    ~Client()
+    {
+        // Requests in flight finish, but their connections aren't kept
+        state->stopped = true;
+        for (std::pair<const std::string, detail::Pool>& pool : state->pools)
+        {
+            for (std::shared_ptr<detail::Connection>& connection :
+                 pool.second.idle)
+            {
+                connection->release();
+            }
+            pool.second.idle.clear();
+        }
+    }
+
+    // For adding certificate authorities, or a client certificate
+    boost::asio::ssl::context& tlsContext()
+    {
+        return state->tlsContext;
+    }
+
+    /**
+     * @brief Sends req to endpoint and calls callback with the response, or
+     *        with the error that kept it from coming within timeout
+     *
+     * Host is filled in if req has none.  The callback is always called
+     * later, from the io_service, never from within send().
+     */
+    void send(const Endpoint& endpoint, Request&& req,
+              std::chrono::milliseconds timeout, Callback&& callback)
+    {
+        if (req[boost::beast::http::field::host].empty())
+        {
+            req.set(boost::beast::http::field::host, endpoint.host);
+        }
+        req.keep_alive(true);
+        req.prepare_payload();
+        auto exchange = std::make_shared<detail::Exchange>(
+            state, endpoint, std::move(req), std::move(callback));
+        exchange->start(timeout);
+    }
+
+    const ClientCounters& counters() const
+    {
+        return state->counters;
+    }
+
+    size_t idleConnections(const Endpoint& endpoint) const
+    {
+        auto pool = state->pools.find(endpoint.key());
+        return pool == state->pools.end() ? 0 : pool->second.idle.size();
+    }
+
+  private:
+    std::shared_ptr<detail::State> state;
+};
+
+} // namespace http_client
+} // namespace crow
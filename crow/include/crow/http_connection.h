@@ -10,14 +10,29 @@
 #include <boost/beast/http.hpp>
 #include <boost/beast/websocket.hpp>
 #include <chrono>
-#include <regex>
 #include <vector>
 
+#include <openssl/evp.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "crow/admission.h"
+#include "crow/buffer_budget.h"
+#include "crow/date_header.h"
 #include "crow/http_response.h"
+#include "crow/json_chunk_writer.h"
+#include "crow/keep_alive.h"
 #include "crow/logging.h"
 #include "crow/middleware_context.h"
+#include "crow/multipart_parser.h"
+#include "crow/priority_scheduler.h"
+#include "crow/server_metrics.h"
 #include "crow/socket_adaptors.h"
 #include "crow/timer_queue.h"
+#include "crow/upload_progress.h"
 
 #ifdef BMCWEB_ENABLE_SSL
 #include <boost/asio/ssl.hpp>
@@ -26,73 +41,117 @@
 namespace crow
 {
 
-inline void escapeHtml(std::string& data)
+// Appends data to out with the characters HTML gives a meaning to escaped
+inline void appendEscapedHtml(std::string& out, boost::string_view data)
 {
-    std::string buffer;
-    // less than 5% of characters should be larger, so reserve a buffer of the
-    // right size
-    buffer.reserve(data.size() * 1.05);
-    for (size_t pos = 0; pos != data.size(); ++pos)
+    for (char c : data)
     {
-        switch (data[pos])
+        switch (c)
         {
             case '&':
-                buffer.append("&amp;");
+                out.append("&amp;");
                 break;
             case '\"':
-                buffer.append("&quot;");
+                out.append("&quot;");
                 break;
             case '\'':
-                buffer.append("&apos;");
+                out.append("&apos;");
                 break;
             case '<':
-                buffer.append("&lt;");
+                out.append("&lt;");
                 break;
             case '>':
-                buffer.append("&gt;");
+                out.append("&gt;");
                 break;
             default:
-                buffer.append(&data[pos], 1);
+                out += c;
                 break;
         }
     }
-    data.swap(buffer);
 }
 
-inline void convertToLinks(std::string& s)
+namespace detail
+{
+// Renders a JSON value the way dump(4) lays it out, HTML escaped, with every
+// @odata.id string turned into a link to the resource.  Escaping and linking
+// happen as the tree is walked, so the text is only produced once.
+inline void appendJsonHtml(std::string& out, const nlohmann::json& value,
+                           size_t depth = 0, bool link = false)
 {
-    const static std::regex r{"(&quot;@odata\\.((id)|(Context))&quot;[ \\n]*:[ "
-                              "\\n]*)(&quot;((?!&quot;).*)&quot;)"};
-    s = std::regex_replace(s, r, "$1<a href=\"$6\">$5</a>");
+    constexpr size_t indentStep = 4;
+    bool isObject = value.is_object();
+    if (isObject || value.is_array())
+    {
+        if (value.empty())
+        {
+            out += isObject ? "{}" : "[]";
+            return;
+        }
+        out += isObject ? "{\n" : "[\n";
+        for (nlohmann::json::const_iterator it = value.cbegin();
+             it != value.cend(); ++it)
+        {
+            if (it != value.cbegin())
+            {
+                out += ",\n";
+            }
+            out.append((depth + 1) * indentStep, ' ');
+            bool isLink = false;
+            if (isObject)
+            {
+                appendEscapedHtml(out, nlohmann::json(it.key()).dump());
+                out += ": ";
+                isLink = it.key() == "@odata.id";
+            }
+            appendJsonHtml(out, *it, depth + 1, isLink);
+        }
+        out += '\n';
+        out.append(depth * indentStep, ' ');
+        out += isObject ? '}' : ']';
+        return;
+    }
+
+    std::string text = value.dump();
+    if (link && value.is_string())
+    {
+        // The href is the string without its quotes
+        out += "<a href=\"";
+        appendEscapedHtml(out, boost::string_view(text).substr(
+                                   1, text.size() - 2));
+        out += "\">";
+        appendEscapedHtml(out, text);
+        out += "</a>";
+        return;
+    }
+    appendEscapedHtml(out, text);
 }
+} // namespace detail
 
 inline void prettyPrintJson(crow::Response& res)
 {
-    std::string value = res.jsonValue.dump(4);
-    escapeHtml(value);
-    convertToLinks(value);
-    res.body() = "<html>\n"
-                 "<head>\n"
-                 "<title>Redfish API</title>\n"
-                 "<link rel=\"stylesheet\" type=\"text/css\" "
-                 "href=\"/styles/default.css\">\n"
-                 "<script src=\"/highlight.pack.js\"></script>"
-                 "<script>hljs.initHighlightingOnLoad();</script>"
-                 "</head>\n"
-                 "<body>\n"
-                 "<div style=\"max-width: 576px;margin:0 auto;\">\n"
-                 "<img src=\"/DMTF_Redfish_logo_2017.svg\" alt=\"redfish\" "
-                 "height=\"406px\" "
-                 "width=\"576px\">\n"
-                 "<br>\n"
-                 "<pre>\n"
-                 "<code class=\"json\">" +
-                 value +
-                 "</code>\n"
-                 "</pre>\n"
-                 "</div>\n"
-                 "</body>\n"
-                 "</html>\n";
+    std::string& body = res.body();
+    body = "<html>\n"
+           "<head>\n"
+           "<title>Redfish API</title>\n"
+           "<link rel=\"stylesheet\" type=\"text/css\" "
+           "href=\"/styles/default.css\">\n"
+           "<script src=\"/highlight.pack.js\"></script>"
+           "<script>hljs.initHighlightingOnLoad();</script>"
+           "</head>\n"
+           "<body>\n"
+           "<div style=\"max-width: 576px;margin:0 auto;\">\n"
+           "<img src=\"/DMTF_Redfish_logo_2017.svg\" alt=\"redfish\" "
+           "height=\"406px\" "
+           "width=\"576px\">\n"
+           "<br>\n"
+           "<pre>\n"
+           "<code class=\"json\">";
+    detail::appendJsonHtml(body, res.jsonValue);
+    body += "</code>\n"
+            "</pre>\n"
+            "</div>\n"
+            "</body>\n"
+            "</html>\n";
 }
 
 using namespace boost;
@@ -202,43 +261,6 @@ typename std::enable_if<IsAfterHandleArity3Impl<MW>::value>::type
     mw.afterHandle(req, res, ctx.template get<MW>());
 }
 
-template <int N, typename Context, typename Container, typename CurrentMW,
-          typename... Middlewares>
-bool middlewareCallHelper(Container& middlewares, Request& req, Response& res,
-                          Context& ctx)
-{
-    using parent_context_t = typename Context::template partial<N - 1>;
-    beforeHandlerCall<CurrentMW, Context, parent_context_t>(
-        std::get<N>(middlewares), req, res, ctx,
-        static_cast<parent_context_t&>(ctx));
-
-    if (res.isCompleted())
-    {
-        afterHandlerCall<CurrentMW, Context, parent_context_t>(
-            std::get<N>(middlewares), req, res, ctx,
-            static_cast<parent_context_t&>(ctx));
-        return true;
-    }
-
-    if (middlewareCallHelper<N + 1, Context, Container, Middlewares...>(
-            middlewares, req, res, ctx))
-    {
-        afterHandlerCall<CurrentMW, Context, parent_context_t>(
-            std::get<N>(middlewares), req, res, ctx,
-            static_cast<parent_context_t&>(ctx));
-        return true;
-    }
-
-    return false;
-}
-
-template <int N, typename Context, typename Container>
-bool middlewareCallHelper(Container& /*middlewares*/, Request& /*req*/,
-                          Response& /*res*/, Context& /*ctx*/)
-{
-    return false;
-}
-
 template <int N, typename Context, typename Container>
 typename std::enable_if<(N < 0)>::type
     afterHandlersCallHelper(Container& /*middlewares*/, Context& /*Context*/,
@@ -273,6 +295,81 @@ typename std::enable_if<(N > 0)>::type
     afterHandlersCallHelper<N - 1, Context, Container>(middlewares, ctx, req,
                                                        res);
 }
+
+template <int N, typename Context, typename Container, typename CurrentMW,
+          typename... Middlewares>
+MiddlewareResult middlewareCallHelper(Container& middlewares, Request& req,
+                                      Response& res, Context& ctx,
+                                      const std::function<void()>& done)
+{
+    using parent_context_t = typename Context::template partial<N - 1>;
+    beforeHandlerCall<CurrentMW, Context, parent_context_t>(
+        std::get<N>(middlewares), req, res, ctx,
+        static_cast<parent_context_t&>(ctx));
+
+    if (res.isDeferred())
+    {
+        // The frames below this one have returned by the time the
+        // middleware resumes, so their after handlers are run from here
+        res.setResumeHandler([&middlewares, &req, &res, &ctx, &done] {
+            MiddlewareResult result =
+                middlewareCallRest<N, Context, Container, CurrentMW,
+                                   Middlewares...>(middlewares, req, res, ctx,
+                                                   done);
+            if (result == MiddlewareResult::deferred)
+            {
+                return;
+            }
+            if (result == MiddlewareResult::completed)
+            {
+                afterHandlersCallHelper<N - 1, Context, Container>(
+                    middlewares, ctx, req, res);
+            }
+            done();
+        });
+        return MiddlewareResult::deferred;
+    }
+
+    return middlewareCallRest<N, Context, Container, CurrentMW,
+                              Middlewares...>(middlewares, req, res, ctx, done);
+}
+
+// Runs what comes after the beforeHandle of middleware N
+template <int N, typename Context, typename Container, typename CurrentMW,
+          typename... Middlewares>
+MiddlewareResult middlewareCallRest(Container& middlewares, Request& req,
+                                    Response& res, Context& ctx,
+                                    const std::function<void()>& done)
+{
+    using parent_context_t = typename Context::template partial<N - 1>;
+    if (res.isCompleted())
+    {
+        afterHandlerCall<CurrentMW, Context, parent_context_t>(
+            std::get<N>(middlewares), req, res, ctx,
+            static_cast<parent_context_t&>(ctx));
+        return MiddlewareResult::completed;
+    }
+
+    MiddlewareResult result =
+        middlewareCallHelper<N + 1, Context, Container, Middlewares...>(
+            middlewares, req, res, ctx, done);
+    if (result == MiddlewareResult::completed)
+    {
+        afterHandlerCall<CurrentMW, Context, parent_context_t>(
+            std::get<N>(middlewares), req, res, ctx,
+            static_cast<parent_context_t&>(ctx));
+    }
+    return result;
+}
+
+template <int N, typename Context, typename Container>
+MiddlewareResult middlewareCallHelper(Container& /*middlewares*/,
+                                      Request& /*req*/, Response& /*res*/,
+                                      Context& /*ctx*/,
+                                      const std::function<void()>& /*done*/)
+{
+    return MiddlewareResult::next;
+}
 } // namespace detail
 
 #ifdef BMCWEB_ENABLE_DEBUG
@@ -281,26 +378,97 @@ static std::atomic<int> connectionCount;
 
 // request body limit size: 30M
 constexpr unsigned int httpReqBodyLimit = 1024 * 1024 * 30;
+// Limit for bodies streamed to a file, which don't take up our memory
+constexpr uint64_t httpStreamedBodyLimit = 1024 * 1024 * 64;
+// Read size when streaming a body to a file
+constexpr size_t httpStreamedBodyChunkSize = 1024 * 64;
+// Most the fields of a streamed multipart/form-data body may take together,
+// besides its file
+constexpr size_t httpFormFieldsLimit = 1024 * 64;
+// JSON bodies bigger than this are serialized and sent in chunks of about
+// this size
+constexpr size_t httpJsonChunkSize = 1024 * 16;
+// Most handed to one sendfile(2) of a file body
+constexpr size_t httpSendfileChunkSize = 1024 * 1024;
+// Read size of a file body that has to go through TLS; one TLS record
+constexpr size_t httpFileReadChunkSize = 1024 * 16;
+
+namespace detail
+{
+// Serializes the jsonValue of res into its body.  A document that doesn't
+// fit in the first chunk is left to a body generator when chunked, and
+// serialized as the socket takes it, so its full text is never held in
+// memory.
+inline void setJsonBody(Response& res, bool chunked)
+{
+    auto writer =
+        std::make_shared<detail::JsonChunkWriter>(std::move(res.jsonValue));
+    std::string& body = res.body();
+    if (!writer->write(body, httpJsonChunkSize))
+    {
+        return;
+    }
+    if (!chunked)
+    {
+        while (writer->write(body, body.size() + httpJsonChunkSize))
+        {
+        }
+        return;
+    }
+    res.setBodyGenerator(
+        [writer, first{std::move(body)}](
+            const Response::ChunkCallback& callback) mutable {
+            if (!first.empty())
+            {
+                callback(std::move(first), true);
+                first.clear();
+                return;
+            }
+            std::string chunk;
+            chunk.reserve(httpJsonChunkSize + 256);
+            bool more = writer->write(chunk, httpJsonChunkSize);
+            callback(std::move(chunk), more);
+        });
+    body.clear();
+}
+} // namespace detail
+
+#ifdef BMCWEB_ENABLE_HTTP2
+template <typename Adaptor, typename Handler, typename... Middlewares>
+class HTTP2Connection;
+#endif
 
 template <typename Adaptor, typename Handler, typename... Middlewares>
 class Connection
 {
   public:
-    Connection(boost::asio::io_service& ioService, Handler* handler,
+    Connection(boost::asio::io_service& ioService,
+               boost::asio::io_service& handlerIo, Handler* handler,
                const std::string& server_name,
                std::tuple<Middlewares...>* middlewares,
-               std::function<std::string()>& get_cached_date_str_f,
+               const detail::DateHeader& dateHeader,
                detail::TimerQueue& timerQueue,
-               typename Adaptor::context* adaptorCtx) :
+               typename Adaptor::context* adaptorCtx,
+               std::function<void(Connection*)> releaseHandler = nullptr) :
         adaptor(ioService, adaptorCtx),
+        adaptorCtx(adaptorCtx), connectionIo(ioService), handlerIo(handlerIo),
         handler(handler), serverName(server_name), middlewares(middlewares),
-        getCachedDateStr(get_cached_date_str_f), timerQueue(timerQueue)
+        dateHeader(dateHeader), timerQueue(timerQueue),
+        releaseHandler(std::move(releaseHandler))
     {
         parser.emplace(std::piecewise_construct, std::make_tuple());
         // Temporarily changed to 30MB; Need to modify uploading/authentication
         // mechanism
         parser->body_limit(httpReqBodyLimit);
         req.emplace(parser->get());
+        // The arena is reset on the connection thread, so only objects that
+        // die on it may live there.  With a worker pool handlers run on
+        // another thread, where AsyncResp and the like release the response
+        // whenever their last callback returns; they stay on the heap.
+        if (&handlerIo == &connectionIo)
+        {
+            res.arena = &arena;
+        }
 #ifdef BMCWEB_ENABLE_DEBUG
         connectionCount++;
         BMCWEB_LOG_DEBUG << this << " Connection open, total "
@@ -312,6 +480,8 @@ class Connection
     {
         res.completeRequestHandler = nullptr;
         cancelDeadlineTimer();
+        closeBodyFile();
+        removeBodyFile();
 #ifdef BMCWEB_ENABLE_DEBUG
         connectionCount--;
         BMCWEB_LOG_DEBUG << this << " Connection closed, total "
@@ -324,13 +494,81 @@ class Connection
         return adaptor.rawSocket();
     }
 
+    // Return the connection to the state it had right after construction so
+    // it can be handed the next accepted socket.  The read buffer shrinks
+    // back as it does between requests.
+    void reset()
+    {
+        cancelDeadlineTimer();
+        closeBodyFile();
+        removeBodyFile();
+        bodyFileDirectory = nullptr;
+        adaptor = Adaptor(connectionIo, adaptorCtx);
+        serializer.reset();
+        fileBody.close();
+        std::vector<char>().swap(fileChunk);
+        fileBytesWritten = 0;
+        chunkedSerializer.reset();
+        chunkedResponse.reset();
+        std::string().swap(chunkBuffer);
+        res.clear();
+        res.completeRequestHandler = nullptr;
+        res.isAliveHelper = nullptr;
+        arena.reset();
+        req.reset();
+        parser.emplace(std::piecewise_construct, std::make_tuple());
+        parser->body_limit(httpReqBodyLimit);
+        buffer.consume(buffer.size());
+        releaseIdleBuffer(buffer, bufferShare);
+        req.emplace(parser->get());
+        ctx = detail::Context<Middlewares...>();
+        isReading = false;
+        isWriting = false;
+        needToCallAfterHandlers = false;
+        routeIndex = 0;
+        std::string().swap(refusal);
+        localSession.reset();
+        requestCount = 0;
+        connectionBytes = 0;
+        closeReason = CloseReason::client;
+    }
+
     void start()
     {
+        ServerCounters& counters = serverCounters();
+        counters.connections++;
+        counters.activeConnections++;
+        active = true;
+
+        boost::system::error_code ec;
+        clientAddress = adaptor.remoteAddress(ec);
+        policy = connectionReuse().policy();
+        if (ec)
+        {
+            socket().close(ec);
+            checkDestroy();
+            return;
+        }
+        if (!admissionControl().openConnection(clientAddress))
+        {
+            BMCWEB_LOG_WARNING << this << " Refusing connection from "
+                               << clientAddress << ", over the limit";
+            refuse();
+            return;
+        }
+        admitted = true;
+
+        startDeadline(policy.headerReadTimeout, CloseReason::readTimeout);
         adaptor.start([this](const boost::system::error_code& ec) {
             if (!ec)
             {
-                startDeadline();
-
+#ifdef BMCWEB_ENABLE_HTTP2
+                if (adaptor.alpnProtocol() == "h2")
+                {
+                    startHttp2();
+                    return;
+                }
+#endif
                 doReadHeaders();
             }
             else
@@ -343,6 +581,7 @@ class Connection
     void handle()
     {
         cancelDeadlineTimer();
+        timer.enter(RequestPhase::auth);
         bool isInvalidRequest = false;
         const boost::string_view connection =
             req->getHeaderValue(boost::beast::http::field::connection);
@@ -353,7 +592,7 @@ class Connection
             if (req->getHeaderValue(boost::beast::http::field::host).empty())
             {
                 isInvalidRequest = true;
-                res = Response(boost::beast::http::status::bad_request);
+                res.result(boost::beast::http::status::bad_request);
             }
         }
 
@@ -364,47 +603,40 @@ class Connection
 
         needToCallAfterHandlers = false;
 
-        if (!isInvalidRequest)
+        if (isInvalidRequest)
         {
-            res.completeRequestHandler = [] {};
-            res.isAliveHelper = [this]() -> bool { return adaptor.isOpen(); };
-
-            ctx = detail::Context<Middlewares...>();
-            req->middlewareContext = (void*)&ctx;
-            req->ioService = &adaptor.getIoService();
-            detail::middlewareCallHelper<
-                0, decltype(ctx), decltype(*middlewares), Middlewares...>(
-                *middlewares, *req, res, ctx);
-
-            if (!res.completed)
-            {
-                if (req->isUpgrade() &&
-                    boost::iequals(
-                        req->getHeaderValue(boost::beast::http::field::upgrade),
-                        "websocket"))
-                {
-                    handler->handleUpgrade(*req, res, std::move(adaptor));
-                    return;
-                }
-                res.completeRequestHandler = [this] {
-                    this->completeRequest();
-                };
-                needToCallAfterHandlers = true;
-                handler->handle(*req, res);
-                if (req->keepAlive())
-                {
-                    res.addHeader("connection", "Keep-Alive");
-                }
-            }
-            else
-            {
-                completeRequest();
-            }
+            completeRequest();
+            return;
         }
-        else
+
+        if (!admissionControl().startRequest(req->isUpgrade()))
         {
+            BMCWEB_LOG_WARNING << this << " Overloaded, shedding request";
+            res.result(boost::beast::http::status::service_unavailable);
+            res.addHeader(
+                "Retry-After",
+                std::to_string(
+                    admissionControl().limits().retryAfter.count()));
+            req->req.keep_alive(false);
             completeRequest();
+            return;
         }
+        requestAdmitted = true;
+
+        res.completeRequestHandler = [] {};
+        res.isAliveHelper = [this]() -> bool { return adaptor.isOpen(); };
+
+        ctx = detail::Context<Middlewares...>();
+        req->middlewareContext = (void*)&ctx;
+        req->ioService = &handlerIo;
+        req->timerQueue = &timerQueue;
+        req->localUser = adaptor.localUser();
+        req->localSession = &localSession;
+        Priority priority =
+            bodyFileDirectory == nullptr
+                ? requestPriority(req->target(), req->body.size())
+                : Priority::bulk;
+        scheduleOnHandlerThread(priority, [this] { callHandlers(); });
     }
 
     void completeRequest()
@@ -412,6 +644,17 @@ class Connection
         BMCWEB_LOG_INFO << "Response: " << this << ' ' << req->url << ' '
                         << res.resultInt() << " keepalive=" << req->keepAlive();
 
+        callAfterHandlers();
+
+        // auto self = this->shared_from_this();
+        res.completeRequestHandler = nullptr;
+
+        runOnConnectionThread([this] { writeResponse(); });
+    }
+
+  private:
+    void callAfterHandlers()
+    {
         if (needToCallAfterHandlers)
         {
             needToCallAfterHandlers = false;
@@ -422,10 +665,163 @@ class Connection
                                             decltype(*middlewares)>(
                 *middlewares, ctx, *req, res);
         }
+    }
 
-        // auto self = this->shared_from_this();
-        res.completeRequestHandler = nullptr;
+    // Answers a connection over a connection limit with 503 and Retry-After
+    // before any request is read, then closes it.  Over TLS that takes a
+    // handshake, so past AdmissionLimits::maxRefusalsAnswered of them at
+    // once the rest are closed unanswered.  A client that negotiated h2
+    // gets the HTTP/1.1 answer all the same, and sees a protocol error.
+    void refuse()
+    {
+        if (!admissionControl().startRefusal())
+        {
+            boost::system::error_code ec;
+            socket().close(ec);
+            checkDestroy();
+            return;
+        }
+        startDeadline(policy.headerReadTimeout, CloseReason::readTimeout);
+        adaptor.start([this](const boost::system::error_code& ec) {
+            if (ec || !adaptor.isOpen())
+            {
+                cancelDeadlineTimer();
+                admissionControl().finishRefusal();
+                checkDestroy();
+                return;
+            }
+            refusal = "HTTP/1.1 503 Service Unavailable\r\nRetry-After: " +
+                      std::to_string(
+                          admissionControl().limits().retryAfter.count()) +
+                      "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+            isWriting = true;
+            boost::asio::async_write(
+                adaptor.socket(), boost::asio::buffer(refusal),
+                [this](const boost::system::error_code&,
+                       std::size_t bytes_transferred) {
+                    isWriting = false;
+                    serverCounters().bytesOut += bytes_transferred;
+                    cancelDeadlineTimer();
+                    adaptor.close();
+                    admissionControl().finishRefusal();
+                    checkDestroy();
+                });
+        });
+    }
+
+#ifdef BMCWEB_ENABLE_HTTP2
+    // The HTTP/2 connection takes the socket, and its place in the counts of
+    // active and admitted connections; this one goes back to the pool
+    void startHttp2()
+    {
+        cancelDeadlineTimer();
+        auto http2 =
+            std::make_shared<HTTP2Connection<Adaptor, Handler, Middlewares...>>(
+                std::move(adaptor), connectionIo, handlerIo, handler,
+                serverName, middlewares, dateHeader, timerQueue,
+                clientAddress);
+        active = false;
+        admitted = false;
+        http2->start();
+        checkDestroy();
+    }
+#endif
+
+    // When the server runs an io worker pool, the socket belongs to a worker
+    // io_service while middlewares and route handlers must run on handlerIo,
+    // which owns the D-Bus connection and all shared state.  Without a pool
+    // both are the same io_service and these are plain calls.
+    template <typename F> void runOnHandlerThread(F&& f)
+    {
+        if (&handlerIo == &connectionIo)
+        {
+            f();
+            return;
+        }
+        handlerIo.post(std::forward<F>(f));
+    }
+
+    // Always queued, even without a pool, so that more urgent work waiting
+    // on handlerIo goes first
+    template <typename F> void scheduleOnHandlerThread(Priority priority, F&& f)
+    {
+        postWithPriority(handlerIo, priority, std::forward<F>(f));
+    }
+
+    template <typename F> void runOnConnectionThread(F&& f)
+    {
+        if (&handlerIo == &connectionIo)
+        {
+            f();
+            return;
+        }
+        connectionIo.post(std::forward<F>(f));
+    }
+
+    void callHandlers()
+    {
+        detail::MiddlewareResult result =
+            detail::middlewareCallHelper<0, decltype(ctx),
+                                         decltype(*middlewares),
+                                         Middlewares...>(
+                *middlewares, *req, res, ctx, middlewaresDone);
+        if (result != detail::MiddlewareResult::deferred)
+        {
+            callRouteHandler();
+        }
+    }
+
+    // Runs once every middleware has let the request through, or one of
+    // them has answered it
+    void callRouteHandler()
+    {
+        if (res.completed)
+        {
+            if (bodyFileDirectory != nullptr)
+            {
+                // Turned away before the body was read, so the connection
+                // can't be used for another request
+                bodyFileDirectory = nullptr;
+                req->req.keep_alive(false);
+            }
+            completeRequest();
+            return;
+        }
+
+        if (bodyFileDirectory != nullptr)
+        {
+            // The middlewares let the request through on its headers; only
+            // now is its body worth reading.  The handler gets it once the
+            // whole body is in, and the after handlers run however that
+            // ends.
+            const std::string* directory = bodyFileDirectory;
+            bodyFileDirectory = nullptr;
+            needToCallAfterHandlers = true;
+            runOnConnectionThread(
+                [this, directory] { startBodyFile(*directory); });
+            return;
+        }
 
+        if (req->isUpgrade() &&
+            boost::iequals(
+                req->getHeaderValue(boost::beast::http::field::upgrade),
+                "websocket"))
+        {
+            // The socket is the websocket's now
+            closeReason = CloseReason::upgrade;
+            leaveActive();
+            handler->handleUpgrade(*req, res, std::move(adaptor));
+            return;
+        }
+        res.completeRequestHandler = [this] { this->completeRequest(); };
+        needToCallAfterHandlers = true;
+        timer.enter(RequestPhase::handler);
+        handler->handle(*req, res, &routeIndex);
+    }
+
+    void writeResponse()
+    {
+        timer.enter(RequestPhase::write);
         if (!adaptor.isOpen())
         {
             // BMCWEB_LOG_DEBUG << this << " delete (socket is closed) " <<
@@ -434,7 +830,7 @@ class Connection
             // delete this;
             return;
         }
-        if (res.body().empty() && !res.jsonValue.empty())
+        if (res.body().empty() && !res.jsonValue.empty() && !res.isStreamed())
         {
             if (http_helpers::requestPrefersHtml(*req))
             {
@@ -443,23 +839,47 @@ class Connection
             else
             {
                 res.jsonMode();
-                res.body() = res.jsonValue.dump(2);
+                setJsonBody();
             }
         }
 
-        if (res.resultInt() >= 400 && res.body().empty())
+        if (res.resultInt() >= 400 && res.body().empty() && !res.isStreamed())
         {
             res.body() = std::string(res.reason());
         }
-        res.addHeader(boost::beast::http::field::server, serverName);
-        res.addHeader(boost::beast::http::field::date, getCachedDateStr());
+        // Past the buffer budget, connections aren't kept open waiting for
+        // another request
+        if (connectionBufferBudget().exhausted())
+        {
+            req->req.keep_alive(false);
+        }
+        else if (policy.maxRequests != 0 &&
+                 requestCount >= policy.maxRequests && req->keepAlive())
+        {
+            req->req.keep_alive(false);
+            closeReason = CloseReason::maxRequests;
+        }
+        if (req->keepAlive())
+        {
+            res.addHeader("connection", "Keep-Alive");
+        }
+        // Nothing else sets these, so skip the lookup addHeader() does
+        res.stringResponse->insert(boost::beast::http::field::server,
+                                   serverName);
+        res.stringResponse->insert(boost::beast::http::field::date,
+                                   dateHeader.get());
 
         res.keepAlive(req->keepAlive());
 
         doWrite();
     }
 
-  private:
+    void setJsonBody()
+    {
+        // HTTP/1.0 has no chunked encoding
+        detail::setJsonBody(res, req->version() >= 11);
+    }
+
     void doReadHeaders()
     {
         // auto self = this->shared_from_this();
@@ -472,7 +892,8 @@ class Connection
             [this](const boost::system::error_code& ec,
                    std::size_t bytes_transferred) {
                 isReading = false;
-                BMCWEB_LOG_ERROR << this << " async_read_header "
+                bufferShare.update(buffer.capacity());
+                BMCWEB_LOG_DEBUG << this << " async_read_header "
                                  << bytes_transferred << " Bytes";
                 bool errorWhileReading = false;
                 if (ec)
@@ -499,19 +920,290 @@ class Connection
                     checkDestroy();
                     return;
                 }
+                countBytesIn(bytes_transferred);
+                connectionReuse().requestStarted(requestCount > 0);
+                requestCount++;
+                timer.start();
 
                 // Compute the url parameters for the request
                 req->url = req->target();
                 std::size_t index = req->url.find("?");
                 if (index != boost::string_view::npos)
                 {
-                    req->url = req->url.substr(0, index - 1);
+                    req->url = req->url.substr(0, index);
                 }
-                req->urlParams = QueryString(std::string(req->target()));
+                req->urlParams = QueryString(req->target());
+                req->indexHeaders();
+                bodyFileDirectory = handler->findBodyFileDirectory(*req);
+                if (bodyFileDirectory != nullptr)
+                {
+                    // Authenticated and admitted on its headers alone, so
+                    // nothing is written to disk for a client that would be
+                    // turned away
+                    handle();
+                    return;
+                }
+                startDeadline(policy.bodyReadTimeout,
+                              CloseReason::readTimeout);
                 doRead();
             });
     }
 
+    // Streams the body of the current request into a new file in directory,
+    // hashing it along the way, instead of letting the parser collect it.
+    // Of a multipart/form-data body only the file goes there, and is hashed.
+    void startBodyFile(const std::string& directory)
+    {
+        startDeadline(policy.bodyReadTimeout, CloseReason::readTimeout);
+        if (parser->chunked() || !parser->content_length())
+        {
+            failBodyFile(boost::beast::http::status::length_required);
+            return;
+        }
+        bodyFileRemaining = *parser->content_length();
+        if (bodyFileRemaining > httpStreamedBodyLimit)
+        {
+            failBodyFile(boost::beast::http::status::payload_too_large);
+            return;
+        }
+
+        std::string path = directory + "/upload-XXXXXX";
+        bodyFileFd = mkstemp(&path[0]);
+        if (bodyFileFd < 0)
+        {
+            BMCWEB_LOG_ERROR << this << " Could not create file in "
+                             << directory;
+            failBodyFile(boost::beast::http::status::internal_server_error);
+            return;
+        }
+        req->bodyFile = std::move(path);
+        bodyHash = EVP_MD_CTX_new();
+        EVP_DigestInit_ex(bodyHash, EVP_sha256(), nullptr);
+        std::string boundary = multipart::boundaryOf(
+            req->getHeaderValue(KnownHeader::contentType));
+        if (!boundary.empty())
+        {
+            startBodyParts(boundary);
+        }
+        // Only now that the middlewares let the request through; see
+        // UploadRegistry
+        bodyUpload =
+            uploadRegistry().start(std::string(req->url), bodyFileRemaining);
+        req->upload = bodyUpload;
+
+        // Part of the body may have come in with the headers
+        size_t buffered = static_cast<size_t>(
+            std::min<uint64_t>(buffer.size(), bodyFileRemaining));
+        if (!appendBodyFile(
+                static_cast<const char*>(buffer.data().data()), buffered))
+        {
+            return;
+        }
+        buffer.consume(buffered);
+        countBytesIn(buffered);
+        doReadBodyFile();
+    }
+
+    void doReadBodyFile()
+    {
+        if (bodyFileRemaining == 0)
+        {
+            finishBodyFile();
+            return;
+        }
+        isReading = true;
+        bodyFileChunk.resize(httpStreamedBodyChunkSize);
+        adaptor.socket().async_read_some(
+            boost::asio::buffer(bodyFileChunk),
+            [this](const boost::system::error_code& ec,
+                   std::size_t bytes_transferred) {
+                isReading = false;
+                if (ec || !adaptor.isOpen())
+                {
+                    BMCWEB_LOG_ERROR << this << " Error while reading body: "
+                                     << ec.message();
+                    cancelDeadlineTimer();
+                    adaptor.close();
+                    closeBodyFile();
+                    // The middlewares saw the request; they get to clean up
+                    // after it before the connection goes
+                    runOnHandlerThread([this] {
+                        callAfterHandlers();
+                        runOnConnectionThread([this] { checkDestroy(); });
+                    });
+                    return;
+                }
+                size_t used = static_cast<size_t>(std::min<uint64_t>(
+                    bytes_transferred, bodyFileRemaining));
+                countBytesIn(used);
+                if (!appendBodyFile(bodyFileChunk.data(), used))
+                {
+                    return;
+                }
+                if (bytes_transferred > used)
+                {
+                    // The start of a pipelined request; leave it for the
+                    // parser
+                    buffer.commit(boost::asio::buffer_copy(
+                        buffer.prepare(bytes_transferred - used),
+                        boost::asio::buffer(&bodyFileChunk[used],
+                                            bytes_transferred - used)));
+                }
+                // The deadline covers the gap between reads, not the whole
+                // upload
+                startDeadline(policy.bodyReadTimeout,
+                              CloseReason::readTimeout);
+                doReadBodyFile();
+            });
+    }
+
+    void startBodyParts(const std::string& boundary)
+    {
+        bodyParts.emplace(boundary);
+        bodyParts->onPartBegin = [this](const multipart::Part& part) {
+            bodyPartIsFile = !part.filename.empty();
+            if (bodyPartIsFile && bodyFileParts++ != 0)
+            {
+                // One file per upload
+                return false;
+            }
+            bodyPartField = part.name;
+            return true;
+        };
+        bodyParts->onPartData = [this](const char* data, size_t size) {
+            if (bodyPartIsFile)
+            {
+                if (!writeBodyFile(data, size))
+                {
+                    bodyPartsError =
+                        boost::beast::http::status::internal_server_error;
+                    return false;
+                }
+                return true;
+            }
+            bodyFormFieldBytes += size;
+            if (bodyFormFieldBytes > httpFormFieldsLimit)
+            {
+                bodyPartsError = boost::beast::http::status::payload_too_large;
+                return false;
+            }
+            req->formFields[bodyPartField].append(data, size);
+            return true;
+        };
+    }
+
+    bool appendBodyFile(const char* data, size_t size)
+    {
+        bodyFileRemaining -= size;
+        bodyUpload->received += size;
+        if (!bodyParts)
+        {
+            if (!writeBodyFile(data, size))
+            {
+                failBodyFile(
+                    boost::beast::http::status::internal_server_error);
+                return false;
+            }
+            return true;
+        }
+        bodyPartsError = boost::beast::http::status::bad_request;
+        if (!bodyParts->feed(data, size))
+        {
+            failBodyFile(bodyPartsError);
+            return false;
+        }
+        return true;
+    }
+
+    bool writeBodyFile(const char* data, size_t size)
+    {
+        EVP_DigestUpdate(bodyHash, data, size);
+        while (size > 0)
+        {
+            ssize_t written = ::write(bodyFileFd, data, size);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                BMCWEB_LOG_ERROR << this << " Failed to write "
+                                 << req->bodyFile << ": " << strerror(errno);
+                return false;
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    void finishBodyFile()
+    {
+        if (bodyParts && (!bodyParts->done() || bodyFileParts == 0))
+        {
+            failBodyFile(boost::beast::http::status::bad_request);
+            return;
+        }
+        std::array<unsigned char, EVP_MAX_MD_SIZE> digest;
+        unsigned int digestSize = 0;
+        EVP_DigestFinal_ex(bodyHash, digest.data(), &digestSize);
+        closeBodyFile();
+
+        constexpr const char* hexDigits = "0123456789abcdef";
+        req->bodySha256.clear();
+        for (unsigned int i = 0; i < digestSize; i++)
+        {
+            req->bodySha256 += hexDigits[digest[i] >> 4];
+            req->bodySha256 += hexDigits[digest[i] & 0xf];
+        }
+        cancelDeadlineTimer();
+        scheduleOnHandlerThread(Priority::bulk, [this] { callRouteHandler(); });
+    }
+
+    void failBodyFile(boost::beast::http::status status)
+    {
+        cancelDeadlineTimer();
+        closeBodyFile();
+        removeBodyFile();
+        // The rest of the body is never read, so the connection can't be
+        // used for another request
+        req->req.keep_alive(false);
+        res.result(status);
+        runOnHandlerThread([this] { completeRequest(); });
+    }
+
+    void closeBodyFile()
+    {
+        if (bodyFileFd >= 0)
+        {
+            ::close(bodyFileFd);
+            bodyFileFd = -1;
+        }
+        if (bodyHash != nullptr)
+        {
+            EVP_MD_CTX_free(bodyHash);
+            bodyHash = nullptr;
+        }
+        bodyParts.reset();
+        bodyPartIsFile = false;
+        bodyFileParts = 0;
+        bodyFormFieldBytes = 0;
+        bodyUpload.reset();
+        // Uploads are rare; don't keep the chunk buffer around for them
+        std::vector<char>().swap(bodyFileChunk);
+    }
+
+    void removeBodyFile()
+    {
+        if (req && !req->bodyFile.empty())
+        {
+            // Fails harmlessly if the handler moved the file
+            ::unlink(req->bodyFile.c_str());
+            req->bodyFile.clear();
+            req->upload.reset();
+        }
+    }
+
     void doRead()
     {
         // auto self = this->shared_from_this();
@@ -522,9 +1214,10 @@ class Connection
             adaptor.socket(), buffer, *parser,
             [this](const boost::system::error_code& ec,
                    std::size_t bytes_transferred) {
-                BMCWEB_LOG_ERROR << this << " async_read " << bytes_transferred
+                BMCWEB_LOG_DEBUG << this << " async_read " << bytes_transferred
                                  << " Bytes";
                 isReading = false;
+                bufferShare.update(buffer.capacity());
 
                 bool errorWhileReading = false;
                 if (ec)
@@ -547,6 +1240,7 @@ class Connection
                     checkDestroy();
                     return;
                 }
+                countBytesIn(bytes_transferred);
                 handle();
             });
     }
@@ -556,51 +1250,327 @@ class Connection
         // auto self = this->shared_from_this();
         isWriting = true;
         BMCWEB_LOG_DEBUG << "Doing Write";
+        if (res.fileBody.isOpen())
+        {
+            doWriteFile();
+            return;
+        }
+        if (res.bodyGenerator)
+        {
+            doWriteChunkedHeader();
+            return;
+        }
         res.preparePayload();
         serializer.emplace(*res.stringResponse);
         boost::beast::http::async_write(
             adaptor.socket(), *serializer,
-            [&](const boost::system::error_code& ec,
-                std::size_t bytes_transferred) {
-                isWriting = false;
-                BMCWEB_LOG_DEBUG << this << " Wrote " << bytes_transferred
-                                 << " bytes";
+            [this](const boost::system::error_code& ec,
+                   std::size_t bytes_transferred) {
+                serializer.reset();
+                afterWrite(ec, bytes_transferred);
+            });
+    }
 
+    void doWriteFile()
+    {
+        fileBody = std::move(res.fileBody);
+        res.stringResponse->content_length(fileBody.length);
+        serializer.emplace(*res.stringResponse);
+        boost::beast::http::async_write_header(
+            adaptor.socket(), *serializer,
+            [this](const boost::system::error_code& ec,
+                   std::size_t bytes_transferred) {
+                serializer.reset();
+                fileBytesWritten = bytes_transferred;
                 if (ec)
                 {
-                    BMCWEB_LOG_DEBUG << this << " from write(2)";
-                    checkDestroy();
+                    finishFileWrite(ec);
+                    return;
+                }
+                writeFileBody(typename Adaptor::secure());
+            });
+    }
+
+    // Without TLS the kernel copies the file to the socket itself
+    void writeFileBody(std::false_type)
+    {
+        auto& socket = adaptor.socket();
+        boost::system::error_code ec;
+        socket.native_non_blocking(true, ec);
+        if (ec)
+        {
+            finishFileWrite(ec);
+            return;
+        }
+        if (fileBody.length == 0)
+        {
+            finishFileWrite(boost::system::error_code());
+            return;
+        }
+        off_t offset = static_cast<off_t>(fileBody.offset);
+        ssize_t sent;
+        do
+        {
+            sent = ::sendfile(
+                socket.native_handle(), fileBody.fd, &offset,
+                std::min<uint64_t>(fileBody.length, httpSendfileChunkSize));
+        } while (sent < 0 && errno == EINTR);
+        if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            finishFileWrite(
+                boost::system::error_code(errno,
+                                          boost::system::system_category()));
+            return;
+        }
+        if (sent == 0)
+        {
+            // The file got shorter than the Content-Length sent
+            finishFileWrite(boost::asio::error::eof);
+            return;
+        }
+        if (sent > 0)
+        {
+            fileBodySent(static_cast<size_t>(sent));
+        }
+        // Each chunk goes back through the io_service, like the TLS writes
+        // do, so a large download doesn't hold up the other connections
+        socket.async_wait(boost::asio::socket_base::wait_write,
+                          [this](const boost::system::error_code& ec) {
+                              if (ec)
+                              {
+                                  finishFileWrite(ec);
+                                  return;
+                              }
+                              writeFileBody(std::false_type());
+                          });
+    }
+
+    // With TLS the file has to be read in and encrypted
+    void writeFileBody(std::true_type)
+    {
+        if (fileBody.length == 0)
+        {
+            finishFileWrite(boost::system::error_code());
+            return;
+        }
+        fileChunk.resize(httpFileReadChunkSize);
+        ssize_t got;
+        do
+        {
+            got = ::pread(
+                fileBody.fd, fileChunk.data(),
+                std::min<uint64_t>(fileBody.length, fileChunk.size()),
+                static_cast<off_t>(fileBody.offset));
+        } while (got < 0 && errno == EINTR);
+        if (got <= 0)
+        {
+            finishFileWrite(got < 0 ? boost::system::error_code(
+                                          errno,
+                                          boost::system::system_category())
+                                    : boost::asio::error::eof);
+            return;
+        }
+        boost::asio::async_write(
+            adaptor.socket(),
+            boost::asio::buffer(fileChunk.data(), static_cast<size_t>(got)),
+            [this](const boost::system::error_code& ec,
+                   std::size_t bytes_transferred) {
+                if (ec)
+                {
+                    finishFileWrite(ec);
                     return;
                 }
-                if (!req->keepAlive())
+                fileBodySent(bytes_transferred);
+                writeFileBody(std::true_type());
+            });
+    }
+
+    void fileBodySent(size_t bytes)
+    {
+        // A download is read once; don't let it push everything else out of
+        // the page cache
+        posix_fadvise(fileBody.fd, static_cast<off_t>(fileBody.offset),
+                      static_cast<off_t>(bytes), POSIX_FADV_DONTNEED);
+        fileBody.offset += bytes;
+        fileBody.length -= bytes;
+        fileBytesWritten += bytes;
+    }
+
+    void finishFileWrite(const boost::system::error_code& ec)
+    {
+        fileBody.close();
+        std::vector<char>().swap(fileChunk);
+        afterWrite(ec, fileBytesWritten);
+    }
+
+    void doWriteChunkedHeader()
+    {
+        chunkedResponse.emplace(std::move(res.stringResponse->base()));
+        chunkedResponse->chunked(true);
+        chunkedResponse->body().data = nullptr;
+        chunkedResponse->body().more = true;
+        chunkedSerializer.emplace(*chunkedResponse);
+        boost::beast::http::async_write_header(
+            adaptor.socket(), *chunkedSerializer,
+            [this](const boost::system::error_code& ec,
+                   std::size_t bytes_transferred) {
+                if (ec)
                 {
-                    adaptor.close();
-                    BMCWEB_LOG_DEBUG << this << " from write(1)";
-                    checkDestroy();
+                    finishChunkedWrite(ec, bytes_transferred);
                     return;
                 }
+                countBytesOut(bytes_transferred);
+                pullChunk();
+            });
+    }
 
-                serializer.reset();
-                BMCWEB_LOG_DEBUG << this << " Clearing response";
-                res.clear();
-                parser.emplace(std::piecewise_construct, std::make_tuple());
-                parser->body_limit(httpReqBodyLimit); // reset body limit for
-                                                      // newly created parser
-                buffer.consume(buffer.size());
-
-                req.emplace(parser->get());
-                doReadHeaders();
+    void pullChunk()
+    {
+        // Each chunk is a slice of bulk work, so anything more urgent gets to
+        // run between them
+        scheduleOnHandlerThread(Priority::bulk, [this] {
+            res.bodyGenerator([this](std::string&& chunk, bool more) {
+                runOnConnectionThread(
+                    [this, chunk{std::move(chunk)}, more]() mutable {
+                        doWriteChunk(std::move(chunk), more);
+                    });
+            });
+        });
+    }
+
+    void doWriteChunk(std::string&& chunk, bool more)
+    {
+        chunkBuffer = std::move(chunk);
+        boost::beast::http::buffer_body::value_type& body =
+            chunkedResponse->body();
+        body.data = chunkBuffer.empty() ? nullptr : &chunkBuffer[0];
+        body.size = chunkBuffer.size();
+        body.more = more;
+        boost::beast::http::async_write(
+            adaptor.socket(), *chunkedSerializer,
+            [this](const boost::system::error_code& ec,
+                   std::size_t bytes_transferred) {
+                // need_buffer means this chunk is out and the serializer
+                // wants the next one
+                if (ec == boost::beast::http::error::need_buffer)
+                {
+                    countBytesOut(bytes_transferred);
+                    pullChunk();
+                    return;
+                }
+                finishChunkedWrite(ec, bytes_transferred);
             });
     }
 
+    void finishChunkedWrite(const boost::system::error_code& ec,
+                            std::size_t bytes_transferred)
+    {
+        chunkedSerializer.reset();
+        chunkedResponse.reset();
+        std::string().swap(chunkBuffer);
+        afterWrite(ec, bytes_transferred);
+    }
+
+    void afterWrite(const boost::system::error_code& ec,
+                    std::size_t bytes_transferred)
+    {
+        isWriting = false;
+        removeBodyFile();
+        BMCWEB_LOG_DEBUG << this << " Wrote " << bytes_transferred
+                         << " bytes";
+        countBytesOut(bytes_transferred);
+        finishRequest();
+        if (timer.running())
+        {
+            RouteMetrics* metrics = handler->routeMetrics(routeIndex);
+            if (metrics != nullptr)
+            {
+                timer.finish(*metrics);
+            }
+            routeIndex = 0;
+        }
+
+        if (ec)
+        {
+            BMCWEB_LOG_DEBUG << this << " from write(2)";
+            checkDestroy();
+            return;
+        }
+        if (!req->keepAlive())
+        {
+            if (closeReason != CloseReason::maxRequests)
+            {
+                closeReason = CloseReason::noKeepAlive;
+            }
+            adaptor.close();
+            BMCWEB_LOG_DEBUG << this << " from write(1)";
+            checkDestroy();
+            return;
+        }
+
+        BMCWEB_LOG_DEBUG << this << " Clearing response";
+        res.clear();
+        arena.reset();
+        parser.emplace(std::piecewise_construct, std::make_tuple());
+        parser->body_limit(httpReqBodyLimit); // reset body limit for
+                                              // newly created parser
+        // The parser only consumed the bytes of the request it parsed.
+        // Anything left in buffer is the start of a pipelined request, which
+        // the next read parses before touching the socket.  Otherwise the
+        // buffer is freed if it grew big, so idle connections hold little.
+        releaseIdleBuffer(buffer, bufferShare);
+
+        req.emplace(parser->get());
+        startDeadline(policy.idleTimeout, CloseReason::idleTimeout);
+        doReadHeaders();
+    }
+
     void checkDestroy()
     {
         BMCWEB_LOG_DEBUG << this << " isReading " << isReading << " isWriting "
                          << isWriting;
         if (!isReading && !isWriting)
         {
-            BMCWEB_LOG_DEBUG << this << " delete (idle) ";
-            delete this;
+            leaveActive();
+            if (!releaseHandler)
+            {
+                BMCWEB_LOG_DEBUG << this << " delete (idle) ";
+                delete this;
+                return;
+            }
+            BMCWEB_LOG_DEBUG << this << " release (idle) ";
+            reset();
+            // The pool is owned by the accepting io_service
+            runOnHandlerThread([this] { releaseHandler(this); });
+        }
+    }
+
+    // Takes the connection out of the active count and out of admission
+    // control, once
+    void leaveActive()
+    {
+        finishRequest();
+        if (active)
+        {
+            active = false;
+            serverCounters().activeConnections--;
+        }
+        if (admitted)
+        {
+            admitted = false;
+            admissionControl().closeConnection(clientAddress);
+            connectionReuse().connectionClosed(requestCount, connectionBytes,
+                                               closeReason);
+        }
+    }
+
+    // Frees the in flight slot of the request, once
+    void finishRequest()
+    {
+        if (requestAdmitted)
+        {
+            requestAdmitted = false;
+            admissionControl().finishRequest();
         }
     }
 
@@ -609,25 +1579,47 @@ class Connection
         BMCWEB_LOG_DEBUG << this << " timer cancelled: " << &timerQueue << ' '
                          << timerCancelKey;
         timerQueue.cancel(timerCancelKey);
+        timerCancelKey = 0;
     }
 
-    void startDeadline()
+    // Closes the connection for reason unless the deadline is cancelled or
+    // replaced within timeout
+    void startDeadline(std::chrono::milliseconds timeout, CloseReason reason)
     {
         cancelDeadlineTimer();
 
-        timerCancelKey = timerQueue.add([this] {
-            if (!adaptor.isOpen())
-            {
-                return;
-            }
-            adaptor.close();
-        });
+        timerCancelKey = timerQueue.add(
+            [this, reason] {
+                timerCancelKey = 0;
+                if (!adaptor.isOpen())
+                {
+                    return;
+                }
+                closeReason = reason;
+                adaptor.close();
+            },
+            timeout);
         BMCWEB_LOG_DEBUG << this << " timer added: " << &timerQueue << ' '
                          << timerCancelKey;
     }
 
+    void countBytesIn(size_t bytes)
+    {
+        serverCounters().bytesIn += bytes;
+        connectionBytes += bytes;
+    }
+
+    void countBytesOut(size_t bytes)
+    {
+        serverCounters().bytesOut += bytes;
+        connectionBytes += bytes;
+    }
+
   private:
     Adaptor adaptor;
+    typename Adaptor::context* adaptorCtx;
+    boost::asio::io_service& connectionIo;
+    boost::asio::io_service& handlerIo;
     Handler* handler;
 
     // Making this a boost::optional allows it to be efficiently destroyed and
@@ -636,29 +1628,90 @@ class Connection
         boost::beast::http::request_parser<boost::beast::http::string_body>>
         parser;
 
+    // Empty until read into, then grows as needed up to 8192 bytes.  Freed
+    // again by releaseIdleBuffer() between requests.
     boost::beast::flat_buffer buffer{8192};
+    BufferShare bufferShare;
 
     boost::optional<boost::beast::http::response_serializer<
         boost::beast::http::string_body>>
         serializer;
 
+    // Only used while writing a response with a streamed body
+    FileBody fileBody;
+    std::vector<char> fileChunk;
+    size_t fileBytesWritten{0};
+    boost::optional<
+        boost::beast::http::response<boost::beast::http::buffer_body>>
+        chunkedResponse;
+    boost::optional<boost::beast::http::response_serializer<
+        boost::beast::http::buffer_body>>
+        chunkedSerializer;
+    std::string chunkBuffer;
+
+    // Where the body of the current request goes once the middlewares let
+    // it through; null for a request whose body the parser collects
+    const std::string* bodyFileDirectory{nullptr};
+    // Only used while streaming a request body to Request::bodyFile
+    int bodyFileFd{-1};
+    uint64_t bodyFileRemaining{0};
+    EVP_MD_CTX* bodyHash{nullptr};
+    std::vector<char> bodyFileChunk;
+    std::shared_ptr<UploadProgress> bodyUpload;
+    // Only used for a multipart/form-data body
+    boost::optional<multipart::Parser> bodyParts;
+    boost::beast::http::status bodyPartsError{
+        boost::beast::http::status::bad_request};
+    bool bodyPartIsFile{false};
+    size_t bodyFileParts{0};
+    std::string bodyPartField;
+    size_t bodyFormFieldBytes{0};
+
     boost::optional<crow::Request> req;
+    // Declared before res, which points at it
+    Arena arena;
     crow::Response res;
 
     const std::string& serverName;
 
-    int timerCancelKey{-1};
+    detail::TimerQueue::TimerId timerCancelKey{0};
 
     bool isReading{};
     bool isWriting{};
     bool needToCallAfterHandlers{};
+    // Continues a request whose middlewares finished asynchronously
+    std::function<void()> middlewaresDone = [this] { callRouteHandler(); };
     bool needToStartReadAfterComplete{};
     bool addKeepAlive{};
 
+    // Counted in ServerCounters::activeConnections
+    bool active{};
+    // Counted by admissionControl(), as a connection from clientAddress and
+    // as a request in flight
+    boost::asio::ip::address clientAddress;
+    bool admitted{};
+    bool requestAdmitted{};
+    // Copied from connectionReuse() when the connection starts, so a change
+    // applies to connections accepted after it
+    KeepAlivePolicy policy;
+    // Requests read, and bytes read and written, on this connection
+    uint64_t requestCount{0};
+    uint64_t connectionBytes{0};
+    // Reported to connectionReuse() when the connection closes
+    CloseReason closeReason{CloseReason::client};
+    // The 503 a refused connection is answered with
+    std::string refusal;
+    // See Request::localSession
+    std::shared_ptr<void> localSession;
+    RequestTimer timer;
+    // The rule that handled the request, as Router::handle reports it
+    unsigned routeIndex{0};
+
     std::tuple<Middlewares...>* middlewares;
     detail::Context<Middlewares...> ctx;
 
-    std::function<std::string()>& getCachedDateStr;
+    const detail::DateHeader& dateHeader;
     detail::TimerQueue& timerQueue;
+    std::function<void(Connection*)> releaseHandler;
 }; // namespace crow
 } // namespace crow
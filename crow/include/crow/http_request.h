@@ -1,14 +1,50 @@
 #pragma once
 
+#include <array>
 #include <boost/asio.hpp>
 #include <boost/beast/http.hpp>
 #include <boost/beast/websocket.hpp>
+#include <boost/container/flat_map.hpp>
+#include <memory>
 
 #include "crow/common.h"
 #include "crow/query_string.h"
+#include "crow/upload_progress.h"
 
 namespace crow
 {
+namespace detail
+{
+class TimerQueue;
+} // namespace detail
+
+// Headers most requests get asked about, found once per request instead of
+// by searching the field list on every lookup
+enum class KnownHeader
+{
+    accept,
+    acceptEncoding,
+    authorization,
+    contentType,
+    cookie,
+    host,
+    ifNoneMatch,
+    ifRange,
+    range,
+    userAgent,
+    xAuthToken,
+    xXsrfToken,
+    count
+};
+
+constexpr const char* knownHeaderNames[] = {
+    "Accept",   "Accept-Encoding", "Authorization", "Content-Type",
+    "Cookie",   "Host",            "If-None-Match", "If-Range",
+    "Range",    "User-Agent",      "X-Auth-Token",  "X-XSRF-TOKEN"};
+
+static_assert(sizeof(knownHeaderNames) / sizeof(knownHeaderNames[0]) ==
+                  static_cast<size_t>(KnownHeader::count),
+              "Every KnownHeader needs a name");
 
 struct Request
 {
@@ -20,6 +56,28 @@ struct Request
 
     void* middlewareContext{};
     boost::asio::io_service* ioService{};
+    // The timers of the io_service the socket belongs to, for a websocket
+    // the request is upgraded to; only for use on that io_service
+    detail::TimerQueue* timerQueue{};
+
+    // Only set for routes that stream their body to a file, in which case
+    // body is empty.  The file is deleted once the response has been sent,
+    // so a handler that wants to keep it has to move it somewhere else.
+    std::string bodyFile;
+    // Hex encoded SHA-256 of the contents of bodyFile
+    std::string bodySha256;
+    // For a multipart/form-data body, bodyFile holds the contents of its file
+    // part, and the other fields of the form are here
+    boost::container::flat_map<std::string, std::string> formFields;
+    // The streamed body, until the response is sent; the id names it in
+    // the UploadRegistry
+    std::shared_ptr<const UploadProgress> upload;
+    // For a request over the Unix socket, the account the client process
+    // runs as; empty for everything else
+    std::string localUser;
+    // Where the session made for localUser is kept for the connection's
+    // later requests; null where there is no such connection
+    std::shared_ptr<void>* localSession{};
 
     Request(boost::beast::http::request<boost::beast::http::string_body>& req) :
         req(req), body(req.body())
@@ -41,6 +99,80 @@ struct Request
         return req[key];
     }
 
+    const boost::string_view getHeaderValue(KnownHeader key) const
+    {
+        if (!headersIndexed)
+        {
+            return req[knownHeaderNames[static_cast<size_t>(key)]];
+        }
+        return knownHeaders[static_cast<size_t>(key)];
+    }
+
+    // Records where each KnownHeader is, in a single pass over the fields.
+    // Called once the header has been parsed; the first of repeated fields
+    // wins, as with req[].
+    void indexHeaders()
+    {
+        knownHeaders.fill(boost::string_view());
+        for (const auto& field : req)
+        {
+            KnownHeader key = KnownHeader::count;
+            switch (field.name())
+            {
+                case boost::beast::http::field::accept:
+                    key = KnownHeader::accept;
+                    break;
+                case boost::beast::http::field::accept_encoding:
+                    key = KnownHeader::acceptEncoding;
+                    break;
+                case boost::beast::http::field::authorization:
+                    key = KnownHeader::authorization;
+                    break;
+                case boost::beast::http::field::content_type:
+                    key = KnownHeader::contentType;
+                    break;
+                case boost::beast::http::field::cookie:
+                    key = KnownHeader::cookie;
+                    break;
+                case boost::beast::http::field::host:
+                    key = KnownHeader::host;
+                    break;
+                case boost::beast::http::field::if_none_match:
+                    key = KnownHeader::ifNoneMatch;
+                    break;
+                case boost::beast::http::field::if_range:
+                    key = KnownHeader::ifRange;
+                    break;
+                case boost::beast::http::field::range:
+                    key = KnownHeader::range;
+                    break;
+                case boost::beast::http::field::user_agent:
+                    key = KnownHeader::userAgent;
+                    break;
+                case boost::beast::http::field::unknown:
+                    if (boost::beast::iequals(field.name_string(),
+                                              "X-Auth-Token"))
+                    {
+                        key = KnownHeader::xAuthToken;
+                    }
+                    else if (boost::beast::iequals(field.name_string(),
+                                                   "X-XSRF-TOKEN"))
+                    {
+                        key = KnownHeader::xXsrfToken;
+                    }
+                    break;
+                default:
+                    break;
+            }
+            if (key != KnownHeader::count &&
+                knownHeaders[static_cast<size_t>(key)].empty())
+            {
+                knownHeaders[static_cast<size_t>(key)] = field.value();
+            }
+        }
+        headersIndexed = true;
+    }
+
     const boost::string_view methodString() const
     {
         return req.method_string();
@@ -51,7 +183,7 @@ struct Request
         return req.target();
     }
 
-    unsigned version()
+    unsigned version() const
     {
         return req.version();
     }
@@ -67,6 +199,11 @@ struct Request
     }
 
     boost::beast::http::request<boost::beast::http::string_body>& req;
+
+  private:
+    std::array<boost::string_view, static_cast<size_t>(KnownHeader::count)>
+        knownHeaders{};
+    bool headersIndexed{false};
 };
 
 } // namespace crow
@@ -1,9 +1,18 @@
 #pragma once
 #include "nlohmann/json.hpp"
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <boost/beast/http.hpp>
+#include <ctime>
+#include <functional>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "crow/arena.h"
 #include "crow/http_request.h"
 #include "crow/logging.h"
 
@@ -12,11 +21,93 @@ namespace crow
 
 template <typename Adaptor, typename Handler, typename... Middlewares>
 class Connection;
+template <typename Adaptor, typename Handler, typename... Middlewares>
+class HTTP2Connection;
+
+// A regular file, or a range of it, sent as a response body
+class FileBody
+{
+  public:
+    FileBody() = default;
+    FileBody(const FileBody&) = delete;
+    FileBody& operator=(const FileBody&) = delete;
+
+    FileBody(FileBody&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    FileBody& operator=(FileBody&& other) noexcept
+    {
+        if (this != &other)
+        {
+            close();
+            fd = other.fd;
+            size = other.size;
+            modified = other.modified;
+            offset = other.offset;
+            length = other.length;
+            other.fd = -1;
+        }
+        return *this;
+    }
+
+    ~FileBody()
+    {
+        close();
+    }
+
+    bool open(const std::string& path)
+    {
+        close();
+        fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+        {
+            close();
+            return false;
+        }
+        size = static_cast<uint64_t>(st.st_size);
+        modified = st.st_mtime;
+        offset = 0;
+        length = size;
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        return true;
+    }
+
+    void close()
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    bool isOpen() const
+    {
+        return fd >= 0;
+    }
+
+    int fd = -1;
+    // Of the whole file
+    uint64_t size = 0;
+    time_t modified = 0;
+    // The part still to send
+    uint64_t offset = 0;
+    uint64_t length = 0;
+};
 
 struct Response
 {
     template <typename Adaptor, typename Handler, typename... Middlewares>
     friend class crow::Connection;
+    template <typename Adaptor, typename Handler, typename... Middlewares>
+    friend class crow::HTTP2Connection;
     using response_type =
         boost::beast::http::response<boost::beast::http::string_body>;
 
@@ -24,6 +115,19 @@ struct Response
 
     nlohmann::json jsonValue;
 
+    // Memory for objects that live until this response is sent, such as the
+    // AsyncResp that builds it; reset before the next request.  Null where
+    // responses have no arena, which allocateShared() and ArenaAllocator
+    // handle by using the heap.
+    Arena* arena = nullptr;
+
+    // Delivers the next piece of a generated body.  more == false marks the
+    // last piece.
+    using ChunkCallback = std::function<void(std::string&& chunk, bool more)>;
+    // Called whenever the connection is ready for more body data; it must
+    // call the ChunkCallback exactly once, possibly asynchronously.
+    using BodyGenerator = std::function<void(const ChunkCallback&)>;
+
     void addHeader(const boost::string_view key, const boost::string_view value)
     {
         stringResponse->set(key, value);
@@ -34,6 +138,25 @@ struct Response
         stringResponse->set(key, value);
     }
 
+    // A fixed set of headers that many responses carry, built once
+    using HeaderBlock = std::vector<std::pair<std::string, std::string>>;
+
+    // Adds every header in the block in one pass.  Unlike addHeader() this
+    // doesn't look for an existing field of the same name first, so the block
+    // must not contain headers that are also set elsewhere.
+    void addHeaders(const HeaderBlock& headers)
+    {
+        for (const std::pair<std::string, std::string>& header : headers)
+        {
+            stringResponse->insert(header.first, header.second);
+        }
+    }
+
+    boost::string_view getHeaderValue(boost::string_view key) const
+    {
+        return stringResponse->base()[key];
+    }
+
     Response() : stringResponse(response_type{})
     {
     }
@@ -41,6 +164,7 @@ struct Response
     explicit Response(boost::beast::http::status code) :
         stringResponse(response_type{})
     {
+        stringResponse->result(code);
     }
 
     explicit Response(boost::string_view body_) :
@@ -75,6 +199,9 @@ struct Response
         stringResponse = std::move(r.stringResponse);
         r.stringResponse.emplace(response_type{});
         jsonValue = std::move(r.jsonValue);
+        fileBody = std::move(r.fileBody);
+        bodyGenerator = std::move(r.bodyGenerator);
+        r.bodyGenerator = nullptr;
         completed = r.completed;
         return *this;
     }
@@ -109,6 +236,51 @@ struct Response
         return stringResponse->body();
     }
 
+    // Send the contents of a regular file as the body, straight from the
+    // page cache instead of being loaded into body().  Returns false if the
+    // file can't be opened.
+    bool openFileBody(const std::string& path)
+    {
+        if (!fileBody.open(path))
+        {
+            BMCWEB_LOG_DEBUG << "Failed to open " << path;
+            return false;
+        }
+        return true;
+    }
+
+    const FileBody& getFileBody() const
+    {
+        return fileBody;
+    }
+
+    // Sends only length bytes of the file, starting at offset.  The caller
+    // has checked that they are within the file.
+    void setFileBodyRange(uint64_t offset, uint64_t length)
+    {
+        fileBody.offset = offset;
+        fileBody.length = length;
+    }
+
+    void closeFileBody()
+    {
+        fileBody.close();
+    }
+
+    // Send the body with chunked transfer encoding, pulling each chunk from
+    // generator as the previous one has been written.  The generator is
+    // called on the same io_service as route handlers.
+    void setBodyGenerator(BodyGenerator generator)
+    {
+        bodyGenerator = std::move(generator);
+    }
+
+    // True if the body comes from a file or generator instead of body()
+    bool isStreamed() const
+    {
+        return fileBody.isOpen() || bodyGenerator;
+    }
+
     void keepAlive(bool k)
     {
         stringResponse->keep_alive(k);
@@ -116,6 +288,12 @@ struct Response
 
     void preparePayload()
     {
+        // A 304 has no body, and any Content-Length it carries has to be
+        // that of the full response, so leave it out entirely
+        if (result() == boost::beast::http::status::not_modified)
+        {
+            return;
+        }
         stringResponse->prepare_payload();
     };
 
@@ -124,7 +302,11 @@ struct Response
         BMCWEB_LOG_DEBUG << this << " Clearing response containers";
         stringResponse.emplace(response_type{});
         jsonValue.clear();
+        fileBody.close();
+        bodyGenerator = nullptr;
         completed = false;
+        deferred = false;
+        resumeHandler = nullptr;
     }
 
     void write(boost::string_view body_part)
@@ -154,14 +336,58 @@ struct Response
         end();
     }
 
+    // Replaces what end() calls once the response is complete.  Lets a
+    // response built for a request made internally, rather than read from a
+    // connection, report back when the handler is done with it.
+    void setCompleteRequestHandler(std::function<void()> handler)
+    {
+        completeRequestHandler = std::move(handler);
+    }
+
     bool isAlive()
     {
         return isAliveHelper && isAliveHelper();
     }
 
+    // Lets a middleware finish beforeHandle asynchronously.  It calls
+    // defer() before returning and resume() once it has decided, after
+    // end() if it answered the request itself.  The middlewares after it and
+    // the route handler only run from resume().
+    void defer()
+    {
+        deferred = true;
+    }
+
+    void resume()
+    {
+        deferred = false;
+        std::function<void()> handler = std::move(resumeHandler);
+        resumeHandler = nullptr;
+        if (handler)
+        {
+            handler();
+        }
+    }
+
+    bool isDeferred() const
+    {
+        return deferred;
+    }
+
+    // Set by the middleware chain to continue a deferred request
+    void setResumeHandler(std::function<void()> handler)
+    {
+        resumeHandler = std::move(handler);
+    }
+
   private:
+    FileBody fileBody;
+    BodyGenerator bodyGenerator;
+
     bool completed{};
+    bool deferred{};
     std::function<void()> completeRequestHandler;
+    std::function<void()> resumeHandler;
     std::function<bool()> isAliveHelper;
 
     // In case of a JSON object, set the Content-Type header
@@ -9,8 +9,15 @@
 #include <memory>
 #include <utility>
 #include <vector>
+#ifdef BMCWEB_ENABLE_IO_THREAD_POOL
+#include <thread>
+#endif
 
+#include "crow/date_header.h"
 #include "crow/http_connection.h"
+#ifdef BMCWEB_ENABLE_HTTP2
+#include "crow/http2_connection.h"
+#endif
 #include "crow/logging.h"
 #include "crow/timer_queue.h"
 #ifdef BMCWEB_ENABLE_SSL
@@ -22,19 +29,120 @@ namespace crow
 using namespace boost;
 using tcp = asio::ip::tcp;
 
+namespace detail
+{
+// State owned by one io_service that services accepted connections.  A
+// connection only ever touches the timer queue of the worker its socket
+// belongs to, so workers never share mutable state.
+struct IoWorker
+{
+    explicit IoWorker(std::shared_ptr<asio::io_service> ioIn) :
+        io(std::move(ioIn)), timer(*io)
+    {
+    }
+
+    std::shared_ptr<asio::io_service> io;
+    TimerQueue timerQueue;
+    asio::deadline_timer timer;
+#ifdef BMCWEB_ENABLE_IO_THREAD_POOL
+    std::unique_ptr<asio::io_service::work> work;
+    std::thread thread;
+#endif
+};
+
+struct ConnectionPoolStats
+{
+    size_t created{};
+    size_t reused{};
+    size_t recycled{};
+    size_t discarded{};
+    size_t idle{};
+};
+
+// Bounded free list of connection objects, so connection churn reuses the
+// same parser, buffer and context allocations instead of fragmenting the
+// heap.  Only used from the io_service that accepts connections.
+template <typename ConnectionType> class ConnectionPool
+{
+  public:
+    explicit ConnectionPool(size_t maxIdle) : maxIdle(maxIdle)
+    {
+        idle.reserve(maxIdle);
+    }
+
+    ~ConnectionPool()
+    {
+        for (ConnectionType* connection : idle)
+        {
+            delete connection;
+        }
+    }
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    template <typename... Args> ConnectionType* acquire(Args&&... args)
+    {
+        if (!idle.empty())
+        {
+            ConnectionType* connection = idle.back();
+            idle.pop_back();
+            stats.reused++;
+            return connection;
+        }
+        stats.created++;
+        return new ConnectionType(std::forward<Args>(args)...);
+    }
+
+    // connection must already have been reset()
+    void release(ConnectionType* connection)
+    {
+        if (idle.size() >= maxIdle)
+        {
+            stats.discarded++;
+            delete connection;
+            return;
+        }
+        stats.recycled++;
+        idle.push_back(connection);
+    }
+
+    ConnectionPoolStats getStats() const
+    {
+        ConnectionPoolStats ret = stats;
+        ret.idle = idle.size();
+        return ret;
+    }
+
+  private:
+    size_t maxIdle;
+    std::vector<ConnectionType*> idle;
+    ConnectionPoolStats stats;
+};
+} // namespace detail
+
+// Idle connection objects kept around for reuse, per io worker
+constexpr size_t maxIdleConnectionsPerWorker = 16;
+
 template <typename Handler, typename Adaptor = SocketAdaptor,
           typename... Middlewares>
 class Server
 {
+    using connection_t = Connection<Adaptor, Handler, Middlewares...>;
+    using connection_pool_t = detail::ConnectionPool<connection_t>;
+    // A TCP acceptor, or a Unix socket one for the UnixSocketAdaptor
+    using acceptor_t = typename Adaptor::protocol::acceptor;
+
   public:
-    Server(Handler* handler, std::unique_ptr<tcp::acceptor>&& acceptor,
+    Server(Handler* handler, std::unique_ptr<acceptor_t>&& acceptor,
            std::tuple<Middlewares...>* middlewares = nullptr,
            typename Adaptor::context* adaptor_ctx = nullptr,
            std::shared_ptr<boost::asio::io_service> io =
                std::make_shared<boost::asio::io_service>()) :
         ioService(std::move(io)),
         acceptor(std::move(acceptor)), signals(*ioService, SIGINT, SIGTERM),
-        tickTimer(*ioService), handler(handler), middlewares(middlewares),
+        tickTimer(*ioService), dateTimer(*ioService), handler(handler),
+        middlewares(middlewares),
         adaptorCtx(adaptor_ctx)
     {
     }
@@ -59,8 +167,8 @@ class Server
            std::shared_ptr<boost::asio::io_service> io =
                std::make_shared<boost::asio::io_service>()) :
         Server(handler,
-               std::make_unique<tcp::acceptor>(*io, boost::asio::ip::tcp::v6(),
-                                               existing_socket),
+               std::make_unique<acceptor_t>(*io, Adaptor::listenProtocol(),
+                                            existing_socket),
                middlewares, adaptor_ctx, io)
     {
     }
@@ -85,52 +193,42 @@ class Server
         });
     }
 
-    void updateDateStr()
+#ifdef BMCWEB_ENABLE_IO_THREAD_POOL
+    ~Server()
     {
-        auto lastTimeT = time(0);
-        tm myTm{};
+        stop();
+    }
 
-#ifdef _MSC_VER
-        gmtime_s(&my_tm, &last_time_t);
-#else
-        gmtime_r(&lastTimeT, &myTm);
+    // Number of worker threads that service connection I/O.  Zero keeps
+    // everything on the io_service passed to the constructor.
+    void setWorkerThreads(size_t count)
+    {
+        workerThreads = count;
+    }
 #endif
-        dateStr.resize(100);
-        size_t dateStrSz =
-            strftime(&dateStr[0], 99, "%a, %d %b %Y %H:%M:%S GMT", &myTm);
-        dateStr.resize(dateStrSz);
-    };
 
     void run()
     {
-        updateDateStr();
-
-        getCachedDateStr = [this]() -> std::string {
-            static std::chrono::time_point<std::chrono::steady_clock>
-                lastDateUpdate = std::chrono::steady_clock::now();
-            if (std::chrono::steady_clock::now() - lastDateUpdate >=
-                std::chrono::seconds(10))
-            {
-                lastDateUpdate = std::chrono::steady_clock::now();
-                updateDateStr();
-            }
-            return this->dateStr;
-        };
-
-        boost::asio::deadline_timer timer(*ioService);
-        timer.expires_from_now(boost::posix_time::seconds(1));
-
-        std::function<void(const boost::system::error_code& ec)> handler;
-        handler = [&](const boost::system::error_code& ec) {
-            if (ec)
-            {
-                return;
-            }
-            timerQueue.process();
-            timer.expires_from_now(boost::posix_time::seconds(1));
-            timer.async_wait(handler);
-        };
-        timer.async_wait(handler);
+#ifdef BMCWEB_ENABLE_IO_THREAD_POOL
+        for (size_t i = 0; i < workerThreads; i++)
+        {
+            workers.emplace_back(std::make_unique<detail::IoWorker>(
+                std::make_shared<asio::io_service>()));
+        }
+#endif
+        if (workers.empty())
+        {
+            workers.emplace_back(
+                std::make_unique<detail::IoWorker>(ioService));
+        }
+        for (auto& worker : workers)
+        {
+            connectionPools.emplace_back(
+                std::make_unique<connection_pool_t>(
+                    maxIdleConnectionsPerWorker));
+            startWorker(*worker);
+        }
+        startDateTimer();
 
         if (tickFunction && tickInterval.count() > 0)
         {
@@ -146,7 +244,8 @@ class Server
         }
 
         BMCWEB_LOG_INFO << serverName << " server is running, local endpoint "
-                        << acceptor->local_endpoint();
+                        << acceptor->local_endpoint() << ", "
+                        << workers.size() << " io worker(s)";
 
         signals.async_wait([&](const boost::system::error_code& /*error*/,
                                int /*signal_number*/) { stop(); });
@@ -157,36 +256,119 @@ class Server
     void stop()
     {
         ioService->stop();
+#ifdef BMCWEB_ENABLE_IO_THREAD_POOL
+        for (auto& worker : workers)
+        {
+            worker->work.reset();
+            worker->io->stop();
+            if (worker->thread.joinable() &&
+                worker->thread.get_id() != std::this_thread::get_id())
+            {
+                worker->thread.join();
+            }
+        }
+#endif
     }
 
     void doAccept()
     {
-        auto p = new Connection<Adaptor, Handler, Middlewares...>(
-            *ioService, handler, serverName, middlewares, getCachedDateStr,
-            timerQueue, adaptorCtx);
+        // Hand accepted sockets out to the workers round robin.  Middlewares
+        // and route handlers are always called on ioService, the io_service
+        // that also owns the D-Bus connection.
+        detail::IoWorker& worker = *workers[nextWorker];
+        connection_pool_t* pool = connectionPools[nextWorker].get();
+        nextWorker = (nextWorker + 1) % workers.size();
+
+        connection_t* p = pool->acquire(
+            *worker.io, *ioService, handler, serverName, middlewares,
+            dateHeader, worker.timerQueue, adaptorCtx,
+            [pool](connection_t* connection) { pool->release(connection); });
         acceptor->async_accept(
-            p->socket(), [this, p](boost::system::error_code ec) {
+            p->socket(),
+            [this, p, pool, io{worker.io}](boost::system::error_code ec) {
                 if (!ec)
                 {
-                    this->ioService->post([p] { p->start(); });
+                    io->post([p] { p->start(); });
                 }
                 else
                 {
-                    delete p;
+                    pool->release(p);
                 }
                 doAccept();
             });
     }
 
+    detail::ConnectionPoolStats getConnectionPoolStats() const
+    {
+        detail::ConnectionPoolStats total;
+        for (const auto& pool : connectionPools)
+        {
+            detail::ConnectionPoolStats stats = pool->getStats();
+            total.created += stats.created;
+            total.reused += stats.reused;
+            total.recycled += stats.recycled;
+            total.discarded += stats.discarded;
+            total.idle += stats.idle;
+        }
+        return total;
+    }
+
   private:
+    void startWorker(detail::IoWorker& worker)
+    {
+        startTimerQueue(worker);
+#ifdef BMCWEB_ENABLE_IO_THREAD_POOL
+        if (worker.io != ioService)
+        {
+            worker.work =
+                std::make_unique<asio::io_service::work>(*worker.io);
+            worker.thread = std::thread([io{worker.io}] { io->run(); });
+        }
+#endif
+    }
+
+    void startTimerQueue(detail::IoWorker& worker)
+    {
+        worker.timer.expires_from_now(boost::posix_time::milliseconds(
+            detail::TimerQueue::resolution().count()));
+        worker.timer.async_wait(
+            [this, &worker](const boost::system::error_code& ec) {
+                if (ec)
+                {
+                    return;
+                }
+                worker.timerQueue.process();
+                startTimerQueue(worker);
+            });
+    }
+
+    void startDateTimer()
+    {
+        dateHeader.update();
+        dateTimer.expires_from_now(boost::posix_time::seconds(1));
+        dateTimer.async_wait([this](const boost::system::error_code& ec) {
+            if (ec)
+            {
+                return;
+            }
+            startDateTimer();
+        });
+    }
+
     std::shared_ptr<asio::io_service> ioService;
-    detail::TimerQueue timerQueue;
-    std::function<std::string()> getCachedDateStr;
-    std::unique_ptr<tcp::acceptor> acceptor;
+    std::vector<std::unique_ptr<detail::IoWorker>> workers;
+    // Indexed like workers; a pooled connection stays bound to its worker
+    std::vector<std::unique_ptr<connection_pool_t>> connectionPools;
+    size_t nextWorker{0};
+#ifdef BMCWEB_ENABLE_IO_THREAD_POOL
+    size_t workerThreads{0};
+#endif
+    std::unique_ptr<acceptor_t> acceptor;
     boost::asio::signal_set signals;
     boost::asio::deadline_timer tickTimer;
-
-    std::string dateStr;
+    // Shared by all workers; only updated from dateTimer on ioService
+    detail::DateHeader dateHeader;
+    boost::asio::deadline_timer dateTimer;
 
     Handler* handler;
     std::string serverName = "iBMC";
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+namespace crow
+{
+namespace detail
+{
+// Serializes a JSON document a piece at a time, producing the same text as
+// dump(2).  Containers are walked with an explicit stack, so serializing can
+// stop when the output is full and pick up where it left off on the next
+// call; only leaf values are dumped whole.
+class JsonChunkWriter
+{
+  public:
+    explicit JsonChunkWriter(nlohmann::json&& value) : root(std::move(value))
+    {
+        stack.push_back(Frame{&root, {}, false});
+    }
+
+    JsonChunkWriter(const JsonChunkWriter&) = delete;
+    JsonChunkWriter& operator=(const JsonChunkWriter&) = delete;
+
+    // Appends the next part of the document to out, stopping once out holds
+    // at least chunkSize bytes.  Returns false once the whole document has
+    // been written.
+    bool write(std::string& out, size_t chunkSize)
+    {
+        while (!stack.empty())
+        {
+            if (out.size() >= chunkSize)
+            {
+                return true;
+            }
+            step(out);
+        }
+        return false;
+    }
+
+  private:
+    static constexpr size_t indentStep = 2;
+
+    struct Frame
+    {
+        const nlohmann::json* value;
+        nlohmann::json::const_iterator next;
+        bool started;
+    };
+
+    void step(std::string& out)
+    {
+        Frame& frame = stack.back();
+        const nlohmann::json& value = *frame.value;
+        bool isObject = value.is_object();
+        if (!isObject && !value.is_array())
+        {
+            out += value.dump();
+            stack.pop_back();
+            return;
+        }
+
+        // Children are indented one level deeper than this frame
+        size_t depth = stack.size();
+        if (!frame.started)
+        {
+            frame.started = true;
+            if (value.empty())
+            {
+                out += isObject ? "{}" : "[]";
+                stack.pop_back();
+                return;
+            }
+            out += isObject ? "{\n" : "[\n";
+            frame.next = value.cbegin();
+        }
+        else if (frame.next == value.cend())
+        {
+            out += '\n';
+            out.append((depth - 1) * indentStep, ' ');
+            out += isObject ? '}' : ']';
+            stack.pop_back();
+            return;
+        }
+        else
+        {
+            out += ",\n";
+        }
+
+        out.append(depth * indentStep, ' ');
+        if (isObject)
+        {
+            out += nlohmann::json(frame.next.key()).dump();
+            out += ": ";
+        }
+        const nlohmann::json* child = &*frame.next;
+        ++frame.next;
+        // frame is invalidated once the stack grows
+        stack.push_back(Frame{child, {}, false});
+    }
+
+    nlohmann::json root;
+    std::vector<Frame> stack;
+};
+} // namespace detail
+} // namespace crow
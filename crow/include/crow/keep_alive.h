@@ -0,0 +1,270 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <boost/utility/string_view.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+
+namespace crow
+{
+
+// How long connections are kept open, and the deadlines for reading a
+// request; a connection that misses one is closed
+struct KeepAlivePolicy
+{
+    // For the headers of the first request, and the TLS handshake before
+    // them
+    std::chrono::milliseconds headerReadTimeout{5000};
+    // For the body, once the headers are in
+    std::chrono::milliseconds bodyReadTimeout{60000};
+    // For the headers of the next request, from when the last response was
+    // written.  Also how long an HTTP/2 connection is kept without streams.
+    std::chrono::milliseconds idleTimeout{15000};
+    // Requests an HTTP/1 connection serves before it is closed; 0 for no
+    // limit
+    uint64_t maxRequests = 0;
+};
+
+/**
+ * @brief Reads a policy from a list such as "idle=30,requests=1000", which
+ *        may set any of
+ *          header    headerReadTimeout, in seconds
+ *          body      bodyReadTimeout, in seconds
+ *          idle      idleTimeout, in seconds
+ *          requests  maxRequests
+ *
+ * @return false if spec isn't such a list; policy is then left alone
+ */
+inline bool parseKeepAlivePolicy(boost::string_view spec,
+                                 KeepAlivePolicy& policy)
+{
+    KeepAlivePolicy parsed = policy;
+    while (!spec.empty())
+    {
+        boost::string_view item = spec.substr(0, spec.find(','));
+        spec.remove_prefix(std::min(item.size() + 1, spec.size()));
+        size_t equals = item.find('=');
+        if (equals == boost::string_view::npos || equals + 1 == item.size())
+        {
+            return false;
+        }
+        boost::string_view name = item.substr(0, equals);
+        std::string text(item.substr(equals + 1));
+        char* end = nullptr;
+        unsigned long long value = std::strtoull(text.c_str(), &end, 10);
+        if (*end != '\0' || text[0] == '-')
+        {
+            return false;
+        }
+        if (name == "requests")
+        {
+            parsed.maxRequests = value;
+            continue;
+        }
+        // Timeouts of 0, or of days, are mistakes
+        if (value == 0 || value > 3600)
+        {
+            return false;
+        }
+        std::chrono::milliseconds timeout = std::chrono::seconds(value);
+        if (name == "header")
+        {
+            parsed.headerReadTimeout = timeout;
+        }
+        else if (name == "body")
+        {
+            parsed.bodyReadTimeout = timeout;
+        }
+        else if (name == "idle")
+        {
+            parsed.idleTimeout = timeout;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    policy = parsed;
+    return true;
+}
+
+// Why an HTTP/1 connection was closed
+enum class CloseReason
+{
+    // The client closed it, or reading or writing failed
+    client,
+    // The request asked for it, or was HTTP/1.0 without keep-alive, or the
+    // buffer budget was exhausted
+    noKeepAlive,
+    // It served KeepAlivePolicy::maxRequests
+    maxRequests,
+    // No next request came within KeepAlivePolicy::idleTimeout
+    idleTimeout,
+    // A request wasn't read within its header or body deadline
+    readTimeout,
+    // It became a websocket
+    upgrade,
+    count
+};
+
+inline const char* closeReasonName(CloseReason reason)
+{
+    switch (reason)
+    {
+        case CloseReason::client:
+            return "client";
+        case CloseReason::noKeepAlive:
+            return "no_keep_alive";
+        case CloseReason::maxRequests:
+            return "max_requests";
+        case CloseReason::idleTimeout:
+            return "idle_timeout";
+        case CloseReason::readTimeout:
+            return "read_timeout";
+        case CloseReason::upgrade:
+            return "upgrade";
+        default:
+            return "unknown";
+    }
+}
+
+/**
+ * @brief The KeepAlivePolicy connections follow, and how much they were
+ *        reused under it
+ *
+ * Each HTTP/1 connection adds its requests as new (the first it served) or
+ * reused, and once closed, how many requests and bytes it served and why it
+ * closed.  A client that reconnects more than it needs to shows up as many
+ * connections closed by the client, or by a timeout, after one or two
+ * requests; each reconnect over TLS costs a handshake.  Connections are
+ * served on several threads, so the counts are atomic and the policy is
+ * under a lock; connections copy it when they start.
+ */
+class ConnectionReuse
+{
+  public:
+    // Upper bounds of the buckets of requests per connection
+    static constexpr size_t bucketCount = 8;
+    static constexpr std::array<uint64_t, bucketCount> bucketBounds()
+    {
+        return {{1, 2, 4, 8, 16, 32, 64, 128}};
+    }
+
+    void setPolicy(const KeepAlivePolicy& newPolicy)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentPolicy = newPolicy;
+    }
+
+    KeepAlivePolicy policy()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return currentPolicy;
+    }
+
+    // A request was read; reused if the connection served one before
+    void requestStarted(bool reused)
+    {
+        (reused ? reusedRequests : newRequests)++;
+    }
+
+    void connectionClosed(uint64_t requests, uint64_t bytes,
+                          CloseReason reason)
+    {
+        size_t bucket = 0;
+        while (bucket < bucketCount && requests > bucketBounds()[bucket])
+        {
+            bucket++;
+        }
+        requestBuckets[bucket]++;
+        requestSum += requests;
+        byteSum += bytes;
+        closed++;
+        closeReasons[static_cast<size_t>(reason)]++;
+    }
+
+    uint64_t requests(bool reused) const
+    {
+        return reused ? reusedRequests.load() : newRequests.load();
+    }
+
+    uint64_t closedConnections(CloseReason reason) const
+    {
+        return closeReasons[static_cast<size_t>(reason)].load();
+    }
+
+    // In Prometheus text format
+    void appendMetrics(std::string& out) const
+    {
+        out += "# HELP bmcweb_http_requests_total HTTP/1 requests, by "
+               "whether their connection had served one before\n"
+               "# TYPE bmcweb_http_requests_total counter\n"
+               "bmcweb_http_requests_total{connection=\"new\"} ";
+        out += std::to_string(newRequests.load());
+        out += "\nbmcweb_http_requests_total{connection=\"reused\"} ";
+        out += std::to_string(reusedRequests.load());
+        out += "\n# HELP bmcweb_connection_requests Requests each HTTP/1 "
+               "connection served before it closed\n"
+               "# TYPE bmcweb_connection_requests histogram\n";
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i < bucketCount; i++)
+        {
+            cumulative += requestBuckets[i].load();
+            out += "bmcweb_connection_requests_bucket{le=\"";
+            out += std::to_string(bucketBounds()[i]);
+            out += "\"} ";
+            out += std::to_string(cumulative);
+            out += '\n';
+        }
+        cumulative += requestBuckets[bucketCount].load();
+        out += "bmcweb_connection_requests_bucket{le=\"+Inf\"} ";
+        out += std::to_string(cumulative);
+        out += "\nbmcweb_connection_requests_sum ";
+        out += std::to_string(requestSum.load());
+        out += "\nbmcweb_connection_requests_count ";
+        out += std::to_string(closed.load());
+        out += "\n# HELP bmcweb_connection_bytes Bytes each HTTP/1 "
+               "connection read and wrote before it closed\n"
+               "# TYPE bmcweb_connection_bytes summary\n"
+               "bmcweb_connection_bytes_sum ";
+        out += std::to_string(byteSum.load());
+        out += "\nbmcweb_connection_bytes_count ";
+        out += std::to_string(closed.load());
+        out += "\n# HELP bmcweb_connections_closed_total HTTP/1 connections "
+               "closed, by why\n"
+               "# TYPE bmcweb_connections_closed_total counter\n";
+        for (size_t i = 0; i < static_cast<size_t>(CloseReason::count); i++)
+        {
+            out += "bmcweb_connections_closed_total{reason=\"";
+            out += closeReasonName(static_cast<CloseReason>(i));
+            out += "\"} ";
+            out += std::to_string(closeReasons[i].load());
+            out += '\n';
+        }
+    }
+
+  private:
+    std::mutex mutex;
+    KeepAlivePolicy currentPolicy;
+
+    std::atomic<uint64_t> newRequests{0};
+    std::atomic<uint64_t> reusedRequests{0};
+    // One past the last bound for the rest
+    std::array<std::atomic<uint64_t>, bucketCount + 1> requestBuckets{};
+    std::atomic<uint64_t> requestSum{0};
+    std::atomic<uint64_t> byteSum{0};
+    std::atomic<uint64_t> closed{0};
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(CloseReason::count)>
+        closeReasons{};
+};
+
+inline ConnectionReuse& connectionReuse()
+{
+    static ConnectionReuse reuse;
+    return reuse;
+}
+
+} // namespace crow
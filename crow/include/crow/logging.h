@@ -1,11 +1,24 @@
 #pragma once
 
+#include <strings.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
 #include <iostream>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
 namespace crow
 {
@@ -26,6 +39,34 @@ enum class LogLevel
     Critical,
 };
 
+// Records below this level are compiled out.  Without logging they all are.
+#ifndef BMCWEB_LOG_MIN_LEVEL
+#define BMCWEB_LOG_MIN_LEVEL 0
+#endif
+#ifdef BMCWEB_ENABLE_LOGGING
+constexpr LogLevel minLogLevel = static_cast<LogLevel>(BMCWEB_LOG_MIN_LEVEL);
+#else
+constexpr LogLevel minLogLevel =
+    static_cast<LogLevel>(static_cast<int>(LogLevel::Critical) + 1);
+#endif
+
+// Reads a level name as BMCWEB_LOG_LEVEL gives it: debug, info, warning,
+// error or critical
+inline bool parseLogLevel(const char* name, LogLevel& level)
+{
+    static constexpr std::array<const char*, 5> names{
+        {"debug", "info", "warning", "error", "critical"}};
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        if (name != nullptr && strcasecmp(name, names[i]) == 0)
+        {
+            level = static_cast<LogLevel>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
 class ILogHandler
 {
   public:
@@ -41,6 +82,270 @@ class CerrLogHandler : public ILogHandler
     }
 };
 
+// A bounded queue of log records that any thread can push to without
+// taking a lock, drained by one consumer.  Each slot's sequence number says
+// whether it is free for the producer at that position, or filled for the
+// consumer.
+class LogRing
+{
+  public:
+    static constexpr size_t capacity = 1024;
+
+    LogRing()
+    {
+        for (size_t i = 0; i < capacity; i++)
+        {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Returns false, dropping the record, if the ring is full
+    bool push(std::string&& message, LogLevel level)
+    {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;)
+        {
+            slot = &slots[pos % capacity];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff =
+                static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (enqueuePos.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        slot->message = std::move(message);
+        slot->level = level;
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Only called from the consumer
+    bool pop(std::string& message, LogLevel& level)
+    {
+        Slot& slot = slots[dequeuePos % capacity];
+        size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence != dequeuePos + 1)
+        {
+            return false;
+        }
+        message = std::move(slot.message);
+        level = slot.level;
+        slot.sequence.store(dequeuePos + capacity, std::memory_order_release);
+        dequeuePos++;
+        return true;
+    }
+
+    // Only called from the consumer
+    bool empty() const
+    {
+        return slots[dequeuePos % capacity].sequence.load(
+                   std::memory_order_acquire) != dequeuePos + 1;
+    }
+
+  private:
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        LogLevel level;
+        std::string message;
+    };
+
+    std::array<Slot, capacity> slots;
+    std::atomic<size_t> enqueuePos{0};
+    size_t dequeuePos = 0;
+};
+
+// Takes formatting and the write to stderr off the request path: records
+// go into a LogRing, and a thread writes them out in batches with one
+// writev.  Under systemd, stderr is a journal stream, so each record is
+// prefixed with its syslog priority for journald.  With nothing to write
+// the thread sleeps until a record comes in.
+class AsyncLogHandler : public ILogHandler
+{
+  public:
+    static constexpr size_t maxBatch = 64;
+
+    void start()
+    {
+        journal = getenv("JOURNAL_STREAM") != nullptr;
+        running = true;
+        writer = std::thread([this] { run(); });
+    }
+
+    // Writes out what is left; has to happen before exit
+    void stop()
+    {
+        if (!writer.joinable())
+        {
+            return;
+        }
+        running = false;
+        wake();
+        writer.join();
+    }
+
+    void log(std::string message, LogLevel level) override
+    {
+        if (!running)
+        {
+            std::cerr << message;
+            return;
+        }
+        if (!ring.push(std::move(message), level))
+        {
+            dropped++;
+        }
+        // Pairs with the fence in waitForRecords(): either the writer sees
+        // the record, or this sees it waiting
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting.load(std::memory_order_relaxed))
+        {
+            wake();
+        }
+    }
+
+  private:
+    static const char* priority(LogLevel level)
+    {
+        switch (level)
+        {
+            case LogLevel::Debug:
+                return "<7>";
+            case LogLevel::Info:
+                return "<6>";
+            case LogLevel::Warning:
+                return "<4>";
+            case LogLevel::Error:
+                return "<3>";
+            default:
+                return "<2>";
+        }
+    }
+
+    void run()
+    {
+        std::vector<std::string> messages(maxBatch);
+        std::vector<iovec> iov;
+        iov.reserve(maxBatch * 2 + 1);
+        std::string droppedNote;
+        for (;;)
+        {
+            // Read running first, so nothing pushed before stop() is missed
+            bool stopping = !running;
+            iov.clear();
+            size_t count = 0;
+            LogLevel level;
+            while (count < maxBatch && ring.pop(messages[count], level))
+            {
+                if (journal)
+                {
+                    const char* prefix = priority(level);
+                    iov.push_back(iovec{const_cast<char*>(prefix), 3});
+                }
+                iov.push_back(iovec{&messages[count][0],
+                                    messages[count].size()});
+                count++;
+            }
+            uint64_t lost = dropped.exchange(0);
+            if (lost > 0)
+            {
+                droppedNote = std::string(journal ? "<4>" : "") +
+                              std::to_string(lost) +
+                              " log records dropped\n";
+                iov.push_back(iovec{&droppedNote[0], droppedNote.size()});
+            }
+            if (!iov.empty())
+            {
+                writeAll(iov);
+                continue;
+            }
+            if (stopping)
+            {
+                return;
+            }
+            waitForRecords();
+        }
+    }
+
+    void waitForRecords()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        waiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        wakeup.wait(lock, [this] {
+            return !ring.empty() || !running || dropped.load() > 0;
+        });
+        waiting.store(false, std::memory_order_relaxed);
+    }
+
+    void wake()
+    {
+        // Taking the lock makes sure the writer is either before its check
+        // or already waiting, so the notification isn't lost
+        std::lock_guard<std::mutex> lock(mutex);
+        wakeup.notify_one();
+    }
+
+    static void writeAll(std::vector<iovec>& iov)
+    {
+        iovec* next = iov.data();
+        int left = static_cast<int>(iov.size());
+        while (left > 0)
+        {
+            ssize_t written = writev(STDERR_FILENO, next, left);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return;
+            }
+            size_t bytes = static_cast<size_t>(written);
+            while (left > 0 && bytes >= next->iov_len)
+            {
+                bytes -= next->iov_len;
+                next++;
+                left--;
+            }
+            if (left > 0)
+            {
+                next->iov_base = static_cast<char*>(next->iov_base) + bytes;
+                next->iov_len -= bytes;
+            }
+        }
+    }
+
+    LogRing ring;
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> waiting{false};
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    bool journal = false;
+    std::thread writer;
+};
+
+inline AsyncLogHandler& asyncLogHandler()
+{
+    static AsyncLogHandler handler;
+    return handler;
+}
+
 class logger
 {
   private:
@@ -93,9 +398,10 @@ class logger
     }
 
     //
+    // Can be changed while running, from any thread
     static void setLogLevel(LogLevel level)
     {
-        getLogLevelRef() = level;
+        getLogLevelRef().store(level, std::memory_order_relaxed);
     }
 
     static void setHandler(ILogHandler* handler)
@@ -105,14 +411,14 @@ class logger
 
     static LogLevel get_current_log_level()
     {
-        return getLogLevelRef();
+        return getLogLevelRef().load(std::memory_order_relaxed);
     }
 
   private:
     //
-    static LogLevel& getLogLevelRef()
+    static std::atomic<LogLevel>& getLogLevelRef()
     {
-        static auto currentLevel = static_cast<LogLevel>(1);
+        static std::atomic<LogLevel> currentLevel{static_cast<LogLevel>(1)};
         return currentLevel;
     }
     static ILogHandler*& getHandlerRef()
@@ -128,18 +434,18 @@ class logger
 };
 } // namespace crow
 
-#define BMCWEB_LOG_CRITICAL                                                    \
-    if (crow::logger::get_current_log_level() <= crow::LogLevel::Critical)     \
-    crow::logger("CRITICAL", crow::LogLevel::Critical)
-#define BMCWEB_LOG_ERROR                                                       \
-    if (crow::logger::get_current_log_level() <= crow::LogLevel::Error)        \
-    crow::logger("ERROR   ", crow::LogLevel::Error)
-#define BMCWEB_LOG_WARNING                                                     \
-    if (crow::logger::get_current_log_level() <= crow::LogLevel::Warning)      \
-    crow::logger("WARNING ", crow::LogLevel::Warning)
-#define BMCWEB_LOG_INFO                                                        \
-    if (crow::logger::get_current_log_level() <= crow::LogLevel::Info)         \
-    crow::logger("INFO    ", crow::LogLevel::Info)
-#define BMCWEB_LOG_DEBUG                                                       \
-    if (crow::logger::get_current_log_level() <= crow::LogLevel::Debug)        \
-    crow::logger("DEBUG   ", crow::LogLevel::Debug)
+// The first test is a constant, so records below minLogLevel and their
+// arguments are compiled out
+#define BMCWEB_LOG_AT(lvl, prefix)                                             \
+    if (crow::LogLevel::lvl < crow::minLogLevel ||                             \
+        crow::logger::get_current_log_level() > crow::LogLevel::lvl)           \
+    {                                                                          \
+    }                                                                          \
+    else                                                                       \
+        crow::logger(prefix, crow::LogLevel::lvl)
+
+#define BMCWEB_LOG_CRITICAL BMCWEB_LOG_AT(Critical, "CRITICAL")
+#define BMCWEB_LOG_ERROR BMCWEB_LOG_AT(Error, "ERROR   ")
+#define BMCWEB_LOG_WARNING BMCWEB_LOG_AT(Warning, "WARNING ")
+#define BMCWEB_LOG_INFO BMCWEB_LOG_AT(Info, "INFO    ")
+#define BMCWEB_LOG_DEBUG BMCWEB_LOG_AT(Debug, "DEBUG   ")
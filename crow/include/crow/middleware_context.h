@@ -32,10 +32,29 @@ template <> struct PartialContext<>
     template <int> using partial = PartialContext;
 };
 
+// What running the middlewares' beforeHandle left to do
+enum class MiddlewareResult
+{
+    // Every middleware let the request through to the route handler
+    next,
+    // A middleware answered the request, and the after handlers have run
+    completed,
+    // A middleware is deciding asynchronously; the chain calls its done
+    // callback once the rest of it has run
+    deferred
+};
+
+template <int N, typename Context, typename Container, typename CurrentMW,
+          typename... Middlewares>
+MiddlewareResult middlewareCallHelper(Container& middlewares, Request& req,
+                                      Response& res, Context& ctx,
+                                      const std::function<void()>& done);
+
 template <int N, typename Context, typename Container, typename CurrentMW,
           typename... Middlewares>
-bool middlewareCallHelper(Container& middlewares, Request& req, Response& res,
-                          Context& ctx);
+MiddlewareResult middlewareCallRest(Container& middlewares, Request& req,
+                                    Response& res, Context& ctx,
+                                    const std::function<void()>& done);
 
 template <typename... Middlewares>
 struct Context : private PartialContext<Middlewares...>
@@ -52,8 +71,15 @@ struct Context : private PartialContext<Middlewares...>
 
     template <int N, typename Context, typename Container, typename CurrentMW,
               typename... Middlewares2>
-    friend bool middlewareCallHelper(Container& middlewares, Request& req,
-                                     Response& res, Context& ctx);
+    friend MiddlewareResult
+        middlewareCallHelper(Container& middlewares, Request& req,
+                             Response& res, Context& ctx,
+                             const std::function<void()>& done);
+    template <int N, typename Context, typename Container, typename CurrentMW,
+              typename... Middlewares2>
+    friend MiddlewareResult
+        middlewareCallRest(Container& middlewares, Request& req, Response& res,
+                           Context& ctx, const std::function<void()>& done);
 
     template <typename T> typename T::Context& get()
     {
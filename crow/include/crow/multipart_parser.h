@@ -0,0 +1,338 @@
+#pragma once
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/utility/string_view.hpp>
+#include <cstddef>
+#include <functional>
+#include <string>
+
+namespace crow
+{
+namespace multipart
+{
+
+// Most the headers of one part may take
+constexpr size_t maxPartHeaderBytes = 1024 * 8;
+
+// What the headers of a part say about it
+struct Part
+{
+    std::string name;
+    // Empty unless the part is a file
+    std::string filename;
+    std::string contentType;
+};
+
+/**
+ * @brief The boundary of a multipart/form-data Content-Type, or an empty
+ *        string if it isn't one or has no valid boundary
+ */
+inline std::string boundaryOf(boost::string_view contentType)
+{
+    size_t semicolon = contentType.find(';');
+    boost::string_view mediaType = contentType.substr(0, semicolon);
+    while (!mediaType.empty() && mediaType.back() == ' ')
+    {
+        mediaType.remove_suffix(1);
+    }
+    if (semicolon == boost::string_view::npos ||
+        !boost::iequals(mediaType, "multipart/form-data"))
+    {
+        return "";
+    }
+    boost::string_view params = contentType.substr(semicolon);
+    while (!params.empty())
+    {
+        params.remove_prefix(1);
+        size_t end = params.find(';');
+        std::string param(params.substr(0, end));
+        params = end == boost::string_view::npos ? boost::string_view()
+                                                  : params.substr(end);
+        boost::trim(param);
+        if (!boost::istarts_with(param, "boundary="))
+        {
+            continue;
+        }
+        std::string boundary = param.substr(9);
+        if (boundary.size() >= 2 && boundary.front() == '"' &&
+            boundary.back() == '"')
+        {
+            boundary = boundary.substr(1, boundary.size() - 2);
+        }
+        // RFC 2046 allows 1 to 70 characters
+        if (boundary.empty() || boundary.size() > 70)
+        {
+            return "";
+        }
+        return boundary;
+    }
+    return "";
+}
+
+/**
+ * @brief Splits a multipart/form-data body into its parts as it arrives
+ *
+ * The body can be fed in pieces of any size, split anywhere; a delimiter
+ * that straddles two pieces is held back until the next one shows whether
+ * it is one.  Part data is handed on as it is found, so only a delimiter's
+ * worth of it is ever held.
+ */
+class Parser
+{
+  public:
+    using PartBeginHandler = std::function<bool(const Part&)>;
+    using PartDataHandler = std::function<bool(const char*, size_t)>;
+    using PartEndHandler = std::function<bool()>;
+
+    explicit Parser(const std::string& boundary) :
+        // The body starts with the delimiter without its line break; taking
+        // the body as if it had one finds both the same way
+        delimiter("\r\n--" + boundary), held("\r\n")
+    {
+    }
+
+    // Called with the headers of each part, its data, and at its end.  A
+    // handler returning false stops the parse as failed.
+    PartBeginHandler onPartBegin = [](const Part&) { return true; };
+    PartDataHandler onPartData = [](const char*, size_t) { return true; };
+    PartEndHandler onPartEnd = [] { return true; };
+
+    /**
+     * @brief Parses the next piece of the body
+     *
+     * @return false if the body isn't valid multipart, or a handler stopped
+     *         the parse; the parser takes nothing more after that
+     */
+    bool feed(const char* data, size_t size)
+    {
+        if (state == State::failed)
+        {
+            return false;
+        }
+        if (state == State::done)
+        {
+            // The epilogue, which means nothing
+            return true;
+        }
+        held.append(data, size);
+        if (!parse())
+        {
+            state = State::failed;
+            held.clear();
+            return false;
+        }
+        return true;
+    }
+
+    // Whether the closing delimiter was seen
+    bool done() const
+    {
+        return state == State::done;
+    }
+
+  private:
+    enum class State
+    {
+        preamble,
+        delimiter,
+        headers,
+        data,
+        done,
+        failed
+    };
+
+    bool parse()
+    {
+        while (true)
+        {
+            switch (state)
+            {
+                case State::preamble:
+                {
+                    size_t found = held.find(delimiter);
+                    if (found == std::string::npos)
+                    {
+                        keepTail();
+                        return true;
+                    }
+                    held.erase(0, found + delimiter.size());
+                    state = State::delimiter;
+                    break;
+                }
+                case State::delimiter:
+                {
+                    if (held.size() < 2)
+                    {
+                        return true;
+                    }
+                    if (held.compare(0, 2, "--") == 0)
+                    {
+                        state = State::done;
+                        held.clear();
+                        return true;
+                    }
+                    if (held.compare(0, 2, "\r\n") != 0)
+                    {
+                        return false;
+                    }
+                    held.erase(0, 2);
+                    state = State::headers;
+                    break;
+                }
+                case State::headers:
+                {
+                    size_t end = held.find("\r\n\r\n");
+                    if (end == std::string::npos)
+                    {
+                        return held.size() <= maxPartHeaderBytes;
+                    }
+                    Part part;
+                    if (end > maxPartHeaderBytes ||
+                        !parseHeaders(boost::string_view(held.data(), end),
+                                      part) ||
+                        !onPartBegin(part))
+                    {
+                        return false;
+                    }
+                    held.erase(0, end + 4);
+                    state = State::data;
+                    break;
+                }
+                case State::data:
+                {
+                    size_t found = held.find(delimiter);
+                    if (found == std::string::npos)
+                    {
+                        // All but what could be the start of a delimiter
+                        if (held.size() >= delimiter.size())
+                        {
+                            size_t ready = held.size() - delimiter.size() + 1;
+                            if (!onPartData(held.data(), ready))
+                            {
+                                return false;
+                            }
+                            held.erase(0, ready);
+                        }
+                        return true;
+                    }
+                    if ((found != 0 && !onPartData(held.data(), found)) ||
+                        !onPartEnd())
+                    {
+                        return false;
+                    }
+                    held.erase(0, found + delimiter.size());
+                    state = State::delimiter;
+                    break;
+                }
+                case State::done:
+                case State::failed:
+                    return true;
+            }
+        }
+    }
+
+    // Drops what can't be part of a delimiter
+    void keepTail()
+    {
+        if (held.size() >= delimiter.size())
+        {
+            held.erase(0, held.size() - delimiter.size() + 1);
+        }
+    }
+
+    static bool parseHeaders(boost::string_view headers, Part& part)
+    {
+        bool disposition = false;
+        while (!headers.empty())
+        {
+            size_t end = headers.find("\r\n");
+            boost::string_view line = headers.substr(0, end);
+            headers = end == boost::string_view::npos
+                          ? boost::string_view()
+                          : headers.substr(end + 2);
+            size_t colon = line.find(':');
+            if (colon == boost::string_view::npos)
+            {
+                return false;
+            }
+            boost::string_view name = line.substr(0, colon);
+            std::string value(line.substr(colon + 1));
+            boost::trim(value);
+            if (boost::iequals(name, "Content-Disposition"))
+            {
+                if (!parseDisposition(value, part))
+                {
+                    return false;
+                }
+                disposition = true;
+            }
+            else if (boost::iequals(name, "Content-Type"))
+            {
+                part.contentType = std::move(value);
+            }
+        }
+        // Every part of a form has to say what field it is
+        return disposition;
+    }
+
+    // form-data; name="field"; filename="file"
+    static bool parseDisposition(boost::string_view value, Part& part)
+    {
+        size_t semicolon = value.find(';');
+        if (!boost::iequals(boost::trim_copy(std::string(
+                                value.substr(0, semicolon))),
+                            "form-data"))
+        {
+            return false;
+        }
+        while (semicolon != boost::string_view::npos)
+        {
+            value = value.substr(semicolon + 1);
+            while (!value.empty() && value.front() == ' ')
+            {
+                value.remove_prefix(1);
+            }
+            size_t equals = value.find('=');
+            if (equals == boost::string_view::npos)
+            {
+                return false;
+            }
+            boost::string_view key = value.substr(0, equals);
+            value = value.substr(equals + 1);
+            std::string param;
+            if (!value.empty() && value.front() == '"')
+            {
+                size_t close = value.find('"', 1);
+                if (close == boost::string_view::npos)
+                {
+                    return false;
+                }
+                param = std::string(value.substr(1, close - 1));
+                value = value.substr(close + 1);
+            }
+            else
+            {
+                param = std::string(value.substr(0, value.find(';')));
+                boost::trim(param);
+            }
+            semicolon = value.find(';');
+            if (boost::iequals(key, "name"))
+            {
+                part.name = std::move(param);
+            }
+            else if (boost::iequals(key, "filename"))
+            {
+                part.filename = std::move(param);
+            }
+        }
+        return !part.name.empty();
+    }
+
+    const std::string delimiter;
+    // What was fed but not parsed yet
+    std::string held;
+    State state{State::preamble};
+};
+
+} // namespace multipart
+} // namespace crow
@@ -0,0 +1,191 @@
+#pragma once
+#include <array>
+#include <boost/asio/io_service.hpp>
+#include <boost/utility/string_view.hpp>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <utility>
+
+namespace crow
+{
+
+// What handler work is for, most urgent first
+enum class Priority
+{
+    // Websocket traffic: KVM, the host console
+    interactive,
+    // Ordinary requests: logins, property reads and writes
+    control,
+    // Uploads, whole collections, and the slices of streamed bodies
+    bulk
+};
+
+constexpr size_t priorityCount()
+{
+    return 3;
+}
+
+// Times a waiting lower priority task may be passed over before it runs
+// anyway, so bulk work still progresses under steady interactive traffic
+constexpr unsigned schedulerMaxPassedOver = 16;
+
+/**
+ * @brief Runs handler work on an io_service, most urgent first
+ *
+ * Work is queued by Priority and run one task per io_service turn, so
+ * socket and D-Bus completions interleave with it, and a task queued behind
+ * a long line of bulk work still runs next.  Within a priority tasks run in
+ * the order they were posted.  Posting is thread safe, for the worker
+ * threads of the io pool.
+ *
+ * It is an io_service service; get it with
+ * boost::asio::use_service<PriorityScheduler>(io).  The Tag only lets the
+ * service id be defined in this header.
+ */
+template <typename Tag = void>
+class BasicPriorityScheduler : public boost::asio::io_service::service
+{
+  public:
+    static boost::asio::io_service::id id;
+
+    explicit BasicPriorityScheduler(boost::asio::io_service& io) :
+        boost::asio::io_service::service(io), io(io)
+    {
+    }
+
+    template <typename F> void post(Priority priority, F&& f)
+    {
+        bool start = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queues[static_cast<size_t>(priority)].emplace_back(
+                std::forward<F>(f));
+            start = !scheduled;
+            scheduled = true;
+        }
+        if (start)
+        {
+            io.post([this] { runOne(); });
+        }
+    }
+
+    size_t size()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t total = 0;
+        for (const std::deque<std::function<void()>>& queue : queues)
+        {
+            total += queue.size();
+        }
+        return total;
+    }
+
+  private:
+    void shutdown() override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (std::deque<std::function<void()>>& queue : queues)
+        {
+            queue.clear();
+        }
+    }
+
+    void runOne()
+    {
+        std::function<void()> task;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            size_t first = priorityCount();
+            for (size_t i = 0; i < priorityCount(); i++)
+            {
+                if (!queues[i].empty())
+                {
+                    first = i;
+                    break;
+                }
+            }
+            if (first == priorityCount())
+            {
+                scheduled = false;
+                return;
+            }
+            // Each waiting lower priority is passed over once more, and the
+            // most urgent of those passed over too often runs instead
+            size_t pick = first;
+            for (size_t i = first + 1; i < priorityCount(); i++)
+            {
+                if (queues[i].empty())
+                {
+                    passedOver[i] = 0;
+                }
+                else if (++passedOver[i] > schedulerMaxPassedOver &&
+                         pick == first)
+                {
+                    pick = i;
+                }
+            }
+            passedOver[pick] = 0;
+            task = std::move(queues[pick].front());
+            queues[pick].pop_front();
+        }
+        // Queued first, so that whatever the task posts runs after the
+        // rest of the queue gets its turn
+        io.post([this] { runOne(); });
+        task();
+    }
+
+    boost::asio::io_service& io;
+    std::mutex mutex;
+    std::array<std::deque<std::function<void()>>, priorityCount()> queues;
+    // A runOne() is posted
+    bool scheduled{false};
+    // By priority, tasks run while the oldest task of that priority waited
+    std::array<unsigned, priorityCount()> passedOver{};
+};
+
+template <typename Tag>
+boost::asio::io_service::id BasicPriorityScheduler<Tag>::id;
+
+using PriorityScheduler = BasicPriorityScheduler<>;
+
+template <typename F>
+void postWithPriority(boost::asio::io_service& io, Priority priority, F&& f)
+{
+    boost::asio::use_service<PriorityScheduler>(io).post(priority,
+                                                         std::forward<F>(f));
+}
+
+// Requests with a body past this size are uploads
+constexpr uint64_t bulkRequestBodyBytes = 64 * 1024;
+
+// Control, unless the request uploads something, or asks for a collection
+// with its members expanded, for a D-Bus enumerate, or for log entries
+inline Priority requestPriority(boost::string_view target, uint64_t bodyBytes)
+{
+    if (bodyBytes > bulkRequestBodyBytes)
+    {
+        return Priority::bulk;
+    }
+    boost::string_view path = target.substr(0, target.find('?'));
+    if (path.size() != target.size() &&
+        target.substr(path.size()).find("$expand") != boost::string_view::npos)
+    {
+        return Priority::bulk;
+    }
+    while (!path.empty() && path.back() == '/')
+    {
+        path.remove_suffix(1);
+    }
+    for (boost::string_view suffix : {"/enumerate", "/Entries"})
+    {
+        if (path.ends_with(suffix))
+        {
+            return Priority::bulk;
+        }
+    }
+    return Priority::control;
+}
+
+} // namespace crow
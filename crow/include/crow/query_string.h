@@ -1,413 +1,307 @@
 #pragma once
 
-#include <cstdio>
-#include <cstring>
+#include <boost/optional.hpp>
+#include <boost/utility/string_view.hpp>
 #include <iostream>
+#include <iterator>
 #include <string>
 #include <vector>
 
 namespace crow
 {
-// ----------------------------------------------------------------------------
-// qs_parse (modified)
-// https://github.com/bartgrantham/qs_parse
-// ----------------------------------------------------------------------------
-/*  Similar to strncmp, but handles URL-encoding for either string  */
-int qsStrncmp(const char* s, const char* qs, size_t n);
 
-/*  Finds the beginning of each key/value pair and stores a pointer in qs_kv.
- *  Also decodes the value portion of the k/v pair *in-place*.  In a future
- *  enhancement it will also have a compile-time option of sorting qs_kv
- *  alphabetically by key.  */
-int qsParse(char* qs, char* qs_kv[], int qs_kv_size);
-
-/*  Used by qs_parse to decode the value portion of a k/v pair  */
-int qsDecode(char* qs);
-
-/*  Looks up the value according to the key on a pre-processed query string
- *  A future enhancement will be a compile-time option to look up the key
- *  in a pre-sorted qs_kv array via a binary search.  */
-// char * qs_k2v(const char * key, char * qs_kv[], int qs_kv_size);
-char* qsK2v(const char* key, char* const* qs_kv, int qs_kv_size, int nth);
-
-/*  Non-destructive lookup of value, based on key.  User provides the
- *  destinaton string and length.  */
-char* qsScanvalue(const char* key, const char* qs, char* val, size_t val_len);
-
-// TODO: implement sorting of the qs_kv array; for now ensure it's not compiled
-#undef _qsSORTING
-
-// isxdigit _is_ available in <ctype.h>, but let's avoid another header instead
-#define BMCWEB_QS_ISHEX(x)                                                     \
-    ((((x) >= '0' && (x) <= '9') || ((x) >= 'A' && (x) <= 'F') ||              \
-      ((x) >= 'a' && (x) <= 'f'))                                              \
-         ? 1                                                                   \
-         : 0)
-#define BMCWEB_QS_HEX2DEC(x)                                                   \
-    (((x) >= '0' && (x) <= '9')                                                \
-         ? (x)-48                                                              \
-         : ((x) >= 'A' && (x) <= 'F')                                          \
-               ? (x)-55                                                        \
-               : ((x) >= 'a' && (x) <= 'f') ? (x)-87 : 0)
-#define BMCWEB_QS_ISQSCHR(x)                                                   \
-    ((((x) == '=') || ((x) == '#') || ((x) == '&') || ((x) == '\0')) ? 0 : 1)
-
-inline int qsStrncmp(const char* s, const char* qs, size_t n)
+/**
+ * @brief One key=value pair of a query string, as it appears in the url
+ *
+ * Both halves are still percent-encoded; QueryString::decode() decodes them.
+ * A pair without '=' has an empty value.
+ */
+struct QueryParameter
 {
-    int i = 0;
-    unsigned char u1, u2, unyb, lnyb;
+    boost::string_view key;
+    boost::string_view value;
+};
 
-    while (n-- > 0)
+/**
+ * @brief The query of a request target, split into its parameters when they
+ *        are looked at
+ *
+ * Only the part between '?' and '#' is kept, so targets without a query
+ * cost nothing.  Nothing is parsed or decoded until a parameter is asked
+ * for.  Keys end at the first '=', and values run to the next '&', so a
+ * value such as a $filter expression may contain '=' itself.
+ */
+class QueryString
+{
+  public:
+    class const_iterator
     {
-        u1 = static_cast<unsigned char>(*s++);
-        u2 = static_cast<unsigned char>(*qs++);
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = QueryParameter;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const QueryParameter*;
+        using reference = const QueryParameter&;
 
-        if (!BMCWEB_QS_ISQSCHR(u1))
-        {
-            u1 = '\0';
-        }
-        if (!BMCWEB_QS_ISQSCHR(u2))
-        {
-            u2 = '\0';
-        }
+        const_iterator() = default;
 
-        if (u1 == '+')
+        reference operator*() const
         {
-            u1 = ' ';
-        }
-        if (u1 == '%') // easier/safer than scanf
-        {
-            unyb = static_cast<unsigned char>(*s++);
-            lnyb = static_cast<unsigned char>(*s++);
-            if (BMCWEB_QS_ISHEX(unyb) && BMCWEB_QS_ISHEX(lnyb))
-            {
-                u1 = (BMCWEB_QS_HEX2DEC(unyb) * 16) + BMCWEB_QS_HEX2DEC(lnyb);
-            }
-            else
-            {
-                u1 = '\0';
-            }
+            return parameter;
         }
 
-        if (u2 == '+')
+        pointer operator->() const
         {
-            u2 = ' ';
-        }
-        if (u2 == '%') // easier/safer than scanf
-        {
-            unyb = static_cast<unsigned char>(*qs++);
-            lnyb = static_cast<unsigned char>(*qs++);
-            if (BMCWEB_QS_ISHEX(unyb) && BMCWEB_QS_ISHEX(lnyb))
-            {
-                u2 = (BMCWEB_QS_HEX2DEC(unyb) * 16) + BMCWEB_QS_HEX2DEC(lnyb);
-            }
-            else
-            {
-                u2 = '\0';
-            }
+            return &parameter;
         }
 
-        if (u1 != u2)
+        const_iterator& operator++()
         {
-            return u1 - u2;
+            next();
+            return *this;
         }
-        if (u1 == '\0')
+
+        const_iterator operator++(int)
         {
-            return 0;
+            const_iterator old = *this;
+            next();
+            return old;
         }
-        i++;
-    }
-    if (BMCWEB_QS_ISQSCHR(*qs))
-    {
-        return -1;
-    }
-    else
-    {
-        return 0;
-    }
-}
-
-inline int qsParse(char* qs, char* qs_kv[], int qs_kv_size)
-{
-    int i, j;
-    char* substrPtr;
-
-    for (i = 0; i < qs_kv_size; i++)
-    {
-        qs_kv[i] = NULL;
-    }
-
-    // find the beginning of the k/v substrings or the fragment
-    substrPtr = qs + strcspn(qs, "?#");
-    if (substrPtr[0] != '\0')
-    {
-        substrPtr++;
-    }
-    else
-    {
-        return 0; // no query or fragment
-    }
 
-    i = 0;
-    while (i < qs_kv_size)
-    {
-        qs_kv[i] = substrPtr;
-        j = strcspn(substrPtr, "&");
-        if (substrPtr[j] == '\0')
+        bool operator==(const const_iterator& other) const
         {
-            break;
+            return atEnd == other.atEnd &&
+                   (atEnd ||
+                    parameter.key.data() == other.parameter.key.data());
         }
-        substrPtr += j + 1;
-        i++;
-    }
-    i++; // x &'s -> means x iterations of this loop -> means *x+1* k/v pairs
 
-    // we only decode the values in place, the keys could have '='s in them
-    // which will hose our ability to distinguish keys from values later
-    for (j = 0; j < i; j++)
-    {
-        substrPtr = qs_kv[j] + strcspn(qs_kv[j], "=&#");
-        if (substrPtr[0] == '&' || substrPtr[0] == '\0')
-        { // blank value: skip decoding
-            substrPtr[0] = '\0';
-        }
-        else
+        bool operator!=(const const_iterator& other) const
         {
-            qsDecode(++substrPtr);
+            return !(*this == other);
         }
-    }
-
-#ifdef _qsSORTING
-// TODO: qsort qs_kv, using qs_strncmp() for the comparison
-#endif
 
-    return i;
-}
-
-inline int qsDecode(char* qs)
-{
-    int i = 0, j = 0;
+      private:
+        friend class QueryString;
 
-    while (BMCWEB_QS_ISQSCHR(qs[j]))
-    {
-        if (qs[j] == '+')
+        explicit const_iterator(boost::string_view query) :
+            rest(query), atEnd(false)
         {
-            qs[i] = ' ';
+            take();
         }
-        else if (qs[j] == '%') // easier/safer than scanf
+
+        void next()
         {
-            if (!BMCWEB_QS_ISHEX(qs[j + 1]) || !BMCWEB_QS_ISHEX(qs[j + 2]))
+            if (last)
             {
-                qs[i] = '\0';
-                return i;
+                atEnd = true;
+                parameter = QueryParameter();
+                return;
             }
-            qs[i] = (BMCWEB_QS_HEX2DEC(qs[j + 1]) * 16) +
-                    BMCWEB_QS_HEX2DEC(qs[j + 2]);
-            j += 2;
+            take();
         }
-        else
+
+        // Splits off the pair at the front of rest
+        void take()
         {
-            qs[i] = qs[j];
+            size_t end = rest.find('&');
+            boost::string_view pair = rest.substr(0, end);
+            last = end == boost::string_view::npos;
+            rest = last ? boost::string_view() : rest.substr(end + 1);
+            size_t equals = pair.find('=');
+            parameter.key = pair.substr(0, equals);
+            parameter.value = equals == boost::string_view::npos
+                                  ? boost::string_view()
+                                  : pair.substr(equals + 1);
         }
-        i++;
-        j++;
-    }
-    qs[i] = '\0';
 
-    return i;
-}
+        boost::string_view rest;
+        QueryParameter parameter;
+        bool atEnd = true;
+        bool last = false;
+    };
 
-inline char* qsK2v(const char* key, char* const* qs_kv, int qs_kv_size,
-                   int nth = 0)
-{
-    int i;
-    size_t keyLen, skip;
-
-    keyLen = strlen(key);
+    QueryString() = default;
 
-#ifdef _qsSORTING
-// TODO: binary search for key in the sorted qs_kv
-#else  // _qsSORTING
-    for (i = 0; i < qs_kv_size; i++)
+    explicit QueryString(boost::string_view target)
     {
-        // we rely on the unambiguous '=' to find the value in our k/v pair
-        if (qsStrncmp(key, qs_kv[i], keyLen) == 0)
+        size_t start = target.find('?');
+        if (start == boost::string_view::npos)
         {
-            skip = strcspn(qs_kv[i], "=");
-            if (qs_kv[i][skip] == '=')
-            {
-                skip++;
-            }
-            // return (zero-char value) ? ptr to trailing '\0' : ptr to value
-            if (nth == 0)
-            {
-                return qs_kv[i] + skip;
-            }
-            else
-            {
-                --nth;
-            }
+            return;
         }
-    }
-#endif // _qsSORTING
-
-    return NULL;
-}
-
-inline char* qsScanvalue(const char* key, const char* qs, char* val,
-                         size_t val_len)
-{
-    size_t i, keyLen;
-    const char* tmp;
-
-    // find the beginning of the k/v substrings
-    if ((tmp = strchr(qs, '?')) != NULL)
-    {
-        qs = tmp + 1;
+        target = target.substr(start + 1);
+        query = std::string(target.substr(0, target.find('#')));
     }
 
-    keyLen = strlen(key);
-    while (qs[0] != '#' && qs[0] != '\0')
+    const_iterator begin() const
     {
-        if (qsStrncmp(key, qs, keyLen) == 0)
+        if (query.empty())
         {
-            break;
+            return end();
         }
-        qs += strcspn(qs, "&") + 1;
+        return const_iterator(query);
     }
 
-    if (qs[0] == '\0')
+    const_iterator end() const
     {
-        return NULL;
+        return const_iterator();
     }
 
-    qs += strcspn(qs, "=&#");
-    if (qs[0] == '=')
+    bool empty() const
     {
-        qs++;
-        i = strcspn(qs, "&=#");
-        strncpy(val, qs, (val_len - 1) < (i + 1) ? (val_len - 1) : (i + 1));
-        qsDecode(val);
+        return query.empty();
     }
-    else
+
+    void clear()
     {
-        if (val_len > 0)
-        {
-            val[0] = '\0';
-        }
+        query.clear();
     }
 
-    return val;
-}
-} // namespace crow
-// ----------------------------------------------------------------------------
-
-namespace crow
-{
-class QueryString
-{
-  public:
-    static const int maxKeyValuePairsCount = 256;
-
-    QueryString() = default;
-
-    QueryString(const QueryString& qs) : url(qs.url)
+    /**
+     * @brief The decoded value of the first parameter called name, or none
+     *        if there isn't one
+     */
+    boost::optional<std::string> get(boost::string_view name) const
     {
-        for (auto p : qs.keyValuePairs)
+        for (const QueryParameter& parameter : *this)
         {
-            keyValuePairs.push_back(
-                const_cast<char*>(p - qs.url.c_str() + url.c_str()));
+            if (keyEquals(parameter.key, name))
+            {
+                return decode(parameter.value);
+            }
         }
+        return boost::none;
     }
 
-    QueryString& operator=(const QueryString& qs)
+    /**
+     * @brief The decoded values of every name[] parameter, in order
+     */
+    std::vector<std::string> getList(boost::string_view name) const
     {
-        url = qs.url;
-        keyValuePairs.clear();
-        for (auto p : qs.keyValuePairs)
+        std::vector<std::string> ret;
+        for (const QueryParameter& parameter : *this)
         {
-            keyValuePairs.push_back(
-                const_cast<char*>(p - qs.url.c_str() + url.c_str()));
+            boost::string_view key = parameter.key;
+            if (key.ends_with("[]") &&
+                keyEquals(key.substr(0, key.size() - 2), name))
+            {
+                ret.push_back(decode(parameter.value));
+            }
         }
-        return *this;
+        return ret;
     }
 
-    QueryString& operator=(QueryString&& qs)
+    /**
+     * @brief Decodes %XX escapes and '+' for space.  Decoding stops at an
+     *        escape that isn't two hex digits.
+     */
+    static std::string decode(boost::string_view encoded)
     {
-        keyValuePairs = std::move(qs.keyValuePairs);
-        auto* oldData = const_cast<char*>(qs.url.c_str());
-        url = std::move(qs.url);
-        for (auto& p : keyValuePairs)
+        std::string out;
+        out.reserve(encoded.size());
+        for (size_t i = 0; i < encoded.size(); i++)
         {
-            p += const_cast<char*>(url.c_str()) - oldData;
+            char c = encoded[i];
+            if (c == '+')
+            {
+                c = ' ';
+            }
+            else if (c == '%')
+            {
+                if (i + 2 >= encoded.size())
+                {
+                    break;
+                }
+                int h = hexValue(encoded[i + 1]);
+                int l = hexValue(encoded[i + 2]);
+                if (h < 0 || l < 0)
+                {
+                    break;
+                }
+                c = static_cast<char>(h * 16 + l);
+                i += 2;
+            }
+            out += c;
         }
-        return *this;
+        return out;
     }
 
-    explicit QueryString(std::string url) : url(std::move(url))
+    /**
+     * @brief Compares an encoded key with a plain name, without allocating
+     */
+    static bool keyEquals(boost::string_view key, boost::string_view name)
     {
-        if (url.empty())
+        size_t n = 0;
+        for (size_t i = 0; i < key.size(); i++, n++)
         {
-            return;
+            char c = key[i];
+            if (c == '+')
+            {
+                c = ' ';
+            }
+            else if (c == '%')
+            {
+                if (i + 2 >= key.size())
+                {
+                    return false;
+                }
+                int h = hexValue(key[i + 1]);
+                int l = hexValue(key[i + 2]);
+                if (h < 0 || l < 0)
+                {
+                    return false;
+                }
+                c = static_cast<char>(h * 16 + l);
+                i += 2;
+            }
+            if (n >= name.size() || name[n] != c)
+            {
+                return false;
+            }
         }
-
-        keyValuePairs.resize(maxKeyValuePairsCount);
-
-        int count = qsParse(&url[0], &keyValuePairs[0], maxKeyValuePairsCount);
-        keyValuePairs.resize(count);
-    }
-
-    void clear()
-    {
-        keyValuePairs.clear();
-        url.clear();
+        return n == name.size();
     }
 
     friend std::ostream& operator<<(std::ostream& os, const QueryString& qs)
     {
         os << "[ ";
-        for (size_t i = 0; i < qs.keyValuePairs.size(); ++i)
+        bool first = true;
+        for (const QueryParameter& parameter : qs)
         {
-            if (i != 0u)
+            if (!first)
             {
                 os << ", ";
             }
-            os << qs.keyValuePairs[i];
+            first = false;
+            os << parameter.key;
+            if (!parameter.value.empty())
+            {
+                os << '=' << parameter.value;
+            }
         }
         os << " ]";
         return os;
     }
 
-    char* get(const std::string& name) const
-    {
-        char* ret =
-            qsK2v(name.c_str(), keyValuePairs.data(), keyValuePairs.size());
-        return ret;
-    }
-
-    std::vector<char*> getList(const std::string& name) const
+  private:
+    static int hexValue(char c)
     {
-        std::vector<char*> ret;
-        std::string plus = name + "[]";
-        char* element = nullptr;
-
-        int count = 0;
-        while (1)
+        if (c >= '0' && c <= '9')
         {
-            element = qsK2v(plus.c_str(), keyValuePairs.data(),
-                            keyValuePairs.size(), count++);
-            if (element == nullptr)
-            {
-                break;
-            }
-            ret.push_back(element);
+            return c - '0';
         }
-        return ret;
+        if (c >= 'A' && c <= 'F')
+        {
+            return c - 'A' + 10;
+        }
+        if (c >= 'a' && c <= 'f')
+        {
+            return c - 'a' + 10;
+        }
+        return -1;
     }
 
-  private:
-    std::string url;
-    std::vector<char*> keyValuePairs;
+    std::string query;
 };
 
 } // namespace crow
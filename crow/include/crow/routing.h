@@ -2,6 +2,8 @@
 
 #include "boost/container/flat_map.hpp"
 
+#include <algorithm>
+#include <array>
 #include <boost/lexical_cast.hpp>
 #include <cerrno>
 #include <cstdint>
@@ -16,6 +18,7 @@
 #include "crow/http_request.h"
 #include "crow/http_response.h"
 #include "crow/logging.h"
+#include "crow/server_metrics.h"
 #include "crow/utility.h"
 #include "crow/websocket.h"
 
@@ -46,6 +49,12 @@ class BaseRule
         res = Response(boost::beast::http::status::not_found);
         res.end();
     }
+    virtual void handleUpgrade(const Request&, Response& res,
+                               UnixSocketAdaptor&&)
+    {
+        res = Response(boost::beast::http::status::not_found);
+        res.end();
+    }
 #ifdef BMCWEB_ENABLE_SSL
     virtual void handleUpgrade(const Request&, Response& res, SSLAdaptor&&)
     {
@@ -59,8 +68,16 @@ class BaseRule
         return methodsBitfield;
     }
 
+    const std::string& getBodyFileDirectory() const
+    {
+        return bodyFileDirectory;
+    }
+
   protected:
     uint32_t methodsBitfield{1 << (int)boost::beast::http::verb::get};
+    std::string bodyFileDirectory;
+    // Methods whose bodies go to bodyFileDirectory
+    uint32_t bodyFileMethodsBitfield{~0u};
 
     std::string rule;
     std::string nameStr;
@@ -302,9 +319,22 @@ class WebSocketRule : public BaseRule
     void handleUpgrade(const Request& req, Response&,
                        SocketAdaptor&& adaptor) override
     {
-        new crow::websocket::ConnectionImpl<SocketAdaptor>(
-            req, std::move(adaptor), openHandler, messageHandler, closeHandler,
-            errorHandler);
+        std::shared_ptr<crow::websocket::ConnectionImpl<SocketAdaptor>>
+            myConnection = std::make_shared<
+                crow::websocket::ConnectionImpl<SocketAdaptor>>(
+                req, std::move(adaptor), openHandler, messageHandler,
+                closeHandler, errorHandler, queueLimits, deflate, pingPolicy);
+        myConnection->start();
+    }
+    void handleUpgrade(const Request& req, Response&,
+                       UnixSocketAdaptor&& adaptor) override
+    {
+        std::shared_ptr<crow::websocket::ConnectionImpl<UnixSocketAdaptor>>
+            myConnection = std::make_shared<
+                crow::websocket::ConnectionImpl<UnixSocketAdaptor>>(
+                req, std::move(adaptor), openHandler, messageHandler,
+                closeHandler, errorHandler, queueLimits, deflate, pingPolicy);
+        myConnection->start();
     }
 #ifdef BMCWEB_ENABLE_SSL
     void handleUpgrade(const Request& req, Response&,
@@ -314,7 +344,8 @@ class WebSocketRule : public BaseRule
             myConnection =
                 std::make_shared<crow::websocket::ConnectionImpl<SSLAdaptor>>(
                     req, std::move(adaptor), openHandler, messageHandler,
-                    closeHandler, errorHandler);
+                    closeHandler, errorHandler, queueLimits, deflate,
+                    pingPolicy);
         myConnection->start();
     }
 #endif
@@ -343,6 +374,41 @@ class WebSocketRule : public BaseRule
         return *this;
     }
 
+    // Caps the bytes queued for each client of this route, and sets what
+    // happens to a client that doesn't keep up
+    self_t& outboundQueue(size_t maxBytes, websocket::OverflowPolicy policy)
+    {
+        queueLimits.maxBytes = maxBytes;
+        queueLimits.policy = policy;
+        return *this;
+    }
+
+    // Sends the messages queued for a client in one frame, up to maxBytes.
+    // Only for routes whose messages are a byte stream, where the client
+    // can't tell the difference.
+    self_t& batchWrites(size_t maxBytes)
+    {
+        queueLimits.batchBytes = maxBytes;
+        return *this;
+    }
+
+    // Offers the permessage-deflate extension during the upgrade
+    self_t& permessageDeflate()
+    {
+        deflate = true;
+        return *this;
+    }
+
+    // Pings each client every interval, and cuts off one that doesn't
+    // answer within pongTimeout; an interval of 0 turns pings off
+    self_t& ping(std::chrono::milliseconds interval,
+                 std::chrono::milliseconds pongTimeout)
+    {
+        pingPolicy.interval = interval;
+        pingPolicy.pongTimeout = pongTimeout;
+        return *this;
+    }
+
   protected:
     std::function<void(crow::websocket::Connection&)> openHandler;
     std::function<void(crow::websocket::Connection&, const std::string&, bool)>
@@ -350,6 +416,9 @@ class WebSocketRule : public BaseRule
     std::function<void(crow::websocket::Connection&, const std::string&)>
         closeHandler;
     std::function<void(crow::websocket::Connection&)> errorHandler;
+    websocket::QueueLimits queueLimits;
+    bool deflate = false;
+    websocket::PingPolicy pingPolicy;
 };
 
 template <typename T> struct RuleParameterTraits
@@ -368,6 +437,25 @@ template <typename T> struct RuleParameterTraits
         return (self_t&)*this;
     }
 
+    // Write the request body to a new file in directory as it arrives,
+    // instead of collecting it in Request::body.  See Request::bodyFile.
+    self_t& streamBodyToFile(std::string directory)
+    {
+        ((self_t*)this)->bodyFileDirectory = std::move(directory);
+        ((self_t*)this)->bodyFileMethodsBitfield = ~0u;
+        return (self_t&)*this;
+    }
+
+    // The same, for the bodies of one method only; the others are collected
+    // in Request::body as usual
+    self_t& streamBodyToFile(std::string directory,
+                             boost::beast::http::verb method)
+    {
+        ((self_t*)this)->bodyFileDirectory = std::move(directory);
+        ((self_t*)this)->bodyFileMethodsBitfield = 1 << (int)method;
+        return (self_t&)*this;
+    }
+
     self_t& methods(boost::beast::http::verb method)
     {
         ((self_t*)this)->methodsBitfield = 1 << (int)method;
@@ -640,6 +728,7 @@ class Trie
     void optimize()
     {
         optimizeNode(head());
+        flatDirty = true;
     }
 
   public:
@@ -649,6 +738,7 @@ class Trie
             throw std::runtime_error(
                 "Internal error: Trie header should be simple!");
         optimize();
+        flatten();
     }
 
     void findRouteIndexes(const std::string& req_url,
@@ -683,147 +773,20 @@ class Trie
         }
     }
 
-    std::pair<unsigned, RoutingParams>
-        find(const boost::string_view req_url, const Node* node = nullptr,
-             unsigned pos = 0, RoutingParams* params = nullptr) const
+    // Returns the lowest rule index matching the url, or 0, along with the
+    // parameters extracted on the way.  Matching runs over a flattened copy
+    // of the trie built by validate() (or by the first lookup after routes
+    // change), so routes must not be added while lookups are running.
+    std::pair<unsigned, RoutingParams> find(boost::string_view reqUrl) const
     {
-        RoutingParams empty;
-        if (params == nullptr)
-            params = &empty;
-
-        unsigned found{};
-        RoutingParams matchParams;
-
-        if (node == nullptr)
-            node = head();
-        if (pos == req_url.size())
-            return {node->ruleIndex, *params};
-
-        auto updateFound =
-            [&found, &matchParams](std::pair<unsigned, RoutingParams>& ret) {
-                if (ret.first && (!found || found > ret.first))
-                {
-                    found = ret.first;
-                    matchParams = std::move(ret.second);
-                }
-            };
-
-        if (node->paramChildrens[(int)ParamType::INT])
-        {
-            char c = req_url[pos];
-            if ((c >= '0' && c <= '9') || c == '+' || c == '-')
-            {
-                char* eptr;
-                errno = 0;
-                long long int value =
-                    std::strtoll(req_url.data() + pos, &eptr, 10);
-                if (errno != ERANGE && eptr != req_url.data() + pos)
-                {
-                    params->intParams.push_back(value);
-                    auto ret =
-                        find(req_url,
-                             &nodes[node->paramChildrens[(int)ParamType::INT]],
-                             eptr - req_url.data(), params);
-                    updateFound(ret);
-                    params->intParams.pop_back();
-                }
-            }
-        }
-
-        if (node->paramChildrens[(int)ParamType::UINT])
-        {
-            char c = req_url[pos];
-            if ((c >= '0' && c <= '9') || c == '+')
-            {
-                char* eptr;
-                errno = 0;
-                unsigned long long int value =
-                    std::strtoull(req_url.data() + pos, &eptr, 10);
-                if (errno != ERANGE && eptr != req_url.data() + pos)
-                {
-                    params->uintParams.push_back(value);
-                    auto ret =
-                        find(req_url,
-                             &nodes[node->paramChildrens[(int)ParamType::UINT]],
-                             eptr - req_url.data(), params);
-                    updateFound(ret);
-                    params->uintParams.pop_back();
-                }
-            }
-        }
-
-        if (node->paramChildrens[(int)ParamType::DOUBLE])
-        {
-            char c = req_url[pos];
-            if ((c >= '0' && c <= '9') || c == '+' || c == '-' || c == '.')
-            {
-                char* eptr;
-                errno = 0;
-                double value = std::strtod(req_url.data() + pos, &eptr);
-                if (errno != ERANGE && eptr != req_url.data() + pos)
-                {
-                    params->doubleParams.push_back(value);
-                    auto ret = find(
-                        req_url,
-                        &nodes[node->paramChildrens[(int)ParamType::DOUBLE]],
-                        eptr - req_url.data(), params);
-                    updateFound(ret);
-                    params->doubleParams.pop_back();
-                }
-            }
-        }
-
-        if (node->paramChildrens[(int)ParamType::STRING])
-        {
-            size_t epos = pos;
-            for (; epos < req_url.size(); epos++)
-            {
-                if (req_url[epos] == '/')
-                    break;
-            }
-
-            if (epos != pos)
-            {
-                params->stringParams.emplace_back(
-                    req_url.substr(pos, epos - pos));
-                auto ret =
-                    find(req_url,
-                         &nodes[node->paramChildrens[(int)ParamType::STRING]],
-                         epos, params);
-                updateFound(ret);
-                params->stringParams.pop_back();
-            }
-        }
-
-        if (node->paramChildrens[(int)ParamType::PATH])
+        if (flatDirty)
         {
-            size_t epos = req_url.size();
-
-            if (epos != pos)
-            {
-                params->stringParams.emplace_back(
-                    req_url.substr(pos, epos - pos));
-                auto ret = find(
-                    req_url, &nodes[node->paramChildrens[(int)ParamType::PATH]],
-                    epos, params);
-                updateFound(ret);
-                params->stringParams.pop_back();
-            }
+            flatten();
         }
-
-        for (auto& kv : node->children)
-        {
-            const std::string& fragment = kv.first;
-            const Node* child = &nodes[kv.second];
-
-            if (req_url.compare(pos, fragment.size(), fragment) == 0)
-            {
-                auto ret = find(req_url, child, pos + fragment.size(), params);
-                updateFound(ret);
-            }
-        }
-
-        return {found, matchParams};
+        RoutingParams params;
+        Match best;
+        findFlat(reqUrl, 0, 0, params, best);
+        return {best.ruleIndex, std::move(best.params)};
     }
 
     void add(const std::string& url, unsigned ruleIndex)
@@ -880,6 +843,7 @@ class Trie
         if (nodes[idx].ruleIndex)
             throw std::runtime_error("handler already exists for " + url);
         nodes[idx].ruleIndex = ruleIndex;
+        flatDirty = true;
     }
 
   private:
@@ -948,7 +912,320 @@ class Trie
         return nodes.size() - 1;
     }
 
+    // The lookup form of the trie, a radix tree: every node in one array,
+    // each node's static children a contiguous run of edges sorted by first
+    // character, and all edge labels in one string.  Chains of nodes with a
+    // single static child and nothing else are collapsed into one edge.
+    struct FlatNode
+    {
+        unsigned ruleIndex{};
+        // Lowest rule index anywhere in this subtree, 0 if none; lets the
+        // search skip subtrees that can't beat the best match so far
+        unsigned minRuleIndex{};
+        std::array<unsigned, (int)ParamType::MAX> paramChildren{};
+        unsigned edgesBegin{};
+        unsigned edgesEnd{};
+    };
+
+    struct FlatEdge
+    {
+        char first{};
+        unsigned labelOffset{};
+        unsigned labelSize{};
+        unsigned child{};
+    };
+
+    struct Match
+    {
+        unsigned ruleIndex{};
+        RoutingParams params;
+    };
+
+    void flatten() const
+    {
+        flatNodes.clear();
+        flatEdges.clear();
+        flatLabels.clear();
+        flattenNode(0);
+        flatDirty = false;
+    }
+
+    unsigned flattenNode(unsigned nodeIndex) const
+    {
+        unsigned flatIndex = static_cast<unsigned>(flatNodes.size());
+        flatNodes.emplace_back();
+        const Node& node = nodes[nodeIndex];
+        unsigned minRuleIndex = node.ruleIndex;
+        auto updateMin = [&minRuleIndex](unsigned ruleIndex) {
+            if (ruleIndex != 0 &&
+                (minRuleIndex == 0 || ruleIndex < minRuleIndex))
+            {
+                minRuleIndex = ruleIndex;
+            }
+        };
+
+        for (int type = 0; type < (int)ParamType::MAX; type++)
+        {
+            if (node.paramChildrens[type])
+            {
+                unsigned child = flattenNode(node.paramChildrens[type]);
+                flatNodes[flatIndex].paramChildren[type] = child;
+                updateMin(flatNodes[child].minRuleIndex);
+            }
+        }
+
+        Edges edges;
+        edges.reserve(node.children.size());
+        for (const auto& kv : node.children)
+        {
+            std::string label = kv.first;
+            unsigned child = kv.second;
+            while (nodes[child].isSimpleNode() &&
+                   nodes[child].children.size() == 1)
+            {
+                label += nodes[child].children.begin()->first;
+                child = nodes[child].children.begin()->second;
+            }
+            edges.emplace_back(std::move(label), child);
+        }
+        updateMin(flattenEdges(flatIndex, std::move(edges)));
+
+        flatNodes[flatIndex].ruleIndex = node.ruleIndex;
+        flatNodes[flatIndex].minRuleIndex = minRuleIndex;
+        return flatIndex;
+    }
+
+    using Edges = std::vector<std::pair<std::string, unsigned>>;
+
+    // Lays out the static children of a flat node, splitting labels that
+    // share a prefix so a lookup never compares more than one of them.
+    // optimize() leaves every child of a merged node keyed by its whole
+    // remaining path, which would otherwise mean a linear scan over all of
+    // them.  Returns the lowest rule index found below.
+    unsigned flattenEdges(unsigned flatIndex, Edges edges) const
+    {
+        std::sort(edges.begin(), edges.end());
+
+        // Each group is a run of labels with the same first character
+        std::vector<std::pair<size_t, size_t>> groups;
+        for (size_t i = 0; i < edges.size(); i++)
+        {
+            if (groups.empty() ||
+                edges[groups.back().first].first[0] != edges[i].first[0])
+            {
+                groups.emplace_back(i, i + 1);
+            }
+            else
+            {
+                groups.back().second = i + 1;
+            }
+        }
+
+        // Reserve this node's run of edges before the children add theirs
+        unsigned edgesBegin = static_cast<unsigned>(flatEdges.size());
+        flatEdges.resize(flatEdges.size() + groups.size());
+        flatNodes[flatIndex].edgesBegin = edgesBegin;
+        flatNodes[flatIndex].edgesEnd =
+            edgesBegin + static_cast<unsigned>(groups.size());
+
+        unsigned minRuleIndex = 0;
+        for (size_t g = 0; g < groups.size(); g++)
+        {
+            size_t first = groups[g].first;
+            size_t last = groups[g].second;
+            std::string label;
+            unsigned child;
+            if (last - first == 1)
+            {
+                label = std::move(edges[first].first);
+                child = flattenNode(edges[first].second);
+            }
+            else
+            {
+                // Labels are sorted, so the first and last share the
+                // shortest common prefix of the group
+                const std::string& a = edges[first].first;
+                const std::string& b = edges[last - 1].first;
+                size_t prefix = 0;
+                while (prefix < a.size() && prefix < b.size() &&
+                       a[prefix] == b[prefix])
+                {
+                    prefix++;
+                }
+                label = a.substr(0, prefix);
+                Edges rest;
+                rest.reserve(last - first);
+                for (size_t i = first; i < last; i++)
+                {
+                    rest.emplace_back(edges[i].first.substr(prefix),
+                                      edges[i].second);
+                }
+                // Trie children never have a label that is a prefix of
+                // another, so none of the remainders are empty
+                child = static_cast<unsigned>(flatNodes.size());
+                flatNodes.emplace_back();
+                unsigned restMin = flattenEdges(child, std::move(rest));
+                flatNodes[child].minRuleIndex = restMin;
+            }
+
+            FlatEdge& edge = flatEdges[edgesBegin + g];
+            edge.first = label[0];
+            edge.labelOffset = static_cast<unsigned>(flatLabels.size());
+            edge.labelSize = static_cast<unsigned>(label.size());
+            edge.child = child;
+            flatLabels += label;
+
+            unsigned childMin = flatNodes[child].minRuleIndex;
+            if (childMin != 0 && (minRuleIndex == 0 || childMin < minRuleIndex))
+            {
+                minRuleIndex = childMin;
+            }
+        }
+        return minRuleIndex;
+    }
+
+    // Parses a number at the start of text with parse, without reading past
+    // the end of the view.  Returns the number of characters used, 0 if
+    // there's no number there.
+    template <typename T, typename Parse>
+    static size_t parseNumber(boost::string_view text, T& value, Parse parse)
+    {
+        std::array<char, 64> digits{};
+        size_t size = std::min(text.size(), digits.size() - 1);
+        std::copy_n(text.data(), size, digits.begin());
+        char* eptr = nullptr;
+        errno = 0;
+        value = parse(digits.data(), &eptr);
+        if (errno == ERANGE || eptr == digits.data())
+        {
+            return 0;
+        }
+        return static_cast<size_t>(eptr - digits.data());
+    }
+
+    void findFlat(boost::string_view url, unsigned nodeIndex, size_t pos,
+                  RoutingParams& params, Match& best) const
+    {
+        const FlatNode& node = flatNodes[nodeIndex];
+        if (node.minRuleIndex == 0 ||
+            (best.ruleIndex != 0 && node.minRuleIndex >= best.ruleIndex))
+        {
+            return;
+        }
+        if (pos == url.size())
+        {
+            if (node.ruleIndex != 0 &&
+                (best.ruleIndex == 0 || node.ruleIndex < best.ruleIndex))
+            {
+                best.ruleIndex = node.ruleIndex;
+                best.params = params;
+            }
+            return;
+        }
+
+        char c = url[pos];
+        boost::string_view rest = url.substr(pos);
+        if (node.paramChildren[(int)ParamType::INT] &&
+            ((c >= '0' && c <= '9') || c == '+' || c == '-'))
+        {
+            long long int value = 0;
+            size_t used = parseNumber(
+                rest, value,
+                [](const char* str, char** end) {
+                    return std::strtoll(str, end, 10);
+                });
+            if (used != 0)
+            {
+                params.intParams.push_back(value);
+                findFlat(url, node.paramChildren[(int)ParamType::INT],
+                         pos + used, params, best);
+                params.intParams.pop_back();
+            }
+        }
+
+        if (node.paramChildren[(int)ParamType::UINT] &&
+            ((c >= '0' && c <= '9') || c == '+'))
+        {
+            unsigned long long int value = 0;
+            size_t used = parseNumber(
+                rest, value,
+                [](const char* str, char** end) {
+                    return std::strtoull(str, end, 10);
+                });
+            if (used != 0)
+            {
+                params.uintParams.push_back(value);
+                findFlat(url, node.paramChildren[(int)ParamType::UINT],
+                         pos + used, params, best);
+                params.uintParams.pop_back();
+            }
+        }
+
+        if (node.paramChildren[(int)ParamType::DOUBLE] &&
+            ((c >= '0' && c <= '9') || c == '+' || c == '-' || c == '.'))
+        {
+            double value = 0;
+            size_t used = parseNumber(
+                rest, value, [](const char* str, char** end) {
+                    return std::strtod(str, end);
+                });
+            if (used != 0)
+            {
+                params.doubleParams.push_back(value);
+                findFlat(url, node.paramChildren[(int)ParamType::DOUBLE],
+                         pos + used, params, best);
+                params.doubleParams.pop_back();
+            }
+        }
+
+        if (node.paramChildren[(int)ParamType::STRING])
+        {
+            size_t epos = url.find('/', pos);
+            if (epos == boost::string_view::npos)
+            {
+                epos = url.size();
+            }
+            if (epos != pos)
+            {
+                params.stringParams.push_back(url.substr(pos, epos - pos));
+                findFlat(url, node.paramChildren[(int)ParamType::STRING],
+                         epos, params, best);
+                params.stringParams.pop_back();
+            }
+        }
+
+        if (node.paramChildren[(int)ParamType::PATH])
+        {
+            params.stringParams.push_back(rest);
+            findFlat(url, node.paramChildren[(int)ParamType::PATH],
+                     url.size(), params, best);
+            params.stringParams.pop_back();
+        }
+
+        // Edges out of a node all start with a different character
+        const FlatEdge* edgesBegin = flatEdges.data() + node.edgesBegin;
+        const FlatEdge* edgesEnd = flatEdges.data() + node.edgesEnd;
+        const FlatEdge* edge = std::lower_bound(
+            edgesBegin, edgesEnd, c,
+            [](const FlatEdge& e, char value) { return e.first < value; });
+        if (edge != edgesEnd && edge->first == c)
+        {
+            boost::string_view label(flatLabels.data() + edge->labelOffset,
+                                     edge->labelSize);
+            if (rest.size() >= label.size() &&
+                rest.compare(0, label.size(), label) == 0)
+            {
+                findFlat(url, edge->child, pos + label.size(), params, best);
+            }
+        }
+    }
+
     std::vector<Node> nodes;
+
+    mutable bool flatDirty{true};
+    mutable std::vector<FlatNode> flatNodes;
+    mutable std::vector<FlatEdge> flatEdges;
+    mutable std::string flatLabels;
 };
 
 class Router
@@ -1009,6 +1286,54 @@ class Router
                 rule->validate();
             }
         }
+        // Rules aren't added once validated, so connections can look their
+        // metrics up without a lock
+        while (metrics.size() < rules.size())
+        {
+            metrics.emplace_back(std::make_unique<RouteMetrics>());
+        }
+    }
+
+    // The metrics of the rule handle() matched; 0 stands for requests no
+    // rule handled
+    RouteMetrics* routeMetrics(unsigned ruleIndex)
+    {
+        if (ruleIndex >= metrics.size())
+        {
+            return nullptr;
+        }
+        return metrics[ruleIndex].get();
+    }
+
+    // The metrics of every route, in Prometheus text format
+    std::string metricsText() const
+    {
+        std::string out;
+        appendMetricsHeader(out);
+        for (size_t i = 0; i < metrics.size(); i++)
+        {
+            const std::string* name = nullptr;
+            static const std::string unmatched("(none)");
+            static const std::string redirect("(redirect)");
+            if (i == 0)
+            {
+                name = &unmatched;
+            }
+            else if (i == ruleSpecialRedirectSlash)
+            {
+                name = &redirect;
+            }
+            else if (rules[i])
+            {
+                name = &rules[i]->rule;
+            }
+            if (name != nullptr)
+            {
+                appendRouteMetrics(out, *name, *metrics[i]);
+            }
+        }
+        appendServerCounters(out);
+        return out;
     }
 
     template <typename Adaptor>
@@ -1090,11 +1415,40 @@ class Router
         }
     }
 
-    void handle(const Request& req, Response& res)
+    // Returns the directory the body of req should be streamed to, or
+    // nullptr if the matching rule takes its body in memory.  Called before
+    // the body is read, possibly from an io worker thread; that's safe since
+    // the rules don't change once validated.
+    const std::string* findBodyFileDirectory(const Request& req) const
+    {
+        unsigned ruleIndex = trie.find(req.url).first;
+        if (ruleIndex == 0 || ruleIndex == ruleSpecialRedirectSlash ||
+            ruleIndex >= rules.size())
+        {
+            return nullptr;
+        }
+        const BaseRule& rule = *rules[ruleIndex];
+        uint32_t method = 1 << (uint32_t)req.method();
+        if ((rule.methodsBitfield & rule.bodyFileMethodsBitfield & method) ==
+                0 ||
+            rule.getBodyFileDirectory().empty())
+        {
+            return nullptr;
+        }
+        return &rule.getBodyFileDirectory();
+    }
+
+    // matched, if given, is set to the index of the rule that handles req,
+    // before its handler runs
+    void handle(const Request& req, Response& res, unsigned* matched = nullptr)
     {
         auto found = trie.find(req.url);
 
         unsigned ruleIndex = found.first;
+        if (matched != nullptr)
+        {
+            *matched = ruleIndex < rules.size() ? ruleIndex : 0;
+        }
 
         if (!ruleIndex)
         {
@@ -1136,6 +1490,10 @@ class Router
                              << " with " << req.methodString() << "("
                              << (uint32_t)req.method() << ") / "
                              << rules[ruleIndex]->getMethods();
+            if (matched != nullptr)
+            {
+                *matched = 0;
+            }
             res = Response(boost::beast::http::status::not_found);
             res.end();
             return;
@@ -1185,8 +1543,24 @@ class Router
         return ret;
     }
 
+    // The pattern of every rule, in the order they were added
+    std::vector<const std::string*> getAllRoutes() const
+    {
+        std::vector<const std::string*> ret;
+        for (const std::unique_ptr<BaseRule>& rule : rules)
+        {
+            if (rule)
+            {
+                ret.push_back(&rule->rule);
+            }
+        }
+        return ret;
+    }
+
   private:
     std::vector<std::unique_ptr<BaseRule>> rules;
     Trie trie;
+    // Indexed like rules
+    std::vector<std::unique_ptr<RouteMetrics>> metrics;
 };
 } // namespace crow
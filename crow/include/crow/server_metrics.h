@@ -0,0 +1,351 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "crow/admission.h"
+#include "crow/buffer_budget.h"
+#include "crow/keep_alive.h"
+
+namespace crow
+{
+
+// The phases a request goes through on a connection
+enum class RequestPhase
+{
+    // From the end of the headers to the end of the body
+    parse,
+    // The middlewares, authentication among them
+    auth,
+    // The route handler, until it ends the response
+    handler,
+    // Sending the response
+    write
+};
+
+constexpr size_t requestPhaseCount()
+{
+    return 4;
+}
+
+inline const char* phaseName(RequestPhase phase)
+{
+    switch (phase)
+    {
+        case RequestPhase::parse:
+            return "parse";
+        case RequestPhase::auth:
+            return "auth";
+        case RequestPhase::handler:
+            return "handler";
+        case RequestPhase::write:
+            return "write";
+    }
+    return "";
+}
+
+// Buckets of a LatencyHistogram with an upper bound
+constexpr size_t latencyBoundedBuckets()
+{
+    return 16;
+}
+
+// Counts durations into fixed buckets, from 100us to 10s, so that recording
+// is a couple of atomic adds and never allocates
+class LatencyHistogram
+{
+  public:
+    // Buckets with an upper bound; one more counts everything above
+    static constexpr size_t boundedBuckets()
+    {
+        return latencyBoundedBuckets();
+    }
+
+    // Upper bound of bucket i, in microseconds
+    static uint64_t bound(size_t i)
+    {
+        static const std::array<uint64_t, latencyBoundedBuckets()> bounds{
+            {100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000,
+             250000, 500000, 1000000, 2500000, 5000000, 10000000}};
+        return bounds[i];
+    }
+
+    void record(std::chrono::microseconds duration)
+    {
+        uint64_t us = static_cast<uint64_t>(
+            std::max<std::chrono::microseconds::rep>(duration.count(), 0));
+        size_t i = 0;
+        while (i < boundedBuckets() && us > bound(i))
+        {
+            i++;
+        }
+        buckets[i].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(us, std::memory_order_relaxed);
+    }
+
+    // Durations in bucket i alone; i == boundedBuckets() is the overflow
+    uint64_t bucket(size_t i) const
+    {
+        return buckets[i].load(std::memory_order_relaxed);
+    }
+
+    uint64_t count() const
+    {
+        return total.load(std::memory_order_relaxed);
+    }
+
+    uint64_t sumMicroseconds() const
+    {
+        return sum.load(std::memory_order_relaxed);
+    }
+
+  private:
+    std::array<std::atomic<uint64_t>, latencyBoundedBuckets() + 1> buckets{};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> sum{0};
+};
+
+// The latency of each phase of the requests one route handled
+struct RouteMetrics
+{
+    std::array<LatencyHistogram, requestPhaseCount()> phases;
+};
+
+// Totals over all HTTP connections
+struct ServerCounters
+{
+    std::atomic<uint64_t> bytesIn{0};
+    std::atomic<uint64_t> bytesOut{0};
+    std::atomic<int64_t> activeConnections{0};
+    std::atomic<uint64_t> connections{0};
+};
+
+inline ServerCounters& serverCounters()
+{
+    static ServerCounters counters;
+    return counters;
+}
+
+// Times the phases of the request a connection is working on
+class RequestTimer
+{
+  public:
+    using clock = std::chrono::steady_clock;
+
+    // The headers are in; parse is the current phase
+    void start()
+    {
+        entered = {};
+        durations = {};
+        current = RequestPhase::parse;
+        entered[0] = true;
+        mark = clock::now();
+    }
+
+    // Ends the current phase and starts next
+    void enter(RequestPhase next)
+    {
+        clock::time_point now = clock::now();
+        durations[static_cast<size_t>(current)] += now - mark;
+        mark = now;
+        current = next;
+        entered[static_cast<size_t>(next)] = true;
+    }
+
+    // Ends the current phase, and adds the phases the request went through
+    // to metrics
+    void finish(RouteMetrics& metrics)
+    {
+        enter(current);
+        for (size_t i = 0; i < requestPhaseCount(); i++)
+        {
+            if (entered[i])
+            {
+                metrics.phases[i].record(
+                    std::chrono::duration_cast<std::chrono::microseconds>(
+                        durations[i]));
+            }
+        }
+        entered = {};
+    }
+
+    // Whether start was called since the last finish
+    bool running() const
+    {
+        return entered[0];
+    }
+
+  private:
+    clock::time_point mark;
+    RequestPhase current = RequestPhase::parse;
+    std::array<clock::duration, requestPhaseCount()> durations{};
+    std::array<bool, requestPhaseCount()> entered{};
+};
+
+namespace detail
+{
+
+// A label value, with the escapes the Prometheus text format wants
+inline void appendLabel(std::string& out, const std::string& value)
+{
+    for (char c : value)
+    {
+        if (c == '\\' || c == '"')
+        {
+            out += '\\';
+        }
+        if (c == '\n')
+        {
+            out += "\\n";
+            continue;
+        }
+        out += c;
+    }
+}
+
+inline void appendSeconds(std::string& out, uint64_t microseconds)
+{
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.6f",
+                  static_cast<double>(microseconds) / 1e6);
+    out += text;
+}
+
+} // namespace detail
+
+/**
+ * @brief Appends one histogram in Prometheus text format
+ *
+ * @param[in] name    The metric, without the _bucket, _sum and _count ends
+ * @param[in] labels  Label pairs, already escaped, separated by commas
+ */
+inline void appendHistogram(std::string& out, const char* name,
+                            const std::string& labels,
+                            const LatencyHistogram& histogram)
+{
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i <= LatencyHistogram::boundedBuckets(); i++)
+    {
+        cumulative += histogram.bucket(i);
+        out += name;
+        out += "_bucket{";
+        out += labels;
+        out += ",le=\"";
+        if (i < LatencyHistogram::boundedBuckets())
+        {
+            detail::appendSeconds(out, LatencyHistogram::bound(i));
+        }
+        else
+        {
+            out += "+Inf";
+        }
+        out += "\"} ";
+        out += std::to_string(cumulative);
+        out += '\n';
+    }
+    out += name;
+    out += "_sum{";
+    out += labels;
+    out += "} ";
+    detail::appendSeconds(out, histogram.sumMicroseconds());
+    out += '\n';
+    out += name;
+    out += "_count{";
+    out += labels;
+    out += "} ";
+    out += std::to_string(histogram.count());
+    out += '\n';
+}
+
+/**
+ * @brief Appends the histograms of one route in Prometheus text format
+ *
+ * Phases no request went through are left out.  The header lines come from
+ * appendMetricsHeader.
+ */
+inline void appendRouteMetrics(std::string& out, const std::string& route,
+                               const RouteMetrics& metrics)
+{
+    for (size_t phase = 0; phase < requestPhaseCount(); phase++)
+    {
+        const LatencyHistogram& histogram = metrics.phases[phase];
+        if (histogram.count() == 0)
+        {
+            continue;
+        }
+        std::string labels = "route=\"";
+        detail::appendLabel(labels, route);
+        labels += "\",phase=\"";
+        labels += phaseName(static_cast<RequestPhase>(phase));
+        labels += '"';
+        appendHistogram(out, "bmcweb_request_duration_seconds", labels,
+                        histogram);
+    }
+}
+
+inline void appendMetricsHeader(std::string& out)
+{
+    out += "# HELP bmcweb_request_duration_seconds Time requests spent in "
+           "each phase, by route\n"
+           "# TYPE bmcweb_request_duration_seconds histogram\n";
+}
+
+// The connection and byte counters, in Prometheus text format
+inline void appendServerCounters(std::string& out)
+{
+    const ServerCounters& counters = serverCounters();
+    out += "# HELP bmcweb_received_bytes_total Bytes read from HTTP "
+           "connections\n"
+           "# TYPE bmcweb_received_bytes_total counter\n"
+           "bmcweb_received_bytes_total ";
+    out += std::to_string(counters.bytesIn.load());
+    out += "\n# HELP bmcweb_sent_bytes_total Bytes written to HTTP "
+           "connections\n"
+           "# TYPE bmcweb_sent_bytes_total counter\n"
+           "bmcweb_sent_bytes_total ";
+    out += std::to_string(counters.bytesOut.load());
+    out += "\n# HELP bmcweb_connections_active HTTP connections open\n"
+           "# TYPE bmcweb_connections_active gauge\n"
+           "bmcweb_connections_active ";
+    out += std::to_string(counters.activeConnections.load());
+    out += "\n# HELP bmcweb_connections_total HTTP connections accepted\n"
+           "# TYPE bmcweb_connections_total counter\n"
+           "bmcweb_connections_total ";
+    out += std::to_string(counters.connections.load());
+    const BufferBudget& budget = connectionBufferBudget();
+    out += "\n# HELP bmcweb_connection_buffer_bytes Bytes held by connection "
+           "read buffers\n"
+           "# TYPE bmcweb_connection_buffer_bytes gauge\n"
+           "bmcweb_connection_buffer_bytes ";
+    out += std::to_string(budget.used());
+    out += "\n# HELP bmcweb_connection_buffer_budget_bytes Bytes connection "
+           "read buffers may hold before idle ones are freed\n"
+           "# TYPE bmcweb_connection_buffer_budget_bytes gauge\n"
+           "bmcweb_connection_buffer_budget_bytes ";
+    out += std::to_string(budget.limit());
+    AdmissionControl& admission = admissionControl();
+    out += "\n# HELP bmcweb_requests_in_flight Requests read and not yet "
+           "answered\n"
+           "# TYPE bmcweb_requests_in_flight gauge\n"
+           "bmcweb_requests_in_flight ";
+    out += std::to_string(admission.requestsInFlight());
+    out += "\n# HELP bmcweb_connections_refused_total Connections closed when "
+           "accepted, over a connection limit\n"
+           "# TYPE bmcweb_connections_refused_total counter\n"
+           "bmcweb_connections_refused_total ";
+    out += std::to_string(admission.getCounters().refusedConnections.load());
+    out += "\n# HELP bmcweb_requests_shed_total Requests answered with 503 "
+           "under overload\n"
+           "# TYPE bmcweb_requests_shed_total counter\n"
+           "bmcweb_requests_shed_total ";
+    out += std::to_string(admission.getCounters().shedRequests.load());
+    out += '\n';
+    connectionReuse().appendMetrics(out);
+}
+
+} // namespace crow
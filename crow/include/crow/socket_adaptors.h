@@ -1,10 +1,18 @@
 #pragma once
+#include <pwd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
 #include <boost/asio.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/utility/string_view.hpp>
+#include <string>
+#include <vector>
 
 #include "crow/logging.h"
 
 #ifdef BMCWEB_ENABLE_SSL
+#include <atomic>
 #include <boost/asio/ssl.hpp>
 #endif
 namespace crow
@@ -14,6 +22,7 @@ using tcp = asio::ip::tcp;
 
 struct SocketAdaptor
 {
+    using protocol = tcp;
     using streamType = tcp::socket;
     using secure = std::false_type;
     using context = void;
@@ -22,6 +31,12 @@ struct SocketAdaptor
     {
     }
 
+    // What an inherited listening socket is taken to be
+    static protocol listenProtocol()
+    {
+        return tcp::v6();
+    }
+
     boost::asio::io_service& getIoService()
     {
         return socketCls.get_io_service();
@@ -48,6 +63,18 @@ struct SocketAdaptor
         return boost::lexical_cast<std::string>(ep);
     }
 
+    // Where admission control counts the connection from
+    boost::asio::ip::address remoteAddress(boost::system::error_code& ec)
+    {
+        return socketCls.remote_endpoint(ec).address();
+    }
+
+    // Only a Unix socket knows who its peer is
+    std::string localUser() const
+    {
+        return std::string();
+    }
+
     bool isOpen()
     {
         return socketCls.is_open();
@@ -64,6 +91,12 @@ struct SocketAdaptor
         f(ec);
     }
 
+    // Without TLS there is no ALPN; the connection is HTTP/1
+    boost::string_view alpnProtocol()
+    {
+        return boost::string_view();
+    }
+
     tcp::socket socketCls;
 };
 
@@ -96,6 +129,16 @@ struct TestSocketAdaptor
         return "Testhost";
     }
 
+    boost::asio::ip::address remoteAddress(boost::system::error_code& ec)
+    {
+        return socketCls.remote_endpoint(ec).address();
+    }
+
+    std::string localUser() const
+    {
+        return std::string();
+    }
+
     bool isOpen()
     {
         return socketCls.is_open();
@@ -111,14 +154,167 @@ struct TestSocketAdaptor
         f(boost::system::error_code());
     }
 
+    boost::string_view alpnProtocol()
+    {
+        return boost::string_view();
+    }
+
     tcp::socket socketCls;
 };
 
+// The name of the account uid belongs to, or an empty string if it has none
+inline std::string userNameOf(uid_t uid)
+{
+    long size = sysconf(_SC_GETPW_R_SIZE_MAX);
+    std::vector<char> buffer(size > 0 ? static_cast<size_t>(size) : 1024);
+    struct passwd entry
+    {
+    };
+    struct passwd* found = nullptr;
+    if (getpwuid_r(uid, &entry, buffer.data(), buffer.size(), &found) != 0 ||
+        found == nullptr)
+    {
+        return std::string();
+    }
+    return std::string(found->pw_name);
+}
+
+/**
+ * @brief A connection over a Unix socket, from a process on the BMC itself
+ *
+ * There's no TLS; only processes the socket file lets in can connect, and
+ * the kernel tells who the peer runs as.  Requests that bring no
+ * credentials of their own are made as that user.
+ */
+struct UnixSocketAdaptor
+{
+    using protocol = boost::asio::local::stream_protocol;
+    using streamType = protocol::socket;
+    using secure = std::false_type;
+    using context = void;
+    UnixSocketAdaptor(boost::asio::io_service& ioService,
+                      context* /*unused*/) :
+        socketCls(ioService)
+    {
+    }
+
+    static protocol listenProtocol()
+    {
+        return protocol();
+    }
+
+    boost::asio::io_service& getIoService()
+    {
+        return socketCls.get_io_service();
+    }
+
+    protocol::socket& rawSocket()
+    {
+        return socketCls;
+    }
+
+    protocol::socket& socket()
+    {
+        return socketCls;
+    }
+
+    std::string remoteEndpoint()
+    {
+        return "local:" +
+               (peerUser.empty() ? std::to_string(peerUid) : peerUser);
+    }
+
+    // Local clients are counted per uid, each as an address of its own in
+    // 100::/64, the IPv6 discard prefix no TCP client connects from
+    boost::asio::ip::address remoteAddress(boost::system::error_code& ec)
+    {
+        ec = readPeer();
+        boost::asio::ip::address_v6::bytes_type bytes{};
+        bytes[0] = 0x01;
+        uint32_t uid = peerUid;
+        for (size_t i = bytes.size(); i > bytes.size() - 4; i--)
+        {
+            bytes[i - 1] = static_cast<unsigned char>(uid);
+            uid >>= 8;
+        }
+        return boost::asio::ip::address_v6(bytes);
+    }
+
+    // The account the peer process runs as; empty if its uid has no name
+    std::string localUser() const
+    {
+        return peerUser;
+    }
+
+    bool isOpen()
+    {
+        return socketCls.is_open();
+    }
+
+    void close()
+    {
+        boost::system::error_code ec;
+        socketCls.close(ec);
+    }
+
+    template <typename F> void start(F f)
+    {
+        f(readPeer());
+    }
+
+    boost::string_view alpnProtocol()
+    {
+        return boost::string_view();
+    }
+
+    // The peer can't change over the connection, so it's looked up once
+    boost::system::error_code readPeer()
+    {
+        if (peerRead)
+        {
+            return boost::system::error_code();
+        }
+        struct ucred credentials
+        {
+        };
+        socklen_t length = sizeof(credentials);
+        if (getsockopt(socketCls.native_handle(), SOL_SOCKET, SO_PEERCRED,
+                       &credentials, &length) != 0)
+        {
+            return boost::system::error_code(errno,
+                                             boost::system::system_category());
+        }
+        peerUid = credentials.uid;
+        peerUser = userNameOf(credentials.uid);
+        peerRead = true;
+        return boost::system::error_code();
+    }
+
+    protocol::socket socketCls;
+    bool peerRead = false;
+    uid_t peerUid{static_cast<uid_t>(-1)};
+    std::string peerUser;
+};
+
 #ifdef BMCWEB_ENABLE_SSL
+// Completed TLS handshakes, by whether they resumed an earlier session
+struct TlsHandshakeCounters
+{
+    std::atomic<uint64_t> full{0};
+    std::atomic<uint64_t> resumed{0};
+};
+
+inline TlsHandshakeCounters& tlsHandshakeCounters()
+{
+    static TlsHandshakeCounters counters;
+    return counters;
+}
+
 struct SSLAdaptor
 {
     using streamType = boost::asio::ssl::stream<tcp::socket>;
     using secure = std::true_type;
+    using protocol = tcp;
     using context = boost::asio::ssl::context;
     using ssl_socket_t = boost::asio::ssl::stream<tcp::socket>;
     SSLAdaptor(boost::asio::io_service& ioService, context* ctx) :
@@ -126,6 +322,11 @@ struct SSLAdaptor
     {
     }
 
+    static protocol listenProtocol()
+    {
+        return tcp::v6();
+    }
+
     boost::asio::ssl::stream<tcp::socket>& socket()
     {
         return *sslSocket;
@@ -147,6 +348,16 @@ struct SSLAdaptor
         return boost::lexical_cast<std::string>(ep);
     }
 
+    boost::asio::ip::address remoteAddress(boost::system::error_code& ec)
+    {
+        return rawSocket().remote_endpoint(ec).address();
+    }
+
+    std::string localUser() const
+    {
+        return std::string();
+    }
+
     bool isOpen()
     {
         /*TODO(ed) this is a bit of a cheat.
@@ -191,7 +402,35 @@ struct SSLAdaptor
     {
         sslSocket->async_handshake(
             boost::asio::ssl::stream_base::server,
-            [f](const boost::system::error_code& ec) { f(ec); });
+            [this, f](const boost::system::error_code& ec) {
+                if (!ec)
+                {
+                    if (SSL_session_reused(sslSocket->native_handle()) == 1)
+                    {
+                        tlsHandshakeCounters().resumed++;
+                    }
+                    else
+                    {
+                        tlsHandshakeCounters().full++;
+                    }
+                }
+                f(ec);
+            });
+    }
+
+    // The protocol ALPN settled on in the handshake; empty if the client
+    // offered none the server takes
+    boost::string_view alpnProtocol()
+    {
+        const unsigned char* protocol = nullptr;
+        unsigned int length = 0;
+        SSL_get0_alpn_selected(sslSocket->native_handle(), &protocol, &length);
+        if (protocol == nullptr)
+        {
+            return boost::string_view();
+        }
+        return boost::string_view(reinterpret_cast<const char*>(protocol),
+                                  length);
     }
 
     std::unique_ptr<boost::asio::ssl::stream<tcp::socket>> sslSocket;
@@ -1,9 +1,10 @@
 #pragma once
 
-#include <boost/circular_buffer.hpp>
-#include <boost/circular_buffer/space_optimized.hpp>
+#include <array>
 #include <chrono>
+#include <cstdint>
 #include <functional>
+#include <vector>
 
 #include "crow/logging.h"
 
@@ -11,68 +12,241 @@ namespace crow
 {
 namespace detail
 {
-// fast timer queue for fixed tick value.
+// Hierarchical timing wheel.  Every timer has its own timeout; adding and
+// cancelling are O(1) and process() only touches the slots that came due.
+// The owner is expected to call process() at least every resolution(), from
+// the io_service the timers belong to.
 class TimerQueue
 {
   public:
-    TimerQueue()
+    using clock = std::chrono::steady_clock;
+    // Opaque handle returned by add().  Stale ids are ignored by cancel(),
+    // and 0 is never returned, so it can be used as "no timer".
+    using TimerId = uint64_t;
+
+    static constexpr std::chrono::milliseconds resolution()
     {
-        dq.set_capacity(100);
+        return std::chrono::milliseconds(100);
     }
 
-    void cancel(int k)
+    explicit TimerQueue(clock::time_point start = clock::now()) :
+        startTime(start)
     {
-        unsigned int index = static_cast<unsigned int>(k - step);
-        if (index < dq.size())
+        for (auto& level : wheel)
         {
-            dq[index].second = nullptr;
+            level.fill(npos);
         }
     }
 
-    int add(std::function<void()> f)
+    TimerQueue(const TimerQueue&) = delete;
+    TimerQueue& operator=(const TimerQueue&) = delete;
+
+    TimerId add(std::function<void()> f, std::chrono::milliseconds timeout)
     {
-        dq.push_back(
-            std::make_pair(std::chrono::steady_clock::now(), std::move(f)));
-        int ret = step + dq.size() - 1;
+        uint32_t index;
+        if (freeList != npos)
+        {
+            index = freeList;
+            freeList = nodes[index].next;
+        }
+        else
+        {
+            index = static_cast<uint32_t>(nodes.size());
+            nodes.emplace_back();
+        }
+        Node& node = nodes[index];
+        uint64_t ticks =
+            static_cast<uint64_t>((timeout.count() + resolution().count() - 1) /
+                                  resolution().count());
+        node.expiry = currentTick + (ticks == 0 ? 1 : ticks);
+        node.callback = std::move(f);
+        link(index);
+        activeTimers++;
 
+        TimerId ret = (static_cast<TimerId>(node.generation) << 32) | index;
         BMCWEB_LOG_DEBUG << "timer add inside: " << this << ' ' << ret;
         return ret;
     }
 
-    void process()
+    void cancel(TimerId id)
     {
-        auto now = std::chrono::steady_clock::now();
-        while (!dq.empty())
+        uint32_t index = static_cast<uint32_t>(id & 0xffffffff);
+        uint32_t generation = static_cast<uint32_t>(id >> 32);
+        if (index >= nodes.size())
         {
-            auto& x = dq.front();
-            if (now - x.first < std::chrono::seconds(5))
-            {
-                break;
-            }
-            if (x.second)
+            return;
+        }
+        Node& node = nodes[index];
+        if (!node.linked || node.generation != generation)
+        {
+            return;
+        }
+        unlink(index);
+        release(index);
+    }
+
+    void process(clock::time_point now = clock::now())
+    {
+        if (now < startTime)
+        {
+            return;
+        }
+        uint64_t target = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(now -
+                                                                  startTime)
+                .count() /
+            resolution().count());
+        while (currentTick < target)
+        {
+            if (activeTimers == 0)
             {
-                BMCWEB_LOG_DEBUG << "timer call: " << this << ' ' << step;
-                // we know that timer handlers are very simple currenty; call
-                // here
-                x.second();
+                // Nothing can fire, so there's no need to walk every slot
+                currentTick = target;
+                return;
             }
-            dq.pop_front();
-            step++;
+            advance();
         }
     }
 
+    size_t size() const
+    {
+        return activeTimers;
+    }
+
   private:
-    using storage_type =
-        std::pair<std::chrono::time_point<std::chrono::steady_clock>,
-                  std::function<void()>>;
+    enum : uint32_t
+    {
+        npos = 0xffffffff
+    };
+    static constexpr unsigned slotBits = 6;
+    static constexpr unsigned slotCount = 1U << slotBits;
+    static constexpr unsigned levelCount = 4;
+
+    struct Node
+    {
+        uint64_t expiry{};
+        std::function<void()> callback;
+        uint32_t prev{npos};
+        uint32_t next{npos};
+        uint32_t generation{1};
+        uint8_t level{};
+        uint8_t slot{};
+        bool linked{};
+    };
 
-    boost::circular_buffer_space_optimized<storage_type,
-                                           std::allocator<storage_type>>
-        dq{};
+    void link(uint32_t index)
+    {
+        Node& node = nodes[index];
+        uint64_t delta = node.expiry > currentTick ? node.expiry - currentTick
+                                                   : 0;
+        unsigned level = 0;
+        while (level + 1 < levelCount &&
+               delta >= (uint64_t{1} << (slotBits * (level + 1))))
+        {
+            level++;
+        }
+        uint64_t expiry =
+            node.expiry > currentTick ? node.expiry : currentTick;
+        if (level == levelCount - 1 &&
+            delta >= (uint64_t{1} << (slotBits * levelCount)))
+        {
+            // Beyond the range of the wheel; park it in the furthest slot and
+            // let it cascade down again.
+            expiry = currentTick + (uint64_t{1} << (slotBits * levelCount)) -
+                     1;
+        }
+        unsigned slot = (expiry >> (slotBits * level)) & (slotCount - 1);
+
+        node.level = static_cast<uint8_t>(level);
+        node.slot = static_cast<uint8_t>(slot);
+        node.prev = npos;
+        node.next = wheel[level][slot];
+        if (node.next != npos)
+        {
+            nodes[node.next].prev = index;
+        }
+        wheel[level][slot] = index;
+        node.linked = true;
+    }
+
+    void unlink(uint32_t index)
+    {
+        Node& node = nodes[index];
+        if (node.prev != npos)
+        {
+            nodes[node.prev].next = node.next;
+        }
+        else
+        {
+            wheel[node.level][node.slot] = node.next;
+        }
+        if (node.next != npos)
+        {
+            nodes[node.next].prev = node.prev;
+        }
+        node.linked = false;
+    }
+
+    void release(uint32_t index)
+    {
+        Node& node = nodes[index];
+        node.callback = nullptr;
+        node.generation =
+            node.generation == 0xffffffff ? 1 : node.generation + 1;
+        node.next = freeList;
+        freeList = index;
+        activeTimers--;
+    }
+
+    void advance()
+    {
+        currentTick++;
+
+        // Move timers from the coarser levels down as their slots come due
+        for (unsigned level = 1; level < levelCount; level++)
+        {
+            if ((currentTick & ((uint64_t{1} << (slotBits * level)) - 1)) !=
+                0)
+            {
+                break;
+            }
+            unsigned slot =
+                (currentTick >> (slotBits * level)) & (slotCount - 1);
+            uint32_t index = wheel[level][slot];
+            wheel[level][slot] = npos;
+            while (index != npos)
+            {
+                uint32_t next = nodes[index].next;
+                link(index);
+                index = next;
+            }
+        }
+
+        uint32_t& head = wheel[0][currentTick & (slotCount - 1)];
+        while (head != npos)
+        {
+            uint32_t index = head;
+            unlink(index);
+            std::function<void()> callback =
+                std::move(nodes[index].callback);
+            release(index);
+            BMCWEB_LOG_DEBUG << "timer call: " << this << ' ' << index;
+            // we know that timer handlers are very simple currenty; call here
+            // They may add or cancel timers, which is why the node is
+            // released first and the slot head is re-read every iteration.
+            if (callback)
+            {
+                callback();
+            }
+        }
+    }
 
-    // boost::circular_buffer<storage_type> dq{20};
-    // std::deque<storage_type> dq{};
-    int step{};
+    clock::time_point startTime;
+    uint64_t currentTick{0};
+    size_t activeTimers{0};
+    std::vector<Node> nodes;
+    uint32_t freeList{npos};
+    std::array<std::array<uint32_t, slotCount>, levelCount> wheel;
 };
 } // namespace detail
 } // namespace crow
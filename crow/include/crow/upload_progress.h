@@ -0,0 +1,100 @@
+#pragma once
+#include <atomic>
+#include <boost/container/flat_map.hpp>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace crow
+{
+
+// How far along one streamed request body is.  Written by the connection
+// reading it, read by anything that reports on it.
+struct UploadProgress
+{
+    uint64_t id = 0;
+    std::string url;
+    // Bytes of the body; received reaches it once the body is all in
+    uint64_t total = 0;
+    std::atomic<uint64_t> received{0};
+    std::chrono::system_clock::time_point started;
+};
+
+/**
+ * @brief The streamed bodies being received, on all connections
+ *
+ * An upload is listed for as long as its UploadProgress is held; the
+ * connection holds it until the response to the upload is sent.  Uploads
+ * are only started once the middlewares have let their request through, so
+ * everything listed here was authenticated; TaskService shows them all.
+ */
+class UploadRegistry
+{
+  public:
+    std::shared_ptr<UploadProgress> start(std::string url, uint64_t total)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::shared_ptr<UploadProgress> upload(
+            new UploadProgress, [this](UploadProgress* upload) {
+                remove(upload->id);
+                delete upload;
+            });
+        upload->id = ++lastId;
+        upload->url = std::move(url);
+        upload->total = total;
+        upload->started = std::chrono::system_clock::now();
+        uploads.emplace(upload->id, upload);
+        return upload;
+    }
+
+    // The uploads in progress, oldest first
+    std::vector<std::shared_ptr<const UploadProgress>> active() const
+    {
+        std::vector<std::shared_ptr<const UploadProgress>> result;
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const std::pair<uint64_t, std::weak_ptr<UploadProgress>>&
+                 upload : uploads)
+        {
+            std::shared_ptr<const UploadProgress> held = upload.second.lock();
+            if (held != nullptr)
+            {
+                result.push_back(std::move(held));
+            }
+        }
+        return result;
+    }
+
+    std::shared_ptr<const UploadProgress> find(uint64_t id) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto upload = uploads.find(id);
+        if (upload == uploads.end())
+        {
+            return nullptr;
+        }
+        return upload->second.lock();
+    }
+
+  private:
+    void remove(uint64_t id)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        uploads.erase(id);
+    }
+
+    mutable std::mutex mutex;
+    uint64_t lastId = 0;
+    boost::container::flat_map<uint64_t, std::weak_ptr<UploadProgress>>
+        uploads;
+};
+
+inline UploadRegistry& uploadRegistry()
+{
+    static UploadRegistry registry;
+    return registry;
+}
+
+} // namespace crow
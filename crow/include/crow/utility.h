@@ -1,5 +1,6 @@
 #pragma once
 
+#include "base64_simd.h"
 #include "nlohmann/json.hpp"
 
 #include <boost/utility/string_view.hpp>
@@ -530,6 +531,11 @@ inline static std::string base64encode(
     std::string ret;
     ret.resize((size + 2) / 3 * 4);
     auto it = ret.begin();
+    size_t done = base64_simd::encodeBlocks(
+        reinterpret_cast<const unsigned char*>(data), size, &ret[0], key);
+    data += done;
+    it += static_cast<std::ptrdiff_t>(done / 3 * 4);
+    size -= done;
     while (size >= 3)
     {
         *it++ = key[(((unsigned char)*data) & 0xFC) >> 2];
@@ -568,13 +574,24 @@ inline static std::string base64encodeUrlsafe(const char* data, size_t size)
         "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_");
 }
 
-// TODO this is temporary and should be deleted once base64 is refactored out of
-// crow
-inline bool base64Decode(const boost::string_view input, std::string& output)
+// The most base64Decode can write for inputSize characters
+constexpr size_t base64DecodedSizeMax(size_t inputSize)
 {
-    static const char nop = -1;
-    // See note on encoding_data[] in above function
-    static const char decodingData[] = {
+    return (inputSize + 3) / 4 * 3;
+}
+
+/**
+ * @brief Decodes input into output, which must have room for
+ *        base64DecodedSizeMax(input.size()) bytes
+ *
+ * Decoding stops at the first padding character.  outputSize is set to the
+ * number of bytes written, also when the input is not valid base64.
+ */
+inline bool base64Decode(const boost::string_view input, char* output,
+                         size_t& outputSize)
+{
+    static const uint8_t nop = 0xff;
+    static const uint8_t decodingData[256] = {
         nop, nop, nop, nop, nop, nop, nop, nop, nop, nop, nop, nop, nop, nop,
         nop, nop, nop, nop, nop, nop, nop, nop, nop, nop, nop, nop, nop, nop,
         nop, nop, nop, nop, nop, nop, nop, nop, nop, nop, nop, nop, nop, nop,
@@ -594,76 +611,91 @@ inline bool base64Decode(const boost::string_view input, std::string& output)
         nop, nop, nop, nop, nop, nop, nop, nop, nop, nop, nop, nop, nop, nop,
         nop, nop, nop, nop, nop, nop, nop, nop, nop, nop, nop, nop, nop, nop,
         nop, nop, nop, nop};
+    auto decode = [](char c) {
+        return decodingData[static_cast<unsigned char>(c)];
+    };
 
+    const char* in = input.data();
     size_t inputLength = input.size();
+    char* out = output;
 
-    // allocate space for output string
-    output.clear();
-    output.reserve(((inputLength + 2) / 3) * 4);
-
-    // for each 4-bytes sequence from the input, extract 4 6-bits sequences by
-    // droping first two bits
-    // and regenerate into 3 8-bits sequences
+    size_t done = base64_simd::decodeBlocks(in, inputLength, out);
+    in += done;
+    inputLength -= done;
+    out += done / 4 * 3;
 
-    for (size_t i = 0; i < inputLength; i++)
+    // Whole groups of four, checking all four at once
+    while (inputLength >= 4)
     {
-        char base64code0;
-        char base64code1;
-        char base64code2 = 0; // initialized to 0 to suppress warnings
-        char base64code3;
-
-        base64code0 = decodingData[static_cast<int>(input[i])]; // NOLINT
-        if (base64code0 == nop)
-        { // non base64 character
-            return false;
-        }
-        if (!(++i < inputLength))
-        { // we need at least two input bytes for first
-          // byte output
-            return false;
-        }
-        base64code1 = decodingData[static_cast<int>(input[i])]; // NOLINT
-        if (base64code1 == nop)
-        { // non base64 character
-            return false;
-        }
-        output +=
-            static_cast<char>((base64code0 << 2) | ((base64code1 >> 4) & 0x3));
-
-        if (++i < inputLength)
+        uint8_t base64code0 = decode(in[0]);
+        uint8_t base64code1 = decode(in[1]);
+        uint8_t base64code2 = decode(in[2]);
+        uint8_t base64code3 = decode(in[3]);
+        if ((base64code0 | base64code1 | base64code2 | base64code3) == nop)
         {
-            char c = input[i];
-            if (c == '=')
-            { // padding , end of input
-                return (base64code1 & 0x0f) == 0;
-            }
-            base64code2 = decodingData[static_cast<int>(input[i])]; // NOLINT
-            if (base64code2 == nop)
-            { // non base64 character
-                return false;
-            }
-            output += static_cast<char>(((base64code1 << 4) & 0xf0) |
-                                        ((base64code2 >> 2) & 0x0f));
+            break;
         }
+        *out++ = static_cast<char>((base64code0 << 2) | (base64code1 >> 4));
+        *out++ = static_cast<char>((base64code1 << 4) | (base64code2 >> 2));
+        *out++ = static_cast<char>((base64code2 << 6) | base64code3);
+        in += 4;
+        inputLength -= 4;
+    }
 
-        if (++i < inputLength)
-        {
-            char c = input[i];
-            if (c == '=')
-            { // padding , end of input
-                return (base64code2 & 0x03) == 0;
-            }
-            base64code3 = decodingData[static_cast<int>(input[i])]; // NOLINT
-            if (base64code3 == nop)
-            { // non base64 character
-                return false;
-            }
-            output +=
-                static_cast<char>((((base64code2 << 6) & 0xc0) | base64code3));
-        }
+    // The last group, which may be short or padded, or the invalid one
+    outputSize = static_cast<size_t>(out - output);
+    if (inputLength == 0)
+    {
+        return true;
+    }
+    uint8_t base64code0 = decode(in[0]);
+    if (base64code0 == nop || inputLength < 2)
+    {
+        // we need at least two input bytes for first byte output
+        return false;
     }
+    uint8_t base64code1 = decode(in[1]);
+    if (base64code1 == nop)
+    {
+        return false;
+    }
+    *out++ = static_cast<char>((base64code0 << 2) | (base64code1 >> 4));
+    outputSize++;
+    if (inputLength < 3)
+    {
+        return true;
+    }
+    if (in[2] == '=')
+    { // padding , end of input
+        return (base64code1 & 0x0f) == 0;
+    }
+    uint8_t base64code2 = decode(in[2]);
+    if (base64code2 == nop)
+    {
+        return false;
+    }
+    *out++ = static_cast<char>((base64code1 << 4) | (base64code2 >> 2));
+    outputSize++;
+    if (inputLength < 4)
+    {
+        return true;
+    }
+    if (in[3] == '=')
+    { // padding , end of input
+        return (base64code2 & 0x03) == 0;
+    }
+    // A whole group only stops the loop above when a character in it
+    // isn't base64, and it wasn't one of the first three
+    return false;
+}
 
-    return true;
+inline bool base64Decode(const boost::string_view input, std::string& output)
+{
+    output.resize(base64DecodedSizeMax(input.size()));
+    size_t outputSize = 0;
+    bool valid = base64Decode(input, &output[0], outputSize);
+    output.resize(outputSize);
+    return valid;
 }
 
 } // namespace utility
@@ -1,11 +1,18 @@
 #pragma once
 #include <array>
+#include <atomic>
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/beast/websocket.hpp>
+#include <chrono>
 #include <functional>
+#include <memory>
 
+#include "crow/buffer_budget.h"
 #include "crow/http_request.h"
+#include "crow/priority_scheduler.h"
 #include "crow/socket_adaptors.h"
+#include "crow/timer_queue.h"
+#include "crow/websocket_queue.h"
 
 #ifdef BMCWEB_ENABLE_SSL
 #include <boost/beast/websocket/ssl.hpp>
@@ -15,6 +22,15 @@ namespace crow
 {
 namespace websocket
 {
+// How often a client is pinged, and how long it has to answer before it is
+// cut off, so a client that went away without closing doesn't hold its
+// connection forever.  An interval of 0 sends no pings.
+struct PingPolicy
+{
+    std::chrono::milliseconds interval{30000};
+    std::chrono::milliseconds pongTimeout{10000};
+};
+
 struct Connection : std::enable_shared_from_this<Connection>
 {
   public:
@@ -23,9 +39,27 @@ struct Connection : std::enable_shared_from_this<Connection>
 
     virtual void sendBinary(const boost::beast::string_view msg) = 0;
     virtual void sendBinary(std::string&& msg) = 0;
+    // Sends one binary message made of buffers, without joining them.
+    // owner has to keep what they point to alive.
+    virtual void sendBinary(std::vector<boost::asio::const_buffer> buffers,
+                            std::shared_ptr<const void> owner) = 0;
     virtual void sendText(const boost::beast::string_view msg) = 0;
     virtual void sendText(std::string&& msg) = 0;
+    // Queues a message without copying it, so one encoded message can be
+    // sent to many connections
+    virtual void sendText(std::shared_ptr<const std::string> msg) = 0;
+    // Like sendText, but under the coalesce policy a message still queued
+    // with the same key is replaced by this one instead of being sent too
+    virtual void sendTextUpdate(std::string key,
+                                std::shared_ptr<const std::string> msg) = 0;
+    virtual void sendBinaryUpdate(std::string key,
+                                  std::shared_ptr<const std::string> msg) = 0;
     virtual void close(const boost::beast::string_view msg = "quit") = 0;
+    // Bytes queued and not yet written to the socket, as of the last queue
+    // change; a client that falls behind makes it grow
+    virtual size_t bufferedAmount() const = 0;
+    // The io_service the route handlers run on.  Resources created by a
+    // handler (timers, sockets) should be bound to it.
     virtual boost::asio::io_service& getIoService() = 0;
     virtual ~Connection() = default;
 
@@ -53,89 +87,194 @@ template <typename Adaptor> class ConnectionImpl : public Connection
         std::function<void(Connection&, const std::string&, bool)>
             message_handler,
         std::function<void(Connection&, const std::string&)> close_handler,
-        std::function<void(Connection&)> error_handler) :
+        std::function<void(Connection&)> error_handler,
+        QueueLimits limits = QueueLimits(), bool permessageDeflate = false,
+        PingPolicy ping = PingPolicy()) :
         adaptor(std::move(adaptorIn)),
-        ws(adaptor.socket()), Connection(req),
+        ws(adaptor.socket()), Connection(req), outQueue(limits),
+        pingPolicy(ping),
         openHandler(std::move(open_handler)),
         messageHandler(std::move(message_handler)),
         closeHandler(std::move(close_handler)),
         errorHandler(std::move(error_handler))
     {
         BMCWEB_LOG_DEBUG << "Creating new connection " << this;
+        socketIo = &adaptor.getIoService();
+        handlerIo = req.ioService != nullptr ? req.ioService : socketIo;
+        timerQueue = req.timerQueue;
+        if (permessageDeflate)
+        {
+            // Only used if the client offers it.  A small window keeps the
+            // state of each connection around 24KB; the messages it is meant
+            // for repeat the same property and key names.
+            boost::beast::websocket::permessage_deflate deflate;
+            deflate.server_enable = true;
+            deflate.server_max_window_bits = 12;
+            deflate.compLevel = 6;
+            ws.set_option(deflate);
+        }
     }
 
     boost::asio::io_service& getIoService() override
     {
-        return adaptor.getIoService();
+        return *handlerIo;
     }
 
-    void start()
+    size_t bufferedAmount() const override
     {
-        BMCWEB_LOG_DEBUG << "starting connection " << this;
-
-        boost::string_view protocol = req.getHeaderValue(
-            boost::beast::http::field::sec_websocket_protocol);
+        return buffered;
+    }
 
-        // Perform the websocket upgrade
-        ws.async_accept_ex(
-            req.req,
-            [protocol{std::string(protocol)}](
-                boost::beast::websocket::response_type& m) {
-                if (!protocol.empty())
-                {
-                    m.insert(boost::beast::http::field::sec_websocket_protocol,
-                             protocol);
-                }
-            },
-            [this, self(shared_from_this())](boost::system::error_code ec) {
-                if (ec)
-                {
-                    BMCWEB_LOG_ERROR << "Error in ws.async_accept " << ec;
-                    return;
-                }
-                acceptDone();
-            });
+    void start()
+    {
+        runOnSocketThread([this, self(shared_from_this())] { doAccept(); });
     }
 
     void sendBinary(const boost::beast::string_view msg) override
     {
-        ws.binary(true);
-        outBuffer.emplace_back(msg);
-        doWrite();
+        sendBinary(std::string(msg));
     }
 
     void sendBinary(std::string&& msg) override
     {
-        ws.binary(true);
-        outBuffer.emplace_back(std::move(msg));
-        doWrite();
+        OutboundMessage message;
+        message.payload = std::make_shared<const std::string>(std::move(msg));
+        message.binary = true;
+        send(std::move(message));
+    }
+
+    void sendBinary(std::vector<boost::asio::const_buffer> buffers,
+                    std::shared_ptr<const void> owner) override
+    {
+        OutboundMessage message;
+        message.buffers = std::move(buffers);
+        message.owner = std::move(owner);
+        message.binary = true;
+        send(std::move(message));
     }
 
     void sendText(const boost::beast::string_view msg) override
     {
-        ws.text(true);
-        outBuffer.emplace_back(msg);
-        doWrite();
+        sendText(std::string(msg));
     }
 
     void sendText(std::string&& msg) override
     {
-        ws.text(true);
-        outBuffer.emplace_back(std::move(msg));
-        doWrite();
+        sendText(std::make_shared<const std::string>(std::move(msg)));
+    }
+
+    void sendText(std::shared_ptr<const std::string> msg) override
+    {
+        OutboundMessage message;
+        message.payload = std::move(msg);
+        send(std::move(message));
+    }
+
+    void sendTextUpdate(std::string key,
+                        std::shared_ptr<const std::string> msg) override
+    {
+        OutboundMessage message;
+        message.payload = std::move(msg);
+        message.key = std::move(key);
+        send(std::move(message));
+    }
+
+    void sendBinaryUpdate(std::string key,
+                          std::shared_ptr<const std::string> msg) override
+    {
+        OutboundMessage message;
+        message.payload = std::move(msg);
+        message.binary = true;
+        message.key = std::move(key);
+        send(std::move(message));
     }
 
     void close(const boost::beast::string_view msg) override
     {
-        ws.async_close(
-            boost::beast::websocket::close_code::normal,
+        runOnSocketThread([this, self(shared_from_this())] {
+            ws.async_close(
+                boost::beast::websocket::close_code::normal,
+                [this, self(shared_from_this())](boost::system::error_code ec) {
+                    if (ec)
+                    {
+                        BMCWEB_LOG_ERROR << "Error closing websocket " << ec;
+                        return;
+                    }
+                    adaptor.close();
+                });
+        });
+    }
+
+  private:
+    void send(OutboundMessage&& message)
+    {
+        runOnSocketThread([this, self(shared_from_this()),
+                           message{std::move(message)}]() mutable {
+            if (overflowed)
+            {
+                return;
+            }
+            if (!outQueue.push(std::move(message)))
+            {
+                BMCWEB_LOG_ERROR << "Websocket " << this
+                                 << " isn't keeping up, closing it with "
+                                 << outQueue.bytes() << " bytes queued";
+                overflowed = true;
+                close("Too many messages queued");
+                return;
+            }
+            doWrite();
+            buffered = outQueue.pendingBytes();
+        });
+    }
+
+    // With an io worker pool the socket is serviced by a worker io_service,
+    // while the open/message/close handlers expect to run on the io_service
+    // owning the D-Bus connection (req.ioService).  Without a pool both are
+    // the same io_service and runOnSocketThread() makes plain calls.
+    template <typename F> void runOnSocketThread(F&& f)
+    {
+        if (socketIo == handlerIo)
+        {
+            f();
+            return;
+        }
+        socketIo->post(std::forward<F>(f));
+    }
+
+    // Handlers are interactive work, queued ahead of requests and bulk
+    // transfers waiting on the handler io_service
+    template <typename F> void runOnHandlerThread(F&& f)
+    {
+        postWithPriority(*handlerIo, Priority::interactive,
+                         std::forward<F>(f));
+    }
+
+    void doAccept()
+    {
+        BMCWEB_LOG_DEBUG << "starting connection " << this;
+
+        boost::string_view protocol = req.getHeaderValue(
+            boost::beast::http::field::sec_websocket_protocol);
+
+        // Perform the websocket upgrade
+        ws.async_accept_ex(
+            req.req,
+            [protocol{std::string(protocol)}](
+                boost::beast::websocket::response_type& m) {
+                if (!protocol.empty())
+                {
+                    m.insert(boost::beast::http::field::sec_websocket_protocol,
+                             protocol);
+                }
+            },
             [this, self(shared_from_this())](boost::system::error_code ec) {
                 if (ec)
                 {
-                    BMCWEB_LOG_ERROR << "Error closing websocket " << ec;
+                    BMCWEB_LOG_ERROR << "Error in ws.async_accept " << ec;
                     return;
                 }
-                adaptor.close();
+                acceptDone();
             });
     }
 
@@ -143,10 +282,24 @@ template <typename Adaptor> class ConnectionImpl : public Connection
     {
         BMCWEB_LOG_DEBUG << "Websocket accepted connection";
 
-        if (openHandler)
-        {
-            openHandler(*this);
-        }
+        ws.control_callback([this](boost::beast::websocket::frame_type kind,
+                                   boost::beast::string_view) {
+            if (kind == boost::beast::websocket::frame_type::pong &&
+                awaitingPong)
+            {
+                awaitingPong = false;
+                cancelPingTimer();
+                startPingTimer();
+            }
+        });
+        startPingTimer();
+
+        runOnHandlerThread([this, self(shared_from_this())] {
+            if (openHandler)
+            {
+                openHandler(*this);
+            }
+        });
         doRead();
     }
 
@@ -155,17 +308,22 @@ template <typename Adaptor> class ConnectionImpl : public Connection
         ws.async_read(
             inBuffer, [this, self(shared_from_this())](
                           boost::beast::error_code ec, std::size_t bytes_read) {
+                inShare.update(inBuffer.capacity());
                 if (ec)
                 {
+                    cancelPingTimer();
                     if (ec != boost::beast::websocket::error::closed)
                     {
                         BMCWEB_LOG_ERROR << "doRead error " << ec;
                     }
-                    if (closeHandler)
-                    {
-                        boost::beast::string_view reason = ws.reason().reason;
-                        closeHandler(*this, std::string(reason));
-                    }
+                    boost::beast::string_view reason = ws.reason().reason;
+                    runOnHandlerThread([this, self(shared_from_this()),
+                                        reason{std::string(reason)}] {
+                        if (closeHandler)
+                        {
+                            closeHandler(*this, reason);
+                        }
+                    });
                     return;
                 }
                 if (messageHandler)
@@ -177,59 +335,140 @@ template <typename Adaptor> class ConnectionImpl : public Connection
                         boost::beast::buffers_front(inBuffer.data());
                     boost::beast::string_view message(
                         reinterpret_cast<char const*>(cb.data()), cb.size());
-                    messageHandler(*this, std::string(message), ws.got_text());
+                    runOnHandlerThread([this, self(shared_from_this()),
+                                        message{std::string(message)},
+                                        isText{ws.got_text()}] {
+                        messageHandler(*this, message, isText);
+                    });
                 }
+                // Each read appends, so the message has to go before the
+                // next one
+                inBuffer.consume(inBuffer.size());
+                releaseIdleBuffer(inBuffer, inShare);
                 doRead();
             });
     }
 
-    void doWrite()
+    // The timers hold the connection weakly, and are cancelled once it stops
+    // reading, so they don't keep it around
+    void startPingTimer()
     {
-        // If we're already doing a write, ignore the request, it will be picked
-        // up when the current write is complete
-        if (doingWrite)
+        if (timerQueue == nullptr || pingPolicy.interval.count() == 0)
         {
             return;
         }
-
-        if (outBuffer.empty())
-        {
-            // Done for now
-            return;
-        }
-        doingWrite = true;
-        ws.async_write(
-            boost::asio::buffer(outBuffer.front()),
-            [this, self(shared_from_this())](boost::beast::error_code ec,
-                                             std::size_t bytes_written) {
-                doingWrite = false;
-                outBuffer.erase(outBuffer.begin());
-                if (ec == boost::beast::websocket::error::closed)
+        std::weak_ptr<Connection> weak = shared_from_this();
+        pingTimer = timerQueue->add(
+            [this, weak] {
+                std::shared_ptr<Connection> self = weak.lock();
+                if (self == nullptr)
                 {
-                    // Do nothing here.  doRead handler will call the
-                    // closeHandler.
-                    close("Write error");
                     return;
                 }
-                if (ec)
+                pingTimer = 0;
+                sendPing();
+            },
+            pingPolicy.interval);
+    }
+
+    void sendPing()
+    {
+        awaitingPong = true;
+        ws.async_ping({}, [this, self(shared_from_this())](
+                              boost::beast::error_code ec) {
+            if (ec)
+            {
+                BMCWEB_LOG_DEBUG << "Websocket " << this
+                                 << " ping failed: " << ec;
+            }
+        });
+        std::weak_ptr<Connection> weak = shared_from_this();
+        pingTimer = timerQueue->add(
+            [this, weak] {
+                std::shared_ptr<Connection> self = weak.lock();
+                if (self == nullptr)
                 {
-                    BMCWEB_LOG_ERROR << "Error in ws.async_write " << ec;
                     return;
                 }
-                doWrite();
-            });
+                pingTimer = 0;
+                BMCWEB_LOG_WARNING << "Websocket " << this
+                                   << " didn't answer a ping, closing it";
+                // The pending read fails, which calls the close handler
+                adaptor.close();
+            },
+            pingPolicy.pongTimeout);
+    }
+
+    void cancelPingTimer()
+    {
+        if (pingTimer != 0)
+        {
+            timerQueue->cancel(pingTimer);
+            pingTimer = 0;
+        }
+    }
+
+    void doWrite()
+    {
+        // Nothing is returned while a write is going on; the next message is
+        // picked up when it completes
+        const OutboundMessage* message = outQueue.startWrite();
+        if (message == nullptr)
+        {
+            return;
+        }
+        ws.binary(message->binary);
+        auto onWritten = [this, self(shared_from_this())](
+                             boost::beast::error_code ec,
+                             std::size_t bytes_written) {
+            outQueue.finishWrite();
+            if (ec == boost::beast::websocket::error::closed)
+            {
+                // Do nothing here.  doRead handler will call the
+                // closeHandler.
+                close("Write error");
+                return;
+            }
+            if (ec)
+            {
+                BMCWEB_LOG_ERROR << "Error in ws.async_write " << ec;
+                return;
+            }
+            doWrite();
+        };
+        if (message->payload == nullptr)
+        {
+            ws.async_write(message->buffers, std::move(onWritten));
+            return;
+        }
+        ws.async_write(boost::asio::buffer(*message->payload),
+                       std::move(onWritten));
     }
 
-  private:
     Adaptor adaptor;
+    boost::asio::io_service* socketIo;
+    boost::asio::io_service* handlerIo;
 
     boost::beast::websocket::stream<
         std::add_lvalue_reference_t<typename Adaptor::streamType>>
         ws;
 
-    boost::beast::flat_static_buffer<4096> inBuffer;
-    std::vector<std::string> outBuffer;
-    bool doingWrite = false;
+    // Grows to fit the message being read, up to 4096 bytes, and is freed
+    // once it is handed off if it grew big
+    boost::beast::flat_buffer inBuffer{4096};
+    BufferShare inShare;
+    OutboundQueue outQueue;
+    // Set once the queue overflowed under the disconnect policy
+    bool overflowed = false;
+    // outQueue.pendingBytes(), for the handler thread
+    std::atomic<size_t> buffered{0};
+
+    // Of the socket's io_service; null if the server didn't give one
+    detail::TimerQueue* timerQueue = nullptr;
+    PingPolicy pingPolicy;
+    // The next ping, or the deadline for the pong
+    detail::TimerQueue::TimerId pingTimer = 0;
+    bool awaitingPong = false;
 
     std::function<void(Connection&)> openHandler;
     std::function<void(Connection&, const std::string&, bool)> messageHandler;
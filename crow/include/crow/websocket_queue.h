@@ -0,0 +1,283 @@
+#pragma once
+#include <atomic>
+#include <boost/asio/buffer.hpp>
+#include <boost/circular_buffer.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace crow
+{
+namespace websocket
+{
+
+// What a connection does with a message that doesn't fit under its byte cap
+enum class OverflowPolicy
+{
+    // Drop queued messages, oldest first, until it fits
+    dropOldest,
+    // Replace a queued message with the same key, else drop oldest
+    coalesce,
+    // Close the connection
+    disconnect
+};
+
+struct QueueLimits
+{
+    size_t maxBytes = 1024 * 1024;
+    OverflowPolicy policy = OverflowPolicy::disconnect;
+    // For routes whose messages make up a byte stream: the messages waiting
+    // when a write starts are sent as one, up to this many bytes.  0 writes
+    // every message on its own.
+    size_t batchBytes = 0;
+};
+
+// Totals over all websocket connections
+struct QueueCounters
+{
+    std::atomic<uint64_t> queued{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> coalesced{0};
+    // Messages sent as part of the one before them
+    std::atomic<uint64_t> batched{0};
+    std::atomic<uint64_t> disconnected{0};
+};
+
+inline QueueCounters& queueCounters()
+{
+    static QueueCounters counters;
+    return counters;
+}
+
+struct OutboundMessage
+{
+    std::shared_ptr<const std::string> payload;
+    // A message written straight from several buffers instead of payload,
+    // in order, so that large parts of it are never copied.  owner keeps
+    // the memory they point to alive until the write is done.
+    std::vector<boost::asio::const_buffer> buffers;
+    std::shared_ptr<const void> owner;
+    bool binary = false;
+    // Messages with the same non empty key carry successive values of the
+    // same thing, so a newer one can replace an older one still queued
+    std::string key;
+
+    size_t size() const
+    {
+        if (payload != nullptr)
+        {
+            return payload->size();
+        }
+        return boost::asio::buffer_size(buffers);
+    }
+};
+
+// The messages waiting to be written to one websocket, in a ring buffer.
+// The message being written is held apart from the queue, so that it is
+// never dropped or replaced, and doesn't count towards the byte cap.
+class OutboundQueue
+{
+  public:
+    explicit OutboundQueue(QueueLimits limits = QueueLimits()) :
+        limits(limits), messages(initialCapacity)
+    {
+    }
+
+    /**
+     * @brief Queues a message, applying the overflow policy
+     *
+     * @return false if the connection has to be closed
+     */
+    bool push(OutboundMessage&& message)
+    {
+        size_t size = message.size();
+        if (limits.policy == OverflowPolicy::coalesce && !message.key.empty())
+        {
+            Entry* queued = find(message.key);
+            if (queued != nullptr)
+            {
+                byteCount -= queued->message.size();
+                byteCount += size;
+                queued->message = std::move(message);
+                queueCounters().coalesced++;
+                dropUntilFits(0);
+                return true;
+            }
+        }
+
+        if (byteCount + size > limits.maxBytes)
+        {
+            if (limits.policy == OverflowPolicy::disconnect)
+            {
+                queueCounters().disconnected++;
+                return false;
+            }
+            if (size > limits.maxBytes)
+            {
+                // Wouldn't fit in an empty queue either
+                queueCounters().dropped++;
+                return true;
+            }
+            dropUntilFits(size);
+        }
+
+        if (messages.full())
+        {
+            messages.set_capacity(messages.capacity() * 2);
+        }
+        if (limits.policy == OverflowPolicy::coalesce && !message.key.empty())
+        {
+            keys[message.key] = nextSeq;
+        }
+        messages.push_back(Entry{std::move(message), nextSeq++});
+        byteCount += size;
+        queueCounters().queued++;
+        return true;
+    }
+
+    /**
+     * @brief Takes the next message to write
+     *
+     * @return nullptr if the queue is empty or a write is already going on
+     */
+    const OutboundMessage* startWrite()
+    {
+        if (inFlight || messages.empty())
+        {
+            return nullptr;
+        }
+        current = popFront();
+        inFlight = true;
+        if (limits.batchBytes > 0)
+        {
+            batch();
+        }
+        return &current;
+    }
+
+    void finishWrite()
+    {
+        current = OutboundMessage();
+        inFlight = false;
+    }
+
+    bool writing() const
+    {
+        return inFlight;
+    }
+
+    // Messages waiting, not counting the one being written
+    size_t size() const
+    {
+        return messages.size();
+    }
+
+    size_t bytes() const
+    {
+        return byteCount;
+    }
+
+    // Bytes waiting and being written
+    size_t pendingBytes() const
+    {
+        return byteCount + (inFlight ? current.size() : 0);
+    }
+
+  private:
+    static constexpr size_t initialCapacity = 8;
+
+    struct Entry
+    {
+        OutboundMessage message;
+        // Position of the message in everything ever queued; the entries in
+        // the ring are consecutive, so seq - frontSeq is the index
+        uint64_t seq;
+    };
+
+    Entry* find(const std::string& key)
+    {
+        auto it = keys.find(key);
+        if (it == keys.end())
+        {
+            return nullptr;
+        }
+        return &messages[it->second - frontSeq];
+    }
+
+    OutboundMessage popFront()
+    {
+        Entry& front = messages.front();
+        byteCount -= front.message.size();
+        if (!front.message.key.empty())
+        {
+            auto it = keys.find(front.message.key);
+            if (it != keys.end() && it->second == front.seq)
+            {
+                keys.erase(it);
+            }
+        }
+        OutboundMessage message = std::move(front.message);
+        messages.pop_front();
+        frontSeq++;
+        return message;
+    }
+
+    // Appends the messages that follow current to it, while they are of the
+    // same type and the total stays within batchBytes.  Messages made of
+    // several buffers are left alone; joining them is the copy they avoid.
+    void batch()
+    {
+        if (current.payload == nullptr)
+        {
+            return;
+        }
+        std::string joined;
+        size_t size = current.payload->size();
+        while (!messages.empty())
+        {
+            const OutboundMessage& next = messages.front().message;
+            if (next.payload == nullptr || next.binary != current.binary ||
+                size + next.payload->size() > limits.batchBytes)
+            {
+                break;
+            }
+            size += next.payload->size();
+            if (joined.empty())
+            {
+                joined.reserve(limits.batchBytes);
+                joined = *current.payload;
+            }
+            joined += *popFront().payload;
+            queueCounters().batched++;
+        }
+        if (!joined.empty())
+        {
+            current.payload =
+                std::make_shared<const std::string>(std::move(joined));
+        }
+    }
+
+    void dropUntilFits(size_t size)
+    {
+        while (!messages.empty() && byteCount + size > limits.maxBytes)
+        {
+            popFront();
+            queueCounters().dropped++;
+        }
+    }
+
+    QueueLimits limits;
+    boost::circular_buffer<Entry> messages;
+    std::unordered_map<std::string, uint64_t> keys;
+    uint64_t frontSeq = 0;
+    uint64_t nextSeq = 0;
+    size_t byteCount = 0;
+    OutboundMessage current;
+    bool inFlight = false;
+};
+
+} // namespace websocket
+} // namespace crow
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ast_video
+{
+
+/* Counts down the bands of one batch of tiles, so that the decoder can wait
+ * for all of them before it reuses the batch.
+ */
+class BandGroup
+{
+  public:
+    void start(size_t bands)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        remaining = bands;
+    }
+
+    void finishBand()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--remaining == 0)
+        {
+            done.notify_all();
+        }
+    }
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return remaining == 0; });
+    }
+
+  private:
+    std::mutex mutex;
+    std::condition_variable done;
+    size_t remaining = 0;
+};
+
+/* Threads that run the IDCT and color conversion of a frame's bands for
+ * AstJpegDecoder, while the thread that called decode reads the next tiles
+ * out of the stream.  Shared by every decoder; the threads are started on
+ * first use.  Once stopped, bands run on the thread that posts them.
+ */
+class BandWorkerPool
+{
+  public:
+    BandWorkerPool() = default;
+    BandWorkerPool(const BandWorkerPool &) = delete;
+    BandWorkerPool &operator=(const BandWorkerPool &) = delete;
+
+    ~BandWorkerPool()
+    {
+        stop();
+    }
+
+    // One thread a core; a single core gains nothing from bands
+    static size_t threadCount()
+    {
+        return std::thread::hardware_concurrency();
+    }
+
+    void post(std::function<void()> band)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!stopping)
+            {
+                if (threads.empty())
+                {
+                    startThreads();
+                }
+                queue.emplace_back(std::move(band));
+                wake.notify_one();
+                return;
+            }
+        }
+        band();
+    }
+
+    // Runs the bands still queued, and joins the threads
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            wake.notify_all();
+        }
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+        threads.clear();
+    }
+
+  private:
+    void startThreads()
+    {
+        for (size_t i = 0; i < threadCount(); i++)
+        {
+            threads.emplace_back([this] { run(); });
+        }
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            wake.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (queue.empty())
+            {
+                return;
+            }
+            std::function<void()> band = std::move(queue.front());
+            queue.pop_front();
+            lock.unlock();
+            band();
+            lock.lock();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::function<void()>> queue;
+    std::vector<std::thread> threads;
+    bool stopping = false;
+};
+
+inline BandWorkerPool &bandWorkerPool()
+{
+    static BandWorkerPool pool;
+    return pool;
+}
+
+} // namespace ast_video
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <array>
+#include <ast_jpeg_simd.hpp>
+#include <cstdint>
+
+namespace ast_video
+{
+namespace color
+{
+
+/* The conversion factors, as fractions of 1 << 16.  The Cb or Cr value is
+ * x = i - 128, and the Y value is x = i - 16, for a sample i.
+ */
+constexpr int fix(double x)
+{
+    return static_cast<int>(x * (1 << 16) + 0.5);
+}
+
+/* Cr=>r value is nearest int to 1.597656 * x */
+constexpr int crToRScale = fix(1.597656);
+/* Cb=>b value is nearest int to 2.015625 * x */
+constexpr int cbToBScale = fix(2.015625);
+/* Cr=>g value is scaled-up -0.8125 * x */
+constexpr int crToGScale = -fix(0.8125);
+/* Cb=>g value is scaled-up -0.390625 * x */
+constexpr int cbToGScale = -fix(0.390625);
+constexpr int yScale = fix(1.164);
+
+inline int term(int scale, int x)
+{
+    return (scale * x + (1 << 15)) >> 16;
+}
+
+// Each term of the conversion, for every sample value
+struct ColorTables
+{
+    ColorTables()
+    {
+        int i, x;
+        for (i = 0, x = -128; i < 256; i++, x++)
+        {
+            crToR[i] = term(crToRScale, x);
+            cbToB[i] = term(cbToBScale, x);
+            crToG[i] = term(crToGScale, x);
+            cbToG[i] = term(cbToGScale, x);
+        }
+        for (i = 0, x = -16; i < 256; i++, x++)
+        {
+            y[i] = term(yScale, x);
+        }
+    }
+
+    std::array<int, 256> crToR{};
+    std::array<int, 256> cbToB{};
+    std::array<int, 256> crToG{};
+    std::array<int, 256> cbToG{};
+    std::array<int, 256> y{};
+};
+
+/* Converts count pixels from YCbCr to BGR through the tables, range
+ * limiting with the table fillRangeLimitTable builds.  The fourth byte of
+ * each output pixel is left as it was.  This is the reference the vector
+ * version has to match bit for bit.
+ */
+inline void convertReference(const ColorTables &tables,
+                             const unsigned char *limit,
+                             const unsigned char *y, const unsigned char *cb,
+                             const unsigned char *cr, unsigned char *bgrx,
+                             int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        int luma = tables.y[y[i]];
+        bgrx[i * 4] = limit[luma + tables.cbToB[cb[i]]];
+        bgrx[i * 4 + 1] =
+            limit[luma + tables.cbToG[cb[i]] + tables.crToG[cr[i]]];
+        bgrx[i * 4 + 2] = limit[luma + tables.crToR[cr[i]]];
+    }
+}
+
+#ifdef AST_JPEG_SIMD
+
+namespace detail
+{
+
+using simd::Int32x4;
+
+/* The term for samples i, with x = i - offset.  The offset is folded into
+ * the rounding constant, so that the multiply is by the sample itself, which
+ * fits in 16 bits.
+ */
+inline Int32x4 term(int scale, Int32x4 i, int offset)
+{
+    return simd::shiftRight<16>(simd::mulShort(simd::splat(scale), i) +
+                                simd::splat((1 << 15) - scale * offset));
+}
+
+} // namespace detail
+
+/* Converts eight pixels from YCbCr to BGR, computing the terms the tables
+ * hold and saturating where the reference range limits.
+ */
+inline void convertSimd(const unsigned char *y, const unsigned char *cb,
+                        const unsigned char *cr, unsigned char *bgrx)
+{
+    using simd::Int32x4;
+    Int32x4 ys[2], cbs[2], crs[2];
+    Int32x4 b[2], g[2], r[2];
+    simd::loadBytes(y, ys[0], ys[1]);
+    simd::loadBytes(cb, cbs[0], cbs[1]);
+    simd::loadBytes(cr, crs[0], crs[1]);
+    for (int i = 0; i < 2; i++)
+    {
+        Int32x4 luma = detail::term(yScale, ys[i], 16);
+        b[i] = luma + detail::term(cbToBScale, cbs[i], 128);
+        g[i] = luma + detail::term(cbToGScale, cbs[i], 128) +
+               detail::term(crToGScale, crs[i], 128);
+        r[i] = luma + detail::term(crToRScale, crs[i], 128);
+    }
+    simd::storePixels(bgrx, b, g, r);
+}
+
+#endif
+
+} // namespace color
+} // namespace ast_video
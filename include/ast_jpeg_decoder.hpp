@@ -2,9 +2,16 @@
 
 #include <aspeed/JTABLES.H>
 
+#include <algorithm>
 #include <array>
+#include <ast_jpeg_band_pool.hpp>
+#include <ast_jpeg_color.hpp>
+#include <ast_jpeg_huffman.hpp>
+#include <ast_jpeg_idct.hpp>
 #include <ast_video_types.hpp>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstdint>
 #include <cstring>
 #include <iostream>
@@ -33,6 +40,63 @@ struct RGB
     unsigned char reserved;
 };
 
+/* A tile read out of the stream, waiting for its IDCT and color conversion.
+ * JPEG tiles hold their coefficients, VQ tiles their Y, Cb and Cr samples.
+ */
+struct DecodedTile
+{
+    enum class Kind : uint8_t
+    {
+        jpeg,
+        jpegPass2,
+        vq
+    };
+
+    Kind kind;
+    uint8_t qtSelection;
+    int txb;
+    int tyb;
+    std::array<short, 384> coef;
+    std::array<unsigned char, 192> samples;
+};
+
+// Time AstJpegDecoder::decode took, over all decoders
+struct DecodeStats
+{
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> totalMicroseconds{0};
+    std::atomic<uint64_t> lastMicroseconds{0};
+    std::atomic<uint64_t> maxMicroseconds{0};
+
+    void record(uint64_t microseconds)
+    {
+        frames++;
+        totalMicroseconds += microseconds;
+        lastMicroseconds = microseconds;
+        uint64_t max = maxMicroseconds;
+        while (microseconds > max &&
+               !maxMicroseconds.compare_exchange_weak(max, microseconds))
+        {
+        }
+    }
+};
+
+inline DecodeStats &decodeStats()
+{
+    static DecodeStats stats;
+    return stats;
+}
+
+// Where the time of AstJpegDecoder::decode goes; see profileStages
+struct StageTimes
+{
+    // Reading the stream, Huffman decoding and the VQ colors, and the rest
+    // of decode
+    std::chrono::nanoseconds entropy{0};
+    std::chrono::nanoseconds idct{0};
+    std::chrono::nanoseconds color{0};
+};
+
 enum class JpgBlock
 {
     JPEG_NO_SKIP_CODE = 0x00,
@@ -383,196 +447,26 @@ class AstJpegDecoder
         bytePos += 64;
     }
 
-    void idctTransform(short *coef, uint8_t *data, uint8_t nBlock)
+    void idctTransform(const short *coef, uint8_t *data, uint8_t nBlock)
     {
-#define FIX_1_082392200 ((int)277) /* FIX(1.082392200) */
-#define FIX_1_414213562 ((int)362) /* FIX(1.414213562) */
-#define FIX_1_847759065 ((int)473) /* FIX(1.847759065) */
-#define FIX_2_613125930 ((int)669) /* FIX(2.613125930) */
-
-#define MULTIPLY(var, cons) ((int)((var) * (cons)) >> 8)
-
-        int tmp0, tmp1, tmp2, tmp3, tmp4, tmp5, tmp6, tmp7;
-        int tmp10, tmp11, tmp12, tmp13;
-        int z5, z10, z11, z12, z13;
-        int workspace[64]; /* buffers data between passes */
-
-        short *inptr = coef;
-        long *quantptr;
-        int *wsptr = workspace;
-        unsigned char *outptr;
-        unsigned char *rLimit = rlimitTable + 128;
-        int ctr, dcval, dctsize = 8;
-
-        quantptr = &qt[nBlock][0];
-
-        // Pass 1: process columns from input (inptr), store into work
-        // array(wsptr)
-
-        for (ctr = 8; ctr > 0; ctr--)
-        {
-            /* Due to quantization, we will usually find that many of the input
-             * coefficients are zero, especially the AC terms.  We can exploit
-             * this by short-circuiting the IDCT calculation for any column in
-             * which all the AC terms are zero.  In that case each output is
-             * equal to the DC coefficient (with scale factor as needed). With
-             * typical images and quantization tables, half or more of the
-             * column DCT calculations can be simplified this way.
-             */
-
-            if ((inptr[dctsize * 1] | inptr[dctsize * 2] | inptr[dctsize * 3] |
-                 inptr[dctsize * 4] | inptr[dctsize * 5] | inptr[dctsize * 6] |
-                 inptr[dctsize * 7]) == 0)
-            {
-                /* AC terms all zero */
-                dcval = static_cast<int>(
-                    (inptr[dctsize * 0] * quantptr[dctsize * 0]) >> 16);
-
-                wsptr[dctsize * 0] = dcval;
-                wsptr[dctsize * 1] = dcval;
-                wsptr[dctsize * 2] = dcval;
-                wsptr[dctsize * 3] = dcval;
-                wsptr[dctsize * 4] = dcval;
-                wsptr[dctsize * 5] = dcval;
-                wsptr[dctsize * 6] = dcval;
-                wsptr[dctsize * 7] = dcval;
-
-                inptr++; /* advance pointers to next column */
-                quantptr++;
-                wsptr++;
-                continue;
-            }
-
-            /* Even part */
-
-            tmp0 = (inptr[dctsize * 0] * quantptr[dctsize * 0]) >> 16;
-            tmp1 = (inptr[dctsize * 2] * quantptr[dctsize * 2]) >> 16;
-            tmp2 = (inptr[dctsize * 4] * quantptr[dctsize * 4]) >> 16;
-            tmp3 = (inptr[dctsize * 6] * quantptr[dctsize * 6]) >> 16;
-
-            tmp10 = tmp0 + tmp2; /* phase 3 */
-            tmp11 = tmp0 - tmp2;
-
-            tmp13 = tmp1 + tmp3; /* phases 5-3 */
-            tmp12 = MULTIPLY(tmp1 - tmp3, FIX_1_414213562) - tmp13; /* 2*c4 */
-
-            tmp0 = tmp10 + tmp13; /* phase 2 */
-            tmp3 = tmp10 - tmp13;
-            tmp1 = tmp11 + tmp12;
-            tmp2 = tmp11 - tmp12;
-
-            /* Odd part */
-
-            tmp4 = (inptr[dctsize * 1] * quantptr[dctsize * 1]) >> 16;
-            tmp5 = (inptr[dctsize * 3] * quantptr[dctsize * 3]) >> 16;
-            tmp6 = (inptr[dctsize * 5] * quantptr[dctsize * 5]) >> 16;
-            tmp7 = (inptr[dctsize * 7] * quantptr[dctsize * 7]) >> 16;
-
-            z13 = tmp6 + tmp5; /* phase 6 */
-            z10 = tmp6 - tmp5;
-            z11 = tmp4 + tmp7;
-            z12 = tmp4 - tmp7;
-
-            tmp7 = z11 + z13;                             /* phase 5 */
-            tmp11 = MULTIPLY(z11 - z13, FIX_1_414213562); /* 2*c4 */
-
-            z5 = MULTIPLY(z10 + z12, FIX_1_847759065);    /* 2*c2 */
-            tmp10 = MULTIPLY(z12, FIX_1_082392200) - z5;  /* 2*(c2-c6) */
-            tmp12 = MULTIPLY(z10, -FIX_2_613125930) + z5; /* -2*(c2+c6) */
-
-            tmp6 = tmp12 - tmp7; /* phase 2 */
-            tmp5 = tmp11 - tmp6;
-            tmp4 = tmp10 + tmp5;
-
-            wsptr[dctsize * 0] = (tmp0 + tmp7);
-            wsptr[dctsize * 7] = (tmp0 - tmp7);
-            wsptr[dctsize * 1] = (tmp1 + tmp6);
-            wsptr[dctsize * 6] = (tmp1 - tmp6);
-            wsptr[dctsize * 2] = (tmp2 + tmp5);
-            wsptr[dctsize * 5] = (tmp2 - tmp5);
-            wsptr[dctsize * 4] = (tmp3 + tmp4);
-            wsptr[dctsize * 3] = (tmp3 - tmp4);
-
-            inptr++; /* advance pointers to next column */
-            quantptr++;
-            wsptr++;
-        }
-
-/* Pass 2: process rows from work array, store into output array. */
-/* Note that we must descale the results by a factor of 8 == 2**3, */
-/* and also undo the PASS1_BITS scaling. */
-
-//#define RANGE_MASK 1023; //2 bits wider than legal samples
-#define PASS1_BITS 0
-#define IDESCALE(x, n) ((int)((x) >> (n)))
-
-        wsptr = workspace;
-        for (ctr = 0; ctr < dctsize; ctr++)
-        {
-            outptr = data + ctr * 8;
-
-            /* Rows of zeroes can be exploited in the same way as we did with
-             * columns. However, the column calculation has created many nonzero
-             * AC terms, so the simplification applies less often (typically 5%
-             * to 10% of the time). On machines with very fast multiplication,
-             * it's possible that the test takes more time than it's worth.  In
-             * that case this section may be commented out.
-             */
-            /* Even part */
-
-            tmp10 = (wsptr[0] + wsptr[4]);
-            tmp11 = (wsptr[0] - wsptr[4]);
-
-            tmp13 = (wsptr[2] + wsptr[6]);
-            tmp12 = MULTIPLY((int)wsptr[2] - (int)wsptr[6], FIX_1_414213562) -
-                    tmp13;
-
-            tmp0 = tmp10 + tmp13;
-            tmp3 = tmp10 - tmp13;
-            tmp1 = tmp11 + tmp12;
-            tmp2 = tmp11 - tmp12;
-
-            /* Odd part */
-
-            z13 = wsptr[5] + wsptr[3];
-            z10 = wsptr[5] - wsptr[3];
-            z11 = wsptr[1] + wsptr[7];
-            z12 = wsptr[1] - wsptr[7];
-
-            tmp7 = z11 + z13;                             /* phase 5 */
-            tmp11 = MULTIPLY(z11 - z13, FIX_1_414213562); /* 2*c4 */
-
-            z5 = MULTIPLY(z10 + z12, FIX_1_847759065);    /* 2*c2 */
-            tmp10 = MULTIPLY(z12, FIX_1_082392200) - z5;  /* 2*(c2-c6) */
-            tmp12 = MULTIPLY(z10, -FIX_2_613125930) + z5; /* -2*(c2+c6) */
-
-            tmp6 = tmp12 - tmp7; /* phase 2 */
-            tmp5 = tmp11 - tmp6;
-            tmp4 = tmp10 + tmp5;
-
-            /* Final output stage: scale down by a factor of 8 and range-limit
-             */
-
-            outptr[0] =
-                rLimit[IDESCALE((tmp0 + tmp7), (PASS1_BITS + 3)) & 1023L];
-            outptr[7] =
-                rLimit[IDESCALE((tmp0 - tmp7), (PASS1_BITS + 3)) & 1023L];
-            outptr[1] =
-                rLimit[IDESCALE((tmp1 + tmp6), (PASS1_BITS + 3)) & 1023L];
-            outptr[6] =
-                rLimit[IDESCALE((tmp1 - tmp6), (PASS1_BITS + 3)) & 1023L];
-            outptr[2] =
-                rLimit[IDESCALE((tmp2 + tmp5), (PASS1_BITS + 3)) & 1023L];
-            outptr[5] =
-                rLimit[IDESCALE((tmp2 - tmp5), (PASS1_BITS + 3)) & 1023L];
-            outptr[4] =
-                rLimit[IDESCALE((tmp3 + tmp4), (PASS1_BITS + 3)) & 1023L];
-            outptr[3] =
-                rLimit[IDESCALE((tmp3 - tmp4), (PASS1_BITS + 3)) & 1023L];
-
-            wsptr += dctsize; /* advance pointer to next row */
-        }
+#ifdef AST_JPEG_SIMD
+        idct::idctSimd(coef, idctQuant[nBlock], data);
+#else
+        idct::idctReference(coef, qt[nBlock].data(), rlimitTable + 128, data);
+#endif
+    }
+    // Converts eight pixels to BGR
+    void convertPixels(const unsigned char *y, const unsigned char *cb,
+                       const unsigned char *cr, struct RGB *out)
+    {
+#ifdef AST_JPEG_SIMD
+        color::convertSimd(y, cb, cr, reinterpret_cast<unsigned char *>(out));
+#else
+        color::convertReference(colorTables, rlimitTable, y, cb, cr,
+                                reinterpret_cast<unsigned char *>(out), 8);
+#endif
     }
+
     void yuvToRgb(
         int txb, int tyb,
         unsigned char
@@ -583,8 +477,8 @@ class AstJpegDecoder
     )
     {
         int i, j, pos, m, n;
-        unsigned char cb, cr, *py, *pcb, *pcr, *py420[4];
-        int y;
+        unsigned char *py, *pcb, *pcr;
+        unsigned char cbRow[16], crRow[16];
         struct RGB *pByte;
         int nBlocksInMcu = 6;
         unsigned int pixelX, pixelY;
@@ -602,30 +496,21 @@ class AstJpegDecoder
 
             for (j = 0; j < 8; j++)
             {
+                m = j << 3;
                 for (i = 0; i < 8; i++)
                 {
-                    m = ((j << 3) + i);
-                    y = py[m];
-                    cb = pcb[m];
-                    cr = pcr[m];
                     n = pos + i;
                     // For 2Pass. Save the YUV value
-                    pYUV[n].b = cb;
-                    pYUV[n].g = y;
-                    pYUV[n].r = cr;
-                    pByte[n].b = rlimitTable[mY[y] + mCbToB[cb]];
-                    pByte[n].g = rlimitTable[mY[y] + mCbToG[cb] + mCrToG[cr]];
-                    pByte[n].r = rlimitTable[mY[y] + mCrToR[cr]];
+                    pYUV[n].b = pcb[m + i];
+                    pYUV[n].g = py[m + i];
+                    pYUV[n].r = pcr[m + i];
                 }
+                convertPixels(py + m, pcb + m, pcr + m, pByte + pos);
                 pos += width;
             }
         }
         else
         {
-            for (i = 0; i < nBlocksInMcu - 2; i++)
-            {
-                py420[i] = pYCbCr + i * 64;
-            }
             pcb = pYCbCr + (nBlocksInMcu - 2) * 64;
             pcr = pcb + 64;
 
@@ -635,18 +520,17 @@ class AstJpegDecoder
 
             for (j = 0; j < 16; j++)
             {
+                // Each Cb and Cr sample covers two pixels of two rows
+                m = (j >> 1) << 3;
                 for (i = 0; i < 16; i++)
                 {
-                    //	block number is ((j/8) * 2 + i/8)={0, 1, 2, 3}
-                    y = *(py420[(j >> 3) * 2 + (i >> 3)]++);
-                    m = ((j >> 1) << 3) + (i >> 1);
-                    cb = pcb[m];
-                    cr = pcr[m];
-                    n = pos + i;
-                    pByte[n].b = rlimitTable[mY[y] + mCbToB[cb]];
-                    pByte[n].g = rlimitTable[mY[y] + mCbToG[cb] + mCrToG[cr]];
-                    pByte[n].r = rlimitTable[mY[y] + mCrToR[cr]];
+                    cbRow[i] = pcb[m + (i >> 1)];
+                    crRow[i] = pcr[m + (i >> 1)];
                 }
+                // Y blocks 0 and 1 are the top half, 2 and 3 the bottom
+                py = pYCbCr + (j >> 3) * 128 + (j & 7) * 8;
+                convertPixels(py, cbRow, crRow, pByte + pos);
+                convertPixels(py + 64, cbRow + 8, crRow + 8, pByte + pos + 8);
                 pos += width;
             }
         }
@@ -662,153 +546,85 @@ class AstJpegDecoder
     )
     {
         int i, j, pos, m, n;
-        unsigned char cb, cr, *py, *pcb, *pcr, *py420[4];
-        int y;
-        struct RGB *pByte;
-        int nBlocksInMcu = 6;
-        unsigned int pixelX, pixelY;
+        unsigned char *py, *pcb, *pcr;
+        unsigned char yRow[8], cbRow[8], crRow[8];
 
-        pByte = reinterpret_cast<struct RGB *>(pBgr);
-        if (yuvmode == YuvMode::YUV444)
+        if (yuvmode != YuvMode::YUV444)
         {
-            py = pYCbCr;
-            pcb = pYCbCr + 64;
-            pcr = pcb + 64;
-
-            pixelX = txb * 8;
-            pixelY = tyb * 8;
-            pos = (pixelY * width) + pixelX;
-
-            for (j = 0; j < 8; j++)
-            {
-                for (i = 0; i < 8; i++)
-                {
-                    m = ((j << 3) + i);
-                    n = pos + i;
-                    y = pYUV[n].g + (py[m] - 128);
-                    cb = pYUV[n].b + (pcb[m] - 128);
-                    cr = pYUV[n].r + (pcr[m] - 128);
-                    pYUV[n].b = cb;
-                    pYUV[n].g = y;
-                    pYUV[n].r = cr;
-                    pByte[n].b = rlimitTable[mY[y] + mCbToB[cb]];
-                    pByte[n].g = rlimitTable[mY[y] + mCbToG[cb] + mCrToG[cr]];
-                    pByte[n].r = rlimitTable[mY[y] + mCrToR[cr]];
-                }
-                pos += width;
-            }
+            yuvToRgb(txb, tyb, pYCbCr, pYUV, pBgr);
+            return;
         }
-        else
-        {
-            for (i = 0; i < nBlocksInMcu - 2; i++)
-            {
-                py420[i] = pYCbCr + i * 64;
-            }
-            pcb = pYCbCr + (nBlocksInMcu - 2) * 64;
-            pcr = pcb + 64;
 
-            pixelX = txb * 16;
-            pixelY = tyb * 16;
-            pos = (pixelY * width) + pixelX;
+        py = pYCbCr;
+        pcb = pYCbCr + 64;
+        pcr = pcb + 64;
+        pos = (tyb * 8 * width) + txb * 8;
 
-            for (j = 0; j < 16; j++)
+        for (j = 0; j < 8; j++)
+        {
+            // The second pass holds differences from the first
+            for (i = 0; i < 8; i++)
             {
-                for (i = 0; i < 16; i++)
-                {
-                    //	block number is ((j/8) * 2 + i/8)={0, 1, 2, 3}
-                    y = *(py420[(j >> 3) * 2 + (i >> 3)]++);
-                    m = ((j >> 1) << 3) + (i >> 1);
-                    cb = pcb[m];
-                    cr = pcr[m];
-                    n = pos + i;
-                    pByte[n].b = rlimitTable[mY[y] + mCbToB[cb]];
-                    pByte[n].g = rlimitTable[mY[y] + mCbToG[cb] + mCrToG[cr]];
-                    pByte[n].r = rlimitTable[mY[y] + mCrToR[cr]];
-                }
-                pos += width;
+                m = (j << 3) + i;
+                n = pos + i;
+                yRow[i] = pYUV[n].g + (py[m] - 128);
+                cbRow[i] = pYUV[n].b + (pcb[m] - 128);
+                crRow[i] = pYUV[n].r + (pcr[m] - 128);
+                pYUV[n].b = cbRow[i];
+                pYUV[n].g = yRow[i];
+                pYUV[n].r = crRow[i];
             }
+            convertPixels(yRow, cbRow, crRow,
+                          reinterpret_cast<struct RGB *>(pBgr) + pos);
+            pos += width;
         }
     }
-    void decompress(int txb, int tyb, char *outBuf, uint8_t QT_TableSelection)
+    void decompress(int txb, int tyb, uint8_t QT_TableSelection)
     {
-        unsigned char *ptr;
-        unsigned char byTileYuv[768] = {};
-
-        memset(dctCoeff, 0, 384 * 2);
-        ptr = byTileYuv;
-        processHuffmanDataUnit(ydcNr, yacNr, &dcy, 0);
-        idctTransform(dctCoeff, ptr, QT_TableSelection);
-        ptr += 64;
+        DecodedTile &tile =
+            newTile(DecodedTile::Kind::jpeg, txb, tyb, QT_TableSelection);
+        short *coef = tile.coef.data();
 
+        memset(coef, 0, 384 * 2);
+        processHuffmanDataUnit(ydcNr, yacNr, &dcy, coef);
         if (yuvmode == YuvMode::YUV420)
         {
-            processHuffmanDataUnit(ydcNr, yacNr, &dcy, 64);
-            idctTransform(dctCoeff + 64, ptr, QT_TableSelection);
-            ptr += 64;
-
-            processHuffmanDataUnit(ydcNr, yacNr, &dcy, 128);
-            idctTransform(dctCoeff + 128, ptr, QT_TableSelection);
-            ptr += 64;
-
-            processHuffmanDataUnit(ydcNr, yacNr, &dcy, 192);
-            idctTransform(dctCoeff + 192, ptr, QT_TableSelection);
-            ptr += 64;
-
-            processHuffmanDataUnit(cbDcNr, cbAcNr, &dcCb, 256);
-            idctTransform(dctCoeff + 256, ptr, QT_TableSelection + 1);
-            ptr += 64;
-
-            processHuffmanDataUnit(crDcNr, crAcNr, &dcCr, 320);
-            idctTransform(dctCoeff + 320, ptr, QT_TableSelection + 1);
+            processHuffmanDataUnit(ydcNr, yacNr, &dcy, coef + 64);
+            processHuffmanDataUnit(ydcNr, yacNr, &dcy, coef + 128);
+            processHuffmanDataUnit(ydcNr, yacNr, &dcy, coef + 192);
+            processHuffmanDataUnit(cbDcNr, cbAcNr, &dcCb, coef + 256);
+            processHuffmanDataUnit(crDcNr, crAcNr, &dcCr, coef + 320);
         }
         else
         {
-            processHuffmanDataUnit(cbDcNr, cbAcNr, &dcCb, 64);
-            idctTransform(dctCoeff + 64, ptr, QT_TableSelection + 1);
-            ptr += 64;
-
-            processHuffmanDataUnit(crDcNr, crAcNr, &dcCr, 128);
-            idctTransform(dctCoeff + 128, ptr, QT_TableSelection + 1);
+            processHuffmanDataUnit(cbDcNr, cbAcNr, &dcCb, coef + 64);
+            processHuffmanDataUnit(crDcNr, crAcNr, &dcCr, coef + 128);
         }
-
-        //    yuvToRgb (txb, tyb, byTileYuv, (unsigned char *)outBuf);
-        //  yuvBuffer for YUV record
-        yuvToRgb(txb, tyb, byTileYuv, yuvBuffer.data(),
-                 reinterpret_cast<unsigned char *>(outBuf));
+        queueTile();
     }
 
-    void decompress2Pass(int txb, int tyb, char *outBuf,
-                         uint8_t QT_TableSelection)
+    void decompress2Pass(int txb, int tyb, uint8_t QT_TableSelection)
     {
-        unsigned char *ptr;
-        unsigned char byTileYuv[768];
-        memset(dctCoeff, 0, 384 * 2);
-
-        ptr = byTileYuv;
-        processHuffmanDataUnit(ydcNr, yacNr, &dcy, 0);
-        idctTransform(dctCoeff, ptr, QT_TableSelection);
-        ptr += 64;
-
-        processHuffmanDataUnit(cbDcNr, cbAcNr, &dcCb, 64);
-        idctTransform(dctCoeff + 64, ptr, QT_TableSelection + 1);
-        ptr += 64;
-
-        processHuffmanDataUnit(crDcNr, crAcNr, &dcCr, 128);
-        idctTransform(dctCoeff + 128, ptr, QT_TableSelection + 1);
-
-        yuvToBuffer(txb, tyb, byTileYuv, yuvBuffer.data(),
-                    reinterpret_cast<unsigned char *>(outBuf));
-        //    yuvToRgb (txb, tyb, byTileYuv, (unsigned char *)outBuf);
+        DecodedTile &tile = newTile(DecodedTile::Kind::jpegPass2, txb, tyb,
+                                    QT_TableSelection);
+        short *coef = tile.coef.data();
+
+        memset(coef, 0, 384 * 2);
+        processHuffmanDataUnit(ydcNr, yacNr, &dcy, coef);
+        processHuffmanDataUnit(cbDcNr, cbAcNr, &dcCb, coef + 64);
+        processHuffmanDataUnit(crDcNr, crAcNr, &dcCr, coef + 128);
+        queueTile();
     }
 
-    void vqDecompress(int txb, int tyb, char *outBuf, uint8_t QT_TableSelection,
+    void vqDecompress(int txb, int tyb, uint8_t QT_TableSelection,
                       struct ColorCache *VQ)
     {
         unsigned char *ptr, i;
-        unsigned char byTileYuv[192];
         int data;
 
-        ptr = byTileYuv;
+        DecodedTile &tile =
+            newTile(DecodedTile::Kind::vq, txb, tyb, QT_TableSelection);
+        ptr = tile.samples.data();
         if (VQ->bitMapBits == 0)
         {
             for (i = 0; i < 64; i++)
@@ -823,315 +639,242 @@ class AstJpegDecoder
         {
             for (i = 0; i < 64; i++)
             {
-                data = static_cast<int>(lookKbits(VQ->bitMapBits));
+                data = static_cast<int>(bits.peek(VQ->bitMapBits));
                 ptr[0] = (VQ->color[VQ->index[data]] & 0xFF0000) >> 16;
                 ptr[64] = (VQ->color[VQ->index[data]] & 0x00FF00) >> 8;
                 ptr[128] = VQ->color[VQ->index[data]] & 0x0000FF;
                 ptr += 1;
-                skipKbits(VQ->bitMapBits);
+                bits.skip(VQ->bitMapBits);
             }
         }
-        //    yuvToRgb (txb, tyb, byTileYuv, (unsigned char *)outBuf);
-        yuvToRgb(txb, tyb, byTileYuv, yuvBuffer.data(),
-                 reinterpret_cast<unsigned char *>(outBuf));
+        queueTile();
     }
 
-    void moveBlockIndex()
+    // The IDCT and color conversion of a tile, into outBuffer, and
+    // yuvBuffer for the second pass
+    void finishTile(const DecodedTile &tile)
     {
-        if (yuvmode == YuvMode::YUV444)
+        unsigned char byTileYuv[768];
+        unsigned char *ptr = byTileYuv;
+        const short *coef = tile.coef.data();
+        uint8_t qtY = tile.qtSelection;
+        auto qtC = static_cast<uint8_t>(tile.qtSelection + 1);
+        auto outBuf = reinterpret_cast<unsigned char *>(outBuffer.data());
+        std::chrono::steady_clock::time_point mark;
+        if (stageTimes != nullptr)
         {
-            txb++;
-            if (txb >= static_cast<int>(width / 8))
-            {
-                tyb++;
-                if (tyb >= static_cast<int>(height / 8))
-                {
-                    tyb = 0;
-                }
-                txb = 0;
-            }
+            mark = std::chrono::steady_clock::now();
         }
-        else
+
+        switch (tile.kind)
         {
-            txb++;
-            if (txb >= static_cast<int>(width / 16))
-            {
-                tyb++;
-                if (tyb >= static_cast<int>(height / 16))
+            case DecodedTile::Kind::jpeg:
+                if (yuvmode == YuvMode::YUV420)
                 {
-                    tyb = 0;
+                    for (int block = 0; block < 4; block++)
+                    {
+                        idctTransform(coef + block * 64, ptr + block * 64,
+                                      qtY);
+                    }
+                    idctTransform(coef + 256, ptr + 256, qtC);
+                    idctTransform(coef + 320, ptr + 320, qtC);
                 }
-                txb = 0;
-            }
+                else
+                {
+                    idctTransform(coef, ptr, qtY);
+                    idctTransform(coef + 64, ptr + 64, qtC);
+                    idctTransform(coef + 128, ptr + 128, qtC);
+                }
+                lapStage(mark, &StageTimes::idct);
+                yuvToRgb(tile.txb, tile.tyb, byTileYuv, yuvBuffer.data(),
+                         outBuf);
+                break;
+            case DecodedTile::Kind::jpegPass2:
+                idctTransform(coef, ptr, qtY);
+                idctTransform(coef + 64, ptr + 64, qtC);
+                idctTransform(coef + 128, ptr + 128, qtC);
+                lapStage(mark, &StageTimes::idct);
+                yuvToBuffer(tile.txb, tile.tyb, byTileYuv, yuvBuffer.data(),
+                            outBuf);
+                break;
+            case DecodedTile::Kind::vq:
+                // A YUV420 tile takes 384 bytes; the VQ colors only fill 192
+                memcpy(byTileYuv, tile.samples.data(), tile.samples.size());
+                memset(byTileYuv + tile.samples.size(), 0,
+                       sizeof(byTileYuv) - tile.samples.size());
+                yuvToRgb(tile.txb, tile.tyb, byTileYuv, yuvBuffer.data(),
+                         outBuf);
+                break;
         }
+        lapStage(mark, &StageTimes::color);
     }
 
-    void initColorTable()
+    // Adds the time since mark to a stage, when profiling, and moves mark
+    void lapStage(std::chrono::steady_clock::time_point &mark,
+                  std::chrono::nanoseconds StageTimes::*stage)
     {
-        int i, x;
-        int nScale = 1L << 16; // equal to power(2,16)
-        int nHalf = nScale >> 1;
-
-#define FIX(x) ((int)((x)*nScale + 0.5))
-
-        /* i is the actual input pixel value, in the range 0..MAXJSAMPLE */
-        /* The Cb or Cr value we are thinking of is x = i - CENTERJSAMPLE */
-        /* Cr=>r value is nearest int to 1.597656 * x */
-        /* Cb=>b value is nearest int to 2.015625 * x */
-        /* Cr=>g value is scaled-up -0.8125 * x */
-        /* Cb=>g value is scaled-up -0.390625 * x */
-        for (i = 0, x = -128; i < 256; i++, x++)
-        {
-            mCrToR[i] = (FIX(1.597656) * x + nHalf) >> 16;
-            mCbToB[i] = (FIX(2.015625) * x + nHalf) >> 16;
-            mCrToG[i] = (-FIX(0.8125) * x + nHalf) >> 16;
-            mCbToG[i] = (-FIX(0.390625) * x + nHalf) >> 16;
-        }
-        for (i = 0, x = -16; i < 256; i++, x++)
+        if (stageTimes == nullptr)
         {
-            mY[i] = (FIX(1.164) * x + nHalf) >> 16;
+            return;
         }
-        // For color Text Enchance Y Re-map. Recommend to disable in default
-        /*
-                for (i = 0; i <
-           (VideoEngineInfo->INFData.Gamma1_Gamma2_Seperate); i++) { temp =
-           (double)i / VideoEngineInfo->INFData.Gamma1_Gamma2_Seperate; temp1
-           = 1.0 / VideoEngineInfo->INFData.Gamma1Parameter; mY[i] =
-           (BYTE)(VideoEngineInfo->INFData.Gamma1_Gamma2_Seperate * pow (temp,
-           temp1));
-                        if (mY[i] > 255) mY[i] = 255;
-                }
-                for (i = (VideoEngineInfo->INFData.Gamma1_Gamma2_Seperate); i <
-           256; i++) { mY[i] =
-           (BYTE)((VideoEngineInfo->INFData.Gamma1_Gamma2_Seperate) + (256 -
-           VideoEngineInfo->INFData.Gamma1_Gamma2_Seperate) * ( pow((double)((i
-           - VideoEngineInfo->INFData.Gamma1_Gamma2_Seperate) / (256 -
-           (VideoEngineInfo->INFData.Gamma1_Gamma2_Seperate))), (1.0 /
-           VideoEngineInfo->INFData.Gamma2Parameter)) ));
-                        if (mY[i] > 255) mY[i] = 255;
-                }
-        */
+        std::chrono::steady_clock::time_point now =
+            std::chrono::steady_clock::now();
+        stageTimes->*stage += now - mark;
+        mark = now;
     }
-    void loadHuffmanTable(HuffmanTable *HT, const unsigned char *nrcode,
-                          const unsigned char *value,
-                          const unsigned short int *Huff_code)
+
+    // Whether tiles are finished in bands; profiling needs them serial
+    bool inBands() const
     {
-        unsigned char k, j, i;
-        unsigned int code, codeIndex;
+        return bands != 0 && stageTimes == nullptr;
+    }
 
-        for (j = 1; j <= 16; j++)
-        {
-            HT->length[j] = nrcode[j];
-        }
-        for (i = 0, k = 1; k <= 16; k++)
-        {
-            for (j = 0; j < HT->length[k]; j++)
-            {
-                HT->v[wordHiLo(k, j)] = value[i];
-                i++;
-            }
-        }
+    // Where the next tile read out of the stream goes
+    DecodedTile &newTile(DecodedTile::Kind kind, int txb, int tyb,
+                         uint8_t QT_TableSelection)
+    {
+        DecodedTile &tile =
+            inBands() ? batches[currentBatch][batchUsed] : serialTile;
+        tile.kind = kind;
+        tile.qtSelection = QT_TableSelection;
+        tile.txb = txb;
+        tile.tyb = tyb;
+        return tile;
+    }
 
-        code = 0;
-        for (k = 1; k <= 16; k++)
+    // Finishes the tile newTile returned, now or as part of a batch
+    void queueTile()
+    {
+        if (!inBands())
         {
-            HT->minorCode[k] = static_cast<unsigned short int>(code);
-            for (j = 1; j <= HT->length[k]; j++)
-            {
-                code++;
-            }
-            HT->majorCode[k] = static_cast<unsigned short int>(code - 1);
-            code *= 2;
-            if (HT->length[k] == 0)
-            {
-                HT->minorCode[k] = 0xFFFF;
-                HT->majorCode[k] = 0;
-            }
+            finishTile(serialTile);
+            return;
         }
-
-        HT->len[0] = 2;
-        i = 2;
-
-        for (codeIndex = 1; codeIndex < 65535; codeIndex++)
+        if (++batchUsed == batchTiles())
         {
-            if (codeIndex < Huff_code[i])
-            {
-                HT->len[codeIndex] =
-                    static_cast<unsigned char>(Huff_code[i + 1]);
-            }
-            else
-            {
-                i = i + 2;
-                HT->len[codeIndex] =
-                    static_cast<unsigned char>(Huff_code[i + 1]);
-            }
+            flushBatch();
         }
     }
-    void initJpgTable()
-    {
-        initColorTable();
-        prepareRangeLimitTable();
-        loadHuffmanTable(&htdc[0], stdDcLuminanceNrcodes, stdDcLuminanceValues,
-                         dcLuminanceHuffmancode);
-        loadHuffmanTable(&htac[0], stdAcLuminanceNrcodes, stdAcLuminanceValues,
-                         acLuminanceHuffmancode);
-        loadHuffmanTable(&htdc[1], stdDcChrominanceNrcodes,
-                         stdDcChrominanceValues, dcChrominanceHuffmancode);
-        loadHuffmanTable(&htac[1], stdAcChrominanceNrcodes,
-                         stdAcChrominanceValues, acChrominanceHuffmancode);
-    }
 
-    void prepareRangeLimitTable()
-    /* Allocate and fill in the sample_range_limit table */
+    // Hands the current batch to the workers, once they are done with the
+    // previous one, and starts filling the other
+    void flushBatch()
     {
-        int j;
-        rlimitTable = reinterpret_cast<unsigned char *>(malloc(5 * 256L + 128));
-        /* First segment of "simple" table: limit[x] = 0 for x < 0 */
-        memset((void *)rlimitTable, 0, 256);
-        rlimitTable += 256; /* allow negative subscripts of simple table */
-        /* Main part of "simple" table: limit[x] = x */
-        for (j = 0; j < 256; j++)
+        waitBatch();
+        const std::vector<DecodedTile> *batch = &batches[currentBatch];
+        size_t count = batchUsed;
+        bandGroup.start(bands);
+        for (size_t band = 0; band < bands; band++)
         {
-            rlimitTable[j] = j;
+            bandWorkerPool().post([this, batch, count, band]() {
+                finishBand(*batch, count, band);
+                bandGroup.finishBand();
+            });
         }
-        /* End of simple table, rest of first half of post-IDCT table */
-        for (j = 256; j < 640; j++)
+        batchInFlight = true;
+        currentBatch ^= 1;
+        batchUsed = 0;
+    }
+
+    void waitBatch()
+    {
+        if (batchInFlight)
         {
-            rlimitTable[j] = 255;
+            bandGroup.wait();
+            batchInFlight = false;
         }
+    }
 
-        /* Second half of post-IDCT table */
-        memset((void *)(rlimitTable + 640), 0, 384);
-        for (j = 0; j < 128; j++)
+    /* Finishes the tiles of a batch that lie in one band of rows, in stream
+     * order.  A tile's pixels, and the second pass tiles that refine them,
+     * always fall in the same band, so no two workers touch the same pixel.
+     */
+    void finishBand(const std::vector<DecodedTile> &batch, size_t count,
+                    size_t band)
+    {
+        size_t tileSize = yuvmode == YuvMode::YUV444 ? 8 : 16;
+        size_t rows = std::max<size_t>(height / tileSize, 1);
+        for (size_t i = 0; i < count; i++)
         {
-            rlimitTable[j + 1024] = j;
+            size_t tileBand =
+                std::min(static_cast<size_t>(batch[i].tyb) * bands / rows,
+                         bands - 1);
+            if (tileBand == band)
+            {
+                finishTile(batch[i]);
+            }
         }
     }
 
-    inline unsigned short int wordHiLo(uint8_t byte_high, uint8_t byte_low)
+    static constexpr size_t batchTiles()
     {
-        return (byte_high << 8) + byte_low;
+        return 256;
     }
 
-    // river
-    void processHuffmanDataUnit(uint8_t DC_nr, uint8_t AC_nr,
-                                signed short int *previous_DC,
-                                unsigned short int position)
+    void moveBlockIndex()
     {
-        uint8_t nr = 0;
-        uint8_t k;
-        unsigned short int tmpHcode;
-        uint8_t sizeVal, count0;
-        unsigned short int *minCode;
-        uint8_t *huffValues;
-        uint8_t byteTemp;
-
-        minCode = htdc[DC_nr].minorCode;
-        //   maj_code=htdc[DC_nr].majorCode;
-        huffValues = htdc[DC_nr].v;
-
-        // DC
-        k = htdc[DC_nr].len[static_cast<unsigned short int>(codebuf >> 16)];
-        // river
-        //	 tmp_Hcode=lookKbits(k);
-        tmpHcode = static_cast<unsigned short int>(codebuf >> (32 - k));
-        skipKbits(k);
-        sizeVal = huffValues[wordHiLo(
-            k, static_cast<uint8_t>(tmpHcode - minCode[k]))];
-        if (sizeVal == 0)
+        if (yuvmode == YuvMode::YUV444)
         {
-            dctCoeff[position + 0] = *previous_DC;
+            txb++;
+            if (txb >= static_cast<int>(width / 8))
+            {
+                tyb++;
+                if (tyb >= static_cast<int>(height / 8))
+                {
+                    tyb = 0;
+                }
+                txb = 0;
+            }
         }
         else
         {
-            dctCoeff[position + 0] = *previous_DC + getKbits(sizeVal);
-            *previous_DC = dctCoeff[position + 0];
-        }
-
-        // Second, AC coefficient decoding
-        minCode = htac[AC_nr].minorCode;
-        //   maj_code=htac[AC_nr].majorCode;
-        huffValues = htac[AC_nr].v;
-
-        nr = 1; // AC coefficient
-        do
-        {
-            k = htac[AC_nr].len[static_cast<unsigned short int>(codebuf >> 16)];
-            tmpHcode = static_cast<unsigned short int>(codebuf >> (32 - k));
-            skipKbits(k);
-
-            byteTemp = huffValues[wordHiLo(
-                k, static_cast<uint8_t>(tmpHcode - minCode[k]))];
-            sizeVal = byteTemp & 0xF;
-            count0 = byteTemp >> 4;
-            if (sizeVal == 0)
+            txb++;
+            if (txb >= static_cast<int>(width / 16))
             {
-                if (count0 != 0xF)
+                tyb++;
+                if (tyb >= static_cast<int>(height / 16))
                 {
-                    break;
+                    tyb = 0;
                 }
-                nr += 16;
-            }
-            else
-            {
-                nr += count0; // skip count_0 zeroes
-                dctCoeff[position + dezigzag[nr++]] = getKbits(sizeVal);
+                txb = 0;
             }
-        } while (nr < 64);
-    }
-
-    unsigned short int lookKbits(uint8_t k)
-    {
-        unsigned short int revcode;
-
-        revcode = static_cast<unsigned short int>(codebuf >> (32 - k));
-
-        return (revcode);
+        }
     }
 
-    void skipKbits(uint8_t k)
+    void initJpgTable()
     {
-        unsigned long readbuf;
-
-        if ((newbits - k) <= 0)
-        {
-            readbuf = buffer[bufferIndex];
-            bufferIndex++;
-            codebuf = (codebuf << k) |
-                      ((newbuf | (readbuf >> (newbits))) >> (32 - k));
-            newbuf = readbuf << (k - newbits);
-            newbits = 32 + newbits - k;
-        }
-        else
+        prepareRangeLimitTable();
+        huffman::loadTable(&htdc[0], stdDcLuminanceNrcodes,
+                           stdDcLuminanceValues, dcLuminanceHuffmancode);
+        huffman::loadTable(&htac[0], stdAcLuminanceNrcodes,
+                           stdAcLuminanceValues, acLuminanceHuffmancode);
+        huffman::loadTable(&htdc[1], stdDcChrominanceNrcodes,
+                           stdDcChrominanceValues, dcChrominanceHuffmancode);
+        huffman::loadTable(&htac[1], stdAcChrominanceNrcodes,
+                           stdAcChrominanceValues, acChrominanceHuffmancode);
+        for (size_t i = 0; i < 2; i++)
         {
-            codebuf = (codebuf << k) | (newbuf >> (32 - k));
-            newbuf = newbuf << k;
-            newbits -= k;
+            huffman::buildLookahead(htdc[i], dcLookahead[i]);
+            huffman::buildLookahead(htac[i], acLookahead[i]);
         }
     }
 
-    signed short int getKbits(uint8_t k)
+    void prepareRangeLimitTable()
+    /* Allocate and fill in the sample_range_limit table */
     {
-        signed short int signedWordvalue;
+        rlimitTable = reinterpret_cast<unsigned char *>(malloc(5 * 256L + 128));
+        rlimitTable += 256; /* allow negative subscripts of simple table */
+        idct::fillRangeLimitTable(rlimitTable);
+    }
 
-        // river
-        // signed_wordvalue=lookKbits(k);
-        signedWordvalue = static_cast<unsigned short int>(codebuf >> (32 - k));
-        if (((1L << (k - 1)) & signedWordvalue) == 0)
-        {
-            // neg_pow2 was previously defined as the below.  It seemed silly to
-            // keep a table of values around for something THat's relatively
-            // easy to compute, so it was replaced with the appropriate math
-            // signed_wordvalue = signed_wordvalue - (0xFFFF >> (16 - k));
-            std::array<signed short int, 17> negPow2 = {
-                0,    -1,   -3,    -7,    -15,   -31,   -63,    -127,
-                -255, -511, -1023, -2047, -4095, -8191, -16383, -32767};
-
-            signedWordvalue = signedWordvalue + negPow2[k];
-        }
-        skipKbits(k);
-        return signedWordvalue;
+    void processHuffmanDataUnit(uint8_t DC_nr, uint8_t AC_nr,
+                                signed short int *previous_DC, short *coef)
+    {
+        huffman::decodeBlock(bits, htdc[DC_nr], dcLookahead[DC_nr],
+                             htac[AC_nr], acLookahead[AC_nr], previous_DC,
+                             coef);
     }
+
     int initJpgDecoding()
     {
         bytePos = 0;
@@ -1140,6 +883,12 @@ class AstJpegDecoder
         //  Note: Added for Dual-JPEG
         loadAdvanceQuantTable(qt[2]);
         loadAdvanceQuantTableCb(qt[3]);
+#ifdef AST_JPEG_SIMD
+        for (size_t i = 0; i < qt.size(); i++)
+        {
+            idct::splitQuant(qt[i], idctQuant[i]);
+        }
+#endif
         return 1;
     }
 
@@ -1165,44 +914,47 @@ class AstJpegDecoder
         }
     }
 
-    void updatereadbuf(uint32_t *codebuf, uint32_t *newbuf, int walks,
-                       int *newbits, std::vector<uint32_t> &buffer)
+    /* With bands > 0, reads tiles out of the stream on the calling thread,
+     * and hands their IDCT and color conversion to bandWorkerPool() in that
+     * many horizontal bands; one a core keeps every worker busy.  decode
+     * still returns once the frame is complete.  0 decodes serially.
+     */
+    void setBands(size_t count)
     {
-        unsigned long readbuf;
-
-        if ((*newbits - walks) <= 0)
-        {
-            readbuf = buffer[bufferIndex];
-            bufferIndex++;
-            *codebuf = (*codebuf << walks) |
-                       ((*newbuf | (readbuf >> (*newbits))) >> (32 - walks));
-            *newbuf = readbuf << (walks - *newbits);
-            *newbits = 32 + *newbits - walks;
-        }
-        else
+        bands = count;
+        if (bands != 0)
         {
-            *codebuf = (*codebuf << walks) | (*newbuf >> (32 - walks));
-            *newbuf = *newbuf << walks;
-            *newbits -= walks;
+            for (std::vector<DecodedTile> &batch : batches)
+            {
+                batch.resize(batchTiles());
+            }
         }
     }
 
+    /* Adds the time each stage of the decodes that follow takes to times;
+     * nullptr stops.  Meant for benchmarks: tiles are then finished
+     * serially, and every tile pays for two more clock reads.
+     */
+    void profileStages(StageTimes *times)
+    {
+        stageTimes = times;
+    }
+
     uint32_t decode(std::vector<uint32_t> &bufferVector, unsigned long width,
                     unsigned long height, YuvMode yuvmode_in, int ySelector,
                     int uvSelector)
     {
-        ColorCache decodeColor;
+        std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
         if (width != userWidth || height != userHeight ||
-            yuvmode_in != yuvmode || ySelector != ySelector ||
-            uvSelector != uvSelector)
+            yuvmode_in != yuvmode || ySelector != this->ySelector ||
+            uvSelector != this->uvSelector)
         {
             yuvmode = yuvmode_in;
-            ySelector = ySelector;   // 0-7
-            uvSelector = uvSelector; // 0-7
+            this->ySelector = static_cast<unsigned char>(ySelector); // 0-7
+            this->uvSelector = static_cast<unsigned char>(uvSelector); // 0-7
             userHeight = height;
             userWidth = width;
-            width = width;
-            height = height;
 
             // TODO(ed) Magic number section.  Document appropriately
             advanceSelector = 0; // 0-7
@@ -1230,20 +982,47 @@ class AstJpegDecoder
                     height = height + 8 - (height % 8);
                 }
             }
+            this->width = width;
+            this->height = height;
 
             initJpgDecoding();
         }
-        // TODO(ed) cleanup cruft
-        buffer = bufferVector.data();
-
-        codebuf = bufferVector[0];
-        newbuf = bufferVector[1];
-        bufferIndex = 2;
+        bits.reset(bufferVector.data());
 
         txb = tyb = 0;
-        newbits = 32;
         dcy = dcCb = dcCr = 0;
 
+        std::chrono::nanoseconds finishing{0};
+        if (stageTimes != nullptr)
+        {
+            finishing = -(stageTimes->idct + stageTimes->color);
+        }
+        uint32_t result = decodeTiles(bufferVector);
+        if (inBands())
+        {
+            if (batchUsed != 0)
+            {
+                flushBatch();
+            }
+            waitBatch();
+        }
+        std::chrono::steady_clock::duration elapsed =
+            std::chrono::steady_clock::now() - start;
+        if (stageTimes != nullptr)
+        {
+            finishing += stageTimes->idct + stageTimes->color;
+            stageTimes->entropy += elapsed - finishing;
+        }
+        decodeStats().record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
+                .count()));
+        return result;
+    }
+
+    uint32_t decodeTiles(std::vector<uint32_t> &bufferVector)
+    {
+        ColorCache decodeColor;
+
         static const uint32_t vqHeaderMask = 0x01;
         static const uint32_t vqNoUpdateHeader = 0x00;
         static const uint32_t vqUpdateHeader = 0x01;
@@ -1257,207 +1036,175 @@ class AstJpegDecoder
 
         do
         {
-            auto blockHeader = static_cast<JpgBlock>((codebuf >> 28) & 0xFF);
+            auto blockHeader =
+                static_cast<JpgBlock>((bits.window() >> 28) & 0xFF);
             switch (blockHeader)
             {
                 case JpgBlock::JPEG_NO_SKIP_CODE:
-                    updatereadbuf(&codebuf, &newbuf, blockAsT2100StartLength,
-                                  &newbits, bufferVector);
-                    decompress(txb, tyb,
-                               reinterpret_cast<char *>(outBuffer.data()), 0);
+                    bits.skip(blockAsT2100StartLength);
+                    decompress(txb, tyb, 0);
                     break;
                 case JpgBlock::FRAME_END_CODE:
                     return 0;
                     break;
                 case JpgBlock::JPEG_SKIP_CODE:
 
-                    txb = (codebuf & 0x0FF00000) >> 20;
-                    tyb = (codebuf & 0x0FF000) >> 12;
+                    txb = (bits.window() & 0x0FF00000) >> 20;
+                    tyb = (bits.window() & 0x0FF000) >> 12;
 
-                    updatereadbuf(&codebuf, &newbuf, blockAsT2100SkipLength,
-                                  &newbits, bufferVector);
-                    decompress(txb, tyb,
-                               reinterpret_cast<char *>(outBuffer.data()), 0);
+                    bits.skip(blockAsT2100SkipLength);
+                    decompress(txb, tyb, 0);
                     break;
                 case JpgBlock::VQ_NO_SKIP_1_COLOR_CODE:
-                    updatereadbuf(&codebuf, &newbuf, blockAsT2100StartLength,
-                                  &newbits, bufferVector);
+                    bits.skip(blockAsT2100StartLength);
                     decodeColor.bitMapBits = 0;
 
                     for (int i = 0; i < 1; i++)
                     {
-                        decodeColor.index[i] = ((codebuf >> 29) & vqIndexMask);
-                        if (((codebuf >> 31) & vqHeaderMask) ==
+                        decodeColor.index[i] =
+                            ((bits.window() >> 29) & vqIndexMask);
+                        if (((bits.window() >> 31) & vqHeaderMask) ==
                             vqNoUpdateHeader)
                         {
-                            updatereadbuf(&codebuf, &newbuf, vqNoUpdateLength,
-                                          &newbits, bufferVector);
+                            bits.skip(vqNoUpdateLength);
                         }
                         else
                         {
                             decodeColor.color[decodeColor.index[i]] =
-                                ((codebuf >> 5) & vqColorMask);
-                            updatereadbuf(&codebuf, &newbuf, vqUpdateLength,
-                                          &newbits, bufferVector);
+                                ((bits.window() >> 5) & vqColorMask);
+                            bits.skip(vqUpdateLength);
                         }
                     }
-                    vqDecompress(txb, tyb,
-                                 reinterpret_cast<char *>(outBuffer.data()), 0,
-                                 &decodeColor);
+                    vqDecompress(txb, tyb, 0, &decodeColor);
                     break;
                 case JpgBlock::VQ_SKIP_1_COLOR_CODE:
-                    txb = (codebuf & 0x0FF00000) >> 20;
-                    tyb = (codebuf & 0x0FF000) >> 12;
+                    txb = (bits.window() & 0x0FF00000) >> 20;
+                    tyb = (bits.window() & 0x0FF000) >> 12;
 
-                    updatereadbuf(&codebuf, &newbuf, blockAsT2100SkipLength,
-                                  &newbits, bufferVector);
+                    bits.skip(blockAsT2100SkipLength);
                     decodeColor.bitMapBits = 0;
 
                     for (int i = 0; i < 1; i++)
                     {
-                        decodeColor.index[i] = ((codebuf >> 29) & vqIndexMask);
-                        if (((codebuf >> 31) & vqHeaderMask) ==
+                        decodeColor.index[i] =
+                            ((bits.window() >> 29) & vqIndexMask);
+                        if (((bits.window() >> 31) & vqHeaderMask) ==
                             vqNoUpdateHeader)
                         {
-                            updatereadbuf(&codebuf, &newbuf, vqNoUpdateLength,
-                                          &newbits, bufferVector);
+                            bits.skip(vqNoUpdateLength);
                         }
                         else
                         {
                             decodeColor.color[decodeColor.index[i]] =
-                                ((codebuf >> 5) & vqColorMask);
-                            updatereadbuf(&codebuf, &newbuf, vqUpdateLength,
-                                          &newbits, bufferVector);
+                                ((bits.window() >> 5) & vqColorMask);
+                            bits.skip(vqUpdateLength);
                         }
                     }
-                    vqDecompress(txb, tyb,
-                                 reinterpret_cast<char *>(outBuffer.data()), 0,
-                                 &decodeColor);
+                    vqDecompress(txb, tyb, 0, &decodeColor);
                     break;
 
                 case JpgBlock::VQ_NO_SKIP_2_COLOR_CODE:
-                    updatereadbuf(&codebuf, &newbuf, blockAsT2100StartLength,
-                                  &newbits, bufferVector);
+                    bits.skip(blockAsT2100StartLength);
                     decodeColor.bitMapBits = 1;
 
                     for (int i = 0; i < 2; i++)
                     {
-                        decodeColor.index[i] = ((codebuf >> 29) & vqIndexMask);
-                        if (((codebuf >> 31) & vqHeaderMask) ==
+                        decodeColor.index[i] =
+                            ((bits.window() >> 29) & vqIndexMask);
+                        if (((bits.window() >> 31) & vqHeaderMask) ==
                             vqNoUpdateHeader)
                         {
-                            updatereadbuf(&codebuf, &newbuf, vqNoUpdateLength,
-                                          &newbits, bufferVector);
+                            bits.skip(vqNoUpdateLength);
                         }
                         else
                         {
                             decodeColor.color[decodeColor.index[i]] =
-                                ((codebuf >> 5) & vqColorMask);
-                            updatereadbuf(&codebuf, &newbuf, vqUpdateLength,
-                                          &newbits, bufferVector);
+                                ((bits.window() >> 5) & vqColorMask);
+                            bits.skip(vqUpdateLength);
                         }
                     }
-                    vqDecompress(txb, tyb,
-                                 reinterpret_cast<char *>(outBuffer.data()), 0,
-                                 &decodeColor);
+                    vqDecompress(txb, tyb, 0, &decodeColor);
                     break;
                 case JpgBlock::VQ_SKIP_2_COLOR_CODE:
-                    txb = (codebuf & 0x0FF00000) >> 20;
-                    tyb = (codebuf & 0x0FF000) >> 12;
+                    txb = (bits.window() & 0x0FF00000) >> 20;
+                    tyb = (bits.window() & 0x0FF000) >> 12;
 
-                    updatereadbuf(&codebuf, &newbuf, blockAsT2100SkipLength,
-                                  &newbits, bufferVector);
+                    bits.skip(blockAsT2100SkipLength);
                     decodeColor.bitMapBits = 1;
 
                     for (int i = 0; i < 2; i++)
                     {
-                        decodeColor.index[i] = ((codebuf >> 29) & vqIndexMask);
-                        if (((codebuf >> 31) & vqHeaderMask) ==
+                        decodeColor.index[i] =
+                            ((bits.window() >> 29) & vqIndexMask);
+                        if (((bits.window() >> 31) & vqHeaderMask) ==
                             vqNoUpdateHeader)
                         {
-                            updatereadbuf(&codebuf, &newbuf, vqNoUpdateLength,
-                                          &newbits, bufferVector);
+                            bits.skip(vqNoUpdateLength);
                         }
                         else
                         {
                             decodeColor.color[decodeColor.index[i]] =
-                                ((codebuf >> 5) & vqColorMask);
-                            updatereadbuf(&codebuf, &newbuf, vqUpdateLength,
-                                          &newbits, bufferVector);
+                                ((bits.window() >> 5) & vqColorMask);
+                            bits.skip(vqUpdateLength);
                         }
                     }
-                    vqDecompress(txb, tyb,
-                                 reinterpret_cast<char *>(outBuffer.data()), 0,
-                                 &decodeColor);
+                    vqDecompress(txb, tyb, 0, &decodeColor);
 
                     break;
                 case JpgBlock::VQ_NO_SKIP_4_COLOR_CODE:
-                    updatereadbuf(&codebuf, &newbuf, blockAsT2100StartLength,
-                                  &newbits, bufferVector);
+                    bits.skip(blockAsT2100StartLength);
                     decodeColor.bitMapBits = 2;
 
                     for (unsigned char &i : decodeColor.index)
                     {
-                        i = ((codebuf >> 29) & vqIndexMask);
-                        if (((codebuf >> 31) & vqHeaderMask) ==
+                        i = ((bits.window() >> 29) & vqIndexMask);
+                        if (((bits.window() >> 31) & vqHeaderMask) ==
                             vqNoUpdateHeader)
                         {
-                            updatereadbuf(&codebuf, &newbuf, vqNoUpdateLength,
-                                          &newbits, bufferVector);
+                            bits.skip(vqNoUpdateLength);
                         }
                         else
                         {
                             decodeColor.color[i] =
-                                ((codebuf >> 5) & vqColorMask);
-                            updatereadbuf(&codebuf, &newbuf, vqUpdateLength,
-                                          &newbits, bufferVector);
+                                ((bits.window() >> 5) & vqColorMask);
+                            bits.skip(vqUpdateLength);
                         }
                     }
-                    vqDecompress(txb, tyb,
-                                 reinterpret_cast<char *>(outBuffer.data()), 0,
-                                 &decodeColor);
+                    vqDecompress(txb, tyb, 0, &decodeColor);
 
                     break;
 
                 case JpgBlock::VQ_SKIP_4_COLOR_CODE:
-                    txb = (codebuf & 0x0FF00000) >> 20;
-                    tyb = (codebuf & 0x0FF000) >> 12;
+                    txb = (bits.window() & 0x0FF00000) >> 20;
+                    tyb = (bits.window() & 0x0FF000) >> 12;
 
-                    updatereadbuf(&codebuf, &newbuf, blockAsT2100SkipLength,
-                                  &newbits, bufferVector);
+                    bits.skip(blockAsT2100SkipLength);
                     decodeColor.bitMapBits = 2;
 
                     for (unsigned char &i : decodeColor.index)
                     {
-                        i = ((codebuf >> 29) & vqIndexMask);
-                        if (((codebuf >> 31) & vqHeaderMask) ==
+                        i = ((bits.window() >> 29) & vqIndexMask);
+                        if (((bits.window() >> 31) & vqHeaderMask) ==
                             vqNoUpdateHeader)
                         {
-                            updatereadbuf(&codebuf, &newbuf, vqNoUpdateLength,
-                                          &newbits, bufferVector);
+                            bits.skip(vqNoUpdateLength);
                         }
                         else
                         {
                             decodeColor.color[i] =
-                                ((codebuf >> 5) & vqColorMask);
-                            updatereadbuf(&codebuf, &newbuf, vqUpdateLength,
-                                          &newbits, bufferVector);
+                                ((bits.window() >> 5) & vqColorMask);
+                            bits.skip(vqUpdateLength);
                         }
                     }
-                    vqDecompress(txb, tyb,
-                                 reinterpret_cast<char *>(outBuffer.data()), 0,
-                                 &decodeColor);
+                    vqDecompress(txb, tyb, 0, &decodeColor);
 
                     break;
                 case JpgBlock::JPEG_SKIP_PASS2_CODE:
-                    txb = (codebuf & 0x0FF00000) >> 20;
-                    tyb = (codebuf & 0x0FF000) >> 12;
+                    txb = (bits.window() & 0x0FF00000) >> 20;
+                    tyb = (bits.window() & 0x0FF000) >> 12;
 
-                    updatereadbuf(&codebuf, &newbuf, blockAsT2100SkipLength,
-                                  &newbits, bufferVector);
-                    decompress2Pass(txb, tyb,
-                                    reinterpret_cast<char *>(outBuffer.data()),
-                                    2);
+                    bits.skip(blockAsT2100SkipLength);
+                    decompress2Pass(txb, tyb, 2);
 
                     break;
                 default:
@@ -1467,7 +1214,7 @@ class AstJpegDecoder
             }
             moveBlockIndex();
 
-        } while (bufferIndex <= bufferVector.size());
+        } while (bits.index() <= bufferVector.size());
 
         return -1;
     }
@@ -1509,24 +1256,24 @@ class AstJpegDecoder
 
     // quantization tables, no more than 4 quantization tables
     std::array<std::array<long, 64>, 4> qt{};
+#ifdef AST_JPEG_SIMD
+    // qt, as the vector IDCT takes it
+    std::array<idct::Quant, 4> idctQuant{};
+#endif
 
     // DC huffman tables , no more than 4 (0..3)
     std::array<HuffmanTable, 4> htdc{};
     // AC huffman tables (0..3)
     std::array<HuffmanTable, 4> htac{};
-    std::array<int, 256> mCrToR{};
-    std::array<int, 256> mCbToB{};
-    std::array<int, 256> mCrToG{};
-    std::array<int, 256> mCbToG{};
-    std::array<int, 256> mY{};
-    unsigned long bufferIndex{};
-    uint32_t codebuf{}, newbuf{}, readbuf{};
+    // htdc and htac, for the first lookahead bits of each code
+    std::array<huffman::Lookahead, 4> dcLookahead{};
+    std::array<huffman::Lookahead, 4> acLookahead{};
+    huffman::BitReader bits;
+    color::ColorTables colorTables;
     const unsigned char *stdLuminanceQt{};
     const uint8_t *stdChrominanceQt{};
 
     signed short int dcy{}, dcCb{}, dcCr{}; // Coeficientii DC pentru Y,Cb,Cr
-    signed short int dctCoeff[384]{};
-    // std::vector<signed short int> dctCoeff;  // Current DCT_coefficients
     // quantization table number for Y, Cb, Cr
     uint8_t yqNr = 0, cbQNr = 1, crQNr = 1;
     // DC Huffman table number for Y,Cb, Cr
@@ -1535,11 +1282,19 @@ class AstJpegDecoder
     uint8_t yacNr = 0, cbAcNr = 1, crAcNr = 1;
     int txb = 0;
     int tyb = 0;
-    int newbits{};
     uint8_t *rlimitTable{};
     std::vector<RGB> yuvBuffer;
-    // TODO(ed) this shouldn't exist.  It is cruft that needs cleaning up
-    uint32_t *buffer{};
+
+    // The tile being decoded, when not decoding in bands
+    DecodedTile serialTile{};
+    size_t bands = 0;
+    // One batch fills while the workers finish the other
+    std::array<std::vector<DecodedTile>, 2> batches;
+    size_t currentBatch = 0;
+    size_t batchUsed = 0;
+    bool batchInFlight = false;
+    BandGroup bandGroup;
+    StageTimes *stageTimes = nullptr;
 
   public:
     std::vector<RGB> outBuffer;
@@ -0,0 +1,356 @@
+#pragma once
+
+#include <aspeed/JTABLES.H>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace ast_video
+{
+namespace huffman
+{
+
+/* Reads the video engine's stream, most significant bit first, out of 32 bit
+ * words.  The bits go through a 64 bit reservoir that is refilled a word at a
+ * time, and always holds more than 32 of them, so that the next 32 can be
+ * looked at without a refill.
+ */
+class BitReader
+{
+  public:
+    void reset(const uint32_t *stream)
+    {
+        words = stream;
+        bits = (static_cast<uint64_t>(words[0]) << 32) | words[1];
+        count = 64;
+        next = 2;
+    }
+
+    // The next 32 bits
+    uint32_t window() const
+    {
+        return static_cast<uint32_t>(bits >> 32);
+    }
+
+    // The next k bits, 1 <= k <= 32
+    uint32_t peek(int k) const
+    {
+        return static_cast<uint32_t>(bits >> (64 - k));
+    }
+
+    // Drops k bits, k <= 32
+    void skip(int k)
+    {
+        bits <<= k;
+        count -= k;
+        if (count <= 32)
+        {
+            bits |= static_cast<uint64_t>(words[next++]) << (32 - count);
+            count += 32;
+        }
+    }
+
+    // The index of the next word to be loaded
+    size_t index() const
+    {
+        return next;
+    }
+
+  private:
+    const uint32_t *words = nullptr;
+    uint64_t bits = 0;
+    int count = 0;
+    size_t next = 0;
+};
+
+// Builds a table from the number of codes of each length, their values, and
+// the first 16 bit window of each code length
+inline void loadTable(HuffmanTable *HT, const unsigned char *nrcode,
+                      const unsigned char *value,
+                      const unsigned short int *Huff_code)
+{
+    unsigned char k, j, i;
+    unsigned int code, codeIndex;
+
+    for (j = 1; j <= 16; j++)
+    {
+        HT->length[j] = nrcode[j];
+    }
+    for (i = 0, k = 1; k <= 16; k++)
+    {
+        for (j = 0; j < HT->length[k]; j++)
+        {
+            HT->v[(k << 8) + j] = value[i];
+            i++;
+        }
+    }
+
+    code = 0;
+    for (k = 1; k <= 16; k++)
+    {
+        HT->minorCode[k] = static_cast<unsigned short int>(code);
+        for (j = 1; j <= HT->length[k]; j++)
+        {
+            code++;
+        }
+        HT->majorCode[k] = static_cast<unsigned short int>(code - 1);
+        code *= 2;
+        if (HT->length[k] == 0)
+        {
+            HT->minorCode[k] = 0xFFFF;
+            HT->majorCode[k] = 0;
+        }
+    }
+
+    HT->len[0] = 2;
+    i = 2;
+
+    for (codeIndex = 1; codeIndex < 65535; codeIndex++)
+    {
+        if (codeIndex < Huff_code[i])
+        {
+            HT->len[codeIndex] =
+                static_cast<unsigned char>(Huff_code[i + 1]);
+        }
+        else
+        {
+            i = i + 2;
+            HT->len[codeIndex] =
+                static_cast<unsigned char>(Huff_code[i + 1]);
+        }
+    }
+}
+
+/* Bits of stream a lookahead table decodes at once.  Every code of the
+ * standard DC tables, and the codes of the common AC symbols, fit.
+ */
+constexpr int lookaheadBits = 10;
+
+struct LookaheadEntry
+{
+    // Bits taken by the code; 0 if it is longer than the lookahead
+    uint8_t codeLength;
+    // Bits taken by the code and the coefficient bits that follow it; 0 if
+    // they don't all fit in the lookahead
+    uint8_t length;
+    // High nibble = nr of previous 0 coefficients, low nibble = size of the
+    // coefficient
+    uint8_t symbol;
+    // The coefficient (the DC difference for DC tables), when length isn't 0
+    int16_t value;
+};
+
+using Lookahead = std::array<LookaheadEntry, 1 << lookaheadBits>;
+
+// The coefficient that the size bits after a code stand for
+inline int extend(uint32_t bits, int size)
+{
+    if (bits < (1U << (size - 1)))
+    {
+        return static_cast<int>(bits) - (1 << size) + 1;
+    }
+    return static_cast<int>(bits);
+}
+
+/* Fills a lookahead table from a table loadTable built.  Each entry
+ * decodes what the stream starting with its index holds: the symbol, and
+ * the coefficient after it, if both fit.
+ */
+inline void buildLookahead(const HuffmanTable &table, Lookahead &lookahead)
+{
+    constexpr uint32_t spread = 1U << (16 - lookaheadBits);
+    for (uint32_t prefix = 0; prefix < lookahead.size(); prefix++)
+    {
+        LookaheadEntry &entry = lookahead[prefix];
+        entry = LookaheadEntry{0, 0, 0, 0};
+
+        // The code is resolved if every window starting with the prefix
+        // has the same length
+        uint32_t first = prefix * spread;
+        int k = table.len[first];
+        if (k == 0 || k > lookaheadBits)
+        {
+            continue;
+        }
+        bool resolved = true;
+        for (uint32_t window = first + 1; window < first + spread; window++)
+        {
+            if (table.len[window] != k)
+            {
+                resolved = false;
+                break;
+            }
+        }
+        if (!resolved)
+        {
+            continue;
+        }
+
+        uint32_t code = prefix >> (lookaheadBits - k);
+        entry.codeLength = static_cast<uint8_t>(k);
+        entry.symbol = table.v[(k << 8) + static_cast<uint8_t>(
+                                              code - table.minorCode[k])];
+        int size = entry.symbol & 0xF;
+        if (k + size <= lookaheadBits)
+        {
+            entry.length = static_cast<uint8_t>(k + size);
+            if (size != 0)
+            {
+                uint32_t bits =
+                    (prefix >> (lookaheadBits - k - size)) & ((1U << size) - 1);
+                entry.value = static_cast<int16_t>(extend(bits, size));
+            }
+        }
+    }
+}
+
+// Decodes a symbol through the full tables
+inline uint8_t decodeSymbol(BitReader &bits, const HuffmanTable &table)
+{
+    int k = table.len[bits.window() >> 16];
+    if (k == 0)
+    {
+        // Not a code of the table; take the same bits the smallest code would
+        k = 1;
+    }
+    auto code = static_cast<uint16_t>(bits.peek(k));
+    bits.skip(k);
+    return table.v[(k << 8) + static_cast<uint8_t>(code - table.minorCode[k])];
+}
+
+// Reads the size bits of a coefficient
+inline int16_t readCoefficient(BitReader &bits, int size)
+{
+    auto value = static_cast<int16_t>(extend(bits.peek(size), size));
+    bits.skip(size);
+    return value;
+}
+
+/* Decodes the coefficients of one block, a code and then its coefficient
+ * bits at a time, through the full tables.  This is the reference the
+ * lookahead decoder has to match.  coef has to be zeroed.
+ */
+inline void decodeBlockReference(BitReader &bits, const HuffmanTable &dcTable,
+                                 const HuffmanTable &acTable,
+                                 int16_t *previousDc, int16_t *coef)
+{
+    int size = decodeSymbol(bits, dcTable);
+    if (size == 0)
+    {
+        coef[0] = *previousDc;
+    }
+    else
+    {
+        coef[0] = static_cast<int16_t>(*previousDc +
+                                       readCoefficient(bits, size));
+        *previousDc = coef[0];
+    }
+
+    int nr = 1;
+    do
+    {
+        uint8_t symbol = decodeSymbol(bits, acTable);
+        size = symbol & 0xF;
+        int count0 = symbol >> 4;
+        if (size == 0)
+        {
+            if (count0 != 0xF)
+            {
+                break;
+            }
+            nr += 16;
+        }
+        else
+        {
+            nr += count0; // skip count_0 zeroes
+            coef[dezigzag[nr++]] = readCoefficient(bits, size);
+        }
+    } while (nr < 64);
+}
+
+/* Decodes the coefficients of one block, looking up a symbol and its
+ * coefficient in one step where the lookahead resolves both, and falling
+ * back to the full tables where it doesn't.  coef has to be zeroed.
+ */
+inline void decodeBlock(BitReader &bits, const HuffmanTable &dcTable,
+                        const Lookahead &dcLookahead,
+                        const HuffmanTable &acTable,
+                        const Lookahead &acLookahead, int16_t *previousDc,
+                        int16_t *coef)
+{
+    const LookaheadEntry *entry = &dcLookahead[bits.peek(lookaheadBits)];
+    if (entry->length != 0)
+    {
+        bits.skip(entry->length);
+        coef[0] = static_cast<int16_t>(*previousDc + entry->value);
+    }
+    else
+    {
+        int size;
+        if (entry->codeLength != 0)
+        {
+            bits.skip(entry->codeLength);
+            size = entry->symbol;
+        }
+        else
+        {
+            size = decodeSymbol(bits, dcTable);
+        }
+        coef[0] = *previousDc;
+        if (size != 0)
+        {
+            coef[0] = static_cast<int16_t>(*previousDc +
+                                           readCoefficient(bits, size));
+        }
+    }
+    *previousDc = coef[0];
+
+    int nr = 1;
+    do
+    {
+        entry = &acLookahead[bits.peek(lookaheadBits)];
+        uint8_t symbol;
+        int16_t value;
+        if (entry->length != 0)
+        {
+            bits.skip(entry->length);
+            symbol = entry->symbol;
+            value = entry->value;
+        }
+        else
+        {
+            if (entry->codeLength != 0)
+            {
+                bits.skip(entry->codeLength);
+                symbol = entry->symbol;
+            }
+            else
+            {
+                symbol = decodeSymbol(bits, acTable);
+            }
+            value = 0;
+            if ((symbol & 0xF) != 0)
+            {
+                value = readCoefficient(bits, symbol & 0xF);
+            }
+        }
+
+        if ((symbol & 0xF) == 0)
+        {
+            if (symbol != 0xF0)
+            {
+                break;
+            }
+            nr += 16;
+        }
+        else
+        {
+            nr += symbol >> 4; // skip the zeroes before the coefficient
+            coef[dezigzag[nr++]] = value;
+        }
+    } while (nr < 64);
+}
+
+} // namespace huffman
+} // namespace ast_video
@@ -0,0 +1,420 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#include <ast_jpeg_simd.hpp>
+
+namespace ast_video
+{
+namespace idct
+{
+
+/* Fills the sample range limit table.  limit has to allow subscripts from
+ * -256 to 1151; the IDCT looks up (limit + 128)[x & 1023].
+ */
+inline void fillRangeLimitTable(unsigned char *limit)
+{
+    int j;
+    /* First segment of "simple" table: limit[x] = 0 for x < 0 */
+    memset(limit - 256, 0, 256);
+    /* Main part of "simple" table: limit[x] = x */
+    for (j = 0; j < 256; j++)
+    {
+        limit[j] = j;
+    }
+    /* End of simple table, rest of first half of post-IDCT table */
+    for (j = 256; j < 640; j++)
+    {
+        limit[j] = 255;
+    }
+
+    /* Second half of post-IDCT table */
+    memset(limit + 640, 0, 384);
+    for (j = 0; j < 128; j++)
+    {
+        limit[j + 1024] = j;
+    }
+}
+
+/* Scalar integer IDCT of one 8x8 block, short-circuiting columns without AC
+ * terms.  This is the reference the vector version has to match bit for bit.
+ */
+inline void idctReference(const short *coef, const long *quant,
+                          const unsigned char *rLimit, unsigned char *data)
+{
+#define FIX_1_082392200 ((int)277) /* FIX(1.082392200) */
+#define FIX_1_414213562 ((int)362) /* FIX(1.414213562) */
+#define FIX_1_847759065 ((int)473) /* FIX(1.847759065) */
+#define FIX_2_613125930 ((int)669) /* FIX(2.613125930) */
+
+#define MULTIPLY(var, cons) ((int)((var) * (cons)) >> 8)
+
+    int tmp0, tmp1, tmp2, tmp3, tmp4, tmp5, tmp6, tmp7;
+    int tmp10, tmp11, tmp12, tmp13;
+    int z5, z10, z11, z12, z13;
+    int workspace[64]; /* buffers data between passes */
+
+    const short *inptr = coef;
+    const long *quantptr = quant;
+    int *wsptr = workspace;
+    unsigned char *outptr;
+    int ctr, dcval, dctsize = 8;
+
+    // Pass 1: process columns from input (inptr), store into work
+    // array(wsptr)
+
+    for (ctr = 8; ctr > 0; ctr--)
+    {
+        /* Due to quantization, we will usually find that many of the input
+         * coefficients are zero, especially the AC terms.  We can exploit
+         * this by short-circuiting the IDCT calculation for any column in
+         * which all the AC terms are zero.  In that case each output is
+         * equal to the DC coefficient (with scale factor as needed). With
+         * typical images and quantization tables, half or more of the
+         * column DCT calculations can be simplified this way.
+         */
+
+        if ((inptr[dctsize * 1] | inptr[dctsize * 2] | inptr[dctsize * 3] |
+             inptr[dctsize * 4] | inptr[dctsize * 5] | inptr[dctsize * 6] |
+             inptr[dctsize * 7]) == 0)
+        {
+            /* AC terms all zero */
+            dcval = static_cast<int>(
+                (inptr[dctsize * 0] * quantptr[dctsize * 0]) >> 16);
+
+            wsptr[dctsize * 0] = dcval;
+            wsptr[dctsize * 1] = dcval;
+            wsptr[dctsize * 2] = dcval;
+            wsptr[dctsize * 3] = dcval;
+            wsptr[dctsize * 4] = dcval;
+            wsptr[dctsize * 5] = dcval;
+            wsptr[dctsize * 6] = dcval;
+            wsptr[dctsize * 7] = dcval;
+
+            inptr++; /* advance pointers to next column */
+            quantptr++;
+            wsptr++;
+            continue;
+        }
+
+        /* Even part */
+
+        tmp0 = (inptr[dctsize * 0] * quantptr[dctsize * 0]) >> 16;
+        tmp1 = (inptr[dctsize * 2] * quantptr[dctsize * 2]) >> 16;
+        tmp2 = (inptr[dctsize * 4] * quantptr[dctsize * 4]) >> 16;
+        tmp3 = (inptr[dctsize * 6] * quantptr[dctsize * 6]) >> 16;
+
+        tmp10 = tmp0 + tmp2; /* phase 3 */
+        tmp11 = tmp0 - tmp2;
+
+        tmp13 = tmp1 + tmp3; /* phases 5-3 */
+        tmp12 = MULTIPLY(tmp1 - tmp3, FIX_1_414213562) - tmp13; /* 2*c4 */
+
+        tmp0 = tmp10 + tmp13; /* phase 2 */
+        tmp3 = tmp10 - tmp13;
+        tmp1 = tmp11 + tmp12;
+        tmp2 = tmp11 - tmp12;
+
+        /* Odd part */
+
+        tmp4 = (inptr[dctsize * 1] * quantptr[dctsize * 1]) >> 16;
+        tmp5 = (inptr[dctsize * 3] * quantptr[dctsize * 3]) >> 16;
+        tmp6 = (inptr[dctsize * 5] * quantptr[dctsize * 5]) >> 16;
+        tmp7 = (inptr[dctsize * 7] * quantptr[dctsize * 7]) >> 16;
+
+        z13 = tmp6 + tmp5; /* phase 6 */
+        z10 = tmp6 - tmp5;
+        z11 = tmp4 + tmp7;
+        z12 = tmp4 - tmp7;
+
+        tmp7 = z11 + z13;                             /* phase 5 */
+        tmp11 = MULTIPLY(z11 - z13, FIX_1_414213562); /* 2*c4 */
+
+        z5 = MULTIPLY(z10 + z12, FIX_1_847759065);    /* 2*c2 */
+        tmp10 = MULTIPLY(z12, FIX_1_082392200) - z5;  /* 2*(c2-c6) */
+        tmp12 = MULTIPLY(z10, -FIX_2_613125930) + z5; /* -2*(c2+c6) */
+
+        tmp6 = tmp12 - tmp7; /* phase 2 */
+        tmp5 = tmp11 - tmp6;
+        tmp4 = tmp10 + tmp5;
+
+        wsptr[dctsize * 0] = (tmp0 + tmp7);
+        wsptr[dctsize * 7] = (tmp0 - tmp7);
+        wsptr[dctsize * 1] = (tmp1 + tmp6);
+        wsptr[dctsize * 6] = (tmp1 - tmp6);
+        wsptr[dctsize * 2] = (tmp2 + tmp5);
+        wsptr[dctsize * 5] = (tmp2 - tmp5);
+        wsptr[dctsize * 4] = (tmp3 + tmp4);
+        wsptr[dctsize * 3] = (tmp3 - tmp4);
+
+        inptr++; /* advance pointers to next column */
+        quantptr++;
+        wsptr++;
+    }
+
+/* Pass 2: process rows from work array, store into output array. */
+/* Note that we must descale the results by a factor of 8 == 2**3, */
+/* and also undo the PASS1_BITS scaling. */
+
+//#define RANGE_MASK 1023; //2 bits wider than legal samples
+#define PASS1_BITS 0
+#define IDESCALE(x, n) ((int)((x) >> (n)))
+
+    wsptr = workspace;
+    for (ctr = 0; ctr < dctsize; ctr++)
+    {
+        outptr = data + ctr * 8;
+
+        /* Rows of zeroes can be exploited in the same way as we did with
+         * columns. However, the column calculation has created many nonzero
+         * AC terms, so the simplification applies less often (typically 5%
+         * to 10% of the time). On machines with very fast multiplication,
+         * it's possible that the test takes more time than it's worth.  In
+         * that case this section may be commented out.
+         */
+        /* Even part */
+
+        tmp10 = (wsptr[0] + wsptr[4]);
+        tmp11 = (wsptr[0] - wsptr[4]);
+
+        tmp13 = (wsptr[2] + wsptr[6]);
+        tmp12 = MULTIPLY((int)wsptr[2] - (int)wsptr[6], FIX_1_414213562) -
+                tmp13;
+
+        tmp0 = tmp10 + tmp13;
+        tmp3 = tmp10 - tmp13;
+        tmp1 = tmp11 + tmp12;
+        tmp2 = tmp11 - tmp12;
+
+        /* Odd part */
+
+        z13 = wsptr[5] + wsptr[3];
+        z10 = wsptr[5] - wsptr[3];
+        z11 = wsptr[1] + wsptr[7];
+        z12 = wsptr[1] - wsptr[7];
+
+        tmp7 = z11 + z13;                             /* phase 5 */
+        tmp11 = MULTIPLY(z11 - z13, FIX_1_414213562); /* 2*c4 */
+
+        z5 = MULTIPLY(z10 + z12, FIX_1_847759065);    /* 2*c2 */
+        tmp10 = MULTIPLY(z12, FIX_1_082392200) - z5;  /* 2*(c2-c6) */
+        tmp12 = MULTIPLY(z10, -FIX_2_613125930) + z5; /* -2*(c2+c6) */
+
+        tmp6 = tmp12 - tmp7; /* phase 2 */
+        tmp5 = tmp11 - tmp6;
+        tmp4 = tmp10 + tmp5;
+
+        /* Final output stage: scale down by a factor of 8 and range-limit
+         */
+
+        outptr[0] =
+            rLimit[IDESCALE((tmp0 + tmp7), (PASS1_BITS + 3)) & 1023L];
+        outptr[7] =
+            rLimit[IDESCALE((tmp0 - tmp7), (PASS1_BITS + 3)) & 1023L];
+        outptr[1] =
+            rLimit[IDESCALE((tmp1 + tmp6), (PASS1_BITS + 3)) & 1023L];
+        outptr[6] =
+            rLimit[IDESCALE((tmp1 - tmp6), (PASS1_BITS + 3)) & 1023L];
+        outptr[2] =
+            rLimit[IDESCALE((tmp2 + tmp5), (PASS1_BITS + 3)) & 1023L];
+        outptr[5] =
+            rLimit[IDESCALE((tmp2 - tmp5), (PASS1_BITS + 3)) & 1023L];
+        outptr[4] =
+            rLimit[IDESCALE((tmp3 + tmp4), (PASS1_BITS + 3)) & 1023L];
+        outptr[3] =
+            rLimit[IDESCALE((tmp3 - tmp4), (PASS1_BITS + 3)) & 1023L];
+
+        wsptr += dctsize; /* advance pointer to next row */
+    }
+}
+
+#ifdef AST_JPEG_SIMD
+
+/* The quantization table as the vector IDCT takes it.  The scaled table
+ * entries are up to 25 bits wide, so the product of coefficient and entry
+ * doesn't fit in 32 bits.  Each entry is split in two halves of 16 bits, and
+ * (c * q) >> 16 is computed exactly as c * high + ((c * low) >> 16).
+ */
+struct Quant
+{
+    std::array<int16_t, 64> high;
+    std::array<uint16_t, 64> low;
+};
+
+inline void splitQuant(const std::array<long, 64> &table, Quant &quant)
+{
+    for (size_t i = 0; i < table.size(); i++)
+    {
+        quant.high[i] = static_cast<int16_t>(table[i] >> 16);
+        quant.low[i] = static_cast<uint16_t>(table[i] & 0xFFFF);
+    }
+}
+
+namespace detail
+{
+
+using simd::Int32x4;
+
+// The constants are positive and fit in 16 bits; the one negative use
+// multiplies by the magnitude and negates
+inline Int32x4 multiply(Int32x4 var, int cons)
+{
+    if (cons < 0)
+    {
+        return simd::shiftRight<8>(simd::splat(0) -
+                                   simd::mulShort(var, simd::splat(-cons)));
+    }
+    return simd::shiftRight<8>(simd::mulShort(var, simd::splat(cons)));
+}
+
+/* Where long is 32 bits the reference's product wraps, which leaves the
+ * low 16 bits of the exact result, sign extended
+ */
+inline Int32x4 wrapLikeLong(Int32x4 x)
+{
+    if (sizeof(long) > sizeof(int32_t))
+    {
+        return x;
+    }
+    return simd::shiftRight<16>(simd::shiftLeft<16>(x));
+}
+
+/* One dimensional IDCT of four rows or columns at once; x[k] holds the kth
+ * sample of each.  The same steps, in the same order, as idctReference.
+ */
+inline void idct8(Int32x4 x[8])
+{
+    /* Even part */
+    Int32x4 tmp10 = x[0] + x[4];
+    Int32x4 tmp11 = x[0] - x[4];
+    Int32x4 tmp13 = x[2] + x[6];
+    Int32x4 tmp12 = multiply(x[2] - x[6], FIX_1_414213562) - tmp13;
+
+    Int32x4 tmp0 = tmp10 + tmp13;
+    Int32x4 tmp3 = tmp10 - tmp13;
+    Int32x4 tmp1 = tmp11 + tmp12;
+    Int32x4 tmp2 = tmp11 - tmp12;
+
+    /* Odd part */
+    Int32x4 z13 = x[5] + x[3];
+    Int32x4 z10 = x[5] - x[3];
+    Int32x4 z11 = x[1] + x[7];
+    Int32x4 z12 = x[1] - x[7];
+
+    Int32x4 tmp7 = z11 + z13;
+    tmp11 = multiply(z11 - z13, FIX_1_414213562);
+
+    Int32x4 z5 = multiply(z10 + z12, FIX_1_847759065);
+    tmp10 = multiply(z12, FIX_1_082392200) - z5;
+    tmp12 = multiply(z10, -FIX_2_613125930) + z5;
+
+    Int32x4 tmp6 = tmp12 - tmp7;
+    Int32x4 tmp5 = tmp11 - tmp6;
+    Int32x4 tmp4 = tmp10 + tmp5;
+
+    x[0] = tmp0 + tmp7;
+    x[7] = tmp0 - tmp7;
+    x[1] = tmp1 + tmp6;
+    x[6] = tmp1 - tmp6;
+    x[2] = tmp2 + tmp5;
+    x[5] = tmp2 - tmp5;
+    x[4] = tmp3 + tmp4;
+    x[3] = tmp3 - tmp4;
+}
+
+/* Descales by 8 and range limits like the reference table lookup: the low
+ * 10 bits, taken as signed, plus 128, clamped to 0..255.
+ */
+inline Int32x4 descale(Int32x4 x)
+{
+    return simd::shiftRight<22>(simd::shiftLeft<19>(x)) + simd::splat(128);
+}
+
+} // namespace detail
+
+/* Vector integer IDCT of one 8x8 block, four columns and then four rows at a
+ * time.  Like the reference, it skips what has nothing to transform: a block
+ * with nothing but a DC term, which most blocks of a screen are, is filled
+ * with its value, four columns without AC terms skip the column pass, and
+ * when no column has any, every row is the same and only four are
+ * transformed.  Rows of zeroes are dequantized all the same; testing each
+ * costs more in mispredicted branches than it saves.
+ */
+inline void idctSimd(const short *coef, const Quant &quant,
+                     unsigned char *data)
+{
+    using simd::Int32x4;
+    // Rows 1 to 7 of columns 0 to 3, and of columns 4 to 7
+    constexpr uint64_t columnAcTerms[2] = {0x0F0F0F0F0F0F0F00,
+                                           0xF0F0F0F0F0F0F000};
+    uint64_t nonZero = simd::nonZeroMask(coef);
+    if ((nonZero & ~uint64_t(1)) == 0)
+    {
+        long dc = (coef[0] * ((static_cast<long>(quant.high[0]) << 16) +
+                              quant.low[0])) >>
+                  16;
+        Int32x4 value = detail::descale(
+            detail::wrapLikeLong(simd::splat(static_cast<int32_t>(dc))));
+        for (int row = 0; row < 8; row++)
+        {
+            simd::storeBytes(data + row * 8, value, value);
+        }
+        return;
+    }
+
+    // Pass 1: process columns from input, store into work array; x[half]
+    // holds columns 4 * half to 4 * half + 3
+    Int32x4 x[2][8];
+    for (int row = 0; row < 8; row++)
+    {
+        int i = row * 8;
+        simd::mulShift16(coef + i, &quant.high[i], &quant.low[i], x[0][row],
+                         x[1][row]);
+        x[0][row] = detail::wrapLikeLong(x[0][row]);
+        x[1][row] = detail::wrapLikeLong(x[1][row]);
+    }
+    for (int half = 0; half < 2; half++)
+    {
+        if ((nonZero & columnAcTerms[half]) != 0)
+        {
+            detail::idct8(x[half]);
+            continue;
+        }
+        // Each column is its DC value in every row
+        for (int row = 1; row < 8; row++)
+        {
+            x[half][row] = x[half][0];
+        }
+    }
+
+    // Pass 2: process rows from work array, four at a time, turning them
+    // into columns of lanes; out[group][k] holds column k of those rows
+    bool sameRows = (nonZero & (columnAcTerms[0] | columnAcTerms[1])) == 0;
+    Int32x4 out[2][8];
+    for (int group = 0; group < (sameRows ? 1 : 2); group++)
+    {
+        Int32x4 *y = out[group];
+        for (int half = 0; half < 2; half++)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                y[half * 4 + i] = x[half][group * 4 + i];
+            }
+            simd::transpose(y[half * 4], y[half * 4 + 1], y[half * 4 + 2],
+                            y[half * 4 + 3]);
+        }
+        detail::idct8(y);
+        for (int k = 0; k < 8; k++)
+        {
+            y[k] = detail::descale(y[k]);
+        }
+    }
+    simd::storeColumns(data, out[0], out[sameRows ? 0 : 1]);
+}
+
+#endif
+
+} // namespace idct
+} // namespace ast_video
@@ -0,0 +1,404 @@
+#pragma once
+
+#include <cstdint>
+
+/* The vector kernels of the decoder are written once against Int32x4, which
+ * is SSE2 on x86 and NEON on ARM.  AST_JPEG_SIMD is defined when one of them
+ * is available; defining AST_JPEG_SCALAR forces the scalar code.
+ */
+#if !defined(AST_JPEG_SCALAR) && defined(__SSE2__)
+#include <emmintrin.h>
+#ifdef __SSE4_1__
+#include <smmintrin.h>
+#endif
+#define AST_JPEG_SIMD 1
+#elif !defined(AST_JPEG_SCALAR) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define AST_JPEG_SIMD 1
+#endif
+
+#ifdef AST_JPEG_SIMD
+
+namespace ast_video
+{
+namespace simd
+{
+
+/* Four 32 bit lanes, with the handful of operations the IDCT and the color
+ * conversion need.  Lane arithmetic wraps, as the int arithmetic of the
+ * scalar code does in practice.
+ */
+#ifdef __SSE2__
+struct Int32x4
+{
+    __m128i v;
+};
+
+inline Int32x4 operator+(Int32x4 a, Int32x4 b)
+{
+    return {_mm_add_epi32(a.v, b.v)};
+}
+
+inline Int32x4 operator-(Int32x4 a, Int32x4 b)
+{
+    return {_mm_sub_epi32(a.v, b.v)};
+}
+
+// The low 32 bits of the product
+inline Int32x4 operator*(Int32x4 a, Int32x4 b)
+{
+#ifdef __SSE4_1__
+    return {_mm_mullo_epi32(a.v, b.v)};
+#else
+    __m128i even = _mm_mul_epu32(a.v, b.v);
+    __m128i odd =
+        _mm_mul_epu32(_mm_srli_epi64(a.v, 32), _mm_srli_epi64(b.v, 32));
+    return {
+        _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                           _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)))};
+#endif
+}
+
+// The low 32 bits of the product, for b in 0..65535; four 16 bit
+// multiplies where there is no 32 bit one
+inline Int32x4 mulShort(Int32x4 a, Int32x4 b)
+{
+#ifdef __SSE4_1__
+    return {_mm_mullo_epi32(a.v, b.v)};
+#else
+    __m128i bb = _mm_or_si128(b.v, _mm_slli_epi32(b.v, 16));
+    __m128i lo = _mm_mullo_epi16(a.v, bb);
+    __m128i hi = _mm_mulhi_epu16(a.v, bb);
+    return {_mm_add_epi32(lo, _mm_slli_epi32(hi, 16))};
+#endif
+}
+
+template <int n> Int32x4 shiftRight(Int32x4 a)
+{
+    return {_mm_srai_epi32(a.v, n)};
+}
+
+template <int n> Int32x4 shiftLeft(Int32x4 a)
+{
+    return {_mm_slli_epi32(a.v, n)};
+}
+
+inline Int32x4 splat(int32_t x)
+{
+    return {_mm_set1_epi32(x)};
+}
+
+inline Int32x4 load(const int32_t *p)
+{
+    return {_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))};
+}
+
+// Sign extends four shorts
+inline Int32x4 loadShorts(const short *p)
+{
+    __m128i x = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p));
+    return {_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16)};
+}
+
+inline void transpose(Int32x4 &r0, Int32x4 &r1, Int32x4 &r2, Int32x4 &r3)
+{
+    __m128i t0 = _mm_unpacklo_epi32(r0.v, r1.v);
+    __m128i t1 = _mm_unpacklo_epi32(r2.v, r3.v);
+    __m128i t2 = _mm_unpackhi_epi32(r0.v, r1.v);
+    __m128i t3 = _mm_unpackhi_epi32(r2.v, r3.v);
+    r0.v = _mm_unpacklo_epi64(t0, t1);
+    r1.v = _mm_unpackhi_epi64(t0, t1);
+    r2.v = _mm_unpacklo_epi64(t2, t3);
+    r3.v = _mm_unpackhi_epi64(t2, t3);
+}
+
+/* (c * q) >> 16 for eight shorts c, where q = (high << 16) + low, in 64 bit
+ * arithmetic; high is below 1 << 15.  Done in 16 bit lanes, which takes a
+ * third of the instructions of widening c and using operator*.
+ */
+inline void mulShift16(const short *c, const int16_t *high,
+                       const uint16_t *low, Int32x4 &lo, Int32x4 &hi)
+{
+    __m128i cs = _mm_loadu_si128(reinterpret_cast<const __m128i *>(c));
+    __m128i hs = _mm_loadu_si128(reinterpret_cast<const __m128i *>(high));
+    __m128i ls = _mm_loadu_si128(reinterpret_cast<const __m128i *>(low));
+    // c * high, widened
+    __m128i productLo = _mm_mullo_epi16(cs, hs);
+    __m128i productHi = _mm_mulhi_epi16(cs, hs);
+    // (c * low) >> 16; pmulhuw takes a negative c as c + 65536
+    __m128i fraction = _mm_sub_epi16(_mm_mulhi_epu16(cs, ls),
+                                     _mm_and_si128(_mm_srai_epi16(cs, 15), ls));
+    lo.v = _mm_add_epi32(_mm_unpacklo_epi16(productLo, productHi),
+                         _mm_srai_epi32(_mm_unpacklo_epi16(fraction, fraction),
+                                        16));
+    hi.v = _mm_add_epi32(_mm_unpackhi_epi16(productLo, productHi),
+                         _mm_srai_epi32(_mm_unpackhi_epi16(fraction, fraction),
+                                        16));
+}
+
+// Bit i is set where p[i], of 64 shorts, isn't zero
+inline uint64_t nonZeroMask(const short *p)
+{
+    const __m128i *rows = reinterpret_cast<const __m128i *>(p);
+    __m128i zero = _mm_setzero_si128();
+    uint64_t zeroes = 0;
+    for (int pair = 0; pair < 4; pair++)
+    {
+        __m128i a = _mm_cmpeq_epi16(_mm_loadu_si128(rows + 2 * pair), zero);
+        __m128i b =
+            _mm_cmpeq_epi16(_mm_loadu_si128(rows + 2 * pair + 1), zero);
+        zeroes |= static_cast<uint64_t>(
+                      _mm_movemask_epi8(_mm_packs_epi16(a, b)))
+                  << (16 * pair);
+    }
+    return ~zeroes;
+}
+
+// Stores eight lanes as bytes, saturating
+inline void storeBytes(unsigned char *p, Int32x4 lo, Int32x4 hi)
+{
+    __m128i words = _mm_packs_epi32(lo.v, hi.v);
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(p),
+                     _mm_packus_epi16(words, words));
+}
+
+/* Stores an 8x8 block of bytes, saturating, given its columns: top[k] holds
+ * rows 0 to 3 of column k, and bottom[k] rows 4 to 7
+ */
+inline void storeColumns(unsigned char *p, const Int32x4 top[8],
+                         const Int32x4 bottom[8])
+{
+    __m128i c[8];
+    for (int k = 0; k < 8; k++)
+    {
+        c[k] = _mm_packs_epi32(top[k].v, bottom[k].v);
+    }
+    // Transposed in 16 bit lanes: t holds pairs of columns, u quads of
+    // them, two rows to a vector
+    __m128i t[8];
+    for (int k = 0; k < 8; k += 2)
+    {
+        t[k] = _mm_unpacklo_epi16(c[k], c[k + 1]);
+        t[k + 1] = _mm_unpackhi_epi16(c[k], c[k + 1]);
+    }
+    __m128i u[8];
+    for (int k = 0; k < 8; k += 4)
+    {
+        u[k] = _mm_unpacklo_epi32(t[k], t[k + 2]);
+        u[k + 1] = _mm_unpackhi_epi32(t[k], t[k + 2]);
+        u[k + 2] = _mm_unpacklo_epi32(t[k + 1], t[k + 3]);
+        u[k + 3] = _mm_unpackhi_epi32(t[k + 1], t[k + 3]);
+    }
+    __m128i *out = reinterpret_cast<__m128i *>(p);
+    for (int i = 0; i < 4; i++)
+    {
+        // Rows 2 * i and 2 * i + 1
+        __m128i even = _mm_unpacklo_epi64(u[i], u[i + 4]);
+        __m128i odd = _mm_unpackhi_epi64(u[i], u[i + 4]);
+        _mm_storeu_si128(out + i, _mm_packus_epi16(even, odd));
+    }
+}
+
+// Zero extends eight bytes
+inline void loadBytes(const unsigned char *p, Int32x4 &lo, Int32x4 &hi)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i words = _mm_unpacklo_epi8(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p)), zero);
+    lo.v = _mm_unpacklo_epi16(words, zero);
+    hi.v = _mm_unpackhi_epi16(words, zero);
+}
+
+/* Stores eight pixels of four bytes, the first three of them from b, g and r
+ * saturated to 0..255.  The fourth byte of each pixel is left as it was.
+ */
+inline void storePixels(unsigned char *p, const Int32x4 b[2],
+                        const Int32x4 g[2], const Int32x4 r[2])
+{
+    __m128i *out = reinterpret_cast<__m128i *>(p);
+    __m128i old0 = _mm_loadu_si128(out);
+    __m128i old1 = _mm_loadu_si128(out + 1);
+    __m128i x = _mm_packs_epi32(_mm_srli_epi32(old0, 24),
+                                _mm_srli_epi32(old1, 24));
+    // b0..b7 g0..g7 and r0..r7 x0..x7
+    __m128i bg = _mm_packus_epi16(_mm_packs_epi32(b[0].v, b[1].v),
+                                  _mm_packs_epi32(g[0].v, g[1].v));
+    __m128i rx = _mm_packus_epi16(_mm_packs_epi32(r[0].v, r[1].v), x);
+    bg = _mm_unpacklo_epi8(bg, _mm_srli_si128(bg, 8));
+    rx = _mm_unpacklo_epi8(rx, _mm_srli_si128(rx, 8));
+    _mm_storeu_si128(out, _mm_unpacklo_epi16(bg, rx));
+    _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(bg, rx));
+}
+#else
+struct Int32x4
+{
+    int32x4_t v;
+};
+
+inline Int32x4 operator+(Int32x4 a, Int32x4 b)
+{
+    return {vaddq_s32(a.v, b.v)};
+}
+
+inline Int32x4 operator-(Int32x4 a, Int32x4 b)
+{
+    return {vsubq_s32(a.v, b.v)};
+}
+
+// The low 32 bits of the product
+inline Int32x4 operator*(Int32x4 a, Int32x4 b)
+{
+    return {vmulq_s32(a.v, b.v)};
+}
+
+// The low 32 bits of the product, for b in 0..65535
+inline Int32x4 mulShort(Int32x4 a, Int32x4 b)
+{
+    return {vmulq_s32(a.v, b.v)};
+}
+
+template <int n> Int32x4 shiftRight(Int32x4 a)
+{
+    return {vshrq_n_s32(a.v, n)};
+}
+
+template <int n> Int32x4 shiftLeft(Int32x4 a)
+{
+    return {vshlq_n_s32(a.v, n)};
+}
+
+inline Int32x4 splat(int32_t x)
+{
+    return {vdupq_n_s32(x)};
+}
+
+inline Int32x4 load(const int32_t *p)
+{
+    return {vld1q_s32(p)};
+}
+
+// Sign extends four shorts
+inline Int32x4 loadShorts(const short *p)
+{
+    return {vmovl_s16(vld1_s16(p))};
+}
+
+inline void transpose(Int32x4 &r0, Int32x4 &r1, Int32x4 &r2, Int32x4 &r3)
+{
+    int32x4x2_t t01 = vtrnq_s32(r0.v, r1.v);
+    int32x4x2_t t23 = vtrnq_s32(r2.v, r3.v);
+    r0.v = vcombine_s32(vget_low_s32(t01.val[0]), vget_low_s32(t23.val[0]));
+    r1.v = vcombine_s32(vget_low_s32(t01.val[1]), vget_low_s32(t23.val[1]));
+    r2.v = vcombine_s32(vget_high_s32(t01.val[0]), vget_high_s32(t23.val[0]));
+    r3.v = vcombine_s32(vget_high_s32(t01.val[1]), vget_high_s32(t23.val[1]));
+}
+
+/* (c * q) >> 16 for eight shorts c, where q = (high << 16) + low, in 64 bit
+ * arithmetic; high is below 1 << 15
+ */
+inline void mulShift16(const short *c, const int16_t *high,
+                       const uint16_t *low, Int32x4 &lo, Int32x4 &hi)
+{
+    int16x8_t cs = vld1q_s16(c);
+    int16x8_t hs = vld1q_s16(high);
+    int32x4_t c0 = vmovl_s16(vget_low_s16(cs));
+    int32x4_t c1 = vmovl_s16(vget_high_s16(cs));
+    uint16x8_t ls = vld1q_u16(low);
+    int32x4_t l0 = vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(ls)));
+    int32x4_t l1 = vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(ls)));
+    lo.v = vaddq_s32(vmull_s16(vget_low_s16(cs), vget_low_s16(hs)),
+                     vshrq_n_s32(vmulq_s32(c0, l0), 16));
+    hi.v = vaddq_s32(vmull_s16(vget_high_s16(cs), vget_high_s16(hs)),
+                     vshrq_n_s32(vmulq_s32(c1, l1), 16));
+}
+
+// Bit i is set where p[i], of 64 shorts, isn't zero
+inline uint64_t nonZeroMask(const short *p)
+{
+    const uint8x8_t bits = {1, 2, 4, 8, 16, 32, 64, 128};
+    uint64_t mask = 0;
+    for (int row = 0; row < 8; row++)
+    {
+        int16x8_t x = vld1q_s16(p + row * 8);
+        uint8x8_t nonZero = vand_u8(vmovn_u16(vtstq_s16(x, x)), bits);
+        uint64_t byte = vget_lane_u64(
+            vpaddl_u32(vpaddl_u16(vpaddl_u8(nonZero))), 0);
+        mask |= byte << (8 * row);
+    }
+    return mask;
+}
+
+// Stores eight lanes as bytes, saturating
+inline void storeBytes(unsigned char *p, Int32x4 lo, Int32x4 hi)
+{
+    vst1_u8(p, vqmovun_s16(vcombine_s16(vqmovn_s32(lo.v), vqmovn_s32(hi.v))));
+}
+
+/* Stores an 8x8 block of bytes, saturating, given its columns: top[k] holds
+ * rows 0 to 3 of column k, and bottom[k] rows 4 to 7
+ */
+inline void storeColumns(unsigned char *p, const Int32x4 top[8],
+                         const Int32x4 bottom[8])
+{
+    int16x8_t c[8];
+    for (int k = 0; k < 8; k++)
+    {
+        c[k] = vcombine_s16(vqmovn_s32(top[k].v), vqmovn_s32(bottom[k].v));
+    }
+    // Transposed in 16 and then 32 bit lanes: s[2 * half + j].val[i] holds
+    // rows j + 2 * i and j + 2 * i + 4 of columns 4 * half to 4 * half + 3
+    int32x4x2_t s[4];
+    for (int k = 0; k < 8; k += 4)
+    {
+        int16x8x2_t t01 = vtrnq_s16(c[k], c[k + 1]);
+        int16x8x2_t t23 = vtrnq_s16(c[k + 2], c[k + 3]);
+        s[k / 2] = vtrnq_s32(vreinterpretq_s32_s16(t01.val[0]),
+                             vreinterpretq_s32_s16(t23.val[0]));
+        s[k / 2 + 1] = vtrnq_s32(vreinterpretq_s32_s16(t01.val[1]),
+                                 vreinterpretq_s32_s16(t23.val[1]));
+    }
+    for (int row = 0; row < 4; row++)
+    {
+        // Row and row + 4
+        int32x4_t left = s[row % 2].val[row / 2];
+        int32x4_t right = s[2 + row % 2].val[row / 2];
+        int16x8_t upper = vreinterpretq_s16_s32(
+            vcombine_s32(vget_low_s32(left), vget_low_s32(right)));
+        int16x8_t lower = vreinterpretq_s16_s32(
+            vcombine_s32(vget_high_s32(left), vget_high_s32(right)));
+        vst1_u8(p + row * 8, vqmovun_s16(upper));
+        vst1_u8(p + (row + 4) * 8, vqmovun_s16(lower));
+    }
+}
+
+// Zero extends eight bytes
+inline void loadBytes(const unsigned char *p, Int32x4 &lo, Int32x4 &hi)
+{
+    uint16x8_t words = vmovl_u8(vld1_u8(p));
+    lo.v = vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(words)));
+    hi.v = vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(words)));
+}
+
+inline uint8x8_t saturateBytes(const Int32x4 x[2])
+{
+    return vqmovun_s16(vcombine_s16(vqmovn_s32(x[0].v), vqmovn_s32(x[1].v)));
+}
+
+/* Stores eight pixels of four bytes, the first three of them from b, g and r
+ * saturated to 0..255.  The fourth byte of each pixel is left as it was.
+ */
+inline void storePixels(unsigned char *p, const Int32x4 b[2],
+                        const Int32x4 g[2], const Int32x4 r[2])
+{
+    uint8x8x4_t pixels = vld4_u8(p);
+    pixels.val[0] = saturateBytes(b);
+    pixels.val[1] = saturateBytes(g);
+    pixels.val[2] = saturateBytes(r);
+    vst4_u8(p, pixels);
+}
+#endif
+
+} // namespace simd
+} // namespace ast_video
+
+#endif
@@ -3,7 +3,10 @@
 #include <ast_video_types.hpp>
 #include <boost/asio.hpp>
 #include <cassert>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -116,6 +119,7 @@ class SimpleVideoPuller
         }
 
         raw.buffer.resize(imageInfo.len);
+        raw.length = imageInfo.len;
 
         raw.height = imageInfo.parameter.features.h;
         raw.width = imageInfo.parameter.features.w;
@@ -135,78 +139,231 @@ class SimpleVideoPuller
     ImageInfo imageInfo;
 };
 
+/* The frames the video engine captures into, handed round so that capture
+ * can go on while the frames before are being encoded and sent.  A frame is
+ * taken to capture into, then shared with every consumer, and comes back
+ * once the last of them drops it, on whichever thread that is.
+ */
+class VideoFrameRing
+{
+  public:
+    explicit VideoFrameRing(size_t frames) : state(std::make_shared<State>())
+    {
+        for (size_t i = 0; i < frames; i++)
+        {
+            state->idle.push_back(std::make_unique<RawVideoBuffer>());
+        }
+    }
+
+    // Called when a shared frame comes back, on the thread that dropped it
+    void onReturn(std::function<void()> handler)
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->onReturn = std::move(handler);
+    }
+
+    // A frame to capture into; nullptr if consumers hold all of them
+    std::unique_ptr<RawVideoBuffer> take()
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->idle.empty())
+        {
+            return nullptr;
+        }
+        std::unique_ptr<RawVideoBuffer> frame = std::move(state->idle.back());
+        state->idle.pop_back();
+        return frame;
+    }
+
+    // Puts back a frame that wasn't captured into
+    void giveBack(std::unique_ptr<RawVideoBuffer> frame)
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->idle.push_back(std::move(frame));
+    }
+
+    // Hands a captured frame to the consumers
+    std::shared_ptr<const RawVideoBuffer>
+        share(std::unique_ptr<RawVideoBuffer> frame)
+    {
+        // The deleter holds the state, so frames can outlive the ring
+        std::shared_ptr<State> owner = state;
+        return std::shared_ptr<const RawVideoBuffer>(
+            frame.release(), [owner](const RawVideoBuffer *f) {
+                std::function<void()> handler;
+                {
+                    std::lock_guard<std::mutex> lock(owner->mutex);
+                    owner->idle.emplace_back(const_cast<RawVideoBuffer *>(f));
+                    handler = owner->onReturn;
+                }
+                if (handler)
+                {
+                    handler();
+                }
+            });
+    }
+
+    size_t idle() const
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        return state->idle.size();
+    }
+
+  private:
+    struct State
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<RawVideoBuffer>> idle;
+        std::function<void()> onReturn;
+    };
+
+    std::shared_ptr<State> state;
+};
+
 #if defined(BOOST_ASIO_HAS_POSIX_STREAM_DESCRIPTOR)
-class AsyncVideoPuller
+/* Captures frames one after the other while anyone is subscribed, and gives
+ * every subscriber each frame.  The driver writes a frame into the buffer
+ * named in ImageInfo, so captures go straight into the frames of a
+ * VideoFrameRing, and the next capture starts before the subscribers see
+ * the last one.  Capture waits when the subscribers hold every frame.
+ * Create it with std::make_shared; it runs on the io_service it is given.
+ */
+class AsyncVideoPuller : public std::enable_shared_from_this<AsyncVideoPuller>
 {
   public:
-    using video_callback = std::function<void(RawVideoBuffer &)>;
+    using video_callback =
+        std::function<void(const std::shared_ptr<const RawVideoBuffer> &)>;
 
-    explicit AsyncVideoPuller(boost::asio::io_service &ioService) :
-        imageInfo(), devVideo(ioService, open("/dev/video", O_RDWR))
+    // Two frames: one being captured, and one being encoded and sent
+    static constexpr size_t frameCount()
     {
-        videobuf = std::make_shared<RawVideoBuffer>();
+        return 2;
+    }
 
+    explicit AsyncVideoPuller(boost::asio::io_service &ioService) :
+        io(ioService), imageInfo(),
+        devVideo(ioService, open("/dev/video", O_RDWR)), frames(frameCount())
+    {
         imageInfo.doImageRefresh = 1; // full frame refresh
         imageInfo.qcValid = 0;        // quick cursor disabled
-        imageInfo.parameter.features.buf =
-            reinterpret_cast<unsigned char *>(videobuf->buffer.data());
         imageInfo.crypttype = -1;
     };
 
-    void registerCallback(video_callback &callback)
+    ~AsyncVideoPuller()
+    {
+        frames.onReturn(nullptr);
+    }
+
+    // Calls callback with every frame captured from now on, until
+    // unsubscribe is called with the id returned
+    size_t subscribe(video_callback callback)
     {
-        std::lock_guard<std::mutex> lock(callbackMutex);
-        callbacks.push_back(callback);
+        if (nextId == 0)
+        {
+            std::weak_ptr<AsyncVideoPuller> weak = shared_from_this();
+            boost::asio::io_service *ioService = &io;
+            frames.onReturn([weak, ioService] {
+                ioService->post([weak] {
+                    std::shared_ptr<AsyncVideoPuller> self = weak.lock();
+                    if (self != nullptr)
+                    {
+                        self->startRead();
+                    }
+                });
+            });
+        }
+        size_t id = ++nextId;
+        callbacks.emplace(id, std::move(callback));
         startRead();
+        return id;
     }
 
+    void unsubscribe(size_t id)
+    {
+        callbacks.erase(id);
+    }
+
+    // Picks the quantization tables of the captures that start from now
+    // on, 0 to 11 from lowest to highest quality
+    void setQuality(int table)
+    {
+        imageInfo.parameter.features.luminTbl = static_cast<short>(table);
+        imageInfo.parameter.features.chromTbl = static_cast<short>(table);
+    }
+
+  private:
     void startRead()
     {
+        if (capturing != nullptr || callbacks.empty())
+        {
+            return;
+        }
+        capturing = frames.take();
+        if (capturing == nullptr)
+        {
+            // Restarted when a frame comes back
+            return;
+        }
+        imageInfo.parameter.features.buf =
+            reinterpret_cast<unsigned char *>(capturing->buffer.data());
         auto mutableBuffer = boost::asio::buffer(&imageInfo, sizeof(imageInfo));
-        boost::asio::async_read(devVideo, mutableBuffer,
-                                [this](const boost::system::error_code &ec,
-                                       std::size_t bytes_transferred) {
-                                    if (ec)
-                                    {
-                                        std::cerr << "Read failed with status "
-                                                  << ec << "\n";
-                                    }
-                                    else
-                                    {
-                                        this->readDone();
-                                    }
-                                });
+        std::weak_ptr<AsyncVideoPuller> weak = shared_from_this();
+        boost::asio::async_read(
+            devVideo, mutableBuffer,
+            [weak](const boost::system::error_code &ec,
+                   std::size_t bytes_transferred) {
+                std::shared_ptr<AsyncVideoPuller> self = weak.lock();
+                if (self == nullptr)
+                {
+                    return;
+                }
+                if (ec)
+                {
+                    std::cerr << "Read failed with status " << ec << "\n";
+                    self->frames.giveBack(std::move(self->capturing));
+                    return;
+                }
+                self->readDone();
+            });
     }
 
     void readDone()
     {
-        std::cout << "Done reading\n";
-        videobuf->buffer.resize(imageInfo.len);
-
-        videobuf->height = imageInfo.parameter.features.h;
-        videobuf->width = imageInfo.parameter.features.w;
+        // The buffer keeps its size, so that it needn't be cleared to grow
+        // back for the next capture; length says how much was written
+        capturing->length = imageInfo.len;
+        capturing->height = imageInfo.parameter.features.h;
+        capturing->width = imageInfo.parameter.features.w;
+        capturing->ySelector = imageInfo.parameter.features.luminTbl;
+        capturing->uvSelector = imageInfo.parameter.features.chromTbl;
         if (imageInfo.parameter.features.jpgFmt == 422)
         {
-            videobuf->mode = YuvMode::YUV420;
+            capturing->mode = YuvMode::YUV420;
         }
         else
         {
-            videobuf->mode = YuvMode::YUV444;
+            capturing->mode = YuvMode::YUV444;
         }
-        std::lock_guard<std::mutex> lock(callbackMutex);
-        for (auto &callback : callbacks)
+        std::shared_ptr<const RawVideoBuffer> frame =
+            frames.share(std::move(capturing));
+        startRead();
+
+        // A callback may unsubscribe
+        std::map<size_t, video_callback> current = callbacks;
+        for (auto &callback : current)
         {
-            // TODO(ed) call callbacks async and double buffer frames
-            callback(*videobuf);
+            callback.second(frame);
         }
     }
 
-  private:
-    std::shared_ptr<RawVideoBuffer> videobuf;
-    boost::asio::posix::stream_descriptor devVideo;
+    boost::asio::io_service &io;
     ImageInfo imageInfo;
-    std::mutex callbackMutex;
-    std::vector<video_callback> callbacks;
+    boost::asio::posix::stream_descriptor devVideo;
+    VideoFrameRing frames;
+    // The frame being captured into
+    std::unique_ptr<RawVideoBuffer> capturing;
+    std::map<size_t, video_callback> callbacks;
+    size_t nextId = 0;
 };
 #endif // defined(BOOST_ASIO_HAS_POSIX_STREAM_DESCRIPTOR)
 } // namespace ast_video
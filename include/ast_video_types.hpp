@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 namespace ast_video
@@ -21,5 +22,7 @@ class RawVideoBuffer
     YuvMode mode;
     // TODO(ed) determine a more appropriate buffer size
     std::vector<uint32_t> buffer;
+    // Bytes of the compressed stream in buffer, as the video engine gave it
+    size_t length{};
 };
 } // namespace ast_video
\ No newline at end of file
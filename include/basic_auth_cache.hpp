@@ -0,0 +1,250 @@
+#pragma once
+
+#include <crow/logging.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+#include <sys/stat.h>
+
+#include <array>
+#include <boost/utility/string_view.hpp>
+#include <chrono>
+#include <memory>
+#include <sessions.hpp>
+#include <string>
+#include <unordered_map>
+#include <user_privileges.hpp>
+
+namespace crow
+{
+
+namespace token_authorization
+{
+
+// Remembers Basic auth credentials that PAM accepted, so that clients
+// sending the same Authorization header on every request don't pay for a
+// PAM transaction and a new session each time.  Credentials are only kept
+// as an HMAC under a key drawn at startup.  Entries live for ttl(); all of
+// them are dropped when the password file changes, and those of a user when
+// the user store sees that user change.
+class BasicAuthCache
+{
+  public:
+    using clock = std::chrono::steady_clock;
+
+    // What's known about the password file; passwd and friends replace it
+    // on every change, so any change shows in one of these
+    struct Stamp
+    {
+        bool exists = false;
+        ino_t inode = 0;
+        off_t size = 0;
+        time_t seconds = 0;
+        long nanoseconds = 0;
+
+        bool operator==(const Stamp& other) const
+        {
+            return exists == other.exists && inode == other.inode &&
+                   size == other.size && seconds == other.seconds &&
+                   nanoseconds == other.nanoseconds;
+        }
+    };
+
+    BasicAuthCache()
+    {
+        if (RAND_bytes(key.data(), static_cast<int>(key.size())) != 1)
+        {
+            BMCWEB_LOG_ERROR << "Couldn't seed Basic auth cache; disabled";
+            enabled = false;
+        }
+    }
+
+    BasicAuthCache(const BasicAuthCache&) = delete;
+    BasicAuthCache& operator=(const BasicAuthCache&) = delete;
+
+    // Listens to the user store, which tells of changed users
+    void start()
+    {
+        redfish::userPrivilegeStore().addListener(
+            [this](const std::string& username) { dropUser(username); });
+    }
+
+    void stop()
+    {
+        clear();
+    }
+
+    // How long a verdict is trusted for
+    void setTtl(clock::duration newTtl)
+    {
+        ttl = newTtl;
+    }
+
+    // Lets tests watch a file of their own
+    void setPasswordFile(std::string file)
+    {
+        passwordFile = std::move(file);
+        clear();
+    }
+
+    // Finds the session of an earlier request that sent these credentials.
+    // On a miss, the credentials are checked with PAM, and stamp is what
+    // insert() needs to tell whether the password file changed meanwhile.
+    std::shared_ptr<persistent_data::UserSession>
+        find(boost::string_view credentials, Stamp& stamp)
+    {
+        if (!enabled)
+        {
+            return nullptr;
+        }
+        stamp = passwordFileStamp();
+        if (!(stamp == lastStamp))
+        {
+            entries.clear();
+            lastStamp = stamp;
+        }
+        if (entries.empty())
+        {
+            return nullptr;
+        }
+        auto it = entries.find(hash(credentials));
+        if (it == entries.end())
+        {
+            return nullptr;
+        }
+        if (clock::now() >= it->second.expires)
+        {
+            entries.erase(it);
+            return nullptr;
+        }
+        return it->second.session;
+    }
+
+    // Remembers credentials PAM accepted after find() missed them, unless
+    // the password file changed since that find() gave stamp: PAM may have
+    // decided on the old password.
+    void insert(boost::string_view credentials,
+                std::shared_ptr<persistent_data::UserSession> session,
+                const Stamp& stamp)
+    {
+        if (!enabled || !(passwordFileStamp() == stamp))
+        {
+            return;
+        }
+        clock::time_point now = clock::now();
+        if (entries.size() >= maxEntries())
+        {
+            evict(now);
+        }
+        entries[hash(credentials)] = Entry{std::move(session), now + ttl};
+    }
+
+    void clear()
+    {
+        entries.clear();
+    }
+
+    // Drops the entries of a user; all of them for an empty name
+    void dropUser(const std::string& username)
+    {
+        if (username.empty())
+        {
+            clear();
+            return;
+        }
+        for (auto it = entries.begin(); it != entries.end();)
+        {
+            if (it->second.session->username == username)
+            {
+                it = entries.erase(it);
+                continue;
+            }
+            ++it;
+        }
+    }
+
+    size_t size() const
+    {
+        return entries.size();
+    }
+
+    static constexpr size_t maxEntries()
+    {
+        return 64;
+    }
+
+  private:
+    struct Entry
+    {
+        std::shared_ptr<persistent_data::UserSession> session;
+        clock::time_point expires;
+    };
+
+    Stamp passwordFileStamp() const
+    {
+        Stamp stamp;
+        struct stat info;
+        if (stat(passwordFile.c_str(), &info) == 0)
+        {
+            stamp.exists = true;
+            stamp.inode = info.st_ino;
+            stamp.size = info.st_size;
+            stamp.seconds = info.st_mtim.tv_sec;
+            stamp.nanoseconds = info.st_mtim.tv_nsec;
+        }
+        return stamp;
+    }
+
+    std::string hash(boost::string_view credentials) const
+    {
+        std::string digest(EVP_MAX_MD_SIZE, '\0');
+        unsigned int size = 0;
+        HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()),
+             reinterpret_cast<const unsigned char*>(credentials.data()),
+             credentials.size(), reinterpret_cast<unsigned char*>(&digest[0]),
+             &size);
+        digest.resize(size);
+        return digest;
+    }
+
+    // Makes room for one more entry: expired ones go first, otherwise the
+    // one closest to expiring
+    void evict(clock::time_point now)
+    {
+        auto oldest = entries.end();
+        for (auto it = entries.begin(); it != entries.end();)
+        {
+            if (now >= it->second.expires)
+            {
+                it = entries.erase(it);
+                continue;
+            }
+            if (oldest == entries.end() ||
+                it->second.expires < oldest->second.expires)
+            {
+                oldest = it;
+            }
+            ++it;
+        }
+        if (entries.size() >= maxEntries() && oldest != entries.end())
+        {
+            entries.erase(oldest);
+        }
+    }
+
+    bool enabled = true;
+    std::array<unsigned char, 32> key;
+    clock::duration ttl = std::chrono::seconds(60);
+    std::string passwordFile = "/etc/shadow";
+    Stamp lastStamp;
+    std::unordered_map<std::string, Entry> entries;
+};
+
+inline BasicAuthCache& basicAuthCache()
+{
+    static BasicAuthCache cache;
+    return cache;
+}
+
+} // namespace token_authorization
+} // namespace crow
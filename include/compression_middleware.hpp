@@ -0,0 +1,190 @@
+#pragma once
+
+#include <crow/http_request.h>
+#include <crow/http_response.h>
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <cstdlib>
+#include <gzip_helper.hpp>
+#include <http_utility.hpp>
+#include <string>
+#include <vector>
+
+namespace crow
+{
+namespace compression
+{
+
+enum class Encoding
+{
+    none,
+    gzip,
+    deflate
+};
+
+// Picks the content coding to use for a response from the request's
+// Accept-Encoding header.  gzip wins ties, since every client supports it.
+inline Encoding selectEncoding(boost::string_view acceptEncoding)
+{
+    std::vector<std::string> codings;
+    boost::split(codings, acceptEncoding, boost::is_any_of(","));
+
+    float gzipQ = 0;
+    float deflateQ = 0;
+    // A "*" entry covers whatever isn't listed explicitly
+    float wildcardQ = -1;
+    bool gzipListed = false;
+    bool deflateListed = false;
+    for (std::string& coding : codings)
+    {
+        float q = 1;
+        std::string::size_type params = coding.find(';');
+        if (params != std::string::npos)
+        {
+            std::string::size_type qPos = coding.find("q=", params);
+            if (qPos != std::string::npos)
+            {
+                q = std::strtof(coding.c_str() + qPos + 2, nullptr);
+            }
+            coding.resize(params);
+        }
+        boost::trim(coding);
+        if (boost::iequals(coding, "gzip"))
+        {
+            gzipQ = q;
+            gzipListed = true;
+        }
+        else if (boost::iequals(coding, "deflate"))
+        {
+            deflateQ = q;
+            deflateListed = true;
+        }
+        else if (coding == "*")
+        {
+            wildcardQ = q;
+        }
+    }
+    if (wildcardQ >= 0)
+    {
+        if (!gzipListed)
+        {
+            gzipQ = wildcardQ;
+        }
+        if (!deflateListed)
+        {
+            deflateQ = wildcardQ;
+        }
+    }
+
+    if (gzipQ > 0 && gzipQ >= deflateQ)
+    {
+        return Encoding::gzip;
+    }
+    if (deflateQ > 0)
+    {
+        return Encoding::deflate;
+    }
+    return Encoding::none;
+}
+
+// Compresses response bodies for clients that accept it.  Needs to be the
+// first middleware on the app, so its afterHandle runs after every other one
+// has finished with the body.
+class Middleware
+{
+  public:
+    struct Context
+    {
+    };
+
+    // Bodies smaller than this go out as they are; compressing them costs
+    // more CPU than it saves on the wire
+    void setMinSize(size_t size)
+    {
+        minSize = size;
+    }
+
+    // zlib compression level, from Z_BEST_SPEED to Z_BEST_COMPRESSION
+    void setLevel(int newLevel)
+    {
+        level = newLevel;
+    }
+
+    void beforeHandle(crow::Request& req, Response& res, Context& ctx)
+    {
+    }
+
+    void afterHandle(Request& req, Response& res, Context& ctx)
+    {
+        // Streamed bodies and precompressed static files are left alone
+        if (res.isStreamed() ||
+            !res.getHeaderValue("Content-Encoding").empty())
+        {
+            return;
+        }
+
+        // Already compressed formats won't get any smaller
+        boost::string_view contentType = res.getHeaderValue("Content-Type");
+        if (boost::starts_with(contentType, "image/") &&
+            !boost::starts_with(contentType, "image/svg"))
+        {
+            return;
+        }
+
+        Encoding encoding = selectEncoding(
+            req.getHeaderValue(crow::KnownHeader::acceptEncoding));
+        std::string& body = res.body();
+        if (body.empty() && !res.jsonValue.empty() &&
+            !http_helpers::requestPrefersHtml(req))
+        {
+            if (encoding == Encoding::none)
+            {
+                // Nothing to gain here; the connection serializes it and
+                // can stream it if it's big
+                res.addHeader("Vary", "Accept-Encoding");
+                return;
+            }
+            // Serialize the JSON here, the same way the connection would
+            // have, so the result can be compressed
+            res.addHeader("Content-Type", "application/json");
+            body = res.jsonValue.dump(2);
+        }
+        if (body.size() < minSize)
+        {
+            return;
+        }
+
+        // The compressibility of this response depends on the client
+        res.addHeader("Vary", "Accept-Encoding");
+        if (encoding == Encoding::none)
+        {
+            return;
+        }
+
+        std::string compressed;
+        if (!gzipDeflate(body, compressed, level, encoding == Encoding::gzip))
+        {
+            BMCWEB_LOG_ERROR << "Failed to compress response";
+            return;
+        }
+        if (compressed.size() >= body.size())
+        {
+            return;
+        }
+        body = std::move(compressed);
+        res.addHeader("Content-Encoding",
+                      encoding == Encoding::gzip ? "gzip" : "deflate");
+    }
+
+  private:
+    size_t minSize = 1024;
+    // The BMC CPU is slow, and the fastest level already gets most of the
+    // gain on JSON
+    int level = Z_BEST_SPEED;
+};
+
+} // namespace compression
+} // namespace crow
@@ -0,0 +1,74 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace crow
+{
+namespace obmc_console
+{
+
+// Host console output kept for sessions that connect later
+constexpr size_t scrollbackSize = 64 * 1024;
+
+// The last scrollbackSize bytes of console output, in a ring.  Positions
+// count every byte ever appended, so a reader can keep one as its cursor.
+class Scrollback
+{
+  public:
+    void append(const char* data, size_t size)
+    {
+        // Only the tail that fits will ever be read
+        if (size > buffer.size())
+        {
+            data += size - buffer.size();
+            written += size - buffer.size();
+            size = buffer.size();
+        }
+        size_t pos = written % buffer.size();
+        size_t first = std::min(size, buffer.size() - pos);
+        std::memcpy(&buffer[pos], data, first);
+        std::memcpy(&buffer[0], data + first, size - first);
+        written += size;
+    }
+
+    // Position of the oldest byte still held
+    uint64_t begin() const
+    {
+        return written > buffer.size() ? written - buffer.size() : 0;
+    }
+
+    // Position after the newest byte
+    uint64_t end() const
+    {
+        return written;
+    }
+
+    // The bytes from position from on; from the oldest held if the ring has
+    // already overwritten from
+    std::string read(uint64_t from) const
+    {
+        from = std::max(from, begin());
+        std::string out;
+        if (from >= written)
+        {
+            return out;
+        }
+        size_t count = static_cast<size_t>(written - from);
+        size_t pos = static_cast<size_t>(from % buffer.size());
+        size_t first = std::min(count, buffer.size() - pos);
+        out.reserve(count);
+        out.append(&buffer[pos], first);
+        out.append(&buffer[0], count - first);
+        return out;
+    }
+
+  private:
+    std::array<char, scrollbackSize> buffer;
+    uint64_t written = 0;
+};
+
+} // namespace obmc_console
+} // namespace crow
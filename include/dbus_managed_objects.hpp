@@ -0,0 +1,258 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace crow
+{
+namespace connections
+{
+
+// Every interface and property name read into a ManagedObjects, each kept
+// once for the life of the process.  The names a BMC's services use are a
+// few hundred, so they are never dropped, and the same name is always the
+// same pointer.
+class NameTable
+{
+  public:
+    const std::string* intern(const char* name)
+    {
+        return &*names.emplace(name).first;
+    }
+
+    const std::string* intern(const std::string& name)
+    {
+        return &*names.insert(name).first;
+    }
+
+    // The interned name, or nullptr if nothing was ever read with it
+    const std::string* find(const std::string& name) const
+    {
+        auto it = names.find(name);
+        if (it == names.end())
+        {
+            return nullptr;
+        }
+        return &*it;
+    }
+
+    size_t size() const
+    {
+        return names.size();
+    }
+
+  private:
+    // Elements of a node based set don't move
+    std::unordered_set<std::string> names;
+};
+
+inline NameTable& nameTable()
+{
+    static NameTable table;
+    return table;
+}
+
+// A contiguous run of elements, for range for
+template <typename T> class Range
+{
+  public:
+    Range(const T* first, const T* last) : first(first), last(last)
+    {
+    }
+
+    const T* begin() const
+    {
+        return first;
+    }
+
+    const T* end() const
+    {
+        return last;
+    }
+
+    size_t size() const
+    {
+        return static_cast<size_t>(last - first);
+    }
+
+    bool empty() const
+    {
+        return first == last;
+    }
+
+  private:
+    const T* first;
+    const T* last;
+};
+
+/**
+ * @brief The objects, interfaces and properties of a GetManagedObjects
+ *        reply, or of any a{oa{sa{sv}}} or a{sv}, read into three arrays
+ *
+ * Reading into nested flat_maps costs a map per object and per interface,
+ * and a copy of every interface and property name of every object.  Here
+ * each object is its path and a run of interfaces, each interface its
+ * interned name and a run of properties, and each property its interned
+ * name and value:
+ *
+ *   for (const auto& object : objects.objects())
+ *       for (const auto& interface : objects.interfaces(object))
+ *           for (const auto& property : objects.properties(interface))
+ *               use(*property.name, property.value);
+ *
+ * Objects, interfaces and properties are in the order they were read, and
+ * the addresses of what a built ManagedObjects holds don't change, so
+ * replies can be shared as shared_ptr<const ManagedObjects>.  Lookups by
+ * name go through the interfaces or properties of one object, which are
+ * few.
+ *
+ * @tparam Variant  Type the values are read into
+ */
+template <typename Variant> class ManagedObjects
+{
+  public:
+    struct Property
+    {
+        const std::string* name;
+        Variant value;
+    };
+
+    struct Interface
+    {
+        const std::string* name;
+        // Index of the first property, and one past the last
+        uint32_t first;
+        uint32_t last;
+    };
+
+    struct Object
+    {
+        std::string path;
+        // Index of the first interface, and one past the last
+        uint32_t first;
+        uint32_t last;
+    };
+
+    Range<Object> objects() const
+    {
+        return Range<Object>(objectList.data(),
+                             objectList.data() + objectList.size());
+    }
+
+    Range<Interface> interfaces(const Object& object) const
+    {
+        return Range<Interface>(interfaceList.data() + object.first,
+                                interfaceList.data() + object.last);
+    }
+
+    Range<Property> properties(const Interface& interface) const
+    {
+        return Range<Property>(propertyList.data() + interface.first,
+                               propertyList.data() + interface.last);
+    }
+
+    // Properties of the interface added last, as when reading an a{sv}
+    Range<Property> properties() const
+    {
+        if (interfaceList.empty())
+        {
+            return Range<Property>(nullptr, nullptr);
+        }
+        return properties(interfaceList.back());
+    }
+
+    const Object* findObject(const std::string& path) const
+    {
+        for (const Object& object : objectList)
+        {
+            if (object.path == path)
+            {
+                return &object;
+            }
+        }
+        return nullptr;
+    }
+
+    const Interface* find(const Object& object,
+                          const std::string& interface) const
+    {
+        const std::string* name = nameTable().find(interface);
+        if (name == nullptr)
+        {
+            return nullptr;
+        }
+        for (const Interface& candidate : interfaces(object))
+        {
+            if (candidate.name == name)
+            {
+                return &candidate;
+            }
+        }
+        return nullptr;
+    }
+
+    // The value of property, or nullptr if the interface doesn't have it
+    const Variant* find(const Interface& interface,
+                        const std::string& property) const
+    {
+        const std::string* name = nameTable().find(property);
+        if (name == nullptr)
+        {
+            return nullptr;
+        }
+        for (const Property& candidate : properties(interface))
+        {
+            if (candidate.name == name)
+            {
+                return &candidate.value;
+            }
+        }
+        return nullptr;
+    }
+
+    // Builds the arrays in reading order: an object, then its interfaces,
+    // each followed by its properties.  An interface added before any
+    // object, as when reading an a{sv}, belongs to none.
+    void addObject(std::string path)
+    {
+        uint32_t next = static_cast<uint32_t>(interfaceList.size());
+        objectList.push_back(Object{std::move(path), next, next});
+    }
+
+    void addInterface(const std::string* name)
+    {
+        uint32_t next = static_cast<uint32_t>(propertyList.size());
+        interfaceList.push_back(Interface{name, next, next});
+        if (!objectList.empty())
+        {
+            objectList.back().last =
+                static_cast<uint32_t>(interfaceList.size());
+        }
+    }
+
+    void addProperty(const std::string* name, Variant&& value)
+    {
+        propertyList.push_back(Property{name, std::move(value)});
+        interfaceList.back().last = static_cast<uint32_t>(propertyList.size());
+    }
+
+    size_t objectCount() const
+    {
+        return objectList.size();
+    }
+
+    size_t propertyCount() const
+    {
+        return propertyList.size();
+    }
+
+  private:
+    std::vector<Object> objectList;
+    std::vector<Interface> interfaceList;
+    std::vector<Property> propertyList;
+};
+
+} // namespace connections
+} // namespace crow
@@ -2,9 +2,13 @@
 #include <crow/app.h>
 #include <crow/websocket.h>
 
+#include <algorithm>
 #include <boost/container/flat_map.hpp>
 #include <boost/container/flat_set.hpp>
+#include <dbus_monitor_compact.hpp>
 #include <dbus_singleton.hpp>
+#include <memory>
+#include <regex>
 #include <sdbusplus/bus/match.hpp>
 
 namespace nlohmann
@@ -26,14 +30,159 @@ namespace dbus_monitor
 
 struct DbusWebsocketSession
 {
-    std::vector<std::unique_ptr<sdbusplus::bus::match::match>> matches;
+    // Match rules this session is subscribed to
+    boost::container::flat_set<std::string> rules;
     boost::container::flat_set<std::string> interfaces;
+    // Set for the compact formats; null for json
+    std::unique_ptr<CompactEncoder> encoder;
 };
 
 static boost::container::flat_map<crow::websocket::Connection*,
                                   DbusWebsocketSession>
     sessions;
 
+inline int onPropertyUpdate(sd_bus_message* m, void* userdata,
+                            sd_bus_error* ret_error);
+
+// Installs each distinct match rule on the bus once, however many sessions
+// ask for it, and drops it when the last of them goes away.  A signal is
+// encoded once and the same buffer is queued on every subscriber using the
+// json format; sessions using a compact one each get their own.
+class SubscriptionRegistry
+{
+  public:
+    struct Subscription
+    {
+        std::unique_ptr<sdbusplus::bus::match::match> match;
+        std::vector<crow::websocket::Connection*> subscribers;
+    };
+
+    void subscribe(const std::string& rule,
+                   crow::websocket::Connection* connection)
+    {
+        std::unique_ptr<Subscription>& subscription = subscriptions[rule];
+        if (subscription == nullptr)
+        {
+            BMCWEB_LOG_DEBUG << "Creating match " << rule;
+            subscription = std::make_unique<Subscription>();
+            // The Subscription doesn't move, so it can be the match's
+            // userdata
+            subscription->match =
+                std::make_unique<sdbusplus::bus::match::match>(
+                    *crow::connections::systemBus, rule, onPropertyUpdate,
+                    subscription.get());
+        }
+        std::vector<crow::websocket::Connection*>& subscribers =
+            subscription->subscribers;
+        if (std::find(subscribers.begin(), subscribers.end(), connection) ==
+            subscribers.end())
+        {
+            subscribers.push_back(connection);
+        }
+    }
+
+    void unsubscribe(const std::string& rule,
+                     crow::websocket::Connection* connection)
+    {
+        auto it = subscriptions.find(rule);
+        if (it == subscriptions.end())
+        {
+            return;
+        }
+        std::vector<crow::websocket::Connection*>& subscribers =
+            it->second->subscribers;
+        subscribers.erase(
+            std::remove(subscribers.begin(), subscribers.end(), connection),
+            subscribers.end());
+        if (subscribers.empty())
+        {
+            BMCWEB_LOG_DEBUG << "Removing match " << rule;
+            subscriptions.erase(it);
+        }
+    }
+
+    // Distinct rules installed on the bus
+    size_t size() const
+    {
+        return subscriptions.size();
+    }
+
+  private:
+    boost::container::flat_map<std::string, std::unique_ptr<Subscription>>
+        subscriptions;
+};
+
+inline SubscriptionRegistry& subscriptionRegistry()
+{
+    static SubscriptionRegistry registry;
+    return registry;
+}
+
+inline void subscribe(crow::websocket::Connection& conn,
+                      DbusWebsocketSession& session, const std::string& rule)
+{
+    if (session.rules.insert(rule).second)
+    {
+        subscriptionRegistry().subscribe(rule, &conn);
+    }
+}
+
+inline void unsubscribeAll(crow::websocket::Connection& conn,
+                           DbusWebsocketSession& session)
+{
+    for (const std::string& rule : session.rules)
+    {
+        subscriptionRegistry().unsubscribe(rule, &conn);
+    }
+    session.rules.clear();
+}
+
+inline void sendEncoded(crow::websocket::Connection& connection,
+                        const CompactEncoder& encoder, std::string&& key,
+                        std::string&& message)
+{
+    auto payload = std::make_shared<const std::string>(std::move(message));
+    if (encoder.binary())
+    {
+        connection.sendBinaryUpdate(std::move(key), std::move(payload));
+    }
+    else
+    {
+        connection.sendTextUpdate(std::move(key), std::move(payload));
+    }
+}
+
+inline void sendCompact(crow::websocket::Connection& connection,
+                        CompactEncoder& encoder, const std::string& path,
+                        const std::string& interface,
+                        const nlohmann::json& properties)
+{
+    std::string message;
+    std::string key;
+    if (encoder.encodeProperties(path, interface, properties, message, key))
+    {
+        sendEncoded(connection, encoder, std::move(key), std::move(message));
+    }
+}
+
+// The message is as in the json format; the values it carries are the ones
+// later changes are compared with
+inline void sendAdded(crow::websocket::Connection& connection,
+                      CompactEncoder& encoder, const std::string& path,
+                      const nlohmann::json& message)
+{
+    auto interfaces = message.find("interfaces");
+    if (interfaces != message.end())
+    {
+        for (auto interface = interfaces->begin();
+             interface != interfaces->end(); ++interface)
+        {
+            encoder.setValues(path, interface.key(), *interface);
+        }
+    }
+    sendEncoded(connection, encoder, std::string(), encoder.encode(message));
+}
+
 inline int onPropertyUpdate(sd_bus_message* m, void* userdata,
                             sd_bus_error* ret_error)
 {
@@ -42,14 +191,8 @@ inline int onPropertyUpdate(sd_bus_message* m, void* userdata,
         BMCWEB_LOG_ERROR << "Got sdbus error on match";
         return 0;
     }
-    crow::websocket::Connection* connection =
-        static_cast<crow::websocket::Connection*>(userdata);
-    auto thisSession = sessions.find(connection);
-    if (thisSession == sessions.end())
-    {
-        BMCWEB_LOG_ERROR << "Couldn't find dbus connection " << connection;
-        return 0;
-    }
+    SubscriptionRegistry::Subscription* subscription =
+        static_cast<SubscriptionRegistry::Subscription*>(userdata);
     sdbusplus::message::message message(m);
     using VariantType = sdbusplus::message::variant<std::string, bool, int64_t,
                                                     uint64_t, double>;
@@ -60,8 +203,39 @@ inline int onPropertyUpdate(sd_bus_message* m, void* userdata,
         std::string interface_name;
         boost::container::flat_map<std::string, VariantType> values;
         message.read(interface_name, values);
+
+        // A newer change to the same properties makes a queued one stale
+        std::string key = message.get_path();
+        key += ' ';
+        key += interface_name;
+        for (const auto& value : values)
+        {
+            key += ' ';
+            key += value.first;
+        }
+
         j["properties"] = values;
-        j["interface"] = std::move(interface_name);
+        j["interface"] = interface_name;
+
+        std::string path = message.get_path();
+        std::shared_ptr<const std::string> encoded;
+        for (crow::websocket::Connection* connection :
+             subscription->subscribers)
+        {
+            auto thisSession = sessions.find(connection);
+            if (thisSession != sessions.end() &&
+                thisSession->second.encoder != nullptr)
+            {
+                sendCompact(*connection, *thisSession->second.encoder, path,
+                            interface_name, j["properties"]);
+                continue;
+            }
+            if (encoded == nullptr)
+            {
+                encoded = std::make_shared<const std::string>(j.dump());
+            }
+            connection->sendTextUpdate(key, encoded);
+        }
     }
     else if (strcmp(message.get_member(), "InterfacesAdded") == 0)
     {
@@ -70,16 +244,65 @@ inline int onPropertyUpdate(sd_bus_message* m, void* userdata,
             std::string, boost::container::flat_map<std::string, VariantType>>
             values;
         message.read(object_name, values);
-        for (const std::pair<
-                 std::string,
-                 boost::container::flat_map<std::string, VariantType>>& paths :
-             values)
+
+        // Each session only sees the interfaces it asked for, so the
+        // message is built once per distinct interface filter, and encoded
+        // once for the json sessions with that filter
+        struct Encoding
         {
-            auto it = thisSession->second.interfaces.find(paths.first);
-            if (it != thisSession->second.interfaces.end())
+            const boost::container::flat_set<std::string>* interfaces;
+            nlohmann::json filtered;
+            std::shared_ptr<const std::string> text;
+        };
+        std::vector<Encoding> encodings;
+        for (crow::websocket::Connection* connection :
+             subscription->subscribers)
+        {
+            auto thisSession = sessions.find(connection);
+            if (thisSession == sessions.end())
+            {
+                BMCWEB_LOG_ERROR << "Couldn't find dbus connection "
+                                 << connection;
+                continue;
+            }
+            const boost::container::flat_set<std::string>& interfaces =
+                thisSession->second.interfaces;
+            auto encoding = std::find_if(
+                encodings.begin(), encodings.end(),
+                [&interfaces](const Encoding& encoding) {
+                    return *encoding.interfaces == interfaces;
+                });
+            if (encoding == encodings.end())
             {
-                j["interfaces"][paths.first] = paths.second;
+                nlohmann::json filtered = j;
+                for (const std::pair<std::string,
+                                     boost::container::flat_map<
+                                         std::string, VariantType>>& paths :
+                     values)
+                {
+                    auto it = interfaces.find(paths.first);
+                    if (it != interfaces.end())
+                    {
+                        filtered["interfaces"][paths.first] = paths.second;
+                    }
+                }
+                encodings.push_back(
+                    Encoding{&interfaces, std::move(filtered), nullptr});
+                encoding = encodings.end() - 1;
             }
+            CompactEncoder* encoder = thisSession->second.encoder.get();
+            if (encoder != nullptr)
+            {
+                sendAdded(*connection, *encoder, object_name,
+                          encoding->filtered);
+                continue;
+            }
+            if (encoding->text == nullptr)
+            {
+                encoding->text = std::make_shared<const std::string>(
+                    encoding->filtered.dump());
+            }
+            connection->sendText(encoding->text);
         }
     }
     else
@@ -88,8 +311,6 @@ inline int onPropertyUpdate(sd_bus_message* m, void* userdata,
                             << " was unexpected";
         return 0;
     }
-
-    connection->sendText(j.dump());
     return 0;
 };
 
@@ -97,12 +318,21 @@ template <typename... Middlewares> void requestRoutes(Crow<Middlewares...>& app)
 {
     BMCWEB_ROUTE(app, "/subscribe")
         .websocket()
+        .outboundQueue(256 * 1024, crow::websocket::OverflowPolicy::coalesce)
+        .permessageDeflate()
         .onopen([&](crow::websocket::Connection& conn) {
             BMCWEB_LOG_DEBUG << "Connection " << &conn << " opened";
             sessions[&conn] = DbusWebsocketSession();
         })
         .onclose([&](crow::websocket::Connection& conn,
-                     const std::string& reason) { sessions.erase(&conn); })
+                     const std::string& reason) {
+            auto thisSession = sessions.find(&conn);
+            if (thisSession != sessions.end())
+            {
+                unsubscribeAll(conn, thisSession->second);
+                sessions.erase(thisSession);
+            }
+        })
         .onmessage([&](crow::websocket::Connection& conn,
                        const std::string& data, bool is_binary) {
             DbusWebsocketSession& thisSession = sessions[&conn];
@@ -114,6 +344,30 @@ template <typename... Middlewares> void requestRoutes(Crow<Middlewares...>& app)
                 conn.close("Unable to parse json request");
                 return;
             }
+            nlohmann::json::iterator reset = j.find("reset");
+            if (reset != j.end() && thisSession.encoder != nullptr &&
+                *reset == true)
+            {
+                thisSession.encoder->reset();
+            }
+            nlohmann::json::iterator format = j.find("format");
+            if (format != j.end())
+            {
+                const std::string* name = format->get_ptr<const std::string*>();
+                Format parsed = Format::json;
+                if (name == nullptr || !parseFormat(*name, parsed))
+                {
+                    BMCWEB_LOG_ERROR << "Unknown subscription format";
+                    conn.close("Unknown format");
+                    return;
+                }
+                thisSession.encoder.reset();
+                if (parsed != Format::json)
+                {
+                    thisSession.encoder =
+                        std::make_unique<CompactEncoder>(parsed);
+                }
+            }
             nlohmann::json::iterator interfaces = j.find("interfaces");
             if (interfaces != j.end())
             {
@@ -130,19 +384,9 @@ template <typename... Middlewares> void requestRoutes(Crow<Middlewares...>& app)
             }
 
             nlohmann::json::iterator paths = j.find("paths");
-            if (paths != j.end())
+            if (paths == j.end())
             {
-                int interfaceCount = thisSession.interfaces.size();
-                if (interfaceCount == 0)
-                {
-                    interfaceCount = 1;
-                }
-                // Reserve our matches upfront.  For each path there is 1 for
-                // interfacesAdded, and InterfaceCount number for
-                // PropertiesChanged
-                thisSession.matches.reserve(thisSession.matches.size() +
-                                            paths->size() *
-                                                (1 + interfaceCount));
+                return;
             }
             std::string object_manager_match_string;
             std::string properties_match_string;
@@ -180,13 +424,7 @@ template <typename... Middlewares> void requestRoutes(Crow<Middlewares...>& app)
                 // interfaces
                 if (thisSession.interfaces.size() == 0)
                 {
-                    BMCWEB_LOG_DEBUG << "Creating match "
-                                     << properties_match_string;
-
-                    thisSession.matches.emplace_back(
-                        std::make_unique<sdbusplus::bus::match::match>(
-                            *crow::connections::systemBus,
-                            properties_match_string, onPropertyUpdate, &conn));
+                    subscribe(conn, thisSession, properties_match_string);
                 }
                 else
                 {
@@ -204,12 +442,7 @@ template <typename... Middlewares> void requestRoutes(Crow<Middlewares...>& app)
                         std::string ifaceMatchString = properties_match_string +
                                                        ",arg0='" + interface +
                                                        "'";
-                        BMCWEB_LOG_DEBUG << "Creating match "
-                                         << ifaceMatchString;
-                        thisSession.matches.emplace_back(
-                            std::make_unique<sdbusplus::bus::match::match>(
-                                *crow::connections::systemBus, ifaceMatchString,
-                                onPropertyUpdate, &conn));
+                        subscribe(conn, thisSession, ifaceMatchString);
                     }
                 }
                 object_manager_match_string =
@@ -219,12 +452,7 @@ template <typename... Middlewares> void requestRoutes(Crow<Middlewares...>& app)
                      *thisPathString +
                      "',"
                      "member='InterfacesAdded'");
-                BMCWEB_LOG_DEBUG << "Creating match "
-                                 << object_manager_match_string;
-                thisSession.matches.emplace_back(
-                    std::make_unique<sdbusplus::bus::match::match>(
-                        *crow::connections::systemBus,
-                        object_manager_match_string, onPropertyUpdate, &conn));
+                subscribe(conn, thisSession, object_manager_match_string);
             }
         });
 }
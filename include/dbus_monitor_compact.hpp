@@ -0,0 +1,208 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <utility>
+
+namespace crow
+{
+namespace dbus_monitor
+{
+
+// How a /subscribe session wants its events, from the "format" of its
+// request
+enum class Format
+{
+    // One JSON text message per signal, with the path and interface
+    json,
+    // See CompactEncoder; as JSON text, or as binary CBOR or MessagePack
+    compact,
+    cbor,
+    msgpack
+};
+
+// false if name isn't one of the formats
+inline bool parseFormat(const std::string& name, Format& format)
+{
+    if (name == "json")
+    {
+        format = Format::json;
+    }
+    else if (name == "compact")
+    {
+        format = Format::compact;
+    }
+    else if (name == "cbor")
+    {
+        format = Format::cbor;
+    }
+    else if (name == "msgpack")
+    {
+        format = Format::msgpack;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Encodes PropertiesChanged signals for one session in the compact
+ *        formats
+ *
+ * Each object path and interface pair gets a small id the first time a
+ * change of it is sent, and only the message doing so carries the path and
+ * interface:
+ *
+ *   {"id": 1, "path": "/xyz/openbmc_project/sensors/temperature/cpu0",
+ *    "interface": "xyz.openbmc_project.Sensor.Value",
+ *    "properties": {"Value": 41.5}}
+ *   {"id": 1, "properties": {"Value": 42.0}}
+ *
+ * Properties whose value is the same as the last one sent are left out, and
+ * a signal that changes nothing sends nothing.  InterfacesAdded messages
+ * are as in the json format.  A client that lost messages, or sees an id
+ * it doesn't know, sends {"reset": true} to have everything sent in full
+ * again.
+ */
+class CompactEncoder
+{
+  public:
+    explicit CompactEncoder(Format format) : format(format)
+    {
+    }
+
+    // Whether messages go out as binary frames
+    bool binary() const
+    {
+        return format == Format::cbor || format == Format::msgpack;
+    }
+
+    /**
+     * @brief Encodes the properties of path and interface that changed
+     *        since they were last sent
+     *
+     * @param[in] properties  Object of the properties in the signal
+     * @param[out] message    Receives the encoded message
+     * @param[out] key        Receives the key a newer message for the same
+     *                        properties replaces this one under; empty if
+     *                        the message mustn't be replaced
+     *
+     * @return false if nothing changed, and there is nothing to send
+     */
+    bool encodeProperties(const std::string& path,
+                          const std::string& interface,
+                          const nlohmann::json& properties,
+                          std::string& message, std::string& key)
+    {
+        Object& object = find(path, interface);
+        nlohmann::json changed = nlohmann::json::object();
+        for (auto property = properties.begin(); property != properties.end();
+             ++property)
+        {
+            nlohmann::json& last = object.values[property.key()];
+            if (last != *property)
+            {
+                last = *property;
+                changed[property.key()] = *property;
+            }
+        }
+        if (changed.empty() && object.defined)
+        {
+            return false;
+        }
+        nlohmann::json out{{"id", object.id},
+                           {"properties", std::move(changed)}};
+        key.clear();
+        if (object.defined)
+        {
+            key = std::to_string(object.id);
+            for (auto property = out["properties"].begin();
+                 property != out["properties"].end(); ++property)
+            {
+                key += ' ';
+                key += property.key();
+            }
+        }
+        else
+        {
+            out["path"] = path;
+            out["interface"] = interface;
+            object.defined = true;
+        }
+        message = encode(out);
+        return true;
+    }
+
+    // Records values the client got some other way, as from InterfacesAdded
+    void setValues(const std::string& path, const std::string& interface,
+                   const nlohmann::json& properties)
+    {
+        Object& object = find(path, interface);
+        for (auto property = properties.begin(); property != properties.end();
+             ++property)
+        {
+            object.values[property.key()] = *property;
+        }
+    }
+
+    std::string encode(const nlohmann::json& message) const
+    {
+        std::string out;
+        if (format == Format::cbor)
+        {
+            nlohmann::json::to_cbor(message, out);
+        }
+        else if (format == Format::msgpack)
+        {
+            nlohmann::json::to_msgpack(message, out);
+        }
+        else
+        {
+            out = message.dump();
+        }
+        return out;
+    }
+
+    // Forgets every id and value sent
+    void reset()
+    {
+        objects.clear();
+        lastId = 0;
+    }
+
+    // Path and interface pairs with an id
+    size_t size() const
+    {
+        return objects.size();
+    }
+
+  private:
+    struct Object
+    {
+        uint64_t id = 0;
+        // Whether the client has been told the path and interface
+        bool defined = false;
+        // As last sent
+        nlohmann::json values = nlohmann::json::object();
+    };
+
+    Object& find(const std::string& path, const std::string& interface)
+    {
+        Object& object = objects[std::make_pair(path, interface)];
+        if (object.id == 0)
+        {
+            object.id = ++lastId;
+        }
+        return object;
+    }
+
+    Format format;
+    std::map<std::pair<std::string, std::string>, Object> objects;
+    uint64_t lastId = 0;
+};
+
+} // namespace dbus_monitor
+} // namespace crow
@@ -0,0 +1,488 @@
+#pragma once
+#include <systemd/sd-bus.h>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <cstdint>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace crow
+{
+namespace connections
+{
+
+// One node of a compiled D-Bus type signature.  The nodes of a signature are
+// stored in prefix order, so the children of a container are the nodes
+// following it, up to its end.
+struct SignatureOp
+{
+    // The type code: a basic type, 'a', 'v', '(' or '{'
+    char code;
+    // Index one past the last node of this type
+    uint32_t end;
+    // For containers, the signature of what they contain, as
+    // sd_bus_message_open_container expects it
+    std::string contents;
+};
+
+// A type signature parsed once into the steps that convert JSON to it
+struct CompiledSignature
+{
+    std::vector<SignatureOp> ops;
+    // Index of the first node of each complete type in the signature
+    std::vector<uint32_t> types;
+};
+
+namespace detail
+{
+
+inline bool isBasicType(char code)
+{
+    switch (code)
+    {
+        case 'y':
+        case 'b':
+        case 'n':
+        case 'q':
+        case 'i':
+        case 'u':
+        case 'x':
+        case 't':
+        case 'd':
+        case 's':
+        case 'o':
+        case 'g':
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Compiles the complete type starting at signature[pos], and moves pos past
+// it
+inline bool compileType(const std::string& signature, size_t& pos,
+                        std::vector<SignatureOp>& ops, size_t depth)
+{
+    // The D-Bus limit of 32 arrays and 32 structs
+    if (pos >= signature.size() || depth > 64)
+    {
+        return false;
+    }
+    char code = signature[pos];
+    size_t index = ops.size();
+    ops.push_back(SignatureOp{code, 0, std::string()});
+    size_t start = pos++;
+
+    if (code == 'a')
+    {
+        if (!compileType(signature, pos, ops, depth + 1))
+        {
+            return false;
+        }
+        ops[index].contents = signature.substr(start + 1, pos - start - 1);
+    }
+    else if (code == '(' || code == '{')
+    {
+        char close = code == '(' ? ')' : '}';
+        // Dict entries are only found in arrays, and have a basic key
+        if (code == '{' && (index == 0 || ops[index - 1].code != 'a'))
+        {
+            return false;
+        }
+        size_t members = 0;
+        while (pos < signature.size() && signature[pos] != close)
+        {
+            if (code == '{' && members == 0 && !isBasicType(signature[pos]))
+            {
+                return false;
+            }
+            if (!compileType(signature, pos, ops, depth + 1))
+            {
+                return false;
+            }
+            members++;
+        }
+        if (pos >= signature.size() || members == 0 ||
+            (code == '{' && members != 2))
+        {
+            return false;
+        }
+        pos++;
+        ops[index].contents = signature.substr(start + 1, pos - start - 2);
+    }
+    else if (code != 'v' && !isBasicType(code))
+    {
+        return false;
+    }
+    ops[index].end = static_cast<uint32_t>(ops.size());
+    return true;
+}
+
+// Integer and floating point views of a JSON number.  uint can be converted
+// to int, and int and uint can be converted to double.
+struct JsonNumber
+{
+    explicit JsonNumber(const nlohmann::json& j)
+    {
+        intValue = j.get_ptr<const int64_t*>();
+        uintValue = j.get_ptr<const uint64_t*>();
+        doubleValue = j.get_ptr<const double*>();
+        if (uintValue != nullptr && intValue == nullptr)
+        {
+            i = static_cast<int64_t>(*uintValue);
+            intValue = &i;
+        }
+        if (intValue != nullptr && doubleValue == nullptr)
+        {
+            d = uintValue != nullptr ? static_cast<double>(*uintValue)
+                                     : static_cast<double>(*intValue);
+            doubleValue = &d;
+        }
+    }
+
+    const int64_t* intValue;
+    const uint64_t* uintValue;
+    const double* doubleValue;
+    int64_t i = 0;
+    double d = 0.0;
+};
+
+template <typename T>
+int appendInt(sd_bus_message* m, char code, const int64_t* value)
+{
+    if (value == nullptr)
+    {
+        return -1;
+    }
+    T v = static_cast<T>(*value);
+    return sd_bus_message_append_basic(m, code, &v);
+}
+
+template <typename T>
+int appendUint(sd_bus_message* m, char code, const uint64_t* value)
+{
+    if (value == nullptr)
+    {
+        return -1;
+    }
+    T v = static_cast<T>(*value);
+    return sd_bus_message_append_basic(m, code, &v);
+}
+
+inline int appendJson(sd_bus_message* m, const CompiledSignature& signature,
+                      uint32_t index, const nlohmann::json& j);
+
+inline int appendBasic(sd_bus_message* m, char code, const nlohmann::json& j)
+{
+    const std::string* stringValue = j.get_ptr<const std::string*>();
+    switch (code)
+    {
+        case 's':
+        case 'o':
+        case 'g':
+            if (stringValue == nullptr)
+            {
+                return -1;
+            }
+            return sd_bus_message_append_basic(m, code, stringValue->c_str());
+        case 'b':
+        {
+            // lots of ways bool could be represented here.  Try them all
+            int boolInt = 0;
+            const bool* b = j.get_ptr<const bool*>();
+            JsonNumber number(j);
+            if (number.intValue != nullptr)
+            {
+                boolInt = *number.intValue > 0 ? 1 : 0;
+            }
+            else if (b != nullptr)
+            {
+                boolInt = *b ? 1 : 0;
+            }
+            else if (stringValue != nullptr)
+            {
+                boolInt = boost::istarts_with(*stringValue, "t") ? 1 : 0;
+            }
+            else
+            {
+                return -1;
+            }
+            return sd_bus_message_append_basic(m, code, &boolInt);
+        }
+        default:
+            break;
+    }
+
+    JsonNumber number(j);
+    switch (code)
+    {
+        case 'n':
+            return appendInt<int16_t>(m, code, number.intValue);
+        case 'i':
+            return appendInt<int32_t>(m, code, number.intValue);
+        case 'x':
+            return appendInt<int64_t>(m, code, number.intValue);
+        case 'y':
+            return appendUint<uint8_t>(m, code, number.uintValue);
+        case 'q':
+            return appendUint<uint16_t>(m, code, number.uintValue);
+        case 'u':
+            return appendUint<uint32_t>(m, code, number.uintValue);
+        case 't':
+            return appendUint<uint64_t>(m, code, number.uintValue);
+        case 'd':
+            if (number.doubleValue == nullptr)
+            {
+                return -1;
+            }
+            return sd_bus_message_append_basic(m, code, number.doubleValue);
+        default:
+            return -2;
+    }
+}
+
+// A variant takes the type of the JSON value it is given
+inline int appendVariant(sd_bus_message* m, const nlohmann::json& j)
+{
+    const char* contents = nullptr;
+    switch (j.type())
+    {
+        case nlohmann::json::value_t::string:
+            contents = "s";
+            break;
+        case nlohmann::json::value_t::boolean:
+            contents = "b";
+            break;
+        case nlohmann::json::value_t::number_integer:
+            contents = "x";
+            break;
+        case nlohmann::json::value_t::number_unsigned:
+            contents = "t";
+            break;
+        case nlohmann::json::value_t::number_float:
+            contents = "d";
+            break;
+        default:
+            return -1;
+    }
+    int r = sd_bus_message_open_container(m, SD_BUS_TYPE_VARIANT, contents);
+    if (r < 0)
+    {
+        return r;
+    }
+    r = appendBasic(m, contents[0], j);
+    if (r < 0)
+    {
+        return r;
+    }
+    return sd_bus_message_close_container(m);
+}
+
+inline int appendArray(sd_bus_message* m, const CompiledSignature& signature,
+                       uint32_t index, const nlohmann::json& j)
+{
+    const SignatureOp& op = signature.ops[index];
+    const SignatureOp& element = signature.ops[index + 1];
+    int r = sd_bus_message_open_container(m, SD_BUS_TYPE_ARRAY,
+                                          op.contents.c_str());
+    if (r < 0)
+    {
+        return r;
+    }
+    if (element.code == '{')
+    {
+        // A dict is a JSON object; its keys are strings, so keys of other
+        // types are parsed from them
+        if (!j.is_object())
+        {
+            return -1;
+        }
+        char keyCode = signature.ops[index + 2].code;
+        for (const auto& item : j.items())
+        {
+            r = sd_bus_message_open_container(m, SD_BUS_TYPE_DICT_ENTRY,
+                                              element.contents.c_str());
+            if (r < 0)
+            {
+                return r;
+            }
+            if (keyCode == 's' || keyCode == 'o' || keyCode == 'g')
+            {
+                r = appendBasic(m, keyCode, item.key());
+            }
+            else
+            {
+                r = appendBasic(
+                    m, keyCode,
+                    nlohmann::json::parse(item.key(), nullptr, false));
+            }
+            if (r < 0)
+            {
+                return r;
+            }
+            r = appendJson(m, signature, index + 3, item.value());
+            if (r < 0)
+            {
+                return r;
+            }
+            r = sd_bus_message_close_container(m);
+            if (r < 0)
+            {
+                return r;
+            }
+        }
+    }
+    else
+    {
+        if (!j.is_array())
+        {
+            return -1;
+        }
+        for (const nlohmann::json& item : j)
+        {
+            r = appendJson(m, signature, index + 1, item);
+            if (r < 0)
+            {
+                return r;
+            }
+        }
+    }
+    return sd_bus_message_close_container(m);
+}
+
+inline int appendStruct(sd_bus_message* m, const CompiledSignature& signature,
+                        uint32_t index, const nlohmann::json& j)
+{
+    const SignatureOp& op = signature.ops[index];
+    if (!j.is_array())
+    {
+        return -1;
+    }
+    int r = sd_bus_message_open_container(m, SD_BUS_TYPE_STRUCT,
+                                          op.contents.c_str());
+    if (r < 0)
+    {
+        return r;
+    }
+    nlohmann::json::const_iterator it = j.begin();
+    for (uint32_t member = index + 1; member < op.end;
+         member = signature.ops[member].end)
+    {
+        if (it == j.end())
+        {
+            return -1;
+        }
+        r = appendJson(m, signature, member, *it);
+        if (r < 0)
+        {
+            return r;
+        }
+        it++;
+    }
+    if (it != j.end())
+    {
+        return -1;
+    }
+    return sd_bus_message_close_container(m);
+}
+
+inline int appendJson(sd_bus_message* m, const CompiledSignature& signature,
+                      uint32_t index, const nlohmann::json& j)
+{
+    switch (signature.ops[index].code)
+    {
+        case 'a':
+            return appendArray(m, signature, index, j);
+        case '(':
+            return appendStruct(m, signature, index, j);
+        case 'v':
+            return appendVariant(m, j);
+        default:
+            return appendBasic(m, signature.ops[index].code, j);
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Compiles a D-Bus type signature
+ *
+ * @return nullptr if signature isn't valid
+ */
+inline std::shared_ptr<const CompiledSignature>
+    compileSignature(const std::string& signature)
+{
+    auto compiled = std::make_shared<CompiledSignature>();
+    size_t pos = 0;
+    while (pos < signature.size())
+    {
+        compiled->types.push_back(static_cast<uint32_t>(compiled->ops.size()));
+        if (!detail::compileType(signature, pos, compiled->ops, 0))
+        {
+            return nullptr;
+        }
+    }
+    return compiled;
+}
+
+// The handful of signatures the services use, compiled once.  Only touched
+// from the io thread that parses introspection data.
+inline std::shared_ptr<const CompiledSignature>
+    cachedSignature(const std::string& signature)
+{
+    static std::unordered_map<std::string,
+                              std::shared_ptr<const CompiledSignature>>
+        signatures;
+    auto it = signatures.find(signature);
+    if (it != signatures.end())
+    {
+        return it->second;
+    }
+    std::shared_ptr<const CompiledSignature> compiled =
+        compileSignature(signature);
+    // Keeps odd signatures from growing the map without end
+    if (signatures.size() < 256)
+    {
+        signatures.emplace(signature, compiled);
+    }
+    return compiled;
+}
+
+/**
+ * @brief Appends JSON to a message as the types of a compiled signature
+ *
+ * A signature of more than one complete type takes a JSON array with one
+ * element for each.
+ *
+ * @return < 0 if the JSON doesn't convert, or the append failed
+ */
+inline int convertJsonToDbus(sd_bus_message* m,
+                             const CompiledSignature& signature,
+                             const nlohmann::json& j)
+{
+    if (signature.types.size() == 1)
+    {
+        return detail::appendJson(m, signature, 0, j);
+    }
+    if (!j.is_array() || j.size() != signature.types.size())
+    {
+        return -2;
+    }
+    nlohmann::json::const_iterator it = j.begin();
+    for (uint32_t type : signature.types)
+    {
+        int r = detail::appendJson(m, signature, type, *it);
+        if (r < 0)
+        {
+            return r;
+        }
+        it++;
+    }
+    return 0;
+}
+
+} // namespace connections
+} // namespace crow
@@ -0,0 +1,914 @@
+#pragma once
+#include <crow/logging.h>
+#include <crow/server_metrics.h>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/asio/io_service.hpp>
+#include <boost/callable_traits/args.hpp>
+#include <boost/system/error_code.hpp>
+#include <boost/utility/string_view.hpp>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <dbus_managed_objects.hpp>
+#include <dbus_singleton.hpp>
+#include <functional>
+#include <map>
+#include <memory>
+#include <sdbusplus/bus/match.hpp>
+#include <string>
+#include <systemd/sd-bus.h>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace crow
+{
+namespace connections
+{
+namespace detail
+{
+
+// One object per type, whose address identifies the type without RTTI
+template <typename T> struct TypeTag
+{
+    static const char id;
+};
+template <typename T> const char TypeTag<T>::id = 0;
+
+// Method call arguments are written into the key with their sizes, so that
+// no two different argument lists end up with the same key
+inline void appendKey(std::string& key, boost::string_view value)
+{
+    uint32_t size = static_cast<uint32_t>(value.size());
+    key.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    key.append(value.data(), value.size());
+}
+
+inline void appendKey(std::string& key, const std::string& value)
+{
+    appendKey(key, boost::string_view(value));
+}
+
+inline void appendKey(std::string& key, const char* value)
+{
+    appendKey(key, boost::string_view(value));
+}
+
+template <typename T>
+typename std::enable_if<std::is_arithmetic<T>::value>::type
+    appendKey(std::string& key, T value)
+{
+    key.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+void appendKey(std::string& key, const std::vector<T>& values);
+
+template <typename T, size_t N>
+void appendKey(std::string& key, const std::array<T, N>& values)
+{
+    appendKey(key, static_cast<uint32_t>(N));
+    for (const T& value : values)
+    {
+        appendKey(key, value);
+    }
+}
+
+template <typename T>
+void appendKey(std::string& key, const std::vector<T>& values)
+{
+    appendKey(key, static_cast<uint32_t>(values.size()));
+    for (const T& value : values)
+    {
+        appendKey(key, value);
+    }
+}
+
+// The types a method call handler takes its reply as, without the leading
+// error_code
+template <typename Args> struct ReplyOf;
+
+template <typename ErrorCode, typename... Reply>
+struct ReplyOf<std::tuple<ErrorCode, Reply...>>
+{
+    using type = std::tuple<std::decay_t<Reply>...>;
+};
+
+// Identifies a method call: what is called, with which arguments, and the
+// types its reply is read into
+template <typename Reply, typename... InputArgs>
+std::string makeCallKey(const std::string& service, const std::string& path,
+                        const std::string& interface, const std::string& method,
+                        const InputArgs&... args)
+{
+    std::string key;
+    appendKey(key, service);
+    appendKey(key, path);
+    appendKey(key, interface);
+    appendKey(key, method);
+    // Expands to nothing but the calls, in order
+    int expand[] = {0, (appendKey(key, args), 0)...};
+    static_cast<void>(expand);
+    const char* tag =
+        &TypeTag<std::tuple<Reply, std::decay_t<InputArgs>...>>::id;
+    key.append(reinterpret_cast<const char*>(&tag), sizeof(tag));
+    return key;
+}
+
+// The parameters of a method call handler after the leading error_code, as
+// it declares them
+template <typename Args> struct HandlerArgs;
+
+template <typename ErrorCode, typename... Args>
+struct HandlerArgs<std::tuple<ErrorCode, Args...>>
+{
+    using type = std::tuple<Args...>;
+};
+
+template <typename Handler, typename Reply, size_t... Index>
+void callWithReply(Handler& handler, const Reply& reply,
+                   std::index_sequence<Index...>)
+{
+    handler(boost::system::error_code(), std::get<Index>(reply)...);
+}
+
+} // namespace detail
+
+// Where the time serving a request goes while it waits on D-Bus: the latency
+// of the method calls bmcweb makes, and how many of them failed or timed out,
+// by service, interface and method.  Calls are only made from the handler
+// io_service, so there is no locking.
+class MethodCallStats
+{
+  public:
+    struct Method
+    {
+        LatencyHistogram latency;
+        uint64_t errors = 0;
+        uint64_t timeouts = 0;
+    };
+
+    // Calls slower than this are logged, with their object path
+    static constexpr std::chrono::milliseconds slowCall()
+    {
+        return std::chrono::milliseconds(1000);
+    }
+
+    Method& method(const std::string& service, const std::string& interface,
+                   const std::string& method)
+    {
+        Key key(service, interface, method);
+        auto it = methods.find(key);
+        if (it != methods.end())
+        {
+            return *it->second;
+        }
+        // Services called by their unique name could add a key per
+        // connection; don't let them grow the map without end
+        if (methods.size() >= maxMethods())
+        {
+            return overflow;
+        }
+        return *methods.emplace(key, std::make_unique<Method>())
+                    .first->second;
+    }
+
+    void record(Method& method, std::chrono::steady_clock::duration elapsed,
+                const boost::system::error_code& ec)
+    {
+        method.latency.record(
+            std::chrono::duration_cast<std::chrono::microseconds>(elapsed));
+        if (ec)
+        {
+            method.errors++;
+            if (ec.value() == ETIMEDOUT)
+            {
+                method.timeouts++;
+            }
+        }
+    }
+
+    // The stats of every method called, in Prometheus text format
+    void appendMetrics(std::string& out) const
+    {
+        out += "# HELP bmcweb_dbus_call_duration_seconds Time D-Bus method "
+               "calls took to be answered\n"
+               "# TYPE bmcweb_dbus_call_duration_seconds histogram\n";
+        forEach([&out](const std::string& labels, const Method& method) {
+            appendHistogram(out, "bmcweb_dbus_call_duration_seconds", labels,
+                            method.latency);
+        });
+        out += "# HELP bmcweb_dbus_call_errors_total D-Bus method calls "
+               "answered with an error\n"
+               "# TYPE bmcweb_dbus_call_errors_total counter\n";
+        forEach([&out](const std::string& labels, const Method& method) {
+            out += "bmcweb_dbus_call_errors_total{" + labels + "} " +
+                   std::to_string(method.errors) + "\n";
+        });
+        out += "# HELP bmcweb_dbus_call_timeouts_total D-Bus method calls "
+               "that timed out\n"
+               "# TYPE bmcweb_dbus_call_timeouts_total counter\n";
+        forEach([&out](const std::string& labels, const Method& method) {
+            out += "bmcweb_dbus_call_timeouts_total{" + labels + "} " +
+                   std::to_string(method.timeouts) + "\n";
+        });
+    }
+
+    size_t size() const
+    {
+        return methods.size();
+    }
+
+  private:
+    using Key = std::tuple<std::string, std::string, std::string>;
+
+    static constexpr size_t maxMethods()
+    {
+        return 256;
+    }
+
+    template <typename Callback>
+    void forEach(Callback&& callback) const
+    {
+        for (const auto& entry : methods)
+        {
+            std::string labels = "service=\"";
+            crow::detail::appendLabel(labels, std::get<0>(entry.first));
+            labels += "\",interface=\"";
+            crow::detail::appendLabel(labels, std::get<1>(entry.first));
+            labels += "\",method=\"";
+            crow::detail::appendLabel(labels, std::get<2>(entry.first));
+            labels += '"';
+            callback(labels, *entry.second);
+        }
+        if (overflow.latency.count() != 0)
+        {
+            callback("service=\"(other)\",interface=\"\",method=\"\"",
+                     overflow);
+        }
+    }
+
+    std::map<Key, std::unique_ptr<Method>> methods;
+    Method overflow;
+};
+
+inline MethodCallStats& methodCallStats()
+{
+    static MethodCallStats stats;
+    return stats;
+}
+
+namespace detail
+{
+
+template <typename... Args, typename Bus, typename Handler,
+          typename... InputArgs>
+void tracedCall(std::tuple<Args...>*, Bus& bus, MethodCallStats& stats,
+                Handler&& handler, const std::string& service,
+                const std::string& path, const std::string& interface,
+                const std::string& method, const InputArgs&... args)
+{
+    MethodCallStats::Method* entry = &stats.method(service, interface, method);
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    // Takes the reply as the handler declares it, so that the bus reads it
+    // into the same types
+    bus.async_method_call(
+        [&stats, entry, start, path, method,
+         handler{std::forward<Handler>(handler)}](
+            const boost::system::error_code ec, Args... reply) mutable {
+            std::chrono::steady_clock::duration elapsed =
+                std::chrono::steady_clock::now() - start;
+            stats.record(*entry, elapsed, ec);
+            if (elapsed > MethodCallStats::slowCall())
+            {
+                BMCWEB_LOG_WARNING
+                    << "D-Bus call " << method << " on " << path << " took "
+                    << std::chrono::duration_cast<std::chrono::milliseconds>(
+                           elapsed)
+                           .count()
+                    << "ms";
+            }
+            handler(ec, std::forward<Args>(reply)...);
+        },
+        service, path, interface, method, args...);
+}
+
+} // namespace detail
+
+// Same as bus.async_method_call(), but records how long the call took, and
+// whether it failed, in stats
+template <typename Bus, typename Handler, typename... InputArgs>
+void tracedMethodCall(Bus& bus, MethodCallStats& stats, Handler&& handler,
+                      const std::string& service, const std::string& path,
+                      const std::string& interface, const std::string& method,
+                      const InputArgs&... args)
+{
+    using Args = typename detail::HandlerArgs<
+        boost::callable_traits::args_t<std::decay_t<Handler>>>::type;
+    detail::tracedCall(static_cast<Args*>(nullptr), bus, stats,
+                       std::forward<Handler>(handler), service, path,
+                       interface, method, args...);
+}
+
+// Merges identical method calls that are in flight at the same time into a
+// single bus round trip.  A call made while an identical one (same service,
+// path, interface, method, arguments and reply type) is still waiting for
+// its reply doesn't go out; its handler is called with the reply of the
+// first one instead.  Every handler gets the reply as const references, and
+// a call made after the reply came back goes out again, so nothing is
+// cached.  Only use it for methods without side effects.
+class MethodCallCoalescer
+{
+  public:
+    template <typename Bus, typename Handler, typename... InputArgs>
+    void asyncMethodCall(Bus& bus, Handler&& handler,
+                         const std::string& service, const std::string& path,
+                         const std::string& interface,
+                         const std::string& method, const InputArgs&... args)
+    {
+        using Reply = typename detail::ReplyOf<boost::callable_traits::args_t<
+            std::decay_t<Handler>>>::type;
+        call(static_cast<Reply*>(nullptr), bus, std::forward<Handler>(handler),
+             service, path, interface, method, args...);
+    }
+
+    // Calls sent to the bus that haven't been answered yet
+    size_t inFlightCount() const
+    {
+        return inFlight.size();
+    }
+
+  private:
+    template <typename... Reply, typename Bus, typename Handler,
+              typename... InputArgs>
+    void call(std::tuple<Reply...>*, Bus& bus, Handler&& handler,
+              const std::string& service, const std::string& path,
+              const std::string& interface, const std::string& method,
+              const InputArgs&... args)
+    {
+        using Waiter = std::function<void(const boost::system::error_code&,
+                                          const Reply&...)>;
+        using Waiters = std::vector<Waiter>;
+
+        std::string key = detail::makeCallKey<std::tuple<Reply...>>(
+            service, path, interface, method, args...);
+        auto it = inFlight.find(key);
+        if (it != inFlight.end())
+        {
+            // The key covers the reply type, so this is the type stored
+            std::static_pointer_cast<Waiters>(it->second)
+                ->emplace_back(std::forward<Handler>(handler));
+            return;
+        }
+        auto waiters = std::make_shared<Waiters>();
+        waiters->emplace_back(std::forward<Handler>(handler));
+        inFlight.emplace(key, waiters);
+
+        tracedMethodCall(
+            bus, methodCallStats(),
+            [this, key{std::move(key)},
+             waiters](const boost::system::error_code ec,
+                      const Reply&... reply) {
+                // Anything asked from here on, including by the handlers
+                // below, gets a round trip of its own
+                inFlight.erase(key);
+                for (Waiter& waiter : *waiters)
+                {
+                    waiter(ec, reply...);
+                }
+            },
+            service, path, interface, method, args...);
+    }
+
+    std::unordered_map<std::string, std::shared_ptr<void>> inFlight;
+};
+
+// Answers ObjectMapper queries from memory.  The mapper's view of the bus
+// only changes when objects or interfaces come and go, or when a service
+// starts or stops, so the whole cache is dropped on any InterfacesAdded,
+// InterfacesRemoved or NameOwnerChanged signal.  A signal may reach us
+// before the mapper has caught up with it, so entries also expire after
+// maxAge(), which bounds how long such a stale answer can be served.
+class MapperCache
+{
+  public:
+    using clock = std::chrono::steady_clock;
+
+    static constexpr std::chrono::seconds maxAge()
+    {
+        return std::chrono::seconds(30);
+    }
+
+    // Subscribes to the signals that invalidate the cache.  Until this is
+    // called, and after stop(), every query goes to the mapper.
+    void start(sdbusplus::asio::connection& bus, boost::asio::io_service& io)
+    {
+        ioService = &io;
+        auto onChange = [this](sdbusplus::message::message& message) {
+            invalidate();
+        };
+        matches.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+            bus,
+            "type='signal',interface='org.freedesktop.DBus.ObjectManager',"
+            "member='InterfacesAdded'",
+            onChange));
+        matches.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+            bus,
+            "type='signal',interface='org.freedesktop.DBus.ObjectManager',"
+            "member='InterfacesRemoved'",
+            onChange));
+        matches.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+            bus,
+            "type='signal',sender='org.freedesktop.DBus',"
+            "interface='org.freedesktop.DBus',member='NameOwnerChanged'",
+            [this](sdbusplus::message::message& message) {
+                std::string name;
+                message.read(name);
+                // Every client connecting announces its unique name, and
+                // the mapper only tracks services by their well known ones
+                if (!boost::starts_with(name, ":"))
+                {
+                    invalidate();
+                }
+            }));
+    }
+
+    // Drops the signal matches; has to happen before the bus goes away
+    void stop()
+    {
+        matches.clear();
+        ioService = nullptr;
+        entries.clear();
+    }
+
+    // Lets tests use the cache without the bus signals
+    void setIoService(boost::asio::io_service* io)
+    {
+        ioService = io;
+    }
+
+    template <typename Bus, typename Handler, typename... InputArgs>
+    void asyncMethodCall(Bus& bus, MethodCallCoalescer& coalescer,
+                         Handler&& handler, const std::string& service,
+                         const std::string& path, const std::string& interface,
+                         const std::string& method, const InputArgs&... args)
+    {
+        using Reply = typename detail::ReplyOf<boost::callable_traits::args_t<
+            std::decay_t<Handler>>>::type;
+        call(static_cast<Reply*>(nullptr), bus, coalescer,
+             std::forward<Handler>(handler), service, path, interface, method,
+             args...);
+    }
+
+    void invalidate()
+    {
+        if (!entries.empty())
+        {
+            BMCWEB_LOG_DEBUG << "Mapper cache dropped after " << hitCount
+                             << " hits, " << missCount << " misses";
+        }
+        entries.clear();
+        generation++;
+        invalidationCount++;
+    }
+
+    uint64_t hits() const
+    {
+        return hitCount;
+    }
+
+    uint64_t misses() const
+    {
+        return missCount;
+    }
+
+    uint64_t invalidations() const
+    {
+        return invalidationCount;
+    }
+
+    size_t size() const
+    {
+        return entries.size();
+    }
+
+  private:
+    // Keeps a burst of distinct queries from growing the cache without end
+    static constexpr size_t maxEntries()
+    {
+        return 512;
+    }
+
+    struct Entry
+    {
+        std::shared_ptr<const void> reply;
+        clock::time_point time;
+    };
+
+    template <typename... Reply, typename Bus, typename Handler,
+              typename... InputArgs>
+    void call(std::tuple<Reply...>*, Bus& bus, MethodCallCoalescer& coalescer,
+              Handler&& handler, const std::string& service,
+              const std::string& path, const std::string& interface,
+              const std::string& method, const InputArgs&... args)
+    {
+        using ReplyTuple = std::tuple<Reply...>;
+        if (ioService == nullptr ||
+            service != "xyz.openbmc_project.ObjectMapper")
+        {
+            coalescer.asyncMethodCall(bus, std::forward<Handler>(handler),
+                                      service, path, interface, method,
+                                      args...);
+            return;
+        }
+
+        std::string key = detail::makeCallKey<ReplyTuple>(
+            service, path, interface, method, args...);
+        clock::time_point now = clock::now();
+        auto it = entries.find(key);
+        if (it != entries.end() && now - it->second.time < maxAge())
+        {
+            hitCount++;
+            // The key covers the reply type, so this is the type stored
+            std::shared_ptr<const ReplyTuple> reply =
+                std::static_pointer_cast<const ReplyTuple>(it->second.reply);
+            // Reply asynchronously, like the bus would
+            ioService->post(
+                [handler{std::forward<Handler>(handler)},
+                 reply{std::move(reply)}]() mutable {
+                    detail::callWithReply(handler, *reply,
+                                          std::index_sequence_for<Reply...>());
+                });
+            return;
+        }
+        missCount++;
+
+        uint64_t startGeneration = generation;
+        coalescer.asyncMethodCall(
+            bus,
+            [this, key{std::move(key)}, now, startGeneration,
+             handler{std::forward<Handler>(handler)}](
+                const boost::system::error_code ec,
+                const Reply&... reply) mutable {
+                // Anything that changed while the call was out may not be
+                // in this reply
+                if (!ec && generation == startGeneration &&
+                    (entries.size() < maxEntries() || entries.count(key)))
+                {
+                    entries[key] = Entry{
+                        std::make_shared<const ReplyTuple>(reply...), now};
+                }
+                handler(ec, reply...);
+            },
+            service, path, interface, method, args...);
+    }
+
+    boost::asio::io_service* ioService = nullptr;
+    std::vector<std::unique_ptr<sdbusplus::bus::match::match>> matches;
+    std::unordered_map<std::string, Entry> entries;
+    uint64_t generation = 0;
+    uint64_t hitCount = 0;
+    uint64_t missCount = 0;
+    uint64_t invalidationCount = 0;
+};
+
+// Same as systemBus->async_method_call(), counted in methodCallStats().  For
+// calls that can't be coalesced, such as those that change something.
+template <typename Handler, typename... InputArgs>
+void tracedMethodCall(Handler&& handler, const std::string& service,
+                      const std::string& path, const std::string& interface,
+                      const std::string& method, const InputArgs&... args)
+{
+    tracedMethodCall(*systemBus, methodCallStats(),
+                     std::forward<Handler>(handler), service, path, interface,
+                     method, args...);
+}
+
+inline MethodCallCoalescer& methodCallCoalescer()
+{
+    static MethodCallCoalescer coalescer;
+    return coalescer;
+}
+
+// Same as systemBus->async_method_call(), but shares the reply of an
+// identical call that is already in flight.  See MethodCallCoalescer.
+template <typename Handler, typename... InputArgs>
+void coalescedMethodCall(Handler&& handler, const std::string& service,
+                         const std::string& path, const std::string& interface,
+                         const std::string& method, const InputArgs&... args)
+{
+    methodCallCoalescer().asyncMethodCall(
+        *systemBus, std::forward<Handler>(handler), service, path, interface,
+        method, args...);
+}
+
+inline MapperCache& mapperCache()
+{
+    static MapperCache cache;
+    return cache;
+}
+
+// Same as coalescedMethodCall(), but once mapperCache() is started,
+// ObjectMapper queries are answered from it.  Calls to other services go
+// straight through.
+template <typename Handler, typename... InputArgs>
+void cachedMethodCall(Handler&& handler, const std::string& service,
+                      const std::string& path, const std::string& interface,
+                      const std::string& method, const InputArgs&... args)
+{
+    mapperCache().asyncMethodCall(*systemBus, methodCallCoalescer(),
+                                  std::forward<Handler>(handler), service,
+                                  path, interface, method, args...);
+}
+
+namespace detail
+{
+
+// Reads the a{sv} at the read position of message into the properties of
+// the interface added last
+template <typename Variant>
+bool readPropertyArray(sdbusplus::message::message& message,
+                       ManagedObjects<Variant>& objects)
+{
+    sd_bus_message* m = message.get();
+    if (sd_bus_message_enter_container(m, SD_BUS_TYPE_ARRAY, "{sv}") <= 0)
+    {
+        return false;
+    }
+    int r = 0;
+    while ((r = sd_bus_message_enter_container(m, SD_BUS_TYPE_DICT_ENTRY,
+                                               "sv")) > 0)
+    {
+        const char* name = nullptr;
+        if (sd_bus_message_read_basic(m, SD_BUS_TYPE_STRING, &name) <= 0)
+        {
+            return false;
+        }
+        Variant value;
+        message.read(value);
+        objects.addProperty(nameTable().intern(name), std::move(value));
+        if (sd_bus_message_exit_container(m) < 0)
+        {
+            return false;
+        }
+    }
+    return r == 0 && sd_bus_message_exit_container(m) >= 0;
+}
+
+// Reads the a{sa{sv}} at the read position of message into interfaces of
+// the object added last
+template <typename Variant>
+bool readInterfaceArray(sdbusplus::message::message& message,
+                        ManagedObjects<Variant>& objects)
+{
+    sd_bus_message* m = message.get();
+    if (sd_bus_message_enter_container(m, SD_BUS_TYPE_ARRAY, "{sa{sv}}") <= 0)
+    {
+        return false;
+    }
+    int r = 0;
+    while ((r = sd_bus_message_enter_container(m, SD_BUS_TYPE_DICT_ENTRY,
+                                               "sa{sv}")) > 0)
+    {
+        const char* name = nullptr;
+        if (sd_bus_message_read_basic(m, SD_BUS_TYPE_STRING, &name) <= 0)
+        {
+            return false;
+        }
+        objects.addInterface(nameTable().intern(name));
+        if (!readPropertyArray(message, objects) ||
+            sd_bus_message_exit_container(m) < 0)
+        {
+            return false;
+        }
+    }
+    return r == 0 && sd_bus_message_exit_container(m) >= 0;
+}
+
+} // namespace detail
+
+/**
+ * @brief Reads a GetManagedObjects reply, an a{oa{sa{sv}}}, into objects
+ *
+ * Values of a type Variant doesn't hold are read as sdbusplus reads them
+ * into a map of Variant.
+ *
+ * @return false if the message isn't one, in which case objects may hold
+ *         part of it
+ */
+template <typename Variant>
+bool readManagedObjects(sdbusplus::message::message& message,
+                        ManagedObjects<Variant>& objects)
+{
+    sd_bus_message* m = message.get();
+    try
+    {
+        if (sd_bus_message_enter_container(m, SD_BUS_TYPE_ARRAY,
+                                           "{oa{sa{sv}}}") <= 0)
+        {
+            return false;
+        }
+        int r = 0;
+        while ((r = sd_bus_message_enter_container(m, SD_BUS_TYPE_DICT_ENTRY,
+                                                   "oa{sa{sv}}")) > 0)
+        {
+            const char* path = nullptr;
+            if (sd_bus_message_read_basic(m, SD_BUS_TYPE_OBJECT_PATH,
+                                          &path) <= 0)
+            {
+                return false;
+            }
+            objects.addObject(path);
+            if (!detail::readInterfaceArray(message, objects) ||
+                sd_bus_message_exit_container(m) < 0)
+            {
+                return false;
+            }
+        }
+        return r == 0 && sd_bus_message_exit_container(m) >= 0;
+    }
+    catch (const std::exception& e)
+    {
+        BMCWEB_LOG_ERROR << "Bad GetManagedObjects reply: " << e.what();
+        return false;
+    }
+}
+
+/**
+ * @brief Reads an InterfacesAdded signal, an o and an a{sa{sv}}, into an
+ *        object of objects
+ */
+template <typename Variant>
+bool readInterfacesAdded(sdbusplus::message::message& message,
+                         ManagedObjects<Variant>& objects)
+{
+    const char* path = nullptr;
+    if (sd_bus_message_read_basic(message.get(), SD_BUS_TYPE_OBJECT_PATH,
+                                  &path) <= 0)
+    {
+        return false;
+    }
+    objects.addObject(path);
+    try
+    {
+        return detail::readInterfaceArray(message, objects);
+    }
+    catch (const std::exception& e)
+    {
+        BMCWEB_LOG_ERROR << "Bad InterfacesAdded signal: " << e.what();
+        return false;
+    }
+}
+
+/**
+ * @brief Reads a GetAll reply, an a{sv}, into the properties of an
+ *        interface of no object; see ManagedObjects::properties()
+ */
+template <typename Variant>
+bool readProperties(sdbusplus::message::message& message,
+                    ManagedObjects<Variant>& objects)
+{
+    objects.addInterface(nullptr);
+    try
+    {
+        return detail::readPropertyArray(message, objects);
+    }
+    catch (const std::exception& e)
+    {
+        BMCWEB_LOG_ERROR << "Bad GetAll reply: " << e.what();
+        return false;
+    }
+}
+
+/**
+ * @brief Calls GetManagedObjects and GetAll and reads their replies into a
+ *        ManagedObjects
+ *
+ * Identical calls in flight share one round trip, as with
+ * MethodCallCoalescer, and one reply, which every handler gets as the same
+ * shared_ptr.  The calls are counted in methodCallStats().
+ */
+template <typename Variant> class ManagedObjectsReader
+{
+  public:
+    using Reply = std::shared_ptr<const ManagedObjects<Variant>>;
+    using Handler =
+        std::function<void(const boost::system::error_code&, const Reply&)>;
+
+    // The objects below path of the object manager there
+    template <typename Bus>
+    void getManagedObjects(Bus& bus, Handler&& handler,
+                           const std::string& service, const std::string& path)
+    {
+        call(bus, std::move(handler), service, path,
+             "org.freedesktop.DBus.ObjectManager", "GetManagedObjects",
+             nullptr);
+    }
+
+    // The properties of interface on path
+    template <typename Bus>
+    void getAllProperties(Bus& bus, Handler&& handler,
+                          const std::string& service, const std::string& path,
+                          const std::string& interface)
+    {
+        call(bus, std::move(handler), service, path,
+             "org.freedesktop.DBus.Properties", "GetAll", &interface);
+    }
+
+    size_t inFlightCount() const
+    {
+        return inFlight.size();
+    }
+
+  private:
+    using Waiters = std::vector<Handler>;
+
+    template <typename Bus>
+    void call(Bus& bus, Handler&& handler, const std::string& service,
+              const std::string& path, const std::string& interface,
+              const std::string& method, const std::string* argument)
+    {
+        std::string key = detail::makeCallKey<std::tuple<>>(
+            service, path, interface, method,
+            argument == nullptr ? std::string() : *argument);
+        auto it = inFlight.find(key);
+        if (it != inFlight.end())
+        {
+            it->second->emplace_back(std::move(handler));
+            return;
+        }
+        auto waiters = std::make_shared<Waiters>();
+        waiters->emplace_back(std::move(handler));
+        inFlight.emplace(key, waiters);
+
+        sdbusplus::message::message m = bus.new_method_call(
+            service.c_str(), path.c_str(), interface.c_str(), method.c_str());
+        if (argument != nullptr)
+        {
+            m.append(*argument);
+        }
+        MethodCallStats::Method* entry =
+            &methodCallStats().method(service, interface, method);
+        std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+        const bool getAll = argument != nullptr;
+        bus.async_send(m, [this, key{std::move(key)}, waiters, entry, start,
+                           getAll](boost::system::error_code ec,
+                                   sdbusplus::message::message& reply) {
+            inFlight.erase(key);
+            auto objects = std::make_shared<ManagedObjects<Variant>>();
+            if (!ec &&
+                (reply.is_method_error() ||
+                 !(getAll ? readProperties(reply, *objects)
+                          : readManagedObjects(reply, *objects))))
+            {
+                ec = boost::system::errc::make_error_code(
+                    boost::system::errc::bad_message);
+            }
+            methodCallStats().record(
+                *entry, std::chrono::steady_clock::now() - start, ec);
+            Reply shared = std::move(objects);
+            for (Handler& waiter : *waiters)
+            {
+                waiter(ec, shared);
+            }
+        });
+    }
+
+    std::unordered_map<std::string, std::shared_ptr<Waiters>> inFlight;
+};
+
+template <typename Variant>
+ManagedObjectsReader<Variant>& managedObjectsReader()
+{
+    static ManagedObjectsReader<Variant> reader;
+    return reader;
+}
+
+// GetManagedObjects of the object manager at path, read into a shared
+// ManagedObjects.  handler takes an error_code and a
+// ManagedObjectsReader<Variant>::Reply.
+template <typename Variant, typename Handler>
+void getManagedObjects(Handler&& handler, const std::string& service,
+                       const std::string& path)
+{
+    managedObjectsReader<Variant>().getManagedObjects(
+        *systemBus, std::forward<Handler>(handler), service, path);
+}
+
+// GetAll of interface on path; the reply's properties() are its properties
+template <typename Variant, typename Handler>
+void getAllProperties(Handler&& handler, const std::string& service,
+                      const std::string& path, const std::string& interface)
+{
+    managedObjectsReader<Variant>().getAllProperties(
+        *systemBus, std::forward<Handler>(handler), service, path, interface);
+}
+
+} // namespace connections
+} // namespace crow
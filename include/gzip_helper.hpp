@@ -61,5 +61,39 @@ inline bool gzipInflate(const std::string& compressedBytes,
         }
     }
 
+    // Drop the unused tail of the last resize
+    uncompressedBytes.resize(strm.total_out);
     return inflateEnd(&strm) == Z_OK;
-}
\ No newline at end of file
+}
+
+// Compresses uncompressedBytes in one pass, straight into compressedBytes.
+// The output has a gzip wrapper if gzip is true, and a zlib one (HTTP's
+// "deflate" encoding) otherwise.
+inline bool gzipDeflate(const std::string& uncompressedBytes,
+                        std::string& compressedBytes,
+                        int level = Z_DEFAULT_COMPRESSION, bool gzip = true)
+{
+    z_stream strm{};
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    if (deflateInit2(&strm, level, Z_DEFLATED,
+                     gzip ? (16 + MAX_WBITS) : MAX_WBITS, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        return false;
+    }
+
+    // deflateBound() is an upper bound, so one deflate() call always finishes
+    compressedBytes.resize(deflateBound(&strm, uncompressedBytes.size()));
+
+    // Same constness cheat as gzipInflate
+    strm.next_in = (Bytef*)uncompressedBytes.data(); // NOLINT
+    strm.avail_in = uncompressedBytes.size();
+    strm.next_out = (Bytef*)&compressedBytes[0]; // NOLINT
+    strm.avail_out = compressedBytes.size();
+
+    int err = deflate(&strm, Z_FINISH);
+    compressedBytes.resize(strm.total_out);
+    deflateEnd(&strm);
+    return err == Z_STREAM_END;
+}
@@ -5,7 +5,7 @@ namespace http_helpers
 {
 inline bool requestPrefersHtml(const crow::Request& req)
 {
-    boost::string_view header = req.getHeaderValue("accept");
+    boost::string_view header = req.getHeaderValue(crow::KnownHeader::accept);
     std::vector<std::string> encodings;
     // chrome currently sends 6 accepts headers, firefox sends 4.
     encodings.reserve(6);
@@ -24,4 +24,118 @@ inline bool requestPrefersHtml(const crow::Request& req)
     }
     return false;
 }
+
+// Returns true if the If-None-Match header value matches etag.  A weak
+// comparison is fine for GET, so W/ prefixes are ignored on both sides.
+inline bool etagMatches(boost::string_view ifNoneMatch,
+                        boost::string_view etag)
+{
+    if (etag.starts_with("W/"))
+    {
+        etag.remove_prefix(2);
+    }
+    std::vector<std::string> tags;
+    boost::split(tags, ifNoneMatch, boost::is_any_of(","));
+    for (std::string& tag : tags)
+    {
+        boost::trim(tag);
+        if (boost::starts_with(tag, "W/"))
+        {
+            tag.erase(0, 2);
+        }
+        if (tag == "*" || tag == etag)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+enum class ByteRange
+{
+    // No usable range; send the whole resource
+    none,
+    satisfiable,
+    unsatisfiable
+};
+
+/**
+ * @brief Reads a Range header asking for a single byte range
+ *
+ * Several ranges in one header would need a multipart reply, so those are
+ * answered with the whole resource, as the header may be ignored.
+ *
+ * @param[in] header  Value of the Range header
+ * @param[in] size    Size of the resource
+ * @param[out] first  First byte of the range
+ * @param[out] length Bytes in the range
+ */
+inline ByteRange parseByteRange(boost::string_view header, uint64_t size,
+                                uint64_t& first, uint64_t& length)
+{
+    if (!header.starts_with("bytes="))
+    {
+        return ByteRange::none;
+    }
+    header.remove_prefix(6);
+    size_t dash = header.find('-');
+    if (dash == boost::string_view::npos ||
+        header.find(',') != boost::string_view::npos)
+    {
+        return ByteRange::none;
+    }
+    auto readNumber = [](boost::string_view digits, uint64_t& value) {
+        if (digits.empty() || digits.size() > 19)
+        {
+            return false;
+        }
+        value = 0;
+        for (char c : digits)
+        {
+            if (c < '0' || c > '9')
+            {
+                return false;
+            }
+            value = value * 10 + static_cast<uint64_t>(c - '0');
+        }
+        return true;
+    };
+    boost::string_view start = header.substr(0, dash);
+    boost::string_view end = header.substr(dash + 1);
+    uint64_t last = 0;
+    if (start.empty())
+    {
+        // The last n bytes
+        uint64_t suffix = 0;
+        if (!readNumber(end, suffix))
+        {
+            return ByteRange::none;
+        }
+        if (suffix == 0 || size == 0)
+        {
+            return ByteRange::unsatisfiable;
+        }
+        first = suffix >= size ? 0 : size - suffix;
+        length = size - first;
+        return ByteRange::satisfiable;
+    }
+    if (!readNumber(start, first))
+    {
+        return ByteRange::none;
+    }
+    if (!end.empty() && (!readNumber(end, last) || last < first))
+    {
+        return ByteRange::none;
+    }
+    if (first >= size)
+    {
+        return ByteRange::unsatisfiable;
+    }
+    if (end.empty() || last >= size)
+    {
+        last = size - 1;
+    }
+    length = last - first + 1;
+    return ByteRange::satisfiable;
+}
 } // namespace http_helpers
\ No newline at end of file
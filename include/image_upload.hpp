@@ -7,7 +7,7 @@
 #include <boost/uuid/uuid_io.hpp>
 #include <cstdio>
 #include <dbus_singleton.hpp>
-#include <fstream>
+#include <experimental/filesystem>
 #include <memory>
 
 namespace crow
@@ -17,6 +17,10 @@ namespace image_upload
 
 std::unique_ptr<sdbusplus::bus::match::match> fwUpdateMatcher;
 
+// Uploads are streamed here first.  It must be on the same filesystem as
+// /tmp/images to avoid a copy.
+constexpr const char* uploadStagingDirectory = "/tmp";
+
 inline void uploadImageHandler(const crow::Request& req, crow::Response& res,
                                const std::string& filename)
 {
@@ -87,16 +91,32 @@ inline void uploadImageHandler(const crow::Request& req, crow::Response& res,
     std::string filepath(
         "/tmp/images/" +
         boost::uuids::to_string(boost::uuids::random_generator()()));
-    BMCWEB_LOG_DEBUG << "Writing file to " << filepath;
-    std::ofstream out(filepath, std::ofstream::out | std::ofstream::binary |
-                                    std::ofstream::trunc);
-    out << req.body;
-    out.close();
+    BMCWEB_LOG_DEBUG << "Moving " << req.bodyFile << " (sha256 "
+                     << req.bodySha256 << ") to " << filepath;
+    // The upload was staged outside of /tmp/images so the image manager
+    // never sees a partial file; renaming it in is atomic
+    std::error_code ec;
+    std::experimental::filesystem::rename(req.bodyFile, filepath, ec);
+    if (ec)
+    {
+        // Not on the same filesystem
+        std::experimental::filesystem::copy_file(req.bodyFile, filepath, ec);
+    }
+    if (ec)
+    {
+        BMCWEB_LOG_ERROR << "Failed to move image to " << filepath << ": "
+                         << ec.message();
+        fwUpdateMatcher = nullptr;
+        timeout.cancel(ec);
+        res.result(boost::beast::http::status::internal_server_error);
+        res.end();
+    }
 }
 
 template <typename... Middlewares> void requestRoutes(Crow<Middlewares...>& app)
 {
     BMCWEB_ROUTE(app, "/upload/image/<str>")
+        .streamBodyToFile(uploadStagingDirectory)
         .methods("POST"_method,
                  "PUT"_method)([](const crow::Request& req, crow::Response& res,
                                   const std::string& filename) {
@@ -104,6 +124,7 @@ template <typename... Middlewares> void requestRoutes(Crow<Middlewares...>& app)
         });
 
     BMCWEB_ROUTE(app, "/upload/image")
+        .streamBodyToFile(uploadStagingDirectory)
         .methods("POST"_method, "PUT"_method)(
             [](const crow::Request& req, crow::Response& res) {
                 uploadImageHandler(req, res, "");
@@ -0,0 +1,378 @@
+#pragma once
+#include <crow/logging.h>
+#include <tinyxml2.h>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/asio/io_service.hpp>
+#include <boost/system/error_code.hpp>
+#include <chrono>
+#include <dbus_signature.hpp>
+#include <dbus_utility.hpp>
+#include <functional>
+#include <map>
+#include <memory>
+#include <sdbusplus/bus/match.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace crow
+{
+namespace connections
+{
+
+// What org.freedesktop.DBus.Introspectable.Introspect says about an object,
+// parsed into tables so that handlers don't walk the XML themselves
+struct IntrospectedArg
+{
+    std::string name;
+    std::string type;
+    // "in" or "out"; empty for signal arguments
+    std::string direction;
+    // type, compiled; null if it isn't a valid signature
+    std::shared_ptr<const CompiledSignature> signature;
+};
+
+// A method or a signal
+struct IntrospectedMember
+{
+    std::string name;
+    std::vector<IntrospectedArg> args;
+};
+
+struct IntrospectedProperty
+{
+    std::string name;
+    std::string type;
+    // type, compiled; null if it isn't a valid signature
+    std::shared_ptr<const CompiledSignature> signature;
+};
+
+struct IntrospectedInterface
+{
+    std::string name;
+    std::vector<IntrospectedMember> methods;
+    std::vector<IntrospectedMember> signals;
+    std::vector<IntrospectedProperty> properties;
+};
+
+struct IntrospectedObject
+{
+    std::vector<IntrospectedInterface> interfaces;
+    // Names of the child nodes, relative to the object
+    std::vector<std::string> children;
+
+    const IntrospectedInterface* findInterface(const std::string& name) const
+    {
+        for (const IntrospectedInterface& interface : interfaces)
+        {
+            if (interface.name == name)
+            {
+                return &interface;
+            }
+        }
+        return nullptr;
+    }
+};
+
+namespace detail
+{
+
+inline std::string attribute(const tinyxml2::XMLElement* element,
+                             const char* name)
+{
+    const char* value = element->Attribute(name);
+    return value == nullptr ? std::string() : std::string(value);
+}
+
+inline std::vector<IntrospectedArg>
+    parseArgs(const tinyxml2::XMLElement* member)
+{
+    std::vector<IntrospectedArg> args;
+    for (const tinyxml2::XMLElement* arg = member->FirstChildElement("arg");
+         arg != nullptr; arg = arg->NextSiblingElement("arg"))
+    {
+        std::string type = attribute(arg, "type");
+        std::shared_ptr<const CompiledSignature> signature =
+            cachedSignature(type);
+        args.push_back(IntrospectedArg{attribute(arg, "name"), std::move(type),
+                                       attribute(arg, "direction"),
+                                       std::move(signature)});
+    }
+    return args;
+}
+
+} // namespace detail
+
+/**
+ * @brief Parses the reply of an Introspect call
+ *
+ * @param[in] xml      Introspection data
+ * @param[out] object  Receives the tables
+ *
+ * @return false if xml has no root node
+ */
+inline bool parseIntrospection(const std::string& xml,
+                               IntrospectedObject& object)
+{
+    tinyxml2::XMLDocument doc;
+    doc.Parse(xml.c_str());
+    const tinyxml2::XMLElement* root = doc.FirstChildElement("node");
+    if (root == nullptr)
+    {
+        return false;
+    }
+
+    for (const tinyxml2::XMLElement* node = root->FirstChildElement("node");
+         node != nullptr; node = node->NextSiblingElement("node"))
+    {
+        object.children.push_back(detail::attribute(node, "name"));
+    }
+
+    for (const tinyxml2::XMLElement* iface =
+             root->FirstChildElement("interface");
+         iface != nullptr; iface = iface->NextSiblingElement("interface"))
+    {
+        IntrospectedInterface interface;
+        interface.name = detail::attribute(iface, "name");
+        for (const tinyxml2::XMLElement* method =
+                 iface->FirstChildElement("method");
+             method != nullptr; method = method->NextSiblingElement("method"))
+        {
+            interface.methods.push_back(IntrospectedMember{
+                detail::attribute(method, "name"), detail::parseArgs(method)});
+        }
+        for (const tinyxml2::XMLElement* signal =
+                 iface->FirstChildElement("signal");
+             signal != nullptr; signal = signal->NextSiblingElement("signal"))
+        {
+            interface.signals.push_back(IntrospectedMember{
+                detail::attribute(signal, "name"), detail::parseArgs(signal)});
+        }
+        for (const tinyxml2::XMLElement* property =
+                 iface->FirstChildElement("property");
+             property != nullptr;
+             property = property->NextSiblingElement("property"))
+        {
+            std::string type = detail::attribute(property, "type");
+            std::shared_ptr<const CompiledSignature> signature =
+                cachedSignature(type);
+            interface.properties.push_back(
+                IntrospectedProperty{detail::attribute(property, "name"),
+                                     std::move(type), std::move(signature)});
+        }
+        object.interfaces.push_back(std::move(interface));
+    }
+    return true;
+}
+
+// Answers Introspect calls from already parsed tables, keyed on service and
+// path.  An object's introspection data changes when interfaces come and go
+// on it or below it, and when its service restarts, so entries are dropped
+// on InterfacesAdded and InterfacesRemoved for the path or one of its
+// descendants, and on NameOwnerChanged for the service.  Services without an
+// ObjectManager don't send the former, so entries also expire after
+// maxAge().
+class IntrospectionCache
+{
+  public:
+    using clock = std::chrono::steady_clock;
+
+    // object is null if the reply wasn't introspection data
+    using Handler = std::function<void(
+        const boost::system::error_code&,
+        const std::shared_ptr<const IntrospectedObject>& object)>;
+
+    static constexpr std::chrono::seconds maxAge()
+    {
+        return std::chrono::seconds(60);
+    }
+
+    // Subscribes to the signals that invalidate the cache.  Until this is
+    // called, and after stop(), every lookup goes to the bus.
+    void start(sdbusplus::asio::connection& bus, boost::asio::io_service& io)
+    {
+        ioService = &io;
+        auto onInterfacesChanged =
+            [this](sdbusplus::message::message& message) {
+                sdbusplus::message::object_path path;
+                message.read(path);
+                invalidatePath(path.str);
+            };
+        matches.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+            bus,
+            "type='signal',interface='org.freedesktop.DBus.ObjectManager',"
+            "member='InterfacesAdded'",
+            onInterfacesChanged));
+        matches.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+            bus,
+            "type='signal',interface='org.freedesktop.DBus.ObjectManager',"
+            "member='InterfacesRemoved'",
+            onInterfacesChanged));
+        matches.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+            bus,
+            "type='signal',sender='org.freedesktop.DBus',"
+            "interface='org.freedesktop.DBus',member='NameOwnerChanged'",
+            [this](sdbusplus::message::message& message) {
+                std::string name;
+                message.read(name);
+                invalidateService(name);
+            }));
+    }
+
+    // Drops the signal matches; has to happen before the bus goes away
+    void stop()
+    {
+        matches.clear();
+        ioService = nullptr;
+        entries.clear();
+    }
+
+    // Lets tests use the cache without the bus signals
+    void setIoService(boost::asio::io_service* io)
+    {
+        ioService = io;
+    }
+
+    template <typename Bus>
+    void introspect(Bus& bus, MethodCallCoalescer& coalescer,
+                    const std::string& service, const std::string& path,
+                    Handler handler)
+    {
+        Key key(service, path);
+        clock::time_point now = clock::now();
+        if (ioService != nullptr)
+        {
+            auto it = entries.find(key);
+            if (it != entries.end() && now - it->second.time < maxAge())
+            {
+                hitCount++;
+                // Reply asynchronously, like the bus would
+                ioService->post([handler{std::move(handler)},
+                                 object{it->second.object}]() {
+                    handler(boost::system::error_code(), object);
+                });
+                return;
+            }
+        }
+        missCount++;
+
+        uint64_t startGeneration = generation;
+        coalescer.asyncMethodCall(
+            bus,
+            [this, key{std::move(key)}, now, startGeneration,
+             handler{std::move(handler)}](const boost::system::error_code ec,
+                                          const std::string& xml) {
+                if (ec)
+                {
+                    handler(ec, nullptr);
+                    return;
+                }
+                auto object = std::make_shared<IntrospectedObject>();
+                if (!parseIntrospection(xml, *object))
+                {
+                    BMCWEB_LOG_ERROR << "XML document failed to parse "
+                                     << key.first << " " << key.second;
+                    handler(ec, nullptr);
+                    return;
+                }
+                // Anything that changed while the call was out may not be
+                // in this reply
+                if (ioService != nullptr && generation == startGeneration &&
+                    (entries.size() < maxEntries() || entries.count(key)))
+                {
+                    entries[key] = Entry{object, now};
+                }
+                handler(ec, object);
+            },
+            service, path, "org.freedesktop.DBus.Introspectable",
+            "Introspect");
+    }
+
+    // Drops the entries for path and for every object above it, whose
+    // children may have changed
+    void invalidatePath(const std::string& path)
+    {
+        generation++;
+        for (auto it = entries.begin(); it != entries.end();)
+        {
+            const std::string& entryPath = it->first.second;
+            if (entryPath == path || entryPath == "/" ||
+                (boost::starts_with(path, entryPath) &&
+                 path[entryPath.size()] == '/'))
+            {
+                it = entries.erase(it);
+            }
+            else
+            {
+                it++;
+            }
+        }
+    }
+
+    void invalidateService(const std::string& service)
+    {
+        generation++;
+        auto it = entries.lower_bound(Key(service, std::string()));
+        while (it != entries.end() && it->first.first == service)
+        {
+            it = entries.erase(it);
+        }
+    }
+
+    uint64_t hits() const
+    {
+        return hitCount;
+    }
+
+    uint64_t misses() const
+    {
+        return missCount;
+    }
+
+    size_t size() const
+    {
+        return entries.size();
+    }
+
+  private:
+    // Keeps a walk over a large tree from growing the cache without end
+    static constexpr size_t maxEntries()
+    {
+        return 1024;
+    }
+
+    using Key = std::pair<std::string, std::string>;
+
+    struct Entry
+    {
+        std::shared_ptr<const IntrospectedObject> object;
+        clock::time_point time;
+    };
+
+    boost::asio::io_service* ioService = nullptr;
+    std::vector<std::unique_ptr<sdbusplus::bus::match::match>> matches;
+    // Ordered, so one service's entries are next to each other
+    std::map<Key, Entry> entries;
+    uint64_t generation = 0;
+    uint64_t hitCount = 0;
+    uint64_t missCount = 0;
+};
+
+inline IntrospectionCache& introspectionCache()
+{
+    static IntrospectionCache cache;
+    return cache;
+}
+
+// Introspects path on service through introspectionCache()
+inline void cachedIntrospect(const std::string& service,
+                             const std::string& path,
+                             IntrospectionCache::Handler handler)
+{
+    introspectionCache().introspect(*systemBus, methodCallCoalescer(), service,
+                                    path, std::move(handler));
+}
+
+} // namespace connections
+} // namespace crow
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <ast_jpeg_decoder.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace crow
+{
+namespace kvm
+{
+
+// A region of the framebuffer, in pixels
+struct DirtyRect
+{
+    uint16_t x;
+    uint16_t y;
+    uint16_t width;
+    uint16_t height;
+};
+
+/* Remembers a hash of every 16x16 tile of the last frame sent to a client,
+ * so that an incremental update only carries the tiles that changed since.
+ * The video engine's own change bitmap doesn't survive the decoder being
+ * recreated for each request, so the decoded pixels are hashed instead.
+ */
+class DirtyTileTracker
+{
+  public:
+    static constexpr unsigned tileSize()
+    {
+        return 16;
+    }
+
+    /**
+     * @brief Finds the parts of a frame that differ from the last one
+     *
+     * Changed tiles next to each other in a row make one rectangle, and
+     * rectangles spanning the same columns in successive rows are joined.
+     * A full update, a new frame size, or a frame where most tiles changed
+     * gives the whole frame as one rectangle.
+     *
+     * @param[in] frame        width * height pixels, a row after the other
+     * @param[in] incremental  If false, the client wants the whole frame
+     *
+     * @return The rectangles to send; empty if nothing changed
+     */
+    std::vector<DirtyRect> update(const ast_video::RGB *frame,
+                                  unsigned width, unsigned height,
+                                  bool incremental)
+    {
+        unsigned columns = (width + tileSize() - 1) / tileSize();
+        unsigned rows = (height + tileSize() - 1) / tileSize();
+        bool resized = width != frameWidth || height != frameHeight;
+        if (resized)
+        {
+            frameWidth = width;
+            frameHeight = height;
+            hashes.assign(static_cast<size_t>(columns) * rows, 0);
+        }
+
+        std::vector<bool> dirty(hashes.size());
+        size_t dirtyCount = 0;
+        for (unsigned row = 0; row < rows; row++)
+        {
+            for (unsigned column = 0; column < columns; column++)
+            {
+                size_t index = static_cast<size_t>(row) * columns + column;
+                uint64_t hash = hashTile(frame, column, row);
+                if (hash != hashes[index] || resized || !incremental)
+                {
+                    dirty[index] = true;
+                    dirtyCount++;
+                }
+                hashes[index] = hash;
+            }
+        }
+
+        std::vector<DirtyRect> rects;
+        if (dirtyCount == 0)
+        {
+            return rects;
+        }
+        if (dirtyCount * 2 > hashes.size())
+        {
+            rects.push_back(DirtyRect{0, 0, static_cast<uint16_t>(width),
+                                      static_cast<uint16_t>(height)});
+            return rects;
+        }
+
+        // The rectangles ending on the previous row of tiles, which the
+        // runs of this row can extend
+        std::vector<size_t> open;
+        std::vector<size_t> nextOpen;
+        for (unsigned row = 0; row < rows; row++)
+        {
+            nextOpen.clear();
+            unsigned column = 0;
+            while (column < columns)
+            {
+                if (!dirty[static_cast<size_t>(row) * columns + column])
+                {
+                    column++;
+                    continue;
+                }
+                unsigned first = column;
+                while (column < columns &&
+                       dirty[static_cast<size_t>(row) * columns + column])
+                {
+                    column++;
+                }
+                DirtyRect rect = clip(first, row, column - first);
+                nextOpen.push_back(extend(rects, open, rect));
+            }
+            open.swap(nextOpen);
+        }
+        return rects;
+    }
+
+    // Forgets the last frame, so that the next update is a full one
+    void reset()
+    {
+        hashes.clear();
+        frameWidth = 0;
+        frameHeight = 0;
+    }
+
+  private:
+    // FNV-1a over the tile's rows, eight bytes at a time
+    uint64_t hashTile(const ast_video::RGB *frame, unsigned column,
+                      unsigned row) const
+    {
+        unsigned x = column * tileSize();
+        unsigned y = row * tileSize();
+        unsigned tileWidth = std::min(tileSize(), frameWidth - x);
+        unsigned tileHeight = std::min(tileSize(), frameHeight - y);
+        size_t rowBytes = tileWidth * sizeof(ast_video::RGB);
+
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (unsigned line = 0; line < tileHeight; line++)
+        {
+            const auto *bytes = reinterpret_cast<const uint8_t *>(
+                frame + static_cast<size_t>(y + line) * frameWidth + x);
+            size_t i = 0;
+            for (; i + sizeof(uint64_t) <= rowBytes; i += sizeof(uint64_t))
+            {
+                uint64_t word;
+                std::memcpy(&word, bytes + i, sizeof(word));
+                hash = (hash ^ word) * 0x100000001b3ULL;
+            }
+            for (; i < rowBytes; i++)
+            {
+                hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+            }
+        }
+        // 0 stands for a tile not seen yet
+        return hash == 0 ? 1 : hash;
+    }
+
+    // The pixels of count tiles from column on row, within the frame
+    DirtyRect clip(unsigned column, unsigned row, unsigned count) const
+    {
+        unsigned x = column * tileSize();
+        unsigned y = row * tileSize();
+        unsigned width = std::min(count * tileSize(), frameWidth - x);
+        unsigned height = std::min(tileSize(), frameHeight - y);
+        return DirtyRect{static_cast<uint16_t>(x), static_cast<uint16_t>(y),
+                         static_cast<uint16_t>(width),
+                         static_cast<uint16_t>(height)};
+    }
+
+    // Grows the open rectangle above rect down over it, if one spans the
+    // same columns, or else adds rect; returns the index of either
+    static size_t extend(std::vector<DirtyRect> &rects,
+                         const std::vector<size_t> &open,
+                         const DirtyRect &rect)
+    {
+        for (size_t i : open)
+        {
+            DirtyRect &above = rects[i];
+            if (above.x == rect.x && above.width == rect.width)
+            {
+                above.height =
+                    static_cast<uint16_t>(above.height + rect.height);
+                return i;
+            }
+        }
+        rects.push_back(rect);
+        return rects.size() - 1;
+    }
+
+    std::vector<uint64_t> hashes;
+    unsigned frameWidth = 0;
+    unsigned frameHeight = 0;
+};
+
+// Writes the pixels of rect as raw encoding sends them: blue, green, red and
+// a pad byte.  out has room for rect.width * rect.height * 4 bytes.
+inline void rawPixels(const ast_video::RGB *frame, unsigned frameWidth,
+                      const DirtyRect &rect, uint8_t *out)
+{
+    for (unsigned y = rect.y; y < rect.y + rect.height; y++)
+    {
+        const ast_video::RGB *pixel =
+            frame + static_cast<size_t>(y) * frameWidth + rect.x;
+        for (unsigned x = 0; x < rect.width; x++, pixel++)
+        {
+            *out++ = pixel->b;
+            *out++ = pixel->g;
+            *out++ = pixel->r;
+            *out++ = 0;
+        }
+    }
+}
+
+inline std::vector<uint8_t> rawPixels(const ast_video::RGB *frame,
+                                      unsigned frameWidth,
+                                      const DirtyRect &rect)
+{
+    std::vector<uint8_t> data(static_cast<size_t>(rect.width) * rect.height *
+                              4);
+    rawPixels(frame, frameWidth, rect, data.data());
+    return data;
+}
+
+} // namespace kvm
+} // namespace crow
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <kvm_dirty_tiles.hpp>
+
+#include <boost/asio/buffer.hpp>
+#include <boost/endian/arithmetic.hpp>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace crow
+{
+namespace kvm
+{
+
+/* Keeps the pixel buffers of framebuffer updates for the next ones, so that
+ * sending a frame doesn't allocate and fault in megabytes every time.  A
+ * buffer goes back to the pool when the last copy of its pointer is dropped,
+ * which is once the websocket has written it, on whichever thread did.
+ */
+class FrameBufferPool
+{
+  public:
+    using Buffer = std::vector<uint8_t>;
+
+    // Buffers kept idle; one being filled and one being written per viewer
+    static constexpr size_t maxIdle()
+    {
+        return 4;
+    }
+
+    FrameBufferPool() : state(std::make_shared<State>())
+    {
+    }
+
+    // A buffer of size bytes, whose contents are left over from its last use
+    std::shared_ptr<Buffer> acquire(size_t size)
+    {
+        std::unique_ptr<Buffer> buffer;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (!state->idle.empty())
+            {
+                buffer = std::move(state->idle.back());
+                state->idle.pop_back();
+            }
+        }
+        if (buffer == nullptr)
+        {
+            buffer = std::make_unique<Buffer>();
+        }
+        buffer->resize(size);
+        // The deleter holds the state, so buffers can outlive the pool
+        std::shared_ptr<State> owner = state;
+        return std::shared_ptr<Buffer>(buffer.release(), [owner](Buffer* b) {
+            std::unique_ptr<Buffer> returned(b);
+            std::lock_guard<std::mutex> lock(owner->mutex);
+            if (owner->idle.size() < maxIdle())
+            {
+                owner->idle.push_back(std::move(returned));
+            }
+        });
+    }
+
+    size_t idle() const
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        return state->idle.size();
+    }
+
+  private:
+    struct State
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Buffer>> idle;
+    };
+
+    std::shared_ptr<State> state;
+};
+
+inline FrameBufferPool& frameBufferPool()
+{
+    static FrameBufferPool pool;
+    return pool;
+}
+
+// A FramebufferUpdate message as the buffers to write: the message and
+// rectangle headers, packed in one small string, and between them the
+// pixels of each rectangle, out of one pooled buffer
+struct EncodedUpdate
+{
+    std::string headers;
+    std::shared_ptr<FrameBufferPool::Buffer> pixels;
+    std::vector<boost::asio::const_buffer> buffers;
+};
+
+/**
+ * @brief Encodes the rectangles of a frame as a raw FramebufferUpdate
+ *
+ * @param[in] frame       frameWidth pixels a row
+ * @param[in] rects       The rectangles to send
+ * @param[in] pool        Where the pixel buffer comes from
+ *
+ * @return The message; its buffers point into it
+ */
+inline std::shared_ptr<const EncodedUpdate>
+    encodeRawUpdate(const ast_video::RGB* frame, unsigned frameWidth,
+                    const std::vector<DirtyRect>& rects,
+                    FrameBufferPool& pool)
+{
+    constexpr size_t messageHeaderSize = 4;
+    constexpr size_t rectHeaderSize = 12;
+    constexpr uint8_t framebufferUpdate = 0;
+    constexpr int32_t rawEncoding = 0;
+
+    auto update = std::make_shared<EncodedUpdate>();
+    size_t pixelBytes = 0;
+    for (const DirtyRect& rect : rects)
+    {
+        pixelBytes += static_cast<size_t>(rect.width) * rect.height * 4;
+    }
+    update->pixels = pool.acquire(pixelBytes);
+    update->headers.resize(messageHeaderSize + rectHeaderSize * rects.size());
+
+    char* header = &update->headers[0];
+    header[0] = static_cast<char>(framebufferUpdate);
+    header[1] = 0; // Pad byte
+    boost::endian::big_uint16_t count = static_cast<uint16_t>(rects.size());
+    std::memcpy(header + 2, &count, sizeof(count));
+    header += messageHeaderSize;
+
+    // Each header is written behind the pixels before it, so the message
+    // header and the first rectangle header make one buffer
+    const char* headerStart = update->headers.data();
+    uint8_t* pixels = update->pixels->data();
+    for (const DirtyRect& rect : rects)
+    {
+        boost::endian::big_uint16_t fields[4] = {rect.x, rect.y, rect.width,
+                                                 rect.height};
+        boost::endian::big_int32_t encoding = rawEncoding;
+        std::memcpy(header, fields, sizeof(fields));
+        std::memcpy(header + sizeof(fields), &encoding, sizeof(encoding));
+        header += rectHeaderSize;
+        update->buffers.emplace_back(
+            headerStart, static_cast<size_t>(header - headerStart));
+        headerStart = header;
+
+        size_t size = static_cast<size_t>(rect.width) * rect.height * 4;
+        rawPixels(frame, frameWidth, rect, pixels);
+        update->buffers.emplace_back(pixels, size);
+        pixels += size;
+    }
+    if (rects.empty())
+    {
+        update->buffers.emplace_back(update->headers.data(),
+                                     update->headers.size());
+    }
+    return update;
+}
+
+} // namespace kvm
+} // namespace crow
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <ast_video_types.hpp>
+#include <boost/asio/buffer.hpp>
+#include <boost/endian/arithmetic.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace crow
+{
+namespace kvm
+{
+
+/* The passthrough protocol hands the video engine's compressed frames to a
+ * viewer that decodes them itself, so that the BMC does nothing but copy
+ * them out.  The viewer sends any message to ask for a frame, and gets one
+ * binary message for each, a PassthroughHeader followed by the stream.
+ */
+struct PassthroughHeader
+{
+    // passthroughVersion(); bumped on any change to the header or stream
+    boost::endian::big_uint8_t version{};
+    // 0 for YUV444, 1 for YUV420
+    boost::endian::big_uint8_t mode{};
+    boost::endian::big_uint8_t ySelector{};
+    boost::endian::big_uint8_t uvSelector{};
+    boost::endian::big_uint16_t width{};
+    boost::endian::big_uint16_t height{};
+    // Bytes of stream that follow
+    boost::endian::big_uint32_t length{};
+};
+
+constexpr uint8_t passthroughVersion()
+{
+    return 1;
+}
+
+// A frame as the buffers to write; they point into it
+struct PassthroughFrame
+{
+    PassthroughHeader header;
+    std::shared_ptr<const ast_video::RawVideoBuffer> video;
+    std::vector<boost::asio::const_buffer> buffers;
+};
+
+// Frames the stream of video, which is sent as it is, not copied
+inline std::shared_ptr<const PassthroughFrame> encodePassthroughFrame(
+    std::shared_ptr<const ast_video::RawVideoBuffer> video)
+{
+    auto frame = std::make_shared<PassthroughFrame>();
+    size_t length = std::min(video->length,
+                             video->buffer.size() * sizeof(uint32_t));
+    frame->header.version = passthroughVersion();
+    frame->header.mode = static_cast<uint8_t>(video->mode);
+    frame->header.ySelector = static_cast<uint8_t>(video->ySelector);
+    frame->header.uvSelector = static_cast<uint8_t>(video->uvSelector);
+    frame->header.width = static_cast<uint16_t>(video->width);
+    frame->header.height = static_cast<uint16_t>(video->height);
+    frame->header.length = static_cast<uint32_t>(length);
+    frame->buffers.emplace_back(&frame->header, sizeof(frame->header));
+    frame->buffers.emplace_back(video->buffer.data(), length);
+    frame->video = std::move(video);
+    return frame;
+}
+
+} // namespace kvm
+} // namespace crow
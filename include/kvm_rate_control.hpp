@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+
+namespace crow
+{
+namespace kvm
+{
+
+/* Paces the frames sent to one viewer to what its link carries.  A viewer
+ * asks for the next frame once it has the last one, so the time from
+ * sending a frame to the next request is the round trip of a frame.  While
+ * that, or the bytes still queued for the viewer, are over budget, frames
+ * are spaced further apart and the quality goes down; once they are back
+ * under, both recover step by step.  A frame that isn't sent isn't kept:
+ * the viewer gets the next one captured, never a stale one.
+ */
+class RateController
+{
+  public:
+    using clock = std::chrono::steady_clock;
+
+    // Round trip above which the console stops feeling interactive
+    static constexpr std::chrono::milliseconds targetRoundTrip()
+    {
+        return std::chrono::milliseconds(150);
+    }
+
+    // Bytes queued for the viewer above which it is falling behind
+    static constexpr size_t maxBuffered()
+    {
+        return 256 * 1024;
+    }
+
+    static constexpr std::chrono::milliseconds maxInterval()
+    {
+        return std::chrono::milliseconds(1000);
+    }
+
+    // The video engine's quantization tables, from lowest to highest
+    // quality
+    static constexpr int minQuality()
+    {
+        return 0;
+    }
+
+    static constexpr int maxQuality()
+    {
+        return 11;
+    }
+
+    // Called when the viewer asks for a frame
+    void requested(clock::time_point now, size_t buffered)
+    {
+        if (!awaitingReply)
+        {
+            return;
+        }
+        awaitingReply = false;
+        std::chrono::microseconds sample =
+            std::chrono::duration_cast<std::chrono::microseconds>(now -
+                                                                  lastSent);
+        // Smoothed over about eight frames, like TCP's
+        roundTrip = roundTrip.count() == 0 ? sample
+                                           : (roundTrip * 7 + sample) / 8;
+
+        if (roundTrip > targetRoundTrip() || buffered > maxBuffered())
+        {
+            interval = std::min<std::chrono::microseconds>(
+                std::max<std::chrono::microseconds>(interval * 2, roundTrip),
+                maxInterval());
+            quality = std::max(quality - 1, minQuality());
+            goodFrames = 0;
+            return;
+        }
+        interval = interval * 3 / 4;
+        // Quality recovers slower than it drops, so it doesn't swing
+        if (++goodFrames >= 8)
+        {
+            quality = std::min(quality + 1, maxQuality());
+            goodFrames = 0;
+        }
+    }
+
+    // Whether a frame can go to the viewer now
+    bool ready(clock::time_point now, size_t buffered) const
+    {
+        return buffered <= maxBuffered() && now - lastSent >= interval;
+    }
+
+    void sent(clock::time_point now)
+    {
+        lastSent = now;
+        awaitingReply = true;
+    }
+
+    std::chrono::microseconds frameInterval() const
+    {
+        return interval;
+    }
+
+    std::chrono::microseconds smoothedRoundTrip() const
+    {
+        return roundTrip;
+    }
+
+    // The quantization tables the viewer's frames should use
+    int targetQuality() const
+    {
+        return quality;
+    }
+
+  private:
+    clock::time_point lastSent;
+    bool awaitingReply = false;
+    std::chrono::microseconds roundTrip{0};
+    // Least time between two frames; 0 sends as fast as they're asked for
+    std::chrono::microseconds interval{0};
+    int quality = maxQuality();
+    int goodFrames = 0;
+};
+
+} // namespace kvm
+} // namespace crow
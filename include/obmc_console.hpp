@@ -3,8 +3,11 @@
 #include <crow/websocket.h>
 #include <sys/socket.h>
 
+#include <boost/asio/steady_timer.hpp>
 #include <boost/container/flat_map.hpp>
-#include <boost/container/flat_set.hpp>
+#include <chrono>
+#include <console_scrollback.hpp>
+#include <memory>
 #include <webserver_common.hpp>
 
 namespace crow
@@ -14,10 +17,23 @@ namespace obmc_console
 
 static std::unique_ptr<boost::asio::local::stream_protocol::socket> host_socket;
 
+// Reads arriving within this long of each other go out as one frame
+constexpr std::chrono::milliseconds flushDelay{5};
+// ...unless this much has piled up
+constexpr size_t flushBytes = 16 * 1024;
+
 static std::array<char, 4096> outputBuffer;
 static std::string inputBuffer;
 
-static boost::container::flat_set<crow::websocket::Connection*> sessions;
+static Scrollback scrollback;
+// Scrollback position up to which output has gone to the sessions
+static uint64_t flushed = 0;
+static std::unique_ptr<boost::asio::steady_timer> flushTimer;
+static bool flushPending = false;
+
+// Each session with the scrollback position it has been sent up to
+static boost::container::flat_map<crow::websocket::Connection*, uint64_t>
+    sessions;
 
 static bool doingWrite = false;
 
@@ -44,9 +60,9 @@ void doWrite()
 
             if (ec == boost::asio::error::eof)
             {
-                for (auto session : sessions)
+                for (auto& session : sessions)
                 {
-                    session->close("Error in reading to host port");
+                    session.first->close("Error in reading to host port");
                 }
                 return;
             }
@@ -59,6 +75,55 @@ void doWrite()
         });
 }
 
+// Sends the output read since the last flush to every session.  The frame
+// is built once and shared; only a session that joined since the last
+// flush, and so already has part of it, gets a copy of its own.
+void flush()
+{
+    flushPending = false;
+    if (flushed == scrollback.end())
+    {
+        return;
+    }
+    auto frame = std::make_shared<const std::string>(scrollback.read(flushed));
+    for (auto& session : sessions)
+    {
+        if (session.second == flushed)
+        {
+            session.first->sendText(frame);
+        }
+        else if (session.second < scrollback.end())
+        {
+            session.first->sendText(scrollback.read(session.second));
+        }
+        session.second = scrollback.end();
+    }
+    flushed = scrollback.end();
+}
+
+void scheduleFlush()
+{
+    if (scrollback.end() - flushed >= flushBytes)
+    {
+        flushTimer->cancel();
+        flush();
+        return;
+    }
+    if (flushPending)
+    {
+        return;
+    }
+    flushPending = true;
+    flushTimer->expires_after(flushDelay);
+    flushTimer->async_wait([](const boost::system::error_code& ec) {
+        if (ec)
+        {
+            return;
+        }
+        flush();
+    });
+}
+
 void doRead()
 {
     BMCWEB_LOG_DEBUG << "Reading from socket";
@@ -70,17 +135,14 @@ void doRead()
             {
                 BMCWEB_LOG_ERROR << "Couldn't read from host serial port: "
                                  << ec;
-                for (auto session : sessions)
+                for (auto& session : sessions)
                 {
-                    session->close("Error in connecting to host port");
+                    session.first->close("Error in connecting to host port");
                 }
                 return;
             }
-            boost::beast::string_view payload(outputBuffer.data(), bytesRead);
-            for (auto session : sessions)
-            {
-                session->sendText(payload);
-            }
+            scrollback.append(outputBuffer.data(), bytesRead);
+            scheduleFlush();
             doRead();
         });
 }
@@ -90,9 +152,9 @@ void connectHandler(const boost::system::error_code& ec)
     if (ec)
     {
         BMCWEB_LOG_ERROR << "Couldn't connect to host serial port: " << ec;
-        for (auto session : sessions)
+        for (auto& session : sessions)
         {
-            session->close("Error in connecting to host port");
+            session.first->close("Error in connecting to host port");
         }
         return;
     }
@@ -105,10 +167,19 @@ void requestRoutes(CrowApp& app)
 {
     BMCWEB_ROUTE(app, "/console0")
         .websocket()
+        .outboundQueue(64 * 1024, crow::websocket::OverflowPolicy::dropOldest)
+        .batchWrites(16 * 1024)
+        .permessageDeflate()
         .onopen([](crow::websocket::Connection& conn) {
             BMCWEB_LOG_DEBUG << "Connection " << &conn << " opened";
 
-            sessions.insert(&conn);
+            // Replay what the console printed before this session joined
+            std::string history = scrollback.read(scrollback.begin());
+            if (!history.empty())
+            {
+                conn.sendText(std::move(history));
+            }
+            sessions[&conn] = scrollback.end();
             if (host_socket == nullptr)
             {
                 const std::string consoleName("\0obmc-console", 13);
@@ -134,6 +205,8 @@ void requestRoutes(CrowApp& app)
                 host_socket = std::make_unique<
                     boost::asio::local::stream_protocol::socket>(
                     conn.getIoService());
+                flushTimer = std::make_unique<boost::asio::steady_timer>(
+                    conn.getIoService());
                 host_socket->async_connect(ep, connectHandler);
             }
         })
@@ -143,6 +216,11 @@ void requestRoutes(CrowApp& app)
                 if (sessions.empty())
                 {
                     host_socket = nullptr;
+                    // Nobody is left to send pending output to; it stays
+                    // in the scrollback
+                    flushTimer = nullptr;
+                    flushPending = false;
+                    flushed = scrollback.end();
                     inputBuffer.clear();
                     inputBuffer.shrink_to_fit();
                 }
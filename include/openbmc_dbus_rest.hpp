@@ -1,13 +1,19 @@
 #pragma once
 
 #include <crow/app.h>
-#include <tinyxml2.h>
 
 #include <boost/algorithm/string.hpp>
+#include <boost/container/flat_map.hpp>
 #include <boost/container/flat_set.hpp>
 #include <dbus_singleton.hpp>
+#include <dbus_utility.hpp>
 #include <experimental/filesystem>
 #include <fstream>
+#include <http_utility.hpp>
+#include <introspection_cache.hpp>
+#include <map>
+#include <regex>
+#include <unordered_map>
 
 namespace crow
 {
@@ -18,10 +24,13 @@ void introspectObjects(crow::Response &res, std::string process_name,
                        std::string path,
                        std::shared_ptr<nlohmann::json> transaction)
 {
-    crow::connections::systemBus->async_method_call(
-        [&res, transaction, processName{std::move(process_name)},
-         objectPath{std::move(path)}](const boost::system::error_code ec,
-                                      const std::string &introspect_xml) {
+    crow::connections::cachedIntrospect(
+        process_name, path,
+        [&res, transaction, processName{process_name},
+         objectPath{path}](const boost::system::error_code ec,
+                           const std::shared_ptr<
+                               const crow::connections::IntrospectedObject>
+                               &object) {
             if (ec)
             {
                 BMCWEB_LOG_ERROR
@@ -33,23 +42,10 @@ void introspectObjects(crow::Response &res, std::string process_name,
             {
                 transaction->push_back({{"path", objectPath}});
 
-                tinyxml2::XMLDocument doc;
-
-                doc.Parse(introspect_xml.c_str());
-                tinyxml2::XMLNode *pRoot = doc.FirstChildElement("node");
-                if (pRoot == nullptr)
-                {
-                    BMCWEB_LOG_ERROR << "XML document failed to parse "
-                                     << processName << " " << objectPath
-                                     << "\n";
-                }
-                else
+                if (object != nullptr)
                 {
-                    tinyxml2::XMLElement *node =
-                        pRoot->FirstChildElement("node");
-                    while (node != nullptr)
+                    for (const std::string &childPath : object->children)
                     {
-                        std::string childPath = node->Attribute("name");
                         std::string newpath;
                         if (objectPath != "/")
                         {
@@ -59,8 +55,6 @@ void introspectObjects(crow::Response &res, std::string process_name,
                         // introspect the subobjects as well
                         introspectObjects(res, processName, newpath,
                                           transaction);
-
-                        node = node->NextSiblingElement("node");
                     }
                 }
             }
@@ -72,9 +66,7 @@ void introspectObjects(crow::Response &res, std::string process_name,
                                  {"objects", std::move(*transaction)}};
                 res.end();
             }
-        },
-        process_name, path, "org.freedesktop.DBus.Introspectable",
-        "Introspect");
+        });
 }
 
 // A smattering of common types to unpack.  TODO(ed) this should really iterate
@@ -90,61 +82,6 @@ using ManagedObjectType = std::vector<std::pair<
         std::string,
         boost::container::flat_map<std::string, DbusRestVariantType>>>>;
 
-void getManagedObjectsForEnumerate(const std::string &object_name,
-                                   const std::string &connection_name,
-                                   crow::Response &res,
-                                   std::shared_ptr<nlohmann::json> transaction)
-{
-    crow::connections::systemBus->async_method_call(
-        [&res, transaction](const boost::system::error_code ec,
-                            const ManagedObjectType &objects) {
-            if (ec)
-            {
-                BMCWEB_LOG_ERROR << ec;
-            }
-            else
-            {
-                nlohmann::json &dataJson = *transaction;
-
-                for (auto &objectPath : objects)
-                {
-                    BMCWEB_LOG_DEBUG
-                        << "Reading object "
-                        << static_cast<const std::string &>(objectPath.first);
-                    nlohmann::json &objectJson =
-                        dataJson[static_cast<const std::string &>(
-                            objectPath.first)];
-                    if (objectJson.is_null())
-                    {
-                        objectJson = nlohmann::json::object();
-                    }
-                    for (const auto &interface : objectPath.second)
-                    {
-                        for (const auto &property : interface.second)
-                        {
-                            nlohmann::json &propertyJson =
-                                objectJson[property.first];
-                            mapbox::util::apply_visitor(
-                                [&propertyJson](auto &&val) {
-                                    propertyJson = val;
-                                },
-                                property.second);
-                        }
-                    }
-                }
-            }
-
-            if (transaction.use_count() == 1)
-            {
-                res.jsonValue = {{"message", "200 OK"},
-                                 {"status", "ok"},
-                                 {"data", std::move(*transaction)}};
-                res.end();
-            }
-        },
-        connection_name, object_name, "org.freedesktop.DBus.ObjectManager",
-        "GetManagedObjects");
-}
 
 using GetSubTreeType = std::vector<
     std::pair<std::string,
@@ -176,448 +113,86 @@ struct InProgressActionData
     nlohmann::json arguments;
 };
 
-std::vector<std::string> dbusArgSplit(const std::string &string)
-{
-    std::vector<std::string> ret;
-    if (string.empty())
-    {
-        return ret;
-    }
-    ret.push_back("");
-    int containerDepth = 0;
-
-    for (std::string::const_iterator character = string.begin();
-         character != string.end(); character++)
-    {
-        ret.back() += *character;
-        switch (*character)
-        {
-            case ('a'):
-                break;
-            case ('('):
-            case ('{'):
-                containerDepth++;
-                break;
-            case ('}'):
-            case (')'):
-                containerDepth--;
-                if (containerDepth == 0)
-                {
-                    if (character + 1 != string.end())
-                    {
-                        ret.push_back("");
-                    }
-                }
-                break;
-            default:
-                if (containerDepth == 0)
-                {
-                    if (character + 1 != string.end())
-                    {
-                        ret.push_back("");
-                    }
-                }
-                break;
-        }
-    }
-}
-
-int convertJsonToDbus(sd_bus_message *m, const std::string &arg_type,
-                      const nlohmann::json &input_json)
-{
-    int r = 0;
-    BMCWEB_LOG_DEBUG << "Converting " << input_json.dump()
-                     << " to type: " << arg_type;
-    const std::vector<std::string> argTypes = dbusArgSplit(arg_type);
-
-    // Assume a single object for now.
-    const nlohmann::json *j = &input_json;
-    nlohmann::json::const_iterator jIt = input_json.begin();
-
-    for (const std::string &arg_code : argTypes)
-    {
-        // If we are decoding multiple objects, grab the pointer to the
-        // iterator, and increment it for the next loop
-        if (argTypes.size() > 1)
-        {
-            if (jIt == input_json.end())
-            {
-                return -2;
-            }
-            j = &*jIt;
-            jIt++;
-        }
-        const int64_t *int_value = j->get_ptr<const int64_t *>();
-        const uint64_t *uint_value = j->get_ptr<const uint64_t *>();
-        const std::string *string_value = j->get_ptr<const std::string *>();
-        const double *double_value = j->get_ptr<const double *>();
-        const bool *b = j->get_ptr<const bool *>();
-        int64_t v = 0;
-        double d = 0.0;
-
-        // Do some basic type conversions that make sense.  uint can be
-        // converted to int.  int and uint can be converted to double
-        if (uint_value != nullptr && int_value == nullptr)
-        {
-            v = static_cast<int64_t>(*uint_value);
-            int_value = &v;
-        }
-        if (uint_value != nullptr && double_value == nullptr)
-        {
-            d = static_cast<double>(*uint_value);
-            double_value = &d;
-        }
-        if (int_value != nullptr && double_value == nullptr)
-        {
-            d = static_cast<double>(*int_value);
-            double_value = &d;
-        }
-
-        if (arg_code == "s")
-        {
-            if (string_value == nullptr)
-            {
-                return -1;
-            }
-            r = sd_bus_message_append_basic(m, arg_code[0],
-                                            (void *)string_value->c_str());
-            if (r < 0)
-            {
-                return r;
-            }
-        }
-        else if (arg_code == "i")
-        {
-            if (int_value == nullptr)
-            {
-                return -1;
-            }
-            int32_t i = static_cast<int32_t>(*int_value);
-            r = sd_bus_message_append_basic(m, arg_code[0], &i);
-            if (r < 0)
-            {
-                return r;
-            }
-        }
-        else if (arg_code == "b")
-        {
-            // lots of ways bool could be represented here.  Try them all
-            int bool_int = false;
-            if (int_value != nullptr)
-            {
-                bool_int = *int_value > 0 ? 1 : 0;
-            }
-            else if (b != nullptr)
-            {
-                bool_int = b ? 1 : 0;
-            }
-            else if (string_value != nullptr)
-            {
-                bool_int = boost::istarts_with(*string_value, "t") ? 1 : 0;
-            }
-            else
-            {
-                return -1;
-            }
-            r = sd_bus_message_append_basic(m, arg_code[0], &bool_int);
-            if (r < 0)
-            {
-                return r;
-            }
-        }
-        else if (arg_code == "n")
-        {
-            if (int_value == nullptr)
-            {
-                return -1;
-            }
-            int16_t n = static_cast<int16_t>(*int_value);
-            r = sd_bus_message_append_basic(m, arg_code[0], &n);
-            if (r < 0)
-            {
-                return r;
-            }
-        }
-        else if (arg_code == "x")
-        {
-            if (int_value == nullptr)
-            {
-                return -1;
-            }
-            r = sd_bus_message_append_basic(m, arg_code[0], int_value);
-            if (r < 0)
-            {
-                return r;
-            }
-        }
-        else if (arg_code == "y")
-        {
-            if (uint_value == nullptr)
-            {
-                return -1;
-            }
-            uint8_t y = static_cast<uint8_t>(*uint_value);
-            r = sd_bus_message_append_basic(m, arg_code[0], &y);
-        }
-        else if (arg_code == "q")
-        {
-            if (uint_value == nullptr)
-            {
-                return -1;
-            }
-            uint16_t q = static_cast<uint16_t>(*uint_value);
-            r = sd_bus_message_append_basic(m, arg_code[0], &q);
-        }
-        else if (arg_code == "u")
-        {
-            if (uint_value == nullptr)
-            {
-                return -1;
-            }
-            uint32_t u = static_cast<uint32_t>(*uint_value);
-            r = sd_bus_message_append_basic(m, arg_code[0], &u);
-        }
-        else if (arg_code == "t")
-        {
-            if (uint_value == nullptr)
-            {
-                return -1;
-            }
-            r = sd_bus_message_append_basic(m, arg_code[0], uint_value);
-        }
-        else if (arg_code == "d")
-        {
-            sd_bus_message_append_basic(m, arg_code[0], double_value);
-        }
-        else if (boost::starts_with(arg_code, "a"))
-        {
-            std::string contained_type = arg_code.substr(1);
-            r = sd_bus_message_open_container(m, SD_BUS_TYPE_ARRAY,
-                                              contained_type.c_str());
-            if (r < 0)
-            {
-                return r;
-            }
-
-            for (nlohmann::json::const_iterator it = j->begin(); it != j->end();
-                 ++it)
-            {
-                r = convertJsonToDbus(m, contained_type, *it);
-                if (r < 0)
-                {
-                    return r;
-                }
-
-                it++;
-            }
-            sd_bus_message_close_container(m);
-        }
-        else if (boost::starts_with(arg_code, "v"))
-        {
-            std::string contained_type = arg_code.substr(1);
-            BMCWEB_LOG_DEBUG
-                << "variant type: " << arg_code
-                << " appending variant of type: " << contained_type;
-            r = sd_bus_message_open_container(m, SD_BUS_TYPE_VARIANT,
-                                              contained_type.c_str());
-            if (r < 0)
-            {
-                return r;
-            }
-
-            r = convertJsonToDbus(m, contained_type, input_json);
-            if (r < 0)
-            {
-                return r;
-            }
-
-            r = sd_bus_message_close_container(m);
-            if (r < 0)
-            {
-                return r;
-            }
-        }
-        else if (boost::starts_with(arg_code, "(") &&
-                 boost::ends_with(arg_code, ")"))
-        {
-            std::string contained_type =
-                arg_code.substr(1, arg_code.size() - 1);
-            r = sd_bus_message_open_container(m, SD_BUS_TYPE_STRUCT,
-                                              contained_type.c_str());
-            nlohmann::json::const_iterator it = j->begin();
-            for (const std::string &arg_code : dbusArgSplit(arg_type))
-            {
-                if (it == j->end())
-                {
-                    return -1;
-                }
-                r = convertJsonToDbus(m, arg_code, *it);
-                if (r < 0)
-                {
-                    return r;
-                }
-                it++;
-            }
-            r = sd_bus_message_close_container(m);
-        }
-        else if (boost::starts_with(arg_code, "{") &&
-                 boost::ends_with(arg_code, "}"))
-        {
-            std::string contained_type =
-                arg_code.substr(1, arg_code.size() - 1);
-            r = sd_bus_message_open_container(m, SD_BUS_TYPE_DICT_ENTRY,
-                                              contained_type.c_str());
-            std::vector<std::string> codes = dbusArgSplit(contained_type);
-            if (codes.size() != 2)
-            {
-                return -1;
-            }
-            const std::string &key_type = codes[0];
-            const std::string &value_type = codes[1];
-            for (auto it : j->items())
-            {
-                r = convertJsonToDbus(m, key_type, it.key());
-                if (r < 0)
-                {
-                    return r;
-                }
-
-                r = convertJsonToDbus(m, value_type, it.value());
-                if (r < 0)
-                {
-                    return r;
-                }
-            }
-            r = sd_bus_message_close_container(m);
-        }
-        else
-        {
-            return -2;
-        }
-        if (r < 0)
-        {
-            return r;
-        }
-
-        if (argTypes.size() > 1)
-        {
-            jIt++;
-        }
-    }
-}
-
 void findActionOnInterface(std::shared_ptr<InProgressActionData> transaction,
                            const std::string &connectionName)
 {
     BMCWEB_LOG_DEBUG << "findActionOnInterface for connection "
                      << connectionName;
-    crow::connections::systemBus->async_method_call(
+    crow::connections::cachedIntrospect(
+        connectionName, transaction->path,
         [transaction, connectionName{std::string(connectionName)}](
             const boost::system::error_code ec,
-            const std::string &introspect_xml) {
-            BMCWEB_LOG_DEBUG << "got xml:\n " << introspect_xml;
+            const std::shared_ptr<const crow::connections::IntrospectedObject>
+                &object) {
             if (ec)
             {
                 BMCWEB_LOG_ERROR
                     << "Introspect call failed with error: " << ec.message()
                     << " on process: " << connectionName << "\n";
+                return;
             }
-            else
+            if (object == nullptr)
             {
-                tinyxml2::XMLDocument doc;
-
-                doc.Parse(introspect_xml.c_str());
-                tinyxml2::XMLNode *pRoot = doc.FirstChildElement("node");
-                if (pRoot == nullptr)
-                {
-                    BMCWEB_LOG_ERROR << "XML document failed to parse "
-                                     << connectionName << "\n";
-                }
-                else
+                return;
+            }
+            for (const crow::connections::IntrospectedInterface &interface :
+                 object->interfaces)
+            {
+                for (const crow::connections::IntrospectedMember &method :
+                     interface.methods)
                 {
-                    tinyxml2::XMLElement *interface_node =
-                        pRoot->FirstChildElement("interface");
-                    while (interface_node != nullptr)
+                    BMCWEB_LOG_DEBUG << "Found method: " << method.name;
+                    if (method.name != transaction->methodName)
                     {
-                        std::string this_interface_name =
-                            interface_node->Attribute("name");
-                        tinyxml2::XMLElement *method_node =
-                            interface_node->FirstChildElement("method");
-                        while (method_node != nullptr)
-                        {
-                            std::string this_methodName =
-                                method_node->Attribute("name");
-                            BMCWEB_LOG_DEBUG << "Found method: "
-                                             << this_methodName;
-                            if (this_methodName == transaction->methodName)
-                            {
-                                sdbusplus::message::message m =
-                                    crow::connections::systemBus
-                                        ->new_method_call(
-                                            connectionName.c_str(),
-                                            transaction->path.c_str(),
-                                            this_interface_name.c_str(),
-                                            transaction->methodName.c_str());
-
-                                tinyxml2::XMLElement *argument_node =
-                                    method_node->FirstChildElement("arg");
-
-                                nlohmann::json::const_iterator arg_it =
-                                    transaction->arguments.begin();
+                        continue;
+                    }
+                    sdbusplus::message::message m =
+                        crow::connections::systemBus->new_method_call(
+                            connectionName.c_str(), transaction->path.c_str(),
+                            interface.name.c_str(),
+                            transaction->methodName.c_str());
 
-                                while (argument_node != nullptr)
-                                {
-                                    std::string arg_direction =
-                                        argument_node->Attribute("direction");
-                                    if (arg_direction == "in")
-                                    {
-                                        std::string arg_type =
-                                            argument_node->Attribute("type");
-                                        if (arg_it ==
-                                            transaction->arguments.end())
-                                        {
-                                            transaction->setErrorStatus();
-                                            return;
-                                        }
-                                        if (convertJsonToDbus(m.get(), arg_type,
-                                                              *arg_it) < 0)
-                                        {
-                                            transaction->setErrorStatus();
-                                            return;
-                                        }
+                    nlohmann::json::const_iterator arg_it =
+                        transaction->arguments.begin();
 
-                                        arg_it++;
-                                    }
-                                    argument_node =
-                                        method_node->NextSiblingElement("arg");
-                                }
-                                crow::connections::systemBus->async_send(
-                                    m, [transaction](
-                                           boost::system::error_code ec,
-                                           sdbusplus::message::message &m) {
-                                        if (ec)
-                                        {
-                                            transaction->setErrorStatus();
-                                            return;
-                                        }
-                                        transaction->res.jsonValue = {
-                                            {"status", "ok"},
-                                            {"message", "200 OK"},
-                                            {"data", nullptr}};
-                                    });
-                                break;
-                            }
-                            method_node =
-                                method_node->NextSiblingElement("method");
+                    for (const crow::connections::IntrospectedArg &arg :
+                         method.args)
+                    {
+                        if (arg.direction != "in")
+                        {
+                            continue;
+                        }
+                        if (arg_it == transaction->arguments.end())
+                        {
+                            transaction->setErrorStatus();
+                            return;
                         }
-                        interface_node =
-                            interface_node->NextSiblingElement("interface");
+                        if (arg.signature == nullptr ||
+                            crow::connections::convertJsonToDbus(
+                                m.get(), *arg.signature, *arg_it) < 0)
+                        {
+                            transaction->setErrorStatus();
+                            return;
+                        }
+
+                        arg_it++;
                     }
+                    crow::connections::systemBus->async_send(
+                        m, [transaction](boost::system::error_code ec,
+                                         sdbusplus::message::message &m) {
+                            if (ec)
+                            {
+                                transaction->setErrorStatus();
+                                return;
+                            }
+                            transaction->res.jsonValue = {{"status", "ok"},
+                                                          {"message", "200 OK"},
+                                                          {"data", nullptr}};
+                        });
+                    break;
                 }
             }
-        },
-        connectionName, transaction->path,
-        "org.freedesktop.DBus.Introspectable", "Introspect");
+        });
 }
 
 void handle_action(const crow::Request &req, crow::Response &res,
@@ -643,7 +218,7 @@ void handle_action(const crow::Request &req, crow::Response &res,
     transaction->path = objectPath;
     transaction->methodName = methodName;
     transaction->arguments = std::move(requestDbusData);
-    crow::connections::systemBus->async_method_call(
+    crow::connections::tracedMethodCall(
         [transaction](
             const boost::system::error_code ec,
             const std::vector<std::pair<std::string, std::vector<std::string>>>
@@ -671,7 +246,7 @@ void handle_action(const crow::Request &req, crow::Response &res,
 
 void handle_list(crow::Response &res, const std::string &objectPath)
 {
-    crow::connections::systemBus->async_method_call(
+    crow::connections::tracedMethodCall(
         [&res](const boost::system::error_code ec,
                std::vector<std::string> &objectPaths) {
             if (ec)
@@ -692,45 +267,268 @@ void handle_list(crow::Response &res, const std::string &objectPath)
         static_cast<int32_t>(99), std::array<std::string, 0>());
 }
 
-void handle_enumerate(crow::Response &res, const std::string &objectPath)
+// GetManagedObjects calls an enumerate keeps in flight at once
+constexpr size_t enumerateCallsInFlight = 4;
+
+/**
+ * @brief Gathers the objects under a path from every service owning one of
+ *        them, for an enumerate
+ *
+ * Services are asked concurrently, a few at a time.  An object is complete
+ * once every service owning it has replied, and is serialized right then,
+ * so when streaming, the first objects go out while later services are still
+ * being asked, and no more than the objects still waiting for an owner are
+ * held as json.  Objects of paths the subtree didn't list can't be known to
+ * be complete, so they wait for the end.
+ */
+class EnumerateTransaction
+    : public std::enable_shared_from_this<EnumerateTransaction>
 {
-    crow::connections::systemBus->async_method_call(
-        [&res, objectPath{std::string(objectPath)}](
-            const boost::system::error_code ec,
-            const GetSubTreeType &object_names) {
-            if (ec)
+  public:
+    EnumerateTransaction(crow::Response &res, const std::string &objectPath,
+                         const GetSubTreeType &subtree, bool streamed) :
+        res(res),
+        objectPath(objectPath), streamed(streamed)
+    {
+        for (const auto &object : subtree)
+        {
+            for (const auto &connection : object.second)
+            {
+                std::vector<std::string> &paths = pathsOf[connection.first];
+                if (paths.empty() || paths.back() != object.first)
+                {
+                    paths.push_back(object.first);
+                    ownersLeft[object.first]++;
+                }
+            }
+        }
+        connections.reserve(pathsOf.size());
+        for (const auto &connection : pathsOf)
+        {
+            connections.push_back(connection.first);
+        }
+    }
+
+    bool empty() const
+    {
+        return connections.empty();
+    }
+
+    /**
+     * @brief Starts asking the services; when streaming, the body is pulled
+     *        from the response
+     */
+    void start()
+    {
+        if (streamed)
+        {
+            ready = "{\"data\":{";
+            res.addHeader("Content-Type", "application/json");
+            auto self = shared_from_this();
+            res.setBodyGenerator(
+                [self](const crow::Response::ChunkCallback &callback) {
+                    self->pull(callback);
+                });
+            res.end();
+        }
+        callNext();
+    }
+
+  private:
+    void callNext()
+    {
+        while (inFlight < enumerateCallsInFlight && next < connections.size())
+        {
+            const std::string &connection = connections[next++];
+            inFlight++;
+            auto self = shared_from_this();
+            crow::connections::tracedMethodCall(
+                [self, connection](const boost::system::error_code ec,
+                                   const ManagedObjectType &objects) {
+                    self->onReply(connection, ec, objects);
+                },
+                connection, objectPath, "org.freedesktop.DBus.ObjectManager",
+                "GetManagedObjects");
+        }
+    }
+
+    void onReply(const std::string &connection,
+                 const boost::system::error_code ec,
+                 const ManagedObjectType &objects)
+    {
+        inFlight--;
+        if (ec)
+        {
+            BMCWEB_LOG_ERROR << ec;
+        }
+        else
+        {
+            for (auto &objectPath : objects)
+            {
+                BMCWEB_LOG_DEBUG
+                    << "Reading object "
+                    << static_cast<const std::string &>(objectPath.first);
+                nlohmann::json &objectJson =
+                    held[static_cast<const std::string &>(objectPath.first)];
+                if (objectJson.is_null())
+                {
+                    objectJson = nlohmann::json::object();
+                }
+                for (const auto &interface : objectPath.second)
+                {
+                    for (const auto &property : interface.second)
+                    {
+                        nlohmann::json &propertyJson =
+                            objectJson[property.first];
+                        mapbox::util::apply_visitor(
+                            [&propertyJson](auto &&val) {
+                                propertyJson = val;
+                            },
+                            property.second);
+                    }
+                }
+            }
+        }
+
+        // A failed service still counts as having replied
+        for (const std::string &path : pathsOf[connection])
+        {
+            if (--ownersLeft[path] == 0)
+            {
+                auto object = held.find(path);
+                if (object != held.end())
+                {
+                    emit(object->first, std::move(object->second));
+                    held.erase(object);
+                }
+            }
+        }
+
+        callNext();
+        if (done())
+        {
+            for (auto &object : held)
+            {
+                emit(object.first, std::move(object.second));
+            }
+            held.clear();
+            if (!streamed)
             {
                 res.jsonValue = {{"message", "200 OK"},
                                  {"status", "ok"},
-                                 {"data", nlohmann::json::object()}};
-
+                                 {"data", std::move(data)}};
                 res.end();
                 return;
             }
+        }
+        deliver();
+    }
+
+    void emit(const std::string &path, nlohmann::json &&object)
+    {
+        if (!streamed)
+        {
+            data[path] = std::move(object);
+            return;
+        }
+        if (!firstObject)
+        {
+            ready += ',';
+        }
+        firstObject = false;
+        ready += nlohmann::json(path).dump();
+        ready += ':';
+        ready += object.dump();
+    }
+
+    bool done() const
+    {
+        return inFlight == 0 && next == connections.size();
+    }
+
+    // Hands over everything serialized so far, or waits until there is
+    // something
+    void pull(const crow::Response::ChunkCallback &callback)
+    {
+        if (done())
+        {
+            ready += "},\"message\":\"200 OK\",\"status\":\"ok\"}";
+            callback(std::move(ready), false);
+            ready.clear();
+            return;
+        }
+        if (!ready.empty())
+        {
+            std::string chunk = std::move(ready);
+            ready.clear();
+            callback(std::move(chunk), true);
+            return;
+        }
+        waiting = callback;
+    }
 
-            boost::container::flat_set<std::string> connections;
+    void deliver()
+    {
+        if (waiting && (done() || !ready.empty()))
+        {
+            crow::Response::ChunkCallback callback = std::move(waiting);
+            waiting = nullptr;
+            pull(callback);
+        }
+    }
+
+    crow::Response &res;
+    std::string objectPath;
+    bool streamed;
+
+    // Services to ask, and the paths each of them owns
+    std::vector<std::string> connections;
+    boost::container::flat_map<std::string, std::vector<std::string>> pathsOf;
+    // Owners of each path that haven't replied yet
+    std::unordered_map<std::string, size_t> ownersLeft;
+    size_t next = 0;
+    size_t inFlight = 0;
+
+    // Objects with owners still to reply
+    std::map<std::string, nlohmann::json> held;
+    // The whole document, when not streaming
+    nlohmann::json data = nlohmann::json::object();
+    // Serialized, not yet pulled text, when streaming
+    std::string ready;
+    bool firstObject = true;
+    crow::Response::ChunkCallback waiting;
+};
 
-            for (const auto &object : object_names)
+void handle_enumerate(const crow::Request &req, crow::Response &res,
+                      const std::string &objectPath)
+{
+    // HTTP/1.0 has no chunked encoding, and the HTML view is built from
+    // jsonValue
+    bool streamed =
+        req.version() >= 11 && !http_helpers::requestPrefersHtml(req);
+    crow::connections::tracedMethodCall(
+        [&res, objectPath{std::string(objectPath)},
+         streamed](const boost::system::error_code ec,
+                   const GetSubTreeType &object_names) {
+            if (ec)
             {
-                for (const auto &Connection : object.second)
-                {
-                    connections.insert(Connection.first);
-                }
+                res.jsonValue = {{"message", "200 OK"},
+                                 {"status", "ok"},
+                                 {"data", nlohmann::json::object()}};
+
+                res.end();
+                return;
             }
 
-            if (connections.size() <= 0)
+            auto transaction = std::make_shared<EnumerateTransaction>(
+                res, objectPath, object_names, streamed);
+            if (transaction->empty())
             {
                 res.result(boost::beast::http::status::not_found);
                 res.end();
                 return;
             }
-            auto transaction =
-                std::make_shared<nlohmann::json>(nlohmann::json::object());
-            for (const std::string &Connection : connections)
-            {
-                getManagedObjectsForEnumerate(objectPath, Connection, res,
-                                              transaction);
-            }
+            transaction->start();
         },
         "xyz.openbmc_project.ObjectMapper",
         "/xyz/openbmc_project/object_mapper",
@@ -751,7 +549,7 @@ void handle_get(crow::Response &res, std::string &objectPath,
 
     using GetObjectType =
         std::vector<std::pair<std::string, std::vector<std::string>>>;
-    crow::connections::systemBus->async_method_call(
+    crow::connections::tracedMethodCall(
         [&res, path, property_name](const boost::system::error_code ec,
                                     const GetObjectType &object_names) {
             if (ec || object_names.size() <= 0)
@@ -779,7 +577,7 @@ void handle_get(crow::Response &res, std::string &objectPath,
 
                 for (const std::string &interface : interfaceNames)
                 {
-                    crow::connections::systemBus->async_method_call(
+                    crow::connections::tracedMethodCall(
                         [&res, response, property_name](
                             const boost::system::error_code ec,
                             const std::vector<
@@ -909,7 +707,7 @@ void handlePut(const crow::Request &req, crow::Response &res,
     using GetObjectType =
         std::vector<std::pair<std::string, std::vector<std::string>>>;
 
-    crow::connections::systemBus->async_method_call(
+    crow::connections::tracedMethodCall(
         [transaction](const boost::system::error_code ec,
                       const GetObjectType &object_names) {
             if (!ec && object_names.size() <= 0)
@@ -923,10 +721,13 @@ void handlePut(const crow::Request &req, crow::Response &res,
             {
                 const std::string &connectionName = connection.first;
 
-                crow::connections::systemBus->async_method_call(
+                crow::connections::cachedIntrospect(
+                    connectionName, transaction->objectPath,
                     [connectionName{std::string(connectionName)},
                      transaction](const boost::system::error_code ec,
-                                  const std::string &introspectXml) {
+                                  const std::shared_ptr<
+                                      const crow::connections::
+                                          IntrospectedObject> &object) {
                         if (ec)
                         {
                             BMCWEB_LOG_ERROR
@@ -936,107 +737,80 @@ void handlePut(const crow::Request &req, crow::Response &res,
                             transaction->setErrorStatus();
                             return;
                         }
-                        tinyxml2::XMLDocument doc;
-
-                        doc.Parse(introspectXml.c_str());
-                        tinyxml2::XMLNode *pRoot =
-                            doc.FirstChildElement("node");
-                        if (pRoot == nullptr)
+                        if (object == nullptr)
                         {
-                            BMCWEB_LOG_ERROR << "XML document failed to parse: "
-                                             << introspectXml;
                             transaction->setErrorStatus();
                             return;
                         }
-                        tinyxml2::XMLElement *ifaceNode =
-                            pRoot->FirstChildElement("interface");
-                        while (ifaceNode != nullptr)
+                        for (const crow::connections::IntrospectedInterface
+                                 &interface : object->interfaces)
                         {
-                            const char *interfaceName =
-                                ifaceNode->Attribute("name");
                             BMCWEB_LOG_DEBUG << "found interface "
-                                             << interfaceName;
-                            tinyxml2::XMLElement *propNode =
-                                ifaceNode->FirstChildElement("property");
-                            while (propNode != nullptr)
+                                             << interface.name;
+                            for (const crow::connections::IntrospectedProperty
+                                     &property : interface.properties)
                             {
-                                const char *propertyName =
-                                    propNode->Attribute("name");
                                 BMCWEB_LOG_DEBUG << "Found property "
-                                                 << propertyName;
-                                if (propertyName == transaction->propertyName)
+                                                 << property.name;
+                                if (property.name != transaction->propertyName)
                                 {
-                                    const char *argType =
-                                        propNode->Attribute("type");
-                                    if (argType != nullptr)
-                                    {
-                                        sdbusplus::message::message m =
-                                            crow::connections::systemBus
-                                                ->new_method_call(
-                                                    connectionName.c_str(),
-                                                    transaction->objectPath
-                                                        .c_str(),
-                                                    "org.freedesktop.DBus."
-                                                    "Properties",
-                                                    "Set");
-                                        m.append(interfaceName,
-                                                 transaction->propertyName);
-                                        int r = sd_bus_message_open_container(
-                                            m.get(), SD_BUS_TYPE_VARIANT,
-                                            argType);
-                                        if (r < 0)
-                                        {
-                                            transaction->setErrorStatus();
-                                            return;
-                                        }
-                                        r = convertJsonToDbus(
-                                            m.get(), argType,
-                                            transaction->propertyValue);
-                                        if (r < 0)
-                                        {
-                                            transaction->setErrorStatus();
-                                            return;
-                                        }
-                                        r = sd_bus_message_close_container(
-                                            m.get());
-                                        if (r < 0)
+                                    continue;
+                                }
+                                const char *argType = property.type.c_str();
+                                sdbusplus::message::message m =
+                                    crow::connections::systemBus
+                                        ->new_method_call(
+                                            connectionName.c_str(),
+                                            transaction->objectPath.c_str(),
+                                            "org.freedesktop.DBus."
+                                            "Properties",
+                                            "Set");
+                                m.append(interface.name,
+                                         transaction->propertyName);
+                                int r = sd_bus_message_open_container(
+                                    m.get(), SD_BUS_TYPE_VARIANT, argType);
+                                if (r < 0)
+                                {
+                                    transaction->setErrorStatus();
+                                    return;
+                                }
+                                if (property.signature == nullptr)
+                                {
+                                    transaction->setErrorStatus();
+                                    return;
+                                }
+                                r = crow::connections::convertJsonToDbus(
+                                    m.get(), *property.signature,
+                                    transaction->propertyValue);
+                                if (r < 0)
+                                {
+                                    transaction->setErrorStatus();
+                                    return;
+                                }
+                                r = sd_bus_message_close_container(m.get());
+                                if (r < 0)
+                                {
+                                    transaction->setErrorStatus();
+                                    return;
+                                }
+
+                                crow::connections::systemBus->async_send(
+                                    m, [transaction](
+                                           boost::system::error_code ec,
+                                           sdbusplus::message::message &m) {
+                                        BMCWEB_LOG_DEBUG << "sent";
+                                        if (ec)
                                         {
-                                            transaction->setErrorStatus();
-                                            return;
+                                            transaction->res
+                                                .jsonValue["status"] = "error";
+                                            transaction->res
+                                                .jsonValue["message"] =
+                                                ec.message();
                                         }
-
-                                        crow::connections::systemBus
-                                            ->async_send(
-                                                m,
-                                                [transaction](
-                                                    boost::system::error_code
-                                                        ec,
-                                                    sdbusplus::message::message
-                                                        &m) {
-                                                    BMCWEB_LOG_DEBUG << "sent";
-                                                    if (ec)
-                                                    {
-                                                        transaction->res
-                                                            .jsonValue
-                                                                ["status"] =
-                                                            "error";
-                                                        transaction->res
-                                                            .jsonValue
-                                                                ["message"] =
-                                                            ec.message();
-                                                    }
-                                                });
-                                    }
-                                }
-                                propNode =
-                                    propNode->NextSiblingElement("property");
+                                    });
                             }
-                            ifaceNode =
-                                ifaceNode->NextSiblingElement("interface");
                         }
-                    },
-                    connectionName, transaction->objectPath,
-                    "org.freedesktop.DBus.Introspectable", "Introspect");
+                    });
             }
         },
         "xyz.openbmc_project.ObjectMapper",
@@ -1045,6 +819,237 @@ void handlePut(const crow::Request &req, crow::Response &res,
         transaction->objectPath, std::array<std::string, 0>());
 }
 
+/**
+ * @brief Answers a Range request on the file body of res
+ *
+ * Lets an interrupted download resume.  The ETag, made of the size and
+ * modification time, lets the client check with If-Range that the file is
+ * still the one it has the start of.
+ */
+inline void handleFileRange(const crow::Request &req, crow::Response &res)
+{
+    const crow::FileBody &file = res.getFileBody();
+    std::string etag = "\"" + std::to_string(file.size) + "-" +
+                       std::to_string(file.modified) + "\"";
+    res.addHeader("Accept-Ranges", "bytes");
+    res.addHeader("ETag", etag);
+
+    boost::string_view range = req.getHeaderValue(crow::KnownHeader::range);
+    boost::string_view ifRange =
+        req.getHeaderValue(crow::KnownHeader::ifRange);
+    if (range.empty() || (!ifRange.empty() && ifRange != etag))
+    {
+        return;
+    }
+    uint64_t first = 0;
+    uint64_t length = 0;
+    switch (http_helpers::parseByteRange(range, file.size, first, length))
+    {
+        case http_helpers::ByteRange::none:
+            break;
+        case http_helpers::ByteRange::satisfiable:
+            res.result(boost::beast::http::status::partial_content);
+            res.addHeader("Content-Range",
+                          "bytes " + std::to_string(first) + "-" +
+                              std::to_string(first + length - 1) + "/" +
+                              std::to_string(file.size));
+            res.setFileBodyRange(first, length);
+            break;
+        case http_helpers::ByteRange::unsatisfiable:
+            res.result(boost::beast::http::status::range_not_satisfiable);
+            res.addHeader("Content-Range",
+                          "bytes */" + std::to_string(file.size));
+            res.closeFileBody();
+            break;
+    }
+}
+
+// Operations of one /batch/ request that are handled at once
+constexpr size_t batchOperationsInFlight = 16;
+constexpr size_t maxBatchOperations = 1024;
+
+/**
+ * BatchTransaction
+ * Runs the operations of a /batch/ request through the /xyz/ routes as
+ * internal requests, a few at a time, and answers with the status and data
+ * of each, in order, once all are done.  The connection, authentication and
+ * request parsing are paid for once for the whole batch.
+ */
+template <typename App>
+class BatchTransaction
+    : public std::enable_shared_from_this<BatchTransaction<App>>
+{
+  public:
+    struct Operation
+    {
+        boost::beast::http::verb verb;
+        std::string path;
+        std::string body;
+    };
+
+    BatchTransaction(App &app, const crow::Request &req, crow::Response &res,
+                     std::vector<Operation> &&operations) :
+        app(app),
+        req(req), res(res), operations(std::move(operations)),
+        results(nlohmann::json::array())
+    {
+    }
+
+    void start()
+    {
+        for (size_t i = 0; i < operations.size(); i++)
+        {
+            results.push_back(nullptr);
+        }
+        while (next < operations.size() && next < batchOperationsInFlight)
+        {
+            startNext();
+        }
+    }
+
+  private:
+    struct SubRequest
+    {
+        boost::beast::http::request<boost::beast::http::string_body> beastReq;
+        crow::Request req{beastReq};
+        crow::Response res;
+    };
+
+    void startNext()
+    {
+        // Those finishing together may post more starts than there are
+        // operations left
+        if (next >= operations.size())
+        {
+            return;
+        }
+        size_t index = next++;
+        Operation &operation = operations[index];
+        auto sub = std::make_shared<SubRequest>();
+        sub->beastReq.method(operation.verb);
+        sub->beastReq.target(operation.path);
+        sub->beastReq.body() = std::move(operation.body);
+        // The results are collected from jsonValue, so keep enumerate from
+        // streaming its reply
+        sub->beastReq.version(10);
+        sub->req.url = operation.path;
+        sub->req.urlParams = crow::QueryString(operation.path);
+        sub->req.isSecure = req.isSecure;
+        sub->req.middlewareContext = req.middlewareContext;
+        sub->req.ioService = req.ioService;
+
+        auto self = this->shared_from_this();
+        sub->res.setCompleteRequestHandler([self, sub, index]() mutable {
+            // Clearing the handler destroys this lambda, so take what it
+            // holds first
+            std::shared_ptr<BatchTransaction> batch = std::move(self);
+            std::shared_ptr<SubRequest> done = std::move(sub);
+            size_t doneIndex = index;
+            done->res.setCompleteRequestHandler(nullptr);
+            batch->onDone(doneIndex, done->res);
+        });
+        app.handle(sub->req, sub->res);
+    }
+
+    void onDone(size_t index, crow::Response &sub)
+    {
+        results[index] = {{"status", sub.resultInt()},
+                          {"data", std::move(sub.jsonValue)}};
+        done++;
+        if (done == operations.size())
+        {
+            res.jsonValue = {{"status", "ok"},
+                             {"message", "200 OK"},
+                             {"data", std::move(results)}};
+            res.end();
+            return;
+        }
+        if (next < operations.size())
+        {
+            // Posted, so operations that complete at once don't each call
+            // the next one a frame deeper
+            auto self = this->shared_from_this();
+            req.ioService->post([self]() { self->startNext(); });
+        }
+    }
+
+    App &app;
+    const crow::Request &req;
+    crow::Response &res;
+    std::vector<Operation> operations;
+    nlohmann::json results;
+    size_t next = 0;
+    size_t done = 0;
+};
+
+/**
+ * @brief Reads the operations of a /batch/ request
+ *
+ * Each is an object with "op" of "get", "set" or "call", a "path" under
+ * /xyz/, and "data": the property value for a set, the argument array for a
+ * call.
+ *
+ * @return false if the request isn't a valid batch
+ */
+template <typename Operation>
+bool parseBatch(const std::string &body, std::vector<Operation> &operations)
+{
+    nlohmann::json batch = nlohmann::json::parse(body, nullptr, false);
+    if (!batch.is_array() || batch.empty() ||
+        batch.size() > maxBatchOperations)
+    {
+        return false;
+    }
+    operations.reserve(batch.size());
+    for (const nlohmann::json &item : batch)
+    {
+        if (!item.is_object())
+        {
+            return false;
+        }
+        const std::string *op = nullptr;
+        const std::string *path = nullptr;
+        nlohmann::json::const_iterator it = item.find("op");
+        if (it != item.end())
+        {
+            op = it->get_ptr<const std::string *>();
+        }
+        it = item.find("path");
+        if (it != item.end())
+        {
+            path = it->get_ptr<const std::string *>();
+        }
+        // Only the D-Bus REST routes can be batched
+        if (op == nullptr || path == nullptr ||
+            !boost::starts_with(*path, "/xyz/"))
+        {
+            return false;
+        }
+        nlohmann::json::const_iterator data = item.find("data");
+        if (*op == "get")
+        {
+            operations.push_back(
+                Operation{boost::beast::http::verb::get, *path, ""});
+        }
+        else if (*op == "set" && data != item.end())
+        {
+            operations.push_back(
+                Operation{boost::beast::http::verb::put, *path,
+                          nlohmann::json{{"data", *data}}.dump()});
+        }
+        else if (*op == "call" && data != item.end() && data->is_array())
+        {
+            operations.push_back(Operation{boost::beast::http::verb::post,
+                                           *path, data->dump()});
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 template <typename... Middlewares> void requestRoutes(Crow<Middlewares...> &app)
 {
     BMCWEB_ROUTE(app, "/bus/")
@@ -1078,7 +1083,7 @@ template <typename... Middlewares> void requestRoutes(Crow<Middlewares...> &app)
                     }
                     res.end();
                 };
-                crow::connections::systemBus->async_method_call(
+                crow::connections::tracedMethodCall(
                     std::move(myCallback), "org.freedesktop.DBus", "/",
                     "org.freedesktop.DBus", "ListNames");
             });
@@ -1089,6 +1094,22 @@ template <typename... Middlewares> void requestRoutes(Crow<Middlewares...> &app)
                 handle_list(res, "/");
             });
 
+    BMCWEB_ROUTE(app, "/batch/")
+        .methods("POST"_method)(
+            [&app](const crow::Request &req, crow::Response &res) {
+                using Transaction = BatchTransaction<Crow<Middlewares...>>;
+                std::vector<typename Transaction::Operation> operations;
+                if (!parseBatch(req.body, operations))
+                {
+                    res.result(boost::beast::http::status::bad_request);
+                    res.end();
+                    return;
+                }
+                std::make_shared<Transaction>(app, req, res,
+                                              std::move(operations))
+                    ->start();
+            });
+
     BMCWEB_ROUTE(app, "/xyz/<path>")
         .methods("GET"_method, "PUT"_method,
                  "POST"_method)([](const crow::Request &req,
@@ -1133,7 +1154,7 @@ template <typename... Middlewares> void requestRoutes(Crow<Middlewares...> &app)
                 if (boost::ends_with(objectPath, "/enumerate"))
                 {
                     objectPath.erase(objectPath.end() - 10, objectPath.end());
-                    handle_enumerate(res, objectPath);
+                    handle_enumerate(req, res, objectPath);
                 }
                 else if (boost::ends_with(objectPath, "/list"))
                 {
@@ -1166,7 +1187,8 @@ template <typename... Middlewares> void requestRoutes(Crow<Middlewares...> &app)
     BMCWEB_ROUTE(app, "/download/dump/<str>/")
         .methods("GET"_method)([](const crow::Request &req, crow::Response &res,
                                   const std::string &dumpId) {
-            std::regex validFilename("^[\\w\\- ]+(\\.?[\\w\\- ]+)$");
+            static const std::regex validFilename(
+                "^[\\w\\- ]+(\\.?[\\w\\- ]+)$", std::regex::optimize);
             if (!std::regex_match(dumpId, validFilename))
             {
                 res.result(boost::beast::http::status::not_found);
@@ -1176,7 +1198,7 @@ template <typename... Middlewares> void requestRoutes(Crow<Middlewares...> &app)
             std::experimental::filesystem::path loc(
                 "/var/lib/phosphor-debug-collector/dumps");
 
-            loc += dumpId;
+            loc /= dumpId;
 
             if (!std::experimental::filesystem::exists(loc) ||
                 !std::experimental::filesystem::is_directory(loc))
@@ -1188,15 +1210,21 @@ template <typename... Middlewares> void requestRoutes(Crow<Middlewares...> &app)
             std::experimental::filesystem::directory_iterator files(loc);
             for (auto &file : files)
             {
-                std::ifstream readFile(file.path());
-                if (readFile.good())
+                if (!std::experimental::filesystem::is_regular_file(
+                        file.path()))
+                {
+                    continue;
+                }
+                // Dumps can be large; stream the file rather than reading it
+                // into memory
+                if (!res.openFileBody(file.path().string()))
                 {
                     continue;
                 }
                 res.addHeader("Content-Type", "application/octet-stream");
-                res.body() = {std::istreambuf_iterator<char>(readFile),
-                              std::istreambuf_iterator<char>()};
+                handleFileRange(req, res);
                 res.end();
+                return;
             }
             res.result(boost::beast::http::status::not_found);
             res.end();
@@ -1256,10 +1284,13 @@ template <typename... Middlewares> void requestRoutes(Crow<Middlewares...> &app)
             }
             if (interfaceName.empty())
             {
-                crow::connections::systemBus->async_method_call(
-                    [&, processName,
-                     objectPath](const boost::system::error_code ec,
-                                 const std::string &introspect_xml) {
+                crow::connections::cachedIntrospect(
+                    processName, objectPath,
+                    [&, processName, objectPath](
+                        const boost::system::error_code ec,
+                        const std::shared_ptr<
+                            const crow::connections::IntrospectedObject>
+                            &object) {
                         if (ec)
                         {
                             BMCWEB_LOG_ERROR
@@ -1268,58 +1299,40 @@ template <typename... Middlewares> void requestRoutes(Crow<Middlewares...> &app)
                                 << " on process: " << processName
                                 << " path: " << objectPath << "\n";
                         }
+                        else if (object == nullptr)
+                        {
+                            res.jsonValue = {{"status", "XML parse error"}};
+                            res.result(boost::beast::http::status::
+                                           internal_server_error);
+                        }
                         else
                         {
-                            tinyxml2::XMLDocument doc;
-
-                            doc.Parse(introspect_xml.c_str());
-                            tinyxml2::XMLNode *pRoot =
-                                doc.FirstChildElement("node");
-                            if (pRoot == nullptr)
+                            nlohmann::json interfacesArray =
+                                nlohmann::json::array();
+                            for (const crow::connections::IntrospectedInterface
+                                     &interface : object->interfaces)
                             {
-                                BMCWEB_LOG_ERROR
-                                    << "XML document failed to parse "
-                                    << processName << " " << objectPath << "\n";
-                                res.jsonValue = {{"status", "XML parse error"}};
-                                res.result(boost::beast::http::status::
-                                               internal_server_error);
-                            }
-                            else
-                            {
-                                nlohmann::json interfacesArray =
-                                    nlohmann::json::array();
-                                tinyxml2::XMLElement *interface =
-                                    pRoot->FirstChildElement("interface");
-
-                                while (interface != nullptr)
-                                {
-                                    std::string ifaceName =
-                                        interface->Attribute("name");
-                                    interfacesArray.push_back(
-                                        {{"name", ifaceName}});
-
-                                    interface = interface->NextSiblingElement(
-                                        "interface");
-                                }
-                                res.jsonValue = {
-                                    {"status", "ok"},
-                                    {"bus_name", processName},
-                                    {"interfaces", interfacesArray},
-                                    {"objectPath", objectPath}};
+                                interfacesArray.push_back(
+                                    {{"name", interface.name}});
                             }
+                            res.jsonValue = {{"status", "ok"},
+                                             {"bus_name", processName},
+                                             {"interfaces", interfacesArray},
+                                             {"objectPath", objectPath}};
                         }
                         res.end();
-                    },
-                    processName, objectPath,
-                    "org.freedesktop.DBus.Introspectable", "Introspect");
+                    });
             }
             else
             {
-                crow::connections::systemBus->async_method_call(
+                crow::connections::cachedIntrospect(
+                    processName, objectPath,
                     [&, processName, objectPath,
-                     interface_name{std::move(interfaceName)}](
+                     interfaceName{std::move(interfaceName)}](
                         const boost::system::error_code ec,
-                        const std::string &introspect_xml) {
+                        const std::shared_ptr<
+                            const crow::connections::IntrospectedObject>
+                            &object) {
                         if (ec)
                         {
                             BMCWEB_LOG_ERROR
@@ -1328,141 +1341,82 @@ template <typename... Middlewares> void requestRoutes(Crow<Middlewares...> &app)
                                 << " on process: " << processName
                                 << " path: " << objectPath << "\n";
                         }
+                        else if (object == nullptr)
+                        {
+                            res.result(boost::beast::http::status::
+                                           internal_server_error);
+                        }
                         else
                         {
-                            tinyxml2::XMLDocument doc;
-
-                            doc.Parse(introspect_xml.c_str());
-                            tinyxml2::XMLNode *pRoot =
-                                doc.FirstChildElement("node");
-                            if (pRoot == nullptr)
+                            const crow::connections::IntrospectedInterface
+                                *interface =
+                                    object->findInterface(interfaceName);
+                            if (interface == nullptr)
                             {
-                                BMCWEB_LOG_ERROR
-                                    << "XML document failed to parse "
-                                    << processName << " " << objectPath << "\n";
-                                res.result(boost::beast::http::status::
-                                               internal_server_error);
+                                // if we got to the end of the list and
+                                // never found a match, throw 404
+                                res.result(
+                                    boost::beast::http::status::not_found);
                             }
                             else
                             {
-                                tinyxml2::XMLElement *node =
-                                    pRoot->FirstChildElement("node");
-
-                                // if we know we're the only call, build the
-                                // json directly
                                 nlohmann::json methodsArray =
                                     nlohmann::json::array();
-                                nlohmann::json signalsArray =
-                                    nlohmann::json::array();
-                                tinyxml2::XMLElement *interface =
-                                    pRoot->FirstChildElement("interface");
-
-                                while (interface != nullptr)
+                                for (const crow::connections::
+                                         IntrospectedMember &method :
+                                     interface->methods)
                                 {
-                                    std::string ifaceName =
-                                        interface->Attribute("name");
-
-                                    if (ifaceName == interfaceName)
+                                    nlohmann::json argsArray =
+                                        nlohmann::json::array();
+                                    for (const crow::connections::
+                                             IntrospectedArg &arg : method.args)
                                     {
-                                        tinyxml2::XMLElement *methods =
-                                            interface->FirstChildElement(
-                                                "method");
-                                        while (methods != nullptr)
-                                        {
-                                            nlohmann::json argsArray =
-                                                nlohmann::json::array();
-                                            tinyxml2::XMLElement *arg =
-                                                methods->FirstChildElement(
-                                                    "arg");
-                                            while (arg != nullptr)
-                                            {
-                                                argsArray.push_back(
-                                                    {{"name",
-                                                      arg->Attribute("name")},
-                                                     {"type",
-                                                      arg->Attribute("type")},
-                                                     {"direction",
-                                                      arg->Attribute(
-                                                          "direction")}});
-                                                arg = arg->NextSiblingElement(
-                                                    "arg");
-                                            }
-                                            methodsArray.push_back(
-                                                {{"name",
-                                                  methods->Attribute("name")},
-                                                 {"uri",
-                                                  "/bus/system/" + processName +
-                                                      objectPath + "/" +
-                                                      interfaceName + "/" +
-                                                      methods->Attribute(
-                                                          "name")},
-                                                 {"args", argsArray}});
-                                            methods =
-                                                methods->NextSiblingElement(
-                                                    "method");
-                                        }
-                                        tinyxml2::XMLElement *signals =
-                                            interface->FirstChildElement(
-                                                "signal");
-                                        while (signals != nullptr)
-                                        {
-                                            nlohmann::json argsArray =
-                                                nlohmann::json::array();
-
-                                            tinyxml2::XMLElement *arg =
-                                                signals->FirstChildElement(
-                                                    "arg");
-                                            while (arg != nullptr)
-                                            {
-                                                std::string name =
-                                                    arg->Attribute("name");
-                                                std::string type =
-                                                    arg->Attribute("type");
-                                                argsArray.push_back({
-                                                    {"name", name},
-                                                    {"type", type},
-                                                });
-                                                arg = arg->NextSiblingElement(
-                                                    "arg");
-                                            }
-                                            signalsArray.push_back(
-                                                {{"name",
-                                                  signals->Attribute("name")},
-                                                 {"args", argsArray}});
-                                            signals =
-                                                signals->NextSiblingElement(
-                                                    "signal");
-                                        }
-
-                                        res.jsonValue = {
-                                            {"status", "ok"},
-                                            {"bus_name", processName},
-                                            {"interface", interfaceName},
-                                            {"methods", methodsArray},
-                                            {"objectPath", objectPath},
-                                            {"properties",
-                                             nlohmann::json::object()},
-                                            {"signals", signalsArray}};
-
-                                        break;
+                                        argsArray.push_back(
+                                            {{"name", arg.name},
+                                             {"type", arg.type},
+                                             {"direction", arg.direction}});
                                     }
-
-                                    interface = interface->NextSiblingElement(
-                                        "interface");
+                                    methodsArray.push_back(
+                                        {{"name", method.name},
+                                         {"uri", "/bus/system/" + processName +
+                                                     objectPath + "/" +
+                                                     interfaceName + "/" +
+                                                     method.name},
+                                         {"args", argsArray}});
                                 }
-                                if (interface == nullptr)
+                                nlohmann::json signalsArray =
+                                    nlohmann::json::array();
+                                for (const crow::connections::
+                                         IntrospectedMember &signal :
+                                     interface->signals)
                                 {
-                                    // if we got to the end of the list and
-                                    // never found a match, throw 404
-                                    res.result(
-                                        boost::beast::http::status::not_found);
+                                    nlohmann::json argsArray =
+                                        nlohmann::json::array();
+                                    for (const crow::connections::
+                                             IntrospectedArg &arg : signal.args)
+                                    {
+                                        argsArray.push_back({
+                                            {"name", arg.name},
+                                            {"type", arg.type},
+                                        });
+                                    }
+                                    signalsArray.push_back(
+                                        {{"name", signal.name},
+                                         {"args", argsArray}});
                                 }
+
+                                res.jsonValue = {
+                                    {"status", "ok"},
+                                    {"bus_name", processName},
+                                    {"interface", interfaceName},
+                                    {"methods", methodsArray},
+                                    {"objectPath", objectPath},
+                                    {"properties", nlohmann::json::object()},
+                                    {"signals", signalsArray}};
                             }
                         }
                         res.end();
-                    },
-                    processName, objectPath,
-                    "org.freedesktop.DBus.Introspectable", "Introspect");
+                    });
             }
         });
 }
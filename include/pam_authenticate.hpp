@@ -1,10 +1,19 @@
 #pragma once
 
+#include <crow/logging.h>
 #include <security/pam_appl.h>
 
+#include <boost/asio/io_service.hpp>
 #include <boost/utility/string_view.hpp>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 // function used to get user input
 inline int pamFunctionConversation(int numMsg, const struct pam_message** msg,
@@ -75,6 +84,137 @@ inline bool pamAuthenticateUser(const boost::string_view username,
     return true;
 }
 
+// Runs PAM conversations off the thread that serves requests.  A module that
+// takes long to answer, such as LDAP, or pam_tally delaying after failed
+// attempts, then only holds up the request it is deciding.  The queue is
+// bounded, so a flood of login attempts is refused instead of piling up.
+class PamWorkerPool
+{
+  public:
+    PamWorkerPool() = default;
+    PamWorkerPool(const PamWorkerPool&) = delete;
+    PamWorkerPool& operator=(const PamWorkerPool&) = delete;
+
+    ~PamWorkerPool()
+    {
+        stop();
+    }
+
+    static constexpr size_t threadCount()
+    {
+        return 2;
+    }
+
+    static constexpr size_t maxQueued()
+    {
+        return 32;
+    }
+
+    // Checks a user's password on a worker thread, then calls back with the
+    // verdict on io.  Attempts beyond the queue bound are refused.
+    template <typename Callback>
+    void authenticate(boost::asio::io_service& io, std::string username,
+                      std::string password, Callback&& callback)
+    {
+        std::function<void(bool)> handler = std::forward<Callback>(callback);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!stopping && queue.size() < maxQueued())
+            {
+                if (threads.empty())
+                {
+                    startThreads();
+                }
+                queue.emplace_back(Job{&io, std::move(username),
+                                       std::move(password),
+                                       std::move(handler)});
+                wake.notify_one();
+                return;
+            }
+        }
+        BMCWEB_LOG_WARNING << "PAM queue full, refusing " << username;
+        io.post([handler{std::move(handler)}] { handler(false); });
+    }
+
+    // Drops the attempts still queued and waits for the ones in progress;
+    // their callbacks are posted but won't run unless io runs again
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            queue.clear();
+            wake.notify_all();
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        threads.clear();
+    }
+
+  private:
+    struct Job
+    {
+        boost::asio::io_service* io;
+        std::string username;
+        std::string password;
+        std::function<void(bool)> callback;
+    };
+
+    void startThreads()
+    {
+        for (size_t i = 0; i < threadCount(); i++)
+        {
+            threads.emplace_back([this] { run(); });
+        }
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            wake.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping)
+            {
+                return;
+            }
+            Job job = std::move(queue.front());
+            queue.pop_front();
+            lock.unlock();
+            bool ok = pamAuthenticateUser(job.username, job.password);
+            job.io->post([callback{std::move(job.callback)}, ok] {
+                callback(ok);
+            });
+            lock.lock();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Job> queue;
+    std::vector<std::thread> threads;
+    bool stopping = false;
+};
+
+inline PamWorkerPool& pamWorkerPool()
+{
+    static PamWorkerPool pool;
+    return pool;
+}
+
+// Checks a user's password without blocking the calling thread.  callback
+// is called on io with whether the user may log in.
+template <typename Callback>
+void pamAuthenticateUserAsync(boost::asio::io_service& io,
+                              std::string username, std::string password,
+                              Callback&& callback)
+{
+    pamWorkerPool().authenticate(io, std::move(username), std::move(password),
+                                 std::forward<Callback>(callback));
+}
+
 inline bool pamUpdatePassword(const std::string& username,
                               const std::string& password)
 {
@@ -3,7 +3,12 @@
 #include <crow/app.h>
 #include <crow/http_request.h>
 #include <crow/http_response.h>
+#include <fcntl.h>
+#include <unistd.h>
 
+#include <atomic>
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/container/flat_map.hpp>
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_generators.hpp>
@@ -12,6 +17,8 @@
 #include <pam_authenticate.hpp>
 #include <random>
 #include <sessions.hpp>
+#include <string>
+#include <thread>
 #include <webassets.hpp>
 
 namespace crow
@@ -20,6 +27,67 @@ namespace crow
 namespace persistent_data
 {
 
+/**
+ * @brief Replaces a file so that a crash leaves either the old or the new
+ *        contents: they go to a temporary file that is flushed to disk, then
+ *        renamed over the old one
+ *
+ * @return false if the file couldn't be written; the old one is left as is
+ */
+inline bool writeFileAtomically(const std::string& path,
+                                const std::string& contents)
+{
+    const std::string temporary = path + ".tmp";
+    int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                  0600);
+    if (fd < 0)
+    {
+        BMCWEB_LOG_ERROR << "Can't create " << temporary << ": " << errno;
+        return false;
+    }
+    const char* data = contents.data();
+    size_t left = contents.size();
+    while (left > 0)
+    {
+        ssize_t written = write(fd, data, left);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            BMCWEB_LOG_ERROR << "Can't write " << temporary << ": " << errno;
+            close(fd);
+            unlink(temporary.c_str());
+            return false;
+        }
+        data += written;
+        left -= static_cast<size_t>(written);
+    }
+    // Closed whether or not the sync worked, so a failed write leaks nothing
+    int syncError = fsync(fd);
+    int closeError = close(fd);
+    if (syncError != 0 || closeError != 0 ||
+        rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        BMCWEB_LOG_ERROR << "Can't replace " << path << ": " << errno;
+        unlink(temporary.c_str());
+        return false;
+    }
+
+    // The rename itself only lasts once the directory is on disk too
+    std::string::size_type slash = path.rfind('/');
+    const std::string directory =
+        slash == std::string::npos ? "." : path.substr(0, slash + 1);
+    int dirFd = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd >= 0)
+    {
+        fsync(dirFd);
+        close(dirFd);
+    }
+    return true;
+}
+
 class Middleware
 {
     // todo(ed) should read this from a fixed location somewhere, not CWD
@@ -38,12 +106,45 @@ class Middleware
 
     ~Middleware()
     {
-        if (persistent_data::SessionStore::getInstance().needsWrite())
+        stopWriter();
+    }
+
+    /**
+     * @brief Writes changes to the sessions behind the requests that make
+     *        them.  Changes within writeDelay() of each other are written
+     *        together, from a thread of their own, so a login doesn't wait
+     *        for flash.
+     */
+    void startWriter(boost::asio::io_service& io)
+    {
+        writeTimer = std::make_unique<boost::asio::steady_timer>(io);
+        SessionStore::getInstance().setChangeHandler(
+            [this] { scheduleWrite(); });
+        if (SessionStore::getInstance().needsWrite())
+        {
+            scheduleWrite();
+        }
+    }
+
+    // Waits for a write in progress and writes whatever is left; has to
+    // happen before the io_service goes away
+    void stopWriter()
+    {
+        SessionStore::getInstance().setChangeHandler(nullptr);
+        writeTimer.reset();
+        writePending = false;
+        joinWriterThread();
+        if (SessionStore::getInstance().needsWrite())
         {
             writeData();
         }
     }
 
+    static constexpr std::chrono::seconds writeDelay()
+    {
+        return std::chrono::seconds(1);
+    }
+
     void beforeHandle(crow::Request& req, Response& res, Context& ctx)
     {
     }
@@ -114,8 +215,7 @@ class Middleware
                                 << "Restored session: " << newSession->csrfToken
                                 << " " << newSession->uniqueId << " "
                                 << newSession->sessionToken;
-                            SessionStore::getInstance().authTokens.emplace(
-                                newSession->sessionToken, newSession);
+                            SessionStore::getInstance().addSession(newSession);
                         }
                     }
                     else
@@ -150,15 +250,63 @@ class Middleware
 
     void writeData()
     {
-        std::ofstream persistentFile(filename);
-        nlohmann::json data{
-            {"sessions", SessionStore::getInstance().authTokens},
-            {"system_uuid", systemUuid},
-            {"revision", jsonRevision}};
-        persistentFile << data;
+        writeFileAtomically(filename, snapshot().dump());
     }
 
     std::string systemUuid{""};
+
+  private:
+    // Copies what goes in the file, and takes the changes as written
+    nlohmann::json snapshot()
+    {
+        SessionStore& store = SessionStore::getInstance();
+        store.needWrite = false;
+        return nlohmann::json{{"sessions", store.authTokens},
+                              {"system_uuid", systemUuid},
+                              {"revision", jsonRevision}};
+    }
+
+    void scheduleWrite()
+    {
+        if (writeTimer == nullptr || writePending)
+        {
+            return;
+        }
+        writePending = true;
+        writeTimer->expires_from_now(writeDelay());
+        writeTimer->async_wait([this](const boost::system::error_code ec) {
+            if (ec)
+            {
+                return;
+            }
+            writePending = false;
+            if (writing)
+            {
+                // The last write is slow; give it another window
+                scheduleWrite();
+                return;
+            }
+            joinWriterThread();
+            writing = true;
+            writerThread = std::thread([this, data = snapshot()] {
+                writeFileAtomically(filename, data.dump());
+                writing = false;
+            });
+        });
+    }
+
+    void joinWriterThread()
+    {
+        if (writerThread.joinable())
+        {
+            writerThread.join();
+        }
+    }
+
+    std::unique_ptr<boost::asio::steady_timer> writeTimer;
+    bool writePending = false;
+    std::atomic<bool> writing{false};
+    std::thread writerThread;
 };
 
 } // namespace persistent_data
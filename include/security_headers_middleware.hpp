@@ -27,6 +27,19 @@ static const char* pragmaValue = "no-cache";
 static const char* cacheControlKey = "Cache-Control";
 static const char* cacheControlValue = "no-Store,no-Cache";
 
+// The headers above that never change, in the form Response::addHeaders()
+// takes
+inline const Response::HeaderBlock& securityHeaders()
+{
+    static const Response::HeaderBlock headers{
+        {strictTransportSecurityKey, strictTransportSecurityValue},
+        {uaCompatabilityKey, uaCompatabilityValue},
+        {xframeKey, xframeValue},
+        {xssKey, xssValue},
+        {contentSecurityKey, contentSecurityValue}};
+    return headers;
+}
+
 struct SecurityHeadersMiddleware
 {
     struct Context
@@ -50,13 +63,13 @@ struct SecurityHeadersMiddleware
          X-UA-Compatible header doesn't make sense when retrieving a JSON or
          javascript file.  It doesn't hurt anything, it's just ugly.
          */
-        res.addHeader(strictTransportSecurityKey, strictTransportSecurityValue);
-        res.addHeader(uaCompatabilityKey, uaCompatabilityValue);
-        res.addHeader(xframeKey, xframeValue);
-        res.addHeader(xssKey, xssValue);
-        res.addHeader(contentSecurityKey, contentSecurityValue);
-        res.addHeader(pragmaKey, pragmaValue);
-        res.addHeader(cacheControlKey, cacheControlValue);
+        res.addHeaders(securityHeaders());
+        // Static assets choose their own caching policy
+        if (res.getHeaderValue(cacheControlKey).empty())
+        {
+            res.addHeader(pragmaKey, pragmaValue);
+            res.addHeader(cacheControlKey, cacheControlValue);
+        }
 
 #ifdef BMCWEB_INSECURE_DISABLE_XSS_PREVENTION
 
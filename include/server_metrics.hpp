@@ -0,0 +1,52 @@
+#pragma once
+
+#include <crow/app.h>
+
+#include <dbus_utility.hpp>
+#include <privileges.hpp>
+#include <resource_cache.hpp>
+#include <token_authorization_middleware.hpp>
+#include <user_privileges.hpp>
+
+namespace crow
+{
+namespace server_metrics
+{
+
+// Per route latencies, bytes in and out, open connections and D-Bus call
+// latencies, for Prometheus to scrape.  Route names tell what the BMC
+// serves, so only users who may configure it can read them.
+template <typename... Middlewares> void requestRoutes(Crow<Middlewares...>& app)
+{
+    BMCWEB_ROUTE(app, "/metrics")
+        .methods("GET"_method)(
+            [&app](const crow::Request& req, crow::Response& res) {
+                auto& ctx =
+                    app.template getContext<token_authorization::Middleware>(
+                        req);
+                const redfish::OperationMap privileges = {
+                    {boost::beast::http::verb::get, {{"ConfigureManager"}}}};
+                redfish::Privileges userPrivileges;
+                if (ctx.session != nullptr)
+                {
+                    userPrivileges =
+                        redfish::userPrivilegeStore().get(*ctx.session);
+                }
+                if (!redfish::isMethodAllowedWithPrivileges(
+                        req.method(), privileges, userPrivileges))
+                {
+                    res.result(boost::beast::http::status::forbidden);
+                    res.end();
+                    return;
+                }
+                res.addHeader("Content-Type",
+                              "text/plain; version=0.0.4; charset=utf-8");
+                res.body() = app.metricsText();
+                connections::methodCallStats().appendMetrics(res.body());
+                redfish::resourceCache().appendMetrics(res.body());
+                res.end();
+            });
+}
+
+} // namespace server_metrics
+} // namespace crow
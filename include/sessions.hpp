@@ -4,13 +4,24 @@
 #include <crow/http_request.h>
 #include <crow/http_response.h>
 
-#include <boost/container/flat_map.hpp>
+#include <openssl/crypto.h>
+#include <openssl/rand.h>
+
+#include <array>
+#include <bitset>
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_generators.hpp>
 #include <boost/uuid/uuid_io.hpp>
+#include <functional>
+#include <memory>
 #include <nlohmann/json.hpp>
 #include <pam_authenticate.hpp>
+#include <queue>
 #include <random>
+#include <unordered_map>
+#include <vector>
 #include <webassets.hpp>
 
 namespace crow
@@ -22,7 +33,10 @@ namespace persistent_data
 enum class PersistenceType
 {
     TIMEOUT, // User session times out after a predetermined amount of time
-    SINGLE_REQUEST // User times out once this request is completed.
+    SINGLE_REQUEST, // User times out once this request is completed.
+    // Never in the SessionStore; lasts as long as what authenticated it
+    // holds on to it: a Basic auth cache entry, or a Unix socket connection
+    HELD
 };
 
 struct UserSession
@@ -33,6 +47,10 @@ struct UserSession
     std::string csrfToken;
     std::chrono::time_point<std::chrono::steady_clock> lastUpdated;
     PersistenceType persistence;
+    // Redfish privileges of the user, and the generation of the user data
+    // they were resolved from; see redfish::UserPrivilegeStore
+    std::bitset<32> privileges;
+    uint64_t privilegesGeneration = 0;
 
     /**
      * @brief Fills object with data from UserSession's JSON representation
@@ -98,6 +116,87 @@ struct UserSession
 
 class Middleware;
 
+// Draws random alphanumeric tokens.  Random bytes are read from OpenSSL a
+// buffer at a time, and bytes that would make some characters likelier than
+// others are skipped.
+class TokenGenerator
+{
+  public:
+    std::string generate(size_t length)
+    {
+        std::string token(length, '0');
+        for (char& c : token)
+        {
+            c = next();
+        }
+        return token;
+    }
+
+  private:
+    static constexpr const char* alphabet()
+    {
+        return "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+               "abcdefghijklmnopqrstuvwxyz";
+    }
+
+    static constexpr size_t alphabetSize()
+    {
+        return 62;
+    }
+
+    char next()
+    {
+        // The largest multiple of the alphabet size that fits in a byte
+        constexpr unsigned limit = 256 / alphabetSize() * alphabetSize();
+        while (true)
+        {
+            if (used == buffer.size())
+            {
+                refill();
+            }
+            unsigned char byte = buffer[used++];
+            if (byte < limit)
+            {
+                return alphabet()[byte % alphabetSize()];
+            }
+        }
+    }
+
+    void refill()
+    {
+        if (RAND_bytes(buffer.data(), static_cast<int>(buffer.size())) != 1)
+        {
+            BMCWEB_LOG_ERROR << "RAND_bytes failed, using random_device";
+            std::random_device rd;
+            std::uniform_int_distribution<int> dist(0, 255);
+            for (unsigned char& byte : buffer)
+            {
+                byte = static_cast<unsigned char>(dist(rd));
+            }
+        }
+        used = 0;
+    }
+
+    std::array<unsigned char, 256> buffer;
+    // Starts out empty, so the first token fills it
+    size_t used = 256;
+};
+
+// Compares session tokens in time that only depends on their length, so
+// timing a login attempt doesn't tell how much of a guess was right
+struct TokenEqual
+{
+    bool operator()(const std::string& a, const std::string& b) const
+    {
+        return a.size() == b.size() &&
+               CRYPTO_memcmp(a.data(), b.data(), a.size()) == 0;
+    }
+};
+
+// Sessions by token
+using SessionMap = std::unordered_map<std::string, std::shared_ptr<UserSession>,
+                                      std::hash<std::string>, TokenEqual>;
+
 class SessionStore
 {
   public:
@@ -107,93 +206,113 @@ class SessionStore
     {
         // TODO(ed) find a secure way to not generate session identifiers if
         // persistence is set to SINGLE_REQUEST
-        static constexpr std::array<char, 62> alphanum = {
-            '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'b', 'C',
-            'D', 'E', 'F', 'g', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
-            'Q', 'r', 'S', 'T', 'U', 'v', 'W', 'X', 'Y', 'Z', 'a', 'b', 'c',
-            'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p',
-            'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z'};
-
-        // entropy: 30 characters, 62 possibilities.  log2(62^30) = 178 bits of
+
+        // entropy: 20 characters, 62 possibilities.  log2(62^20) = 119 bits of
         // entropy.  OWASP recommends at least 60
         // https://www.owasp.org/index.php/Session_Management_Cheat_Sheet#Session_ID_Entropy
-        std::string sessionToken;
-        sessionToken.resize(20, '0');
-        std::uniform_int_distribution<int> dist(0, alphanum.size() - 1);
-        for (int i = 0; i < sessionToken.size(); ++i)
-        {
-            sessionToken[i] = alphanum[dist(rd)];
-        }
+        std::string sessionToken = tokenGenerator.generate(20);
         // Only need csrf tokens for cookie based auth, token doesn't matter
-        std::string csrfToken;
-        csrfToken.resize(20, '0');
-        for (int i = 0; i < csrfToken.size(); ++i)
-        {
-            csrfToken[i] = alphanum[dist(rd)];
-        }
+        std::string csrfToken = tokenGenerator.generate(20);
 
         std::string uniqueId;
-        uniqueId.resize(10, '0');
-        for (int i = 0; i < uniqueId.size(); ++i)
+        do
         {
-            uniqueId[i] = alphanum[dist(rd)];
-        }
+            uniqueId = tokenGenerator.generate(10);
+        } while (sessionsByUid.find(uniqueId) != sessionsByUid.end());
         auto session = std::make_shared<UserSession>(UserSession{
             uniqueId, sessionToken, std::string(username), csrfToken,
             std::chrono::steady_clock::now(), persistence});
-        auto it = authTokens.emplace(std::make_pair(sessionToken, session));
+        addSession(session);
         // Only need to write to disk if session isn't about to be destroyed.
-        needWrite = persistence == PersistenceType::TIMEOUT;
-        return it.first->second;
+        if (persistence == PersistenceType::TIMEOUT)
+        {
+            markForWrite();
+        }
+        return session;
     }
 
     std::shared_ptr<UserSession>
         loginSessionByToken(const boost::string_view token)
     {
-        applySessionTimeouts();
         auto sessionIt = authTokens.find(std::string(token));
         if (sessionIt == authTokens.end())
         {
             return nullptr;
         }
         std::shared_ptr<UserSession> userSession = sessionIt->second;
-        userSession->lastUpdated = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::time_point now =
+            std::chrono::steady_clock::now();
+        if (isExpired(*userSession, now))
+        {
+            // The expiry timer hasn't got to it yet
+            return nullptr;
+        }
+        userSession->lastUpdated = now;
         return userSession;
     }
 
     std::shared_ptr<UserSession> getSessionByUid(const boost::string_view uid)
     {
-        applySessionTimeouts();
-        // TODO(Ed) this is inefficient
-        auto sessionIt = authTokens.begin();
-        while (sessionIt != authTokens.end())
+        auto sessionIt = sessionsByUid.find(std::string(uid));
+        if (sessionIt == sessionsByUid.end() ||
+            isExpired(*sessionIt->second, std::chrono::steady_clock::now()))
         {
-            if (sessionIt->second->uniqueId == uid)
-            {
-                return sessionIt->second;
-            }
-            sessionIt++;
+            return nullptr;
         }
-        return nullptr;
+        return sessionIt->second;
     }
 
     void removeSession(std::shared_ptr<UserSession> session)
     {
-        authTokens.erase(session->sessionToken);
-        needWrite = true;
+        // Single request sessions never make it to disk, so removing one
+        // doesn't need a write either
+        auto sessionIt = authTokens.find(session->sessionToken);
+        if (sessionIt == authTokens.end())
+        {
+            return;
+        }
+        eraseSession(sessionIt);
+        if (session->persistence == PersistenceType::TIMEOUT)
+        {
+            markForWrite();
+        }
+    }
+
+    // Removes every session of a user, as when the user is deleted
+    void removeUserSessions(const std::string& username)
+    {
+        bool removedPersistent = false;
+        for (auto it = authTokens.begin(); it != authTokens.end();)
+        {
+            if (it->second->username != username)
+            {
+                ++it;
+                continue;
+            }
+            if (it->second->persistence == PersistenceType::TIMEOUT)
+            {
+                removedPersistent = true;
+            }
+            it = eraseSession(it);
+        }
+        if (removedPersistent)
+        {
+            markForWrite();
+        }
     }
 
     std::vector<const std::string*> getUniqueIds(
         bool getAll = true,
         const PersistenceType& type = PersistenceType::SINGLE_REQUEST)
     {
-        applySessionTimeouts();
-
+        std::chrono::steady_clock::time_point now =
+            std::chrono::steady_clock::now();
         std::vector<const std::string*> ret;
         ret.reserve(authTokens.size());
         for (auto& session : authTokens)
         {
-            if (getAll || type == session.second->persistence)
+            if ((getAll || type == session.second->persistence) &&
+                !isExpired(*session.second, now))
             {
                 ret.push_back(&session.second->uniqueId);
             }
@@ -205,11 +324,59 @@ class SessionStore
     {
         return needWrite;
     }
+
+    // Called whenever a change has to reach the persistent file
+    void setChangeHandler(std::function<void()> handler)
+    {
+        changeHandler = std::move(handler);
+    }
     int getTimeoutInSeconds() const
     {
         return std::chrono::seconds(timeoutInMinutes).count();
     };
 
+    // Reclaims expired sessions on io from now on, as they expire.  Sessions
+    // are only ever timed out from here; lookups just ignore expired ones.
+    void startExpiryTimer(boost::asio::io_service& io)
+    {
+        expiryTimer = std::make_unique<boost::asio::steady_timer>(io);
+        timerArmed = false;
+        armExpiryTimer();
+    }
+
+    // Drops the timer; has to happen before its io_service goes away
+    void stopExpiryTimer()
+    {
+        expiryTimer.reset();
+        timerArmed = false;
+    }
+
+    // Removes every session that expired by now
+    void expireSessions(std::chrono::steady_clock::time_point now)
+    {
+        while (!expiryQueue.empty() && expiryQueue.top().first <= now)
+        {
+            std::string token = expiryQueue.top().second;
+            expiryQueue.pop();
+            auto sessionIt = authTokens.find(token);
+            if (sessionIt == authTokens.end())
+            {
+                // Logged out already
+                continue;
+            }
+            if (isExpired(*sessionIt->second, now))
+            {
+                eraseSession(sessionIt);
+                markForWrite();
+            }
+            else
+            {
+                // Used since it was queued; look again when it would expire
+                expiryQueue.emplace(expiresAt(*sessionIt->second), token);
+            }
+        }
+    }
+
     // Persistent data middleware needs to be able to serialize our authTokens
     // structure, which is private
     friend Middleware;
@@ -228,33 +395,92 @@ class SessionStore
     {
     }
 
-    void applySessionTimeouts()
+    // Adds a session to both indexes, unless its token or unique id is
+    // taken already
+    void addSession(const std::shared_ptr<UserSession>& session)
     {
-        auto timeNow = std::chrono::steady_clock::now();
-        if (timeNow - lastTimeoutUpdate > std::chrono::minutes(1))
+        if (sessionsByUid.find(session->uniqueId) != sessionsByUid.end())
+        {
+            return;
+        }
+        if (!authTokens.emplace(session->sessionToken, session).second)
+        {
+            return;
+        }
+        sessionsByUid.emplace(session->uniqueId, session);
+        // Single request sessions are removed once their request is done
+        if (session->persistence == PersistenceType::TIMEOUT)
         {
-            lastTimeoutUpdate = timeNow;
-            auto authTokensIt = authTokens.begin();
-            while (authTokensIt != authTokens.end())
+            expiryQueue.emplace(expiresAt(*session), session->sessionToken);
+            armExpiryTimer();
+        }
+    }
+
+    std::chrono::steady_clock::time_point
+        expiresAt(const UserSession& session) const
+    {
+        return session.lastUpdated + timeoutInMinutes;
+    }
+
+    bool isExpired(const UserSession& session,
+                   std::chrono::steady_clock::time_point now) const
+    {
+        return session.persistence == PersistenceType::TIMEOUT &&
+               now >= expiresAt(session);
+    }
+
+    // Sessions get the same timeout, so a new one never expires before the
+    // one the timer waits for, and the timer only needs arming when idle
+    void armExpiryTimer()
+    {
+        if (expiryTimer == nullptr || timerArmed || expiryQueue.empty())
+        {
+            return;
+        }
+        timerArmed = true;
+        expiryTimer->expires_at(expiryQueue.top().first);
+        expiryTimer->async_wait([this](const boost::system::error_code ec) {
+            if (ec)
             {
-                if (timeNow - authTokensIt->second->lastUpdated >=
-                    timeoutInMinutes)
-                {
-                    authTokensIt = authTokens.erase(authTokensIt);
-                    needWrite = true;
-                }
-                else
-                {
-                    authTokensIt++;
-                }
+                return;
             }
+            timerArmed = false;
+            expireSessions(std::chrono::steady_clock::now());
+            armExpiryTimer();
+        });
+    }
+
+    void markForWrite()
+    {
+        needWrite = true;
+        if (changeHandler)
+        {
+            changeHandler();
         }
     }
-    std::chrono::time_point<std::chrono::steady_clock> lastTimeoutUpdate;
-    boost::container::flat_map<std::string, std::shared_ptr<UserSession>>
-        authTokens;
-    std::random_device rd;
+
+    SessionMap::iterator eraseSession(SessionMap::iterator sessionIt)
+    {
+        sessionsByUid.erase(sessionIt->second->uniqueId);
+        return authTokens.erase(sessionIt);
+    }
+
+    using ExpiryEntry =
+        std::pair<std::chrono::steady_clock::time_point, std::string>;
+    // Tokens of the sessions by when they expire at the earliest; a session
+    // used since is queued again when popped
+    std::priority_queue<ExpiryEntry, std::vector<ExpiryEntry>,
+                        std::greater<ExpiryEntry>>
+        expiryQueue;
+    std::unique_ptr<boost::asio::steady_timer> expiryTimer;
+    bool timerArmed = false;
+    SessionMap authTokens;
+    // The same sessions by unique id, for the Redfish Sessions resources
+    std::unordered_map<std::string, std::shared_ptr<UserSession>>
+        sessionsByUid;
+    TokenGenerator tokenGenerator;
     bool needWrite{false};
+    std::function<void()> changeHandler;
     std::chrono::minutes timeoutInMinutes;
 };
 
@@ -0,0 +1,221 @@
+#pragma once
+#include <crow/logging.h>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/container/flat_map.hpp>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <sdbusplus/asio/connection.hpp>
+#include <sdbusplus/bus/match.hpp>
+#include <string>
+#include <systemd/sd-bus.h>
+#include <utility>
+#include <vector>
+
+namespace crow
+{
+namespace connections
+{
+
+/**
+ * @brief One set of D-Bus signal matches, shared by everything that only
+ *        needs to know that something changed
+ *
+ * Each match costs the bus daemon a rule to check every signal against, and
+ * each listener with its own copy of the same rules would be woken with
+ * its own copy of the same message.  Listeners subscribed here are called
+ * with what changed instead:
+ *   - properties of an interface on an object under /xyz/openbmc_project,
+ *   - an object gaining or losing interfaces,
+ *   - a service with a well known name starting or stopping.
+ * Listeners that need the values that changed, or the interfaces added,
+ * are handed the signal itself, with the path to check before reading it.
+ */
+class SignalDispatcher
+{
+  public:
+    struct Listener
+    {
+        // Object path, interface, and the names of the properties that
+        // changed or were invalidated
+        std::function<void(const std::string&, const std::string&,
+                           const std::vector<std::string>&)>
+            propertiesChanged;
+        // Object path, interface, and the PropertiesChanged signal, rewound
+        // to its start
+        std::function<void(const std::string&, const std::string&,
+                           sdbusplus::message::message&)>
+            propertyValues;
+        // Object path
+        std::function<void(const std::string&)> objectChanged;
+        // Object path, and the InterfacesAdded or InterfacesRemoved signal,
+        // rewound to its start
+        std::function<void(const std::string&, sdbusplus::message::message&)>
+            interfacesAdded;
+        std::function<void(const std::string&, sdbusplus::message::message&)>
+            interfacesRemoved;
+        // Well known name of the service
+        std::function<void(const std::string&)> serviceChanged;
+    };
+
+    void start(sdbusplus::asio::connection& bus)
+    {
+        matches.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+            bus,
+            "type='signal',interface='org.freedesktop.DBus.Properties',"
+            "member='PropertiesChanged',"
+            "path_namespace='/xyz/openbmc_project'",
+            [this](sdbusplus::message::message& message) {
+                std::string interface;
+                boost::container::flat_map<std::string, Value> changed;
+                std::vector<std::string> invalidated;
+                message.read(interface, changed, invalidated);
+                for (auto& property : changed)
+                {
+                    invalidated.push_back(std::move(property.first));
+                }
+                const std::string path = message.get_path();
+                notifyPropertiesChanged(path, interface, invalidated);
+                for (auto& listener : listeners)
+                {
+                    if (listener.second.propertyValues)
+                    {
+                        rewind(message);
+                        listener.second.propertyValues(path, interface,
+                                                       message);
+                    }
+                }
+            }));
+        matches.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+            bus,
+            "type='signal',interface='org.freedesktop.DBus.ObjectManager',"
+            "member='InterfacesAdded'",
+            [this](sdbusplus::message::message& message) {
+                onInterfaces(message, &Listener::interfacesAdded);
+            }));
+        matches.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+            bus,
+            "type='signal',interface='org.freedesktop.DBus.ObjectManager',"
+            "member='InterfacesRemoved'",
+            [this](sdbusplus::message::message& message) {
+                onInterfaces(message, &Listener::interfacesRemoved);
+            }));
+        matches.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+            bus,
+            "type='signal',sender='org.freedesktop.DBus',"
+            "interface='org.freedesktop.DBus',member='NameOwnerChanged'",
+            [this](sdbusplus::message::message& message) {
+                std::string name;
+                message.read(name);
+                // Unique names come and go with every client connecting
+                if (!boost::starts_with(name, ":"))
+                {
+                    notifyServiceChanged(name);
+                }
+            }));
+    }
+
+    // Drops the signal matches; has to happen before the bus goes away
+    void stop()
+    {
+        matches.clear();
+    }
+
+    // Returns an id to unsubscribe with
+    uint64_t subscribe(Listener&& listener)
+    {
+        uint64_t id = ++lastId;
+        listeners.emplace(id, std::move(listener));
+        return id;
+    }
+
+    void unsubscribe(uint64_t id)
+    {
+        listeners.erase(id);
+    }
+
+    // The signal handlers call these; tests can too
+    void notifyPropertiesChanged(const std::string& path,
+                                 const std::string& interface,
+                                 const std::vector<std::string>& properties)
+    {
+        for (auto& listener : listeners)
+        {
+            if (listener.second.propertiesChanged)
+            {
+                listener.second.propertiesChanged(path, interface,
+                                                  properties);
+            }
+        }
+    }
+
+    void notifyObjectChanged(const std::string& path)
+    {
+        for (auto& listener : listeners)
+        {
+            if (listener.second.objectChanged)
+            {
+                listener.second.objectChanged(path);
+            }
+        }
+    }
+
+    void notifyServiceChanged(const std::string& name)
+    {
+        BMCWEB_LOG_DEBUG << "Service " << name << " changed owner";
+        for (auto& listener : listeners)
+        {
+            if (listener.second.serviceChanged)
+            {
+                listener.second.serviceChanged(name);
+            }
+        }
+    }
+
+  private:
+    using InterfacesCallback = std::function<void(
+        const std::string&, sdbusplus::message::message&)>;
+
+    void onInterfaces(sdbusplus::message::message& message,
+                      InterfacesCallback Listener::*callback)
+    {
+        sdbusplus::message::object_path path;
+        message.read(path);
+        notifyObjectChanged(path.str);
+        for (auto& listener : listeners)
+        {
+            if (listener.second.*callback)
+            {
+                rewind(message);
+                (listener.second.*callback)(path.str, message);
+            }
+        }
+    }
+
+    // So each listener reads the signal from the start
+    static void rewind(sdbusplus::message::message& message)
+    {
+        sd_bus_message_rewind(message.get(), 1);
+    }
+
+    // Only the names of the properties are passed on; values of other types
+    // are skipped when read
+    using Value = sdbusplus::message::variant<std::string, bool, uint8_t,
+                                              int16_t, uint16_t, int32_t,
+                                              uint32_t, int64_t, uint64_t,
+                                              double>;
+
+    std::vector<std::unique_ptr<sdbusplus::bus::match::match>> matches;
+    boost::container::flat_map<uint64_t, Listener> listeners;
+    uint64_t lastId = 0;
+};
+
+inline SignalDispatcher& signalDispatcher()
+{
+    static SignalDispatcher dispatcher;
+    return dispatcher;
+}
+
+} // namespace connections
+} // namespace crow
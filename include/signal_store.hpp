@@ -0,0 +1,138 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <signal_dispatcher.hpp>
+#include <utility>
+#include <vector>
+
+namespace crow
+{
+namespace connections
+{
+
+/**
+ * @brief D-Bus state loaded on first use and then kept current from the
+ *        SignalDispatcher, and the requests waiting for it
+ *
+ * The listener is subscribed before the first load, so no change made
+ * during a load is missed.  A change the owner can't apply in place calls
+ * invalidate(), which drops what's loaded; made during a load, it leaves
+ * the load stale, and the next request loads again.
+ *
+ * @tparam Data  What a load reads
+ */
+template <typename Data> class SignalStore
+{
+  public:
+    // Called with whether the data could be read, and the data.  The
+    // reference is only good during the call.
+    using Callback = std::function<void(bool, const Data&)>;
+    // Reads into data(), then calls finish() with the generation it's given
+    using LoadFunction = std::function<void(uint64_t)>;
+
+    SignalStore(SignalDispatcher::Listener listener, LoadFunction load) :
+        listener(std::move(listener)), loadFunction(std::move(load))
+    {
+    }
+
+    template <typename Handler> void get(Handler&& callback)
+    {
+        if (state == State::ready)
+        {
+            callback(true, stored);
+            return;
+        }
+        waiting.emplace_back(std::forward<Handler>(callback));
+        if (state == State::empty)
+        {
+            load();
+        }
+    }
+
+    void invalidate()
+    {
+        currentGeneration++;
+        if (state == State::ready)
+        {
+            state = State::empty;
+            stored = Data();
+        }
+    }
+
+    void stop()
+    {
+        if (subscribed)
+        {
+            signalDispatcher().unsubscribe(subscription);
+            subscribed = false;
+        }
+        invalidate();
+    }
+
+    // What's loaded, or read so far by a load, for signals to update
+    Data& data()
+    {
+        return stored;
+    }
+
+    bool ready() const
+    {
+        return state == State::ready;
+    }
+
+    void finish(bool ok, uint64_t loadGeneration)
+    {
+        // Whatever changed during the load may be missing, so the requests
+        // already waiting get what was read, and the next one reloads
+        Data loaded;
+        if (ok && currentGeneration == loadGeneration)
+        {
+            state = State::ready;
+        }
+        else
+        {
+            state = State::empty;
+            std::swap(loaded, stored);
+        }
+        const Data& result = state == State::ready ? stored : loaded;
+        std::vector<Callback> callbacks;
+        callbacks.swap(waiting);
+        for (Callback& callback : callbacks)
+        {
+            callback(ok, result);
+        }
+    }
+
+  private:
+    enum class State
+    {
+        empty,
+        loading,
+        ready
+    };
+
+    void load()
+    {
+        if (!subscribed)
+        {
+            subscription = signalDispatcher().subscribe(
+                SignalDispatcher::Listener(listener));
+            subscribed = true;
+        }
+        state = State::loading;
+        stored = Data();
+        loadFunction(currentGeneration);
+    }
+
+    SignalDispatcher::Listener listener;
+    LoadFunction loadFunction;
+    State state = State::empty;
+    uint64_t currentGeneration = 0;
+    Data stored;
+    std::vector<Callback> waiting;
+    uint64_t subscription = 0;
+    bool subscribed = false;
+};
+
+} // namespace connections
+} // namespace crow
@@ -1,6 +1,7 @@
 #pragma once
 #ifdef BMCWEB_ENABLE_SSL
 
+#include <crow/logging.h>
 #include <openssl/bio.h>
 #include <openssl/dh.h>
 #include <openssl/dsa.h>
@@ -10,9 +11,19 @@
 #include <openssl/rand.h>
 #include <openssl/rsa.h>
 #include <openssl/ssl.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#else
+#include <openssl/hmac.h>
+#endif
 
+#include <array>
 #include <boost/asio.hpp>
+#include <chrono>
+#include <cstring>
+#include <mutex>
 #include <random>
+#include <thread>
 
 namespace ensuressl
 {
@@ -22,6 +33,20 @@ static EVP_PKEY *createRsaKey();
 static EVP_PKEY *createEcKey();
 static void handleOpensslError();
 
+// Kinds of key a self-signed certificate can be generated for.  P-256 keys
+// generate in milliseconds and make handshakes cheaper than RSA ones
+enum class KeyType
+{
+    ec,
+    rsa
+};
+
+#ifdef BMCWEB_GENERATE_RSA_CERTIFICATE
+constexpr KeyType generatedKeyType = KeyType::rsa;
+#else
+constexpr KeyType generatedKeyType = KeyType::ec;
+#endif
+
 inline bool verifyOpensslKeyCert(const std::string &filepath)
 {
     bool privateKeyValid = false;
@@ -42,7 +67,9 @@ inline bool verifyOpensslKeyCert(const std::string &filepath)
                 std::cout << "Found an RSA key\n";
                 if (RSA_check_key(rsa) == 1)
                 {
-                    // private_key_valid = true;
+                    // Only keep RSA keys when that's what we'd generate, so
+                    // switching to EC replaces them
+                    privateKeyValid = generatedKeyType == KeyType::rsa;
                 }
                 else
                 {
@@ -100,81 +127,128 @@ inline bool verifyOpensslKeyCert(const std::string &filepath)
     return certValid;
 }
 
-inline void generateSslCertificate(const std::string &filepath)
+/**
+ * @brief Makes a self-signed certificate for a key
+ *
+ * @param[in] pkey  Key to certify and sign with
+ *
+ * @return The certificate, or nullptr on error
+ */
+inline X509 *makeSelfSignedCertificate(EVP_PKEY *pkey)
 {
-    FILE *pFile = NULL;
-    std::cout << "Generating new keys\n";
-    initOpenssl();
+    std::cerr << "Generating x509 Certificate\n";
+    // Use this code to directly generate a certificate
+    X509 *x509;
+    x509 = X509_new();
+    if (x509 == nullptr)
+    {
+        return nullptr;
+    }
+    // get a random number from the RNG for the certificate serial
+    // number If this is not random, regenerating certs throws broswer
+    // errors
+    std::random_device rd;
+    int serial = rd();
+
+    ASN1_INTEGER_set(X509_get_serialNumber(x509), serial);
+
+    // not before this moment
+    X509_gmtime_adj(X509_get_notBefore(x509), 0);
+    // Cert is valid for 10 years
+    X509_gmtime_adj(X509_get_notAfter(x509), 60L * 60L * 24L * 365L * 10L);
+
+    // set the public key to the key we just generated
+    X509_set_pubkey(x509, pkey);
+
+    // get the subject name
+    X509_NAME *name;
+    name = X509_get_subject_name(x509);
+
+    X509_NAME_add_entry_by_txt(name, "C", MBSTRING_ASC,
+                               reinterpret_cast<const unsigned char *>("US"),
+                               -1, -1, 0);
+    X509_NAME_add_entry_by_txt(
+        name, "O", MBSTRING_ASC,
+        reinterpret_cast<const unsigned char *>("Intel BMC"), -1, -1, 0);
+    X509_NAME_add_entry_by_txt(
+        name, "CN", MBSTRING_ASC,
+        reinterpret_cast<const unsigned char *>("testhost"), -1, -1, 0);
+    // set the CSR options
+    X509_set_issuer_name(x509, name);
+
+    // Sign the certificate with our private key
+    if (X509_sign(x509, pkey, EVP_sha256()) == 0)
+    {
+        handleOpensslError();
+        X509_free(x509);
+        return nullptr;
+    }
+    return x509;
+}
 
-    // std::cerr << "Generating RSA key";
-    // EVP_PKEY *pRsaPrivKey = create_rsa_key();
+/**
+ * @brief Generates a key of the given type and a self-signed certificate for
+ *        it
+ *
+ * @param[in] keyType  Kind of key to generate
+ * @param[out] pkey    Receives the key
+ * @param[out] x509    Receives the certificate
+ *
+ * @return false if either couldn't be made; nothing is returned then
+ */
+inline bool generateKeyAndCertificate(KeyType keyType, EVP_PKEY *&pkey,
+                                      X509 *&x509)
+{
+    initOpenssl();
 
-    std::cerr << "Generating EC key\n";
-    EVP_PKEY *pRsaPrivKey = createEcKey();
-    if (pRsaPrivKey != nullptr)
+    if (keyType == KeyType::rsa)
     {
-        std::cerr << "Generating x509 Certificate\n";
-        // Use this code to directly generate a certificate
-        X509 *x509;
-        x509 = X509_new();
-        if (x509 != nullptr)
-        {
-            // get a random number from the RNG for the certificate serial
-            // number If this is not random, regenerating certs throws broswer
-            // errors
-            std::random_device rd;
-            int serial = rd();
-
-            ASN1_INTEGER_set(X509_get_serialNumber(x509), serial);
-
-            // not before this moment
-            X509_gmtime_adj(X509_get_notBefore(x509), 0);
-            // Cert is valid for 10 years
-            X509_gmtime_adj(X509_get_notAfter(x509),
-                            60L * 60L * 24L * 365L * 10L);
-
-            // set the public key to the key we just generated
-            X509_set_pubkey(x509, pRsaPrivKey);
-
-            // get the subject name
-            X509_NAME *name;
-            name = X509_get_subject_name(x509);
-
-            X509_NAME_add_entry_by_txt(
-                name, "C", MBSTRING_ASC,
-                reinterpret_cast<const unsigned char *>("US"), -1, -1, 0);
-            X509_NAME_add_entry_by_txt(
-                name, "O", MBSTRING_ASC,
-                reinterpret_cast<const unsigned char *>("Intel BMC"), -1, -1,
-                0);
-            X509_NAME_add_entry_by_txt(
-                name, "CN", MBSTRING_ASC,
-                reinterpret_cast<const unsigned char *>("testhost"), -1, -1, 0);
-            // set the CSR options
-            X509_set_issuer_name(x509, name);
-
-            // Sign the certificate with our private key
-            X509_sign(x509, pRsaPrivKey, EVP_sha256());
-
-            pFile = fopen(filepath.c_str(), "wt");
-
-            if (pFile != nullptr)
-            {
-                PEM_write_PrivateKey(pFile, pRsaPrivKey, NULL, NULL, 0, 0,
-                                     NULL);
+        std::cerr << "Generating RSA key\n";
+        pkey = createRsaKey();
+    }
+    else
+    {
+        std::cerr << "Generating EC key\n";
+        pkey = createEcKey();
+    }
+    if (pkey == nullptr)
+    {
+        return false;
+    }
+    x509 = makeSelfSignedCertificate(pkey);
+    if (x509 == nullptr)
+    {
+        EVP_PKEY_free(pkey);
+        pkey = nullptr;
+        return false;
+    }
+    return true;
+}
 
-                PEM_write_X509(pFile, x509);
-                fclose(pFile);
-                pFile = NULL;
-            }
+inline void generateSslCertificate(const std::string &filepath,
+                                   KeyType keyType = generatedKeyType)
+{
+    std::cout << "Generating new keys\n";
+    EVP_PKEY *pkey = nullptr;
+    X509 *x509 = nullptr;
+    if (!generateKeyAndCertificate(keyType, pkey, x509))
+    {
+        return;
+    }
 
-            X509_free(x509);
-        }
+    FILE *pFile = fopen(filepath.c_str(), "wt");
+    if (pFile != nullptr)
+    {
+        PEM_write_PrivateKey(pFile, pkey, NULL, NULL, 0, 0, NULL);
 
-        EVP_PKEY_free(pRsaPrivKey);
-        pRsaPrivKey = NULL;
+        PEM_write_X509(pFile, x509);
+        fclose(pFile);
+        pFile = NULL;
     }
 
+    X509_free(x509);
+    EVP_PKEY_free(pkey);
+
     // cleanup_openssl();
 }
 
@@ -184,7 +258,16 @@ EVP_PKEY *createRsaKey()
 #if OPENSSL_VERSION_NUMBER < 0x00908000L
     pRSA = RSA_generate_key(2048, RSA_3, NULL, NULL);
 #else
-    RSA_generate_key_ex(pRSA, 2048, NULL, NULL);
+    pRSA = RSA_new();
+    BIGNUM *exponent = BN_new();
+    if (pRSA != nullptr && exponent != nullptr &&
+        (BN_set_word(exponent, RSA_F4) != 1 ||
+         RSA_generate_key_ex(pRSA, 2048, exponent, NULL) != 1))
+    {
+        RSA_free(pRSA);
+        pRSA = NULL;
+    }
+    BN_free(exponent);
 #endif
 
     EVP_PKEY *pKey = EVP_PKEY_new();
@@ -280,6 +363,395 @@ inline void ensureOpensslKeyPresentAndValid(const std::string &filepath)
     }
 }
 
+/**
+ * @brief Certificate handed out to new handshakes in place of the one the
+ *        ssl::context was built with
+ *
+ * Lets a certificate generated after startup be swapped in without touching
+ * the SSL_CTX, which other threads are creating connections from.
+ */
+class ServerCertificate
+{
+  public:
+    ~ServerCertificate()
+    {
+        set(nullptr, nullptr);
+    }
+
+    /**
+     * @brief Replaces the certificate; takes ownership of both arguments
+     */
+    void set(EVP_PKEY *newPkey, X509 *newX509)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pkey != nullptr)
+        {
+            EVP_PKEY_free(pkey);
+        }
+        if (x509 != nullptr)
+        {
+            X509_free(x509);
+        }
+        pkey = newPkey;
+        x509 = newX509;
+    }
+
+    /**
+     * @brief Puts the certificate on a connection, if one has been set
+     *
+     * @return false if the connection couldn't take it
+     */
+    bool use(SSL *ssl)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pkey == nullptr || x509 == nullptr)
+        {
+            return true;
+        }
+        return SSL_use_certificate(ssl, x509) == 1 &&
+               SSL_use_PrivateKey(ssl, pkey) == 1;
+    }
+
+  private:
+    std::mutex mutex;
+    EVP_PKEY *pkey = nullptr;
+    X509 *x509 = nullptr;
+};
+
+inline ServerCertificate &serverCertificate()
+{
+    static ServerCertificate certificate;
+    return certificate;
+}
+
+inline int certificateCallback(SSL *ssl, void * /*arg*/)
+{
+    return serverCertificate().use(ssl) ? 1 : 0;
+}
+
+/**
+ * @brief Generates the server's certificate on its own thread, so the server
+ *        can listen while a slow key is made
+ */
+class CertificateGenerator
+{
+  public:
+    ~CertificateGenerator()
+    {
+        stop();
+    }
+
+    /**
+     * @brief Generates a key and certificate, writes them to filepath, and
+     *        hands them to serverCertificate()
+     */
+    void start(const std::string &filepath, KeyType keyType)
+    {
+        thread = std::thread([filepath, keyType]() {
+            EVP_PKEY *pkey = nullptr;
+            X509 *x509 = nullptr;
+            if (!generateKeyAndCertificate(keyType, pkey, x509))
+            {
+                BMCWEB_LOG_ERROR << "Couldn't generate a certificate, still "
+                                    "serving the temporary one";
+                return;
+            }
+            FILE *pFile = fopen(filepath.c_str(), "wt");
+            if (pFile != nullptr)
+            {
+                PEM_write_PrivateKey(pFile, pkey, NULL, NULL, 0, 0, NULL);
+                PEM_write_X509(pFile, x509);
+                fclose(pFile);
+            }
+            else
+            {
+                BMCWEB_LOG_ERROR << "Couldn't write " << filepath;
+            }
+            serverCertificate().set(pkey, x509);
+            BMCWEB_LOG_INFO << "Serving newly generated certificate";
+        });
+    }
+
+    /**
+     * @brief Waits for a generation in progress to finish
+     */
+    void stop()
+    {
+        if (thread.joinable())
+        {
+            thread.join();
+        }
+    }
+
+  private:
+    std::thread thread;
+};
+
+inline CertificateGenerator &certificateGenerator()
+{
+    static CertificateGenerator generator;
+    return generator;
+}
+
+/**
+ * @brief Serves a throwaway P-256 certificate from ctx, and generates the
+ *        real one for filepath in the background
+ *
+ * @param[in] ctx       Context to serve from
+ * @param[in] filepath  Where the generated certificate is saved
+ *
+ * @return false if not even a temporary certificate could be made
+ */
+inline bool useCertificateGeneratedInBackground(SSL_CTX *ctx,
+                                                const std::string &filepath)
+{
+    EVP_PKEY *pkey = nullptr;
+    X509 *x509 = nullptr;
+    if (!generateKeyAndCertificate(KeyType::ec, pkey, x509))
+    {
+        return false;
+    }
+    bool loaded = SSL_CTX_use_certificate(ctx, x509) == 1 &&
+                  SSL_CTX_use_PrivateKey(ctx, pkey) == 1;
+    // The context holds its own references
+    X509_free(x509);
+    EVP_PKEY_free(pkey);
+    if (!loaded)
+    {
+        handleOpensslError();
+        return false;
+    }
+
+    SSL_CTX_set_cert_cb(ctx, certificateCallback, nullptr);
+    certificateGenerator().start(filepath, generatedKeyType);
+    return true;
+}
+
+// How long a resumable TLS session lives, in the server's session cache or
+// in a ticket held by the client
+constexpr long tlsSessionTimeout = 3600;
+
+// Sessions the server's session cache holds, for clients without tickets
+constexpr long tlsSessionCacheSize = 256;
+
+/**
+ * @brief Keys session tickets are encrypted with
+ *
+ * New tickets are sealed with the current key, which is replaced once it is
+ * tlsSessionTimeout old.  The key before it still opens tickets, so a ticket
+ * stays usable for its whole lifetime; after that, clients fall back to a
+ * full handshake.  Keys only live in memory, so a restart drops them all.
+ */
+class TicketKeys
+{
+  public:
+    struct Key
+    {
+        std::array<unsigned char, 16> name;
+        std::array<unsigned char, 32> aesKey;
+        std::array<unsigned char, 32> hmacKey;
+        std::chrono::steady_clock::time_point created;
+    };
+
+    /**
+     * @brief Gets the key to seal a new ticket with
+     *
+     * @param[out] key  Receives the key
+     *
+     * @return false if there is no key to seal tickets with
+     */
+    bool current(Key &key)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto now = std::chrono::steady_clock::now();
+        if (!haveCurrent ||
+            now - keys[0].created >= std::chrono::seconds(tlsSessionTimeout))
+        {
+            rotate(now);
+        }
+        if (!haveCurrent)
+        {
+            return false;
+        }
+        key = keys[0];
+        return true;
+    }
+
+    /**
+     * @brief Finds the key a ticket was sealed with
+     *
+     * @param[in] name   Key name from the ticket
+     * @param[out] key   Receives the key
+     * @param[out] old   Set if the key was rotated out, so the client should
+     *                   get a new ticket
+     *
+     * @return false if no key has that name any more
+     */
+    bool find(const unsigned char *name, Key &key, bool &old)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < keyCount; i++)
+        {
+            if (std::memcmp(keys[i].name.data(), name, keys[i].name.size()) ==
+                0)
+            {
+                key = keys[i];
+                old = i != 0;
+                return true;
+            }
+        }
+        return false;
+    }
+
+  private:
+    void rotate(std::chrono::steady_clock::time_point now)
+    {
+        Key key;
+        if (RAND_bytes(key.name.data(), key.name.size()) != 1 ||
+            RAND_bytes(key.aesKey.data(), key.aesKey.size()) != 1 ||
+            RAND_bytes(key.hmacKey.data(), key.hmacKey.size()) != 1)
+        {
+            // Keep sealing with the old key rather than not at all
+            BMCWEB_LOG_ERROR << "Couldn't make a session ticket key";
+            return;
+        }
+        key.created = now;
+        keys[1] = keys[0];
+        keys[0] = key;
+        keyCount = haveCurrent ? 2 : 1;
+        haveCurrent = true;
+    }
+
+    std::mutex mutex;
+    std::array<Key, 2> keys;
+    size_t keyCount = 0;
+    bool haveCurrent = false;
+};
+
+inline TicketKeys &ticketKeys()
+{
+    static TicketKeys keys;
+    return keys;
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+using TicketMacCtx = EVP_MAC_CTX;
+
+inline bool initTicketMac(TicketMacCtx *macCtx, TicketKeys::Key &key)
+{
+    char digest[] = "SHA256";
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY,
+                                          key.hmacKey.data(),
+                                          key.hmacKey.size()),
+        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest, 0),
+        OSSL_PARAM_construct_end()};
+    return EVP_MAC_CTX_set_params(macCtx, params) == 1;
+}
+#else
+using TicketMacCtx = HMAC_CTX;
+
+inline bool initTicketMac(TicketMacCtx *macCtx, TicketKeys::Key &key)
+{
+    return HMAC_Init_ex(macCtx, key.hmacKey.data(),
+                        static_cast<int>(key.hmacKey.size()), EVP_sha256(),
+                        nullptr) == 1;
+}
+#endif
+
+/**
+ * @brief Seals and opens session tickets with ticketKeys(), as OpenSSL's
+ *        session ticket key callback
+ *
+ * @return 1 if the ticket was sealed or opened, 2 if it was opened with a
+ *         rotated out key, 0 to do without a ticket, -1 on error
+ */
+inline int ticketKeyCallback(SSL * /*ssl*/, unsigned char *keyName,
+                             unsigned char *iv, EVP_CIPHER_CTX *cipherCtx,
+                             TicketMacCtx *macCtx, int encrypt)
+{
+    TicketKeys::Key key;
+    if (encrypt == 1)
+    {
+        if (!ticketKeys().current(key))
+        {
+            return 0;
+        }
+        std::memcpy(keyName, key.name.data(), key.name.size());
+        if (RAND_bytes(iv, EVP_CIPHER_iv_length(EVP_aes_256_cbc())) != 1 ||
+            EVP_EncryptInit_ex(cipherCtx, EVP_aes_256_cbc(), nullptr,
+                               key.aesKey.data(), iv) != 1 ||
+            !initTicketMac(macCtx, key))
+        {
+            return -1;
+        }
+        return 1;
+    }
+
+    bool old = false;
+    if (!ticketKeys().find(keyName, key, old))
+    {
+        return 0;
+    }
+    if (EVP_DecryptInit_ex(cipherCtx, EVP_aes_256_cbc(), nullptr,
+                           key.aesKey.data(), iv) != 1 ||
+        !initTicketMac(macCtx, key))
+    {
+        return -1;
+    }
+    return old ? 2 : 1;
+}
+
+/**
+ * @brief Lets clients resume their TLS sessions, from the server's session
+ *        cache or from a session ticket, instead of doing a full handshake
+ *        on every connection
+ *
+ * @param[in] ctx  Context to set up
+ */
+inline void setupSessionResumption(SSL_CTX *ctx)
+{
+    static constexpr unsigned char sessionIdContext[] = "bmcweb";
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+    SSL_CTX_sess_set_cache_size(ctx, tlsSessionCacheSize);
+    SSL_CTX_set_timeout(ctx, tlsSessionTimeout);
+    if (SSL_CTX_set_session_id_context(ctx, sessionIdContext,
+                                       sizeof(sessionIdContext) - 1) != 1)
+    {
+        BMCWEB_LOG_ERROR << "Error setting session id context\n";
+    }
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    if (SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx, ticketKeyCallback) != 1)
+#else
+    if (SSL_CTX_set_tlsext_ticket_key_cb(ctx, ticketKeyCallback) != 1)
+#endif
+    {
+        BMCWEB_LOG_ERROR << "Error setting session ticket keys\n";
+    }
+}
+
+#ifdef BMCWEB_ENABLE_HTTP2
+// The protocols offered over ALPN, preferred first, in its wire format
+constexpr unsigned char alpnProtocols[] = "\x02h2\x08http/1.1";
+
+// Picks h2 if the client offers it.  A client offering nothing the server
+// speaks goes on without ALPN, and gets HTTP/1.
+inline int alpnSelectCallback(SSL * /*ssl*/, const unsigned char **out,
+                              unsigned char *outlen, const unsigned char *in,
+                              unsigned int inlen, void * /*arg*/)
+{
+    unsigned char *selected = nullptr;
+    if (SSL_select_next_proto(&selected, outlen, alpnProtocols,
+                              sizeof(alpnProtocols) - 1, in,
+                              inlen) != OPENSSL_NPN_NEGOTIATED)
+    {
+        return SSL_TLSEXT_ERR_NOACK;
+    }
+    *out = selected;
+    return SSL_TLSEXT_ERR_OK;
+}
+#endif
+
 inline boost::asio::ssl::context getSslContext(const std::string &ssl_pem_file)
 {
     boost::asio::ssl::context mSslContext{boost::asio::ssl::context::sslv23};
@@ -291,10 +763,23 @@ inline boost::asio::ssl::context getSslContext(const std::string &ssl_pem_file)
                             boost::asio::ssl::context::no_tlsv1_1);
 
     // m_ssl_context.set_verify_mode(boost::asio::ssl::verify_peer);
-    mSslContext.use_certificate_file(ssl_pem_file,
-                                     boost::asio::ssl::context::pem);
-    mSslContext.use_private_key_file(ssl_pem_file,
-                                     boost::asio::ssl::context::pem);
+    if (verifyOpensslKeyCert(ssl_pem_file))
+    {
+        mSslContext.use_certificate_file(ssl_pem_file,
+                                         boost::asio::ssl::context::pem);
+        mSslContext.use_private_key_file(ssl_pem_file,
+                                         boost::asio::ssl::context::pem);
+    }
+    else
+    {
+        BMCWEB_LOG_INFO << "No valid certificate in " << ssl_pem_file
+                        << ", generating one in the background";
+        if (!useCertificateGeneratedInBackground(mSslContext.native_handle(),
+                                                 ssl_pem_file))
+        {
+            BMCWEB_LOG_ERROR << "Couldn't make a temporary certificate\n";
+        }
+    }
 
     // Set up EC curves to auto (boost asio doesn't have a method for this)
     // There is a pull request to add this.  Once this is included in an asio
@@ -357,6 +842,12 @@ inline boost::asio::ssl::context getSslContext(const std::string &ssl_pem_file)
     {
         BMCWEB_LOG_ERROR << "Error setting cipher list\n";
     }
+
+    setupSessionResumption(mSslContext.native_handle());
+#ifdef BMCWEB_ENABLE_HTTP2
+    SSL_CTX_set_alpn_select_cb(mSslContext.native_handle(), alpnSelectCallback,
+                               nullptr);
+#endif
     return mSslContext;
 }
 } // namespace ensuressl
@@ -0,0 +1,93 @@
+#pragma once
+#include <crow/logging.h>
+#include <time.h>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace crow
+{
+
+/**
+ * @brief Logs how long each phase of startup takes, and how long after
+ *        boot the server starts accepting connections
+ *
+ * main() marks the end of each phase with phase(), and ready() once the
+ * event loop runs.  The boot time is CLOCK_BOOTTIME, so it counts from the
+ * kernel starting, not from bmcweb:
+ *
+ *   Startup: redfish took 12 ms
+ *   Ready to accept 41 ms after start, 8713 ms after boot
+ */
+class StartupTimer
+{
+  public:
+    using clock = std::chrono::steady_clock;
+
+    StartupTimer() : started(clock::now()), last(started)
+    {
+    }
+
+    // Ends the phase that began with the last one, or at construction
+    void phase(const char* name)
+    {
+        clock::time_point now = clock::now();
+        uint64_t ms = toMs(now - last);
+        last = now;
+        phases.emplace_back(name, ms);
+        BMCWEB_LOG_INFO << "Startup: " << name << " took " << ms << " ms";
+    }
+
+    void ready()
+    {
+        BMCWEB_LOG_INFO << "Ready to accept " << sinceStart()
+                        << " ms after start, " << sinceBoot()
+                        << " ms after boot";
+    }
+
+    uint64_t sinceStart() const
+    {
+        return toMs(clock::now() - started);
+    }
+
+    // 0 if the clock can't be read
+    static uint64_t sinceBoot()
+    {
+        timespec now{};
+        if (clock_gettime(CLOCK_BOOTTIME, &now) != 0)
+        {
+            return 0;
+        }
+        return static_cast<uint64_t>(now.tv_sec) * 1000 +
+               static_cast<uint64_t>(now.tv_nsec) / 1000000;
+    }
+
+    // Name and milliseconds of each phase, in order
+    const std::vector<std::pair<std::string, uint64_t>>& phaseTimes() const
+    {
+        return phases;
+    }
+
+  private:
+    static uint64_t toMs(clock::duration duration)
+    {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(duration)
+                .count());
+    }
+
+    clock::time_point started;
+    clock::time_point last;
+    std::vector<std::pair<std::string, uint64_t>> phases;
+};
+
+inline StartupTimer& startupTimer()
+{
+    static StartupTimer timer;
+    return timer;
+}
+
+} // namespace crow
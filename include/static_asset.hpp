@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+namespace crow
+{
+namespace webassets
+{
+
+// A file of the web root, as scripts/generate_webassets_manifest.py described
+// it at build time
+struct StaticAsset
+{
+    // The URL it is served at
+    const char* url;
+    // Where it is, relative to the web root
+    const char* file;
+    const char* contentType;
+    const char* contentEncoding;
+    uint64_t size;
+    // Quoted strong entity tag, the SHA1 of the file
+    const char* etag;
+    // The filename carries a content hash, so it can be cached forever
+    bool immutable;
+};
+
+} // namespace webassets
+} // namespace crow
@@ -5,10 +5,14 @@
 #include <crow/http_request.h>
 #include <crow/http_response.h>
 
+#include <algorithm>
+#include <array>
+#include <basic_auth_cache.hpp>
 #include <boost/container/flat_set.hpp>
 #include <pam_authenticate.hpp>
 #include <persistent_data_middleware.hpp>
 #include <random>
+#include <vector>
 #include <webassets.hpp>
 
 namespace crow
@@ -17,6 +21,192 @@ namespace crow
 namespace token_authorization
 {
 
+/**
+ * @brief Set of strings, built once, with constant time lookups
+ *
+ * Hash and displace: keys are split into buckets by one hash, and each
+ * bucket gets the seed of a second hash that puts its keys into slots no
+ * other key uses.  A lookup is two hashes and one string compare.
+ */
+class PerfectHashSet
+{
+  public:
+    void build(std::vector<std::string> keys)
+    {
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+        seeds.clear();
+        slots.clear();
+        used.clear();
+        if (keys.empty())
+        {
+            return;
+        }
+
+        // Spare slots make displacing the last, crowded buckets quick.  Keep
+        // growing until every bucket fits.
+        size_t slotCount = keys.size() + keys.size() / 4 + 1;
+        while (!place(keys, slotCount))
+        {
+            slotCount *= 2;
+        }
+    }
+
+    bool contains(boost::string_view key) const
+    {
+        if (slots.empty())
+        {
+            return false;
+        }
+        uint32_t seed = seeds[hash(key, 0) % seeds.size()];
+        size_t slot = hash(key, seed) % slots.size();
+        // An empty key would match any slot left empty
+        return used[slot] && slots[slot] == key;
+    }
+
+  private:
+    static uint64_t hash(boost::string_view key, uint32_t seed)
+    {
+        // FNV-1a, started from the seed, with a final mix so the low bits
+        // used by % depend on every byte
+        uint64_t h = 14695981039346656037ULL ^ (seed * 0x9E3779B97F4A7C15ULL);
+        for (char c : key)
+        {
+            h ^= static_cast<unsigned char>(c);
+            h *= 1099511628211ULL;
+        }
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    bool place(const std::vector<std::string>& keys, size_t slotCount)
+    {
+        constexpr uint32_t maxSeed = 1U << 16;
+
+        std::vector<std::vector<size_t>> buckets(keys.size());
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            buckets[hash(keys[i], 0) % buckets.size()].push_back(i);
+        }
+        std::vector<size_t> order(buckets.size());
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            order[i] = i;
+        }
+        // Biggest buckets first, while most slots are free
+        std::sort(order.begin(), order.end(), [&buckets](size_t a, size_t b) {
+            return buckets[a].size() > buckets[b].size();
+        });
+
+        seeds.assign(buckets.size(), 0);
+        slots.assign(slotCount, std::string());
+        used.assign(slotCount, false);
+        std::vector<size_t> positions;
+        for (size_t b : order)
+        {
+            const std::vector<size_t>& bucket = buckets[b];
+            if (bucket.empty())
+            {
+                break;
+            }
+            uint32_t seed = 1;
+            for (; seed < maxSeed; seed++)
+            {
+                positions.clear();
+                bool fits = true;
+                for (size_t i : bucket)
+                {
+                    size_t position = hash(keys[i], seed) % slotCount;
+                    if (used[position] ||
+                        std::find(positions.begin(), positions.end(),
+                                  position) != positions.end())
+                    {
+                        fits = false;
+                        break;
+                    }
+                    positions.push_back(position);
+                }
+                if (fits)
+                {
+                    break;
+                }
+            }
+            if (seed == maxSeed)
+            {
+                return false;
+            }
+            seeds[b] = seed;
+            for (size_t i = 0; i < bucket.size(); i++)
+            {
+                used[positions[i]] = true;
+                slots[positions[i]] = keys[bucket[i]];
+            }
+        }
+        return true;
+    }
+
+    std::vector<uint32_t> seeds;
+    std::vector<std::string> slots;
+    std::vector<bool> used;
+};
+
+/**
+ * @brief URLs that can be requested without authenticating
+ */
+class Whitelist
+{
+  public:
+    Whitelist()
+    {
+        build({});
+    }
+
+    /**
+     * @brief Rebuilds the GET set from the fixed entries plus the static
+     *        files, which have to have been registered already
+     */
+    void build(const boost::container::flat_set<std::string>& staticRoutes)
+    {
+        // it's allowed to GET root node without authentication
+        std::vector<std::string> getUrls{
+            "/redfish/v1", "/redfish/v1/",      "/redfish",
+            "/redfish/",   "/redfish/v1/odata", "/redfish/v1/odata/"};
+        getUrls.insert(getUrls.end(), staticRoutes.begin(),
+                       staticRoutes.end());
+        getSet.build(std::move(getUrls));
+
+        // it's allowed to POST on session collection & login without
+        // authentication
+        postSet.build({"/redfish/v1/SessionService/Sessions",
+                       "/redfish/v1/SessionService/Sessions/", "/login"});
+    }
+
+    bool contains(boost::beast::http::verb method, boost::string_view url) const
+    {
+        if (method == boost::beast::http::verb::get)
+        {
+            return getSet.contains(url);
+        }
+        if (method == boost::beast::http::verb::post)
+        {
+            return postSet.contains(url);
+        }
+        return false;
+    }
+
+  private:
+    PerfectHashSet getSet;
+    PerfectHashSet postSet;
+};
+
+inline Whitelist& whitelist()
+{
+    static Whitelist list;
+    return list;
+}
+
 class Middleware
 {
   public:
@@ -39,7 +229,8 @@ class Middleware
         }
         if (ctx.session == nullptr)
         {
-            boost::string_view authHeader = req.getHeaderValue("Authorization");
+            boost::string_view authHeader =
+                req.getHeaderValue(KnownHeader::authorization);
             if (!authHeader.empty())
             {
                 // Reject any kind of auth other than basic or token
@@ -49,34 +240,26 @@ class Middleware
                 }
                 else if (boost::starts_with(authHeader, "Basic "))
                 {
-                    ctx.session = performBasicAuth(authHeader);
+                    ctx.session = performBasicAuth(req, res, ctx, authHeader);
+                    if (res.isDeferred())
+                    {
+                        return;
+                    }
                 }
             }
         }
+        // Over the Unix socket, a client that brings no credentials is the
+        // user its process runs as, if that is a user of the user manager
+        if (ctx.session == nullptr && !req.localUser.empty() &&
+            req.getHeaderValue(KnownHeader::authorization).empty() &&
+            req.getHeaderValue(KnownHeader::xAuthToken).empty())
+        {
+            ctx.session = performLocalUserAuth(req);
+        }
 
         if (ctx.session == nullptr)
         {
-            BMCWEB_LOG_WARNING << "[AuthMiddleware] authorization failed";
-
-            // If it's a browser connecting, don't send the HTTP authenticate
-            // header, to avoid possible CSRF attacks with basic auth
-            if (http_helpers::requestPrefersHtml(req))
-            {
-                res.result(boost::beast::http::status::temporary_redirect);
-                res.addHeader("Location", "/#/login");
-            }
-            else
-            {
-                res.result(boost::beast::http::status::unauthorized);
-                // only send the WWW-authenticate header if this isn't a xhr
-                // from the browser.  most scripts,
-                if (req.getHeaderValue("User-Agent").empty())
-                {
-                    res.addHeader("WWW-Authenticate", "Basic");
-                }
-            }
-
-            res.end();
+            rejectRequest(req, res);
             return;
         }
 
@@ -101,47 +284,172 @@ class Middleware
         }
     }
 
+    // Finds the value of the SESSION cookie in one pass over the
+    // "name=value; name=value" pairs of a Cookie header
+    static boost::string_view findSessionCookie(boost::string_view cookies)
+    {
+        constexpr boost::string_view sessionName = "SESSION";
+        while (!cookies.empty())
+        {
+            size_t end = cookies.find(';');
+            boost::string_view pair = cookies.substr(0, end);
+            cookies = end == boost::string_view::npos
+                          ? boost::string_view()
+                          : cookies.substr(end + 1);
+            while (!pair.empty() && pair.front() == ' ')
+            {
+                pair.remove_prefix(1);
+            }
+            if (pair.size() > sessionName.size() &&
+                pair[sessionName.size()] == '=' &&
+                pair.starts_with(sessionName))
+            {
+                return pair.substr(sessionName.size() + 1);
+            }
+        }
+        return boost::string_view();
+    }
+
   private:
+    static void rejectRequest(const crow::Request& req, Response& res)
+    {
+        BMCWEB_LOG_WARNING << "[AuthMiddleware] authorization failed";
+
+        // If it's a browser connecting, don't send the HTTP authenticate
+        // header, to avoid possible CSRF attacks with basic auth
+        if (http_helpers::requestPrefersHtml(req))
+        {
+            res.result(boost::beast::http::status::temporary_redirect);
+            res.addHeader("Location", "/#/login");
+        }
+        else
+        {
+            res.result(boost::beast::http::status::unauthorized);
+            // only send the WWW-authenticate header if this isn't a xhr
+            // from the browser.  most scripts,
+            if (req.getHeaderValue(KnownHeader::userAgent).empty())
+            {
+                res.addHeader("WWW-Authenticate", "Basic");
+            }
+        }
+
+        res.end();
+    }
+
+    // Answers from the cache when it can.  Otherwise the credentials go to
+    // pam on a worker thread and the request is deferred until the verdict
+    // is in, so a slow pam module doesn't hold up other connections.
     const std::shared_ptr<crow::persistent_data::UserSession>
-        performBasicAuth(boost::string_view auth_header) const
+        performBasicAuth(crow::Request& req, Response& res, Context& ctx,
+                         boost::string_view auth_header) const
     {
         BMCWEB_LOG_DEBUG << "[AuthMiddleware] Basic authentication";
 
-        std::string authData;
         boost::string_view param = auth_header.substr(strlen("Basic "));
-        if (!crow::utility::base64Decode(param, authData))
+        BasicAuthCache::Stamp stamp;
+        std::shared_ptr<crow::persistent_data::UserSession> session =
+            basicAuthCache().find(param, stamp);
+        if (session != nullptr)
+        {
+            BMCWEB_LOG_DEBUG << "[AuthMiddleware] Cached user: "
+                             << session->username;
+            return session;
+        }
+
+        // Credentials of any sensible length decode without allocating
+        std::array<char, 192> stackBuffer;
+        std::string heapBuffer;
+        char* decoded = stackBuffer.data();
+        if (crow::utility::base64DecodedSizeMax(param.size()) >
+            stackBuffer.size())
+        {
+            heapBuffer.resize(
+                crow::utility::base64DecodedSizeMax(param.size()));
+            decoded = &heapBuffer[0];
+        }
+        std::size_t decodedSize = 0;
+        if (!crow::utility::base64Decode(param, decoded, decodedSize))
         {
             return nullptr;
         }
+        boost::string_view authData(decoded, decodedSize);
         std::size_t separator = authData.find(':');
-        if (separator == std::string::npos)
+        if (separator == boost::string_view::npos)
         {
             return nullptr;
         }
 
-        std::string user = authData.substr(0, separator);
+        std::string user(authData.substr(0, separator));
         separator += 1;
         if (separator > authData.size())
         {
             return nullptr;
         }
-        std::string pass = authData.substr(separator);
+        std::string pass(authData.substr(separator));
 
         BMCWEB_LOG_DEBUG << "[AuthMiddleware] Authenticating user: " << user;
 
-        if (!pamAuthenticateUser(user, pass))
+        // The connection keeps req, res and ctx alive until the response is
+        // sent, which can't happen before resume()
+        res.defer();
+        pamAuthenticateUserAsync(
+            *req.ioService, user, std::move(pass),
+            [&req, &res, &ctx, user, credentials{std::string(param)},
+             stamp](bool authenticated) {
+                if (!authenticated)
+                {
+                    rejectRequest(req, res);
+                    res.resume();
+                    return;
+                }
+                // Clients sending the same credentials again within the
+                // cache's lifetime reuse this session instead of going
+                // through pam again
+                ctx.session = makeHeldSession(user);
+                basicAuthCache().insert(credentials, ctx.session, stamp);
+                res.resume();
+            });
+        return nullptr;
+    }
+
+    // A session for a user authenticated some other way than by a session
+    // token, for the authenticator to keep; see PersistenceType::HELD
+    static std::shared_ptr<crow::persistent_data::UserSession>
+        makeHeldSession(const std::string& username)
+    {
+        auto session = std::make_shared<crow::persistent_data::UserSession>();
+        session->username = username;
+        session->lastUpdated = std::chrono::steady_clock::now();
+        session->persistence = crow::persistent_data::PersistenceType::HELD;
+        return session;
+    }
+
+    // The session is made on the connection's first request and kept for
+    // the rest of them.  It isn't in the SessionStore: it has no token, and
+    // goes away with the connection.
+    const std::shared_ptr<crow::persistent_data::UserSession>
+        performLocalUserAuth(const crow::Request& req) const
+    {
+        BMCWEB_LOG_DEBUG << "[AuthMiddleware] Local user " << req.localUser;
+
+        if (!redfish::userPrivilegeStore().knows(req.localUser))
         {
+            BMCWEB_LOG_WARNING << "[AuthMiddleware] Local user "
+                               << req.localUser << " isn't a known user";
             return nullptr;
         }
-
-        // TODO(ed) generateUserSession is a little expensive for basic
-        // auth, as it generates some random identifiers that will never be
-        // used.  This should have a "fast" path for when user tokens aren't
-        // needed.
-        // This whole flow needs to be revisited anyway, as we can't be
-        // calling directly into pam for every request
-        return persistent_data::SessionStore::getInstance().generateUserSession(
-            user, crow::persistent_data::PersistenceType::SINGLE_REQUEST);
+        if (req.localSession != nullptr && *req.localSession != nullptr)
+        {
+            return std::static_pointer_cast<
+                crow::persistent_data::UserSession>(*req.localSession);
+        }
+        std::shared_ptr<crow::persistent_data::UserSession> session =
+            makeHeldSession(req.localUser);
+        if (req.localSession != nullptr)
+        {
+            *req.localSession = session;
+        }
+        return session;
     }
 
     const std::shared_ptr<crow::persistent_data::UserSession>
@@ -161,7 +469,7 @@ class Middleware
     {
         BMCWEB_LOG_DEBUG << "[AuthMiddleware] X-Auth-Token authentication";
 
-        boost::string_view token = req.getHeaderValue("X-Auth-Token");
+        boost::string_view token = req.getHeaderValue(KnownHeader::xAuthToken);
         if (token.empty())
         {
             return nullptr;
@@ -177,25 +485,18 @@ class Middleware
     {
         BMCWEB_LOG_DEBUG << "[AuthMiddleware] Cookie authentication";
 
-        boost::string_view cookieValue = req.getHeaderValue("Cookie");
+        boost::string_view cookieValue =
+            req.getHeaderValue(KnownHeader::cookie);
         if (cookieValue.empty())
         {
             return nullptr;
         }
 
-        auto startIndex = cookieValue.find("SESSION=");
-        if (startIndex == std::string::npos)
+        boost::string_view authKey = findSessionCookie(cookieValue);
+        if (authKey.empty())
         {
             return nullptr;
         }
-        startIndex += sizeof("SESSION=") - 1;
-        auto endIndex = cookieValue.find(";", startIndex);
-        if (endIndex == std::string::npos)
-        {
-            endIndex = cookieValue.size();
-        }
-        boost::string_view authKey =
-            cookieValue.substr(startIndex, endIndex - startIndex);
 
         const std::shared_ptr<crow::persistent_data::UserSession> session =
             persistent_data::SessionStore::getInstance().loginSessionByToken(
@@ -208,7 +509,8 @@ class Middleware
         // RFC7231 defines methods that need csrf protection
         if (req.method() != "GET"_method)
         {
-            boost::string_view csrf = req.getHeaderValue("X-XSRF-TOKEN");
+            boost::string_view csrf =
+                req.getHeaderValue(KnownHeader::xXsrfToken);
             // Make sure both tokens are filled
             if (csrf.empty() || session->csrfToken.empty())
             {
@@ -227,36 +529,7 @@ class Middleware
     // checks if request can be forwarded without authentication
     bool isOnWhitelist(const crow::Request& req) const
     {
-        // it's allowed to GET root node without authentica tion
-        if ("GET"_method == req.method())
-        {
-            if (req.url == "/redfish/v1" || req.url == "/redfish/v1/" ||
-                req.url == "/redfish" || req.url == "/redfish/" ||
-                req.url == "/redfish/v1/odata" ||
-                req.url == "/redfish/v1/odata/")
-            {
-                return true;
-            }
-            else if (crow::webassets::routes.find(std::string(req.url)) !=
-                     crow::webassets::routes.end())
-            {
-                return true;
-            }
-        }
-
-        // it's allowed to POST on session collection & login without
-        // authentication
-        if ("POST"_method == req.method())
-        {
-            if ((req.url == "/redfish/v1/SessionService/Sessions") ||
-                (req.url == "/redfish/v1/SessionService/Sessions/") ||
-                (req.url == "/login"))
-            {
-                return true;
-            }
-        }
-
-        return false;
+        return whitelist().contains(req.method(), req.url);
     }
 };
 
@@ -273,7 +546,8 @@ template <typename... Middlewares> void requestRoutes(Crow<Middlewares...>& app)
     BMCWEB_ROUTE(app, "/login")
         .methods(
             "POST"_method)([&](const crow::Request& req, crow::Response& res) {
-            boost::string_view contentType = req.getHeaderValue("content-type");
+            boost::string_view contentType =
+                req.getHeaderValue(KnownHeader::contentType);
             boost::string_view username;
             boost::string_view password;
 
@@ -377,16 +651,25 @@ template <typename... Middlewares> void requestRoutes(Crow<Middlewares...>& app)
                 password = req.getHeaderValue("password");
             }
 
-            if (!username.empty() && !password.empty())
+            if (username.empty() || password.empty())
             {
-                if (!pamAuthenticateUser(username, password))
-                {
-                    res.result(boost::beast::http::status::unauthorized);
-                }
-                else
-                {
+                res.result(boost::beast::http::status::bad_request);
+                res.end();
+                return;
+            }
+
+            std::string user(username);
+            pamAuthenticateUserAsync(
+                *req.ioService, user, std::string(password),
+                [&res, user, looksLikeIbm](bool authenticated) {
+                    if (!authenticated)
+                    {
+                        res.result(boost::beast::http::status::unauthorized);
+                        res.end();
+                        return;
+                    }
                     auto session = persistent_data::SessionStore::getInstance()
-                                       .generateUserSession(username);
+                                       .generateUserSession(user);
 
                     if (looksLikeIbm)
                     {
@@ -394,8 +677,7 @@ template <typename... Middlewares> void requestRoutes(Crow<Middlewares...>& app)
                         // doesn't actually look at the status code.
                         // TODO(ed).... Fix that upstream
                         res.jsonValue = {
-                            {"data",
-                             "User '" + std::string(username) + "' logged in"},
+                            {"data", "User '" + user + "' logged in"},
                             {"message", "200 OK"},
                             {"status", "ok"}};
 
@@ -420,13 +702,8 @@ template <typename... Middlewares> void requestRoutes(Crow<Middlewares...>& app)
                         // if content type is json, assume json token
                         res.jsonValue = {{"token", session->sessionToken}};
                     }
-                }
-            }
-            else
-            {
-                res.result(boost::beast::http::status::bad_request);
-            }
-            res.end();
+                    res.end();
+                });
         });
 
     BMCWEB_ROUTE(app, "/logout")
@@ -3,6 +3,11 @@
 #include <ast_jpeg_decoder.hpp>
 #include <ast_video_puller.hpp>
 #include <boost/endian/arithmetic.hpp>
+#include <map>
+#include <kvm_dirty_tiles.hpp>
+#include <kvm_frame_buffers.hpp>
+#include <kvm_passthrough.hpp>
+#include <kvm_rate_control.hpp>
 #include <string>
 
 namespace crow
@@ -197,6 +202,8 @@ class ConnectionMetadata
     ConnectionMetadata(){};
 
     VncState vncState{VncState::UNSTARTED};
+    // What the client was last sent
+    DirtyTileTracker tiles;
 };
 
 using meta_list = std::vector<ConnectionMetadata>;
@@ -204,10 +211,122 @@ meta_list connectionStates(10);
 
 ConnectionMetadata meta;
 
+/* The viewers of /kvmws/passthrough, who share one capture.  A viewer that
+ * asked for a frame gets the next one captured once its RateController lets
+ * it, framed once for all of them.  The capture uses the quality the
+ * slowest viewer can take.  Only touched from the io_service the route
+ * handlers run on.
+ */
+class PassthroughViewers
+{
+  public:
+    void add(crow::websocket::Connection& conn)
+    {
+        if (puller == nullptr)
+        {
+            try
+            {
+                puller = std::make_shared<ast_video::AsyncVideoPuller>(
+                    conn.getIoService());
+            }
+            catch (const boost::system::system_error& e)
+            {
+                BMCWEB_LOG_ERROR << "Failed to open /dev/video: " << e.what();
+                conn.close("No video");
+                return;
+            }
+        }
+        viewers.emplace(&conn, Viewer());
+        if (subscription == 0)
+        {
+            subscription = puller->subscribe(
+                [this](const std::shared_ptr<const ast_video::RawVideoBuffer>&
+                           video) { send(video); });
+        }
+    }
+
+    void remove(crow::websocket::Connection& conn)
+    {
+        viewers.erase(&conn);
+        if (viewers.empty() && subscription != 0)
+        {
+            // Capture stops until the next viewer
+            puller->unsubscribe(subscription);
+            subscription = 0;
+        }
+    }
+
+    void request(crow::websocket::Connection& conn)
+    {
+        auto it = viewers.find(&conn);
+        if (it != viewers.end())
+        {
+            it->second.waiting = true;
+            it->second.rate.requested(RateController::clock::now(),
+                                      conn.bufferedAmount());
+        }
+    }
+
+    // Closes the video device; has to happen before the io_service goes
+    void stop()
+    {
+        viewers.clear();
+        subscription = 0;
+        puller.reset();
+    }
+
+  private:
+    struct Viewer
+    {
+        // Asked for a frame it hasn't got yet
+        bool waiting = false;
+        RateController rate;
+    };
+
+    void send(const std::shared_ptr<const ast_video::RawVideoBuffer>& video)
+    {
+        RateController::clock::time_point now = RateController::clock::now();
+        std::shared_ptr<const PassthroughFrame> frame;
+        int quality = RateController::maxQuality();
+        for (auto& viewer : viewers)
+        {
+            Viewer& v = viewer.second;
+            quality = std::min(quality, v.rate.targetQuality());
+            if (!v.waiting ||
+                !v.rate.ready(now, viewer.first->bufferedAmount()))
+            {
+                continue;
+            }
+            if (frame == nullptr)
+            {
+                frame = encodePassthroughFrame(video);
+            }
+            viewer.first->sendBinary(frame->buffers, frame);
+            v.waiting = false;
+            v.rate.sent(now);
+        }
+        puller->setQuality(quality);
+    }
+
+    std::shared_ptr<ast_video::AsyncVideoPuller> puller;
+    size_t subscription = 0;
+    std::map<crow::websocket::Connection*, Viewer> viewers;
+};
+
+inline PassthroughViewers& passthroughViewers()
+{
+    static PassthroughViewers viewers;
+    return viewers;
+}
+
 template <typename... Middlewares> void requestRoutes(Crow<Middlewares...>& app)
 {
     BMCWEB_ROUTE(app, "/kvmws")
         .websocket()
+        // Dropping part of the RFB stream would desync the client, and an
+        // uncompressed frame is several megabytes
+        .outboundQueue(16 * 1024 * 1024,
+                       crow::websocket::OverflowPolicy::disconnect)
         .onopen([&](crow::websocket::Connection& conn) {
             if (meta.vncState == VncState::UNSTARTED)
             {
@@ -222,6 +341,7 @@ template <typename... Middlewares> void requestRoutes(Crow<Middlewares...>& app)
         .onclose(
             [&](crow::websocket::Connection& conn, const std::string& reason) {
                 meta.vncState = VncState::UNSTARTED;
+                meta.tiles.reset();
             })
         .onmessage([&](crow::websocket::Connection& conn,
                        const std::string& data, bool is_binary) {
@@ -342,49 +462,28 @@ template <typename... Middlewares> void requestRoutes(Crow<Middlewares...>& app)
                                     p.initialize();
                                     auto out = p.readVideo();
                                     ast_video::AstJpegDecoder d;
+                                    if (ast_video::BandWorkerPool::
+                                            threadCount() > 1)
+                                    {
+                                        d.setBands(ast_video::BandWorkerPool::
+                                                       threadCount());
+                                    }
                                     d.decode(out.buffer, out.width, out.height,
                                              out.mode, out.ySelector,
                                              out.uvSelector);
 
-                                    FramebufferUpdateMsg bufferUpdateMsg;
-
-                                    // If the viewer is requesting a full
-                                    // update, force write of all pixels
-
-                                    FramebufferRectangle thisRect;
-                                    thisRect.x = msg->xPosition;
-                                    thisRect.y = msg->yPosition;
-                                    thisRect.width = out.width;
-                                    thisRect.height = out.height;
-                                    thisRect.encoding = static_cast<uint8_t>(
-                                        encoding_type::raw);
-                                    std::cout << "Encoding is "
-                                              << thisRect.encoding;
-                                    thisRect.data.reserve(
-                                        static_cast<std::size_t>(
-                                            thisRect.width) *
-                                        static_cast<std::size_t>(
-                                            thisRect.height) *
-                                        4);
-                                    std::cout << "Width " << out.width
-                                              << " Height " << out.height;
-
-                                    for (int i = 0; i < out.width * out.height;
-                                         i++)
-                                    {
-                                        auto& pixel = d.outBuffer[i];
-                                        thisRect.data.push_back(pixel.b);
-                                        thisRect.data.push_back(pixel.g);
-                                        thisRect.data.push_back(pixel.r);
-                                        thisRect.data.push_back(0);
-                                    }
-
-                                    bufferUpdateMsg.rectangles.push_back(
-                                        std::move(thisRect));
-                                    auto serialized =
-                                        serialize(bufferUpdateMsg);
-
-                                    conn.sendBinary(serialized);
+                                    // Only the tiles that changed since the
+                                    // last update, unless the viewer asks
+                                    // for all of them
+                                    std::vector<DirtyRect> dirty =
+                                        meta.tiles.update(
+                                            d.outBuffer.data(), out.width,
+                                            out.height, msg->incremental != 0);
+                                    std::shared_ptr<const EncodedUpdate>
+                                        update = encodeRawUpdate(
+                                            d.outBuffer.data(), out.width,
+                                            dirty, frameBufferPool());
+                                    conn.sendBinary(update->buffers, update);
 
                                 } // TODO(Ed) handle error
                             }
@@ -417,6 +516,27 @@ template <typename... Middlewares> void requestRoutes(Crow<Middlewares...>& app)
                     break;
             }
         });
+
+    // The compressed frames as they come from the video engine, for viewers
+    // that decode them themselves; see PassthroughHeader.  The BMC only
+    // frames them, whatever is moving on the screen, and sends a tenth of
+    // the bytes or less of the raw pixels of /kvmws.
+    BMCWEB_ROUTE(app, "/kvmws/passthrough")
+        .websocket()
+        // A viewer asks for one frame at a time, so one or two are queued
+        .outboundQueue(16 * 1024 * 1024,
+                       crow::websocket::OverflowPolicy::disconnect)
+        .onopen([&](crow::websocket::Connection& conn) {
+            passthroughViewers().add(conn);
+        })
+        .onclose(
+            [&](crow::websocket::Connection& conn, const std::string& reason) {
+                passthroughViewers().remove(conn);
+            })
+        .onmessage([&](crow::websocket::Connection& conn,
+                       const std::string& data, bool is_binary) {
+            passthroughViewers().request(conn);
+        });
 }
 } // namespace kvm
 } // namespace crow
\ No newline at end of file
@@ -5,10 +5,13 @@
 #include <crow/http_response.h>
 #include <crow/routing.h>
 
-#include <boost/algorithm/string/replace.hpp>
+#include <bmcweb/webassets_manifest.hpp>
 #include <boost/container/flat_set.hpp>
-#include <experimental/filesystem>
-#include <fstream>
+#include <boost/utility/string_view.hpp>
+#include <algorithm>
+#include <array>
+#include <http_utility.hpp>
+#include <static_asset.hpp>
 #include <string>
 
 namespace crow
@@ -16,147 +19,119 @@ namespace crow
 namespace webassets
 {
 
-namespace filesystem = std::experimental::filesystem;
+// Where the files staticAssets describes are installed
+constexpr const char* webRoot = "/usr/share/www";
 
-struct CmpStr
+// The URLs of staticAssets, which authentication lets through
+static boost::container::flat_set<std::string> routes;
+
+// The asset served at url, or nullptr
+template <size_t N>
+const StaticAsset* findAsset(const std::array<StaticAsset, N>& assets,
+                             boost::string_view url)
 {
-    bool operator()(const char* a, const char* b) const
+    auto it = std::lower_bound(
+        assets.begin(), assets.end(), url,
+        [](const StaticAsset& asset, boost::string_view url) {
+            return boost::string_view(asset.url) < url;
+        });
+    if (it == assets.end() || boost::string_view(it->url) != url)
     {
-        return std::strcmp(a, b) < 0;
+        return nullptr;
     }
-};
+    return &*it;
+}
 
-static boost::container::flat_set<std::string> routes;
+using http_helpers::etagMatches;
 
-template <typename... Middlewares> void requestRoutes(Crow<Middlewares...>& app)
+inline void handleStaticFile(const StaticAsset& asset,
+                             const crow::Request& req, crow::Response& res)
 {
-    const static boost::container::flat_map<const char*, const char*, CmpStr>
-        contentTypes{
-            {{".css", "text/css;charset=UTF-8"},
-             {".html", "text/html;charset=UTF-8"},
-             {".js", "text/html;charset=UTF-8"},
-             {".png", "image/png;charset=UTF-8"},
-             {".woff", "application/x-font-woff"},
-             {".woff2", "application/x-font-woff2"},
-             {".gif", "image/gif"},
-             {".ico", "image/x-icon"},
-             {".ttf", "application/x-font-ttf"},
-             {".svg", "image/svg+xml"},
-             {".eot", "application/vnd.ms-fontobject"},
-             {".xml", "application/xml"},
-             {".json", "application/json"},
-             {".jpg", "image/jpeg"},
-             {".jpeg", "image/jpeg"},
-             {".json", "application/json"},
-             // dev tools don't care about map type, setting to json causes
-             // browser to show as text
-             // https://stackoverflow.com/questions/19911929/what-mime-type-should-i-use-for-javascript-source-map-files
-             {".map", "application/json"}}};
-    filesystem::path rootpath{"/usr/share/www/"};
-    filesystem::recursive_directory_iterator dirIter(rootpath);
-    // In certain cases, we might have both a gzipped version of the file AND a
-    // non-gzipped version.  To avoid duplicated routes, we need to make sure we
-    // get the gzipped version first.  Because the gzipped path should be longer
-    // than the non gzipped path, if we sort in Ascending order, we should be
-    // guaranteed to get the gzip version first.
-    std::vector<filesystem::directory_entry> paths(filesystem::begin(dirIter),
-                                                   filesystem::end(dirIter));
-    std::sort(paths.rbegin(), paths.rend());
-
-    for (const filesystem::directory_entry& dir : paths)
+    if (!res.openFileBody(std::string(webRoot) + asset.file))
     {
-        filesystem::path absolutePath = dir.path();
-        filesystem::path relativePath{
-            absolutePath.string().substr(rootpath.string().size() - 1)};
-        if (filesystem::is_directory(dir))
-        {
-            // don't recurse into hidden directories or symlinks
-            if (boost::starts_with(dir.path().filename().string(), ".") ||
-                filesystem::is_symlink(dir))
-            {
-                dirIter.disable_recursion_pending();
-            }
-        }
-        else if (filesystem::is_regular_file(dir))
-        {
-            std::string extension = relativePath.extension();
-            filesystem::path webpath = relativePath;
-            const char* contentEncoding = nullptr;
-
-            if (extension == ".gz")
-            {
-                webpath = webpath.replace_extension("");
-                // Use the non-gzip version for determining content type
-                extension = webpath.extension().string();
-                contentEncoding = "gzip";
-            }
-
-            if (boost::starts_with(webpath.filename().string(), "index."))
-            {
-                webpath = webpath.parent_path();
-                if (webpath.string().size() == 0 ||
-                    webpath.string().back() != '/')
-                {
-                    // insert the non-directory version of this path
-                    routes.insert(webpath);
-                    webpath += "/";
-                }
-            }
-
-            std::pair<boost::container::flat_set<std::string>::iterator, bool>
-                inserted = routes.insert(webpath);
+        BMCWEB_LOG_ERROR << "failed to open " << webRoot << asset.file;
+        res.result(boost::beast::http::status::not_found);
+        res.end();
+        return;
+    }
+    // The tag is only good for the file the build saw
+    if (res.getFileBody().size == asset.size)
+    {
+        res.addHeader("ETag", asset.etag);
+    }
+    else
+    {
+        BMCWEB_LOG_ERROR << webRoot << asset.file
+                         << " differs from the build's; not tagging it";
+    }
+    if (asset.immutable)
+    {
+        res.addHeader("Cache-Control", "public, max-age=31536000, immutable");
+    }
+    else
+    {
+        // Let the browser keep it, but revalidate with If-None-Match
+        res.addHeader("Cache-Control", "no-cache");
+    }
 
-            if (!inserted.second)
-            {
-                // Got a duplicated path.  This is expected in certain
-                // situations
-                BMCWEB_LOG_DEBUG << "Got duplicated path " << webpath;
-                continue;
-            }
-            const char* contentType = nullptr;
+    boost::string_view ifNoneMatch =
+        req.getHeaderValue(crow::KnownHeader::ifNoneMatch);
+    if (!ifNoneMatch.empty() && res.getFileBody().size == asset.size &&
+        etagMatches(ifNoneMatch, asset.etag))
+    {
+        res.closeFileBody();
+        res.result(boost::beast::http::status::not_modified);
+        res.end();
+        return;
+    }
 
-            auto contentTypeIt = contentTypes.find(extension.c_str());
-            if (contentTypeIt == contentTypes.end())
-            {
-                BMCWEB_LOG_ERROR << "Cannot determine content-type for "
-                                 << absolutePath << " with extension "
-                                 << extension;
-            }
-            else
-            {
-                contentType = contentTypeIt->second;
-            }
+    if (asset.contentType != nullptr)
+    {
+        res.addHeader("Content-Type", asset.contentType);
+    }
 
-            app.routeDynamic(webpath)(
-                [absolutePath, contentType, contentEncoding](
-                    const crow::Request& req, crow::Response& res) {
-                    if (contentType != nullptr)
-                    {
-                        res.addHeader("Content-Type", contentType);
-                    }
+    if (asset.contentEncoding != nullptr)
+    {
+        res.addHeader("Content-Encoding", asset.contentEncoding);
+    }
+    res.end();
+}
 
-                    if (contentEncoding != nullptr)
-                    {
-                        res.addHeader("Content-Encoding", contentEncoding);
-                    }
+inline void handleStaticRequest(const crow::Request& req, crow::Response& res)
+{
+    const StaticAsset* asset = findAsset(staticAssets, req.url);
+    if (asset == nullptr)
+    {
+        res.result(boost::beast::http::status::not_found);
+        res.end();
+        return;
+    }
+    handleStaticFile(*asset, req, res);
+}
+
+/**
+ * @brief Serves the files of the web root, from the manifest the build made
+ *
+ * One route takes every path, so it has to be registered after all the
+ * others: the router picks the rule registered first when several match.
+ */
+template <typename... Middlewares> void requestRoutes(Crow<Middlewares...>& app)
+{
+    for (const StaticAsset& asset : staticAssets)
+    {
+        routes.insert(asset.url);
+    }
 
-                    // res.set_header("Cache-Control", "public, max-age=86400");
-                    std::ifstream inf(absolutePath);
-                    if (!inf)
-                    {
-                        BMCWEB_LOG_DEBUG << "failed to read file";
-                        res.result(
-                            boost::beast::http::status::internal_server_error);
-                        res.end();
-                        return;
-                    }
+    BMCWEB_ROUTE(app, "/").methods("GET"_method)(
+        [](const crow::Request& req, crow::Response& res) {
+            handleStaticRequest(req, res);
+        });
+    BMCWEB_ROUTE(app, "/<path>")
+        .methods("GET"_method)([](const crow::Request& req,
+                                  crow::Response& res, const std::string&) {
+            handleStaticRequest(req, res);
+        });
+}
 
-                    res.body() = {std::istreambuf_iterator<char>(inf),
-                                  std::istreambuf_iterator<char>()};
-                    res.end();
-                });
-        }
-    }
-} // namespace webassets
 } // namespace webassets
 } // namespace crow
@@ -15,10 +15,13 @@
 */
 #pragma once
 
+#include "compression_middleware.hpp"
 #include "security_headers_middleware.hpp"
 #include "token_authorization_middleware.hpp"
 #include "webserver_common.hpp"
 
-using CrowApp = crow::App<crow::SecurityHeadersMiddleware,
+// compression::Middleware has to stay first, see its comment
+using CrowApp = crow::App<crow::compression::Middleware,
+                          crow::SecurityHeadersMiddleware,
                           crow::persistent_data::Middleware,
                           crow::token_authorization::Middleware>;
@@ -0,0 +1,387 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+#pragma once
+#include <crow/http_client.h>
+#include <crow/http_request.h>
+#include <crow/http_response.h>
+#include <crow/logging.h>
+
+#include <boost/container/flat_map.hpp>
+#include <chrono>
+#include <error_messages.hpp>
+#include <fstream>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <utils/aggregation_utils.hpp>
+#include <vector>
+
+namespace redfish
+{
+
+// How long a satellite gets to answer, unless the config says otherwise
+constexpr std::chrono::milliseconds aggregationTimeout{2000};
+
+/**
+ * @brief A BMC whose chassis and systems this one shows as its own
+ */
+struct Satellite
+{
+    // Put in front of the satellite's ids; see aggregation_util
+    std::string prefix;
+    crow::http_client::Endpoint endpoint;
+    // Sent as the Authorization header of every request to the satellite
+    std::string authorization;
+};
+
+/**
+ * @brief Makes the Chassis and Systems collections of satellite BMCs part
+ *        of this service's
+ *
+ * The satellites come from a configuration file:
+ *
+ *   {
+ *     "Timeout": 2000,
+ *     "Satellites": [
+ *       {"Prefix": "node2", "Host": "10.0.0.2", "Port": 443, "Tls": true,
+ *        "VerifyCertificate": false,
+ *        "Authorization": "Basic cm9vdDowcGVuQm1j"}
+ *     ]
+ *   }
+ *
+ * Collections are read from every satellite at once, each given Timeout
+ * milliseconds; members of a satellite that doesn't answer in time are
+ * left out.  Requests for a prefixed member, or anything below it, are
+ * sent on to its satellite over a pooled connection, and the links in the
+ * answer are prefixed on the way back.  The query goes with them, so the
+ * satellite applies $top, $skip and $filter, but for $select and $expand,
+ * which are applied here, as for local resources.  Paths with "." or ".."
+ * segments aren't sent on, since the satellite could resolve them to a
+ * resource outside the member, with this service's credentials.
+ */
+class Aggregator
+{
+  public:
+    static constexpr const char* configFile = "/etc/bmcweb/aggregation.json";
+
+    // Reads the satellites from file, if it exists
+    void start(boost::asio::io_service& io,
+               const std::string& file = configFile)
+    {
+        std::ifstream config(file);
+        if (!config.is_open())
+        {
+            return;
+        }
+        nlohmann::json data = nlohmann::json::parse(config, nullptr, false);
+        std::vector<Satellite> satellites;
+        std::chrono::milliseconds timeout = aggregationTimeout;
+        if (!parseConfig(data, satellites, timeout))
+        {
+            BMCWEB_LOG_ERROR << "Ignoring invalid aggregation config " << file;
+            return;
+        }
+        start(io, std::move(satellites), timeout);
+    }
+
+    void start(boost::asio::io_service& io, std::vector<Satellite>&& list,
+               std::chrono::milliseconds timeout)
+    {
+        satellites.clear();
+        for (Satellite& satellite : list)
+        {
+            BMCWEB_LOG_INFO << "Aggregating " << satellite.endpoint.key()
+                            << " as " << satellite.prefix;
+            std::string prefix = satellite.prefix;
+            satellites.emplace(std::move(prefix), std::move(satellite));
+        }
+        requestTimeout = timeout;
+        if (!satellites.empty())
+        {
+            client = std::make_unique<crow::http_client::Client>(io);
+        }
+    }
+
+    void stop()
+    {
+        client.reset();
+        satellites.clear();
+    }
+
+    bool enabled() const
+    {
+        return !satellites.empty();
+    }
+
+    // Whether path belongs to a satellite, and forward() would send it on
+    bool owns(boost::string_view path) const
+    {
+        boost::string_view prefix = aggregation_util::prefixOf(path);
+        return !prefix.empty() &&
+               satellites.find(std::string(prefix)) != satellites.end();
+    }
+
+    static bool parseConfig(const nlohmann::json& data,
+                            std::vector<Satellite>& satellites,
+                            std::chrono::milliseconds& timeout)
+    {
+        if (!data.is_object())
+        {
+            return false;
+        }
+        auto timeoutValue = data.find("Timeout");
+        if (timeoutValue != data.end())
+        {
+            const uint64_t* ms = timeoutValue->get_ptr<const uint64_t*>();
+            if (ms == nullptr || *ms == 0)
+            {
+                return false;
+            }
+            timeout = std::chrono::milliseconds(*ms);
+        }
+        auto list = data.find("Satellites");
+        if (list == data.end() || !list->is_array())
+        {
+            return false;
+        }
+        for (const nlohmann::json& entry : *list)
+        {
+            Satellite satellite;
+            const std::string* prefix = getValue<std::string>(entry, "Prefix");
+            const std::string* host = getValue<std::string>(entry, "Host");
+            if (prefix == nullptr || host == nullptr ||
+                !aggregation_util::isValidPrefix(*prefix))
+            {
+                return false;
+            }
+            satellite.prefix = *prefix;
+            satellite.endpoint.host = *host;
+            const bool* tls = getValue<bool>(entry, "Tls");
+            satellite.endpoint.tls = tls == nullptr || *tls;
+            const bool* verify = getValue<bool>(entry, "VerifyCertificate");
+            satellite.endpoint.verifyPeer = verify == nullptr || *verify;
+            satellite.endpoint.port = satellite.endpoint.tls ? 443 : 80;
+            if (entry.find("Port") != entry.end())
+            {
+                const uint64_t* port = getValue<uint64_t>(entry, "Port");
+                if (port == nullptr || *port == 0 || *port > 65535)
+                {
+                    return false;
+                }
+                satellite.endpoint.port = static_cast<uint16_t>(*port);
+            }
+            const std::string* authorization =
+                getValue<std::string>(entry, "Authorization");
+            if (authorization != nullptr)
+            {
+                satellite.authorization = *authorization;
+            }
+            satellites.push_back(std::move(satellite));
+        }
+        return true;
+    }
+
+    /**
+     * @brief Adds the members of collection on every satellite to the
+     *        collection in res, then ends res
+     */
+    void appendMembers(const std::string& collection, crow::Response& res)
+    {
+        if (satellites.empty())
+        {
+            res.end();
+            return;
+        }
+        auto merge = std::make_shared<Merge>(res, satellites.size());
+        size_t index = 0;
+        for (const std::pair<std::string, Satellite>& satellite : satellites)
+        {
+            std::string prefix = satellite.first;
+            client->send(
+                satellite.second.endpoint,
+                makeRequest(satellite.second,
+                            boost::beast::http::verb::get, collection),
+                requestTimeout,
+                [merge, index, prefix](const boost::system::error_code& ec,
+                                       crow::http_client::Response& r) {
+                    if (ec || r.result() != boost::beast::http::status::ok)
+                    {
+                        BMCWEB_LOG_WARNING
+                            << "No members from " << prefix << ": "
+                            << (ec ? ec.message() : std::string(r.reason()));
+                        return;
+                    }
+                    nlohmann::json body =
+                        nlohmann::json::parse(r.body(), nullptr, false);
+                    auto members = body.find("Members");
+                    if (!body.is_object() || members == body.end() ||
+                        !members->is_array())
+                    {
+                        return;
+                    }
+                    aggregation_util::prefixLinks(*members, prefix);
+                    merge->members[index] = std::move(*members);
+                });
+            index++;
+        }
+    }
+
+    /**
+     * @brief Sends req on to the satellite its path belongs to, and answers
+     *        res with what comes back
+     *
+     * @return false if the path doesn't belong to a satellite, in which
+     *         case res is left alone
+     */
+    bool forward(const crow::Request& req, crow::Response& res)
+    {
+        if (!owns(req.url))
+        {
+            return false;
+        }
+        // As the satellite will see it; "node2_.." is ".." there
+        std::string path = aggregation_util::removePrefix(req.url);
+        if (aggregation_util::hasDotSegment(path))
+        {
+            res.result(boost::beast::http::status::not_found);
+            messages::addMessageToErrorJson(
+                res.jsonValue,
+                messages::resourceMissingAtURI(std::string(req.url)));
+            res.end();
+            return true;
+        }
+        auto satellite = satellites.find(
+            std::string(aggregation_util::prefixOf(req.url)));
+        crow::http_client::Request out = makeRequest(
+            satellite->second, req.method(),
+            path + aggregation_util::forwardedQuery(req.target()));
+        if (!req.body.empty())
+        {
+            out.body() = req.body;
+            out.set(boost::beast::http::field::content_type,
+                    req.getHeaderValue(crow::KnownHeader::contentType));
+        }
+        client->send(
+            satellite->second.endpoint, std::move(out), requestTimeout,
+            [&res, prefix{satellite->first}](
+                const boost::system::error_code& ec,
+                crow::http_client::Response& r) {
+                if (ec)
+                {
+                    BMCWEB_LOG_WARNING << "Request to " << prefix
+                                       << " failed: " << ec.message();
+                    res.result(boost::beast::http::status::service_unavailable);
+                    messages::addMessageToErrorJson(
+                        res.jsonValue,
+                        messages::serviceTemporarilyUnavailable("5"));
+                    res.end();
+                    return;
+                }
+                res.result(r.result());
+                boost::string_view location =
+                    r[boost::beast::http::field::location];
+                if (!location.empty())
+                {
+                    res.addHeader(
+                        "Location",
+                        aggregation_util::addPrefix(location, prefix));
+                }
+                nlohmann::json body =
+                    nlohmann::json::parse(r.body(), nullptr, false);
+                if (body.is_object())
+                {
+                    aggregation_util::prefixLinks(body, prefix);
+                    res.jsonValue = std::move(body);
+                }
+                res.end();
+            });
+        return true;
+    }
+
+  private:
+    // The members of each satellite, added to the response in the
+    // satellites' order once every request is done
+    struct Merge
+    {
+        Merge(crow::Response& res, size_t count) : res(res), members(count)
+        {
+        }
+
+        ~Merge()
+        {
+            nlohmann::json& all = res.jsonValue["Members"];
+            if (!all.is_array())
+            {
+                all = nlohmann::json::array();
+            }
+            for (nlohmann::json& satelliteMembers : members)
+            {
+                for (nlohmann::json& member : satelliteMembers)
+                {
+                    all.push_back(std::move(member));
+                }
+            }
+            res.jsonValue["Members@odata.count"] = all.size();
+            res.end();
+        }
+
+        crow::Response& res;
+        std::vector<nlohmann::json> members;
+    };
+
+    // The value of key, if entry is an object that has one of type T
+    template <typename T>
+    static const T* getValue(const nlohmann::json& entry, const char* key)
+    {
+        if (!entry.is_object())
+        {
+            return nullptr;
+        }
+        auto value = entry.find(key);
+        if (value == entry.end())
+        {
+            return nullptr;
+        }
+        return value->get_ptr<const T*>();
+    }
+
+    static crow::http_client::Request makeRequest(const Satellite& satellite,
+                                                  boost::beast::http::verb verb,
+                                                  const std::string& target)
+    {
+        crow::http_client::Request req{verb, target, 11};
+        req.set(boost::beast::http::field::accept, "application/json");
+        if (!satellite.authorization.empty())
+        {
+            req.set(boost::beast::http::field::authorization,
+                    satellite.authorization);
+        }
+        return req;
+    }
+
+    // By prefix
+    boost::container::flat_map<std::string, Satellite> satellites;
+    std::chrono::milliseconds requestTimeout = aggregationTimeout;
+    std::unique_ptr<crow::http_client::Client> client;
+};
+
+inline Aggregator& aggregator()
+{
+    static Aggregator aggregator;
+    return aggregator;
+}
+
+} // namespace redfish
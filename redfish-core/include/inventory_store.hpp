@@ -0,0 +1,269 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+#pragma once
+#include <crow/logging.h>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/container/flat_map.hpp>
+#include <boost/container/flat_set.hpp>
+#include <dbus_singleton.hpp>
+#include <dbus_utility.hpp>
+#include <functional>
+#include <memory>
+#include <signal_store.hpp>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace redfish
+{
+
+/**
+ * @brief Keeps the objects under /xyz/openbmc_project/inventory in memory
+ *
+ * The store is loaded on first use: one mapper GetSubTree finds the
+ * services owning inventory objects, then each service is read with one
+ * GetManagedObjects.  The cost doesn't grow with the number of objects, so
+ * a collection and all its members, as $expand asks for, take the same
+ * handful of calls as one member.  Properties are kept current from the
+ * PropertiesChanged signals the SignalDispatcher passes on.  Objects coming
+ * or going, or a service starting or stopping, drops the store; the next
+ * request loads it again.
+ */
+class InventoryStore
+{
+  public:
+    using PropertyValue = sdbusplus::message::variant<
+        std::string, bool, uint8_t, int16_t, uint16_t, int32_t, uint32_t,
+        int64_t, uint64_t, double, std::vector<std::string>>;
+    using Properties = boost::container::flat_map<std::string, PropertyValue>;
+    // Properties of an object by interface, as GetManagedObjects returns them
+    using Interfaces = boost::container::flat_map<std::string, Properties>;
+    // Objects by path
+    using Objects = boost::container::flat_map<std::string, Interfaces>;
+
+    InventoryStore() :
+        store(listener(), [this](uint64_t generation) { load(generation); })
+    {
+    }
+
+    /**
+     * @brief Calls back once every inventory object is in the store
+     * @param callback  Called with whether the inventory could be read, and
+     *                  the objects
+     */
+    template <typename Handler> void get(Handler&& callback)
+    {
+        store.get(std::forward<Handler>(callback));
+    }
+
+    void invalidate()
+    {
+        store.invalidate();
+    }
+
+    // Unsubscribes from the signal dispatcher
+    void stop()
+    {
+        store.stop();
+    }
+
+    /**
+     * @brief Merges the properties of all interfaces of an object, the way
+     *        a GetAll for every interface would return them
+     */
+    static Properties allProperties(const Interfaces& interfaces)
+    {
+        Properties merged;
+        for (const std::pair<std::string, Properties>& interface : interfaces)
+        {
+            for (const std::pair<std::string, PropertyValue>& property :
+                 interface.second)
+            {
+                merged.insert(property);
+            }
+        }
+        return merged;
+    }
+
+  private:
+    using ManagedObjects =
+        std::vector<std::pair<sdbusplus::message::object_path, Interfaces>>;
+    using SubTree = std::vector<std::pair<
+        std::string,
+        std::vector<std::pair<std::string, std::vector<std::string>>>>>;
+
+    static constexpr const char* root()
+    {
+        return "/xyz/openbmc_project/inventory";
+    }
+
+    static bool isInventory(const std::string& path)
+    {
+        return boost::starts_with(path, "/xyz/openbmc_project/inventory/");
+    }
+
+    crow::connections::SignalDispatcher::Listener listener()
+    {
+        crow::connections::SignalDispatcher::Listener listener;
+        listener.propertyValues = [this](const std::string& path,
+                                         const std::string&,
+                                         sdbusplus::message::message& message) {
+            if (isInventory(path))
+            {
+                std::string interface;
+                Properties values;
+                message.read(interface, values);
+                update(path, interface, values);
+            }
+        };
+        listener.objectChanged = [this](const std::string& path) {
+            if (isInventory(path))
+            {
+                invalidate();
+            }
+        };
+        listener.serviceChanged = [this](const std::string&) {
+            invalidate();
+        };
+        return listener;
+    }
+
+    void update(const std::string& path, const std::string& interface,
+                const Properties& values)
+    {
+        Objects& objects = store.data();
+        auto object = objects.find(path);
+        if (object == objects.end())
+        {
+            return;
+        }
+        Properties& properties = object->second[interface];
+        for (const std::pair<std::string, PropertyValue>& value : values)
+        {
+            properties[value.first] = value.second;
+        }
+    }
+
+    void add(const ManagedObjects& managed)
+    {
+        for (const auto& object : managed)
+        {
+            const std::string& path = object.first;
+            if (boost::starts_with(path, root()))
+            {
+                Interfaces& interfaces = store.data()[path];
+                for (const auto& interface : object.second)
+                {
+                    interfaces[interface.first] = interface.second;
+                }
+            }
+        }
+    }
+
+    void load(uint64_t loadGeneration)
+    {
+        BMCWEB_LOG_DEBUG << "Loading inventory store";
+        crow::connections::cachedMethodCall(
+            [this, loadGeneration](const boost::system::error_code ec,
+                                   const SubTree& subtree) {
+                if (ec)
+                {
+                    BMCWEB_LOG_ERROR << "Dbus error " << ec;
+                    finishLoad(false, loadGeneration);
+                    return;
+                }
+                boost::container::flat_set<std::string> services;
+                for (const auto& object : subtree)
+                {
+                    for (const auto& owner : object.second)
+                    {
+                        services.insert(owner.first);
+                    }
+                }
+                if (services.empty())
+                {
+                    finishLoad(true, loadGeneration);
+                    return;
+                }
+
+                auto pending = std::make_shared<size_t>(services.size());
+                auto failed = std::make_shared<bool>(false);
+                for (const std::string& service : services)
+                {
+                    loadService(service, root(), pending, failed,
+                                loadGeneration);
+                }
+            },
+            "xyz.openbmc_project.ObjectMapper",
+            "/xyz/openbmc_project/object_mapper",
+            "xyz.openbmc_project.ObjectMapper", "GetSubTree", root(),
+            int32_t(0), std::array<const char*, 0>());
+    }
+
+    // Services put their object manager at the inventory root or at the
+    // root of the bus, so the inventory root is tried first
+    void loadService(const std::string& service, const std::string& path,
+                     const std::shared_ptr<size_t>& pending,
+                     const std::shared_ptr<bool>& failed,
+                     uint64_t loadGeneration)
+    {
+        crow::connections::coalescedMethodCall(
+            [this, service, path, pending, failed,
+             loadGeneration](const boost::system::error_code ec,
+                             const ManagedObjects& managed) {
+                if (ec && path != "/")
+                {
+                    loadService(service, "/", pending, failed,
+                                loadGeneration);
+                    return;
+                }
+                if (ec)
+                {
+                    BMCWEB_LOG_ERROR << "GetManagedObjects of " << service
+                                     << " failed: " << ec;
+                    *failed = true;
+                }
+                else
+                {
+                    add(managed);
+                }
+                if (--*pending == 0)
+                {
+                    finishLoad(!*failed, loadGeneration);
+                }
+            },
+            service, path, "org.freedesktop.DBus.ObjectManager",
+            "GetManagedObjects");
+    }
+
+    void finishLoad(bool ok, uint64_t loadGeneration)
+    {
+        BMCWEB_LOG_DEBUG << "Inventory store loaded " << store.data().size()
+                         << " objects";
+        store.finish(ok, loadGeneration);
+    }
+
+    crow::connections::SignalStore<Objects> store;
+};
+
+inline InventoryStore& inventoryStore()
+{
+    static InventoryStore store;
+    return store;
+}
+
+} // namespace redfish
@@ -15,11 +15,17 @@
 */
 #pragma once
 
+#include "aggregator.hpp"
 #include "privileges.hpp"
+#include "resource_cache.hpp"
 #include "token_authorization_middleware.hpp"
+#include "user_privileges.hpp"
 #include "webserver_common.hpp"
 
 #include <error_messages.hpp>
+#include <http_utility.hpp>
+#include <utils/etag_utils.hpp>
+#include <utils/query_utils.hpp>
 
 #include "crow.h"
 
@@ -37,6 +43,12 @@ class AsyncResp
     {
     }
 
+    // Allocated from the response's arena, when it has one
+    static std::shared_ptr<AsyncResp> create(crow::Response& response)
+    {
+        return crow::allocateShared<AsyncResp>(response.arena, response);
+    }
+
     ~AsyncResp()
     {
         if (res.result() != boost::beast::http::status::ok &&
@@ -63,6 +75,238 @@ class AsyncResp
     crow::Response& res;
 };
 
+/**
+ * @brief Sends a serialized JSON resource, or a 304 if the client already
+ *        has the version etag names
+ */
+inline void sendSerializedJson(const crow::Request& req, crow::Response& res,
+                               const std::string& body,
+                               const std::string& etag)
+{
+    res.addHeader("ETag", etag);
+    boost::string_view ifNoneMatch =
+        req.getHeaderValue(crow::KnownHeader::ifNoneMatch);
+    if (!ifNoneMatch.empty() && http_helpers::etagMatches(ifNoneMatch, etag))
+    {
+        res.result(boost::beast::http::status::not_modified);
+        res.end();
+        return;
+    }
+    res.addHeader("Content-Type", "application/json");
+    res.body() = body;
+    res.end();
+}
+
+inline void sendCachedResource(const crow::Request& req, crow::Response& res,
+                               const CachedResource& resource)
+{
+    for (const std::pair<std::string, std::string>& header : resource.headers)
+    {
+        res.addHeader(header.first, header.second);
+    }
+    sendSerializedJson(req, res, resource.body, resource.etag);
+}
+
+/**
+ * QueryResponse
+ * Finishes off a GET.  The node's handler fills in a response of our own;
+ * once it's done, the references it returned are replaced by GETs of the
+ * resources they point to for $expand, the $select is applied and the result
+ * is tagged with an ETag.  If the client already has that version, a 304 goes
+ * out instead of the resource.
+ */
+class QueryResponse : public std::enable_shared_from_this<QueryResponse>
+{
+  public:
+    QueryResponse(CrowApp& app, const crow::Request& req, crow::Response& res,
+                  query_util::Select&& select,
+                  const query_util::Expand& expand) :
+        app(app),
+        req(req), res(res), select(std::move(select)), expand(expand)
+    {
+    }
+
+    // Has the result stored under the token ResourceCache::begin() gave
+    // for uri
+    void cacheAs(std::string&& uri, uint64_t token)
+    {
+        cacheUri = std::move(uri);
+        cacheToken = token;
+    }
+
+    template <typename Handler> void start(Handler&& handler)
+    {
+        auto self = shared_from_this();
+        inner.setCompleteRequestHandler([self] { self->onHandled(); });
+        handler(inner);
+    }
+
+  private:
+    // One GET made on behalf of $expand
+    struct SubRequest
+    {
+        std::string path;
+        boost::beast::http::request<boost::beast::http::string_body> beastReq;
+        crow::Request req{beastReq};
+        crow::Response res;
+        bool retried = false;
+    };
+
+    void onHandled()
+    {
+        // Dropping the handler breaks the reference cycle through inner
+        auto self = shared_from_this();
+        inner.setCompleteRequestHandler(nullptr);
+
+        if (inner.result() != boost::beast::http::status::ok ||
+            expand.scope == query_util::Expand::Scope::none)
+        {
+            finish();
+            return;
+        }
+        std::vector<nlohmann::json*> references;
+        query_util::findReferences(inner.jsonValue, expand.scope, references);
+        if (references.empty())
+        {
+            finish();
+            return;
+        }
+        pending = references.size();
+        for (nlohmann::json* reference : references)
+        {
+            fetch(reference, (*reference)["@odata.id"].get<std::string>(),
+                  false);
+        }
+    }
+
+    void fetch(nlohmann::json* reference, std::string&& path, bool retried)
+    {
+        auto sub = std::make_shared<SubRequest>();
+        sub->path = std::move(path);
+        sub->retried = retried;
+        std::string target = sub->path;
+        std::string nextLevel = expand.nextLevel();
+        if (!nextLevel.empty())
+        {
+            target += "?$expand=" + nextLevel;
+        }
+        sub->beastReq.method(boost::beast::http::verb::get);
+        sub->beastReq.target(target);
+        sub->req.url = sub->path;
+        sub->req.urlParams = crow::QueryString(target);
+        sub->req.isSecure = req.isSecure;
+        sub->req.middlewareContext = req.middlewareContext;
+        sub->req.ioService = req.ioService;
+
+        auto self = shared_from_this();
+        sub->res.setCompleteRequestHandler([self, sub, reference]() mutable {
+            // Clearing the handler destroys this lambda, so take what it
+            // holds first
+            std::shared_ptr<QueryResponse> query = std::move(self);
+            std::shared_ptr<SubRequest> done = std::move(sub);
+            nlohmann::json* target = reference;
+            done->res.setCompleteRequestHandler(nullptr);
+            query->onFetched(std::move(done), target);
+        });
+        app.handle(sub->req, sub->res);
+    }
+
+    void onFetched(std::shared_ptr<SubRequest>&& sub,
+                   nlohmann::json* reference)
+    {
+        // Collections link their members without the trailing slash the
+        // routes are registered with
+        if (sub->res.result() ==
+                boost::beast::http::status::moved_permanently &&
+            !sub->retried && !boost::ends_with(sub->path, "/"))
+        {
+            std::string path = sub->path + "/";
+            fetch(reference, std::move(path), true);
+            return;
+        }
+        if (sub->res.result() == boost::beast::http::status::ok &&
+            !sub->res.jsonValue.empty())
+        {
+            *reference = std::move(sub->res.jsonValue);
+        }
+        pending--;
+        if (pending == 0)
+        {
+            finish();
+        }
+    }
+
+    void finish()
+    {
+        if (cacheToken != 0)
+        {
+            if (inner.result() == boost::beast::http::status::ok &&
+                !inner.jsonValue.empty())
+            {
+                finishCached();
+                return;
+            }
+            resourceCache().abandon(cacheUri, cacheToken);
+        }
+        for (const auto& field : inner.stringResponse->base())
+        {
+            res.stringResponse->insert(field.name_string(), field.value());
+        }
+        res.result(inner.result());
+        if (inner.result() == boost::beast::http::status::ok)
+        {
+            select.apply(inner.jsonValue);
+            if (!inner.jsonValue.empty() && notModified())
+            {
+                res.result(boost::beast::http::status::not_modified);
+                res.end();
+                return;
+            }
+        }
+        res.jsonValue = std::move(inner.jsonValue);
+        res.body() = std::move(inner.body());
+        res.end();
+    }
+
+    // Serializes the resource once, for the cache and this response alike
+    void finishCached()
+    {
+        auto resource = std::make_shared<CachedResource>();
+        for (const auto& field : inner.stringResponse->base())
+        {
+            resource->headers.emplace_back(std::string(field.name_string()),
+                                           std::string(field.value()));
+        }
+        resource->etag = etag_util::makeEtag(inner.jsonValue);
+        resource->body = inner.jsonValue.dump(2);
+        std::shared_ptr<const CachedResource> cached = resource;
+        resourceCache().complete(cacheUri, cacheToken, std::move(resource));
+        sendCachedResource(req, res, *cached);
+    }
+
+    // Adds the ETag of the resource and tells whether it matches the one
+    // the client sent
+    bool notModified()
+    {
+        std::string etag = etag_util::makeEtag(inner.jsonValue);
+        res.addHeader("ETag", etag);
+        boost::string_view ifNoneMatch =
+            req.getHeaderValue(crow::KnownHeader::ifNoneMatch);
+        return !ifNoneMatch.empty() &&
+               http_helpers::etagMatches(ifNoneMatch, etag);
+    }
+
+    CrowApp& app;
+    const crow::Request& req;
+    crow::Response& res;
+    crow::Response inner;
+    query_util::Select select;
+    query_util::Expand expand;
+    size_t pending = 0;
+    std::string cacheUri;
+    uint64_t cacheToken = 0;
+};
+
 /**
  * @brief  Abstract class used for implementing Redfish nodes.
  *
@@ -71,10 +315,10 @@ class Node
 {
   public:
     template <typename... Params>
-    Node(CrowApp& app, std::string&& entityUrl, Params... params)
+    Node(CrowApp& app, std::string&& entityUrl, Params... params) :
+        rule(app.routeDynamic(entityUrl.c_str()))
     {
-        app.routeDynamic(entityUrl.c_str())
-            .methods("GET"_method, "PATCH"_method, "POST"_method,
+        rule.methods("GET"_method, "PATCH"_method, "POST"_method,
                      "DELETE"_method)([&](const crow::Request& req,
                                           crow::Response& res,
                                           Params... params) {
@@ -97,54 +341,29 @@ class Node
     }
 
     /**
-     * @brief Inserts subroute fields into for the node's json in the form:
-     *        "subroute_name" : { "odata.id": "node_url/subroute_name/" }
-     *        Excludes metadata urls starting with "$" and child urls having
-     *        more than one level.
+     * @brief Links a node one level below this one, in the form:
+     *        "name" : { "@odata.id": "url" }
+     *        See route_tree::findSubRoutes.
+     */
+    void addSubRoute(const std::string& name, const std::string& url)
+    {
+        json[name] = nlohmann::json{{"@odata.id", url}};
+    }
+
+    /**
+     * @brief Called once every node has been created and given its
+     *        subroutes.  From then on json is only read, possibly from
+     *        several threads at once, so handlers must copy it into their
+     *        response before adding to it.
      *
      * @return  None
      */
-    void getSubRoutes(const std::vector<std::unique_ptr<Node>>& allNodes)
+    void freeze()
     {
-        const std::string* url = getUrl();
-        if (url == nullptr)
+        if (staticJson)
         {
-            // BMCWEB_LOG_CRITICAL << "Unable to get url for route";
-            return;
-        }
-
-        for (const auto& node : allNodes)
-        {
-            const std::string* route = node->getUrl();
-            if (route == nullptr)
-            {
-                // BMCWEB_LOG_CRITICAL << "Unable to get url for route";
-                continue;
-            }
-            if (boost::starts_with(*route, *url))
-            {
-                std::string subRoute = route->substr(url->size());
-                if (subRoute.empty())
-                {
-                    continue;
-                }
-
-                if (boost::starts_with(subRoute, "/"))
-                {
-                    subRoute.erase(0, 1);
-                }
-
-                if (boost::ends_with(subRoute, "/"))
-                {
-                    subRoute.pop_back();
-                }
-
-                if (!boost::starts_with(subRoute, "$") &&
-                    subRoute.find('/') == std::string::npos)
-                {
-                    json[subRoute] = nlohmann::json{{"@odata.id", *route}};
-                }
-            }
+            jsonBody = json.dump(2);
+            jsonEtag = etag_util::makeEtag(json);
         }
     }
 
@@ -180,28 +399,141 @@ class Node
         res.end();
     }
 
+    /**
+     * @brief Says whether a GET of the resource may be answered from the
+     *        ResourceCache, and what has to change for it to be built again
+     *
+     * Only plain GETs are cached: no query parameters, and not from a
+     * browser.  Only successful results are kept.
+     *
+     * @param[in] params   Parameters of the request's URL
+     * @param[out] policy  Receives the dependencies and maximum age
+     *
+     * @return true if the resource may be cached
+     */
+    virtual bool getCachePolicy(const std::vector<std::string>& params,
+                                CachePolicy& policy)
+    {
+        return false;
+    }
+
+    /**
+     * @brief Reads $top and $skip, for collections that page themselves
+     *
+     * @param[in] req      Request to read them from
+     * @param[out] res     Answered with an error if either isn't valid
+     * @param[out] paging  Receives the page to send
+     *
+     * @return false if res was answered with an error
+     */
+    static bool getPaging(const crow::Request& req, crow::Response& res,
+                          query_util::Paging& paging)
+    {
+        const char* param = paging.parse(req);
+        if (param == nullptr)
+        {
+            return true;
+        }
+        res.result(boost::beast::http::status::bad_request);
+        messages::addMessageToErrorJson(
+            res.jsonValue, messages::queryParameterValueFormatError(
+                               req.urlParams.get(param).value_or(""), param));
+        res.end();
+        return false;
+    }
+
+    /**
+     * @brief Reads $filter, for collections that filter their members, and
+     *        makes the nextLink of paging repeat it
+     *
+     * @param[in] req      Request to read it from
+     * @param[out] res     Answered with an error if it isn't understood
+     * @param[out] filter  Receives the filter, empty if there was none
+     * @param[in,out] paging  Paging the filtered members go through
+     *
+     * @return false if res was answered with an error
+     */
+    static bool getFilter(const crow::Request& req, crow::Response& res,
+                          query_util::Filter& filter,
+                          query_util::Paging& paging)
+    {
+        boost::optional<std::string> value = req.urlParams.get("$filter");
+        if (!value)
+        {
+            return true;
+        }
+        if (filter.parse(*value))
+        {
+            paging.keep("$filter", *value);
+            return true;
+        }
+        res.result(boost::beast::http::status::bad_request);
+        messages::addMessageToErrorJson(
+            res.jsonValue,
+            messages::queryParameterValueFormatError(*value, "$filter"));
+        res.end();
+        return false;
+    }
+
+    /**
+     * @brief Has the bodies of method streamed to a new file in directory
+     *        as they arrive, for uploads too big to hold in memory.  See
+     *        crow::Request::bodyFile.
+     */
+    void streamBodyToFile(std::string directory,
+                          boost::beast::http::verb method)
+    {
+        rule.streamBodyToFile(std::move(directory), method);
+    }
+
     nlohmann::json json;
 
+    // Set by nodes whose GET handler sends json and nothing else.  freeze()
+    // serializes it up front, and a plain GET gets a copy of those bytes
+    // instead of a copy of the tree.
+    bool staticJson = false;
+
   private:
+    crow::DynamicRule& rule;
+
     void dispatchRequest(CrowApp& app, const crow::Request& req,
                          crow::Response& res,
                          const std::vector<std::string>& params)
     {
-        auto ctx =
+        auto& ctx =
             app.template getContext<crow::token_authorization::Middleware>(req);
 
-        if (!isMethodAllowedForUser(req.method(), entityPrivileges,
-                                    ctx.session->username))
+        // Whitelisted routes have no session, and need no privileges
+        Privileges userPrivileges;
+        if (ctx.session != nullptr)
+        {
+            userPrivileges = userPrivilegeStore().get(*ctx.session);
+        }
+        if (!isMethodAllowedWithPrivileges(req.method(), entityPrivileges,
+                                           userPrivileges))
         {
             res.result(boost::beast::http::status::method_not_allowed);
             res.end();
             return;
         }
 
+        // Members of a satellite BMC are answered by the satellite.  A GET
+        // goes through handleGet first, for $select and $expand.
+        if (req.method() != "GET"_method && aggregator().forward(req, res))
+        {
+            return;
+        }
+        // A GET right after a change mustn't depend on the signal for it
+        // having arrived first
+        if (req.method() != "GET"_method)
+        {
+            resourceCache().erase(std::string(req.url));
+        }
+
         switch (req.method())
         {
             case "GET"_method:
-                doGet(res, req, params);
+                handleGet(app, req, res, params);
                 break;
 
             case "PATCH"_method:
@@ -222,6 +554,64 @@ class Node
         }
         return;
     }
+
+    void handleGet(CrowApp& app, const crow::Request& req,
+                   crow::Response& res, const std::vector<std::string>& params)
+    {
+        query_util::Select select(req);
+        query_util::Expand expand;
+        boost::optional<std::string> expandValue =
+            req.urlParams.get("$expand");
+        if (expandValue && !expand.parse(*expandValue))
+        {
+            res.result(boost::beast::http::status::bad_request);
+            messages::addMessageToErrorJson(
+                res.jsonValue, messages::queryParameterValueFormatError(
+                                   *expandValue, "$expand"));
+            res.end();
+            return;
+        }
+
+        if (!jsonBody.empty() && select.all() &&
+            expand.scope == query_util::Expand::Scope::none &&
+            !http_helpers::requestPrefersHtml(req))
+        {
+            sendSerializedJson(req, res, jsonBody, jsonEtag);
+            return;
+        }
+        // Resources the node lets us cache are sent as they were serialized
+        // last, until something they're built from changes
+        std::string uri;
+        uint64_t cacheToken = 0;
+        CachePolicy policy;
+        if (req.urlParams.empty() && resourceCache().enabled() &&
+            !http_helpers::requestPrefersHtml(req) &&
+            !aggregator().owns(req.url) && getCachePolicy(params, policy))
+        {
+            uri = std::string(req.url);
+            std::shared_ptr<const CachedResource> cached =
+                resourceCache().find(uri);
+            if (cached != nullptr)
+            {
+                sendCachedResource(req, res, *cached);
+                return;
+            }
+            cacheToken = resourceCache().begin(uri, std::move(policy));
+        }
+        auto query = std::make_shared<QueryResponse>(app, req, res,
+                                                     std::move(select), expand);
+        query->cacheAs(std::move(uri), cacheToken);
+        query->start(
+            [this, &req, &params](crow::Response& inner) {
+                if (!aggregator().forward(req, inner))
+                {
+                    doGet(inner, req, params);
+                }
+            });
+    }
+
+    std::string jsonBody;
+    std::string jsonEtag;
 };
 
 } // namespace redfish
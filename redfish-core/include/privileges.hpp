@@ -71,6 +71,17 @@ class Privileges
      */
     Privileges() = default;
 
+    /**
+     * @brief Constructs object from a bitset of privileges
+     *
+     * @param[in] bits  Privileges as returned by bits()
+     *
+     */
+    explicit Privileges(const std::bitset<maxPrivilegeCount>& bits) :
+        privilegeBitset(bits)
+    {
+    }
+
     /**
      * @brief Constructs object with given privileges active
      *
@@ -172,6 +183,15 @@ class Privileges
         return (privilegeBitset & p.privilegeBitset) == p.privilegeBitset;
     }
 
+    /**
+     * @brief Gets the privileges as a bitset, for storing them
+     *
+     */
+    const std::bitset<maxPrivilegeCount>& bits() const
+    {
+        return privilegeBitset;
+    }
+
   private:
     std::bitset<maxPrivilegeCount> privilegeBitset = 0;
 };
@@ -215,24 +235,31 @@ inline bool isMethodAllowedWithPrivileges(const boost::beast::http::verb method,
 }
 
 /**
- * @brief Checks if a user is allowed to call an HTTP method
- *
- * @param[in] method       HTTP method
- * @param[in] user         Username
+ * @brief Gets the privileges of the predefined roles, by the UserPrivilege
+ *        the user manager stores for them
  *
- * @return                 True if method allowed, false otherwise
+ * @param[in] userPrivilege  Privilege role as on D-Bus, such as priv-admin
  *
+ * @return                   The role's privileges, or none if the role isn't
+ *                           known
  */
-inline bool isMethodAllowedForUser(const boost::beast::http::verb method,
-                                   const OperationMap& operationMap,
-                                   const std::string& user)
+inline boost::optional<Privileges>
+    getPrivilegesFromUserPrivilege(boost::beast::string_view userPrivilege)
 {
-    // TODO: load user privileges from configuration as soon as its available
-    // now we are granting all privileges to everyone.
-    Privileges userPrivileges{"Login", "ConfigureManager", "ConfigureSelf",
-                              "ConfigureUsers", "ConfigureComponents"};
-
-    return isMethodAllowedWithPrivileges(method, operationMap, userPrivileges);
+    if (userPrivilege == "priv-admin")
+    {
+        return Privileges{"Login", "ConfigureManager", "ConfigureUsers",
+                          "ConfigureSelf", "ConfigureComponents"};
+    }
+    else if (userPrivilege == "priv-operator")
+    {
+        return Privileges{"Login", "ConfigureSelf", "ConfigureComponents"};
+    }
+    else if (userPrivilege == "priv-user" || userPrivilege == "priv-callback")
+    {
+        return Privileges{"Login", "ConfigureSelf"};
+    }
+    return boost::none;
 }
 
 } // namespace redfish
@@ -17,9 +17,13 @@
 #pragma once
 
 #include "../lib/account_service.hpp"
+#include "../lib/aggregation.hpp"
 #include "../lib/cpudimm.hpp"
 #include "../lib/ethernet.hpp"
+#include "../lib/event_service.hpp"
+#include "../lib/json_schemas.hpp"
 #include "../lib/managers.hpp"
+#include "../lib/message_registries.hpp"
 #include "../lib/network_protocol.hpp"
 #ifdef OCP_CUSTOM_FLAG // TODO Add OCP custom flag for include target header
     #include "../lib/ocp-chassis.hpp"
@@ -31,6 +35,8 @@
 #include "../lib/roles.hpp"
 #include "../lib/service_root.hpp"
 #include "../lib/systems.hpp"
+#include "../lib/task_service.hpp"
+#include "../lib/telemetry_service.hpp"
 #include "../lib/thermal.hpp"
 #include "../lib/systems.hpp"
 #include "../lib/logservices.hpp"
@@ -40,6 +46,7 @@
 #include "../lib/simplestorage.hpp"
 #include "../lib/ampere_computing.hpp"
 #include "../lib/upload_service.hpp"
+#include "utils/route_tree.hpp"
 #include "webserver_common.hpp"
 
 namespace redfish
@@ -81,6 +88,9 @@ class RedfishService
         nodes.emplace_back(std::make_unique<UpdateService>(app));
         nodes.emplace_back(std::make_unique<SoftwareInventoryCollection>(app));
         nodes.emplace_back(std::make_unique<SoftwareInventory>(app));
+        nodes.emplace_back(std::make_unique<TaskService>(app));
+        nodes.emplace_back(std::make_unique<TaskCollection>(app));
+        nodes.emplace_back(std::make_unique<Task>(app));
         nodes.emplace_back(
             std::make_unique<VlanNetworkInterfaceCollection>(app));
 
@@ -107,10 +117,35 @@ class RedfishService
         nodes.emplace_back(std::make_unique<SimpleStorage>(app));
         nodes.emplace_back(std::make_unique<AmpereComputing>(app));
         nodes.emplace_back(std::make_unique<UploadService>(app));
+        nodes.emplace_back(std::make_unique<EventService>(app));
+        nodes.emplace_back(std::make_unique<EventDestinationCollection>(app));
+        nodes.emplace_back(std::make_unique<EventDestination>(app));
+        requestEventStreamRoutes(app);
+        nodes.emplace_back(std::make_unique<TelemetryService>(app));
+        nodes.emplace_back(std::make_unique<MetricReportCollection>(app));
+        nodes.emplace_back(std::make_unique<MetricReport>(app));
+        nodes.emplace_back(std::make_unique<BaseMessageRegistryFile>(app));
+        nodes.emplace_back(std::make_unique<BaseMessageRegistry>(app));
+        requestSchemaRoutes(app);
+        // Last, so every other route comes first
+        addSatelliteRoutes(app, nodes);
 
+        std::vector<std::string> urls;
+        urls.reserve(nodes.size());
+        for (const auto& node : nodes)
+        {
+            const std::string* url = node->getUrl();
+            urls.emplace_back(url == nullptr ? std::string() : *url);
+        }
+        for (const route_tree::SubRoute& subRoute :
+             route_tree::findSubRoutes(urls))
+        {
+            nodes[subRoute.parent]->addSubRoute(subRoute.name,
+                                                urls[subRoute.child]);
+        }
         for (auto& node : nodes)
         {
-            node->getSubRoutes(nodes);
+            node->freeze();
         }
     }
 
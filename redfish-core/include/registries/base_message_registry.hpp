@@ -0,0 +1,664 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+/****************************************************************
+ * The messages of the DMTF Base.1.2.0 registry bmcweb sends.
+ *
+ * Both the message functions in error_messages.hpp and the
+ * registry served under /redfish/v1/Registries are built from
+ * this table, so they can't disagree.  In a message, %1, %2 ...
+ * stand for its arguments.
+ ***************************************************************/
+#pragma once
+#include <array>
+#include <cstddef>
+#include <utility>
+
+namespace redfish
+{
+
+namespace message_registries
+{
+
+struct Message
+{
+    const char* message;
+    const char* severity;
+    size_t numberOfArgs;
+    std::array<const char*, 3> paramTypes;
+    const char* resolution;
+};
+
+using MessageEntry = std::pair<const char*, const Message>;
+
+namespace base
+{
+
+constexpr const char* registryId = "Base.1.2.0";
+constexpr const char* registryPrefix = "Base";
+constexpr const char* registryVersion = "1.2.0";
+constexpr const char* registryName = "Base Message Registry";
+constexpr const char* owningEntity = "DMTF";
+
+constexpr std::array<MessageEntry, 55> registry = {{
+    MessageEntry{
+        "AccessDenied",
+        {
+            "While attempting to establish a Connection to %1, the service "
+            "denied access.",
+            "Critical",
+            1,
+            {"string"},
+            "Attempt to ensure that the URI is correct and that the service "
+            "has the appropriate credentials.",
+        }},
+    MessageEntry{
+        "AccountForSessionNoLongerExists",
+        {
+            "The account for the current session has been removed, thus the "
+            "current session has been removed as well.",
+            "OK",
+            0,
+            {},
+            "Attempt to connect with a valid account.",
+        }},
+    MessageEntry{
+        "AccountModified",
+        {
+            "The account was successfully modified.",
+            "OK",
+            0,
+            {},
+            "No resolution is required.",
+        }},
+    MessageEntry{
+        "AccountNotModified",
+        {
+            "The account modification request failed.",
+            "Warning",
+            0,
+            {},
+            "The modification may have failed due to permission issues or "
+            "issues with the request body.",
+        }},
+    MessageEntry{
+        "AccountRemoved",
+        {
+            "The account was successfully removed.",
+            "OK",
+            0,
+            {},
+            "No resolution is required.",
+        }},
+    MessageEntry{
+        "ActionNotSupported",
+        {
+            "The action %1 is not supported by the resource.",
+            "Critical",
+            1,
+            {"string"},
+            "The action supplied cannot be resubmitted to the implementation.  "
+            "Perhaps the action was invalid, the wrong resource was the target "
+            "or the implementation documentation may be of assistance.",
+        }},
+    MessageEntry{
+        "ActionParameterDuplicate",
+        {
+            "The action %1 was submitted with more than one value for the "
+            "parameter %2.",
+            "Warning",
+            2,
+            {"string", "string"},
+            "Resubmit the action with only one instance of the parameter in "
+            "the request body if the operation failed.",
+        }},
+    MessageEntry{
+        "ActionParameterMissing",
+        {
+            "The action %1 requires the parameter %2 to be present in the "
+            "request body.",
+            "Critical",
+            2,
+            {"string", "string"},
+            "Supply the action with the required parameter in the request body "
+            "when the request is resubmitted.",
+        }},
+    MessageEntry{
+        "ActionParameterNotSupported",
+        {
+            "The parameter %1 for the action %2 is not supported on the target "
+            "resource.",
+            "Warning",
+            2,
+            {"string", "string"},
+            "Remove the parameter supplied and resubmit the request if the "
+            "operation failed.",
+        }},
+    MessageEntry{
+        "ActionParameterUnknown",
+        {
+            "The action %1 was submitted with the invalid parameter %2.",
+            "Warning",
+            2,
+            {"string", "string"},
+            "Correct the invalid parameter and resubmit the request if the "
+            "operation failed.",
+        }},
+    MessageEntry{
+        "ActionParameterValueFormatError",
+        {
+            "The value %1 for the parameter %2 in the action %3 is of a "
+            "different format than the parameter can accept.",
+            "Warning",
+            3,
+            {"string", "string", "string"},
+            "Correct the value for the parameter in the request body and "
+            "resubmit the request if the operation failed.",
+        }},
+    MessageEntry{
+        "ActionParameterValueTypeError",
+        {
+            "The value %1 for the parameter %2 in the action %3 is of a "
+            "different type than the parameter can accept.",
+            "Warning",
+            3,
+            {"string", "string", "string"},
+            "Correct the value for the parameter in the request body and "
+            "resubmit the request if the operation failed.",
+        }},
+    MessageEntry{
+        "CouldNotEstablishConnection",
+        {
+            "The service failed to establish a Connection with the URI %1.",
+            "Critical",
+            1,
+            {"string"},
+            "Ensure that the URI contains a valid and reachable node name, "
+            "protocol information and other URI components.",
+        }},
+    MessageEntry{
+        "CreateFailedMissingReqProperties",
+        {
+            "The create operation failed because the required property %1 was "
+            "missing from the request.",
+            "Critical",
+            1,
+            {"string"},
+            "Correct the body to include the required property with a valid "
+            "value and resubmit the request if the operation failed.",
+        }},
+    MessageEntry{
+        "CreateLimitReachedForResource",
+        {
+            "The create operation failed because the resource has reached the "
+            "limit of possible resources.",
+            "Critical",
+            0,
+            {},
+            "Either delete resources and resubmit the request if the operation "
+            "failed or do not resubmit the request.",
+        }},
+    MessageEntry{
+        "Created",
+        {
+            "The resource has been created successfully",
+            "OK",
+            0,
+            {},
+            "None",
+        }},
+    MessageEntry{
+        "EmptyJSON",
+        {
+            "The request body submitted contained an empty JSON object and the "
+            "service is unable to process it.",
+            "Warning",
+            0,
+            {},
+            "Add properties in the JSON object and resubmit the request.",
+        }},
+    MessageEntry{
+        "EventSubscriptionLimitExceeded",
+        {
+            "The event subscription failed due to the number of simultaneous "
+            "subscriptions exceeding the limit of the implementation.",
+            "Critical",
+            0,
+            {},
+            "Reduce the number of other subscriptions before trying to "
+            "establish the event subscription or increase the limit of "
+            "simultaneous subscriptions (if supported).",
+        }},
+    MessageEntry{
+        "GeneralError",
+        {
+            "A general error has occurred. See ExtendedInfo for more "
+            "information.",
+            "Critical",
+            0,
+            {},
+            "See ExtendedInfo for more information.",
+        }},
+    MessageEntry{
+        "InsufficientPrivilege",
+        {
+            "There are insufficient privileges for the account or credentials "
+            "associated with the current session to perform the requested "
+            "operation.",
+            "Critical",
+            0,
+            {},
+            "Either abandon the operation or change the associated access "
+            "rights and resubmit the request if the operation failed.",
+        }},
+    MessageEntry{
+        "InternalError",
+        {
+            "The request failed due to an internal service error.  The service "
+            "is still operational.",
+            "Critical",
+            0,
+            {},
+            "Resubmit the request.  If the problem persists, consider "
+            "resetting the service.",
+        }},
+    MessageEntry{
+        "InvalidIndex",
+        {
+            "The index %1 is not a valid offset into the array.",
+            "Warning",
+            1,
+            {"number"},
+            "Verify the index value provided is within the bounds of the "
+            "array.",
+        }},
+    MessageEntry{
+        "InvalidObject",
+        {
+            "The object at %1 is invalid.",
+            "Critical",
+            1,
+            {"string"},
+            "Either the object is malformed or the URI is not correct.  "
+            "Correct the condition and resubmit the request if it failed.",
+        }},
+    MessageEntry{
+        "MalformedJSON",
+        {
+            "The request body submitted was malformed JSON and could not be "
+            "parsed by the receiving service.",
+            "Critical",
+            0,
+            {},
+            "Ensure that the request body is valid JSON and resubmit the "
+            "request.",
+        }},
+    MessageEntry{
+        "NoValidSession",
+        {
+            "There is no valid session established with the implementation.",
+            "Critical",
+            0,
+            {},
+            "Establish as session before attempting any operations.",
+        }},
+    MessageEntry{
+        "PropertyDuplicate",
+        {
+            "The property %1 was duplicated in the request.",
+            "Warning",
+            1,
+            {"string"},
+            "Remove the duplicate property from the request body and resubmit "
+            "the request if the operation failed.",
+        }},
+    MessageEntry{
+        "PropertyMissing",
+        {
+            "The property %1 is a required property and must be included in "
+            "the request.",
+            "Warning",
+            1,
+            {"string"},
+            "Ensure that the property is in the request body and has a valid "
+            "value and resubmit the request if the operation failed.",
+        }},
+    MessageEntry{
+        "PropertyNotWritable",
+        {
+            "The property %1 is a read only property and cannot be assigned a "
+            "value.",
+            "Warning",
+            1,
+            {"string"},
+            "Remove the property from the request body and resubmit the "
+            "request if the operation failed.",
+        }},
+    MessageEntry{
+        "PropertyUnknown",
+        {
+            "The property %1 is not in the list of valid properties for the "
+            "resource.",
+            "Warning",
+            1,
+            {"string"},
+            "Remove the unknown property from the request body and resubmit "
+            "the request if the operation failed.",
+        }},
+    MessageEntry{
+        "PropertyValueFormatError",
+        {
+            "The value %1 for the property %2 is of a different format than "
+            "the property can accept.",
+            "Warning",
+            2,
+            {"string", "string"},
+            "Correct the value for the property in the request body and "
+            "resubmit the request if the operation failed.",
+        }},
+    MessageEntry{
+        "PropertyValueModified",
+        {
+            "The property %1 was assigned the value %2 due to modification by "
+            "the service.",
+            "Warning",
+            2,
+            {"string", "string"},
+            "No resolution is required.",
+        }},
+    MessageEntry{
+        "PropertyValueNotInList",
+        {
+            "The value %1 for the property %2 is not in the list of acceptable "
+            "values.",
+            "Warning",
+            2,
+            {"string", "string"},
+            "Choose a value from the enumeration list that the implementation "
+            "can support and resubmit the request if the operation failed.",
+        }},
+    MessageEntry{
+        "PropertyValueTypeError",
+        {
+            "The value %1 for the property %2 is of a different type than the "
+            "property can accept.",
+            "Warning",
+            2,
+            {"string", "string"},
+            "Correct the value for the property in the request body and "
+            "resubmit the request if the operation failed.",
+        }},
+    MessageEntry{
+        "QueryNotSupported",
+        {
+            "Querying is not supported by the implementation.",
+            "Warning",
+            0,
+            {},
+            "Remove the query parameters and resubmit the request if the "
+            "operation failed.",
+        }},
+    MessageEntry{
+        "QueryNotSupportedOnResource",
+        {
+            "Querying is not supported on the requested resource.",
+            "Warning",
+            0,
+            {},
+            "Remove the query parameters and resubmit the request if the "
+            "operation failed.",
+        }},
+    MessageEntry{
+        "QueryParameterOutOfRange",
+        {
+            "The value %1 for the query parameter %2 is out of range %3.",
+            "Warning",
+            3,
+            {"string", "string", "string"},
+            "Reduce the value for the query parameter to a value that is "
+            "within range, such as a start or count value that is within "
+            "bounds of the number of resources in a collection or a page that "
+            "is within the range of valid pages.",
+        }},
+    MessageEntry{
+        "QueryParameterValueFormatError",
+        {
+            "The value %1 for the parameter %2 is of a different format than "
+            "the parameter can accept.",
+            "Warning",
+            2,
+            {"string", "string"},
+            "Correct the value for the query parameter in the request and "
+            "resubmit the request if the operation failed.",
+        }},
+    MessageEntry{
+        "QueryParameterValueTypeError",
+        {
+            "The value %1 for the query parameter %2 is of a different type "
+            "than the parameter can accept.",
+            "Warning",
+            2,
+            {"string", "string"},
+            "Correct the value for the query parameter in the request and "
+            "resubmit the request if the operation failed.",
+        }},
+    MessageEntry{
+        "ResourceAlreadyExists",
+        {
+            "The requested resource of type %1 with the property %2 with the "
+            "value %3 already exists.",
+            "Critical",
+            3,
+            {"string", "string", "string"},
+            "Do not repeat the create operation as the resource has already "
+            "been created.",
+        }},
+    MessageEntry{
+        "ResourceAtUriInUnknownFormat",
+        {
+            "The resource at %1 is in a format not recognized by the service.",
+            "Critical",
+            1,
+            {"string"},
+            "Place an image or resource or file that is recognized by the "
+            "service at the URI.",
+        }},
+    MessageEntry{
+        "ResourceAtUriUnauthorized",
+        {
+            "While accessing the resource at %1, the service received an "
+            "authorization error %2.",
+            "Critical",
+            2,
+            {"string", "string"},
+            "Ensure that the appropriate access is provided for the service in "
+            "order for it to access the URI.",
+        }},
+    MessageEntry{
+        "ResourceCannotBeDeleted",
+        {
+            "The delete request failed because the resource requested cannot "
+            "be deleted.",
+            "Critical",
+            0,
+            {},
+            "Do not attempt to delete a non-deletable resource.",
+        }},
+    MessageEntry{
+        "ResourceExhaustion",
+        {
+            "The resource %1 was unable to satisfy the request due to "
+            "unavailability of resources.",
+            "Critical",
+            1,
+            {"string"},
+            "Ensure that the resources are available and resubmit the request.",
+        }},
+    MessageEntry{
+        "ResourceInStandby",
+        {
+            "The request could not be performed because the resource is in "
+            "standby.",
+            "Critical",
+            0,
+            {},
+            "Ensure that the resource is in the correct power state and "
+            "resubmit the request.",
+        }},
+    MessageEntry{
+        "ResourceInUse",
+        {
+            "The change to the requested resource failed because the resource "
+            "is in use or in transition.",
+            "Warning",
+            0,
+            {},
+            "Remove the condition and resubmit the request if the operation "
+            "failed.",
+        }},
+    MessageEntry{
+        "ResourceMissingAtURI",
+        {
+            "The resource at the URI %1 was not found.",
+            "Critical",
+            1,
+            {"string"},
+            "Place a valid resource at the URI or correct the URI and resubmit "
+            "the request.",
+        }},
+    MessageEntry{
+        "ResourceNotFound",
+        {
+            "The requested resource of type %1 named %2 was not found.",
+            "Critical",
+            2,
+            {"string", "string"},
+            "Provide a valid resource identifier and resubmit the request.",
+        }},
+    MessageEntry{
+        "ServiceInUnknownState",
+        {
+            "The operation failed because the service is in an unknown state "
+            "and can no longer take incoming requests.",
+            "Critical",
+            0,
+            {},
+            "Restart the service and resubmit the request if the operation "
+            "failed.",
+        }},
+    MessageEntry{
+        "ServiceShuttingDown",
+        {
+            "The operation failed because the service is shutting down and can "
+            "no longer take incoming requests.",
+            "Critical",
+            0,
+            {},
+            "When the service becomes available, resubmit the request if the "
+            "operation failed.",
+        }},
+    MessageEntry{
+        "ServiceTemporarilyUnavailable",
+        {
+            "The service is temporarily unavailable.  Retry in %1 seconds.",
+            "Critical",
+            1,
+            {"string"},
+            "Wait for the indicated retry duration and retry the operation.",
+        }},
+    MessageEntry{
+        "SessionLimitExceeded",
+        {
+            "The session establishment failed due to the number of "
+            "simultaneous sessions exceeding the limit of the implementation.",
+            "Critical",
+            0,
+            {},
+            "Reduce the number of other sessions before trying to establish "
+            "the session or increase the limit of simultaneous sessions (if "
+            "supported).",
+        }},
+    MessageEntry{
+        "SourceDoesNotSupportProtocol",
+        {
+            "The other end of the Connection at %1 does not support the "
+            "specified protocol %2.",
+            "Critical",
+            2,
+            {"string", "string"},
+            "Change protocols or URIs. ",
+        }},
+    MessageEntry{
+        "StringValueTooLong",
+        {
+            "The string %1 exceeds the length limit %2.",
+            "Warning",
+            2,
+            {"string", "number"},
+            "Resubmit the request with an appropriate string length.",
+        }},
+    MessageEntry{
+        "Success",
+        {
+            "Successfully Completed Request",
+            "OK",
+            0,
+            {},
+            "None",
+        }},
+    MessageEntry{
+        "UnrecognizedRequestBody",
+        {
+            "The service detected a malformed request body that it was unable "
+            "to interpret.",
+            "Warning",
+            0,
+            {},
+            "Correct the request body and resubmit the request if it failed.",
+        }},
+}};
+
+constexpr bool sameName(const char* left, const char* right)
+{
+    while (*left != '\0' && *left == *right)
+    {
+        left++;
+        right++;
+    }
+    return *left == *right;
+}
+
+/**
+ * @brief Index of a message in the registry, for use at compile time
+ *
+ * @return registry.size() if there is no such message
+ */
+constexpr size_t messageIndex(const char* name)
+{
+    for (size_t i = 0; i < registry.size(); i++)
+    {
+        if (sameName(registry[i].first, name))
+        {
+            return i;
+        }
+    }
+    return registry.size();
+}
+
+} // namespace base
+
+} // namespace message_registries
+
+} // namespace redfish
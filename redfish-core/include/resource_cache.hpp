@@ -0,0 +1,435 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+#pragma once
+#include <crow/logging.h>
+
+#include <algorithm>
+#include <boost/algorithm/string/predicate.hpp>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <signal_dispatcher.hpp>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace redfish
+{
+
+/**
+ * @brief Something on D-Bus a cached resource is built from
+ */
+struct CacheDependency
+{
+    // Object path, or the root of the subtree when subtree is set
+    std::string path;
+    bool subtree = false;
+    // Properties that matter when they change; an empty interface or
+    // property matches any
+    std::string interface;
+    std::string property;
+    // False when only objects coming and going matter, as for a collection.
+    // Objects gaining or losing interfaces always matter.
+    bool properties = true;
+};
+
+/**
+ * @brief How a node's GET may be cached.  See Node::getCachePolicy().
+ */
+struct CachePolicy
+{
+    std::vector<CacheDependency> dependencies;
+    // Kept at most this long, for whatever changes without a signal; a
+    // resource with no dependencies is only ever dropped by age
+    std::chrono::seconds maxAge{30};
+};
+
+/**
+ * @brief A resource as it goes out: serialized, with its ETag and the
+ *        headers its handler added
+ */
+struct CachedResource
+{
+    std::string body;
+    std::string etag;
+    std::vector<std::pair<std::string, std::string>> headers;
+};
+
+/**
+ * @brief Serialized Redfish resources by URI, dropped when what they were
+ *        built from changes
+ *
+ * A GET that misses registers its URI with begin() before the handler
+ * runs, and its result is only stored if nothing the entry depends on
+ * changed by the time complete() is called; so a response built partly
+ * from old values is never kept.  Changes come from the shared
+ * crow::connections::SignalDispatcher.  A service restarting drops
+ * everything.
+ */
+class ResourceCache
+{
+  public:
+    using clock = std::chrono::steady_clock;
+
+    void start()
+    {
+        crow::connections::SignalDispatcher::Listener listener;
+        listener.propertiesChanged =
+            [this](const std::string& path, const std::string& interface,
+                   const std::vector<std::string>& properties) {
+                propertiesChanged(path, interface, properties);
+            };
+        listener.objectChanged = [this](const std::string& path) {
+            objectChanged(path);
+        };
+        listener.serviceChanged = [this](const std::string&) { clear(); };
+        subscription = crow::connections::signalDispatcher().subscribe(
+            std::move(listener));
+        started = true;
+    }
+
+    void stop()
+    {
+        if (started)
+        {
+            crow::connections::signalDispatcher().unsubscribe(subscription);
+        }
+        started = false;
+        entries.clear();
+        byPath.clear();
+        bySubtree.clear();
+    }
+
+    // Nothing is cached until start(), since nothing would drop it
+    bool enabled() const
+    {
+        return started;
+    }
+
+    /**
+     * @brief The resource at uri, if it's cached and not too old
+     */
+    std::shared_ptr<const CachedResource> find(const std::string& uri)
+    {
+        auto entry = entries.find(uri);
+        if (entry == entries.end() || entry->second.resource == nullptr)
+        {
+            missCount++;
+            return nullptr;
+        }
+        if (clock::now() >= entry->second.expires)
+        {
+            erase(entry);
+            missCount++;
+            return nullptr;
+        }
+        hitCount++;
+        return entry->second.resource;
+    }
+
+    /**
+     * @brief Starts watching the dependencies of the resource at uri, which
+     *        is about to be built
+     *
+     * @return Token to pass to complete() or abandon(); 0 if the resource
+     *         won't be cached
+     */
+    uint64_t begin(const std::string& uri, CachePolicy&& policy)
+    {
+        auto old = entries.find(uri);
+        if (old != entries.end())
+        {
+            erase(old);
+        }
+        if (entries.size() >= maxEntries())
+        {
+            sweep();
+            if (entries.size() >= maxEntries())
+            {
+                return 0;
+            }
+        }
+        Entry& entry = entries[uri];
+        entry.token = ++lastToken;
+        entry.expires = clock::now() + policy.maxAge;
+        entry.dependencies = std::move(policy.dependencies);
+        for (const CacheDependency& dependency : entry.dependencies)
+        {
+            if (dependency.subtree)
+            {
+                bySubtree.emplace(dependency.path, uri);
+            }
+            else
+            {
+                byPath.emplace(dependency.path, uri);
+            }
+        }
+        return entry.token;
+    }
+
+    /**
+     * @brief Stores the resource begin() returned token for, unless
+     *        something it depends on changed since
+     */
+    void complete(const std::string& uri, uint64_t token,
+                  std::shared_ptr<const CachedResource>&& resource)
+    {
+        auto entry = entries.find(uri);
+        if (entry != entries.end() && entry->second.token == token)
+        {
+            entry->second.resource = std::move(resource);
+        }
+    }
+
+    // For a resource that turned out not to be worth keeping
+    void abandon(const std::string& uri, uint64_t token)
+    {
+        auto entry = entries.find(uri);
+        if (entry != entries.end() && entry->second.token == token)
+        {
+            erase(entry);
+        }
+    }
+
+    // For a request that may have changed the resource at uri
+    void erase(const std::string& uri)
+    {
+        auto entry = entries.find(uri);
+        if (entry != entries.end())
+        {
+            erase(entry);
+            invalidationCount++;
+        }
+    }
+
+    void clear()
+    {
+        invalidationCount += entries.size();
+        entries.clear();
+        byPath.clear();
+        bySubtree.clear();
+    }
+
+    void propertiesChanged(const std::string& path,
+                           const std::string& interface,
+                           const std::vector<std::string>& properties)
+    {
+        invalidate(path, [&interface,
+                          &properties](const CacheDependency& dependency) {
+            return dependency.properties &&
+                   (dependency.interface.empty() ||
+                    dependency.interface == interface) &&
+                   (dependency.property.empty() ||
+                    std::find(properties.begin(), properties.end(),
+                              dependency.property) != properties.end());
+        });
+    }
+
+    void objectChanged(const std::string& path)
+    {
+        invalidate(path, [](const CacheDependency&) { return true; });
+    }
+
+    uint64_t hits() const
+    {
+        return hitCount;
+    }
+
+    uint64_t misses() const
+    {
+        return missCount;
+    }
+
+    uint64_t invalidations() const
+    {
+        return invalidationCount;
+    }
+
+    size_t size() const
+    {
+        return entries.size();
+    }
+
+    void appendMetrics(std::string& out) const
+    {
+        out += "# HELP bmcweb_resource_cache_hits_total Redfish GETs answered "
+               "from the resource cache\n"
+               "# TYPE bmcweb_resource_cache_hits_total counter\n"
+               "bmcweb_resource_cache_hits_total " +
+               std::to_string(hitCount) +
+               "\n"
+               "# HELP bmcweb_resource_cache_misses_total Redfish GETs of "
+               "cacheable resources that had to be built\n"
+               "# TYPE bmcweb_resource_cache_misses_total counter\n"
+               "bmcweb_resource_cache_misses_total " +
+               std::to_string(missCount) +
+               "\n"
+               "# HELP bmcweb_resource_cache_invalidations_total Cached "
+               "resources dropped because what they depend on changed\n"
+               "# TYPE bmcweb_resource_cache_invalidations_total counter\n"
+               "bmcweb_resource_cache_invalidations_total " +
+               std::to_string(invalidationCount) +
+               "\n"
+               "# HELP bmcweb_resource_cache_entries Resources in the "
+               "resource cache\n"
+               "# TYPE bmcweb_resource_cache_entries gauge\n"
+               "bmcweb_resource_cache_entries " +
+               std::to_string(entries.size()) + "\n";
+    }
+
+  private:
+    // Bounds what a client walking many distinct URIs can make us hold
+    static constexpr size_t maxEntries()
+    {
+        return 512;
+    }
+
+    struct Entry
+    {
+        uint64_t token = 0;
+        // Null until the resource is built
+        std::shared_ptr<const CachedResource> resource;
+        clock::time_point expires;
+        std::vector<CacheDependency> dependencies;
+    };
+
+    using Entries = std::unordered_map<std::string, Entry>;
+
+    // Drops the entries with a dependency on path that matches
+    template <typename Matches>
+    void invalidate(const std::string& path, Matches&& matches)
+    {
+        std::vector<std::string> uris;
+        auto dependsOn = [this, &path, &matches](const std::string& uri) {
+            auto entry = entries.find(uri);
+            if (entry == entries.end())
+            {
+                return false;
+            }
+            for (const CacheDependency& dependency : entry->second.dependencies)
+            {
+                if (isBelow(path, dependency) && matches(dependency))
+                {
+                    return true;
+                }
+            }
+            return false;
+        };
+        auto exact = byPath.equal_range(path);
+        for (auto it = exact.first; it != exact.second; ++it)
+        {
+            if (dependsOn(it->second))
+            {
+                uris.push_back(it->second);
+            }
+        }
+        for (const std::pair<const std::string, std::string>& root : bySubtree)
+        {
+            if (isBelow(path, root.first) && dependsOn(root.second))
+            {
+                uris.push_back(root.second);
+            }
+        }
+        for (const std::string& uri : uris)
+        {
+            erase(uri);
+        }
+    }
+
+    static bool isBelow(const std::string& path, const std::string& root)
+    {
+        return boost::starts_with(path, root) &&
+               (path.size() == root.size() || root == "/" ||
+                path[root.size()] == '/');
+    }
+
+    static bool isBelow(const std::string& path,
+                        const CacheDependency& dependency)
+    {
+        return dependency.subtree ? isBelow(path, dependency.path)
+                                  : path == dependency.path;
+    }
+
+    void erase(Entries::iterator entry)
+    {
+        for (const CacheDependency& dependency : entry->second.dependencies)
+        {
+            if (dependency.subtree)
+            {
+                removeIndex(bySubtree, dependency.path, entry->first);
+            }
+            else
+            {
+                removeIndex(byPath, dependency.path, entry->first);
+            }
+        }
+        entries.erase(entry);
+    }
+
+    template <typename Index>
+    static void removeIndex(Index& index, const std::string& path,
+                            const std::string& uri)
+    {
+        auto range = index.equal_range(path);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (it->second == uri)
+            {
+                index.erase(it);
+                return;
+            }
+        }
+    }
+
+    // Drops what's too old, to make room
+    void sweep()
+    {
+        clock::time_point now = clock::now();
+        for (auto entry = entries.begin(); entry != entries.end();)
+        {
+            auto next = std::next(entry);
+            if (now >= entry->second.expires)
+            {
+                erase(entry);
+            }
+            entry = next;
+        }
+    }
+
+    Entries entries;
+    // URIs by the object path of a dependency
+    std::unordered_multimap<std::string, std::string> byPath;
+    // URIs by the root of a subtree dependency; there are few roots, so
+    // they are all checked against each change
+    std::multimap<std::string, std::string> bySubtree;
+    uint64_t lastToken = 0;
+    uint64_t subscription = 0;
+    bool started = false;
+    uint64_t hitCount = 0;
+    uint64_t missCount = 0;
+    uint64_t invalidationCount = 0;
+};
+
+inline ResourceCache& resourceCache()
+{
+    static ResourceCache cache;
+    return cache;
+}
+
+} // namespace redfish
@@ -0,0 +1,404 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+#pragma once
+#include "privileges.hpp"
+
+#include <crow/logging.h>
+
+#include <boost/container/flat_map.hpp>
+#include <dbus_singleton.hpp>
+#include <functional>
+#include <memory>
+#include <sdbusplus/bus/match.hpp>
+#include <sessions.hpp>
+#include <string>
+#include <vector>
+
+namespace redfish
+{
+
+/**
+ * @brief Knows every user of the user manager and what it may do, so
+ *        AccountService reads and authorizing a request take no D-Bus calls
+ *
+ * The users are read from the user manager once, then kept current from its
+ * signals.  Each change bumps a generation; a session resolves its user's
+ * privileges again only when the generation it resolved them at is stale.
+ * Users the user manager doesn't know, or doesn't give a known role, have
+ * no privileges, nor does anyone until the users have been read; disabled
+ * users have none either.  A user the user manager removes loses its
+ * sessions.
+ */
+class UserPrivilegeStore
+{
+  public:
+    using PropertyValue =
+        sdbusplus::message::variant<bool, std::string,
+                                    std::vector<std::string>>;
+    using Properties = boost::container::flat_map<std::string, PropertyValue>;
+    using Interfaces = boost::container::flat_map<std::string, Properties>;
+    using ManagedObjects =
+        std::vector<std::pair<sdbusplus::message::object_path, Interfaces>>;
+
+    // The xyz.openbmc_project.User.Attributes of a user
+    struct User
+    {
+        // UserPrivilege, like "priv-admin"
+        std::string privilege;
+        bool enabled = true;
+        bool locked = false;
+        std::vector<std::string> groups;
+    };
+    // By user name
+    using Users = boost::container::flat_map<std::string, User>;
+    using UsersCallback = std::function<void(bool, const Users&)>;
+    // Called with the name of a user that changed or went away, or an empty
+    // name when all of them may have
+    using Listener = std::function<void(const std::string&)>;
+
+    UserPrivilegeStore() = default;
+    UserPrivilegeStore(const UserPrivilegeStore&) = delete;
+    UserPrivilegeStore& operator=(const UserPrivilegeStore&) = delete;
+
+    // Subscribes to the user manager and reads the roles
+    void start(sdbusplus::bus::bus& bus)
+    {
+        subscribe(bus);
+        load();
+    }
+
+    // Drops the signal matches; has to happen before the bus goes away
+    void stop()
+    {
+        matches.clear();
+        listeners.clear();
+        waiting.clear();
+    }
+
+    /**
+     * @brief Gets the users, at once if they have been read, or once they
+     *        are
+     *
+     * @param[in] callback  Called with false if the user manager couldn't
+     *                      be read
+     */
+    void getUsers(UsersCallback&& callback)
+    {
+        if (isLoaded)
+        {
+            callback(true, users);
+            return;
+        }
+        waiting.push_back(std::move(callback));
+        if (!loading)
+        {
+            load();
+        }
+    }
+
+    // Whether the user manager has an enabled user by this name
+    bool knows(const std::string& username) const
+    {
+        auto it = users.find(username);
+        return isLoaded && it != users.end() && it->second.enabled;
+    }
+
+    void addListener(Listener&& listener)
+    {
+        listeners.push_back(std::move(listener));
+    }
+
+    /**
+     * @brief Gets the privileges of a session's user
+     *
+     * @param[in,out] session  Session; keeps the resolved privileges
+     */
+    Privileges get(crow::persistent_data::UserSession& session)
+    {
+        if (!isLoaded && !loading && !matches.empty())
+        {
+            // An earlier read failed; no one has privileges until one works
+            load();
+        }
+        if (session.privilegesGeneration != generation)
+        {
+            session.privileges = resolve(session.username).bits();
+            session.privilegesGeneration = generation;
+        }
+        return Privileges(session.privileges);
+    }
+
+    /**
+     * @brief Takes in the properties of a user's Attributes interface
+     *
+     * @param[in] path        Object path of the user
+     * @param[in] properties  Properties that are new or changed
+     */
+    void update(const std::string& path, const Properties& properties)
+    {
+        const std::string name = userName(path);
+        User& user = users[name];
+        for (const std::pair<std::string, PropertyValue>& property :
+             properties)
+        {
+            if (property.first == "UserPrivilege")
+            {
+                const std::string* value =
+                    mapbox::getPtr<const std::string>(property.second);
+                if (value != nullptr)
+                {
+                    user.privilege = *value;
+                }
+            }
+            else if (property.first == "UserEnabled")
+            {
+                const bool* value = mapbox::getPtr<const bool>(property.second);
+                if (value != nullptr)
+                {
+                    user.enabled = *value;
+                }
+            }
+            else if (property.first == "UserLockedForFailedAttempt")
+            {
+                const bool* value = mapbox::getPtr<const bool>(property.second);
+                if (value != nullptr)
+                {
+                    user.locked = *value;
+                }
+            }
+            else if (property.first == "UserGroups")
+            {
+                const std::vector<std::string>* value =
+                    mapbox::getPtr<const std::vector<std::string>>(
+                        property.second);
+                if (value != nullptr)
+                {
+                    user.groups = *value;
+                }
+            }
+        }
+        changed(name);
+    }
+
+    void remove(const std::string& path)
+    {
+        const std::string name = userName(path);
+        users.erase(name);
+        crow::persistent_data::SessionStore::getInstance().removeUserSessions(
+            name);
+        changed(name);
+    }
+
+    void clear()
+    {
+        users.clear();
+        isLoaded = false;
+        changed("");
+    }
+
+    /**
+     * @brief Takes in every user of the user manager, as its
+     *        GetManagedObjects returns them; until then, no one has
+     *        privileges
+     */
+    void setUsers(const ManagedObjects& objects)
+    {
+        for (const auto& object : objects)
+        {
+            auto it = object.second.find(attributesInterface());
+            if (it != object.second.end())
+            {
+                update(object.first, it->second);
+            }
+        }
+        isLoaded = true;
+        // Sessions resolved while nothing was loaded have nothing
+        generation++;
+    }
+
+  private:
+    static constexpr const char* service()
+    {
+        return "xyz.openbmc_project.User.Manager";
+    }
+
+    static constexpr const char* attributesInterface()
+    {
+        return "xyz.openbmc_project.User.Attributes";
+    }
+
+    static std::string userName(const std::string& path)
+    {
+        return path.substr(path.rfind('/') + 1);
+    }
+
+    void changed(const std::string& name)
+    {
+        generation++;
+        for (const Listener& listener : listeners)
+        {
+            listener(name);
+        }
+    }
+
+    Privileges resolve(const std::string& username) const
+    {
+        if (!isLoaded)
+        {
+            return Privileges();
+        }
+        auto it = users.find(username);
+        if (it == users.end() || !it->second.enabled)
+        {
+            return Privileges();
+        }
+        boost::optional<Privileges> privileges =
+            getPrivilegesFromUserPrivilege(it->second.privilege);
+        if (!privileges)
+        {
+            return Privileges();
+        }
+        return *privileges;
+    }
+
+    void subscribe(sdbusplus::bus::bus& bus)
+    {
+        matches.clear();
+        const std::string signal =
+            std::string("type='signal',sender='") + service() + "',";
+        matches.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+            bus,
+            signal + "interface='org.freedesktop.DBus.Properties',"
+                     "member='PropertiesChanged',"
+                     "path_namespace='/xyz/openbmc_project/user',"
+                     "arg0='" +
+                attributesInterface() + "'",
+            [this](sdbusplus::message::message& message) {
+                std::string interface;
+                Properties properties;
+                message.read(interface, properties);
+                update(message.get_path(), properties);
+            }));
+        matches.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+            bus,
+            signal + "interface='org.freedesktop.DBus.ObjectManager',"
+                     "member='InterfacesAdded',"
+                     "arg0path='/xyz/openbmc_project/user/'",
+            [this](sdbusplus::message::message& message) {
+                sdbusplus::message::object_path path;
+                Interfaces interfaces;
+                message.read(path, interfaces);
+                auto it = interfaces.find(attributesInterface());
+                if (it != interfaces.end())
+                {
+                    update(path, it->second);
+                }
+            }));
+        matches.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+            bus,
+            signal + "interface='org.freedesktop.DBus.ObjectManager',"
+                     "member='InterfacesRemoved',"
+                     "arg0path='/xyz/openbmc_project/user/'",
+            [this](sdbusplus::message::message& message) {
+                sdbusplus::message::object_path path;
+                std::vector<std::string> interfaces;
+                message.read(path, interfaces);
+                for (const std::string& interface : interfaces)
+                {
+                    if (interface == attributesInterface())
+                    {
+                        remove(path);
+                        break;
+                    }
+                }
+            }));
+        matches.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+            bus,
+            "type='signal',sender='org.freedesktop.DBus',"
+            "interface='org.freedesktop.DBus',member='NameOwnerChanged',"
+            "arg0='" +
+                std::string(service()) + "'",
+            [this](sdbusplus::message::message& message) {
+                // A restarted user manager may know other users.  A read
+                // under way notices the change and reads again.
+                clear();
+                if (!loading)
+                {
+                    load();
+                }
+            }));
+    }
+
+    void load()
+    {
+        const uint64_t loadGeneration = ++generation;
+        loading = true;
+        crow::connections::systemBus->async_method_call(
+            [this, loadGeneration](const boost::system::error_code ec,
+                                   const ManagedObjects& objects) {
+                if (ec)
+                {
+                    BMCWEB_LOG_ERROR << "Can't read users: " << ec;
+                    loading = false;
+                    // Asking again is left to the next getUsers()
+                    notifyWaiting(false);
+                    return;
+                }
+                if (generation != loadGeneration)
+                {
+                    // The users changed during the call, so what was read
+                    // may be older than what the signals said
+                    load();
+                    return;
+                }
+                loading = false;
+                setUsers(objects);
+                notifyWaiting(true);
+            },
+            service(), "/xyz/openbmc_project/user",
+            "org.freedesktop.DBus.ObjectManager", "GetManagedObjects");
+    }
+
+    void notifyWaiting(bool ok)
+    {
+        std::vector<UsersCallback> callbacks;
+        callbacks.swap(waiting);
+        for (UsersCallback& callback : callbacks)
+        {
+            callback(ok, users);
+        }
+    }
+
+    // Starts at one, so sessions that never resolved their privileges are
+    // stale
+    uint64_t generation = 1;
+    Users users;
+    // Whether users holds everything the user manager knows, and whether a
+    // read of it is under way
+    bool isLoaded = false;
+    bool loading = false;
+    std::vector<UsersCallback> waiting;
+    std::vector<Listener> listeners;
+    std::vector<std::unique_ptr<sdbusplus::bus::match::match>> matches;
+};
+
+inline UserPrivilegeStore& userPrivilegeStore()
+{
+    static UserPrivilegeStore store;
+    return store;
+}
+
+} // namespace redfish
@@ -0,0 +1,272 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+#pragma once
+#include <array>
+#include <boost/utility/string_view.hpp>
+#include <nlohmann/json.hpp>
+#include <string>
+
+namespace redfish
+{
+
+namespace aggregation_util
+{
+
+/**
+ * @brief Collections that satellites add their members to.  A satellite's
+ *        member shows up here with the satellite's prefix and '_' in front
+ *        of its id, so /redfish/v1/Chassis/1 of satellite "node2" is
+ *        /redfish/v1/Chassis/node2_1.
+ */
+constexpr std::array<const char*, 2> aggregatedCollections = {
+    {"/redfish/v1/Chassis", "/redfish/v1/Systems"}};
+
+/**
+ * @brief Prefixes are letters and digits, so the first '_' of an id always
+ *        ends the prefix
+ */
+inline bool isValidPrefix(boost::string_view prefix)
+{
+    if (prefix.empty())
+    {
+        return false;
+    }
+    for (char c : prefix)
+    {
+        if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+              (c >= '0' && c <= '9')))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Finds the member id in a path below one of the aggregated
+ *        collections
+ *
+ * @return false if path isn't below one of them
+ */
+inline bool findMemberId(boost::string_view path, size_t& idStart,
+                         size_t& idEnd)
+{
+    for (boost::string_view collection : aggregatedCollections)
+    {
+        if (path.size() > collection.size() + 1 &&
+            path.starts_with(collection) && path[collection.size()] == '/')
+        {
+            idStart = collection.size() + 1;
+            idEnd = path.find('/', idStart);
+            if (idEnd == boost::string_view::npos)
+            {
+                idEnd = path.size();
+            }
+            return idEnd != idStart;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief The prefix of the member path is under, empty if it has none
+ */
+inline boost::string_view prefixOf(boost::string_view path)
+{
+    size_t idStart = 0;
+    size_t idEnd = 0;
+    if (!findMemberId(path, idStart, idEnd))
+    {
+        return boost::string_view();
+    }
+    boost::string_view id = path.substr(idStart, idEnd - idStart);
+    size_t separator = id.find('_');
+    if (separator == boost::string_view::npos || separator + 1 == id.size())
+    {
+        return boost::string_view();
+    }
+    return id.substr(0, separator);
+}
+
+/**
+ * @brief The path a satellite knows a prefixed path by
+ *
+ * "/redfish/v1/Chassis/node2_1/Thermal" becomes
+ * "/redfish/v1/Chassis/1/Thermal".  Paths without a prefix are returned as
+ * they are.
+ */
+inline std::string removePrefix(boost::string_view path)
+{
+    boost::string_view prefix = prefixOf(path);
+    if (prefix.empty())
+    {
+        return std::string(path);
+    }
+    size_t idStart = 0;
+    size_t idEnd = 0;
+    findMemberId(path, idStart, idEnd);
+    std::string out(path.substr(0, idStart));
+    out.append(path.data() + idStart + prefix.size() + 1,
+               path.size() - idStart - prefix.size() - 1);
+    return out;
+}
+
+/**
+ * @brief The reverse of removePrefix().  Paths outside the aggregated
+ *        collections, and the collections themselves, are returned as they
+ *        are.
+ */
+inline std::string addPrefix(boost::string_view path,
+                             boost::string_view prefix)
+{
+    size_t idStart = 0;
+    size_t idEnd = 0;
+    if (!findMemberId(path, idStart, idEnd))
+    {
+        return std::string(path);
+    }
+    std::string out(path.substr(0, idStart));
+    out.append(prefix.data(), prefix.size());
+    out += '_';
+    out.append(path.data() + idStart, path.size() - idStart);
+    return out;
+}
+
+/**
+ * @brief Whether path has a "." or ".." segment, spelled out or percent
+ *        encoded, which the satellite could resolve to somewhere outside
+ *        the member it was sent for
+ */
+inline bool hasDotSegment(boost::string_view path)
+{
+    while (!path.empty())
+    {
+        size_t end = path.find('/');
+        boost::string_view segment = path.substr(0, end);
+        size_t dots = 0;
+        bool onlyDots = true;
+        for (size_t i = 0; i < segment.size() && onlyDots; i++)
+        {
+            if (segment[i] == '.')
+            {
+                dots++;
+            }
+            else if (segment.substr(i, 3) == "%2e" ||
+                     segment.substr(i, 3) == "%2E")
+            {
+                dots++;
+                i += 2;
+            }
+            else
+            {
+                onlyDots = false;
+            }
+        }
+        if (onlyDots && (dots == 1 || dots == 2))
+        {
+            return true;
+        }
+        if (end == boost::string_view::npos)
+        {
+            break;
+        }
+        path.remove_prefix(end + 1);
+    }
+    return false;
+}
+
+/**
+ * @brief The query of target to send on to a satellite, with its '?', or
+ *        empty if there's nothing to send.  $select and $expand are left
+ *        out, since this service applies them.
+ */
+inline std::string forwardedQuery(boost::string_view target)
+{
+    size_t start = target.find('?');
+    if (start == boost::string_view::npos)
+    {
+        return std::string();
+    }
+    boost::string_view query = target.substr(start + 1);
+    std::string out;
+    while (!query.empty())
+    {
+        size_t end = query.find('&');
+        boost::string_view parameter = query.substr(0, end);
+        boost::string_view key = parameter.substr(0, parameter.find('='));
+        // The '$' may come percent encoded
+        if (key.starts_with("%24"))
+        {
+            key.remove_prefix(3);
+        }
+        else if (key.starts_with("$"))
+        {
+            key.remove_prefix(1);
+        }
+        else
+        {
+            key = boost::string_view();
+        }
+        if (!parameter.empty() && key != "select" && key != "expand")
+        {
+            out += out.empty() ? '?' : '&';
+            out.append(parameter.data(), parameter.size());
+        }
+        if (end == boost::string_view::npos)
+        {
+            break;
+        }
+        query.remove_prefix(end + 1);
+    }
+    return out;
+}
+
+/**
+ * @brief Adds prefix to every @odata.id in a satellite's resource that
+ *        points into an aggregated collection, so the links lead back
+ *        through this service
+ */
+inline void prefixLinks(nlohmann::json& resource, boost::string_view prefix)
+{
+    if (resource.is_array())
+    {
+        for (nlohmann::json& element : resource)
+        {
+            prefixLinks(element, prefix);
+        }
+        return;
+    }
+    if (!resource.is_object())
+    {
+        return;
+    }
+    for (auto it = resource.begin(); it != resource.end(); ++it)
+    {
+        if (it.key() == "@odata.id")
+        {
+            const std::string* link = it->get_ptr<const std::string*>();
+            if (link != nullptr)
+            {
+                *it = addPrefix(*link, prefix);
+            }
+            continue;
+        }
+        prefixLinks(*it, prefix);
+    }
+}
+
+} // namespace aggregation_util
+} // namespace redfish
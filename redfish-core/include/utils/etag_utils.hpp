@@ -0,0 +1,174 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <nlohmann/json.hpp>
+#include <string>
+
+namespace redfish
+{
+
+namespace etag_util
+{
+
+namespace details
+{
+
+constexpr uint64_t fnvOffsetBasis = 0xcbf29ce484222325ULL;
+constexpr uint64_t fnvPrime = 0x100000001b3ULL;
+
+inline void hashBytes(uint64_t& hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= fnvPrime;
+    }
+}
+
+inline void hashString(uint64_t& hash, const std::string& value)
+{
+    // The length keeps {"ab": "c"} and {"a": "bc"} apart
+    uint64_t size = value.size();
+    hashBytes(hash, &size, sizeof(size));
+    hashBytes(hash, value.data(), value.size());
+}
+
+inline void hashValue(uint64_t& hash, const nlohmann::json& json)
+{
+    unsigned char type = static_cast<unsigned char>(json.type());
+    hashBytes(hash, &type, sizeof(type));
+    switch (json.type())
+    {
+        case nlohmann::json::value_t::object:
+        {
+            uint64_t size = json.size();
+            hashBytes(hash, &size, sizeof(size));
+            // Objects keep their keys sorted, so equal objects hash the same
+            // whichever order their properties were filled in
+            for (nlohmann::json::const_iterator it = json.cbegin();
+                 it != json.cend(); ++it)
+            {
+                hashString(hash, it.key());
+                hashValue(hash, *it);
+            }
+            break;
+        }
+        case nlohmann::json::value_t::array:
+        {
+            uint64_t size = json.size();
+            hashBytes(hash, &size, sizeof(size));
+            for (const nlohmann::json& element : json)
+            {
+                hashValue(hash, element);
+            }
+            break;
+        }
+        case nlohmann::json::value_t::string:
+            hashString(hash, *json.get_ptr<const std::string*>());
+            break;
+        case nlohmann::json::value_t::boolean:
+        {
+            bool value = json.get<bool>();
+            hashBytes(hash, &value, sizeof(value));
+            break;
+        }
+        case nlohmann::json::value_t::number_integer:
+        {
+            int64_t value = json.get<int64_t>();
+            hashBytes(hash, &value, sizeof(value));
+            break;
+        }
+        case nlohmann::json::value_t::number_unsigned:
+        {
+            uint64_t value = json.get<uint64_t>();
+            hashBytes(hash, &value, sizeof(value));
+            break;
+        }
+        case nlohmann::json::value_t::number_float:
+        {
+            double value = json.get<double>();
+            hashBytes(hash, &value, sizeof(value));
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+inline std::string formatEtag(uint64_t value)
+{
+    constexpr const char* hexDigits = "0123456789abcdef";
+    std::string etag = "W/\"0123456789abcdef\"";
+    for (size_t i = 0; i < 16; i++)
+    {
+        etag[18 - i] = hexDigits[value & 0xf];
+        value >>= 4;
+    }
+    return etag;
+}
+
+} // namespace details
+
+/**
+ * @brief Hashes a JSON document without serializing it.  Documents that
+ *        compare equal hash the same.
+ *
+ * @param[in] json  Document to hash
+ *
+ * @return 64 bit FNV-1a hash of the document
+ */
+inline uint64_t hash(const nlohmann::json& json)
+{
+    uint64_t hash = details::fnvOffsetBasis;
+    details::hashValue(hash, json);
+    return hash;
+}
+
+/**
+ * @brief Builds the ETag header value for a resource from its content.  The
+ *        tag is weak, as the same resource may be sent pretty printed or
+ *        compressed.
+ *
+ * @param[in] json  The resource as it is about to be sent
+ *
+ * @return Weak entity tag, such as W/"0123456789abcdef"
+ */
+inline std::string makeEtag(const nlohmann::json& json)
+{
+    return details::formatEtag(hash(json));
+}
+
+/**
+ * @brief Builds the ETag header value for a file from its bytes.  Weak for
+ *        the same reason as makeEtag.
+ *
+ * @param[in] content  The file, uncompressed
+ *
+ * @return Weak entity tag, such as W/"0123456789abcdef"
+ */
+inline std::string makeContentEtag(const std::string& content)
+{
+    uint64_t hash = details::fnvOffsetBasis;
+    details::hashBytes(hash, content.data(), content.size());
+    return details::formatEtag(hash);
+}
+
+} // namespace etag_util
+
+} // namespace redfish
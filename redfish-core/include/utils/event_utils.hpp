@@ -0,0 +1,249 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+#pragma once
+#include <boost/algorithm/string/predicate.hpp>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace redfish
+{
+
+namespace event_util
+{
+
+/**
+ * @brief Events one subscriber may have waiting.  Past this the oldest are
+ *        dropped; the gap shows in the event ids.
+ */
+constexpr size_t maxQueuedEvents = 64;
+
+/**
+ * @brief The events a subscriber wants, from the $filter of its stream
+ *
+ * Understands terms of the form "EventType eq 'StatusChange'" and
+ * "OriginResource eq '/redfish/v1/Chassis/1/Thermal'", joined with "or".  An
+ * event passes if it matches any term; an origin term also matches the
+ * resources below it.  Without terms every event passes.
+ */
+class EventFilter
+{
+  public:
+    /**
+     * @brief Parses a $filter value
+     *
+     * @return false if the value isn't understood
+     */
+    bool parse(const std::string& value)
+    {
+        eventTypes.clear();
+        origins.clear();
+        size_t pos = 0;
+        while (true)
+        {
+            size_t end = value.find(" or ", pos);
+            std::string term = value.substr(
+                pos, end == std::string::npos ? std::string::npos : end - pos);
+            if (!parseTerm(term))
+            {
+                return false;
+            }
+            if (end == std::string::npos)
+            {
+                return true;
+            }
+            pos = end + 4;
+        }
+    }
+
+    bool matches(const std::string& eventType,
+                 const std::string& origin) const
+    {
+        if (eventTypes.empty() && origins.empty())
+        {
+            return true;
+        }
+        for (const std::string& type : eventTypes)
+        {
+            if (type == eventType)
+            {
+                return true;
+            }
+        }
+        for (const std::string& resource : origins)
+        {
+            if (origin == resource ||
+                (boost::starts_with(origin, resource) &&
+                 origin[resource.size()] == '/'))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const std::vector<std::string>& getEventTypes() const
+    {
+        return eventTypes;
+    }
+
+    const std::vector<std::string>& getOrigins() const
+    {
+        return origins;
+    }
+
+  private:
+    bool parseTerm(std::string term)
+    {
+        while (!term.empty() && term.front() == ' ')
+        {
+            term.erase(0, 1);
+        }
+        while (!term.empty() && term.back() == ' ')
+        {
+            term.pop_back();
+        }
+        // Property eq 'value'
+        size_t eq = term.find(" eq '");
+        if (eq == std::string::npos || term.size() < eq + 6 ||
+            term.back() != '\'')
+        {
+            return false;
+        }
+        std::string property = term.substr(0, eq);
+        std::string value = term.substr(eq + 5, term.size() - eq - 6);
+        if (value.empty() || value.find('\'') != std::string::npos)
+        {
+            return false;
+        }
+        if (property == "EventType")
+        {
+            eventTypes.push_back(std::move(value));
+            return true;
+        }
+        if (property == "OriginResource")
+        {
+            while (value.size() > 1 && value.back() == '/')
+            {
+                value.pop_back();
+            }
+            origins.push_back(std::move(value));
+            return true;
+        }
+        return false;
+    }
+
+    std::vector<std::string> eventTypes;
+    std::vector<std::string> origins;
+};
+
+/**
+ * @brief Events waiting for one subscriber
+ *
+ * Events are encoded once and shared by every queue they go to.  A queued
+ * event is dropped for a newer one with the same key, so a sensor reading
+ * changing faster than the subscriber reads only sends the latest value.
+ * Past maxQueuedEvents the oldest event is dropped.
+ */
+class EventQueue
+{
+  public:
+    using Event = std::shared_ptr<const std::string>;
+
+    explicit EventQueue(size_t limit = maxQueuedEvents) : limit(limit)
+    {
+    }
+
+    void push(const std::string& key, Event event)
+    {
+        if (!key.empty())
+        {
+            for (auto it = events.begin(); it != events.end(); ++it)
+            {
+                if (it->first == key)
+                {
+                    // The newer event goes last, so ids stay in order
+                    events.erase(it);
+                    coalesced++;
+                    events.emplace_back(key, std::move(event));
+                    return;
+                }
+            }
+        }
+        if (events.size() >= limit)
+        {
+            events.pop_front();
+            dropped++;
+        }
+        events.emplace_back(key, std::move(event));
+    }
+
+    bool empty() const
+    {
+        return events.empty();
+    }
+
+    size_t size() const
+    {
+        return events.size();
+    }
+
+    /**
+     * @brief Takes every queued event, oldest first, into one string
+     */
+    std::string takeAll()
+    {
+        std::string out;
+        for (const std::pair<std::string, Event>& queued : events)
+        {
+            out += *queued.second;
+        }
+        events.clear();
+        return out;
+    }
+
+    // Events replaced by newer ones, and dropped for lack of room
+    uint64_t coalesced{0};
+    uint64_t dropped{0};
+
+  private:
+    size_t limit;
+    std::deque<std::pair<std::string, Event>> events;
+};
+
+/**
+ * @brief Frames a message for a text/event-stream
+ *
+ * @param[in] id    Sent as the event id, which clients send back in
+ *                  Last-Event-ID when they reconnect
+ * @param[in] data  The event, on one line
+ */
+inline std::string sseMessage(uint64_t id, const std::string& data)
+{
+    std::string message = "id: ";
+    message += std::to_string(id);
+    message += "\ndata: ";
+    message += data;
+    message += "\n\n";
+    return message;
+}
+
+} // namespace event_util
+
+} // namespace redfish
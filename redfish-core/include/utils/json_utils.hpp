@@ -17,7 +17,13 @@
 #include <crow/http_request.h>
 #include <crow/http_response.h>
 
+#include <bitset>
+#include <boost/optional.hpp>
+#include <error_messages.hpp>
+#include <limits>
 #include <nlohmann/json.hpp>
+#include <type_traits>
+#include <vector>
 
 namespace redfish
 {
@@ -297,6 +303,244 @@ Result getDouble(const char* fieldName, const nlohmann::json& json,
 bool processJsonFromRequest(crow::Response& res, const crow::Request& req,
                             nlohmann::json& reqJson);
 
+namespace details
+{
+
+template <typename Type> struct IsOptional : std::false_type
+{
+};
+
+template <typename Type>
+struct IsOptional<boost::optional<Type>> : std::true_type
+{
+};
+
+inline bool typeError(const nlohmann::json& jsonValue, const std::string& key,
+                      crow::Response& res)
+{
+    messages::addMessageToErrorJson(
+        res.jsonValue, messages::propertyValueTypeError(jsonValue.dump(), key));
+    res.result(boost::beast::http::status::bad_request);
+    return false;
+}
+
+inline bool unpackValue(nlohmann::json& jsonValue, const std::string& key,
+                        crow::Response& res, std::string& value)
+{
+    std::string* string = jsonValue.get_ptr<std::string*>();
+    if (string == nullptr)
+    {
+        return typeError(jsonValue, key, res);
+    }
+    value = std::move(*string);
+    return true;
+}
+
+inline bool unpackValue(nlohmann::json& jsonValue, const std::string& key,
+                        crow::Response& res, bool& value)
+{
+    const bool* boolean = jsonValue.get_ptr<const bool*>();
+    if (boolean == nullptr)
+    {
+        return typeError(jsonValue, key, res);
+    }
+    value = *boolean;
+    return true;
+}
+
+inline bool unpackValue(nlohmann::json& jsonValue, const std::string& key,
+                        crow::Response& res, double& value)
+{
+    if (!jsonValue.is_number())
+    {
+        return typeError(jsonValue, key, res);
+    }
+    value = jsonValue.get<double>();
+    return true;
+}
+
+// Any number that fits, signed or unsigned
+template <typename Type>
+typename std::enable_if<std::is_integral<Type>::value, bool>::type
+    unpackValue(nlohmann::json& jsonValue, const std::string& key,
+                crow::Response& res, Type& value)
+{
+    const int64_t* signedNumber = jsonValue.get_ptr<const int64_t*>();
+    if (signedNumber != nullptr)
+    {
+        const bool fits =
+            *signedNumber < 0
+                ? std::is_signed<Type>::value &&
+                      *signedNumber >= static_cast<int64_t>(
+                                           std::numeric_limits<Type>::min())
+                : static_cast<uint64_t>(*signedNumber) <=
+                      static_cast<uint64_t>(std::numeric_limits<Type>::max());
+        if (!fits)
+        {
+            return typeError(jsonValue, key, res);
+        }
+        value = static_cast<Type>(*signedNumber);
+        return true;
+    }
+    const uint64_t* unsignedNumber = jsonValue.get_ptr<const uint64_t*>();
+    if (unsignedNumber == nullptr ||
+        *unsignedNumber >
+            static_cast<uint64_t>(std::numeric_limits<Type>::max()))
+    {
+        return typeError(jsonValue, key, res);
+    }
+    value = static_cast<Type>(*unsignedNumber);
+    return true;
+}
+
+// Left for the handler to look into, for nested objects
+inline bool unpackValue(nlohmann::json& jsonValue, const std::string& key,
+                        crow::Response& res, nlohmann::json& value)
+{
+    value = std::move(jsonValue);
+    return true;
+}
+
+template <typename Type>
+bool unpackValue(nlohmann::json& jsonValue, const std::string& key,
+                 crow::Response& res, boost::optional<Type>& value)
+{
+    value.emplace();
+    return unpackValue(jsonValue, key, res, *value);
+}
+
+template <typename Type>
+bool unpackValue(nlohmann::json& jsonValue, const std::string& key,
+                 crow::Response& res, std::vector<Type>& value)
+{
+    if (!jsonValue.is_array())
+    {
+        return typeError(jsonValue, key, res);
+    }
+    value.clear();
+    value.reserve(jsonValue.size());
+    bool result = true;
+    for (nlohmann::json& element : jsonValue)
+    {
+        value.emplace_back();
+        result = unpackValue(element, key, res, value.back()) && result;
+    }
+    return result;
+}
+
+template <size_t Count, size_t Index>
+bool readJsonValue(const std::string& key, nlohmann::json& jsonValue,
+                   crow::Response& res, std::bitset<Count>& handled)
+{
+    messages::addMessageToErrorJson(res.jsonValue,
+                                    messages::propertyUnknown(key));
+    res.result(boost::beast::http::status::bad_request);
+    return false;
+}
+
+template <size_t Count, size_t Index, typename ValueType,
+          typename... UnpackTypes>
+bool readJsonValue(const std::string& key, nlohmann::json& jsonValue,
+                   crow::Response& res, std::bitset<Count>& handled,
+                   const char* keyToCheck, ValueType& valueToFill,
+                   UnpackTypes&... in)
+{
+    if (key != keyToCheck)
+    {
+        return readJsonValue<Count, Index + 1>(key, jsonValue, res, handled,
+                                               in...);
+    }
+    handled.set(Index);
+    return unpackValue(jsonValue, key, res, valueToFill);
+}
+
+template <size_t Index = 0, size_t Count>
+bool checkMissing(const std::bitset<Count>& handled, crow::Response& res)
+{
+    return true;
+}
+
+template <size_t Index = 0, size_t Count, typename ValueType,
+          typename... UnpackTypes>
+bool checkMissing(const std::bitset<Count>& handled, crow::Response& res,
+                  const char* key, ValueType& value, UnpackTypes&... in)
+{
+    bool result = true;
+    if (!handled.test(Index) && !IsOptional<ValueType>::value)
+    {
+        messages::addMessageToErrorJson(res.jsonValue,
+                                        messages::propertyMissing(key));
+        res.result(boost::beast::http::status::bad_request);
+        result = false;
+    }
+    return checkMissing<Index + 1, Count>(handled, res, in...) && result;
+}
+
+} // namespace details
+
+/**
+ * @brief Reads the properties of a request body into typed variables
+ *
+ * Takes pairs of a property name and the variable it goes in: a string,
+ * bool, integer, double, nlohmann::json, a std::vector of those, or a
+ * boost::optional of any of them.  Properties not in boost::optional must
+ * be present.  The body is walked once; each property is matched against
+ * the names and written straight into its variable.  Unknown properties,
+ * wrong types and missing properties are all reported in that pass, as
+ * errors in the response, which is given a 400 status but not ended.
+ *
+ * @param[in]  jsonRequest  Body of the request, an object; values are moved
+ *                          out of it
+ * @param[out] res          Response errors are added to
+ *
+ * @return false if anything was wrong with the body
+ */
+template <typename... UnpackTypes>
+bool readJson(nlohmann::json& jsonRequest, crow::Response& res,
+              const char* key, UnpackTypes&... in)
+{
+    if (!jsonRequest.is_object())
+    {
+        messages::addMessageToErrorJson(res.jsonValue,
+                                        messages::unrecognizedRequestBody());
+        res.result(boost::beast::http::status::bad_request);
+        return false;
+    }
+
+    constexpr size_t count = (sizeof...(in) + 1) / 2;
+    static_assert(sizeof...(in) % 2 == 1,
+                  "readJson takes pairs of a name and a variable");
+    std::bitset<count> handled;
+    bool result = true;
+    for (auto item = jsonRequest.begin(); item != jsonRequest.end(); ++item)
+    {
+        result = details::readJsonValue<count, 0>(item.key(), item.value(),
+                                                  res, handled, key, in...) &&
+                 result;
+    }
+    return details::checkMissing(handled, res, key, in...) && result;
+}
+
+/**
+ * @brief Parses the body of a request and reads it with readJson.  A body
+ *        that isn't JSON gets a MalformedJSON error.
+ */
+template <typename... UnpackTypes>
+bool readJson(const crow::Request& req, crow::Response& res, const char* key,
+              UnpackTypes&... in)
+{
+    nlohmann::json jsonRequest =
+        nlohmann::json::parse(req.body, nullptr, false);
+    if (jsonRequest.is_discarded())
+    {
+        messages::addMessageToErrorJson(res.jsonValue,
+                                        messages::malformedJSON());
+        res.result(boost::beast::http::status::bad_request);
+        return false;
+    }
+    return readJson(jsonRequest, res, key, in...);
+}
+
 } // namespace json_util
 
 } // namespace redfish
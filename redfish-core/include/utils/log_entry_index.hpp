@@ -0,0 +1,298 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+#pragma once
+#include <crow/logging.h>
+
+#include "utils/query_utils.hpp"
+
+#include <boost/container/flat_map.hpp>
+#include <dbus_singleton.hpp>
+#include <dbus_utility.hpp>
+#include <functional>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <signal_store.hpp>
+#include <string>
+#include <vector>
+
+namespace redfish
+{
+
+namespace log_util
+{
+
+/**
+ * @brief Orders entry ids as numbers, which logging services name their
+ *        entries with, falling back to text order for anything else
+ */
+struct IdLess
+{
+    bool operator()(const std::string& a, const std::string& b) const
+    {
+        if (a.size() != b.size())
+        {
+            return a.size() < b.size();
+        }
+        return a < b;
+    }
+};
+
+/**
+ * @brief Gets the id of a log entry, the last component of its object path
+ */
+inline std::string entryId(const std::string& path)
+{
+    return path.substr(path.rfind('/') + 1);
+}
+
+/**
+ * @brief Maps the ids of the entries of a log to their object paths, and to
+ *        the properties of the LogEntry resources they are shown as
+ *
+ * The index is loaded on first use with one GetManagedObjects, then kept
+ * current from the InterfacesAdded and InterfacesRemoved signals under the
+ * root of the logging service, as the SignalDispatcher passes them on, so
+ * finding one entry, a page of them or the ones a $filter picks takes no
+ * call to the service.  The service restarting drops it; the next request
+ * loads it again.
+ *
+ * The GetManagedObjects reply is read into a ManagedObjects, so loading a
+ * log of thousands of entries doesn't copy their property names thousands
+ * of times.
+ *
+ * @tparam Variant  Type the values of the service's properties are read into
+ */
+template <typename Variant> class LogEntryIndex
+{
+  public:
+    using ManagedObjects = crow::connections::ManagedObjects<Variant>;
+    // The properties of an entry, as ManagedObjects holds them
+    using Properties =
+        crow::connections::Range<typename ManagedObjects::Property>;
+
+    struct Entry
+    {
+        std::string path;
+        // The entry as a LogEntry, for $filter to look at
+        nlohmann::json fields;
+    };
+    // Entries by id
+    using Entries = boost::container::flat_map<std::string, Entry, IdLess>;
+    // Fills in the LogEntry properties of an entry from its D-Bus ones
+    using FieldsFunction =
+        std::function<void(const Properties&, nlohmann::json&)>;
+
+    /**
+     * @param[in] service         Logging service owning the entries
+     * @param[in] root            Object manager path of the service
+     * @param[in] entryInterface  Interface every entry implements
+     * @param[in] fieldsOf        Makes the fields of an entry
+     */
+    LogEntryIndex(std::string service, std::string root,
+                  std::string entryInterface, FieldsFunction fieldsOf) :
+        service(std::move(service)),
+        root(std::move(root)), entryInterface(std::move(entryInterface)),
+        fieldsOf(std::move(fieldsOf)),
+        store(listener(), [this](uint64_t generation) { load(generation); })
+    {
+    }
+
+    /**
+     * @brief Calls back once the index holds every entry
+     *
+     * @param[in] callback  Called with whether the entries could be read, and
+     *                      the entries
+     */
+    template <typename Handler> void get(Handler&& callback)
+    {
+        store.get(std::forward<Handler>(callback));
+    }
+
+    void invalidate()
+    {
+        store.invalidate();
+    }
+
+    // Unsubscribes from the signal dispatcher
+    void stop()
+    {
+        store.stop();
+    }
+
+  private:
+    bool isEntry(const std::string& path) const
+    {
+        return path.size() > root.size() && path[root.size()] == '/' &&
+               path.compare(0, root.size(), root) == 0;
+    }
+
+    crow::connections::SignalDispatcher::Listener listener()
+    {
+        crow::connections::SignalDispatcher::Listener listener;
+        listener.interfacesAdded = [this](
+                                       const std::string& path,
+                                       sdbusplus::message::message& message) {
+            if (!isEntry(path))
+            {
+                return;
+            }
+            ManagedObjects added;
+            if (!crow::connections::readInterfacesAdded(message, added))
+            {
+                return;
+            }
+            const typename ManagedObjects::Object& object =
+                *added.objects().begin();
+            const typename ManagedObjects::Interface* entry =
+                added.find(object, entryInterface);
+            if (entry != nullptr)
+            {
+                Properties properties = added.properties(*entry);
+                changed(object.path, &properties);
+            }
+        };
+        listener.interfacesRemoved =
+            [this](const std::string& path,
+                   sdbusplus::message::message& message) {
+                if (!isEntry(path))
+                {
+                    return;
+                }
+                sdbusplus::message::object_path object;
+                std::vector<std::string> interfaces;
+                message.read(object, interfaces);
+                for (const std::string& interface : interfaces)
+                {
+                    if (interface == entryInterface)
+                    {
+                        changed(path, nullptr);
+                        break;
+                    }
+                }
+            };
+        listener.serviceChanged = [this](const std::string& name) {
+            if (name == service)
+            {
+                invalidate();
+            }
+        };
+        return listener;
+    }
+
+    // An entry was added with properties, or removed
+    void changed(const std::string& path, const Properties* properties)
+    {
+        if (!store.ready())
+        {
+            // A load in flight may or may not have seen this
+            store.invalidate();
+            return;
+        }
+        if (properties != nullptr)
+        {
+            store.data()[entryId(path)] = makeEntry(path, *properties);
+        }
+        else
+        {
+            store.data().erase(entryId(path));
+        }
+    }
+
+    void load(uint64_t loadGeneration)
+    {
+        BMCWEB_LOG_DEBUG << "Loading entries of " << service;
+        crow::connections::getManagedObjects<Variant>(
+            [this, loadGeneration](
+                const boost::system::error_code& ec,
+                const std::shared_ptr<const ManagedObjects>& objects) {
+                if (ec)
+                {
+                    BMCWEB_LOG_ERROR << "GetManagedObjects DBUS error: " << ec;
+                    store.finish(false, loadGeneration);
+                    return;
+                }
+                for (const auto& object : objects->objects())
+                {
+                    const typename ManagedObjects::Interface* entry =
+                        objects->find(object, entryInterface);
+                    if (entry != nullptr)
+                    {
+                        store.data().emplace(
+                            entryId(object.path),
+                            makeEntry(object.path,
+                                      objects->properties(*entry)));
+                    }
+                }
+                store.finish(true, loadGeneration);
+            },
+            service, root);
+    }
+
+    Entry makeEntry(const std::string& path,
+                    const Properties& properties) const
+    {
+        Entry entry{path, nlohmann::json::object()};
+        fieldsOf(properties, entry.fields);
+        return entry;
+    }
+
+    std::string service;
+    std::string root;
+    std::string entryInterface;
+    FieldsFunction fieldsOf;
+    crow::connections::SignalStore<Entries> store;
+};
+
+/**
+ * @brief Fills in Members, Members@odata.count and the nextLink of a page of
+ *        the entry collection of a log, of the entries filter passes
+ *
+ * @param[in,out] json    The collection
+ * @param[in] collection  URI of the collection
+ * @param[in] entries     The entries of the log, from its LogEntryIndex
+ * @param[in] paging      Page to fill in
+ * @param[in] filter      Entries to list, from their indexed fields
+ */
+template <typename Entries>
+void addEntryMembers(nlohmann::json& json, const std::string& collection,
+                     const Entries& entries, const query_util::Paging& paging,
+                     const query_util::Filter& filter)
+{
+    const std::string prefix = collection + "/";
+    if (filter.empty())
+    {
+        paging.addMembers(json, collection, entries.size(),
+                          [&entries, &prefix](size_t i) {
+                              return prefix + (entries.begin() + i)->first;
+                          });
+        return;
+    }
+    std::vector<const std::string*> ids;
+    for (const auto& entry : entries)
+    {
+        if (filter.matches(entry.second.fields))
+        {
+            ids.push_back(&entry.first);
+        }
+    }
+    paging.addMembers(
+        json, collection, ids.size(),
+        [&ids, &prefix](size_t i) { return prefix + *ids[i]; });
+}
+
+} // namespace log_util
+
+} // namespace redfish
@@ -0,0 +1,179 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace redfish
+{
+
+namespace telemetry_util
+{
+
+// Marks a sample with no reading
+constexpr int32_t missingSample = std::numeric_limits<int32_t>::min();
+
+/**
+ * @brief The last readings of one sensor, taken at a fixed interval
+ *
+ * Readings are kept in thousandths, as the change from the reading before,
+ * in 4 bytes a sample.  A sample without a reading, or one that changed by
+ * more than fits, is kept as missing.  Once full, each new sample drops the
+ * oldest.
+ */
+class MetricRing
+{
+  public:
+    struct Summary
+    {
+        // Samples that had a reading
+        size_t count = 0;
+        double min = 0;
+        double max = 0;
+        double average = 0;
+    };
+
+    explicit MetricRing(size_t capacity) : deltas(capacity)
+    {
+    }
+
+    // Records a reading; one that isn't finite is recorded as missing
+    void push(double reading)
+    {
+        if (deltas.empty())
+        {
+            return;
+        }
+        if (!std::isfinite(reading) || std::fabs(reading) > 9.0e12)
+        {
+            pushMissing();
+            return;
+        }
+        const int64_t value = std::llround(reading * 1000);
+        const int64_t delta = value - last;
+        if (delta <= missingSample ||
+            delta > std::numeric_limits<int32_t>::max())
+        {
+            pushMissing();
+            return;
+        }
+        append(static_cast<int32_t>(delta));
+        last = value;
+        readings++;
+    }
+
+    void pushMissing()
+    {
+        if (deltas.empty())
+        {
+            return;
+        }
+        append(missingSample);
+    }
+
+    size_t size() const
+    {
+        return count;
+    }
+
+    // Whether any sample in the ring has a reading
+    bool hasReadings() const
+    {
+        return readings != 0;
+    }
+
+    /**
+     * @brief Min, max and average of the readings in the newest samples
+     *
+     * @param[in] newest  Samples to look at
+     */
+    Summary summarize(size_t newest) const
+    {
+        Summary summary;
+        const size_t skip = newest < count ? count - newest : 0;
+        int64_t value = base;
+        int64_t sum = 0;
+        int64_t min = 0;
+        int64_t max = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            const int32_t delta = deltas[(head + i) % deltas.size()];
+            if (delta == missingSample)
+            {
+                continue;
+            }
+            value += delta;
+            if (i < skip)
+            {
+                continue;
+            }
+            if (summary.count == 0 || value < min)
+            {
+                min = value;
+            }
+            if (summary.count == 0 || value > max)
+            {
+                max = value;
+            }
+            sum += value;
+            summary.count++;
+        }
+        if (summary.count != 0)
+        {
+            summary.min = min / 1000.0;
+            summary.max = max / 1000.0;
+            summary.average =
+                static_cast<double>(sum) / summary.count / 1000.0;
+        }
+        return summary;
+    }
+
+  private:
+    void append(int32_t delta)
+    {
+        if (count == deltas.size())
+        {
+            // The oldest reading becomes part of the base
+            const int32_t oldest = deltas[head];
+            if (oldest != missingSample)
+            {
+                base += oldest;
+                readings--;
+            }
+            deltas[head] = delta;
+            head = (head + 1) % deltas.size();
+            return;
+        }
+        deltas[(head + count) % deltas.size()] = delta;
+        count++;
+    }
+
+    std::vector<int32_t> deltas;
+    // Index of the oldest sample
+    size_t head = 0;
+    size_t count = 0;
+    // Reading before the oldest sample
+    int64_t base = 0;
+    // Newest reading
+    int64_t last = 0;
+    size_t readings = 0;
+};
+
+} // namespace telemetry_util
+
+} // namespace redfish
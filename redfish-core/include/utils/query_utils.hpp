@@ -0,0 +1,878 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+#pragma once
+#include <crow/http_request.h>
+
+#include <algorithm>
+#include <array>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+namespace redfish
+{
+
+namespace query_util
+{
+
+/**
+ * @brief Deepest $expand the service handles, advertised in the service root
+ */
+constexpr unsigned maxExpandLevels = 3;
+
+/**
+ * @brief Properties picked by the $select query parameter
+ *
+ * Paths are split on '/', so "$select=Status/Health" keeps only Health inside
+ * Status.  Without $select every property is selected.
+ */
+class Select
+{
+  public:
+    Select() = default;
+
+    explicit Select(const crow::Request& req)
+    {
+        boost::optional<std::string> value = req.urlParams.get("$select");
+        if (value)
+        {
+            parse(*value);
+        }
+    }
+
+    explicit Select(const std::string& value)
+    {
+        parse(value);
+    }
+
+    /**
+     * @brief True if no $select was given, so the whole resource is wanted
+     */
+    bool all() const
+    {
+        return paths.empty();
+    }
+
+    /**
+     * @brief Tells whether a top level property, or anything inside it, was
+     *        selected.  Handlers use this to skip D-Bus calls that only fill
+     *        in properties nobody asked for.
+     *
+     * @param[in] property  Name of the top level property
+     *
+     * @return true if the property has to be filled in
+     */
+    bool contains(const std::string& property) const
+    {
+        if (all())
+        {
+            return true;
+        }
+        for (const std::vector<std::string>& path : paths)
+        {
+            if (path.front() == property)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Removes every property that wasn't selected from a resource.
+     *        @odata annotations are always kept.
+     *
+     * @param[in,out] json  Resource to prune
+     */
+    void apply(nlohmann::json& json) const
+    {
+        if (all())
+        {
+            return;
+        }
+        PathList selected;
+        selected.reserve(paths.size());
+        for (const std::vector<std::string>& path : paths)
+        {
+            selected.push_back(&path);
+        }
+        prune(json, selected, 0);
+    }
+
+  private:
+    void parse(const std::string& value)
+    {
+        std::vector<std::string> properties;
+        boost::split(properties, value, boost::is_any_of(","));
+        for (std::string& property : properties)
+        {
+            boost::trim(property);
+            if (property.empty())
+            {
+                continue;
+            }
+            std::vector<std::string> path;
+            boost::split(path, property, boost::is_any_of("/"));
+            paths.push_back(std::move(path));
+        }
+    }
+
+    using PathList = std::vector<const std::vector<std::string>*>;
+
+    static void prune(nlohmann::json& json, const PathList& selected,
+                      size_t depth)
+    {
+        if (json.is_array())
+        {
+            for (nlohmann::json& element : json)
+            {
+                prune(element, selected, depth);
+            }
+            return;
+        }
+        if (!json.is_object())
+        {
+            return;
+        }
+
+        PathList below;
+        for (nlohmann::json::iterator it = json.begin(); it != json.end();)
+        {
+            if (boost::starts_with(it.key(), "@odata."))
+            {
+                ++it;
+                continue;
+            }
+            bool whole = false;
+            below.clear();
+            for (const std::vector<std::string>* path : selected)
+            {
+                if ((*path)[depth] == it.key())
+                {
+                    if (path->size() == depth + 1)
+                    {
+                        whole = true;
+                        break;
+                    }
+                    below.push_back(path);
+                }
+            }
+            if (whole)
+            {
+                ++it;
+            }
+            else if (below.empty())
+            {
+                it = json.erase(it);
+            }
+            else
+            {
+                prune(*it, below, depth + 1);
+                ++it;
+            }
+        }
+    }
+
+    std::vector<std::vector<std::string>> paths;
+};
+
+/**
+ * @brief The $expand query parameter
+ *
+ * "*" expands every reference, "." only those outside of Links and "~" only
+ * those inside it.  "$levels=n" goes n levels of references deep.
+ */
+struct Expand
+{
+    enum class Scope
+    {
+        none,
+        all,
+        notLinks,
+        links
+    };
+
+    Scope scope = Scope::none;
+    unsigned levels = 1;
+
+    /**
+     * @brief Parses a $expand value
+     *
+     * @param[in] value  Value of the query parameter
+     *
+     * @return false if the value isn't valid
+     */
+    bool parse(const std::string& value)
+    {
+        std::string::size_type options = value.find('(');
+        std::string what = value.substr(0, options);
+        if (what == "*")
+        {
+            scope = Scope::all;
+        }
+        else if (what == ".")
+        {
+            scope = Scope::notLinks;
+        }
+        else if (what == "~")
+        {
+            scope = Scope::links;
+        }
+        else
+        {
+            return false;
+        }
+
+        levels = 1;
+        if (options == std::string::npos)
+        {
+            return true;
+        }
+        const std::string prefix = "($levels=";
+        if (value.compare(options, prefix.size(), prefix) != 0 ||
+            value.back() != ')')
+        {
+            return false;
+        }
+        const char* begin = value.c_str() + options + prefix.size();
+        char* end = nullptr;
+        unsigned long parsed = std::strtoul(begin, &end, 10);
+        if (end == begin || *end != ')' || end != &value.back() ||
+            parsed == 0 || parsed > maxExpandLevels)
+        {
+            return false;
+        }
+        levels = static_cast<unsigned>(parsed);
+        return true;
+    }
+
+    /**
+     * @brief The $expand value for the resources one level down, empty if
+     *        they shouldn't expand anything
+     */
+    std::string nextLevel() const
+    {
+        if (levels <= 1)
+        {
+            return "";
+        }
+        const char* what = scope == Scope::all
+                               ? "*"
+                               : scope == Scope::links ? "~" : ".";
+        return std::string(what) + "($levels=" + std::to_string(levels - 1) +
+               ")";
+    }
+};
+
+/**
+ * @brief Finds the references in a resource that $expand should replace
+ *        with the resources they point to.  A reference is an object whose
+ *        only property is @odata.id; the resource's own @odata.id isn't one.
+ *
+ * @param[in] json      Resource to look through
+ * @param[in] scope     Which references to expand
+ * @param[out] found    Receives the reference objects
+ * @param[in] inLinks   Whether json is inside a Links property
+ */
+inline void findReferences(nlohmann::json& json, Expand::Scope scope,
+                           std::vector<nlohmann::json*>& found,
+                           bool inLinks = false)
+{
+    if (json.is_array())
+    {
+        for (nlohmann::json& element : json)
+        {
+            findReferences(element, scope, found, inLinks);
+        }
+        return;
+    }
+    if (!json.is_object())
+    {
+        return;
+    }
+    if (json.size() == 1)
+    {
+        nlohmann::json::iterator odataId = json.find("@odata.id");
+        if (odataId != json.end() && odataId->is_string())
+        {
+            if (inLinks ? scope != Expand::Scope::notLinks
+                        : scope != Expand::Scope::links)
+            {
+                found.push_back(&json);
+            }
+            return;
+        }
+    }
+    for (nlohmann::json::iterator it = json.begin(); it != json.end(); ++it)
+    {
+        if (it->is_structured())
+        {
+            findReferences(*it, scope, found, inLinks || it.key() == "Links");
+        }
+    }
+}
+
+/**
+ * @brief The $filter query parameter
+ *
+ * Understands comparisons of a member property with a literal, such as
+ * "Severity eq 'Critical'" or "Created gt '2018-11-01T00:00:00+00:00'", with
+ * eq, ne, gt, ge, lt and le, joined with and, or and parentheses.  A property
+ * inside another is written as a path, "Status/Health".  Literals are
+ * strings in single quotes, numbers, true, false and null.
+ *
+ * Strings order as text, which puts Redfish timestamps with the same offset
+ * in time order.  A property the member doesn't have is null.  Comparing
+ * values of different types only holds for ne.
+ */
+class Filter
+{
+  public:
+    /**
+     * @brief Parses a $filter value
+     *
+     * @return false if the value isn't understood
+     */
+    bool parse(const std::string& value)
+    {
+        nodes.clear();
+        tokens.clear();
+        next = 0;
+        if (!tokenize(value))
+        {
+            nodes.clear();
+            return false;
+        }
+        size_t parsed = parseOr(0);
+        bool complete = parsed != invalid && next == tokens.size();
+        tokens.clear();
+        if (!complete)
+        {
+            nodes.clear();
+            return false;
+        }
+        root = parsed;
+        return true;
+    }
+
+    /**
+     * @brief True if nothing was parsed, so every member passes
+     */
+    bool empty() const
+    {
+        return nodes.empty();
+    }
+
+    bool matches(const nlohmann::json& member) const
+    {
+        return empty() || evaluate(root, member);
+    }
+
+  private:
+    enum class Kind
+    {
+        eq,
+        ne,
+        gt,
+        ge,
+        lt,
+        le,
+        andTerms,
+        orTerms
+    };
+
+    struct Node
+    {
+        Kind kind;
+        // Comparisons
+        std::vector<std::string> path;
+        nlohmann::json literal;
+        // and, or
+        std::vector<size_t> terms;
+    };
+
+    struct Token
+    {
+        std::string text;
+        bool quoted;
+    };
+
+    static constexpr size_t invalid = std::numeric_limits<size_t>::max();
+    // Parentheses nest no deeper than this
+    static constexpr size_t maxDepth = 16;
+
+    bool tokenize(const std::string& value)
+    {
+        size_t pos = 0;
+        while (pos < value.size())
+        {
+            char c = value[pos];
+            if (c == ' ')
+            {
+                pos++;
+            }
+            else if (c == '(' || c == ')')
+            {
+                tokens.push_back({std::string(1, c), false});
+                pos++;
+            }
+            else if (c == '\'')
+            {
+                // A quote inside a string is written twice
+                std::string text;
+                pos++;
+                while (true)
+                {
+                    if (pos >= value.size())
+                    {
+                        return false;
+                    }
+                    if (value[pos] == '\'')
+                    {
+                        if (pos + 1 < value.size() && value[pos + 1] == '\'')
+                        {
+                            text += '\'';
+                            pos += 2;
+                            continue;
+                        }
+                        pos++;
+                        break;
+                    }
+                    text += value[pos++];
+                }
+                tokens.push_back({std::move(text), true});
+            }
+            else
+            {
+                size_t end = value.find_first_of(" ()'", pos);
+                if (end == std::string::npos)
+                {
+                    end = value.size();
+                }
+                tokens.push_back({value.substr(pos, end - pos), false});
+                pos = end;
+            }
+        }
+        return true;
+    }
+
+    bool atWord(const char* word) const
+    {
+        return next < tokens.size() && !tokens[next].quoted &&
+               tokens[next].text == word;
+    }
+
+    size_t parseOr(size_t depth)
+    {
+        return parseJoined(depth, "or", Kind::orTerms);
+    }
+
+    size_t parseAnd(size_t depth)
+    {
+        return parseJoined(depth, "and", Kind::andTerms);
+    }
+
+    // Terms joined by one operator are kept in one node, so a long chain
+    // doesn't make a deep tree
+    size_t parseJoined(size_t depth, const char* word, Kind kind)
+    {
+        size_t first = kind == Kind::orTerms ? parseAnd(depth)
+                                             : parsePrimary(depth);
+        if (first == invalid || !atWord(word))
+        {
+            return first;
+        }
+        Node node{kind, {}, nullptr, {first}};
+        while (atWord(word))
+        {
+            next++;
+            size_t term = kind == Kind::orTerms ? parseAnd(depth)
+                                                : parsePrimary(depth);
+            if (term == invalid)
+            {
+                return invalid;
+            }
+            node.terms.push_back(term);
+        }
+        nodes.push_back(std::move(node));
+        return nodes.size() - 1;
+    }
+
+    size_t parsePrimary(size_t depth)
+    {
+        if (atWord("("))
+        {
+            if (depth >= maxDepth)
+            {
+                return invalid;
+            }
+            next++;
+            size_t inner = parseOr(depth + 1);
+            if (inner == invalid || !atWord(")"))
+            {
+                return invalid;
+            }
+            next++;
+            return inner;
+        }
+        return parseComparison();
+    }
+
+    size_t parseComparison()
+    {
+        if (next + 3 > tokens.size())
+        {
+            return invalid;
+        }
+        const Token& property = tokens[next];
+        const Token& op = tokens[next + 1];
+        const Token& literal = tokens[next + 2];
+        if (property.quoted || op.quoted || property.text == "(" ||
+            property.text == ")")
+        {
+            return invalid;
+        }
+        Node node{Kind::eq, {}, nullptr, {}};
+        static const std::array<std::pair<const char*, Kind>, 6> operators{
+            {{"eq", Kind::eq},
+             {"ne", Kind::ne},
+             {"gt", Kind::gt},
+             {"ge", Kind::ge},
+             {"lt", Kind::lt},
+             {"le", Kind::le}}};
+        auto found = std::find_if(
+            operators.begin(), operators.end(),
+            [&op](const std::pair<const char*, Kind>& entry) {
+                return op.text == entry.first;
+            });
+        if (found == operators.end())
+        {
+            return invalid;
+        }
+        node.kind = found->second;
+        boost::split(node.path, property.text, boost::is_any_of("/"));
+        for (const std::string& segment : node.path)
+        {
+            if (segment.empty())
+            {
+                return invalid;
+            }
+        }
+        if (!parseLiteral(literal, node.literal))
+        {
+            return invalid;
+        }
+        next += 3;
+        nodes.push_back(std::move(node));
+        return nodes.size() - 1;
+    }
+
+    static bool parseLiteral(const Token& token, nlohmann::json& literal)
+    {
+        if (token.quoted)
+        {
+            literal = token.text;
+            return true;
+        }
+        if (token.text == "true" || token.text == "false")
+        {
+            literal = token.text == "true";
+            return true;
+        }
+        if (token.text == "null")
+        {
+            literal = nullptr;
+            return true;
+        }
+        if (token.text.empty() || token.text == "(" || token.text == ")")
+        {
+            return false;
+        }
+        char* end = nullptr;
+        double number = std::strtod(token.text.c_str(), &end);
+        if (*end != '\0' || !std::isfinite(number))
+        {
+            return false;
+        }
+        literal = number;
+        return true;
+    }
+
+    bool evaluate(size_t index, const nlohmann::json& member) const
+    {
+        const Node& node = nodes[index];
+        if (node.kind == Kind::andTerms)
+        {
+            for (size_t term : node.terms)
+            {
+                if (!evaluate(term, member))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+        if (node.kind == Kind::orTerms)
+        {
+            for (size_t term : node.terms)
+            {
+                if (evaluate(term, member))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        static const nlohmann::json missing;
+        const nlohmann::json* value = &member;
+        for (const std::string& segment : node.path)
+        {
+            if (!value->is_object())
+            {
+                value = &missing;
+                break;
+            }
+            auto it = value->find(segment);
+            value = it == value->end() ? &missing : &*it;
+        }
+        return compare(node.kind, *value, node.literal);
+    }
+
+    static bool compare(Kind kind, const nlohmann::json& value,
+                        const nlohmann::json& literal)
+    {
+        int order = 0;
+        if (value.is_number() && literal.is_number())
+        {
+            double a = value.get<double>();
+            double b = literal.get<double>();
+            order = a < b ? -1 : (a > b ? 1 : 0);
+        }
+        else if (value.is_string() && literal.is_string())
+        {
+            order = value.get_ref<const std::string&>().compare(
+                literal.get_ref<const std::string&>());
+        }
+        else if (value.type() == literal.type() &&
+                 (value.is_boolean() || value.is_null()))
+        {
+            if (kind != Kind::eq && kind != Kind::ne)
+            {
+                return false;
+            }
+            order = value == literal ? 0 : 1;
+        }
+        else
+        {
+            return kind == Kind::ne;
+        }
+        switch (kind)
+        {
+            case Kind::eq:
+                return order == 0;
+            case Kind::ne:
+                return order != 0;
+            case Kind::gt:
+                return order > 0;
+            case Kind::ge:
+                return order >= 0;
+            case Kind::lt:
+                return order < 0;
+            case Kind::le:
+                return order <= 0;
+            default:
+                return false;
+        }
+    }
+
+    std::vector<Node> nodes;
+    size_t root = 0;
+    // Only used while parsing
+    std::vector<Token> tokens;
+    size_t next = 0;
+};
+
+/**
+ * @brief Percent encodes a query parameter value
+ */
+inline std::string urlEncode(const std::string& value)
+{
+    constexpr const char* hexDigits = "0123456789ABCDEF";
+    std::string encoded;
+    for (unsigned char c : value)
+    {
+        if (std::isalnum(c) || c == '-' || c == '.' || c == '_' || c == '~')
+        {
+            encoded += static_cast<char>(c);
+            continue;
+        }
+        encoded += '%';
+        encoded += hexDigits[c >> 4];
+        encoded += hexDigits[c & 0xf];
+    }
+    return encoded;
+}
+
+/**
+ * @brief Most members one page of a collection holds.  Longer collections,
+ *        or a larger $top, get the rest through Members@odata.nextLink, so a
+ *        response stays bounded however long the collection grows.
+ */
+constexpr size_t maxPageMembers = 1000;
+
+/**
+ * @brief The $top and $skip query parameters
+ *
+ * Collections that can be long page themselves, only building the members
+ * on the requested page.  Members are numbered in an order that doesn't
+ * change between requests, sorted by id, so that a nextLink carries on
+ * where the page before it stopped.
+ */
+struct Paging
+{
+    size_t skip = 0;
+    size_t top = maxPageMembers;
+    // Other query parameters the nextLink repeats, such as $filter
+    std::string query;
+
+    /**
+     * @brief Reads $top and $skip from a request
+     *
+     * @param[in] req  Request to read them from
+     *
+     * @return Name of the parameter that isn't valid, or nullptr
+     */
+    const char* parse(const crow::Request& req)
+    {
+        boost::optional<std::string> value = req.urlParams.get("$skip");
+        if (value && !parseCount(*value, skip))
+        {
+            return "$skip";
+        }
+        value = req.urlParams.get("$top");
+        if (value && !parseCount(*value, top))
+        {
+            return "$top";
+        }
+        top = std::min(top, maxPageMembers);
+        return nullptr;
+    }
+
+    /**
+     * @brief Parses a $top or $skip value, a non negative integer
+     *
+     * @param[in] value   Value of the query parameter
+     * @param[out] count  Receives the parsed value
+     *
+     * @return false if the value isn't valid
+     */
+    static bool parseCount(const std::string& value, size_t& count)
+    {
+        if (value.empty() || value.size() > 9 ||
+            value.find_first_not_of("0123456789") != std::string::npos)
+        {
+            return false;
+        }
+        count = std::strtoul(value.c_str(), nullptr, 10);
+        return true;
+    }
+
+    /**
+     * @brief Makes the nextLink repeat a query parameter, so that the next
+     *        page is of the same members
+     */
+    void keep(const std::string& name, const std::string& value)
+    {
+        query += "&" + name + "=" + urlEncode(value);
+    }
+
+    /**
+     * @brief Index of the first member on the page
+     */
+    size_t begin(size_t count) const
+    {
+        return skip < count ? skip : count;
+    }
+
+    /**
+     * @brief Index one past the last member on the page
+     */
+    size_t end(size_t count) const
+    {
+        size_t first = begin(count);
+        return count - first > top ? first + top : count;
+    }
+
+    /**
+     * @brief Adds Members@odata.nextLink to a page of a collection if there
+     *        are members after it
+     *
+     * @param[in,out] json     The collection
+     * @param[in] collection  URI of the collection
+     * @param[in] count       Number of members in the whole collection
+     */
+    void addNextLink(nlohmann::json& json, const std::string& collection,
+                     size_t count) const
+    {
+        size_t next = end(count);
+        if (next < count)
+        {
+            json["Members@odata.nextLink"] =
+                collection + "?$skip=" + std::to_string(next) +
+                "&$top=" + std::to_string(top) + query;
+        }
+    }
+
+    /**
+     * @brief Fills in Members, Members@odata.count and the nextLink of a
+     *        page of a collection
+     *
+     * Only the members on the page are asked for, so a page costs the same
+     * however long the collection is.
+     *
+     * @param[in,out] json    The collection
+     * @param[in] collection  URI of the collection
+     * @param[in] count       Number of members in the whole collection
+     * @param[in] memberUri   Called with the index of each member on the
+     *                        page, returns the URI of that member
+     */
+    template <typename MemberUri>
+    void addMembers(nlohmann::json& json, const std::string& collection,
+                    size_t count, MemberUri&& memberUri) const
+    {
+        nlohmann::json& members = json["Members"];
+        members = nlohmann::json::array();
+        size_t last = end(count);
+        for (size_t i = begin(count); i < last; i++)
+        {
+            members.push_back({{"@odata.id", memberUri(i)}});
+        }
+        json["Members@odata.count"] = count;
+        addNextLink(json, collection, count);
+    }
+};
+
+} // namespace query_util
+
+} // namespace redfish
@@ -0,0 +1,93 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace redfish
+{
+
+namespace route_tree
+{
+
+// A url found one level below another
+struct SubRoute
+{
+    // Indexes into the urls given to findSubRoutes
+    size_t parent;
+    size_t child;
+    // The last segment of the child's url, which the parent links it by
+    std::string name;
+};
+
+/**
+ * @brief Finds the urls that are one level below each url
+ *
+ * A child is found from its own url, by looking up the url without its last
+ * segment, with and without a trailing slash.  This costs one lookup per
+ * url, where comparing every url against every other grew with the square
+ * of the number of nodes.  Segments starting with "$", and empty urls, are
+ * left out.
+ *
+ * @param[in] urls  The url of each node
+ *
+ * @return The links, ordered by child
+ */
+inline std::vector<SubRoute> findSubRoutes(const std::vector<std::string>& urls)
+{
+    std::unordered_map<std::string, std::vector<size_t>> byUrl;
+    for (size_t i = 0; i < urls.size(); i++)
+    {
+        if (!urls[i].empty())
+        {
+            byUrl[urls[i]].push_back(i);
+        }
+    }
+
+    std::vector<SubRoute> subRoutes;
+    for (size_t child = 0; child < urls.size(); child++)
+    {
+        std::string trimmed = urls[child];
+        if (!trimmed.empty() && trimmed.back() == '/')
+        {
+            trimmed.pop_back();
+        }
+        size_t slash = trimmed.rfind('/');
+        if (slash == std::string::npos || slash + 1 == trimmed.size() ||
+            trimmed[slash + 1] == '$')
+        {
+            continue;
+        }
+        std::string name = trimmed.substr(slash + 1);
+        for (size_t length : {slash, slash + 1})
+        {
+            auto parents = byUrl.find(trimmed.substr(0, length));
+            if (parents == byUrl.end())
+            {
+                continue;
+            }
+            for (size_t parent : parents->second)
+            {
+                subRoutes.push_back(SubRoute{parent, child, name});
+            }
+        }
+    }
+    return subRoutes;
+}
+
+} // namespace route_tree
+} // namespace redfish
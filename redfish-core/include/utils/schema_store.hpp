@@ -0,0 +1,298 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+#pragma once
+#include "utils/etag_utils.hpp"
+
+#include <crow/logging.h>
+
+#include <array>
+#include <atomic>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/container/flat_map.hpp>
+#include <boost/container/flat_set.hpp>
+#include <boost/utility/string_view.hpp>
+#include <chrono>
+#include <fstream>
+#include <gzip_helper.hpp>
+#include <iterator>
+#include <nlohmann/json.hpp>
+#include <static_asset.hpp>
+#include <string>
+#include <thread>
+
+namespace redfish
+{
+
+namespace schema_util
+{
+
+constexpr const char* jsonSchemasUrl = "/redfish/v1/JsonSchemas";
+
+// The files kept in memory, by the start of their URL
+constexpr std::array<const char*, 3> schemaPrefixes = {
+    {"/redfish/v1/JsonSchemas/", "/redfish/v1/$metadata",
+     "/redfish/v1/schema/"}};
+
+/**
+ * @brief The schema files of the web root, gzipped in memory
+ *
+ * Schema validating clients fetch every one of them, so they are read and
+ * compressed once at startup instead of opened on every request; see
+ * SchemaStoreLoader.  What is
+ * loaded never changes, and neither do the ETags made when loading it.
+ *
+ * The JsonSchemas collection is built from the JsonSchemaFile resources that
+ * were found, not read from a file, so it lists what can actually be
+ * fetched.
+ */
+class SchemaStore
+{
+  public:
+    struct File
+    {
+        std::string gzipped;
+        // Bytes once inflated
+        size_t size = 0;
+        std::string etag;
+        const char* contentType = nullptr;
+    };
+
+    /**
+     * @brief Loads the schema files among assets
+     *
+     * @param[in] root    Directory the files of assets are in
+     * @param[in] assets  What the web root holds, as the manifest says
+     *
+     * @return Files that couldn't be read or compressed, and were skipped
+     */
+    template <typename Assets>
+    size_t load(const std::string& root, const Assets& assets)
+    {
+        files.clear();
+        size_t failed = 0;
+        boost::container::flat_set<std::string> schemaFiles;
+        for (const crow::webassets::StaticAsset& asset : assets)
+        {
+            const std::string url = asset.url;
+            // A directory is listed with and without its slash; the store
+            // takes both as the same URL
+            if (url.back() == '/' || !isSchemaUrl(url))
+            {
+                continue;
+            }
+            std::ifstream stream(root + asset.file, std::ios::binary);
+            if (!stream)
+            {
+                failed++;
+                continue;
+            }
+            std::string content((std::istreambuf_iterator<char>(stream)),
+                                std::istreambuf_iterator<char>());
+            File file;
+            file.contentType = asset.contentType;
+            if (asset.contentEncoding != nullptr &&
+                std::string(asset.contentEncoding) == "gzip")
+            {
+                file.gzipped = std::move(content);
+                if (!gzipInflate(file.gzipped, content))
+                {
+                    failed++;
+                    continue;
+                }
+            }
+            else if (!gzipDeflate(content, file.gzipped, Z_BEST_COMPRESSION))
+            {
+                failed++;
+                continue;
+            }
+            file.size = content.size();
+            file.etag = etag_util::makeContentEtag(content);
+            files.emplace(url, std::move(file));
+
+            // The JsonSchemaFile resources are the index files one level
+            // down
+            if (boost::starts_with(url, schemaPrefixes[0]) &&
+                url.find('/', std::char_traits<char>::length(
+                                  schemaPrefixes[0])) == std::string::npos)
+            {
+                schemaFiles.insert(url);
+            }
+        }
+        if (!addCollection(schemaFiles))
+        {
+            failed++;
+        }
+        return failed;
+    }
+
+    /**
+     * @brief The file served at url, or nullptr
+     */
+    const File* find(boost::string_view url) const
+    {
+        while (url.size() > 1 && url.back() == '/')
+        {
+            url.remove_suffix(1);
+        }
+        auto it = files.find(std::string(url));
+        if (it == files.end())
+        {
+            return nullptr;
+        }
+        return &it->second;
+    }
+
+    size_t fileCount() const
+    {
+        return files.size();
+    }
+
+    // Memory the files take
+    size_t gzippedBytes() const
+    {
+        size_t bytes = 0;
+        for (const std::pair<std::string, File>& file : files)
+        {
+            bytes += file.second.gzipped.size();
+        }
+        return bytes;
+    }
+
+    static bool isSchemaUrl(const std::string& url)
+    {
+        for (const char* prefix : schemaPrefixes)
+        {
+            if (boost::starts_with(url, prefix))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+  private:
+    bool addCollection(
+        const boost::container::flat_set<std::string>& schemaFiles)
+    {
+        nlohmann::json collection = {
+            {"@odata.id", jsonSchemasUrl},
+            {"@odata.context", "/redfish/v1/$metadata"
+                               "#JsonSchemaFileCollection."
+                               "JsonSchemaFileCollection"},
+            {"@odata.type",
+             "#JsonSchemaFileCollection.JsonSchemaFileCollection"},
+            {"Name", "JsonSchemaFile Collection"},
+            {"Description", "Collection of JsonSchemaFiles"}};
+        nlohmann::json& members = collection["Members"];
+        members = nlohmann::json::array();
+        for (const std::string& url : schemaFiles)
+        {
+            members.push_back({{"@odata.id", url}});
+        }
+        collection["Members@odata.count"] = members.size();
+
+        const std::string content = collection.dump(2);
+        File file;
+        file.contentType = "application/json";
+        if (!gzipDeflate(content, file.gzipped, Z_BEST_COMPRESSION))
+        {
+            return false;
+        }
+        file.size = content.size();
+        file.etag = etag_util::makeContentEtag(content);
+        files.emplace(jsonSchemasUrl, std::move(file));
+        return true;
+    }
+
+    boost::container::flat_map<std::string, File> files;
+};
+
+/**
+ * @brief Loads a SchemaStore on a thread of its own
+ *
+ * Reading and compressing every schema file is most of the work startup
+ * would otherwise do before accepting connections, so it runs alongside
+ * the rest of startup and the first requests.  Until it is done, get()
+ * returns nullptr and the schemas are served from the static files they
+ * are read from.
+ */
+class SchemaStoreLoader
+{
+  public:
+    SchemaStoreLoader() = default;
+    SchemaStoreLoader(const SchemaStoreLoader&) = delete;
+    SchemaStoreLoader& operator=(const SchemaStoreLoader&) = delete;
+
+    ~SchemaStoreLoader()
+    {
+        stop();
+    }
+
+    // assets has to outlive the loading; the manifest's always does
+    template <typename Assets>
+    void start(const std::string& root, const Assets& assets)
+    {
+        stop();
+        ready = false;
+        thread = std::thread([this, root, &assets] {
+            std::chrono::steady_clock::time_point started =
+                std::chrono::steady_clock::now();
+            size_t failed = store.load(root, assets);
+            if (failed != 0)
+            {
+                BMCWEB_LOG_ERROR << failed
+                                 << " schema files could not be loaded";
+            }
+            BMCWEB_LOG_INFO
+                << "Schema store holds " << store.fileCount() << " files in "
+                << store.gzippedBytes() << " bytes, loaded in "
+                << std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::steady_clock::now() - started)
+                       .count()
+                << " ms";
+            ready.store(true, std::memory_order_release);
+        });
+    }
+
+    // Waits for a load in progress to finish
+    void stop()
+    {
+        if (thread.joinable())
+        {
+            thread.join();
+        }
+    }
+
+    // The store once loaded, nullptr until then
+    const SchemaStore* get() const
+    {
+        if (!ready.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+        return &store;
+    }
+
+  private:
+    // Only touched by the loading thread until ready is set
+    SchemaStore store;
+    std::atomic<bool> ready{false};
+    std::thread thread;
+};
+
+} // namespace schema_util
+
+} // namespace redfish
@@ -16,6 +16,8 @@
 #pragma once
 #include "node.hpp"
 
+#include <basic_auth_cache.hpp>
+#include <dbus_utility.hpp>
 #include <error_messages.hpp>
 #include <openbmc_dbus_rest.hpp>
 #include <utils/json_utils.hpp>
@@ -23,13 +25,6 @@
 namespace redfish
 {
 
-using ManagedObjectType = std::vector<std::pair<
-    sdbusplus::message::object_path,
-    boost::container::flat_map<
-        std::string,
-        boost::container::flat_map<
-            std::string, sdbusplus::message::variant<bool, std::string>>>>>;
-
 inline const char* getPrivilegeFromRoleId(boost::beast::string_view role)
 {
     if (role == "Administrator")
@@ -70,6 +65,8 @@ class AccountService : public Node
             "/redfish/v1/AccountService/Accounts";
         Node::json["Roles"]["@odata.id"] = "/redfish/v1/AccountService/Roles";
 
+        staticJson = true;
+
         entityPrivileges = {
             {boost::beast::http::verb::get,
              {{"ConfigureUsers"}, {"ConfigureManager"}}},
@@ -119,165 +116,67 @@ class AccountsCollection : public Node
     void doGet(crow::Response& res, const crow::Request& req,
                const std::vector<std::string>& params) override
     {
+        query_util::Paging paging;
+        if (!getPaging(req, res, paging))
+        {
+            return;
+        }
         res.jsonValue = Node::json;
-        auto asyncResp = std::make_shared<AsyncResp>(res);
-        crow::connections::systemBus->async_method_call(
-            [asyncResp](const boost::system::error_code ec,
-                        const ManagedObjectType& users) {
-                if (ec)
+        auto asyncResp = AsyncResp::create(res);
+        userPrivilegeStore().getUsers(
+            [asyncResp, paging](bool ok,
+                                const UserPrivilegeStore::Users& users) {
+                if (!ok)
                 {
                     asyncResp->res.result(
                         boost::beast::http::status::internal_server_error);
                     return;
                 }
-
-                nlohmann::json& memberArray =
-                    asyncResp->res.jsonValue["Members"];
-                memberArray = nlohmann::json::array();
-
-                asyncResp->res.jsonValue["Members@odata.count"] = users.size();
-                for (auto& user : users)
-                {
-                    const std::string& path =
-                        static_cast<const std::string&>(user.first);
-                    std::size_t lastIndex = path.rfind("/");
-                    if (lastIndex == std::string::npos)
-                    {
-                        lastIndex = 0;
-                    }
-                    else
-                    {
-                        lastIndex += 1;
-                    }
-                    memberArray.push_back(
-                        {{"@odata.id", "/redfish/v1/AccountService/Accounts/" +
-                                           path.substr(lastIndex)}});
-                }
-            },
-            "xyz.openbmc_project.User.Manager", "/xyz/openbmc_project/user",
-            "org.freedesktop.DBus.ObjectManager", "GetManagedObjects");
+                // The store keeps them by name
+                paging.addMembers(
+                    asyncResp->res.jsonValue,
+                    "/redfish/v1/AccountService/Accounts", users.size(),
+                    [&users](size_t i) {
+                        return "/redfish/v1/AccountService/Accounts/" +
+                               users.nth(i)->first;
+                    });
+            });
     }
     void doPost(crow::Response& res, const crow::Request& req,
                 const std::vector<std::string>& params) override
     {
-        auto asyncResp = std::make_shared<AsyncResp>(res);
-
-        nlohmann::json patchRequest;
-        if (!json_util::processJsonFromRequest(res, req, patchRequest))
+        auto asyncResp = AsyncResp::create(res);
+
+        std::string username;
+        std::string password;
+        boost::optional<std::string> roleId;
+        boost::optional<bool> enabled;
+        if (!json_util::readJson(req, res, "UserName", username, "Password",
+                                 password, "RoleId", roleId, "Enabled",
+                                 enabled))
         {
             return;
         }
 
-        const std::string* username = nullptr;
-        const std::string* password = nullptr;
         // Default to user
         std::string privilege = "priv-user";
-        // default to enabled
-        bool enabled = true;
-        for (const auto& item : patchRequest.items())
+        if (roleId)
         {
-            if (item.key() == "UserName")
-            {
-                username = item.value().get_ptr<const std::string*>();
-                if (username == nullptr)
-                {
-                    messages::addMessageToErrorJson(
-                        asyncResp->res.jsonValue,
-                        messages::propertyValueFormatError(item.value().dump(),
-                                                           item.key()));
-                    asyncResp->res.result(
-                        boost::beast::http::status::bad_request);
-                    return;
-                }
-            }
-            else if (item.key() == "Enabled")
-            {
-                const bool* enabledJson = item.value().get_ptr<const bool*>();
-                if (enabledJson == nullptr)
-                {
-                    messages::addMessageToErrorJson(
-                        asyncResp->res.jsonValue,
-                        messages::propertyValueFormatError(item.value().dump(),
-                                                           item.key()));
-                    asyncResp->res.result(
-                        boost::beast::http::status::bad_request);
-                    return;
-                }
-                enabled = *enabledJson;
-            }
-            else if (item.key() == "Password")
-            {
-                password = item.value().get_ptr<const std::string*>();
-                if (password == nullptr)
-                {
-                    messages::addMessageToErrorJson(
-                        asyncResp->res.jsonValue,
-                        messages::propertyValueFormatError(item.value().dump(),
-                                                           item.key()));
-                    asyncResp->res.result(
-                        boost::beast::http::status::bad_request);
-                    return;
-                }
-            }
-            else if (item.key() == "RoleId")
-            {
-                const std::string* roleIdJson =
-                    item.value().get_ptr<const std::string*>();
-                if (roleIdJson == nullptr)
-                {
-                    messages::addMessageToErrorJson(
-                        asyncResp->res.jsonValue,
-                        messages::propertyValueFormatError(item.value().dump(),
-                                                           item.key()));
-                    asyncResp->res.result(
-                        boost::beast::http::status::bad_request);
-                    return;
-                }
-                const char* priv = getPrivilegeFromRoleId(*roleIdJson);
-                if (priv == nullptr)
-                {
-                    messages::addMessageToErrorJson(
-                        asyncResp->res.jsonValue,
-                        messages::propertyValueNotInList(*roleIdJson,
-                                                         item.key()));
-                    asyncResp->res.result(
-                        boost::beast::http::status::bad_request);
-                    return;
-                }
-                privilege = priv;
-            }
-            else
+            const char* priv = getPrivilegeFromRoleId(*roleId);
+            if (priv == nullptr)
             {
                 messages::addMessageToErrorJson(
                     asyncResp->res.jsonValue,
-                    messages::propertyNotWritable(item.key()));
+                    messages::propertyValueNotInList(*roleId, "RoleId"));
                 asyncResp->res.result(boost::beast::http::status::bad_request);
                 return;
             }
+            privilege = priv;
         }
 
-        if (username == nullptr)
-        {
-            messages::addMessageToErrorJson(
-                asyncResp->res.jsonValue,
-                messages::createFailedMissingReqProperties("UserName"));
-            asyncResp->res.result(boost::beast::http::status::bad_request);
-            return;
-        }
-
-        if (password == nullptr)
-        {
-            messages::addMessageToErrorJson(
-                asyncResp->res.jsonValue,
-                messages::createFailedMissingReqProperties("Password"));
-            asyncResp->res.result(boost::beast::http::status::bad_request);
-            return;
-        }
-
-        crow::connections::systemBus->async_method_call(
-            [asyncResp, username{std::string(*username)},
-             password{std::string(*password)}](
-                const boost::system::error_code ec) {
+        crow::connections::tracedMethodCall(
+            [asyncResp, username,
+             password](const boost::system::error_code ec) {
                 if (ec)
                 {
                     messages::addMessageToErrorJson(
@@ -295,7 +194,7 @@ class AccountsCollection : public Node
                     // At this point we have a user that's been created, but the
                     // password set failed.  Something is wrong, so delete the
                     // user that we've already created
-                    crow::connections::systemBus->async_method_call(
+                    crow::connections::tracedMethodCall(
                         [asyncResp](const boost::system::error_code ec) {
                             if (ec)
                             {
@@ -323,29 +222,12 @@ class AccountsCollection : public Node
                     "/redfish/v1/AccountService/Accounts/" + username);
             },
             "xyz.openbmc_project.User.Manager", "/xyz/openbmc_project/user",
-            "xyz.openbmc_project.User.Manager", "CreateUser", *username,
+            "xyz.openbmc_project.User.Manager", "CreateUser", username,
             std::array<const char*, 4>{"ipmi", "redfish", "ssh", "web"},
-            privilege, enabled);
+            privilege, enabled.value_or(true));
     }
 };
 
-template <typename Callback>
-inline void checkDbusPathExists(const std::string& path, Callback&& callback)
-{
-    using GetObjectType =
-        std::vector<std::pair<std::string, std::vector<std::string>>>;
-
-    crow::connections::systemBus->async_method_call(
-        [callback{std::move(callback)}](const boost::system::error_code ec,
-                                        const GetObjectType& object_names) {
-            callback(ec || object_names.size() == 0);
-        },
-        "xyz.openbmc_project.ObjectMapper",
-        "/xyz/openbmc_project/object_mapper",
-        "xyz.openbmc_project.ObjectMapper", "GetObject", path,
-        std::array<std::string, 0>());
-}
-
 inline std::string getRoleIdFromPrivilege(boost::beast::string_view priv)
 {
     if (priv == "priv-admin")
@@ -400,7 +282,7 @@ class ManagerAccount : public Node
                const std::vector<std::string>& params) override
     {
         res.jsonValue = Node::json;
-        auto asyncResp = std::make_shared<AsyncResp>(res);
+        auto asyncResp = AsyncResp::create(res);
 
         if (params.size() != 1)
         {
@@ -408,122 +290,47 @@ class ManagerAccount : public Node
             return;
         }
 
-        crow::connections::systemBus->async_method_call(
+        userPrivilegeStore().getUsers(
             [asyncResp, accountName{std::string(params[0])}](
-                const boost::system::error_code ec,
-                const ManagedObjectType& users) {
-                if (ec)
+                bool ok, const UserPrivilegeStore::Users& users) {
+                if (!ok)
                 {
                     asyncResp->res.result(
                         boost::beast::http::status::internal_server_error);
                     return;
                 }
-
-                auto& links = asyncResp->res.jsonValue["Links"];
-                for (auto& user : users)
+                auto user = users.find(accountName);
+                if (user == users.end())
                 {
-                    const std::string& path =
-                        static_cast<const std::string&>(user.first);
-                    std::size_t lastIndex = path.rfind("/");
-                    if (lastIndex == std::string::npos)
-                    {
-                        lastIndex = 0;
-                    }
-                    else
-                    {
-                        lastIndex += 1;
-                    }
-                    if (path.substr(lastIndex) == accountName)
-                    {
-                        for (const auto& interface : user.second)
-                        {
-                            if (interface.first ==
-                                "xyz.openbmc_project.User.Attributes")
-                            {
-                                for (const auto& property : interface.second)
-                                {
-                                    if (property.first == "UserEnabled")
-                                    {
-                                        const bool* userEnabled =
-                                            mapbox::getPtr<const bool>(
-                                                property.second);
-                                        if (userEnabled == nullptr)
-                                        {
-                                            BMCWEB_LOG_ERROR
-                                                << "UserEnabled wasn't a bool";
-                                            continue;
-                                        }
-                                        asyncResp->res.jsonValue["Enabled"] =
-                                            *userEnabled;
-                                    }
-                                    else if (property.first ==
-                                             "UserLockedForFailedAttempt")
-                                    {
-                                        const bool* userLocked =
-                                            mapbox::getPtr<const bool>(
-                                                property.second);
-                                        if (userLocked == nullptr)
-                                        {
-                                            BMCWEB_LOG_ERROR
-                                                << "UserLockedForFailedAttempt "
-                                                   "wasn't a bool";
-                                            continue;
-                                        }
-                                        asyncResp->res.jsonValue["Locked"] =
-                                            *userLocked;
-                                    }
-                                    else if (property.first == "UserPrivilege")
-                                    {
-                                        const std::string* userPriv =
-                                            mapbox::getPtr<std::string>(
-                                                property.second);
-                                        if (userPriv == nullptr)
-                                        {
-                                            BMCWEB_LOG_ERROR
-                                                << "UserPrivilege wasn't a "
-                                                   "string";
-                                            continue;
-                                        }
-                                        const std::string role =
-                                            getRoleIdFromPrivilege(*userPriv);
-                                        if (role == "")
-                                        {
-                                            // workaround fix for 'root' user.
-                                            // use default instead.
-                                            continue;
-                                        }
-                                        asyncResp->res.jsonValue["RoleId"] =
-                                            role;
-                                        links = nlohmann::json::object();
-                                        links["Role"] = {
-                                            {"@odata.id",
-                                             "/redfish/v1/AccountService/"
-                                             "Roles/" + role}};
-                                    }
-                                }
-                            }
-                        }
-
-                        asyncResp->res.jsonValue["@odata.id"] =
-                            "/redfish/v1/AccountService/Accounts/" +
-                            accountName;
-                        asyncResp->res.jsonValue["Id"] = accountName;
-                        asyncResp->res.jsonValue["UserName"] = accountName;
-
-                        return;
-                    }
+                    asyncResp->res.result(
+                        boost::beast::http::status::not_found);
+                    return;
                 }
 
-                asyncResp->res.result(boost::beast::http::status::not_found);
-            },
-            "xyz.openbmc_project.User.Manager", "/xyz/openbmc_project/user",
-            "org.freedesktop.DBus.ObjectManager", "GetManagedObjects");
+                asyncResp->res.jsonValue["@odata.id"] =
+                    "/redfish/v1/AccountService/Accounts/" + accountName;
+                asyncResp->res.jsonValue["Id"] = accountName;
+                asyncResp->res.jsonValue["UserName"] = accountName;
+                asyncResp->res.jsonValue["Enabled"] = user->second.enabled;
+                asyncResp->res.jsonValue["Locked"] = user->second.locked;
+                const std::string role =
+                    getRoleIdFromPrivilege(user->second.privilege);
+                // Users without a known role, like root, show the default
+                if (!role.empty())
+                {
+                    asyncResp->res.jsonValue["RoleId"] = role;
+                    asyncResp->res.jsonValue["Links"] = {
+                        {"Role",
+                         {{"@odata.id",
+                           "/redfish/v1/AccountService/Roles/" + role}}}};
+                }
+            });
     }
 
     void doPatch(crow::Response& res, const crow::Request& req,
                  const std::vector<std::string>& params) override
     {
-        auto asyncResp = std::make_shared<AsyncResp>(res);
+        auto asyncResp = AsyncResp::create(res);
 
         if (params.size() != 1)
         {
@@ -531,19 +338,43 @@ class ManagerAccount : public Node
             return;
         }
 
-        nlohmann::json patchRequest;
-        if (!json_util::processJsonFromRequest(res, req, patchRequest))
+        boost::optional<std::string> password;
+        boost::optional<bool> enabled;
+        boost::optional<std::string> roleId;
+        boost::optional<std::string> newUserName;
+        if (!json_util::readJson(req, res, "Password", password, "Enabled",
+                                 enabled, "RoleId", roleId, "UserName",
+                                 newUserName))
         {
             return;
         }
 
+        const char* priv = nullptr;
+        if (roleId)
+        {
+            priv = getPrivilegeFromRoleId(*roleId);
+            if (priv == nullptr)
+            {
+                messages::addMessageToErrorJson(
+                    asyncResp->res.jsonValue,
+                    messages::propertyValueNotInList(*roleId, "RoleId"));
+                asyncResp->res.result(boost::beast::http::status::bad_request);
+                return;
+            }
+        }
+
         // Check the user exists before updating the fields
-        checkDbusPathExists(
-            "/xyz/openbmc_project/users/" + params[0],
-            [username{std::string(params[0])},
-             patchRequest(std::move(patchRequest)),
-             asyncResp](bool userExists) {
-                if (!userExists)
+        userPrivilegeStore().getUsers(
+            [username{std::string(params[0])}, password(std::move(password)),
+             enabled, priv, newUserName(std::move(newUserName)),
+             asyncResp](bool ok, const UserPrivilegeStore::Users& users) {
+                if (!ok)
+                {
+                    asyncResp->res.result(
+                        boost::beast::http::status::internal_server_error);
+                    return;
+                }
+                if (users.find(username) == users.end())
                 {
                     messages::addMessageToErrorJson(
                         asyncResp->res.jsonValue,
@@ -555,159 +386,64 @@ class ManagerAccount : public Node
                     return;
                 }
 
-                for (const auto& item : patchRequest.items())
-                {
-                    if (item.key() == "Password")
-                    {
-                        const std::string* passStr =
-                            item.value().get_ptr<const std::string*>();
-                        if (passStr == nullptr)
-                        {
-                            messages::addMessageToErrorJson(
-                                asyncResp->res.jsonValue,
-                                messages::propertyValueFormatError(
-                                    item.value().dump(), "Password"));
-                            return;
-                        }
-                        BMCWEB_LOG_DEBUG << "Updating user: " << username
-                                         << " to password " << *passStr;
-                        if (!pamUpdatePassword(username, *passStr))
-                        {
-                            BMCWEB_LOG_ERROR << "pamUpdatePassword Failed";
-                            asyncResp->res.result(boost::beast::http::status::
-                                                      internal_server_error);
-                            return;
-                        }
-                    }
-                    else if (item.key() == "Enabled")
+                auto setDone = [asyncResp](const boost::system::error_code ec) {
+                    if (ec)
                     {
-                        const bool* enabledBool =
-                            item.value().get_ptr<const bool*>();
-
-                        if (enabledBool == nullptr)
-                        {
-                            messages::addMessageToErrorJson(
-                                asyncResp->res.jsonValue,
-                                messages::propertyValueFormatError(
-                                    item.value().dump(), "Enabled"));
-                            return;
-                        }
-                        crow::connections::systemBus->async_method_call(
-                            [asyncResp](const boost::system::error_code ec) {
-                                if (ec)
-                                {
-                                    BMCWEB_LOG_ERROR
-                                        << "D-Bus responses error: " << ec;
-                                    asyncResp->res.result(
-                                        boost::beast::http::status::
-                                            internal_server_error);
-                                    return;
-                                }
-                                // TODO Consider support polling mechanism to
-                                // verify status of host and chassis after
-                                // execute the requested action.
-                                BMCWEB_LOG_DEBUG << "Response with no content";
-                                asyncResp->res.result(
-                                    boost::beast::http::status::no_content);
-                            },
-                            "xyz.openbmc_project.User.Manager",
-                            "/xyz/openbmc_project/user/" + username,
-                            "org.freedesktop.DBus.Properties", "Set",
-                            "xyz.openbmc_project.User.Attributes",
-                            "UserEnabled",
-                            sdbusplus::message::variant<bool>{*enabledBool});
-                    }
-                    else if (item.key() == "UserName")
-                    {
-                        const std::string* new_username =
-                            item.value().get_ptr<const std::string*>();
-
-                        if (new_username == nullptr)
-                        {
-                            messages::addMessageToErrorJson(
-                                asyncResp->res.jsonValue,
-                                messages::propertyValueFormatError(
-                                    item.value().dump(), "UserName"));
-                            return;
-                        }
-                        crow::connections::systemBus->async_method_call(
-                            [asyncResp](const boost::system::error_code ec) {
-                                if (ec)
-                                {
-                                    BMCWEB_LOG_ERROR
-                                        << "D-Bus responses error: " << ec;
-                                    asyncResp->res.result(
-                                        boost::beast::http::status::
-                                            internal_server_error);
-                                    return;
-                                }
-                                // TODO May notify user after rename.
-                                BMCWEB_LOG_DEBUG << "Response with no content";
-                                asyncResp->res.result(
-                                    boost::beast::http::status::no_content);
-                            },
-                            "xyz.openbmc_project.User.Manager",
-                            "/xyz/openbmc_project/user",
-                            "xyz.openbmc_project.User.Manager", "RenameUser",
-                            username, *new_username);
-                    }
-                    else if (item.key() == "RoleId")
-                    {
-                        const std::string* role =
-                            item.value().get_ptr<const std::string*>();
-
-                        if (role == nullptr)
-                        {
-                            messages::addMessageToErrorJson(
-                                asyncResp->res.jsonValue,
-                                messages::propertyValueFormatError(
-                                    item.value().dump(), "RoleId"));
-                            return;
-                        }
-
-                        const char* priv = getPrivilegeFromRoleId(*role);
-                        if (priv == nullptr)
-                        {
-                            messages::addMessageToErrorJson(
-                                asyncResp->res.jsonValue,
-                                messages::propertyValueNotInList(*role,
-                                                                 item.key()));
-                            asyncResp->res.result(
-                                boost::beast::http::status::bad_request);
-                            return;
-                        }
-
-                        crow::connections::systemBus->async_method_call(
-                            [asyncResp](const boost::system::error_code ec) {
-                                if (ec)
-                                {
-                                    BMCWEB_LOG_ERROR
-                                        << "D-Bus responses error: " << ec;
-                                    asyncResp->res.result(
-                                        boost::beast::http::status::
-                                            internal_server_error);
-                                    return;
-                                }
-                                BMCWEB_LOG_DEBUG << "Response with no content";
-                                asyncResp->res.result(
-                                    boost::beast::http::status::no_content);
-                            },
-                            "xyz.openbmc_project.User.Manager",
-                            "/xyz/openbmc_project/user/" + username,
-                            "org.freedesktop.DBus.Properties", "Set",
-                            "xyz.openbmc_project.User.Attributes",
-                            "UserPrivilege",
-                            sdbusplus::message::variant<std::string>{priv});
+                        BMCWEB_LOG_ERROR << "D-Bus responses error: " << ec;
+                        asyncResp->res.result(
+                            boost::beast::http::status::internal_server_error);
+                        return;
                     }
-                    else
+                    BMCWEB_LOG_DEBUG << "Response with no content";
+                    asyncResp->res.result(
+                        boost::beast::http::status::no_content);
+                };
+
+                if (enabled)
+                {
+                    crow::connections::tracedMethodCall(
+                        setDone, "xyz.openbmc_project.User.Manager",
+                        "/xyz/openbmc_project/user/" + username,
+                        "org.freedesktop.DBus.Properties", "Set",
+                        "xyz.openbmc_project.User.Attributes", "UserEnabled",
+                        sdbusplus::message::variant<bool>{*enabled});
+                }
+
+                if (password)
+                {
+                    BMCWEB_LOG_DEBUG << "Updating password of user "
+                                     << username;
+                    if (!pamUpdatePassword(username, *password))
                     {
-                        messages::addMessageToErrorJson(
-                            asyncResp->res.jsonValue,
-                            messages::propertyNotWritable(item.key()));
+                        BMCWEB_LOG_ERROR << "pamUpdatePassword Failed";
                         asyncResp->res.result(
-                            boost::beast::http::status::bad_request);
+                            boost::beast::http::status::internal_server_error);
                         return;
                     }
+                    // The old password mustn't keep working for clients
+                    // that sent it before
+                    crow::token_authorization::basicAuthCache().dropUser(
+                        username);
+                }
+
+                if (priv != nullptr)
+                {
+                    crow::connections::tracedMethodCall(
+                        setDone, "xyz.openbmc_project.User.Manager",
+                        "/xyz/openbmc_project/user/" + username,
+                        "org.freedesktop.DBus.Properties", "Set",
+                        "xyz.openbmc_project.User.Attributes", "UserPrivilege",
+                        sdbusplus::message::variant<std::string>{priv});
+                }
+
+                // TODO May notify user after rename.
+                if (newUserName)
+                {
+                    crow::connections::tracedMethodCall(
+                        setDone, "xyz.openbmc_project.User.Manager",
+                        "/xyz/openbmc_project/user",
+                        "xyz.openbmc_project.User.Manager", "RenameUser",
+                        username, *newUserName);
                 }
             });
     }
@@ -715,7 +451,7 @@ class ManagerAccount : public Node
     void doDelete(crow::Response& res, const crow::Request& req,
                   const std::vector<std::string>& params) override
     {
-        auto asyncResp = std::make_shared<AsyncResp>(res);
+        auto asyncResp = AsyncResp::create(res);
 
         if (params.size() != 1)
         {
@@ -725,7 +461,7 @@ class ManagerAccount : public Node
 
         const std::string userPath = "/xyz/openbmc_project/user/" + params[0];
 
-        crow::connections::systemBus->async_method_call(
+        crow::connections::tracedMethodCall(
             [asyncResp, username{std::move(params[0])}](
                 const boost::system::error_code ec) {
                 if (ec)
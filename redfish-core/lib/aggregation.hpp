@@ -0,0 +1,98 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+#pragma once
+
+#include "node.hpp"
+
+namespace redfish
+{
+
+/**
+ * SatelliteResource takes whatever is below an aggregated collection and
+ * has no route of its own, so resources a satellite has and this BMC
+ * doesn't can be reached.  Node sends those on to the satellite before
+ * they get here; anything else isn't there.
+ */
+class SatelliteResource : public Node
+{
+  public:
+    SatelliteResource(CrowApp& app, const std::string& collection) :
+        Node(app, collection + "/<path>", std::string())
+    {
+        entityPrivileges = {
+            {boost::beast::http::verb::get, {{"Login"}}},
+            {boost::beast::http::verb::head, {{"Login"}}},
+            {boost::beast::http::verb::patch, {{"ConfigureComponents"}}},
+            {boost::beast::http::verb::put, {{"ConfigureComponents"}}},
+            {boost::beast::http::verb::delete_, {{"ConfigureComponents"}}},
+            {boost::beast::http::verb::post, {{"ConfigureComponents"}}}};
+    }
+
+  private:
+    void doGet(crow::Response& res, const crow::Request& req,
+               const std::vector<std::string>& params) override
+    {
+        notFound(res, req);
+    }
+
+    void doPatch(crow::Response& res, const crow::Request& req,
+                 const std::vector<std::string>& params) override
+    {
+        notFound(res, req);
+    }
+
+    void doPost(crow::Response& res, const crow::Request& req,
+                const std::vector<std::string>& params) override
+    {
+        notFound(res, req);
+    }
+
+    void doDelete(crow::Response& res, const crow::Request& req,
+                  const std::vector<std::string>& params) override
+    {
+        notFound(res, req);
+    }
+
+    static void notFound(crow::Response& res, const crow::Request& req)
+    {
+        res.result(boost::beast::http::status::not_found);
+        messages::addMessageToErrorJson(
+            res.jsonValue,
+            messages::resourceNotFound("Resource", std::string(req.url)));
+        res.end();
+    }
+};
+
+/**
+ * @brief Adds the routes satellite resources without a local route of
+ *        their own are reached through.  Only needed when aggregating.
+ */
+inline void
+    addSatelliteRoutes(CrowApp& app,
+                       std::vector<std::unique_ptr<Node>>& nodes)
+{
+    if (!aggregator().enabled())
+    {
+        return;
+    }
+    for (const char* collection : aggregation_util::aggregatedCollections)
+    {
+        nodes.emplace_back(
+            std::make_unique<SatelliteResource>(app, collection));
+    }
+}
+
+} // namespace redfish
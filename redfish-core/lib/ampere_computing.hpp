@@ -34,6 +34,8 @@ class AmpereComputing : public Node
         Node::json["UploadService"] =
             {{"@odata.id", "/redfish/v1/AmpereComputing/UploadService"}};
 
+        staticJson = true;
+
         entityPrivileges = {
             {boost::beast::http::verb::get, {}},
             {boost::beast::http::verb::head, {}},
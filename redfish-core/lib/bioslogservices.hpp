@@ -18,20 +18,53 @@
 
 #include "node.hpp"
 #include "utils/ampere-utils.hpp"
+#include "utils/log_entry_index.hpp"
 
 #include <boost/container/flat_map.hpp>
+#include <dbus_utility.hpp>
 
 namespace redfish
 {
 
-using GetManagedObjectsType = boost::container::flat_map<
-    sdbusplus::message::object_path,
-    boost::container::flat_map<
-        std::string,
-        boost::container::flat_map<
-            std::string, sdbusplus::message::variant<
-                             std::string, bool, uint8_t, int16_t, uint16_t,
-                             int32_t, uint32_t, int64_t, uint64_t, double>>>>;
+using BiosEntryVariant =
+    sdbusplus::message::variant<std::string, bool, uint8_t, int16_t, uint16_t,
+                                int32_t, uint32_t, int64_t, uint64_t, double>;
+
+using BiosEntryIndex = log_util::LogEntryIndex<BiosEntryVariant>;
+
+/**
+ * @brief Fills in a LogEntry from the properties of its D-Bus entry, which
+ *        are named as the LogEntry ones
+ *
+ * @param[in] properties  Properties of the BiosLogEntry interface
+ * @param[out] json       Receives the LogEntry properties
+ */
+inline void fillBiosEntry(const BiosEntryIndex::Properties &properties,
+                          nlohmann::json &json)
+{
+    json["EntryType"] = "BIOS Event Log";
+    for (const auto &property : properties)
+    {
+        const std::string *s =
+            mapbox::getPtr<const std::string>(property.value);
+        if (s != nullptr)
+        {
+            json[*property.name] = *s;
+        }
+    }
+}
+
+/**
+ * @brief Index of the entries of the BIOS event log
+ */
+inline BiosEntryIndex &biosEntryIndex()
+{
+    static BiosEntryIndex index(
+        "xyz.openbmc_project.Inventory.Host.Manager",
+        "/xyz/openbmc_project/inventory/host",
+        "xyz.openbmc_project.Inventory.Item.BiosLogEntry", fillBiosEntry);
+    return index;
+}
 
 /**
  * BIOSLogEntry derived class for delivering Log Entry Schema.
@@ -78,10 +111,36 @@ class BIOSLogEntry : public Node
         res.jsonValue = Node::json;
         res.jsonValue["@odata.id"] =
             "/redfish/v1/Systems/1/LogServices/BIOS/Entries/" + entryId;
-        auto asyncResp = std::make_shared<AsyncResp>(res);
-        crow::connections::systemBus->async_method_call(
-            [asyncResp, entryId](const boost::system::error_code ec,
-                                 const GetManagedObjectsType &resp) {
+        auto asyncResp = AsyncResp::create(res);
+        biosEntryIndex().get(
+            [asyncResp, entryId](bool ok,
+                                 const BiosEntryIndex::Entries &entries) {
+                if (!ok)
+                {
+                    asyncResp->res.result(
+                        boost::beast::http::status::internal_server_error);
+                    return;
+                }
+                auto entry = entries.find(entryId);
+                if (entry == entries.end())
+                {
+                    asyncResp->res.clear();
+                    asyncResp->res.result(
+                        boost::beast::http::status::not_found);
+                    return;
+                }
+                getEntry(asyncResp, entryId, entry->second.path);
+            });
+    }
+
+    static void getEntry(const std::shared_ptr<AsyncResp> &asyncResp,
+                         const std::string &entryId, const std::string &path)
+    {
+        crow::connections::getAllProperties<BiosEntryVariant>(
+            [asyncResp, entryId](
+                const boost::system::error_code &ec,
+                const std::shared_ptr<const BiosEntryIndex::ManagedObjects>
+                    &reply) {
                 if (ec)
                 {
                     asyncResp->res.result(
@@ -89,46 +148,28 @@ class BIOSLogEntry : public Node
                     return;
                 }
 
-                for (auto &objectPath : resp)
+                for (const auto &property : reply->properties())
                 {
-                    for (auto &interfaceMap : objectPath.second)
+                    if (*property.name == "Id")
                     {
-                        if (interfaceMap.first !=
-                            "xyz.openbmc_project.Inventory.Item.BiosLogEntry")
+                        const uint16_t *id =
+                            mapbox::getPtr<const uint16_t>(property.value);
+                        // only assign properties if the id is matched
+                        if (id == nullptr || entryId != std::to_string(*id))
                         {
-                            BMCWEB_LOG_DEBUG << "Bailing early on "
-                                             << interfaceMap.first;
-                            continue;
-                        }
-                        for (auto &propertyMap : interfaceMap.second)
-                        {
-                            if (propertyMap.first == "Id")
-                            {
-                                const uint16_t *id =
-                                    mapbox::getPtr<const uint16_t>(
-                                        propertyMap.second);
-                                // only assign properties if the id is matched
-                                if (id == nullptr ||
-                                    entryId != std::to_string(*id))
-                                {
-                                    break;
-                                }
-                            }
-                            const std::string *s =
-                                mapbox::getPtr<const std::string>(
-                                    propertyMap.second);
-                            if (s != nullptr)
-                            {
-                                asyncResp->res.jsonValue[propertyMap.first] =
-                                    *s;
-                            }
+                            break;
                         }
                     }
+                    const std::string *s =
+                        mapbox::getPtr<const std::string>(property.value);
+                    if (s != nullptr)
+                    {
+                        asyncResp->res.jsonValue[*property.name] = *s;
+                    }
                 }
             },
-            "xyz.openbmc_project.Inventory.Host.Manager",
-            "/xyz/openbmc_project/inventory/host",
-            "org.freedesktop.DBus.ObjectManager", "GetManagedObjects");
+            "xyz.openbmc_project.Inventory.Host.Manager", path,
+            "xyz.openbmc_project.Inventory.Item.BiosLogEntry");
     }
 };
 
@@ -167,43 +208,30 @@ class BIOSLogEntryCollection : public Node
     void doGet(crow::Response &res, const crow::Request &req,
                const std::vector<std::string> &params) override
     {
+        query_util::Paging paging;
+        query_util::Filter filter;
+        if (!getPaging(req, res, paging) ||
+            !getFilter(req, res, filter, paging))
+        {
+            return;
+        }
         res.jsonValue = Node::json;
-        auto asyncResp = std::make_shared<AsyncResp>(res);
-        crow::connections::systemBus->async_method_call(
-            [asyncResp](const boost::system::error_code ec,
-                        GetManagedObjectsType &resp) {
-                if (ec)
-                {
-                    asyncResp->res.result(
-                        boost::beast::http::status::internal_server_error);
-                    return;
-                }
+        auto asyncResp = AsyncResp::create(res);
+        biosEntryIndex().get([asyncResp, paging, filter](
+                                 bool ok,
+                                 const BiosEntryIndex::Entries &entries) {
+            if (!ok)
+            {
+                asyncResp->res.result(
+                    boost::beast::http::status::internal_server_error);
+                return;
+            }
 
-                nlohmann::json &entries = asyncResp->res.jsonValue["Members"];
-                entries = nlohmann::json::array();
-                for (auto &objPath : resp)
-                {
-                    for (auto &interface : objPath.second)
-                    {
-                        if (interface.first ==
-                            "xyz.openbmc_project.Inventory.Item.BiosLogEntry")
-                        {
-                            const std::string &id = objPath.first;
-                            // Cut out everything until last "/", and put it
-                            // into output vector
-                            entries.push_back(
-                                {{"@odata.id",
-                                  "/redfish/v1/Systems/1/LogServices/BIOS/"
-                                  "Entries/" +
-                                      id.substr(id.rfind("/") + 1)}});
-                        }
-                    }
-                }
-                asyncResp->res.jsonValue["Member@odata.count"] = entries.size();
-            },
-            "xyz.openbmc_project.Inventory.Host.Manager",
-            "/xyz/openbmc_project/inventory/host",
-            "org.freedesktop.DBus.ObjectManager", "GetManagedObjects");
+            log_util::addEntryMembers(
+                asyncResp->res.jsonValue,
+                "/redfish/v1/Systems/1/LogServices/BIOS/Entries", entries,
+                paging, filter);
+        });
     }
 };
 
@@ -231,8 +259,8 @@ class BIOSLogServiceActionsClear : public Node
                 const std::vector<std::string> &params) override
     {
         BMCWEB_LOG_DEBUG << "Delete all entries.";
-        auto asyncResp = std::make_shared<AsyncResp>(res);
-        crow::connections::systemBus->async_method_call(
+        auto asyncResp = AsyncResp::create(res);
+        crow::connections::tracedMethodCall(
             [asyncResp](const boost::system::error_code ec) {
                 if (ec)
                 {
@@ -288,31 +316,31 @@ class BIOSLogService : public Node
                const std::vector<std::string> &params) override
     {
         // Get Log Service name
-        Node::json["@odata.id"] = "/redfish/v1/Systems/1/LogServices/BIOS";
+        res.jsonValue = Node::json;
+        res.jsonValue["@odata.id"] = "/redfish/v1/Systems/1/LogServices/BIOS";
 
         // TODO Logging service has not supported get MaxNumberOfRecords
         // property yet hardcode to ERROR_CAP (200) from phosphor-logging.
-        Node::json["MaxNumberOfRecords"] = 200;
-        Node::json["OverWritePolicy"] = "WrapsWhenFull";
+        res.jsonValue["MaxNumberOfRecords"] = 200;
+        res.jsonValue["OverWritePolicy"] = "WrapsWhenFull";
         std::string redfishDateTime = getCurrentDateTime("%FT%T%z");
         // insert the colon required by the ISO 8601 standard
         redfishDateTime.insert(redfishDateTime.end() - 2, ':');
-        Node::json["DateTime"] = redfishDateTime;
-        Node::json["DateTimeLocalOffset"] =
+        res.jsonValue["DateTime"] = redfishDateTime;
+        res.jsonValue["DateTimeLocalOffset"] =
             redfishDateTime.substr(redfishDateTime.length() - 6);
         // TODO hardcoded ServiceEnabled property to true
-        Node::json["ServiceEnabled"] = true;
+        res.jsonValue["ServiceEnabled"] = true;
         // TODO hardcoded Status information
-        Node::json["Status"]["State"] = "Enabled";
-        Node::json["Status"]["Health"] = "OK";
+        res.jsonValue["Status"]["State"] = "Enabled";
+        res.jsonValue["Status"]["Health"] = "OK";
 
         // Supported Actions
         nlohmann::json clearLog;
         clearLog["target"] =
             "/redfish/v1/Systems/1/LogServices/BIOS/Actions/LogService.Reset";
-        Node::json["Actions"]["#LogService.ClearLog"] = clearLog;
+        res.jsonValue["Actions"]["#LogService.ClearLog"] = clearLog;
 
-        res.jsonValue = Node::json;
         res.end();
     }
 };
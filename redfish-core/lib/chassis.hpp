@@ -18,6 +18,7 @@
 #include "node.hpp"
 
 #include <boost/container/flat_map.hpp>
+#include <dbus_utility.hpp>
 
 namespace redfish
 {
@@ -66,7 +67,7 @@ class OnDemandChassisProvider
             "xyz.openbmc_project.Inventory.Item.PowerSupply",
             "xyz.openbmc_project.Inventory.Item.System",
         };
-        crow::connections::systemBus->async_method_call(
+        crow::connections::cachedMethodCall(
             [callback{std::move(callback)}](
                 const boost::system::error_code error_code,
                 const std::vector<std::string> &resp) {
@@ -127,6 +128,19 @@ class ChassisCollection : public Node
     }
 
   private:
+    // The members only change as inventory objects come and go.  Those of
+    // satellites aren't watched, so aggregated collections aren't kept.
+    bool getCachePolicy(const std::vector<std::string> &params,
+                        CachePolicy &policy) override
+    {
+        CacheDependency inventory;
+        inventory.path = "/xyz/openbmc_project/inventory";
+        inventory.subtree = true;
+        inventory.properties = false;
+        policy.dependencies.push_back(std::move(inventory));
+        return !aggregator().enabled();
+    }
+
     /**
      * Functions triggers appropriate requests on DBus
      */
@@ -147,9 +161,12 @@ class ChassisCollection : public Node
                               "/redfish/v1/Chassis/" + chassisItem}});
                     }
                     // Then attach members, count size and return,
-                    Node::json["Members"] = chassisArray;
-                    Node::json["Members@odata.count"] = chassisArray.size();
                     res.jsonValue = Node::json;
+                    res.jsonValue["Members"] = chassisArray;
+                    res.jsonValue["Members@odata.count"] = chassisArray.size();
+                    // Adds the satellites' chassis, then ends res
+                    aggregator().appendMembers("/redfish/v1/Chassis", res);
+                    return;
                 }
                 else
                 {
@@ -208,7 +225,7 @@ class Chassis : public Node
 
         res.jsonValue = Node::json;
         const std::string &chassisId = params[0];
-        crow::connections::systemBus->async_method_call(
+        crow::connections::cachedMethodCall(
             [&res, chassisId(std::string(chassisId))](
                 const boost::system::error_code error_code,
                 const std::vector<std::pair<
@@ -248,7 +265,7 @@ class Chassis : public Node
                     }
 
                     const std::string connectionName = connectionNames[0].first;
-                    crow::connections::systemBus->async_method_call(
+                    crow::connections::coalescedMethodCall(
                         [&res, chassisId(std::string(chassisId))](
                             const boost::system::error_code error_code,
                             const std::vector<std::pair<
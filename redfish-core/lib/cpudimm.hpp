@@ -16,6 +16,8 @@
 #pragma once
 
 #include <boost/container/flat_map.hpp>
+#include <dbus_utility.hpp>
+#include <inventory_store.hpp>
 #include <node.hpp>
 #include <utils/json_utils.hpp>
 
@@ -27,290 +29,240 @@ void getResourceList(std::shared_ptr<AsyncResp> aResp, const std::string &name,
                      const std::string &collectionName)
 {
     BMCWEB_LOG_DEBUG << "Get available system cpu/mem resources.";
-    crow::connections::systemBus->async_method_call(
-        [name, subclass, aResp{std::move(aResp)}](
-            const boost::system::error_code ec,
-            const boost::container::flat_map<
-                std::string, boost::container::flat_map<
-                                 std::string, std::vector<std::string>>>
-                &subtree) {
-            if (ec)
+    inventoryStore().get([name, subclass, collectionName,
+                          aResp{std::move(aResp)}](
+                             bool ok, const InventoryStore::Objects &objects) {
+        if (!ok)
+        {
+            BMCWEB_LOG_DEBUG << "DBUS response error";
+            aResp->res.jsonValue = messages::internalError();
+            return;
+        }
+        nlohmann::json &members = aResp->res.jsonValue["Members"];
+        members = nlohmann::json::array();
+
+        for (const auto &object : objects)
+        {
+            if (object.second.find(collectionName) == object.second.end())
             {
-                BMCWEB_LOG_DEBUG << "DBUS response error";
-                aResp->res.jsonValue = messages::internalError();
-                return;
+                continue;
             }
-            nlohmann::json &members = aResp->res.jsonValue["Members"];
-            members = nlohmann::json::array();
-
-            for (const auto &object : subtree)
+            auto iter = object.first.rfind("/");
+            if ((iter != std::string::npos) && (iter < object.first.size()))
             {
-                auto iter = object.first.rfind("/");
-                if ((iter != std::string::npos) && (iter < object.first.size()))
-                {
-                    members.push_back(
-                        {{"@odata.id", "/redfish/v1/Systems/" + name + "/" +
-                                           subclass + "/" +
-                                           object.first.substr(iter + 1)}});
-                }
+                members.push_back(
+                    {{"@odata.id", "/redfish/v1/Systems/" + name + "/" +
+                                       subclass + "/" +
+                                       object.first.substr(iter + 1)}});
             }
-            aResp->res.jsonValue["Members@odata.count"] = members.size();
-        },
-        "xyz.openbmc_project.ObjectMapper",
-        "/xyz/openbmc_project/object_mapper",
-        "xyz.openbmc_project.ObjectMapper", "GetSubTree",
-        "/xyz/openbmc_project/inventory", int32_t(0),
-        std::array<const char *, 1>{collectionName.c_str()});
+        }
+        aResp->res.jsonValue["Members@odata.count"] = members.size();
+    });
 }
 
-void getCpuDataByService(std::shared_ptr<AsyncResp> aResp,
-                         const std::string &name, const std::string &cpuId,
-                         const std::string &service, const std::string &objPath)
+/**
+ * @brief Finds the inventory object implementing interface whose path ends
+ *        with id, and merges the properties of all its interfaces
+ *
+ * @return Whether the object was found
+ */
+bool findInventoryItem(const InventoryStore::Objects &objects,
+                       const std::string &interface, const std::string &id,
+                       InventoryStore::Properties &properties)
 {
-    BMCWEB_LOG_DEBUG << "Get available system cpu resources by service.";
-    crow::connections::systemBus->async_method_call(
-        [name, cpuId, aResp{std::move(aResp)}](
-            const boost::system::error_code ec,
-            const boost::container::flat_map<
-                std::string,
-                sdbusplus::message::variant<std::string, uint32_t, uint16_t>>
-                &properties) {
-            if (ec)
-            {
-                BMCWEB_LOG_DEBUG << "DBUS response error";
-                aResp->res.jsonValue = messages::internalError();
+    for (const auto &object : objects)
+    {
+        if (boost::ends_with(object.first, id) &&
+            object.second.find(interface) != object.second.end())
+        {
+            properties = InventoryStore::allProperties(object.second);
+            return true;
+        }
+    }
+    return false;
+}
 
-                return;
-            }
-            aResp->res.jsonValue["Id"] = cpuId;
-            aResp->res.jsonValue["Name"] = "Processor";
-            const auto coresCountProperty =
-                properties.find("ProcessorCoreCount");
-            if (coresCountProperty == properties.end())
-            {
-                // Important property not in result
-                aResp->res.jsonValue = messages::internalError();
-                return;
-            }
-            const uint16_t *coresCount =
-                mapbox::getPtr<const uint16_t>(coresCountProperty->second);
-            if (coresCount == nullptr)
-            {
-                // Important property not in desired type
-                aResp->res.jsonValue = messages::internalError();
-                return;
-            }
-            if (*coresCount == 0)
-            {
-                // Slot is not populated, set status end return
-                aResp->res.jsonValue["Status"]["State"] = "Absent";
-                aResp->res.jsonValue["Status"]["Health"] = "OK";
-                // HTTP Code will be set up automatically, just return
-                return;
-            }
+void fillCpuData(const std::shared_ptr<AsyncResp> &aResp,
+                 const std::string &cpuId,
+                 const InventoryStore::Properties &properties)
+{
+    aResp->res.jsonValue["Id"] = cpuId;
+    aResp->res.jsonValue["Name"] = "Processor";
+    const auto coresCountProperty = properties.find("ProcessorCoreCount");
+    if (coresCountProperty == properties.end())
+    {
+        // Important property not in result
+        aResp->res.jsonValue = messages::internalError();
+        return;
+    }
+    const uint16_t *coresCount =
+        mapbox::getPtr<const uint16_t>(coresCountProperty->second);
+    if (coresCount == nullptr)
+    {
+        // Important property not in desired type
+        aResp->res.jsonValue = messages::internalError();
+        return;
+    }
+    if (*coresCount == 0)
+    {
+        // Slot is not populated, set status end return
+        aResp->res.jsonValue["Status"]["State"] = "Absent";
+        aResp->res.jsonValue["Status"]["Health"] = "OK";
+        // HTTP Code will be set up automatically, just return
+        return;
+    }
 
-            aResp->res.jsonValue["TotalCores"] = *coresCount;
-            aResp->res.jsonValue["Status"]["State"] = "Enabled";
-            aResp->res.jsonValue["Status"]["Health"] = "OK";
+    aResp->res.jsonValue["TotalCores"] = *coresCount;
+    aResp->res.jsonValue["Status"]["State"] = "Enabled";
+    aResp->res.jsonValue["Status"]["Health"] = "OK";
 
-            for (const auto &property : properties)
+    for (const auto &property : properties)
+    {
+        if (property.first == "ProcessorType")
+        {
+            aResp->res.jsonValue["Name"] = property.second;
+        }
+        else if (property.first == "ProcessorManufacturer")
+        {
+            aResp->res.jsonValue["Manufacturer"] = property.second;
+            const std::string *value =
+                mapbox::getPtr<const std::string>(property.second);
+            if (value != nullptr)
             {
-                if (property.first == "ProcessorType")
-                {
-                    aResp->res.jsonValue["Name"] = property.second;
-                }
-                else if (property.first == "ProcessorManufacturer")
-                {
-                    aResp->res.jsonValue["Manufacturer"] = property.second;
-                    const std::string *value =
-                        mapbox::getPtr<const std::string>(property.second);
-                    if (value != nullptr)
-                    {
-                        // Otherwise would be unexpected.
-                        if (value->find("Intel") != std::string::npos)
-                        {
-                            aResp->res.jsonValue["ProcessorArchitecture"] =
-                                "x86";
-                            aResp->res.jsonValue["InstructionSet"] = "x86-64";
-                        }
-                    }
-                }
-                else if (property.first == "ProcessorMaxSpeed")
+                // Otherwise would be unexpected.
+                if (value->find("Intel") != std::string::npos)
                 {
-                    aResp->res.jsonValue["MaxSpeedMHz"] = property.second;
-                }
-                else if (property.first == "ProcessorThreadCount")
-                {
-                    aResp->res.jsonValue["TotalThreads"] = property.second;
-                }
-                else if (property.first == "ProcessorVersion")
-                {
-                    aResp->res.jsonValue["Model"] = property.second;
+                    aResp->res.jsonValue["ProcessorArchitecture"] = "x86";
+                    aResp->res.jsonValue["InstructionSet"] = "x86-64";
                 }
             }
-        },
-        service, objPath, "org.freedesktop.DBus.Properties", "GetAll", "");
+        }
+        else if (property.first == "ProcessorMaxSpeed")
+        {
+            aResp->res.jsonValue["MaxSpeedMHz"] = property.second;
+        }
+        else if (property.first == "ProcessorThreadCount")
+        {
+            aResp->res.jsonValue["TotalThreads"] = property.second;
+        }
+        else if (property.first == "ProcessorVersion")
+        {
+            aResp->res.jsonValue["Model"] = property.second;
+        }
+    }
 }
 
 void getCpuData(std::shared_ptr<AsyncResp> aResp, const std::string &name,
                 const std::string &cpuId)
 {
     BMCWEB_LOG_DEBUG << "Get available system cpu resources.";
-    crow::connections::systemBus->async_method_call(
-        [name, cpuId, aResp{std::move(aResp)}](
-            const boost::system::error_code ec,
-            const boost::container::flat_map<
-                std::string, boost::container::flat_map<
-                                 std::string, std::vector<std::string>>>
-                &subtree) {
-            if (ec)
-            {
-                BMCWEB_LOG_DEBUG << "DBUS response error";
-                aResp->res.jsonValue = messages::internalError();
-                return;
-            }
-            for (const auto &object : subtree)
-            {
-                if (boost::ends_with(object.first, cpuId))
-                {
-                    for (const auto &service : object.second)
-                    {
-                        getCpuDataByService(aResp, name, cpuId, service.first,
-                                            object.first);
-                        return;
-                    }
-                }
-            }
+    inventoryStore().get([cpuId, aResp{std::move(aResp)}](
+                             bool ok, const InventoryStore::Objects &objects) {
+        if (!ok)
+        {
+            BMCWEB_LOG_DEBUG << "DBUS response error";
+            aResp->res.jsonValue = messages::internalError();
+            return;
+        }
+        InventoryStore::Properties properties;
+        if (!findInventoryItem(objects,
+                               "xyz.openbmc_project.Inventory.Item.Cpu", cpuId,
+                               properties))
+        {
             // Object not found
             messages::resourceNotFound("Processor", cpuId);
             return;
-        },
-        "xyz.openbmc_project.ObjectMapper",
-        "/xyz/openbmc_project/object_mapper",
-        "xyz.openbmc_project.ObjectMapper", "GetSubTree",
-        "/xyz/openbmc_project/inventory", int32_t(0),
-        std::array<const char *, 1>{"xyz.openbmc_project.Inventory.Item.Cpu"});
+        }
+        fillCpuData(aResp, cpuId, properties);
+    });
 };
 
-void getDimmDataByService(std::shared_ptr<AsyncResp> aResp,
-                          const std::string &name, const std::string &dimmId,
-                          const std::string &service,
-                          const std::string &objPath)
+void fillDimmData(const std::shared_ptr<AsyncResp> &aResp,
+                  const std::string &dimmId,
+                  const InventoryStore::Properties &properties)
 {
-    BMCWEB_LOG_DEBUG << "Get available system components.";
-    crow::connections::systemBus->async_method_call(
-        [name, dimmId, aResp{std::move(aResp)}](
-            const boost::system::error_code ec,
-            const boost::container::flat_map<
-                std::string,
-                sdbusplus::message::variant<std::string, uint32_t, uint16_t>>
-                &properties) {
-            if (ec)
-            {
-                BMCWEB_LOG_DEBUG << "DBUS response error";
-                aResp->res.jsonValue = messages::internalError();
+    aResp->res.jsonValue["Id"] = dimmId;
+    aResp->res.jsonValue["Name"] = "DIMM Slot";
 
-                return;
-            }
-            aResp->res.jsonValue["Id"] = dimmId;
-            aResp->res.jsonValue["Name"] = "DIMM Slot";
-
-            const auto memorySizeProperty = properties.find("MemorySizeInKB");
-            if (memorySizeProperty == properties.end())
-            {
-                // Important property not in result
-                aResp->res.jsonValue = messages::internalError();
+    const auto memorySizeProperty = properties.find("MemorySizeInKB");
+    if (memorySizeProperty == properties.end())
+    {
+        // Important property not in result
+        aResp->res.jsonValue = messages::internalError();
 
-                return;
-            }
-            const uint32_t *memorySize =
-                mapbox::getPtr<const uint32_t>(memorySizeProperty->second);
-            if (memorySize == nullptr)
-            {
-                // Important property not in desired type
-                aResp->res.jsonValue = messages::internalError();
+        return;
+    }
+    const uint32_t *memorySize =
+        mapbox::getPtr<const uint32_t>(memorySizeProperty->second);
+    if (memorySize == nullptr)
+    {
+        // Important property not in desired type
+        aResp->res.jsonValue = messages::internalError();
 
-                return;
-            }
-            if (*memorySize == 0)
-            {
-                // Slot is not populated, set status end return
-                aResp->res.jsonValue["Status"]["State"] = "Absent";
-                aResp->res.jsonValue["Status"]["Health"] = "OK";
-                // HTTP Code will be set up automatically, just return
-                return;
-            }
-            aResp->res.jsonValue["CapacityMiB"] = (*memorySize >> 10);
-            aResp->res.jsonValue["Status"]["State"] = "Enabled";
-            aResp->res.jsonValue["Status"]["Health"] = "OK";
+        return;
+    }
+    if (*memorySize == 0)
+    {
+        // Slot is not populated, set status end return
+        aResp->res.jsonValue["Status"]["State"] = "Absent";
+        aResp->res.jsonValue["Status"]["Health"] = "OK";
+        // HTTP Code will be set up automatically, just return
+        return;
+    }
+    aResp->res.jsonValue["CapacityMiB"] = (*memorySize >> 10);
+    aResp->res.jsonValue["Status"]["State"] = "Enabled";
+    aResp->res.jsonValue["Status"]["Health"] = "OK";
 
-            for (const auto &property : properties)
+    for (const auto &property : properties)
+    {
+        if (property.first == "MemoryDataWidth")
+        {
+            aResp->res.jsonValue["DataWidthBits"] = property.second;
+        }
+        else if (property.first == "MemoryBusWidth")
+        {
+            aResp->res.jsonValue["BusWidthBits"] = property.second;
+        }
+        else if (property.first == "MemoryType")
+        {
+            const auto *value =
+                mapbox::getPtr<const std::string>(property.second);
+            if (value != nullptr)
             {
-                if (property.first == "MemoryDataWidth")
-                {
-                    aResp->res.jsonValue["DataWidthBits"] = property.second;
-                }
-                else if (property.first == "MemoryBusWidth")
+                aResp->res.jsonValue["MemoryDeviceType"] = *value;
+                if (boost::starts_with(*value, "DDR"))
                 {
-                    aResp->res.jsonValue["BusWidthBits"] = property.second;
-                }
-                else if (property.first == "MemoryType")
-                {
-                    const auto *value =
-                        mapbox::getPtr<const std::string>(property.second);
-                    if (value != nullptr)
-                    {
-                        aResp->res.jsonValue["MemoryDeviceType"] = *value;
-                        if (boost::starts_with(*value, "DDR"))
-                        {
-                            aResp->res.jsonValue["MemoryType"] = "DRAM";
-                        }
-                    }
+                    aResp->res.jsonValue["MemoryType"] = "DRAM";
                 }
             }
-        },
-        service, objPath, "org.freedesktop.DBus.Properties", "GetAll", "");
+        }
+    }
 }
 
 void getDimmData(std::shared_ptr<AsyncResp> aResp, const std::string &name,
                  const std::string &dimmId)
 {
     BMCWEB_LOG_DEBUG << "Get available system dimm resources.";
-    crow::connections::systemBus->async_method_call(
-        [name, dimmId, aResp{std::move(aResp)}](
-            const boost::system::error_code ec,
-            const boost::container::flat_map<
-                std::string, boost::container::flat_map<
-                                 std::string, std::vector<std::string>>>
-                &subtree) {
-            if (ec)
-            {
-                BMCWEB_LOG_DEBUG << "DBUS response error";
-                aResp->res.jsonValue = messages::internalError();
+    inventoryStore().get([dimmId, aResp{std::move(aResp)}](
+                             bool ok, const InventoryStore::Objects &objects) {
+        if (!ok)
+        {
+            BMCWEB_LOG_DEBUG << "DBUS response error";
+            aResp->res.jsonValue = messages::internalError();
 
-                return;
-            }
-            for (const auto &object : subtree)
-            {
-                if (boost::ends_with(object.first, dimmId))
-                {
-                    for (const auto &service : object.second)
-                    {
-                        getDimmDataByService(aResp, name, dimmId, service.first,
-                                             object.first);
-                        return;
-                    }
-                }
-            }
+            return;
+        }
+        InventoryStore::Properties properties;
+        if (!findInventoryItem(objects,
+                               "xyz.openbmc_project.Inventory.Item.Dimm",
+                               dimmId, properties))
+        {
             // Object not found
             messages::resourceNotFound("Memory", dimmId);
             return;
-        },
-        "xyz.openbmc_project.ObjectMapper",
-        "/xyz/openbmc_project/object_mapper",
-        "xyz.openbmc_project.ObjectMapper", "GetSubTree",
-        "/xyz/openbmc_project/inventory", int32_t(0),
-        std::array<const char *, 1>{"xyz.openbmc_project.Inventory.Item.Dimm"});
+        }
+        fillDimmData(aResp, dimmId, properties);
+    });
 };
 
 class ProcessorCollection : public Node
@@ -356,7 +308,7 @@ class ProcessorCollection : public Node
         res.jsonValue = Node::json;
         res.jsonValue["@odata.id"] =
             "/redfish/v1/Systems/" + name + "/Processors/";
-        auto asyncResp = std::make_shared<AsyncResp>(res);
+        auto asyncResp = AsyncResp::create(res);
 
         getResourceList(asyncResp, name, "Processors",
                         "xyz.openbmc_project.Inventory.Item.Cpu");
@@ -409,7 +361,7 @@ class Processor : public Node
         res.jsonValue["@odata.id"] =
             "/redfish/v1/Systems/" + name + "/Processors/" + cpuId;
 
-        auto asyncResp = std::make_shared<AsyncResp>(res);
+        auto asyncResp = AsyncResp::create(res);
 
         getCpuData(asyncResp, name, cpuId);
     }
@@ -458,7 +410,7 @@ class MemoryCollection : public Node
 
         res.jsonValue = Node::json;
         res.jsonValue["@odata.id"] = "/redfish/v1/Systems/" + name + "/Memory/";
-        auto asyncResp = std::make_shared<AsyncResp>(res);
+        auto asyncResp = AsyncResp::create(res);
 
         getResourceList(asyncResp, name, "Memory",
                         "xyz.openbmc_project.Inventory.Item.Dimm");
@@ -508,7 +460,7 @@ class Memory : public Node
         res.jsonValue = Node::json;
         res.jsonValue["@odata.id"] =
             "/redfish/v1/Systems/" + name + "/Memory/" + dimmId;
-        auto asyncResp = std::make_shared<AsyncResp>(res);
+        auto asyncResp = AsyncResp::create(res);
 
         getDimmData(asyncResp, name, dimmId);
     }
@@ -18,8 +18,12 @@
 
 #include <boost/container/flat_map.hpp>
 #include <dbus_singleton.hpp>
+#include <dbus_utility.hpp>
 #include <error_messages.hpp>
+#include <functional>
+#include <memory>
 #include <node.hpp>
+#include <signal_store.hpp>
 // TODO: remove this when find a better way to retrieve domain name.
 #include <utils/ampere-utils.hpp>
 #include <utils/json_utils.hpp>
@@ -106,10 +110,129 @@ inline bool is_xdigit(const unsigned char &character)
                : false;
 }
 
+/**
+ * @brief The objects of the network daemon, kept in memory
+ *
+ * Loaded with one GetManagedObjects on first use, then kept current from
+ * the signals the SignalDispatcher passes on: PropertiesChanged updates
+ * values in place, while addresses or interfaces coming and going, or the
+ * daemon restarting, drop the snapshot so the next request reloads it.
+ * EthernetInterface GETs are served from it without a D-Bus call.
+ */
+class NetworkSnapshot
+{
+  public:
+    NetworkSnapshot() :
+        store(listener(), [this](uint64_t generation) { load(generation); })
+    {
+    }
+
+    /**
+     * @brief Calls back with whether the objects could be read, and the
+     *        objects.  The reference is only good during the call.
+     */
+    template <typename Handler> void get(Handler &&callback)
+    {
+        store.get(std::forward<Handler>(callback));
+    }
+
+    void invalidate()
+    {
+        store.invalidate();
+    }
+
+    // Unsubscribes from the signal dispatcher
+    void stop()
+    {
+        store.stop();
+    }
+
+  private:
+    static bool isNetwork(const std::string &path)
+    {
+        return boost::starts_with(path, "/xyz/openbmc_project/network/");
+    }
+
+    crow::connections::SignalDispatcher::Listener listener()
+    {
+        crow::connections::SignalDispatcher::Listener listener;
+        listener.propertyValues = [this](const std::string &path,
+                                         const std::string &,
+                                         sdbusplus::message::message
+                                             &message) {
+            if (isNetwork(path))
+            {
+                std::string interface;
+                PropertiesMapType values;
+                message.read(interface, values);
+                update(path, interface, values);
+            }
+        };
+        listener.objectChanged = [this](const std::string &path) {
+            if (isNetwork(path))
+            {
+                invalidate();
+            }
+        };
+        listener.serviceChanged = [this](const std::string &name) {
+            if (name == "xyz.openbmc_project.Network")
+            {
+                invalidate();
+            }
+        };
+        return listener;
+    }
+
+    void update(const std::string &path, const std::string &interface,
+                const PropertiesMapType &values)
+    {
+        GetManagedObjectsType &objects = store.data();
+        auto object = objects.find(path);
+        if (object == objects.end())
+        {
+            return;
+        }
+        PropertiesMapType &properties = object->second[interface];
+        for (const auto &value : values)
+        {
+            properties[value.first] = value.second;
+        }
+    }
+
+    void load(uint64_t loadGeneration)
+    {
+        BMCWEB_LOG_DEBUG << "Loading network snapshot";
+        crow::connections::coalescedMethodCall(
+            [this, loadGeneration](const boost::system::error_code ec,
+                                   const GetManagedObjectsType &resp) {
+                if (ec)
+                {
+                    BMCWEB_LOG_ERROR << "GetManagedObjects failed: " << ec;
+                }
+                else
+                {
+                    store.data() = resp;
+                }
+                store.finish(!ec, loadGeneration);
+            },
+            "xyz.openbmc_project.Network", "/xyz/openbmc_project/network",
+            "org.freedesktop.DBus.ObjectManager", "GetManagedObjects");
+    }
+
+    crow::connections::SignalStore<GetManagedObjectsType> store;
+};
+
+inline NetworkSnapshot &networkSnapshot()
+{
+    static NetworkSnapshot snapshot;
+    return snapshot;
+}
+
 /**
  * OnDemandEthernetProvider
  * Ethernet provider class that retrieves data directly from dbus, before
- * setting it into JSON output. This does not cache any data.
+ * setting it into JSON output. Reads come from
+ * the NetworkSnapshot.
  *
  * TODO(Pawel)
  * This perhaps shall be different file, which has to be chosen on compile time
@@ -385,7 +508,7 @@ class OnDemandEthernetProvider
     void createVlan(const std::string &ifaceId, const uint64_t &inputVlanId,
                     CallbackFunc &&callback)
     {
-        crow::connections::systemBus->async_method_call(
+        crow::connections::tracedMethodCall(
             callback, "xyz.openbmc_project.Network",
             "/xyz/openbmc_project/network",
             "xyz.openbmc_project.Network.VLAN.Create", "VLAN", ifaceId,
@@ -406,7 +529,7 @@ class OnDemandEthernetProvider
                              const uint32_t &inputVlanId,
                              CallbackFunc &&callback)
     {
-        crow::connections::systemBus->async_method_call(
+        crow::connections::tracedMethodCall(
             callback, "xyz.openbmc_project.Network",
             std::string("/xyz/openbmc_project/network/") + ifaceId,
             "org.freedesktop.DBus.Properties", "Set",
@@ -541,7 +664,7 @@ class OnDemandEthernetProvider
             }
         };
 
-        crow::connections::systemBus->async_method_call(
+        crow::connections::tracedMethodCall(
             std::move(callback), "xyz.openbmc_project.Network",
             "/xyz/openbmc_project/network/" + ifaceId + "/ipv4/" + ipHash,
             "org.freedesktop.DBus.Properties", "Set",
@@ -587,7 +710,7 @@ class OnDemandEthernetProvider
             }
         };
 
-        crow::connections::systemBus->async_method_call(
+        crow::connections::tracedMethodCall(
             std::move(callback), "xyz.openbmc_project.Network",
             "/xyz/openbmc_project/network/" + ifaceId + "/ipv4/" + ipHash,
             "org.freedesktop.DBus.Properties", "Set",
@@ -629,7 +752,7 @@ class OnDemandEthernetProvider
             }
         };
 
-        crow::connections::systemBus->async_method_call(
+        crow::connections::tracedMethodCall(
             std::move(callback), "xyz.openbmc_project.Network",
             "/xyz/openbmc_project/network/" + ifaceId + "/ipv4/" + ipHash,
             "org.freedesktop.DBus.Properties", "Set",
@@ -648,7 +771,7 @@ class OnDemandEthernetProvider
     template <typename CallbackFunc>
     static void disableVlan(const std::string &ifaceId, CallbackFunc &&callback)
     {
-        crow::connections::systemBus->async_method_call(
+        crow::connections::tracedMethodCall(
             callback, "xyz.openbmc_project.Network",
             std::string("/xyz/openbmc_project/network/") + ifaceId,
             "xyz.openbmc_project.Object.Delete", "Delete");
@@ -665,7 +788,7 @@ class OnDemandEthernetProvider
     template <typename CallbackFunc>
     void setHostName(const std::string &newHostname, CallbackFunc &&callback)
     {
-        crow::connections::systemBus->async_method_call(
+        crow::connections::tracedMethodCall(
             callback, "xyz.openbmc_project.Network",
             "/xyz/openbmc_project/network/config",
             "org.freedesktop.DBus.Properties", "Set",
@@ -687,7 +810,7 @@ class OnDemandEthernetProvider
                     unsigned int ipIdx,
                     const std::shared_ptr<AsyncResp> &asyncResp)
     {
-        crow::connections::systemBus->async_method_call(
+        crow::connections::tracedMethodCall(
             [ipIdx{std::move(ipIdx)}, asyncResp{std::move(asyncResp)}](
                 const boost::system::error_code ec) {
                 if (ec)
@@ -746,7 +869,7 @@ class OnDemandEthernetProvider
                 }
             };
 
-        crow::connections::systemBus->async_method_call(
+        crow::connections::tracedMethodCall(
             std::move(createIpHandler),
             "xyz.openbmc_project.Network",
             "/xyz/openbmc_project/network/" + ifaceId,
@@ -821,19 +944,18 @@ class OnDemandEthernetProvider
     void getEthernetIfaceData(const std::string &ethifaceId,
                               CallbackFunc &&callback)
     {
-        crow::connections::systemBus->async_method_call(
+        networkSnapshot().get(
             [this, ethifaceId{std::move(ethifaceId)},
              callback{std::move(callback)}](
-                const boost::system::error_code error_code,
-                const GetManagedObjectsType &resp) {
+                bool ok, const GetManagedObjectsType &resp) {
                 EthernetInterfaceData ethData{};
                 std::vector<IPv4AddressData> ipv4Data;
                 ipv4Data.reserve(maxIpV4AddressesPerInterface);
                 std::vector<IPv6AddressData> ipv6Data;
 
-                if (error_code)
+                if (!ok)
                 {
-                    // Something wrong on DBus, the error_code is not important
+                    // Something wrong on DBus, the error is not important
                     // at this moment, just return success=false, and empty
                     // output. Since size of vector may vary depending on
                     // information from Network Manager, and empty output could
@@ -867,9 +989,7 @@ class OnDemandEthernetProvider
 
                 // Finally make a callback with useful data
                 callback(true, ethData, ipv4Data, ipv6Data);
-            },
-            "xyz.openbmc_project.Network", "/xyz/openbmc_project/network",
-            "org.freedesktop.DBus.ObjectManager", "GetManagedObjects");
+            });
     };
 
     /**
@@ -881,17 +1001,16 @@ class OnDemandEthernetProvider
     template <typename CallbackFunc>
     void getEthernetIfaceList(CallbackFunc &&callback)
     {
-        crow::connections::systemBus->async_method_call(
+        networkSnapshot().get(
             [this, callback{std::move(callback)}](
-                const boost::system::error_code error_code,
-                GetManagedObjectsType &resp) {
+                bool ok, const GetManagedObjectsType &resp) {
                 // Callback requires vector<string> to retrieve all available
                 // ethernet interfaces
                 std::vector<std::string> ifaceList;
                 ifaceList.reserve(resp.size());
-                if (error_code)
+                if (!ok)
                 {
-                    // Something wrong on DBus, the error_code is not important
+                    // Something wrong on DBus, the error is not important
                     // at this moment, just return success=false, and empty
                     // output. Since size of vector may vary depending on
                     // information from Network Manager, and empty output could
@@ -927,9 +1046,7 @@ class OnDemandEthernetProvider
                 }
                 // Finally make a callback with useful data
                 callback(true, ifaceList);
-            },
-            "xyz.openbmc_project.Network", "/xyz/openbmc_project/network",
-            "org.freedesktop.DBus.ObjectManager", "GetManagedObjects");
+            });
     };
 };
 
@@ -992,11 +1109,12 @@ class EthernetCollection : public Node
                                                "/EthernetInterfaces/" +
                                                ifaceItem}});
                     }
-                    Node::json["Members"] = ifaceArray;
-                    Node::json["Members@odata.count"] = ifaceArray.size();
-                    Node::json["@odata.id"] = "/redfish/v1/Managers/" +
-                                              managerId + "/EthernetInterfaces";
                     res.jsonValue = Node::json;
+                    res.jsonValue["Members"] = ifaceArray;
+                    res.jsonValue["Members@odata.count"] = ifaceArray.size();
+                    res.jsonValue["@odata.id"] = "/redfish/v1/Managers/" +
+                                                 managerId +
+                                                 "/EthernetInterfaces";
                 }
                 else
                 {
@@ -1188,7 +1306,7 @@ class EthernetInterface : public Node
             }
         };
 
-        crow::connections::systemBus->async_method_call(
+        crow::connections::tracedMethodCall(
             std::move(handler), "xyz.openbmc_project.Network",
             "/xyz/openbmc_project/network/" + ifaceId,
             "org.freedesktop.DBus.Properties", "Set",
@@ -1232,121 +1350,63 @@ class EthernetInterface : public Node
         }
     }
 
-    void doSetMacAddress(const std::string &property_value, crow::Response &res,
-                         const crow::Request &req,
-                         const std::vector<std::string> &params)
+    void doSetMacAddress(const std::string &ifaceId,
+                         const std::string &propertyValue,
+                         const std::shared_ptr<AsyncResp> &asyncResp)
     {
-        // TODO: Refactor this function to be consistent with other similar
-        //       functions (eg: changeIPv4AddressProperty)
-        const std::string iface_id = params[0];
-        const std::string &base_object_path = "/xyz/openbmc_project/network";
-        const std::string &main_object_path =
-            "/xyz/openbmc_project/network/" + iface_id;
-        const std::string &process_name = "xyz.openbmc_project.Network";
-        std::string dest_property = "MACAddress";
-        auto asyncResp = std::make_shared<AsyncResp>(res);
-
         // Validate MACAddress value.
-        if (!isValidMacAddress(property_value))
+        if (!isValidMacAddress(propertyValue))
         {
             BMCWEB_LOG_ERROR << "Incorrect MACAddress value: not local address";
             asyncResp->res.result(boost::beast::http::status::bad_request);
             return;
         }
 
-        // List all interface of base_object_path.
-        crow::connections::systemBus->async_method_call(
-            [&, main_object_path, process_name,
-             dest_property{std::move(dest_property)},
-             property_value](const boost::system::error_code error_code,
-                             const GetManagedObjectsType &resp) {
-                if (error_code)
-                {
-                    BMCWEB_LOG_ERROR << "Internal Error";
-                    asyncResp->res.result(
-                        boost::beast::http::status::internal_server_error);
-                    return;
-                }
+        // Every interface of the object carrying a MACAddress gets the new
+        // one; the writes are independent, so they are all issued at once
+        networkSnapshot().get([ifaceId, propertyValue, asyncResp](
+                                  bool ok, const GetManagedObjectsType &resp) {
+            if (!ok)
+            {
+                BMCWEB_LOG_ERROR << "Internal Error";
+                asyncResp->res.result(
+                    boost::beast::http::status::internal_server_error);
+                return;
+            }
 
-                const auto &objpath = resp.find(
-                    sdbusplus::message::object_path{main_object_path});
-                if (objpath != resp.end())
+            const auto objpath =
+                resp.find("/xyz/openbmc_project/network/" + ifaceId);
+            if (objpath == resp.end())
+            {
+                return;
+            }
+            for (const auto &interface : objpath->second)
+            {
+                if (interface.first.find("xyz.openbmc_project.Network") ==
+                        std::string::npos ||
+                    interface.second.find("MACAddress") ==
+                        interface.second.end())
                 {
-                    // Iterate for all interfaces available for specified
-                    // ObjectPath.
-                    for (auto &interface : objpath->second)
-                    {
-                        if (interface.first.find(process_name) !=
-                            std::string::npos)
+                    continue;
+                }
+                crow::connections::tracedMethodCall(
+                    [asyncResp](const boost::system::error_code ec) {
+                        if (ec)
                         {
-                            crow::connections::systemBus->async_method_call(
-                                [&, main_object_path, process_name,
-                                 interface{std::move(interface)},
-                                 dest_property{std::move(dest_property)},
-                                 property_value](
-                                    const boost::system::error_code ec,
-                                    const PropertiesMapType &properties) {
-                                    if (ec)
-                                    {
-                                        BMCWEB_LOG_ERROR
-                                            << "Bad D-Bus request error: "
-                                            << ec;
-                                        asyncResp->res.result(
-                                            boost::beast::http::status::
-                                                internal_server_error);
-                                        return;
-                                    }
-                                    else
-                                    {
-                                        auto it =
-                                            properties.find(dest_property);
-                                        if (it != properties.end())
-                                        {
-                                            // Create the D-Bus variant for
-                                            // D-Bus call.
-                                            crow::connections::systemBus
-                                                ->async_method_call(
-                                                    [&](const boost::system::
-                                                            error_code ec) {
-                                                        // Use "Set" method to
-                                                        // set the property
-                                                        // value.
-                                                        if (ec)
-                                                        {
-                                                            BMCWEB_LOG_ERROR
-                                                                << "Bad D-Bus "
-                                                                   "request "
-                                                                   "error: "
-                                                                << ec;
-                                                            asyncResp->res.result(
-                                                                boost::beast::
-                                                                    http::status::
-                                                                        internal_server_error);
-                                                            return;
-                                                        }
-                                                    },
-                                                    process_name,
-                                                    main_object_path,
-                                                    "org.freedesktop.DBus."
-                                                    "Properties",
-                                                    "Set", interface.first,
-                                                    dest_property,
-                                                    sdbusplus::message::variant<
-                                                        std::string>{
-                                                        property_value});
-                                        }
-                                    }
-                                },
-                                process_name, main_object_path,
-                                "org.freedesktop.DBus.Properties", "GetAll",
-                                interface.first);
+                            BMCWEB_LOG_ERROR << "Bad D-Bus request error: "
+                                             << ec;
+                            asyncResp->res.result(
+                                boost::beast::http::status::
+                                    internal_server_error);
                         }
-                    }
-                }
-            },
-            process_name, base_object_path,
-            "org.freedesktop.DBus.ObjectManager", "GetManagedObjects");
-        asyncResp->res.jsonValue = Node::json;
+                    },
+                    "xyz.openbmc_project.Network",
+                    "/xyz/openbmc_project/network/" + ifaceId,
+                    "org.freedesktop.DBus.Properties", "Set", interface.first,
+                    "MACAddress",
+                    sdbusplus::message::variant<std::string>{propertyValue});
+            }
+        });
     }
 
     bool isValidMacAddress(const std::string &mac_address)
@@ -1767,8 +1827,7 @@ class EthernetInterface : public Node
 
                 res.jsonValue = parseInterfaceData(ifaceId, ethData, ipv4Data,ipv6Data);
 
-                std::shared_ptr<AsyncResp> asyncResp =
-                    std::make_shared<AsyncResp>(res);
+                std::shared_ptr<AsyncResp> asyncResp = AsyncResp::create(res);
 
                 for (auto propertyIt = patchReq.begin();
                      propertyIt != patchReq.end(); ++propertyIt)
@@ -1790,8 +1849,9 @@ class EthernetInterface : public Node
                     }
                     else if (propertyIt.key() == "MacAddress")
                     {
-                        doSetMacAddress(propertyIt->get<const std::string>(),
-                                        asyncResp->res, req, params);
+                        doSetMacAddress(ifaceId,
+                                        propertyIt->get<const std::string>(),
+                                        asyncResp);
                     }
                     else if (propertyIt.key() == "IPv4Addresses")
                     {
@@ -2014,8 +2074,7 @@ class VlanNetworkInterface : public Node
                 res.jsonValue = parseInterfaceData(parentIfaceId, ifaceId,
                                                    ethData, ipv4Data, ipv6Data);
 
-                std::shared_ptr<AsyncResp> asyncResp =
-                    std::make_shared<AsyncResp>(res);
+                std::shared_ptr<AsyncResp> asyncResp = AsyncResp::create(res);
 
                 for (auto propertyIt = patchReq.begin();
                      propertyIt != patchReq.end(); ++propertyIt)
@@ -2206,13 +2265,15 @@ class VlanNetworkInterfaceCollection : public Node
 
                     if (rootInterfaceFound)
                     {
-                        Node::json["Members"] = ifaceArray;
-                        Node::json["Members@odata.count"] = ifaceArray.size();
-                        Node::json["@odata.id"] = "/redfish/v1/Managers/" +
-                                                  managerId +
-                                                  "/EthernetInterfaces/" +
-                                                  rootInterfaceName + "/VLANs";
                         res.jsonValue = Node::json;
+                        res.jsonValue["Members"] = ifaceArray;
+                        res.jsonValue["Members@odata.count"] =
+                            ifaceArray.size();
+                        res.jsonValue["@odata.id"] = "/redfish/v1/Managers/" +
+                                                     managerId +
+                                                     "/EthernetInterfaces/" +
+                                                     rootInterfaceName +
+                                                     "/VLANs";
                     }
                     else
                     {
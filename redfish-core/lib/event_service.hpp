@@ -0,0 +1,648 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+#pragma once
+
+#include "node.hpp"
+#include "utils/ampere-utils.hpp"
+#include "utils/event_utils.hpp"
+#include "utils/log_entry_index.hpp"
+
+#include <boost/asio/steady_timer.hpp>
+#include <boost/container/flat_map.hpp>
+#include <chrono>
+#include <dbus_singleton.hpp>
+#include <memory>
+#include <sdbusplus/bus/match.hpp>
+
+namespace redfish
+{
+
+// Event streams open at once.  Each holds a request in flight for as long
+// as it's open, so only a few are allowed.
+constexpr size_t maxEventStreams = 4;
+// An idle stream sends a comment this often, so a client that went away is
+// noticed and its stream closed
+constexpr std::chrono::seconds eventStreamKeepAlive{30};
+
+class EventDispatcher;
+EventDispatcher &eventDispatcher();
+
+/**
+ * @brief One client reading events from the ServerSentEventUri
+ *
+ * The response body is generated from it: each time the connection wants
+ * more, the queued events are sent, or if there are none, the request waits
+ * until one is pushed or the keep-alive comes due.
+ */
+class EventStream : public std::enable_shared_from_this<EventStream>
+{
+  public:
+    EventStream(uint64_t id, event_util::EventFilter filter,
+                boost::asio::io_service &io) :
+        id(id),
+        filter(std::move(filter)), keepAliveTimer(io)
+    {
+    }
+
+    ~EventStream();
+
+    void push(const std::string &key,
+              const event_util::EventQueue::Event &event)
+    {
+        queue.push(key, event);
+        if (pending)
+        {
+            keepAliveTimer.cancel();
+            send(queue.takeAll(), true);
+        }
+    }
+
+    // The BodyGenerator of the response
+    void pull(const crow::Response::ChunkCallback &callback)
+    {
+        if (closed)
+        {
+            callback(std::string(), false);
+            return;
+        }
+        if (!queue.empty())
+        {
+            callback(queue.takeAll(), true);
+            return;
+        }
+        pending = callback;
+        std::weak_ptr<EventStream> weak = shared_from_this();
+        keepAliveTimer.expires_from_now(eventStreamKeepAlive);
+        keepAliveTimer.async_wait([weak](const boost::system::error_code ec) {
+            std::shared_ptr<EventStream> self = weak.lock();
+            if (ec || self == nullptr || !self->pending)
+            {
+                return;
+            }
+            self->send(": keep-alive\n\n", true);
+        });
+    }
+
+    // Ends the response once what is queued has been sent
+    void close()
+    {
+        closed = true;
+        if (pending)
+        {
+            keepAliveTimer.cancel();
+            send(queue.takeAll(), false);
+        }
+    }
+
+    uint64_t getId() const
+    {
+        return id;
+    }
+
+    const event_util::EventFilter &getFilter() const
+    {
+        return filter;
+    }
+
+  private:
+    void send(std::string &&chunk, bool more)
+    {
+        crow::Response::ChunkCallback callback = std::move(pending);
+        pending = nullptr;
+        callback(std::move(chunk), more);
+    }
+
+    uint64_t id;
+    event_util::EventFilter filter;
+    event_util::EventQueue queue;
+    boost::asio::steady_timer keepAliveTimer;
+    // Set while the connection waits for the next chunk
+    crow::Response::ChunkCallback pending;
+    bool closed = false;
+};
+
+/**
+ * @brief Turns D-Bus signals into Redfish events for the open streams
+ *
+ * Sensor readings, sensor threshold alarms, host and chassis power state,
+ * and SEL entries being added or removed are turned into events.  Each event
+ * is encoded once and queued on every stream whose filter takes it.  The
+ * signal matches are only installed while a stream is open, so nobody
+ * listening costs nothing.
+ */
+class EventDispatcher
+{
+  public:
+    /**
+     * @brief Opens a stream for a client
+     *
+     * @return The stream, or nullptr if maxEventStreams are open already
+     */
+    std::shared_ptr<EventStream> open(event_util::EventFilter filter,
+                                      boost::asio::io_service &io)
+    {
+        if (streams.size() >= maxEventStreams)
+        {
+            return nullptr;
+        }
+        auto stream = std::make_shared<EventStream>(nextStreamId++,
+                                                    std::move(filter), io);
+        streams.emplace(stream->getId(), stream.get());
+        if (matches.empty())
+        {
+            subscribe();
+        }
+        return stream;
+    }
+
+    // Called as a stream goes away
+    void remove(uint64_t id)
+    {
+        streams.erase(id);
+        if (streams.empty())
+        {
+            matches.clear();
+        }
+    }
+
+    EventStream *find(uint64_t id)
+    {
+        auto it = streams.find(id);
+        return it == streams.end() ? nullptr : it->second;
+    }
+
+    const boost::container::flat_map<uint64_t, EventStream *> &
+        getStreams() const
+    {
+        return streams;
+    }
+
+    /**
+     * @brief Sends an event to every stream that wants it
+     *
+     * @param[in] key        Events with the same non empty key replace each
+     *                       other in the queue of a stream that reads slowly
+     * @param[in] eventType  Redfish EventType
+     * @param[in] messageId  Redfish MessageId
+     * @param[in] message    Human readable message
+     * @param[in] args       MessageArgs
+     * @param[in] origin     URI of the resource the event is about
+     */
+    void publish(const std::string &key, const std::string &eventType,
+                 const std::string &messageId, const std::string &message,
+                 const std::vector<std::string> &args,
+                 const std::string &origin)
+    {
+        std::vector<EventStream *> targets;
+        for (const std::pair<uint64_t, EventStream *> &stream : streams)
+        {
+            if (stream.second->getFilter().matches(eventType, origin))
+            {
+                targets.push_back(stream.second);
+            }
+        }
+        if (targets.empty())
+        {
+            return;
+        }
+
+        const uint64_t eventId = nextEventId++;
+        std::string timestamp = getCurrentDateTime("%FT%T%z");
+        if (timestamp.size() > 2)
+        {
+            timestamp.insert(timestamp.end() - 2, ':');
+        }
+        nlohmann::json event = {
+            {"@odata.type", "#Event.v1_1_0.Event"},
+            {"Id", std::to_string(eventId)},
+            {"Name", "Event Log"},
+            {"Events",
+             {{{"EventType", eventType},
+               {"EventId", std::to_string(eventId)},
+               {"EventTimestamp", std::move(timestamp)},
+               {"MessageId", messageId},
+               {"Message", message},
+               {"MessageArgs", args},
+               {"OriginOfCondition", {{"@odata.id", origin}}}}}}};
+        auto encoded = std::make_shared<const std::string>(
+            event_util::sseMessage(eventId, event.dump()));
+        for (EventStream *stream : targets)
+        {
+            stream->push(key, encoded);
+        }
+    }
+
+    // Ends every stream; has to happen before the bus goes away
+    void stop()
+    {
+        matches.clear();
+        for (const std::pair<uint64_t, EventStream *> &stream : streams)
+        {
+            stream.second->close();
+        }
+    }
+
+  private:
+    using Value = sdbusplus::message::variant<std::string, bool, int64_t,
+                                              uint64_t, uint32_t, double>;
+    using Properties = boost::container::flat_map<std::string, Value>;
+
+    static std::string valueText(const Value &value)
+    {
+        return mapbox::util::apply_visitor(
+            [](const auto &v) { return nlohmann::json(v).dump(); }, value);
+    }
+
+    static std::string sensorOrigin(const std::string &type)
+    {
+        if (type == "temperature" || type == "fan_tach" || type == "fan_pwm")
+        {
+            return "/redfish/v1/Chassis/1/Thermal";
+        }
+        if (type == "voltage" || type == "power" || type == "current")
+        {
+            return "/redfish/v1/Chassis/1/Power";
+        }
+        return "/redfish/v1/Chassis/1";
+    }
+
+    void onSensorChanged(sdbusplus::message::message &message)
+    {
+        std::string interface;
+        Properties values;
+        message.read(interface, values);
+        const std::string path = message.get_path();
+        std::string::size_type nameStart = path.rfind('/');
+        std::string::size_type typeStart = path.rfind('/', nameStart - 1);
+        if (nameStart == std::string::npos || typeStart == std::string::npos)
+        {
+            return;
+        }
+        const std::string name = path.substr(nameStart + 1);
+        const std::string origin = sensorOrigin(
+            path.substr(typeStart + 1, nameStart - typeStart - 1));
+        for (const std::pair<std::string, Value> &value : values)
+        {
+            if (value.first == "Value")
+            {
+                publish(path, "ResourceUpdated",
+                        "ResourceEvent.1.0.ResourceChanged",
+                        "The reading of " + name + " is " +
+                            valueText(value.second) + ".",
+                        {name, valueText(value.second)}, origin);
+            }
+            else if (boost::ends_with(value.first, "Alarm") ||
+                     boost::ends_with(value.first, "AlarmHigh") ||
+                     boost::ends_with(value.first, "AlarmLow"))
+            {
+                const bool *asserted = mapbox::getPtr<const bool>(value.second);
+                if (asserted == nullptr)
+                {
+                    continue;
+                }
+                publish(std::string(), "Alert",
+                        *asserted ? "ResourceEvent.1.0.ResourceErrorsDetected"
+                                  : "ResourceEvent.1.0.ResourceErrorsCorrected",
+                        name + " " + value.first +
+                            (*asserted ? " asserted." : " deasserted."),
+                        {name, value.first}, origin);
+            }
+        }
+    }
+
+    void onStateChanged(sdbusplus::message::message &message,
+                        const std::string &property, const std::string &origin)
+    {
+        std::string interface;
+        Properties values;
+        message.read(interface, values);
+        auto value = values.find(property);
+        if (value == values.end())
+        {
+            return;
+        }
+        const std::string *state =
+            mapbox::getPtr<const std::string>(value->second);
+        if (state == nullptr)
+        {
+            return;
+        }
+        std::string shortState = state->substr(state->rfind('.') + 1);
+        publish(std::string(), "StatusChange",
+                "ResourceEvent.1.0.ResourceStatusChanged",
+                property + " is " + shortState + ".", {property, shortState},
+                origin);
+    }
+
+    void onLogEntry(sdbusplus::message::message &message, bool added)
+    {
+        sdbusplus::message::object_path path;
+        message.read(path);
+        const std::string &entryPath = path;
+        const std::string id = log_util::entryId(entryPath);
+        const std::string origin =
+            "/redfish/v1/Systems/1/LogServices/SEL/Entries/" + id;
+        if (added)
+        {
+            publish(std::string(), "Alert",
+                    "ResourceEvent.1.0.ResourceCreated",
+                    "Log entry " + id + " was added.", {id}, origin);
+        }
+        else
+        {
+            publish(std::string(), "ResourceRemoved",
+                    "ResourceEvent.1.0.ResourceRemoved",
+                    "Log entry " + id + " was removed.", {id}, origin);
+        }
+    }
+
+    void subscribe()
+    {
+        sdbusplus::bus::bus &bus = *crow::connections::systemBus;
+        matches.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+            bus,
+            "type='signal',interface='org.freedesktop.DBus.Properties',"
+            "member='PropertiesChanged',"
+            "path_namespace='/xyz/openbmc_project/sensors'",
+            [this](sdbusplus::message::message &message) {
+                onSensorChanged(message);
+            }));
+        matches.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+            bus,
+            "type='signal',interface='org.freedesktop.DBus.Properties',"
+            "member='PropertiesChanged',"
+            "path='/xyz/openbmc_project/state/host0',"
+            "arg0='xyz.openbmc_project.State.Host'",
+            [this](sdbusplus::message::message &message) {
+                onStateChanged(message, "CurrentHostState",
+                               "/redfish/v1/Systems/1");
+            }));
+        matches.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+            bus,
+            "type='signal',interface='org.freedesktop.DBus.Properties',"
+            "member='PropertiesChanged',"
+            "path='/xyz/openbmc_project/state/chassis0',"
+            "arg0='xyz.openbmc_project.State.Chassis'",
+            [this](sdbusplus::message::message &message) {
+                onStateChanged(message, "CurrentPowerState",
+                               "/redfish/v1/Chassis/1");
+            }));
+        matches.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+            bus,
+            "type='signal',sender='xyz.openbmc_project.Logging',"
+            "interface='org.freedesktop.DBus.ObjectManager',"
+            "member='InterfacesAdded',"
+            "arg0path='/xyz/openbmc_project/logging/entry/'",
+            [this](sdbusplus::message::message &message) {
+                onLogEntry(message, true);
+            }));
+        matches.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+            bus,
+            "type='signal',sender='xyz.openbmc_project.Logging',"
+            "interface='org.freedesktop.DBus.ObjectManager',"
+            "member='InterfacesRemoved',"
+            "arg0path='/xyz/openbmc_project/logging/entry/'",
+            [this](sdbusplus::message::message &message) {
+                onLogEntry(message, false);
+            }));
+    }
+
+    boost::container::flat_map<uint64_t, EventStream *> streams;
+    uint64_t nextStreamId = 1;
+    uint64_t nextEventId = 1;
+    std::vector<std::unique_ptr<sdbusplus::bus::match::match>> matches;
+};
+
+inline EventDispatcher &eventDispatcher()
+{
+    static EventDispatcher dispatcher;
+    return dispatcher;
+}
+
+inline EventStream::~EventStream()
+{
+    eventDispatcher().remove(id);
+}
+
+/**
+ * @brief Opens an event stream at the ServerSentEventUri
+ *
+ * The events a client gets can be narrowed with $filter, see
+ * event_util::EventFilter.  The response is text/event-stream, and goes on
+ * until the client goes away or the service stops.
+ */
+inline void requestEventStreamRoutes(CrowApp &app)
+{
+    BMCWEB_ROUTE(app, "/redfish/v1/EventService/SSE")
+        .methods("GET"_method)(
+            [](const crow::Request &req, crow::Response &res) {
+                event_util::EventFilter filter;
+                boost::optional<std::string> filterParam =
+                    req.urlParams.get("$filter");
+                if (filterParam && !filter.parse(*filterParam))
+                {
+                    res.result(boost::beast::http::status::bad_request);
+                    messages::addMessageToErrorJson(
+                        res.jsonValue, messages::queryParameterValueFormatError(
+                                           *filterParam, "$filter"));
+                    res.end();
+                    return;
+                }
+                std::shared_ptr<EventStream> stream =
+                    eventDispatcher().open(std::move(filter), *req.ioService);
+                if (stream == nullptr)
+                {
+                    res.result(boost::beast::http::status::service_unavailable);
+                    res.addHeader("Retry-After", "30");
+                    res.end();
+                    return;
+                }
+                res.addHeader("Content-Type", "text/event-stream");
+                res.addHeader("Cache-Control", "no-cache");
+                // The stream lives as long as the response holds its
+                // generator
+                res.setBodyGenerator(
+                    [stream](const crow::Response::ChunkCallback &callback) {
+                        stream->pull(callback);
+                    });
+                res.end();
+            });
+}
+
+class EventService : public Node
+{
+  public:
+    EventService(CrowApp &app) : Node(app, "/redfish/v1/EventService/")
+    {
+        Node::json["@odata.type"] = "#EventService.v1_2_0.EventService";
+        Node::json["@odata.id"] = "/redfish/v1/EventService";
+        Node::json["@odata.context"] =
+            "/redfish/v1/$metadata#EventService.EventService";
+        Node::json["Id"] = "EventService";
+        Node::json["Name"] = "Event Service";
+        Node::json["ServiceEnabled"] = true;
+        Node::json["Status"] = {{"State", "Enabled"}, {"Health", "OK"}};
+        Node::json["EventTypesForSubscription"] = {
+            "StatusChange", "ResourceUpdated", "ResourceRemoved", "Alert"};
+        Node::json["ServerSentEventUri"] = "/redfish/v1/EventService/SSE";
+        staticJson = true;
+
+        entityPrivileges = {
+            {boost::beast::http::verb::get, {{"Login"}}},
+            {boost::beast::http::verb::head, {{"Login"}}},
+            {boost::beast::http::verb::patch, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::put, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::delete_, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::post, {{"ConfigureManager"}}}};
+    }
+
+  private:
+    void doGet(crow::Response &res, const crow::Request &req,
+               const std::vector<std::string> &params) override
+    {
+        res.jsonValue = Node::json;
+        res.end();
+    }
+};
+
+/**
+ * @brief The open event streams.  Subscriptions are made by opening the
+ *        ServerSentEventUri; pushing events to a Destination isn't supported.
+ */
+class EventDestinationCollection : public Node
+{
+  public:
+    EventDestinationCollection(CrowApp &app) :
+        Node(app, "/redfish/v1/EventService/Subscriptions/")
+    {
+        Node::json["@odata.type"] =
+            "#EventDestinationCollection.EventDestinationCollection";
+        Node::json["@odata.id"] = "/redfish/v1/EventService/Subscriptions";
+        Node::json["@odata.context"] =
+            "/redfish/v1/"
+            "$metadata#EventDestinationCollection.EventDestinationCollection";
+        Node::json["Name"] = "Event Subscriptions Collection";
+
+        entityPrivileges = {
+            {boost::beast::http::verb::get, {{"Login"}}},
+            {boost::beast::http::verb::head, {{"Login"}}},
+            {boost::beast::http::verb::patch, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::put, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::delete_, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::post, {{"ConfigureManager"}}}};
+    }
+
+  private:
+    void doGet(crow::Response &res, const crow::Request &req,
+               const std::vector<std::string> &params) override
+    {
+        res.jsonValue = Node::json;
+        nlohmann::json &members = res.jsonValue["Members"];
+        members = nlohmann::json::array();
+        for (const std::pair<uint64_t, EventStream *> &stream :
+             eventDispatcher().getStreams())
+        {
+            members.push_back(
+                {{"@odata.id", "/redfish/v1/EventService/Subscriptions/" +
+                                   std::to_string(stream.first)}});
+        }
+        res.jsonValue["Members@odata.count"] = members.size();
+        res.end();
+    }
+};
+
+class EventDestination : public Node
+{
+  public:
+    EventDestination(CrowApp &app) :
+        Node(app, "/redfish/v1/EventService/Subscriptions/<str>/",
+             std::string())
+    {
+        Node::json["@odata.type"] = "#EventDestination.v1_4_0.EventDestination";
+        Node::json["@odata.context"] =
+            "/redfish/v1/$metadata#EventDestination.EventDestination";
+        Node::json["Protocol"] = "Redfish";
+        Node::json["SubscriptionType"] = "SSE";
+        Node::json["Context"] = "";
+
+        entityPrivileges = {
+            {boost::beast::http::verb::get, {{"Login"}}},
+            {boost::beast::http::verb::head, {{"Login"}}},
+            {boost::beast::http::verb::patch, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::put, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::delete_, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::post, {{"ConfigureManager"}}}};
+    }
+
+  private:
+    EventStream *findStream(const std::string &id, crow::Response &res)
+    {
+        size_t streamId = 0;
+        EventStream *stream = nullptr;
+        if (query_util::Paging::parseCount(id, streamId))
+        {
+            stream = eventDispatcher().find(streamId);
+        }
+        if (stream == nullptr)
+        {
+            res.result(boost::beast::http::status::not_found);
+            messages::addMessageToErrorJson(
+                res.jsonValue,
+                messages::resourceNotFound("EventDestination", id));
+            res.end();
+        }
+        return stream;
+    }
+
+    void doGet(crow::Response &res, const crow::Request &req,
+               const std::vector<std::string> &params) override
+    {
+        const EventStream *stream = findStream(params[0], res);
+        if (stream == nullptr)
+        {
+            return;
+        }
+        res.jsonValue = Node::json;
+        res.jsonValue["@odata.id"] =
+            "/redfish/v1/EventService/Subscriptions/" + params[0];
+        res.jsonValue["Id"] = params[0];
+        res.jsonValue["Name"] = "Event Stream " + params[0];
+        res.jsonValue["EventTypes"] = stream->getFilter().getEventTypes();
+        nlohmann::json &origins = res.jsonValue["OriginResources"];
+        origins = nlohmann::json::array();
+        for (const std::string &origin : stream->getFilter().getOrigins())
+        {
+            origins.push_back({{"@odata.id", origin}});
+        }
+        res.end();
+    }
+
+    // Ends the stream; the client sees its response finish
+    void doDelete(crow::Response &res, const crow::Request &req,
+                  const std::vector<std::string> &params) override
+    {
+        EventStream *stream = findStream(params[0], res);
+        if (stream == nullptr)
+        {
+            return;
+        }
+        stream->close();
+        res.result(boost::beast::http::status::no_content);
+        res.end();
+    }
+};
+
+} // namespace redfish
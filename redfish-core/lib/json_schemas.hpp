@@ -0,0 +1,136 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+#pragma once
+
+#include "node.hpp"
+#include "utils/schema_store.hpp"
+
+#include <compression_middleware.hpp>
+#include <webassets.hpp>
+
+namespace redfish
+{
+
+inline schema_util::SchemaStoreLoader& schemaStoreLoader()
+{
+    static schema_util::SchemaStoreLoader loader;
+    return loader;
+}
+
+/**
+ * @brief Sends a file of the schema store: gzipped as it is kept if the
+ *        client takes that, inflated if not
+ */
+inline void handleSchemaRequest(const crow::Request& req, crow::Response& res)
+{
+    const schema_util::SchemaStore* store = schemaStoreLoader().get();
+    if (store == nullptr)
+    {
+        // Still loading; the files are served as they are on disk, but the
+        // collection is only made by the store
+        const crow::webassets::StaticAsset* asset =
+            crow::webassets::findAsset(crow::webassets::staticAssets, req.url);
+        if (asset == nullptr)
+        {
+            res.result(boost::beast::http::status::service_unavailable);
+            res.addHeader("Retry-After", "1");
+            res.jsonValue = messages::serviceTemporarilyUnavailable("1");
+            res.end();
+            return;
+        }
+        crow::webassets::handleStaticFile(*asset, req, res);
+        return;
+    }
+    const schema_util::SchemaStore::File* file = store->find(req.url);
+    if (file == nullptr)
+    {
+        res.result(boost::beast::http::status::not_found);
+        res.end();
+        return;
+    }
+    res.addHeader("ETag", file->etag);
+    res.addHeader("Cache-Control", "no-cache");
+    res.addHeader("Vary", "Accept-Encoding");
+    boost::string_view ifNoneMatch =
+        req.getHeaderValue(crow::KnownHeader::ifNoneMatch);
+    if (!ifNoneMatch.empty() &&
+        http_helpers::etagMatches(ifNoneMatch, file->etag))
+    {
+        res.result(boost::beast::http::status::not_modified);
+        res.end();
+        return;
+    }
+    if (file->contentType != nullptr)
+    {
+        res.addHeader("Content-Type", file->contentType);
+    }
+
+    if (crow::compression::selectEncoding(req.getHeaderValue(
+            crow::KnownHeader::acceptEncoding)) ==
+        crow::compression::Encoding::gzip)
+    {
+        res.body() = file->gzipped;
+        res.addHeader("Content-Encoding", "gzip");
+        res.end();
+        return;
+    }
+    if (!gzipInflate(file->gzipped, res.body()))
+    {
+        BMCWEB_LOG_ERROR << "Failed to inflate " << req.url;
+        res.body().clear();
+        res.result(boost::beast::http::status::internal_server_error);
+    }
+    res.end();
+}
+
+/**
+ * @brief Starts loading the schema store and serves it, ahead of the static
+ *        files the schemas come from
+ */
+inline void requestSchemaRoutes(CrowApp& app)
+{
+    schemaStoreLoader().start(crow::webassets::webRoot,
+                              crow::webassets::staticAssets);
+
+    BMCWEB_ROUTE(app, "/redfish/v1/JsonSchemas/")
+        .methods("GET"_method)(
+            [](const crow::Request& req, crow::Response& res) {
+                handleSchemaRequest(req, res);
+            });
+    BMCWEB_ROUTE(app, "/redfish/v1/JsonSchemas/<str>/")
+        .methods("GET"_method)([](const crow::Request& req,
+                                  crow::Response& res, const std::string&) {
+            handleSchemaRequest(req, res);
+        });
+    BMCWEB_ROUTE(app, "/redfish/v1/JsonSchemas/<str>/<str>")
+        .methods("GET"_method)(
+            [](const crow::Request& req, crow::Response& res,
+               const std::string&, const std::string&) {
+                handleSchemaRequest(req, res);
+            });
+    BMCWEB_ROUTE(app, "/redfish/v1/$metadata/")
+        .methods("GET"_method)(
+            [](const crow::Request& req, crow::Response& res) {
+                handleSchemaRequest(req, res);
+            });
+    BMCWEB_ROUTE(app, "/redfish/v1/schema/<str>")
+        .methods("GET"_method)([](const crow::Request& req,
+                                  crow::Response& res, const std::string&) {
+            handleSchemaRequest(req, res);
+        });
+}
+
+} // namespace redfish
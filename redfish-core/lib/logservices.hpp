@@ -19,21 +19,20 @@
 
 #include "node.hpp"
 #include "utils/ampere-utils.hpp"
+#include "utils/log_entry_index.hpp"
 
 #include <boost/container/flat_map.hpp>
+#include <dbus_utility.hpp>
 
 namespace redfish
 {
 
-using GetManagedObjectsTypes = boost::container::flat_map<
-    sdbusplus::message::object_path,
-    boost::container::flat_map<
-        std::string,
-        boost::container::flat_map<
-            std::string, sdbusplus::message::variant<
-                             std::string, bool, uint8_t, int16_t, uint16_t,
-                             int32_t, uint32_t, int64_t, uint64_t, double,
-                             std::vector<std::string>>>>>;
+using SelEntryVariant =
+    sdbusplus::message::variant<std::string, bool, uint8_t, int16_t, uint16_t,
+                                int32_t, uint32_t, int64_t, uint64_t, double,
+                                std::vector<std::string>>;
+
+using SelEntryIndex = log_util::LogEntryIndex<SelEntryVariant>;
 
 /** @brief A fixed array of sensor type - following the LogEntry schema  */
 constexpr std::array<const char *, 46> sensorTypeList{
@@ -144,7 +143,14 @@ inline std::string getSELSpecificInfo(const std::string &s, uint8_t field)
             subSEL = s.substr(37, 2);
             data = std::stoi(subSEL, nullptr, 16);
             BMCWEB_LOG_DEBUG << "-> Byte 11 0x" << data;
-            ret = sensorTypeList[data];
+            if (data < sensorTypeList.size() - 1)
+            {
+                ret = sensorTypeList[data];
+            }
+            else
+            {
+                ret = data >= 0xc0 ? "OEM" : "Reserved";
+            }
             break;
         case 1:
             // Request getting the Sensor Number info
@@ -205,6 +211,95 @@ inline std::string translateSeverityDbusToRedfish(const std::string &s)
     return "";
 }
 
+/**
+ * @brief Fills in a LogEntry from the properties of its D-Bus entry
+ *
+ * @param[in] properties  Properties of xyz.openbmc_project.Logging.Entry
+ * @param[out] json       Receives the LogEntry properties
+ */
+inline void fillSelEntry(const SelEntryIndex::Properties &properties,
+                         nlohmann::json &json)
+{
+    json["EntryType"] = "SEL"; // System Event Log
+    for (const auto &property : properties)
+    {
+        const std::string &name = *property.name;
+        if (name == "Id")
+        {
+            const uint32_t *id = mapbox::getPtr<const uint32_t>(property.value);
+            if (id != nullptr)
+            {
+                json["Id"] = std::to_string(*id);
+                json["Name"] = "Log Entry " + std::to_string(*id);
+            }
+        }
+        else if (name == "Timestamp")
+        {
+            const uint64_t *millisTimeStamp =
+                mapbox::getPtr<const uint64_t>(property.value);
+            if (millisTimeStamp != nullptr)
+            {
+                // Retrieve Created property with format:
+                // yyyy-mm-ddThh:mm:ss
+                std::string created =
+                    getDateTime(Milliseconds{*millisTimeStamp}, "%FT%T%z");
+                created.insert(created.end() - 2, ':');
+                json["Created"] = created;
+            }
+        }
+        else if (name == "Severity")
+        {
+            const std::string *severity =
+                mapbox::getPtr<const std::string>(property.value);
+            if (severity != nullptr)
+            {
+                json["Severity"] = translateSeverityDbusToRedfish(*severity);
+            }
+        }
+        else if (name == "AdditionalData")
+        {
+            const std::vector<std::string> *addData =
+                mapbox::getPtr<const std::vector<std::string>>(property.value);
+            // STRING=XX XX XX XX XX XX XX XX XX XX XX XX XX XX XX XX
+            if (addData != nullptr && addData->size() > 1 &&
+                (*addData)[1].size() >= 45 &&
+                (*addData)[1].find_first_not_of("0123456789abcdefABCDEF ",
+                                                37) == std::string::npos)
+            {
+                const std::string &selData = (*addData)[1];
+                json["MessageId"] = getSELSpecificInfo(selData, 2);
+                json["SensorType"] = getSELSpecificInfo(selData, 0);
+                json["SensorNumber"] = std::strtoul(
+                    getSELSpecificInfo(selData, 1).c_str(), nullptr, 16);
+            }
+        }
+        else if (name == "Message")
+        {
+            const std::string *message =
+                mapbox::getPtr<const std::string>(property.value);
+            if (message != nullptr)
+            {
+                json["Message"] = *message;
+            }
+        }
+        // TODO Retrieve Message Arguments object
+        // TODO Need get EntryCode, OemRecordFormat and Links object.
+        // Now D-Bus does not support to retrieve these objects.
+    }
+}
+
+/**
+ * @brief Index of the entries of the system event log
+ */
+inline SelEntryIndex &selEntryIndex()
+{
+    static SelEntryIndex index("xyz.openbmc_project.Logging",
+                               "/xyz/openbmc_project/logging",
+                               "xyz.openbmc_project.Logging.Entry",
+                               fillSelEntry);
+    return index;
+}
+
 /**
  * LogEntry derived class for delivering Log Entry Schema.
  */
@@ -219,7 +314,6 @@ class LogEntry : public Node
         Node::json["@odata.type"] = "#LogEntry.v1_3_0.LogEntry";
         Node::json["@odata.context"] =
             "/redfish/v1/$metadata#LogEntry.LogEntry";
-        Node::json["EntryType"] = "SEL"; // System Event Log
 
         entityPrivileges = {
             {boost::beast::http::verb::get, {{"Login"}}},
@@ -250,150 +344,60 @@ class LogEntry : public Node
         res.jsonValue = Node::json;
         res.jsonValue["@odata.id"] =
             "/redfish/v1/Systems/1/LogServices/SEL/Entries/" + entryId;
-        auto asyncResp = std::make_shared<AsyncResp>(res);
-        crow::connections::systemBus->async_method_call(
-            [asyncResp, entryId](const boost::system::error_code ec,
-                                 const GetManagedObjectsTypes &resp) {
-                if (ec)
+        auto asyncResp = AsyncResp::create(res);
+        selEntryIndex().get(
+            [asyncResp, entryId](bool ok,
+                                 const SelEntryIndex::Entries &entries) {
+                if (!ok)
                 {
                     // TODO Handle for specific error code
                     asyncResp->res.result(
                         boost::beast::http::status::internal_server_error);
                     return;
                 }
+                auto entry = entries.find(entryId);
+                if (entry == entries.end())
+                {
+                    asyncResp->res.clear();
+                    asyncResp->res.result(
+                        boost::beast::http::status::not_found);
+                    return;
+                }
+                getEntry(asyncResp, entryId, entry->second.path);
+            });
+    }
 
-                bool idFound = false;
-                for (auto &objectPath : resp)
+    static void getEntry(const std::shared_ptr<AsyncResp> &asyncResp,
+                         const std::string &entryId, const std::string &path)
+    {
+        crow::connections::getAllProperties<SelEntryVariant>(
+            [asyncResp, entryId](
+                const boost::system::error_code &ec,
+                const std::shared_ptr<const SelEntryIndex::ManagedObjects>
+                    &reply) {
+                if (ec)
                 {
-                    for (auto &interfaceMap : objectPath.second)
-                    {
-                        if (interfaceMap.first !=
-                            "xyz.openbmc_project.Logging.Entry")
-                        {
-                            BMCWEB_LOG_DEBUG << "Bailing early on "
-                                             << interfaceMap.first;
-                            continue;
-                        }
-                        if (idFound == true)
-                        {
-                            break;
-                        }
-
-                        for (auto &propertyMap : interfaceMap.second)
-                        {
-                            if (propertyMap.first == "Id")
-                            {
-                                const uint32_t *id =
-                                    mapbox::getPtr<const uint32_t>(
-                                        propertyMap.second);
-                                // only assign properties if the id is matched
-                                if (id == nullptr ||
-                                    entryId != std::to_string(*id))
-                                {
-                                    break;
-                                }
-                                idFound = true;
-                                asyncResp->res.jsonValue["Id"] = entryId;
-                                asyncResp->res.jsonValue["Name"] =
-                                    "Log Entry " + entryId;
-                            }
-                            else if (propertyMap.first == "Timestamp")
-                            {
-                                const uint64_t *millisTimeStamp =
-                                    mapbox::getPtr<const uint64_t>(
-                                        propertyMap.second);
-                                if (millisTimeStamp != nullptr)
-                                {
-                                    // Retrieve Created property with format:
-                                    // yyyy-mm-ddThh:mm:ss
-                                    std::string created = getDateTime(
-                                        Milliseconds{*millisTimeStamp},
-                                        "%FT%T%z");
-                                    created.insert(created.end() - 2, ':');
-                                    asyncResp->res.jsonValue["Created"] =
-                                        created;
-                                }
-                            }
-                            else if (propertyMap.first == "Severity")
-                            {
-                                const std::string *severity =
-                                    mapbox::getPtr<const std::string>(
-                                        propertyMap.second);
-                                if (severity != nullptr)
-                                {
-                                    asyncResp->res.jsonValue["Severity"] =
-                                        translateSeverityDbusToRedfish(
-                                            *severity);
-                                }
-                            }
-                            else if (propertyMap.first == "AdditionalData")
-                            {
-                                const std::vector<std::string> *addData =
-                                    mapbox::getPtr<
-                                        const std::vector<std::string>>(
-                                        propertyMap.second);
-                                if (addData != nullptr)
-                                {
-                                    std::string selData =
-                                        (std::string)addData->at(1);
-                                    asyncResp->res.jsonValue["MessageId"] =
-                                        getSELSpecificInfo(selData, 2);
-                                    asyncResp->res.jsonValue["SensorType"] =
-                                        getSELSpecificInfo(selData, 0);
-                                    asyncResp->res.jsonValue["SensorNumber"] =
-                                        std::stoi(
-                                            getSELSpecificInfo(selData, 1),
-                                            nullptr, 10);
-                                }
-                            }
-                            else if (propertyMap.first == "Message")
-                            {
-                                const std::string *message =
-                                    mapbox::getPtr<const std::string>(
-                                        propertyMap.second);
-                                if (message != nullptr)
-                                {
-                                    asyncResp->res.jsonValue["Message"] =
-                                        *message;
-                                }
-                            }
-                            else if (propertyMap.first == "Resolved")
-                            {
-                                const bool *resolved =
-                                    mapbox::getPtr<const bool>(
-                                        propertyMap.second);
-                                if (resolved != nullptr)
-                                {
-                                    // No place to put this for now
-                                }
-                            }
-                            else
-                            {
-                                // TODO Retrieve Message Arguments object
-                                // TODO Need get MessageId, SensorType,
-                                // SensorNumber,
-                                // EntryCode, OemRecordFormat and Links object.
-                                // Now D-Bus does not support to retrieve these
-                                // objects.
-                                BMCWEB_LOG_WARNING << "Got extra property in "
-                                                      "log entry interface "
-                                                   << propertyMap.first;
-                            }
-                        }
-                    }
+                    // TODO Handle for specific error code
+                    asyncResp->res.result(
+                        boost::beast::http::status::internal_server_error);
+                    return;
                 }
-                if (idFound == false)
+
+                nlohmann::json entry = nlohmann::json::object();
+                fillSelEntry(reply->properties(), entry);
+                // only assign properties if the id is matched
+                auto id = entry.find("Id");
+                if (id == entry.end() || *id != entryId)
                 {
-                    // some properties may be misassigned so must clear the
-                    // response here
                     asyncResp->res.clear();
                     asyncResp->res.result(
                         boost::beast::http::status::not_found);
                     return;
                 }
+                asyncResp->res.jsonValue.update(entry);
             },
-            "xyz.openbmc_project.Logging", "/xyz/openbmc_project/logging",
-            "org.freedesktop.DBus.ObjectManager", "GetManagedObjects");
+            "xyz.openbmc_project.Logging", path,
+            "xyz.openbmc_project.Logging.Entry");
     }
 };
 
@@ -431,44 +435,31 @@ class LogEntryCollection : public Node
     void doGet(crow::Response &res, const crow::Request &req,
                const std::vector<std::string> &params) override
     {
+        query_util::Paging paging;
+        query_util::Filter filter;
+        if (!getPaging(req, res, paging) ||
+            !getFilter(req, res, filter, paging))
+        {
+            return;
+        }
         res.jsonValue = Node::json;
-        auto asyncResp = std::make_shared<AsyncResp>(res);
-        crow::connections::systemBus->async_method_call(
-            [asyncResp](const boost::system::error_code ec,
-                        GetManagedObjectsTypes &resp) {
-                if (ec)
-                {
-                    // TODO Handle for specific error code
-                    asyncResp->res.result(
-                        boost::beast::http::status::internal_server_error);
-                    return;
-                }
-
-                nlohmann::json &entries = asyncResp->res.jsonValue["Members"];
-                entries = nlohmann::json::array();
-                // Iterate over all retrived ObjectPath
-                for (auto &objPath : resp)
-                {
-                    for (auto &interface : objPath.second)
-                    {
-                        if (interface.first ==
-                            "xyz.openbmc_project.Logging.Entry")
-                        {
-                            const std::string &id = objPath.first;
-                            // Cut out everything until last "/", and put it
-                            // into output vector
-                            entries.push_back(
-                                {{"@odata.id",
-                                  "/redfish/v1/Systems/1/LogServices/SEL/"
-                                  "Entries/" +
-                                      id.substr(id.rfind("/") + 1)}});
-                        }
-                    }
-                }
-                asyncResp->res.jsonValue["Member@odata.count"] = entries.size();
-            },
-            "xyz.openbmc_project.Logging", "/xyz/openbmc_project/logging",
-            "org.freedesktop.DBus.ObjectManager", "GetManagedObjects");
+        auto asyncResp = AsyncResp::create(res);
+        selEntryIndex().get([asyncResp, paging, filter](
+                                bool ok,
+                                const SelEntryIndex::Entries &entries) {
+            if (!ok)
+            {
+                // TODO Handle for specific error code
+                asyncResp->res.result(
+                    boost::beast::http::status::internal_server_error);
+                return;
+            }
+
+            log_util::addEntryMembers(
+                asyncResp->res.jsonValue,
+                "/redfish/v1/Systems/1/LogServices/SEL/Entries", entries,
+                paging, filter);
+        });
     }
 };
 
@@ -497,8 +488,8 @@ class LogServiceActionsClear : public Node
     {
         BMCWEB_LOG_DEBUG << "Delete all entries.";
 
-        auto asyncResp = std::make_shared<AsyncResp>(res);
-        crow::connections::systemBus->async_method_call(
+        auto asyncResp = AsyncResp::create(res);
+        crow::connections::tracedMethodCall(
             [asyncResp](const boost::system::error_code ec) {
                 if (ec)
                 {
@@ -552,33 +543,34 @@ class LogService : public Node
                const std::vector<std::string> &params) override
     {
         // Get Log Service name
-        Node::json["@odata.id"] = "/redfish/v1/Systems/1/LogServices/SEL";
+        res.jsonValue = Node::json;
+        res.jsonValue["@odata.id"] = "/redfish/v1/Systems/1/LogServices/SEL";
 
         // TODO Logging service has not supported get MaxNumberOfRecords
         // property yet hardcode to ERROR_CAP (200) from phosphor-logging.
-        Node::json["MaxNumberOfRecords"] = 200;
-        Node::json["OverWritePolicy"] = "WrapsWhenFull"; // TODO hardcoded
-                                                         // should retrieve from
-                                                         // Logging service
+        res.jsonValue["MaxNumberOfRecords"] = 200;
+        res.jsonValue["OverWritePolicy"] = "WrapsWhenFull"; // TODO hardcoded
+                                                            // should retrieve
+                                                            // from Logging
+                                                            // service
         std::string redfishDateTime = getCurrentDateTime("%FT%T%z");
         // insert the colon required by the ISO 8601 standard
         redfishDateTime.insert(redfishDateTime.end() - 2, ':');
-        Node::json["DateTime"] = redfishDateTime;
-        Node::json["DateTimeLocalOffset"] =
+        res.jsonValue["DateTime"] = redfishDateTime;
+        res.jsonValue["DateTimeLocalOffset"] =
             redfishDateTime.substr(redfishDateTime.length() - 6);
         // TODO hardcoded ServiceEnabled property to true
-        Node::json["ServiceEnabled"] = true;
+        res.jsonValue["ServiceEnabled"] = true;
         // TODO hardcoded Status information
-        Node::json["Status"]["State"] = "Enabled";
-        Node::json["Status"]["Health"] = "OK";
+        res.jsonValue["Status"]["State"] = "Enabled";
+        res.jsonValue["Status"]["Health"] = "OK";
 
         // Supported Actions
         nlohmann::json clearLog;
         clearLog["target"] =
             "/redfish/v1/Systems/1/LogServices/SEL/Actions/LogService.Reset";
-        Node::json["Actions"]["#LogService.ClearLog"] = clearLog;
+        res.jsonValue["Actions"]["#LogService.ClearLog"] = clearLog;
 
-        res.jsonValue = Node::json;
         res.end();
     }
 };
@@ -19,6 +19,8 @@
 #include "node.hpp"
 #include "utils/ampere-utils.hpp"
 
+#include <dbus_utility.hpp>
+
 namespace redfish
 {
 
@@ -112,9 +114,9 @@ class ManagerActionsReset : public Node
     void doBMCGracefulRestart(crow::Response &res, const crow::Request &req,
                               const std::vector<std::string> &params)
     {
-        auto asyncResp = std::make_shared<AsyncResp>(res);
+        auto asyncResp = AsyncResp::create(res);
         // Create the D-Bus variant for D-Bus call.
-        crow::connections::systemBus->async_method_call(
+        crow::connections::coalescedMethodCall(
             [asyncResp](const boost::system::error_code ec,
                         const PropertiesMapType &properties) {
                 if (ec)
@@ -128,7 +130,7 @@ class ManagerActionsReset : public Node
                     auto it = properties.find("RequestedBMCTransition");
                     if (it != properties.end())
                     {
-                        crow::connections::systemBus->async_method_call(
+                        crow::connections::tracedMethodCall(
                             [asyncResp](const boost::system::error_code ec) {
                                 // Use "Set" method to set the property value.
                                 if (ec)
@@ -208,10 +210,10 @@ class Manager : public Node
                const std::vector<std::string> &params) override
     {
         res.jsonValue = Node::json;
-        auto asyncResp = std::make_shared<AsyncResp>(res);
+        auto asyncResp = AsyncResp::create(res);
 
         BMCWEB_LOG_DEBUG << "Get BMC Firmware Version enter.";
-        crow::connections::systemBus->async_method_call(
+        crow::connections::coalescedMethodCall(
             [asyncResp](const boost::system::error_code ec,
                         const PropertiesMapType &properties) {
                 if (ec)
@@ -285,7 +287,7 @@ class Manager : public Node
             {"MaxConcurrentSessions", 64}, // TODO(Hy): Retrieve real data
             {"ServiceEnabled", true} // true only when all protocols are enabled
         };
-        crow::connections::systemBus->async_method_call(
+        crow::connections::coalescedMethodCall(
             [asyncResp](const boost::system::error_code ec,
                         const sdbusplus::message::variant<std::string> &resp) {
                 if (ec)
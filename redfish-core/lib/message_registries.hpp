@@ -0,0 +1,137 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+#pragma once
+
+#include "node.hpp"
+#include "registries/base_message_registry.hpp"
+
+namespace redfish
+{
+
+/**
+ * @brief Where the registry the Base messages come from is.  The other
+ *        registries, and the collection, are static files.
+ */
+class BaseMessageRegistryFile : public Node
+{
+  public:
+    BaseMessageRegistryFile(CrowApp& app) :
+        Node(app, "/redfish/v1/Registries/Base/")
+    {
+        using namespace message_registries;
+        const std::string registryFile =
+            std::string(base::registryId) + ".json";
+        Node::json["@odata.type"] =
+            "#MessageRegistryFile.v1_1_0.MessageRegistryFile";
+        Node::json["@odata.id"] = "/redfish/v1/Registries/Base";
+        Node::json["@odata.context"] =
+            "/redfish/v1/$metadata#MessageRegistryFile.MessageRegistryFile";
+        Node::json["Id"] = base::registryPrefix;
+        Node::json["Name"] = "Base MessageRegistry File";
+        Node::json["Description"] = "DMTF Base MessageRegistry File Location";
+        Node::json["Registry"] = base::registryId;
+        Node::json["Languages"] = {"en"};
+        Node::json["Languages@odata.count"] = 1;
+        Node::json["Location"] = {
+            {{"Language", "en"},
+             {"PublicationUri",
+              "https://redfish.dmtf.org/registries/" + registryFile},
+             {"Uri", "/redfish/v1/Registries/Base/" + registryFile}}};
+        Node::json["Location@odata.count"] = 1;
+        staticJson = true;
+
+        entityPrivileges = {
+            {boost::beast::http::verb::get, {{"Login"}}},
+            {boost::beast::http::verb::head, {{"Login"}}},
+            {boost::beast::http::verb::patch, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::put, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::delete_, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::post, {{"ConfigureManager"}}}};
+    }
+
+  private:
+    void doGet(crow::Response& res, const crow::Request& req,
+               const std::vector<std::string>& params) override
+    {
+        res.jsonValue = Node::json;
+        res.end();
+    }
+};
+
+/**
+ * @brief The registry the messages bmcweb sends come from.  Built from the
+ *        same table as the messages, and serialized once.
+ *
+ * Like the registry files DMTF publishes, it has no @odata.id; that also
+ * keeps it from being linked into the file resource as a sub route.
+ */
+class BaseMessageRegistry : public Node
+{
+  public:
+    BaseMessageRegistry(CrowApp& app) :
+        Node(app, "/redfish/v1/Registries/Base/" +
+                      std::string(message_registries::base::registryId) +
+                      ".json")
+    {
+        using namespace message_registries;
+        Node::json["@odata.type"] = "#MessageRegistry.v1_0_0.MessageRegistry";
+        Node::json["Id"] = base::registryId;
+        Node::json["Name"] = base::registryName;
+        Node::json["Language"] = "en";
+        Node::json["Description"] =
+            "This registry defines the base messages for Redfish";
+        Node::json["RegistryPrefix"] = base::registryPrefix;
+        Node::json["RegistryVersion"] = base::registryVersion;
+        Node::json["OwningEntity"] = base::owningEntity;
+        nlohmann::json& messages = Node::json["Messages"];
+        for (const MessageEntry& entry : base::registry)
+        {
+            const Message& message = entry.second;
+            nlohmann::json& messageJson = messages[entry.first];
+            messageJson = {{"Message", message.message},
+                           {"Severity", message.severity},
+                           {"NumberOfArgs", message.numberOfArgs},
+                           {"Resolution", message.resolution}};
+            if (message.numberOfArgs != 0)
+            {
+                nlohmann::json& paramTypes = messageJson["ParamTypes"];
+                for (size_t i = 0; i < message.numberOfArgs; i++)
+                {
+                    paramTypes.push_back(message.paramTypes[i]);
+                }
+            }
+        }
+        staticJson = true;
+
+        entityPrivileges = {
+            {boost::beast::http::verb::get, {{"Login"}}},
+            {boost::beast::http::verb::head, {{"Login"}}},
+            {boost::beast::http::verb::patch, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::put, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::delete_, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::post, {{"ConfigureManager"}}}};
+    }
+
+  private:
+    void doGet(crow::Response& res, const crow::Request& req,
+               const std::vector<std::string>& params) override
+    {
+        res.jsonValue = Node::json;
+        res.end();
+    }
+};
+
+} // namespace redfish
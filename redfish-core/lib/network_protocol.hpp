@@ -19,6 +19,7 @@
 #include "error_messages.hpp"
 #include "node.hpp"
 
+#include <dbus_utility.hpp>
 #include <fstream>
 #include <utils/ampere-utils.hpp>
 
@@ -108,7 +109,7 @@ class NetworkProtocol : public Node
     void doGet(crow::Response& res, const crow::Request& req,
                const std::vector<std::string>& params) override
     {
-        std::shared_ptr<AsyncResp> asyncResp = std::make_shared<AsyncResp>(res);
+        std::shared_ptr<AsyncResp> asyncResp = AsyncResp::create(res);
 
         getData(asyncResp);
     }
@@ -116,7 +117,7 @@ class NetworkProtocol : public Node
     void doPatch(crow::Response& res, const crow::Request& req,
                  const std::vector<std::string>& params) override
     {
-        std::shared_ptr<AsyncResp> asyncResp = std::make_shared<AsyncResp>(res);
+        std::shared_ptr<AsyncResp> asyncResp = AsyncResp::create(res);
 
         nlohmann::json patchRequest;
         if (!json_util::processJsonFromRequest(res, req, patchRequest))
@@ -156,7 +157,7 @@ class NetworkProtocol : public Node
         for (auto& kv : protocolToDBus)
         {
             const char* socketPath = kv.second.socketPath;
-            crow::connections::systemBus->async_method_call(
+            crow::connections::coalescedMethodCall(
                 [asyncResp, service{std::string(kv.first)}](
                     const boost::system::error_code ec,
                     const sdbusplus::message::variant<std::vector<
@@ -205,7 +206,7 @@ class NetworkProtocol : public Node
                 "org.freedesktop.DBus.Properties", "Get",
                 "org.freedesktop.systemd1.Socket", "Listen");
 
-            crow::connections::systemBus->async_method_call(
+            crow::connections::coalescedMethodCall(
                 [asyncResp, service{std::string(kv.first)}](
                     const boost::system::error_code ec,
                     const sdbusplus::message::variant<std::string>& resp) {
@@ -267,7 +268,7 @@ class NetworkProtocol : public Node
                 {
                     action = "Stop";
                 }
-                crow::connections::systemBus->async_method_call(
+                crow::connections::tracedMethodCall(
                     [asyncResp, &protocol](
                         const boost::system::error_code ec,
                         const sdbusplus::message::object_path objectPath) {
@@ -286,7 +287,7 @@ class NetworkProtocol : public Node
                     "org.freedesktop.systemd1.Unit", action, "replace");
                 if (protocol != "SSH")
                 {
-                    crow::connections::systemBus->async_method_call(
+                    crow::connections::tracedMethodCall(
                         [asyncResp, &protocol](
                             const boost::system::error_code ec,
                             const sdbusplus::message::object_path objectPath) {
@@ -366,7 +367,7 @@ class NetworkProtocol : public Node
                     m.append("replace");
                     crow::connections::systemBus->call(m);
                 }
-                // crow::connections::systemBus->async_method_call(
+                // crow::connections::tracedMethodCall(
                 //     [asyncResp, &protocol](
                 //         const boost::system::error_code ec,
                 //         const sdbusplus::message::object_path objectPath) {
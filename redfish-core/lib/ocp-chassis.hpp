@@ -28,6 +28,7 @@
 #include "node.hpp"
 
 #include <boost/container/flat_map.hpp>
+#include <dbus_utility.hpp>
 
 namespace redfish
 {
@@ -68,7 +69,7 @@ class OnDemandChassisProvider
      */
     void get_chassis_data(const std::shared_ptr<AsyncResp> aResp)
     {
-        crow::connections::systemBus->async_method_call(
+        crow::connections::coalescedMethodCall(
             [aResp{std::move(aResp)}](const boost::system::error_code ec,
                                       const PropertiesType &properties) {
                 // Callback requires flat_map<string, string> so prepare one.
@@ -127,7 +128,7 @@ class OnDemandChassisProvider
      */
     void get_chassis_data_from_product(const std::shared_ptr<AsyncResp> aResp)
     {
-        crow::connections::systemBus->async_method_call(
+        crow::connections::coalescedMethodCall(
             [aResp{std::move(aResp)}](const boost::system::error_code ec,
                                       const PropertiesType &properties) {
                 // Callback requires flat_map<string, string> so prepare one.
@@ -177,7 +178,7 @@ class OnDemandChassisProvider
     void get_chassis_state(const std::shared_ptr<AsyncResp> aResp)
     {
         BMCWEB_LOG_DEBUG << "Get Chassis information.";
-        crow::connections::systemBus->async_method_call(
+        crow::connections::coalescedMethodCall(
             [aResp{std::move(aResp)}](const boost::system::error_code ec,
                                       const PropertiesType &properties) {
                 if (ec)
@@ -271,7 +272,7 @@ class ChassisActionsReset : public Node
             return;
         }
 
-        auto asyncResp = std::make_shared<AsyncResp>(res);
+        auto asyncResp = AsyncResp::create(res);
 
         for (const auto &item : post.items())
         {
@@ -317,7 +318,7 @@ class ChassisActionsReset : public Node
                     return;
                 }
 
-                crow::connections::systemBus->async_method_call(
+                crow::connections::tracedMethodCall(
                     [asyncResp](const boost::system::error_code ec) {
                         if (ec)
                         {
@@ -392,6 +393,20 @@ class Chassis : public Node
     }
 
   private:
+    // Built from the objects OnDemandChassisProvider reads
+    bool getCachePolicy(const std::vector<std::string> &params,
+                        CachePolicy &policy) override
+    {
+        policy.dependencies = {
+            {"/xyz/openbmc_project/inventory/fru0/chassis", false,
+             "xyz.openbmc_project.Inventory.FRU.Chassis"},
+            {"/xyz/openbmc_project/inventory/fru0/product", false,
+             "xyz.openbmc_project.Inventory.FRU.Product"},
+            {"/xyz/openbmc_project/state/chassis0", false,
+             "xyz.openbmc_project.State.Chassis"}};
+        return true;
+    }
+
     /**
      * Functions triggers appropriate requests on D-Bus
      */
@@ -408,22 +423,22 @@ class Chassis : public Node
             return;
         }
 
-        Node::json["@odata.id"] = "/redfish/v1/Chassis/1";
-        Node::json["Thermal"] = {
+        res.jsonValue = Node::json;
+        res.jsonValue["@odata.id"] = "/redfish/v1/Chassis/1";
+        res.jsonValue["Thermal"] = {
             {"@odata.id", "/redfish/v1/Chassis/1/Thermal"}};
-        Node::json["Power"] = {{"@odata.id", "/redfish/v1/Chassis/1/Power"}};
-        Node::json["Links"]["ComputerSystems"] = {
+        res.jsonValue["Power"] = {{"@odata.id", "/redfish/v1/Chassis/1/Power"}};
+        res.jsonValue["Links"]["ComputerSystems"] = {
             {{"@odata.id", "/redfish/v1/Systems/1"}}};
-        Node::json["Links"]["ManagedBy"] = {
+        res.jsonValue["Links"]["ManagedBy"] = {
             {{"@odata.id", "/redfish/v1/Managers/bmc"}}};
-        Node::json["Actions"]["#Chassis.Reset"] = {
+        res.jsonValue["Actions"]["#Chassis.Reset"] = {
             {"target",
              "/redfish/v1/Chassis/1/Actions/Chassis.Reset"},
             {"ResetType@Redfish.AllowableValues",
              {"On", "ForceOff", "ForceRestart"}}};
 
-        auto asyncResp = std::make_shared<AsyncResp>(res);
-        asyncResp->res.jsonValue = Node::json;
+        auto asyncResp = AsyncResp::create(res);
 
         // Get chassis information:
         //        Name,
@@ -486,7 +501,7 @@ class ChassisCollection : public Node
                const std::vector<std::string> &params) override
     {
         res.jsonValue = Node::json;
-        res.end();
+        aggregator().appendMembers("/redfish/v1/Chassis", res);
     }
 };
 } // namespace redfish
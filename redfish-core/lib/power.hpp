@@ -56,11 +56,11 @@ class Power : public Node
 
         // Add specific Chassis sub-node name: Power
         const std::string& subNodeName = "Power";
-        Node::json["@odata.id"] =
-            "/redfish/v1/Chassis/" + chassisName + "/Power";
         res.jsonValue = Node::json;
-        auto sensorAsyncResp = std::make_shared<SensorAsyncResp>(
-            res, chassisName,
+        res.jsonValue["@odata.id"] =
+            "/redfish/v1/Chassis/" + chassisName + "/Power";
+        auto sensorAsyncResp = crow::allocateShared<SensorAsyncResp>(
+            res.arena, res, chassisName,
             std::initializer_list<const char*>{
                 "/xyz/openbmc_project/sensors/voltage",
                 "/xyz/openbmc_project/sensors/power"},
@@ -18,6 +18,7 @@
 #include "error_messages.hpp"
 #include "node.hpp"
 #include "persistent_data_middleware.hpp"
+#include "utils/json_utils.hpp"
 
 namespace redfish
 {
@@ -63,12 +64,12 @@ class Sessions : public Node
             return;
         }
 
-        Node::json["Id"] = session->uniqueId;
-        Node::json["UserName"] = session->username;
-        Node::json["@odata.id"] =
+        res.jsonValue = Node::json;
+        res.jsonValue["Id"] = session->uniqueId;
+        res.jsonValue["UserName"] = session->username;
+        res.jsonValue["@odata.id"] =
             "/redfish/v1/SessionService/Sessions/" + session->uniqueId;
 
-        res.jsonValue = Node::json;
         res.end();
     }
 
@@ -149,115 +150,77 @@ class SessionCollection : public Node
     void doGet(crow::Response& res, const crow::Request& req,
                const std::vector<std::string>& params) override
     {
+        query_util::Paging paging;
+        if (!getPaging(req, res, paging))
+        {
+            return;
+        }
         std::vector<const std::string*> sessionIds =
             crow::persistent_data::SessionStore::getInstance().getUniqueIds(
                 false, crow::persistent_data::PersistenceType::TIMEOUT);
-
-        Node::json["Members@odata.count"] = sessionIds.size();
-        Node::json["Members"] = nlohmann::json::array();
-        for (const std::string* uid : sessionIds)
-        {
-            Node::json["Members"].push_back(
-                {{"@odata.id", "/redfish/v1/SessionService/Sessions/" + *uid}});
-        }
+        std::sort(sessionIds.begin(), sessionIds.end(),
+                  [](const std::string* left, const std::string* right) {
+                      return *left < *right;
+                  });
 
         res.jsonValue = Node::json;
+        paging.addMembers(res.jsonValue, "/redfish/v1/SessionService/Sessions",
+                          sessionIds.size(), [&sessionIds](size_t i) {
+                              return "/redfish/v1/SessionService/Sessions/" +
+                                     *sessionIds[i];
+                          });
+
         res.end();
     }
 
     void doPost(crow::Response& res, const crow::Request& req,
                 const std::vector<std::string>& params) override
     {
-        nlohmann::json postRequest;
-        if (!json_util::processJsonFromRequest(res, req, postRequest))
-        {
-            res.end();
-            return;
-        }
-
         std::string username;
         std::string password;
-        for (const auto& item : postRequest.items())
+        if (!json_util::readJson(req, res, "UserName", username, "Password",
+                                 password))
         {
-            const std::string* strVal =
-                item.value().get_ptr<const std::string*>();
-            if (item.key() == "UserName")
-            {
-                if (strVal == nullptr)
-                {
-                    res.result(boost::beast::http::status::bad_request);
-                    messages::addMessageToErrorJson(
-                        res.jsonValue, messages::propertyValueTypeError(
-                                           item.value().dump(), item.key()));
-                    continue;
-                }
-                username = *strVal;
-            }
-            else if (item.key() == "Password")
-            {
-                if (strVal == nullptr)
-                {
-                    res.result(boost::beast::http::status::bad_request);
-                    messages::addMessageToErrorJson(
-                        res.jsonValue, messages::propertyValueTypeError(
-                                           item.value().dump(), item.key()));
-                    continue;
-                }
-
-                password = *strVal;
-            }
-            else
-            {
-                res.result(boost::beast::http::status::bad_request);
-                messages::addMessageToErrorJson(
-                    res.jsonValue, messages::propertyUnknown(item.key()));
-                continue;
-            }
-        }
-
-        if (password.empty() || username.empty() ||
-            res.result() != boost::beast::http::status::ok)
-        {
-            if (username.empty())
-            {
-                res.result(boost::beast::http::status::bad_request);
-                messages::addMessageToErrorJson(
-                    res.jsonValue, messages::propertyMissing("UserName"));
-            }
-
-            if (password.empty())
-            {
-                res.result(boost::beast::http::status::bad_request);
-                messages::addMessageToErrorJson(
-                    res.jsonValue, messages::propertyMissing("Password"));
-            }
             res.end();
-
             return;
         }
-
-        if (!pamAuthenticateUser(username, password))
+        // Empty credentials count as missing
+        if (username.empty() || password.empty())
         {
-
-            res.result(boost::beast::http::status::unauthorized);
+            res.result(boost::beast::http::status::bad_request);
             messages::addMessageToErrorJson(
-                res.jsonValue,
-                messages::resourceAtUriUnauthorized(
-                    std::string(req.url), "Invalid username or password"));
+                res.jsonValue, messages::propertyMissing(
+                                   username.empty() ? "UserName" : "Password"));
             res.end();
-
             return;
         }
 
-        // User is authenticated - create session
-        std::shared_ptr<crow::persistent_data::UserSession> session =
-            crow::persistent_data::SessionStore::getInstance()
-                .generateUserSession(username);
-        res.addHeader("X-Auth-Token", session->sessionToken);
-        res.addHeader("Location", "/redfish/v1/SessionService/Sessions/" +
-                                      session->uniqueId);
-        res.result(boost::beast::http::status::created);
-        memberSession.doGet(res, req, {session->uniqueId});
+        pamAuthenticateUserAsync(
+            *req.ioService, username, std::move(password),
+            [this, &req, &res, username](bool authenticated) {
+                if (!authenticated)
+                {
+                    res.result(boost::beast::http::status::unauthorized);
+                    messages::addMessageToErrorJson(
+                        res.jsonValue,
+                        messages::resourceAtUriUnauthorized(
+                            std::string(req.url),
+                            "Invalid username or password"));
+                    res.end();
+                    return;
+                }
+
+                // User is authenticated - create session
+                std::shared_ptr<crow::persistent_data::UserSession> session =
+                    crow::persistent_data::SessionStore::getInstance()
+                        .generateUserSession(username);
+                res.addHeader("X-Auth-Token", session->sessionToken);
+                res.addHeader("Location",
+                              "/redfish/v1/SessionService/Sessions/" +
+                                  session->uniqueId);
+                res.result(boost::beast::http::status::created);
+                memberSession.doGet(res, req, {session->uniqueId});
+            });
     }
 
     /**
@@ -285,6 +248,8 @@ class SessionService : public Node
         Node::json["ServiceEnabled"] = true;
         Node::json["Status"] = {{"State", "Enabled"}, {"Health", "OK"}};
 
+        staticJson = true;
+
         entityPrivileges = {
             {boost::beast::http::verb::get, {{"Login"}}},
             {boost::beast::http::verb::head, {{"Login"}}},
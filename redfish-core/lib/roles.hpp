@@ -45,7 +45,7 @@ class Roles : public Node
                const std::vector<std::string>& params) override
     {
         res.jsonValue = Node::json;
-        auto asyncResp = std::make_shared<AsyncResp>(res);
+        auto asyncResp = AsyncResp::create(res);
 
         const std::string& role = params[0];
         if (role == "Administrator")
@@ -99,6 +99,8 @@ class RoleCollection : public Node
             {{"@odata.id", "/redfish/v1/AccountService/Roles/Operator"}},
             {{"@odata.id", "/redfish/v1/AccountService/Roles/ReadOnly"}}};
 
+        staticJson = true;
+
         entityPrivileges = {
             {boost::beast::http::verb::get, {{"Login"}}},
             {boost::beast::http::verb::head, {{"Login"}}},
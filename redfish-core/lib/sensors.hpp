@@ -18,11 +18,18 @@
 
 #include <math.h>
 
+#include <algorithm>
+#include <array>
 #include <boost/algorithm/string/predicate.hpp>
-#include <boost/algorithm/string/split.hpp>
 #include <boost/container/flat_map.hpp>
 #include <boost/range/algorithm/replace_copy_if.hpp>
+#include <boost/utility/string_view.hpp>
 #include <dbus_singleton.hpp>
+#include <dbus_utility.hpp>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <signal_store.hpp>
 
 namespace redfish
 {
@@ -44,6 +51,11 @@ using ManagedObjectsVectorType = std::vector<std::pair<
     boost::container::flat_map<
         std::string, boost::container::flat_map<std::string, SensorVariant>>>>;
 
+// A GetManagedObjects reply as ManagedObjectsReader reads it, for replies
+// that are only looked through and not kept
+using SensorObjectsReply =
+    crow::connections::ManagedObjectsReader<SensorVariant>::Reply;
+
 /**
  * SensorAsyncResp
  * Gathers data needed for response processing after async calls are done
@@ -53,15 +65,15 @@ class SensorAsyncResp
   public:
     SensorAsyncResp(crow::Response& response, const std::string& chassisId,
 #ifdef OCP_CUSTOM_FLAG // Add specific sub-Node
-                    const std::initializer_list<const char*> types,
+                    std::vector<const char*> types,
                     const std::string& subNode) :
         chassisId(chassisId),
-        res(response), types(types), chassisSubNode(subNode)
+        res(response), types(std::move(types)), chassisSubNode(subNode)
     {
 #else
-                    const std::initializer_list<const char*> types) :
+                    std::vector<const char*> types) :
         chassisId(chassisId),
-        res(response), types(types)
+        res(response), types(std::move(types))
     {
         res.jsonValue["@odata.id"] =
             "/redfish/v1/Chassis/" + chassisId + "/Thermal";
@@ -94,109 +106,260 @@ class SensorAsyncResp
 };
 
 /**
- * @brief Creates connections necessary for chassis sensors
- * @param SensorsAsyncResp Pointer to object holding response data
- * @param sensorNames Sensors retrieved from chassis
- * @param callback Callback for processing gathered connections
+ * @brief Splits a sensor object path into the sensor's type and name,
+ *        without copying either
+ * @param path  Object path, /xyz/openbmc_project/sensors/<type>/<name>
+ * @param type  Receives the sensor type, pointing into path
+ * @param name  Receives the sensor name, pointing into path
+ * @return false if path isn't that of a sensor
  */
-template <typename Callback>
-void getConnections(const std::shared_ptr<SensorAsyncResp>& sensorAsyncResp,
-#ifndef OCP_CUSTOM_FLAG
-                    const boost::container::flat_set<std::string>& sensorNames,
-#endif
-                    Callback&& callback)
+inline bool splitSensorPath(boost::string_view path, boost::string_view& type,
+                            boost::string_view& name)
 {
-    BMCWEB_LOG_DEBUG << "getConnections";
-    const std::string path = "/xyz/openbmc_project/sensors";
-    const std::array<std::string, 1> interfaces = {
-        "xyz.openbmc_project.Sensor.Value"};
+    const boost::string_view prefix = "/xyz/openbmc_project/sensors/";
+    if (!path.starts_with(prefix))
+    {
+        return false;
+    }
+    path.remove_prefix(prefix.size());
+    boost::string_view::size_type typeEnd = path.find('/');
+    if (typeEnd == boost::string_view::npos || typeEnd == 0 ||
+        typeEnd + 1 == path.size() || path[typeEnd + 1] == '/')
+    {
+        return false;
+    }
+    type = path.substr(0, typeEnd);
+    name = path.substr(typeEnd + 1);
+    name = name.substr(0, name.find('/'));
+    return true;
+}
 
-    // Response handler for parsing objects subtree
-    auto respHandler = [callback{std::move(callback)}, sensorAsyncResp
-#ifdef OCP_CUSTOM_FLAG
-                        ](const boost::system::error_code ec,
-#else
-                        sensorNames](const boost::system::error_code ec,
-#endif
-                                     const GetSubTreeType& subtree) {
-        if (ec != 0)
-        {
-            sensorAsyncResp->setErrorStatus();
-            BMCWEB_LOG_ERROR << "Dbus error " << ec;
-            return;
-        }
+/**
+ * @brief Finds a key in a flat_map keyed by std::string without building a
+ *        std::string out of it
+ * @param map  Map to look in
+ * @param key  Key to look for
+ * @return Iterator to the entry, or map.end()
+ */
+template <typename Map>
+auto findSensorEntry(Map& map, boost::string_view key) -> decltype(map.end())
+{
+    auto it = std::lower_bound(
+        map.begin(), map.end(), key,
+        [](const typename Map::value_type& entry, boost::string_view key) {
+            return boost::string_view(entry.first) < key;
+        });
+    if (it != map.end() && boost::string_view(it->first) == key)
+    {
+        return it;
+    }
+    return map.end();
+}
 
-        BMCWEB_LOG_DEBUG << "Found " << subtree.size() << " subtrees";
+/**
+ * SensorStore
+ * Keeps the properties of every sensor under /xyz/openbmc_project/sensors in
+ * memory, so Thermal and Power are served without any D-Bus call.  It's
+ * loaded on first use, with one GetManagedObjects per sensor service, and
+ * kept current from PropertiesChanged signals.  Sensors coming or going, or
+ * a service starting or stopping, drops it; the next request loads it again.
+ */
+class SensorStore
+{
+  public:
+    // Properties of a sensor by interface, as GetManagedObjects returns them
+    using Interfaces = boost::container::flat_map<
+        std::string, boost::container::flat_map<std::string, SensorVariant>>;
+    // Sensors of one type, by name
+    using Table = boost::container::flat_map<std::string, Interfaces>;
+    // Tables of sensors, by sensor type
+    using Tables = boost::container::flat_map<std::string, Table>;
+
+    SensorStore() : store(listener(), [this](uint64_t generation) {
+                          load(generation);
+                      })
+    {
+    }
 
-        // Make unique list of connections only for requested sensor types and
-        // found in the chassis
-        boost::container::flat_set<std::string> connections;
-        // Intrinsic to avoid malloc.  Most systems will have < 8 sensor
-        // producers
-        connections.reserve(8);
+    /**
+     * @brief Calls back once every sensor is in the store
+     * @param callback  Called with whether the sensors could be read, and
+     *                  the sensors
+     */
+    template <typename Handler> void get(Handler&& callback)
+    {
+        store.get(std::forward<Handler>(callback));
+    }
 
-#ifndef OCP_CUSTOM_FLAG
-        BMCWEB_LOG_DEBUG << "sensorNames list cout: " << sensorNames.size();
-        for (const std::string& tsensor : sensorNames)
+    void invalidate()
+    {
+        store.invalidate();
+    }
+
+    // Unsubscribes from the signal dispatcher
+    void stop()
+    {
+        store.stop();
+    }
+
+  private:
+    static bool isSensor(const std::string& path)
+    {
+        return boost::starts_with(path, "/xyz/openbmc_project/sensors/");
+    }
+
+    crow::connections::SignalDispatcher::Listener listener()
+    {
+        crow::connections::SignalDispatcher::Listener listener;
+        listener.propertyValues = [this](const std::string& path,
+                                         const std::string&,
+                                         sdbusplus::message::message& message) {
+            if (isSensor(path))
+            {
+                std::string interface;
+                boost::container::flat_map<std::string, SensorVariant> values;
+                message.read(interface, values);
+                update(path, interface, values);
+            }
+        };
+        listener.objectChanged = [this](const std::string& path) {
+            if (isSensor(path))
+            {
+                invalidate();
+            }
+        };
+        listener.serviceChanged = [this](const std::string&) {
+            invalidate();
+        };
+        return listener;
+    }
+
+    void update(boost::string_view path, const std::string& interface,
+                const boost::container::flat_map<std::string, SensorVariant>&
+                    values)
+    {
+        boost::string_view type;
+        boost::string_view name;
+        if (!splitSensorPath(path, type, name))
         {
-            BMCWEB_LOG_DEBUG << "Sensor to find: " << tsensor;
+            return;
         }
-#endif
+        Tables& sensorTables = store.data();
+        auto table = findSensorEntry(sensorTables, type);
+        if (table == sensorTables.end())
+        {
+            return;
+        }
+        auto sensor = findSensorEntry(table->second, name);
+        if (sensor == table->second.end())
+        {
+            return;
+        }
+        boost::container::flat_map<std::string, SensorVariant>& properties =
+            sensor->second[interface];
+        for (const std::pair<std::string, SensorVariant>& value : values)
+        {
+            properties[value.first] = value.second;
+        }
+    }
 
-        for (const std::pair<
-                 std::string,
-                 std::vector<std::pair<std::string, std::vector<std::string>>>>&
-                 object : subtree)
+    void add(const ManagedObjectsVectorType& objects)
+    {
+        boost::string_view type;
+        boost::string_view name;
+        for (const auto& objDictEntry : objects)
         {
-            for (const char* type : sensorAsyncResp->types)
+            const std::string& objPath =
+                static_cast<const std::string&>(objDictEntry.first);
+            if (!splitSensorPath(objPath, type, name))
             {
-                if (boost::starts_with(object.first, type))
+                BMCWEB_LOG_ERROR << "Got path that isn't a sensor " << objPath;
+                continue;
+            }
+            store.data()[type.to_string()][name.to_string()] =
+                objDictEntry.second;
+        }
+    }
+
+    void load(uint64_t loadGeneration)
+    {
+        BMCWEB_LOG_DEBUG << "Loading sensor store";
+        const std::array<std::string, 1> interfaces = {
+            "xyz.openbmc_project.Sensor.Value"};
+
+        crow::connections::cachedMethodCall(
+            [this, loadGeneration](const boost::system::error_code ec,
+                                   const GetSubTreeType& subtree) {
+                if (ec)
+                {
+                    BMCWEB_LOG_ERROR << "Dbus error " << ec;
+                    finishLoad(false, loadGeneration);
+                    return;
+                }
+                boost::container::flat_set<std::string> connections;
+                // Most systems will have < 8 sensor producers
+                connections.reserve(8);
+                for (const auto& object : subtree)
                 {
-                    auto lastPos = object.first.rfind('/');
-                    if (lastPos != std::string::npos)
+                    for (const auto& objData : object.second)
                     {
-#ifdef OCP_CUSTOM_FLAG // Remove unused parameter: sensorNames.
-                        // Add connection list.
-                        for (const std::pair<std::string,
-                                             std::vector<std::string>>& objData
-                                    : object.second)
-                        {
-                            BMCWEB_LOG_DEBUG << "objData.first: "
-                                             << objData.first;
-                            connections.insert(objData.first);
-                        }
-#else
-                        std::string sensorName =
-                            object.first.substr(lastPos + 1);
-
-                        if (sensorNames.find(sensorName) != sensorNames.end())
-                        {
-                            // For each connection name
-                            for (const std::pair<std::string,
-                                                 std::vector<std::string>>&
-                                     objData : object.second)
+                        connections.insert(objData.first);
+                    }
+                }
+                if (connections.empty())
+                {
+                    finishLoad(true, loadGeneration);
+                    return;
+                }
+
+                auto pending = std::make_shared<size_t>(connections.size());
+                auto failed = std::make_shared<bool>(false);
+                for (const std::string& connection : connections)
+                {
+                    crow::connections::coalescedMethodCall(
+                        [this, loadGeneration, pending,
+                         failed](const boost::system::error_code ec,
+                                 const ManagedObjectsVectorType& resp) {
+                            if (ec)
                             {
-                                connections.insert(objData.first);
+                                BMCWEB_LOG_ERROR
+                                    << "GetManagedObjects DBUS error: " << ec;
+                                *failed = true;
                             }
-                        }
-#endif
-                    }
-                    break;
+                            else
+                            {
+                                add(resp);
+                            }
+                            if (--*pending == 0)
+                            {
+                                finishLoad(!*failed, loadGeneration);
+                            }
+                        },
+                        connection, "/xyz/openbmc_project/sensors",
+                        "org.freedesktop.DBus.ObjectManager",
+                        "GetManagedObjects");
                 }
-            }
-        }
+            },
+            "xyz.openbmc_project.ObjectMapper",
+            "/xyz/openbmc_project/object_mapper",
+            "xyz.openbmc_project.ObjectMapper", "GetSubTree",
+            "/xyz/openbmc_project/sensors", 2, interfaces);
+    }
 
-        BMCWEB_LOG_DEBUG << "Found " << connections.size() << " connections";
-        callback(std::move(connections));
-        BMCWEB_LOG_DEBUG << "getConnections respHandler exit";
-    };
+    void finishLoad(bool ok, uint64_t loadGeneration)
+    {
+        BMCWEB_LOG_DEBUG << "Sensor store loaded " << store.data().size()
+                         << " sensor types";
+        store.finish(ok, loadGeneration);
+    }
+
+    crow::connections::SignalStore<Tables> store;
+};
 
-    // Make call to ObjectMapper to find all sensors objects
-    crow::connections::systemBus->async_method_call(
-        std::move(respHandler), "xyz.openbmc_project.ObjectMapper",
-        "/xyz/openbmc_project/object_mapper",
-        "xyz.openbmc_project.ObjectMapper", "GetSubTree", path, 2, interfaces);
-    BMCWEB_LOG_DEBUG << "getConnections exit";
+inline SensorStore& sensorStore()
+{
+    static SensorStore store;
+    return store;
 }
 
 #ifndef OCP_CUSTOM_FLAG // Comment out getChassis method
@@ -213,8 +376,8 @@ void getChassis(std::shared_ptr<SensorAsyncResp> sensorAsyncResp,
     BMCWEB_LOG_DEBUG << "getChassis enter";
     // Process response from EntityManager and extract chassis data
     auto respHandler = [callback{std::move(callback)},
-                        sensorAsyncResp](const boost::system::error_code ec,
-                                         ManagedObjectsVectorType& resp) {
+                        sensorAsyncResp](const boost::system::error_code& ec,
+                                         const SensorObjectsReply& resp) {
         BMCWEB_LOG_DEBUG << "getChassis respHandler enter";
         if (ec)
         {
@@ -226,35 +389,28 @@ void getChassis(std::shared_ptr<SensorAsyncResp> sensorAsyncResp,
 
         //   sensorAsyncResp->chassisId
         bool foundChassis = false;
-        std::vector<std::string> split;
-        // Reserve space for
-        // /xyz/openbmc_project/inventory/<name>/<subname> + 3 subnames
-        split.reserve(8);
-
-        for (const auto& objDictEntry : resp)
+        for (const auto& object : resp->objects())
         {
-            const std::string& objectPath =
-                static_cast<const std::string&>(objDictEntry.first);
-            boost::algorithm::split(split, objectPath, boost::is_any_of("/"));
-            if (split.size() < 2)
+            boost::string_view objectPath = object.path;
+            // Paths are /xyz/openbmc_project/inventory/.../<chassis>/<sensor>
+            boost::string_view::size_type nameStart = objectPath.rfind('/');
+            if (nameStart == boost::string_view::npos)
             {
                 BMCWEB_LOG_ERROR << "Got path that isn't long enough "
                                  << objectPath;
-                split.clear();
                 continue;
             }
-            const std::string& sensorName = split.end()[-1];
-            const std::string& chassisName = split.end()[-2];
+            boost::string_view sensorName = objectPath.substr(nameStart + 1);
+            boost::string_view chassisName = objectPath.substr(0, nameStart);
+            chassisName = chassisName.substr(chassisName.rfind('/') + 1);
 
             if (chassisName != sensorAsyncResp->chassisId)
             {
-                split.clear();
                 continue;
             }
             BMCWEB_LOG_DEBUG << "New sensor: " << sensorName;
             foundChassis = true;
-            sensorNames.emplace(sensorName);
-            split.clear();
+            sensorNames.emplace(sensorName.to_string());
         };
         BMCWEB_LOG_DEBUG << "Found " << sensorNames.size() << " Sensor names";
 
@@ -272,24 +428,141 @@ void getChassis(std::shared_ptr<SensorAsyncResp> sensorAsyncResp,
     };
 
     // Make call to EntityManager to find all chassis objects
-    crow::connections::systemBus->async_method_call(
-        respHandler, "xyz.openbmc_project.EntityManager", "/",
-        "org.freedesktop.DBus.ObjectManager", "GetManagedObjects");
+    crow::connections::getManagedObjects<SensorVariant>(
+        respHandler, "xyz.openbmc_project.EntityManager", "/");
     BMCWEB_LOG_DEBUG << "getChassis exit";
 }
 #endif // OCP_CUSTOM_FLAG
 
+/**
+ * @brief A D-Bus sensor property and the Redfish property it maps to
+ */
+struct SensorProperty
+{
+    const char* interface;
+    const char* dbusName;
+    const char* redfishName;
+    // Whether the Scale of the sensor applies to the value
+    bool scaled;
+};
+
+constexpr std::array<SensorProperty, 6> thresholdProperties = {{
+    {"xyz.openbmc_project.Sensor.Threshold.Warning", "WarningHigh",
+     "UpperThresholdNonCritical", true},
+    {"xyz.openbmc_project.Sensor.Threshold.Warning", "WarningLow",
+     "LowerThresholdNonCritical", true},
+    {"xyz.openbmc_project.Sensor.Threshold.Critical", "CriticalHigh",
+     "UpperThresholdCritical", true},
+    {"xyz.openbmc_project.Sensor.Threshold.Critical", "CriticalLow",
+     "LowerThresholdCritical", true},
+    {"xyz.openbmc_project.Sensor.Threshold.Fatal", "FatalHigh",
+     "UpperThresholdFatal", true},
+    {"xyz.openbmc_project.Sensor.Threshold.Fatal", "FatalLow",
+     "LowerThresholdFatal", true}}};
+
+constexpr SensorProperty temperatureProperties[] = {
+    {"xyz.openbmc_project.Sensor.Value", "MinValue", "MinReadingRangeTemp",
+     true},
+    {"xyz.openbmc_project.Sensor.Value", "MaxValue", "MaxReadingRangeTemp",
+     true},
+    {"xyz.openbmc_project.Sensor.Value", "SensorID", "SensorNumber", false}};
+
+constexpr SensorProperty voltageProperties[] = {
+    {"xyz.openbmc_project.Sensor.Value", "SensorID", "SensorNumber", false}};
+
+constexpr SensorProperty rangeProperties[] = {
+    {"xyz.openbmc_project.Sensor.Value", "MinValue", "MinReadingRange", true},
+    {"xyz.openbmc_project.Sensor.Value", "MaxValue", "MaxReadingRange", true}};
+
+/**
+ * @brief How the sensors of one D-Bus sensor type are shown in Redfish
+ */
+struct SensorTypeInfo
+{
+    // Type as it appears in the sensor object path
+    const char* type;
+    // Array of the Thermal or Power resource the sensors go in
+    const char* fieldName;
+    // Property the sensor value goes in
+    const char* unit;
+    const char* odataType;
+    // ReadingUnits of the sensors, if the schema has it
+    const char* readingUnits;
+    // Schemas like fan require integers, not floats, regardless of what is
+    // available on dbus
+    bool forceToInt;
+    // Properties besides the value and thresholds
+    const SensorProperty* propertiesBegin;
+    const SensorProperty* propertiesEnd;
+};
+
+// TODO(ed) Documentation says that path should be type fan_tach,
+// implementation seems to implement fan
+// TODO Power schema does not include MinReadingRange/MaxReadingRange, This
+// should be replaced by PowerInputWatts/PowerOutputWatts...
+constexpr std::array<SensorTypeInfo, 6> sensorTypes = {{
+    {"temperature", "Temperatures", "ReadingCelsius",
+     "#Thermal.v1_3_0.Temperature", nullptr, false,
+     temperatureProperties, std::end(temperatureProperties)},
+    {"fan", "Fans", "Reading", "#Thermal.v1_3_0.Fan", "RPM", true,
+     rangeProperties, std::end(rangeProperties)},
+    {"fan_tach", "Fans", "Reading", "#Thermal.v1_3_0.Fan", "RPM", true,
+     rangeProperties, std::end(rangeProperties)},
+    {"voltage", "Voltages", "ReadingVolts", "#Power.v1_0_0.Voltage", nullptr,
+     false, voltageProperties, std::end(voltageProperties)},
+    {"power", "PowerSupplies", "LastPowerOutputWatts",
+     "#Power.v1_5_0.PowerSupply", nullptr, false, nullptr, nullptr},
+    {"current", "PowerSupplies", "LastPowerOutputWatts",
+     "#Power.v1_5_0.PowerSupply", nullptr, false, rangeProperties,
+     std::end(rangeProperties)}}};
+
+/**
+ * @brief Looks up how a sensor type is shown.  The length and first letter
+ *        of the type pick its only possible entry in sensorTypes, so a
+ *        single compare confirms it.
+ * @param type  Type as it appears in the sensor object path
+ * @return The type's entry, or nullptr if Redfish has no place for it
+ */
+inline const SensorTypeInfo* findSensorType(boost::string_view type)
+{
+    size_t index = sensorTypes.size();
+    switch (type.size())
+    {
+        case 11:
+            index = 0; // temperature
+            break;
+        case 3:
+            index = 1; // fan
+            break;
+        case 8:
+            index = 2; // fan_tach
+            break;
+        case 7:
+            index = type[0] == 'v' ? 3 : 5; // voltage, current
+            break;
+        case 5:
+            index = 4; // power
+            break;
+        default:
+            return nullptr;
+    }
+    if (type != sensorTypes[index].type)
+    {
+        return nullptr;
+    }
+    return &sensorTypes[index];
+}
+
 /**
  * @brief Builds a json sensor representation of a sensor.
  * @param sensorName  The name of the sensor to be built
- * @param sensorType  The type (temperature, fan_tach, etc) of the sensor to
- * build
+ * @param typeInfo  How sensors of its type are shown
  * @param interfacesDict  A dictionary of the interfaces and properties of said
  * interfaces to be built from
  * @param sensor_json  The json object to fill
  */
 void objectInterfacesToJson(
-    const std::string& sensorName, const std::string& sensorType,
+    const std::string& sensorName, const SensorTypeInfo& typeInfo,
     const boost::container::flat_map<
         std::string, boost::container::flat_map<std::string, SensorVariant>>&
         interfacesDict,
@@ -322,146 +595,172 @@ void objectInterfacesToJson(
     sensor_json["Name"] = sensorName;
     sensor_json["Status"]["State"] = "Enabled";
     sensor_json["Status"]["Health"] = "OK";
-
-    // Parameter to set to override the type we get from dbus, and force it to
-    // int, regardless of what is available.  This is used for schemas like fan,
-    // that require integers, not floats.
-    bool forceToInt = false;
-
-    const char* unit = "Reading";
-    if (sensorType == "temperature")
-    {
-        unit = "ReadingCelsius";
-        sensor_json["@odata.type"] = "#Thermal.v1_3_0.Temperature";
-        // TODO(ed) Documentation says that path should be type fan_tach,
-        // implementation seems to implement fan
-    }
-    else if (sensorType == "fan" || sensorType == "fan_tach")
-    {
-        unit = "Reading";
-        sensor_json["ReadingUnits"] = "RPM";
-        sensor_json["@odata.type"] = "#Thermal.v1_3_0.Fan";
-        forceToInt = true;
-    }
-    else if (sensorType == "voltage")
-    {
-        unit = "ReadingVolts";
-        sensor_json["@odata.type"] = "#Power.v1_0_0.Voltage";
-    }
-    else if (sensorType == "power" || sensorType == "current")
-    {
-        unit = "LastPowerOutputWatts";
-        sensor_json["@odata.type"] = "#Power.v1_5_0.PowerSupply";
-    }
-    else
-    {
-        BMCWEB_LOG_ERROR << "Redfish cannot map object type for " << sensorName;
-        return;
-    }
-    // Map of dbus interface name, dbus property name and redfish property_name
-    std::vector<std::tuple<const char*, const char*, const char*>> properties;
-    properties.reserve(8);
-
-    properties.emplace_back("xyz.openbmc_project.Sensor.Value", "Value", unit);
-    properties.emplace_back("xyz.openbmc_project.Sensor.Threshold.Warning",
-                            "WarningHigh", "UpperThresholdNonCritical");
-    properties.emplace_back("xyz.openbmc_project.Sensor.Threshold.Warning",
-                            "WarningLow", "LowerThresholdNonCritical");
-    properties.emplace_back("xyz.openbmc_project.Sensor.Threshold.Critical",
-                            "CriticalHigh", "UpperThresholdCritical");
-    properties.emplace_back("xyz.openbmc_project.Sensor.Threshold.Critical",
-                            "CriticalLow", "LowerThresholdCritical");
-    properties.emplace_back("xyz.openbmc_project.Sensor.Threshold.Fatal",
-                            "FatalHigh", "UpperThresholdFatal");
-    properties.emplace_back("xyz.openbmc_project.Sensor.Threshold.Fatal",
-                            "FatalLow", "LowerThresholdFatal");
-
-    if (sensorType == "temperature")
-    {
-        properties.emplace_back("xyz.openbmc_project.Sensor.Value", "MinValue",
-                                "MinReadingRangeTemp");
-        properties.emplace_back("xyz.openbmc_project.Sensor.Value", "MaxValue",
-                                "MaxReadingRangeTemp");
-        properties.emplace_back("xyz.openbmc_project.Sensor.Value", "SensorID",
-                                "SensorNumber");
-    }
-    else if (sensorType == "voltage")
+    sensor_json["@odata.type"] = typeInfo.odataType;
+    if (typeInfo.readingUnits != nullptr)
     {
-        properties.emplace_back("xyz.openbmc_project.Sensor.Value", "SensorID",
-                                "SensorNumber");
+        sensor_json["ReadingUnits"] = typeInfo.readingUnits;
     }
-    else if (sensorType == "power")
+    const bool forceToInt = typeInfo.forceToInt;
+
+    const SensorProperty value = {"xyz.openbmc_project.Sensor.Value", "Value",
+                                  typeInfo.unit, true};
+    auto addProperty = [&](const SensorProperty& p) {
+        auto interfaceProperties = interfacesDict.find(p.interface);
+        if (interfaceProperties == interfacesDict.end())
+        {
+            return;
+        }
+        auto valueIt = interfaceProperties->second.find(p.dbusName);
+        if (valueIt == interfaceProperties->second.end())
+        {
+            return;
+        }
+        const SensorVariant& valueVariant = valueIt->second;
+        nlohmann::json& jsonValue = sensor_json[p.redfishName];
+
+        // Attempt to pull the int64 directly
+        const int64_t* int64Value = mapbox::getPtr<const int64_t>(valueVariant);
+
+        if (int64Value != nullptr)
+        {
+            auto value = 0;
+
+            // Don't need to adjust the value of Sensor ID
+            if (!p.scaled)
+            {
+                value = *int64Value;
+            }
+            else
+            {
+                value = *int64Value * std::pow(10, scaleMultiplier);
+            }
+
+            if (forceToInt || scaleMultiplier >= 0)
+            {
+                jsonValue = static_cast<int64_t>(value);
+            }
+            else
+            {
+                jsonValue = value;
+            }
+        }
+        // Attempt to pull the float directly
+        const double* doubleValue = mapbox::getPtr<const double>(valueVariant);
+
+        if (doubleValue != nullptr)
+        {
+            auto value = *doubleValue * std::pow(10, scaleMultiplier);
+            if (!forceToInt)
+            {
+                jsonValue = value;
+            }
+            else
+            {
+                jsonValue = static_cast<int64_t>(value);
+            }
+        }
+    };
+
+    addProperty(value);
+    for (const SensorProperty& p : thresholdProperties)
     {
-        // TODO Power schema does not include MinReadingRange/MaxReadingRange,
-        // This should be replaced by PowerInputWatts/PowerOutputWatts...
+        addProperty(p);
     }
-    else
+    for (const SensorProperty* p = typeInfo.propertiesBegin;
+         p != typeInfo.propertiesEnd; ++p)
     {
-        properties.emplace_back("xyz.openbmc_project.Sensor.Value", "MinValue",
-                                "MinReadingRange");
-        properties.emplace_back("xyz.openbmc_project.Sensor.Value", "MaxValue",
-                                "MaxReadingRange");
+        addProperty(*p);
     }
+    BMCWEB_LOG_DEBUG << "Added sensor " << sensorName;
+}
 
-    for (const std::tuple<const char*, const char*, const char*>& p :
-         properties)
+/**
+ * @brief Adds the requested sensors of the chassis to the response.
+ * @param sensorAsyncResp   Pointer to object holding response data
+ * @param sensorNames  Sensors of the chassis
+ * @param tables  Sensors by type, from the sensor store
+ */
+void addSensorsToJson(
+    const std::shared_ptr<SensorAsyncResp>& sensorAsyncResp,
+#ifndef OCP_CUSTOM_FLAG
+    const boost::container::flat_set<std::string>& sensorNames,
+#endif
+    const SensorStore::Tables& tables)
+{
+    for (const std::pair<std::string, SensorStore::Table>& table : tables)
     {
-        auto interfaceProperties = interfacesDict.find(std::get<0>(p));
-        if (interfaceProperties != interfacesDict.end())
+        const std::string& sensorType = table.first;
+#ifndef OCP_CUSTOM_FLAG
+        const std::string typePath =
+            "/xyz/openbmc_project/sensors/" + sensorType + "/";
+#endif
+        bool isMatchSensorType = false;
+        for (const char* type : sensorAsyncResp->types)
         {
-            auto valueIt = interfaceProperties->second.find(std::get<1>(p));
-            if (valueIt != interfaceProperties->second.end())
+#ifdef OCP_CUSTOM_FLAG
+            // only accept the object path consists requested type.
+            if (strstr(type, sensorType.c_str()))
+#else
+            if (boost::starts_with(typePath, type))
+#endif
             {
-                const SensorVariant& valueVariant = valueIt->second;
-                nlohmann::json& valueIt = sensor_json[std::get<2>(p)];
-
-                // Attempt to pull the int64 directly
-                const int64_t* int64Value =
-                    mapbox::getPtr<const int64_t>(valueVariant);
-
-                if (int64Value != nullptr)
-                {
-                    auto value = 0;
-
-                    // Don't need to adjust the value of Sensor ID
-                    if (std::get<1>(p) == "SensorID")
-                    {
-                        value = *int64Value;
-                    }
-                    else
-                    {
-                        value = *int64Value * std::pow(10, scaleMultiplier);
-                    }
+                isMatchSensorType = true;
+                break;
+            }
+        }
+        if (!isMatchSensorType)
+        {
+            BMCWEB_LOG_DEBUG << sensorType << " is not requested";
+            continue;
+        }
 
-                    if (forceToInt || scaleMultiplier >= 0)
-                    {
-                        valueIt = static_cast<int64_t>(value);
-                    }
-                    else
-                    {
-                        valueIt = value;
-                    }
-                }
-                // Attempt to pull the float directly
-                const double* doubleValue =
-                    mapbox::getPtr<const double>(valueVariant);
+        const SensorTypeInfo* typeInfo = findSensorType(sensorType);
+        if (typeInfo == nullptr)
+        {
+            BMCWEB_LOG_ERROR << "Unsure how to handle sensorType "
+                             << sensorType;
+            continue;
+        }
 
-                if (doubleValue != nullptr)
+        nlohmann::json* tempArray = nullptr;
+        for (const std::pair<std::string, SensorStore::Interfaces>& sensor :
+             table.second)
+        {
+            const std::string& sensorName = sensor.first;
+#ifndef OCP_CUSTOM_FLAG
+            if (sensorNames.find(sensorName) == sensorNames.end())
+            {
+                BMCWEB_LOG_DEBUG << sensorName << " not in sensor list ";
+                continue;
+            }
+#endif
+            if (tempArray == nullptr)
+            {
+                tempArray =
+                    &sensorAsyncResp->res.jsonValue[typeInfo->fieldName];
+                // Create the array if it doesn't yet exist
+                if (tempArray->is_array() == false)
                 {
-                    auto value = *doubleValue * std::pow(10, scaleMultiplier);
-                    if (!forceToInt)
-                    {
-                        valueIt = value;
-                    }
-                    else
-                    {
-                        valueIt = static_cast<int64_t>(value);
-                    }
+                    *tempArray = nlohmann::json::array();
                 }
             }
+
+            tempArray->push_back(nlohmann::json::object());
+            nlohmann::json& sensorJson = tempArray->back();
+#ifdef OCP_CUSTOM_FLAG // @odata.id belongs to specific Chassis sub-node name.
+            sensorJson["@odata.id"] = "/redfish/v1/Chassis/" +
+                                      sensorAsyncResp->chassisId + "/" +
+                                      sensorAsyncResp->chassisSubNode + "#/" +
+                                      sensorName;
+#else
+            sensorJson["@odata.id"] = "/redfish/v1/Chassis/" +
+                                      sensorAsyncResp->chassisId +
+                                      "/Thermal#/" + sensorName;
+#endif // OCP_CUSTOM_FLAG
+            objectInterfacesToJson(sensorName, *typeInfo, sensor.second,
+                                   sensorJson);
         }
     }
-    BMCWEB_LOG_DEBUG << "Added sensor " << sensorName;
 }
 
 /**
@@ -473,172 +772,31 @@ void getChassisData(std::shared_ptr<SensorAsyncResp> sensorAsyncResp)
 {
     BMCWEB_LOG_DEBUG << "getChassisData enter";
 #ifdef OCP_CUSTOM_FLAG // Remove unused parameter: sensorNames
-    auto getConnectionCb = [&, sensorAsyncResp](
+    sensorStore().get(
+        [sensorAsyncResp](bool ok, const SensorStore::Tables& tables) {
+            if (!ok)
+            {
+                sensorAsyncResp->setErrorStatus();
+                return;
+            }
+            addSensorsToJson(sensorAsyncResp, tables);
+        });
 #else
-    auto getChassisCb = [&, sensorAsyncResp](
-        boost::container::flat_set<std::string>& sensorNames) {
+    auto getChassisCb = [sensorAsyncResp](
+                            boost::container::flat_set<std::string>&
+                                sensorNames) {
         BMCWEB_LOG_DEBUG << "getChassisCb enter";
-        auto getConnectionCb =
-            [&, sensorAsyncResp, sensorNames](
-#endif //OCP_CUSTOM_FLAG
-                const boost::container::flat_set<std::string>& connections) {
-                BMCWEB_LOG_DEBUG << "getConnectionCb enter";
-                // Get managed objects from all services exposing sensors
-                for (const std::string& connection : connections)
-                {
-                    // Response handler to process managed objects
-#ifdef OCP_CUSTOM_FLAG
-                    auto getManagedObjectsCb =
-                        [&, sensorAsyncResp
-                         ](const boost::system::error_code ec,
-#else
-                    auto getManagedObjectsCb =
-                        [&, sensorAsyncResp,
-                         sensorNames](const boost::system::error_code ec,
-#endif
-                                      ManagedObjectsVectorType& resp) {
-                            BMCWEB_LOG_DEBUG << "getManagedObjectsCb enter";
-                            if (ec)
-                            {
-                                BMCWEB_LOG_ERROR
-                                    << "getManagedObjectsCb DBUS error: " << ec;
-                                sensorAsyncResp->setErrorStatus();
-                                return;
-                            }
-                            // Go through all objects and update response with
-                            // sensor data
-                            for (const auto& objDictEntry : resp)
-                            {
-                                const std::string& objPath =
-                                    static_cast<const std::string&>(
-                                        objDictEntry.first);
-                                BMCWEB_LOG_DEBUG
-                                    << "getManagedObjectsCb parsing object "
-                                    << objPath;
-
-                                std::vector<std::string> split;
-                                // Reserve space for
-                                // /xyz/openbmc_project/sensors/<name>/<subname>
-                                split.reserve(6);
-                                boost::algorithm::split(split, objPath,
-                                                        boost::is_any_of("/"));
-                                if (split.size() < 6)
-                                {
-                                    BMCWEB_LOG_ERROR
-                                        << "Got path that isn't long enough "
-                                        << objPath;
-                                    continue;
-                                }
-                                // These indexes aren't intuitive, as
-                                // boost::split puts an empty string at the
-                                // beggining
-                                const std::string& sensorType = split[4];
-                                const std::string& sensorName = split[5];
-                                BMCWEB_LOG_DEBUG << "sensorName " << sensorName
-                                                 << " sensorType "
-                                                 << sensorType;
-#ifdef OCP_CUSTOM_FLAG
-                                // Verify each object path
-                                bool isMatchSensorType = false;
-                                for (const char* type : sensorAsyncResp->types)
-                                {
-                                    // only accept the object path consists
-                                    // requested type.
-                                    if (strstr(type, sensorType.c_str()))
-                                    {
-                                        isMatchSensorType = true;
-                                        break;
-                                    }
-                                }
-                                if (!isMatchSensorType)
-                                {
-                                    BMCWEB_LOG_DEBUG << sensorType
-                                                     << " is not requested";
-                                    continue;
-                                }
-#else
-                                if (sensorNames.find(sensorName) ==
-                                    sensorNames.end())
-                                {
-                                    BMCWEB_LOG_ERROR << sensorName
-                                                     << " not in sensor list ";
-                                    continue;
-                                }
-#endif
-                                const char* fieldName = nullptr;
-                                if (sensorType == "temperature")
-                                {
-                                    fieldName = "Temperatures";
-                                }
-                                else if (sensorType == "fan" ||
-                                         sensorType == "fan_tach")
-                                {
-                                    fieldName = "Fans";
-                                }
-                                else if (sensorType == "voltage")
-                                {
-                                    fieldName = "Voltages";
-                                }
-                                else if (sensorType == "current")
-                                {
-                                    fieldName = "PowerSupplies";
-                                }
-                                else if (sensorType == "power")
-                                {
-                                    fieldName = "PowerSupplies";
-                                }
-                                else
-                                {
-                                    BMCWEB_LOG_ERROR
-                                        << "Unsure how to handle sensorType "
-                                        << sensorType;
-                                    continue;
-                                }
-
-                                nlohmann::json& tempArray =
-                                    sensorAsyncResp->res.jsonValue[fieldName];
-
-                                // Create the array if it doesn't yet exist
-                                if (tempArray.is_array() == false)
-                                {
-                                    tempArray = nlohmann::json::array();
-                                }
-
-                                tempArray.push_back(nlohmann::json::object());
-                                nlohmann::json& sensorJson = tempArray.back();
-#ifdef OCP_CUSTOM_FLAG // @odata.id belongs to specific Chassis sub-node name.
-                                sensorJson["@odata.id"] =
-                                    "/redfish/v1/Chassis/" +
-                                    sensorAsyncResp->chassisId + "/" +
-                                    sensorAsyncResp->chassisSubNode + "#/" +
-                                    sensorName;
-#else
-                                sensorJson["@odata.id"] =
-                                    "/redfish/v1/Chassis/" +
-                                    sensorAsyncResp->chassisId + "/Thermal#/" +
-                                    sensorName;
-#endif // OCP_CUSTOM_FLAG
-                                objectInterfacesToJson(sensorName, sensorType,
-                                                       objDictEntry.second,
-                                                       sensorJson);
-                            }
-                            BMCWEB_LOG_DEBUG << "getManagedObjectsCb exit";
-                        };
-                    crow::connections::systemBus->async_method_call(
-                        getManagedObjectsCb, connection,
-                        "/xyz/openbmc_project/sensors",
-                        "org.freedesktop.DBus.ObjectManager",
-                        "GetManagedObjects");
-                };
-                BMCWEB_LOG_DEBUG << "getConnectionCb exit";
-            };
+        sensorStore().get([sensorAsyncResp,
+                           sensorNames{std::move(sensorNames)}](
+                              bool ok, const SensorStore::Tables& tables) {
+            if (!ok)
+            {
+                sensorAsyncResp->setErrorStatus();
+                return;
+            }
+            addSensorsToJson(sensorAsyncResp, sensorNames, tables);
+        });
         BMCWEB_LOG_DEBUG << "getChassisCb exit";
-        // get connections and then pass it to get sensors
-#ifdef OCP_CUSTOM_FLAG
-        getConnections(sensorAsyncResp, std::move(getConnectionCb));
-#else
-        getConnections(sensorAsyncResp, sensorNames,
-                       std::move(getConnectionCb));
     };
     // Get chassis information related to sensors
     getChassis(sensorAsyncResp, std::move(getChassisCb));
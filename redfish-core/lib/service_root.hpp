@@ -42,6 +42,16 @@ class ServiceRoot : public Node
             {{"@odata.id", "/redfish/v1/AmpereComputing"}};
 
         Node::json["UUID"] = getUuid();
+        Node::json["ProtocolFeaturesSupported"] = {
+            {"ExpandQuery",
+             {{"ExpandAll", true},
+              {"Levels", true},
+              {"Links", true},
+              {"NoLinks", true},
+              {"MaxLevels", query_util::maxExpandLevels}}},
+            {"SelectQuery", true}};
+
+        staticJson = true;
 
         entityPrivileges = {
             {boost::beast::http::verb::get, {}},
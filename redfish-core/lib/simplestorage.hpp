@@ -20,6 +20,7 @@
 #include "utils/ampere-utils.hpp"
 
 #include <boost/container/flat_map.hpp>
+#include <dbus_utility.hpp>
 
 namespace redfish
 {
@@ -43,7 +44,7 @@ using GetManagedObjectsType = boost::container::flat_map<
 void getSimpleStorageDevices(std::shared_ptr<AsyncResp> aResp)
 {
     BMCWEB_LOG_DEBUG << "Get simple storage device information.";
-    crow::connections::systemBus->async_method_call(
+    crow::connections::coalescedMethodCall(
         [aResp](const boost::system::error_code ec,
                 const GetManagedObjectsType &resp) {
             if (ec)
@@ -146,7 +147,7 @@ class SimpleStorage : public Node
                const std::vector<std::string> &params) override
     {
         res.jsonValue = Node::json;
-        auto asyncResp = std::make_shared<AsyncResp>(res);
+        auto asyncResp = AsyncResp::create(res);
         getSimpleStorageDevices(asyncResp);
     }
 };
@@ -19,584 +19,821 @@
 #include "boost/container/flat_map.hpp"
 #include "node.hpp"
 
+#include <boost/optional.hpp>
+#include <dbus_utility.hpp>
+#include <functional>
+#include <signal_store.hpp>
 #include <utils/json_utils.hpp>
+#include <utils/query_utils.hpp>
 
 namespace redfish
 {
 
 /**
- * @brief Retrieves Host Bios Version properties over D-Bus.
+ * @brief Fills in the Bios Version from the BiosInfo properties.
  *
- * @param[in] asyncResp  Shared pointer for completing asynchronous calls.
+ * @param[out] json        ComputerSystem resource.
+ * @param[in]  properties  Properties of the BiosInfo interface.
  *
  * @return None.
  */
-void getBiosVersion(std::shared_ptr<AsyncResp> asyncResp)
+void fillBiosVersion(nlohmann::json &json, const PropertiesType &properties)
 {
-    BMCWEB_LOG_DEBUG << "Get Bios Version enter.";
-    crow::connections::systemBus->async_method_call(
-        [asyncResp{std::move(asyncResp)}](const boost::system::error_code ec,
-                                          const PropertiesType &properties) {
-            if (ec)
-            {
-                BMCWEB_LOG_ERROR << "D-Bus response error " << ec;
-                asyncResp->res.result(
-                    boost::beast::http::status::internal_server_error);
-                return;
-            }
-            std::string output{}; // Initial output Bios Version as Null.
-            PropertiesType::const_iterator it = properties.find("BiosVersion");
-            if (it != properties.end())
-            {
-                const std::string *s =
-                    mapbox::getPtr<const std::string>(it->second);
-                BMCWEB_LOG_DEBUG << "Found BiosVersion: " << *s;
-                if (nullptr != s)
-                {
-                    output = *s;
-                }
-            }
-            // Update JSON payload with Bios Version information.
-            asyncResp->res.jsonValue["BiosVersion"] = output;
-        },
-        "xyz.openbmc_project.Inventory.Host.Manager",
-        "/xyz/openbmc_project/inventory/host/bios",
-        "org.freedesktop.DBus.Properties", "GetAll",
-        "xyz.openbmc_project.Inventory.Item.BiosInfo");
+    std::string output{}; // Initial output Bios Version as Null.
+    PropertiesType::const_iterator it = properties.find("BiosVersion");
+    if (it != properties.end())
+    {
+        const std::string *s = mapbox::getPtr<const std::string>(it->second);
+        if (nullptr != s)
+        {
+            BMCWEB_LOG_DEBUG << "Found BiosVersion: " << *s;
+            output = *s;
+        }
+    }
+    // Update JSON payload with Bios Version information.
+    json["BiosVersion"] = output;
 }
 
 /**
- * Function that retrieves all properties of boot interface.
- * @param[in] asyncResp     Shared pointer for completing asynchronous calls.
+ * @brief Fills in the boot override policy from the BiosInfo properties.
+ *
+ * @param[out] json        ComputerSystem resource.
+ * @param[in]  properties  Properties of the BiosInfo interface.
+ *
  * @return None.
  */
-void getBootPolicy(std::shared_ptr<AsyncResp> asyncResp)
+void fillBootPolicy(nlohmann::json &json, const PropertiesType &properties)
 {
-    BMCWEB_LOG_DEBUG << "Get boot policy enter.";
-    crow::connections::systemBus->async_method_call(
-        [asyncResp](const boost::system::error_code ec,
-                    const PropertiesType &properties) {
-            if (ec)
-            {
-                BMCWEB_LOG_ERROR << "D-Bus response error " << ec;
-                asyncResp->res.result(
-                    boost::beast::http::status::internal_server_error);
-                return;
-            }
-            // Prepare all the schema required fields which retrieved from
-            // D-Bus.
-            for (const std::string p : std::array<const char *, 2>{
-                     "BootSourceOverrideEnabled", "BootSourceOverrideTarget"})
+    // Prepare all the schema required fields which retrieved from D-Bus.
+    for (const std::string p : std::array<const char *, 2>{
+             "BootSourceOverrideEnabled", "BootSourceOverrideTarget"})
+    {
+        PropertiesType::const_iterator it = properties.find(p);
+        if (it != properties.end())
+        {
+            const std::string *s =
+                mapbox::getPtr<const std::string>(it->second);
+            if (s != nullptr)
             {
-                PropertiesType::const_iterator it = properties.find(p);
-                if (it != properties.end())
-                {
-                    const std::string *s =
-                        mapbox::getPtr<const std::string>(it->second);
-                    if (s != nullptr)
-                    {
-                        asyncResp->res.jsonValue["Boot"][p] = *s;
-                    }
-                }
+                json["Boot"][p] = *s;
             }
-        },
-        "xyz.openbmc_project.Inventory.Host.Manager",
-        "/xyz/openbmc_project/inventory/host/bios",
-        "org.freedesktop.DBus.Properties", "GetAll",
-        "xyz.openbmc_project.Inventory.Item.BiosInfo");
-};
+        }
+    }
+}
 
 /**
- * Function that retrieves all properties of processor interface.
- * @param[in] asyncResp     Shared pointer for completing asynchronous calls.
+ * @brief Fills in ProcessorSummary from the Processor properties.
+ *
+ * @param[out] json        ComputerSystem resource.
+ * @param[in]  properties  Properties of the Processor interface.
+ *
  * @return None.
  */
-void getProcessorSummary(std::shared_ptr<AsyncResp> asyncResp)
+void fillProcessorSummary(nlohmann::json &json,
+                          const PropertiesType &properties)
 {
-    BMCWEB_LOG_DEBUG << "Get processor summary enter.";
-    // Make call to Host service.
-    crow::connections::systemBus->async_method_call(
-        [asyncResp{std::move(asyncResp)}](const boost::system::error_code ec,
-                                          const PropertiesType &properties) {
-            if (ec)
+    // Prepare all the schema required fields which retrieved from D-Bus.
+    for (const std::string p :
+         std::array<const char *, 4>{"Count", "Model", "State", "Health"})
+    {
+        PropertiesType::const_iterator it = properties.find(p);
+        if (it == properties.end())
+        {
+            continue;
+        }
+        if (p == "Count")
+        {
+            const uint32_t *count = mapbox::getPtr<const uint32_t>(it->second);
+            if (count != nullptr)
             {
-                BMCWEB_LOG_DEBUG << "D-Bus response error " << ec;
-                asyncResp->res.result(
-                    boost::beast::http::status::internal_server_error);
-                return;
+                json["ProcessorSummary"]["Count"] = *count;
             }
-            // Prepare all the schema required fields which retrieved
-            // from D-Bus.
-            for (const std::string p : std::array<const char *, 4>{
-                     "Count", "Model", "State", "Health"})
+        }
+        else
+        {
+            const std::string *s =
+                mapbox::getPtr<const std::string>(it->second);
+            if (s != nullptr)
             {
-                PropertiesType::const_iterator it = properties.find(p);
-                if (it != properties.end())
+                if (p == "State" || p == "Health")
                 {
-                    if (p == "Count")
-                    {
-                        const uint32_t *count =
-                            mapbox::getPtr<const uint32_t>(it->second);
-                        if (count != nullptr)
-                        {
-                            asyncResp->res
-                                .jsonValue["ProcessorSummary"]["Count"] =
-                                *count;
-                        }
-                    }
-                    else
-                    {
-                        const std::string *s =
-                            mapbox::getPtr<const std::string>(it->second);
-                        if (s != nullptr)
-                        {
-                            if (p == "State" || p == "Health")
-                            {
-                                asyncResp->res.jsonValue["ProcessorSummary"]
-                                                        ["Status"][p] = *s;
-                            }
-                            else
-                            {
-                                asyncResp->res
-                                    .jsonValue["ProcessorSummary"][p] = *s;
-                            }
-                        }
-                    }
+                    json["ProcessorSummary"]["Status"][p] = *s;
+                }
+                else
+                {
+                    json["ProcessorSummary"][p] = *s;
                 }
             }
-        },
-        "xyz.openbmc_project.Inventory.Host.Manager",
-        "/xyz/openbmc_project/inventory/system/chassis0/motherboard0/cpu0/"
-        "processor",
-        "org.freedesktop.DBus.Properties", "GetAll",
-        "xyz.openbmc_project.Inventory.Item.Processor");
+        }
+    }
 }
 
-/*
- * Function that retrieves all properties of memory interface.
- * @param[in] asyncResp     Shared pointer for completing asynchronous calls.
+/**
+ * @brief Fills in MemorySummary from the Memory properties.
+ *
+ * @param[out] json        ComputerSystem resource.
+ * @param[in]  properties  Properties of the Memory interface.
+ *
  * @return None.
  */
-void getMemorySummary(std::shared_ptr<AsyncResp> asyncResp)
+void fillMemorySummary(nlohmann::json &json, const PropertiesType &properties)
 {
-    BMCWEB_LOG_DEBUG << "Get system memory summary.";
-    crow::connections::systemBus->async_method_call(
-        [asyncResp{std::move(asyncResp)}](const boost::system::error_code ec,
-                                          const PropertiesType &properties) {
-            if (ec)
+    // Prepare all the schema required fields which retrieved from D-Bus.
+    for (const std::string p : std::array<const char *, 3>{
+             "TotalSystemMemoryGiB", "State", "Health"})
+    {
+        PropertiesType::const_iterator it = properties.find(p);
+        if (it == properties.end())
+        {
+            continue;
+        }
+        if (p == "TotalSystemMemoryGiB")
+        {
+            const uint32_t *total = mapbox::getPtr<const uint32_t>(it->second);
+            if (total != nullptr)
             {
-                BMCWEB_LOG_ERROR << "D-Bus response error " << ec;
-                asyncResp->res.result(
-                    boost::beast::http::status::internal_server_error);
-                return;
+                json["MemorySummary"]["TotalSystemMemoryGiB"] = *total;
             }
-
-            // Prepare all the schema required fields which retrieved
-            // from D-Bus.
-            for (const std::string p : std::array<const char *, 3>{
-                     "TotalSystemMemoryGiB", "State", "Health"})
+        }
+        else
+        {
+            const std::string *s =
+                mapbox::getPtr<const std::string>(it->second);
+            if (s != nullptr)
             {
-                PropertiesType::const_iterator it = properties.find(p);
-                if (it == properties.end())
-                {
-                    continue;
-                }
-                if (p == "TotalSystemMemoryGiB")
-                {
-                    const uint32_t *total =
-                        mapbox::getPtr<const uint32_t>(it->second);
-                    if (total != nullptr)
-                    {
-                        asyncResp->res.jsonValue["MemorySummary"]
-                                                ["TotalSystemMemoryGiB"] =
-                            *total;
-                    }
-                }
-                else
-                {
-                    const std::string *s =
-                        mapbox::getPtr<const std::string>(it->second);
-                    if (s != nullptr)
-                    {
-                        asyncResp->res.jsonValue["MemorySummary"]["Status"][p] =
-                            *s;
-                    }
-                }
+                json["MemorySummary"]["Status"][p] = *s;
             }
-        },
-        "xyz.openbmc_project.Inventory.Host.Manager",
-        "/xyz/openbmc_project/inventory/system/chassis0/motherboard0/cpu0/"
-        "memory",
-        "org.freedesktop.DBus.Properties", "GetAll",
-        "xyz.openbmc_project.Inventory.Item.Memory");
+        }
+    }
 }
 
 /**
- * @brief Retrieves System Unique ID (UUID) properties over D-Bus.
+ * @brief Fills in the System Unique ID (UUID) from the FRU MultiRecord
+ *        properties.
  *
- * @param[in] asyncResp  Shared pointer for completing asynchronous calls.
+ * @param[out] json        ComputerSystem resource.
+ * @param[in]  properties  Properties of the MultiRecord interface.
  *
  * @return None.
  */
-void getSystemUniqueID(std::shared_ptr<AsyncResp> asyncResp)
+void fillSystemUniqueID(nlohmann::json &json, const PropertiesType &properties)
 {
-    BMCWEB_LOG_DEBUG << "Get System Unique ID.";
-    crow::connections::systemBus->async_method_call(
-        [asyncResp{std::move(asyncResp)}](const boost::system::error_code ec,
-                                          const PropertiesType &properties) {
-            if (ec)
-            {
-                BMCWEB_LOG_DEBUG << "D-Bus response error " << ec;
-                asyncResp->res.result(
-                    boost::beast::http::status::internal_server_error);
-                return;
-            }
+    std::string output{}; // Initial output UUID as Null.
+    PropertiesType::const_iterator it = properties.find("Record_1");
+    if (it != properties.end())
+    {
+        const std::string *s = mapbox::getPtr<const std::string>(it->second);
+        if (nullptr != s)
+        {
+            output = *s;
+        }
+    }
+    // Update JSON payload with UUID information.
+    json["UUID"] = output;
+}
 
-            std::string output{}; // Initial output UUID as Null.
-            PropertiesType::const_iterator it = properties.find("Record_1");
-            if (it != properties.end())
-            {
-                const std::string *s =
-                    mapbox::getPtr<const std::string>(it->second);
-                if (nullptr != s)
-                {
-                    output = *s;
-                }
-            }
-            // Update JSON payload with UUID information.
-            asyncResp->res.jsonValue["UUID"] = output;
-        },
-        "xyz.openbmc_project.Inventory.FRU",
-        "/xyz/openbmc_project/inventory/fru0/multirecord",
-        "org.freedesktop.DBus.Properties", "GetAll",
-        "xyz.openbmc_project.Inventory.FRU.MultiRecord");
+/**
+ * @brief Fills in the asset properties from the FRU Product properties.
+ *
+ * @param[out] json        ComputerSystem resource.
+ * @param[in]  properties  Properties of the Product interface.
+ *
+ * @return None.
+ */
+void fillProduct(nlohmann::json &json, const PropertiesType &properties)
+{
+    for (auto &p : std::array<const std::string, 7>{
+             "Asset_Tag", "Manufacturer", "Model_Number", "Name",
+             "Serial_Number", "Part_Number", "SKU"})
+    {
+        PropertiesType::const_iterator it = properties.find(p);
+        if (it == properties.end())
+        {
+            continue;
+        }
+        const std::string *s = mapbox::getPtr<const std::string>(it->second);
+        if (s == nullptr)
+        {
+            continue;
+        }
+        if (p == "Asset_Tag")
+        {
+            json["AssetTag"] = *s;
+        }
+        else if (p == "Model_Number")
+        {
+            json["Model"] = *s;
+        }
+        else if (p == "Serial_Number")
+        {
+            json["SerialNumber"] = *s;
+        }
+        else if (p == "Part_Number")
+        {
+            json["PartNumber"] = *s;
+        }
+        else
+        {
+            json[p] = *s;
+        }
+    }
 }
 
 /**
- * @brief Retrieves computer system properties over dbus
+ * @brief Fills in PowerState and Status.State from the host state.
  *
- * @param[in] aResp Shared pointer for completing asynchronous calls
- * @param[in] name  Computer system name from request
+ * @param[out] json        ComputerSystem resource.
+ * @param[in]  properties  Properties of the State.Host interface.
  *
  * @return None.
  */
-void getComputerSystem(std::shared_ptr<AsyncResp> asyncResp)
+void fillHostState(nlohmann::json &json, const PropertiesType &properties)
 {
-    BMCWEB_LOG_DEBUG << "Get Computer System information... ";
-    crow::connections::systemBus->async_method_call(
-        [asyncResp](const boost::system::error_code ec,
-                    const PropertiesType &properties) {
-            if (ec)
-            {
-                BMCWEB_LOG_ERROR << "D-Bus response error: " << ec;
-                asyncResp->res.result(
-                    boost::beast::http::status::internal_server_error);
-                return;
-            }
+    PropertiesType::const_iterator it = properties.find("CurrentHostState");
+    if (it == properties.end())
+    {
+        return;
+    }
+    const std::string *s = mapbox::getPtr<const std::string>(it->second);
+    if (s == nullptr)
+    {
+        return;
+    }
+    BMCWEB_LOG_DEBUG << "Host state: " << *s;
+    // Verify Host State
+    if (*s == "xyz.openbmc_project.State.Host.HostState.Running")
+    {
+        json["PowerState"] = "On";
+        json["Status"]["State"] = "Enabled";
+    }
+    else
+    {
+        json["PowerState"] = "Off";
+        json["Status"]["State"] = "Disabled";
+    }
+}
 
-            // Verify ifaceName
-            for (auto &p : std::array<const std::string, 7>{
-                     "Asset_Tag", "Manufacturer", "Model_Number", "Name",
-                     "Serial_Number", "Part_Number", "SKU"})
-            {
-                PropertiesType::const_iterator it = properties.find(p);
-                if (it != properties.end())
-                {
-                    const std::string *s =
-                        mapbox::getPtr<const std::string>(it->second);
-                    if (s != nullptr)
-                    {
-                        if (p == "Asset_Tag")
-                        {
-                            asyncResp->res.jsonValue["AssetTag"] = *s;
-                        }
-                        else if (p == "Model_Number")
-                        {
-                            asyncResp->res.jsonValue["Model"] = *s;
-                        }
-                        else if (p == "Serial_Number")
-                        {
-                            asyncResp->res.jsonValue["SerialNumber"] = *s;
-                        }
-                        else if (p == "Part_Number")
-                        {
-                            asyncResp->res.jsonValue["PartNumber"] = *s;
-                        }
-                        else if (p == "SKU")
-                        {
-                            asyncResp->res.jsonValue["SKU"] = *s;
-                        }
-                        else
-                        {
-                            asyncResp->res.jsonValue[p] = *s;
-                        }
-                    }
-                }
-            }
-        },
-        "xyz.openbmc_project.Inventory.FRU",
-        "/xyz/openbmc_project/inventory/fru0/product",
-        "org.freedesktop.DBus.Properties", "GetAll",
-        "xyz.openbmc_project.Inventory.FRU.Product");
-    getBiosVersion(asyncResp);
-    getBootPolicy(asyncResp);
-    getMemorySummary(asyncResp);
-    getProcessorSummary(asyncResp);
-    getSystemUniqueID(asyncResp);
+/**
+ * @brief Gets IndicatorLED from the identify LED properties.
+ *
+ * @param[in] properties  Properties of the Led.Physical interface.
+ *
+ * @return "Lit", "Blinking" or "Off", or empty if the state is unknown.
+ */
+std::string getIndicatorLed(const PropertiesType &properties)
+{
+    PropertiesType::const_iterator it = properties.find("State");
+    if (it == properties.end())
+    {
+        return std::string();
+    }
+    const std::string *s = mapbox::getPtr<const std::string>(it->second);
+    if (s == nullptr)
+    {
+        return std::string();
+    }
+    BMCWEB_LOG_DEBUG << "Identify Led State: " << *s;
+    const std::string led = s->substr(s->rfind('.') + 1);
+    for (const std::pair<const char *, const char *> &p :
+         std::array<std::pair<const char *, const char *>, 3>{
+             {{"On", "Lit"}, {"Blink", "Blinking"}, {"Off", "Off"}}})
+    {
+        if (led == p.first)
+        {
+            return p.second;
+        }
+    }
+    return std::string();
+}
+
+// Health of the system, as the worst log entry makes it
+enum class SystemHealth
+{
+    ok,
+    warning,
+    critical
+};
+
+/*
+ * Log severity level ->  Health value
+ * Emergency              Critical
+ * Alert                  Critical
+ * Critical               Critical
+ * Error                  Warning
+ * Warning                Warning
+ * Notice                 OK
+ * Debug                  OK
+ * Informational          OK
+ */
+SystemHealth getSeverityHealth(const std::string &severity)
+{
+    const std::string entryLevel = severity.substr(severity.rfind('.') + 1);
+    if (entryLevel == "Critical" || entryLevel == "Alert" ||
+        entryLevel == "Emergency")
+    {
+        return SystemHealth::critical;
+    }
+    if (entryLevel == "Error" || entryLevel == "Warning")
+    {
+        return SystemHealth::warning;
+    }
+    return SystemHealth::ok;
 }
 
 /**
- * @brief Retrieves identify led group properties over dbus
+ * @brief What the ComputerSystem resource shows from D-Bus
  *
- * @param[in] aResp     Shared pointer for completing asynchronous calls.
- * @param[in] callback  Callback for process retrieved data.
+ * The Health rollup is kept as a count of log entries by the health they
+ * imply, which log entries coming and going update one at a time, instead
+ * of every request looking at every entry.
+ */
+class SystemSummary
+{
+  public:
+    // The objects the summary is built from
+    enum Source
+    {
+        bios,
+        processor,
+        memory,
+        multiRecord,
+        product,
+        host,
+        ledGroup,
+        ledPhysical,
+        sourceCount
+    };
+
+    /**
+     * @brief Fills in the properties of the resource that select asks for
+     *
+     * @param[out] res     Response holding the ComputerSystem resource.
+     * @param[in]  select  Properties the client asked for.
+     *
+     * @return None.
+     */
+    void render(crow::Response &res, const query_util::Select &select) const
+    {
+        if (select.contains("IndicatorLED"))
+        {
+            renderIndicatorLed(res);
+        }
+        if (select.contains("PowerState") || select.contains("Status"))
+        {
+            renderHostState(res);
+        }
+        if (select.contains("Status"))
+        {
+            renderHealth(res.jsonValue);
+        }
+        renderComputerSystem(res, select);
+    }
+
+    // The asset, BIOS, boot, memory, processor and UUID properties
+    void renderComputerSystem(
+        crow::Response &res,
+        const query_util::Select &select = query_util::Select()) const
+    {
+        if (select.contains("AssetTag") || select.contains("Manufacturer") ||
+            select.contains("Model") || select.contains("Name") ||
+            select.contains("SerialNumber") || select.contains("PartNumber") ||
+            select.contains("SKU"))
+        {
+            renderSource(res, product, fillProduct);
+        }
+        if (select.contains("BiosVersion"))
+        {
+            renderSource(res, bios, fillBiosVersion);
+        }
+        if (select.contains("Boot"))
+        {
+            renderBoot(res);
+        }
+        if (select.contains("MemorySummary"))
+        {
+            renderSource(res, memory, fillMemorySummary);
+        }
+        if (select.contains("ProcessorSummary"))
+        {
+            renderSource(res, processor, fillProcessorSummary);
+        }
+        if (select.contains("UUID"))
+        {
+            renderSource(res, multiRecord, fillSystemUniqueID);
+        }
+    }
+
+    void renderBoot(crow::Response &res) const
+    {
+        renderSource(res, bios, fillBootPolicy);
+    }
+
+    void renderHostState(crow::Response &res) const
+    {
+        renderSource(res, host, fillHostState);
+    }
+
+    // Lit or Blinking only while the enclosure identify group is asserted
+    void renderIndicatorLed(crow::Response &res) const
+    {
+        // Without an identify group, IndicatorLED is left out
+        const boost::optional<PropertiesType> &group = sources[ledGroup];
+        if (!group)
+        {
+            return;
+        }
+        PropertiesType::const_iterator it = group->find("Asserted");
+        if (it == group->end())
+        {
+            return;
+        }
+        const bool *asserted = mapbox::getPtr<const bool>(it->second);
+        if (asserted == nullptr || !*asserted)
+        {
+            res.jsonValue["IndicatorLED"] = "Off";
+            return;
+        }
+        const boost::optional<PropertiesType> &led = sources[ledPhysical];
+        if (!led)
+        {
+            res.result(boost::beast::http::status::internal_server_error);
+            return;
+        }
+        std::string ledStatus = getIndicatorLed(*led);
+        if (!ledStatus.empty())
+        {
+            res.jsonValue["IndicatorLED"] = std::move(ledStatus);
+        }
+    }
+
+    void renderHealth(nlohmann::json &json) const
+    {
+        if (healthCounts[static_cast<size_t>(SystemHealth::critical)] != 0)
+        {
+            json["Status"]["Health"] = "Critical";
+        }
+        else if (healthCounts[static_cast<size_t>(SystemHealth::warning)] != 0)
+        {
+            json["Status"]["Health"] = "Warning";
+        }
+        else
+        {
+            json["Status"]["Health"] = "OK";
+        }
+    }
+
+  private:
+    friend class SystemSummaryStore;
+
+    using Interfaces = boost::container::flat_map<std::string, PropertiesType>;
+
+    struct SourceObject
+    {
+        const char *service;
+        const char *path;
+        const char *interface;
+    };
+
+    static const std::array<SourceObject, sourceCount> &sourceObjects()
+    {
+        static const std::array<SourceObject, sourceCount> objects{
+            {{"xyz.openbmc_project.Inventory.Host.Manager",
+              "/xyz/openbmc_project/inventory/host/bios",
+              "xyz.openbmc_project.Inventory.Item.BiosInfo"},
+             {"xyz.openbmc_project.Inventory.Host.Manager",
+              "/xyz/openbmc_project/inventory/system/chassis0/motherboard0/"
+              "cpu0/processor",
+              "xyz.openbmc_project.Inventory.Item.Processor"},
+             {"xyz.openbmc_project.Inventory.Host.Manager",
+              "/xyz/openbmc_project/inventory/system/chassis0/motherboard0/"
+              "cpu0/memory",
+              "xyz.openbmc_project.Inventory.Item.Memory"},
+             {"xyz.openbmc_project.Inventory.FRU",
+              "/xyz/openbmc_project/inventory/fru0/multirecord",
+              "xyz.openbmc_project.Inventory.FRU.MultiRecord"},
+             {"xyz.openbmc_project.Inventory.FRU",
+              "/xyz/openbmc_project/inventory/fru0/product",
+              "xyz.openbmc_project.Inventory.FRU.Product"},
+             {"xyz.openbmc_project.State.Host",
+              "/xyz/openbmc_project/state/host0",
+              "xyz.openbmc_project.State.Host"},
+             {"xyz.openbmc_project.LED.GroupManager",
+              "/xyz/openbmc_project/led/groups/enclosure_identify",
+              "xyz.openbmc_project.Led.Group"},
+             {"xyz.openbmc_project.LED.Controller.identify",
+              "/xyz/openbmc_project/led/physical/identify",
+              "xyz.openbmc_project.Led.Physical"}}};
+        return objects;
+    }
+
+    static constexpr const char *entryInterface()
+    {
+        return "xyz.openbmc_project.Logging.Entry";
+    }
+
+    // An object that couldn't be read fails the request, as reading it for
+    // the request would have
+    template <typename Fill>
+    void renderSource(crow::Response &res, Source source, Fill fill) const
+    {
+        if (!sources[source])
+        {
+            res.result(boost::beast::http::status::internal_server_error);
+            return;
+        }
+        fill(res.jsonValue, *sources[source]);
+    }
+
+    // False if the source couldn't be read, so has to be read again
+    bool update(size_t source, const PropertiesType &changed)
+    {
+        if (!sources[source])
+        {
+            return false;
+        }
+        for (const std::pair<std::string, VariantType> &value : changed)
+        {
+            (*sources[source])[value.first] = value.second;
+        }
+        return true;
+    }
+
+    void setEntryHealth(const std::string &path, SystemHealth health)
+    {
+        auto it = entryHealth.find(path);
+        if (it != entryHealth.end())
+        {
+            healthCounts[static_cast<size_t>(it->second)]--;
+            it->second = health;
+        }
+        else
+        {
+            entryHealth.emplace(path, health);
+        }
+        healthCounts[static_cast<size_t>(health)]++;
+    }
+
+    void setEntrySeverity(const std::string &path,
+                          const PropertiesType &properties)
+    {
+        PropertiesType::const_iterator it = properties.find("Severity");
+        if (it == properties.end())
+        {
+            return;
+        }
+        const std::string *severity =
+            mapbox::getPtr<const std::string>(it->second);
+        if (severity != nullptr)
+        {
+            setEntryHealth(path, getSeverityHealth(*severity));
+        }
+    }
+
+    void removeEntry(const std::string &path)
+    {
+        auto it = entryHealth.find(path);
+        if (it != entryHealth.end())
+        {
+            healthCounts[static_cast<size_t>(it->second)]--;
+            entryHealth.erase(it);
+        }
+    }
+
+    // Properties of each source; empty if it couldn't be read
+    std::array<boost::optional<PropertiesType>, sourceCount> sources;
+    // Health implied by each log entry, by object path, and how many
+    // entries imply each health
+    boost::container::flat_map<std::string, SystemHealth> entryHealth;
+    std::array<size_t, 3> healthCounts{};
+};
+
+/**
+ * @brief Keeps the SystemSummary in memory
  *
- * @return None.
+ * Every object the summary is built from is read once, on first use, with
+ * one GetAll, and then kept current from the signals the SignalDispatcher
+ * passes on.  One of the services restarting drops it all; the next request
+ * loads it again.
  */
-template <typename CallbackFunc>
-void getLedGroupIdentify(std::shared_ptr<AsyncResp> aResp,
-                         CallbackFunc &&callback)
+class SystemSummaryStore
 {
-    BMCWEB_LOG_DEBUG << "Get led groups";
-    crow::connections::systemBus->async_method_call(
-        [aResp{std::move(aResp)},
-         callback{std::move(callback)}](const boost::system::error_code &ec,
-                                        const ManagedObjectsType &resp) {
-            if (ec)
+  public:
+    SystemSummaryStore() :
+        store(listener(), [this](uint64_t generation) { load(generation); })
+    {
+    }
+
+    /**
+     * @brief Calls back once the summary is loaded
+     * @param callback  Called with the summary
+     */
+    template <typename Handler> void get(Handler &&callback)
+    {
+        store.get([callback{std::forward<Handler>(callback)}](
+                      bool, const SystemSummary &summary) {
+            callback(summary);
+        });
+    }
+
+    void invalidate()
+    {
+        store.invalidate();
+    }
+
+    // Unsubscribes from the signal dispatcher
+    void stop()
+    {
+        store.stop();
+    }
+
+  private:
+    using SourceObject = SystemSummary::SourceObject;
+
+    static bool isLogging(const std::string &path)
+    {
+        return boost::starts_with(path, "/xyz/openbmc_project/logging/");
+    }
+
+    crow::connections::SignalDispatcher::Listener listener()
+    {
+        crow::connections::SignalDispatcher::Listener listener;
+        listener.propertyValues = [this](const std::string &path,
+                                         const std::string &interface,
+                                         sdbusplus::message::message
+                                             &message) {
+            if (interface == SystemSummary::entryInterface() &&
+                isLogging(path))
             {
-                BMCWEB_LOG_DEBUG << "DBUS response error " << ec;
-                aResp->res.result(
-                    boost::beast::http::status::internal_server_error);
+                std::string name;
+                PropertiesType changed;
+                message.read(name, changed);
+                store.data().setEntrySeverity(path, changed);
                 return;
             }
-            BMCWEB_LOG_DEBUG << "Got " << resp.size() << "led group objects.";
-            for (const auto &objPath : resp)
+            for (size_t i = 0; i < SystemSummary::sourceCount; i++)
             {
-                const std::string &path = objPath.first;
-                if (path.rfind("enclosure_identify") != std::string::npos)
+                const SourceObject &object = SystemSummary::sourceObjects()[i];
+                if (path == object.path && interface == object.interface)
                 {
-                    for (const auto &interface : objPath.second)
+                    std::string name;
+                    PropertiesType changed;
+                    message.read(name, changed);
+                    if (!store.data().update(i, changed))
                     {
-                        if (interface.first == "xyz.openbmc_project.Led.Group")
-                        {
-                            for (const auto &property : interface.second)
-                            {
-                                if (property.first == "Asserted")
-                                {
-                                    const bool *asserted =
-                                        mapbox::getPtr<const bool>(
-                                            property.second);
-                                    if (nullptr != asserted)
-                                    {
-                                        callback(*asserted, aResp);
-                                    }
-                                    else
-                                    {
-                                        callback(false, aResp);
-                                    }
-                                }
-                            }
-                        }
+                        // The object is there now; read it all on the next
+                        // request
+                        invalidate();
                     }
+                    return;
                 }
             }
-        },
-        "xyz.openbmc_project.LED.GroupManager",
-        "/xyz/openbmc_project/led/groups", "org.freedesktop.DBus.ObjectManager",
-        "GetManagedObjects");
-}
-
-template <typename CallbackFunc>
-void getLedIdentify(std::shared_ptr<AsyncResp> aResp, CallbackFunc &&callback)
-{
-    BMCWEB_LOG_DEBUG << "Get identify led properties";
-    crow::connections::systemBus->async_method_call(
-        [aResp,
-         callback{std::move(callback)}](const boost::system::error_code ec,
-                                        const PropertiesType &properties) {
-            if (ec)
+        };
+        listener.interfacesAdded = [this](
+                                       const std::string &path,
+                                       sdbusplus::message::message &message) {
+            if (!isLogging(path))
             {
-                BMCWEB_LOG_DEBUG << "DBUS response error " << ec;
-                aResp->res.result(
-                    boost::beast::http::status::internal_server_error);
                 return;
             }
-            BMCWEB_LOG_DEBUG << "Got " << properties.size()
-                             << "led properties.";
-            std::string output;
-            for (const auto &property : properties)
+            sdbusplus::message::object_path object;
+            SystemSummary::Interfaces interfaces;
+            message.read(object, interfaces);
+            auto it = interfaces.find(SystemSummary::entryInterface());
+            if (it != interfaces.end())
             {
-                if (property.first == "State")
-                {
-                    const std::string *s =
-                        mapbox::getPtr<std::string>(property.second);
-                    if (nullptr != s)
-                    {
-                        BMCWEB_LOG_DEBUG << "Identify Led State: " << *s;
-                        const auto pos = s->rfind('.');
-                        if (pos != std::string::npos)
-                        {
-                            auto led = s->substr(pos + 1);
-                            for (const std::pair<const char *, const char *>
-                                     &p :
-                                 std::array<
-                                     std::pair<const char *, const char *>, 3>{
-                                     {{"On", "Lit"},
-                                      {"Blink", "Blinking"},
-                                      {"Off", "Off"}}})
-                            {
-                                if (led == p.first)
-                                {
-                                    output = p.second;
-                                }
-                            }
-                        }
-                    }
-                }
+                store.data().setEntrySeverity(path, it->second);
             }
-            callback(output, aResp);
-        },
-        "xyz.openbmc_project.LED.Controller.identify",
-        "/xyz/openbmc_project/led/physical/identify",
-        "org.freedesktop.DBus.Properties", "GetAll",
-        "xyz.openbmc_project.Led.Physical");
-}
-
-/**
- * @brief Retrieves host state properties over dbus
- *
- * @param[in] aResp     Shared pointer for completing asynchronous calls.
- *
- * @return None.
- */
-void getHostState(std::shared_ptr<AsyncResp> aResp)
-{
-    BMCWEB_LOG_DEBUG << "Get host information.";
-    crow::connections::systemBus->async_method_call(
-        [aResp{std::move(aResp)}](
-            const boost::system::error_code ec,
-            const sdbusplus::message::variant<std::string> &hostState) {
-            if (ec)
+        };
+        listener.interfacesRemoved = [this](
+                                         const std::string &path,
+                                         sdbusplus::message::message &message) {
+            if (!isLogging(path))
             {
-                BMCWEB_LOG_DEBUG << "DBUS response error " << ec;
-                aResp->res.result(
-                    boost::beast::http::status::internal_server_error);
                 return;
             }
-
-            const std::string *s = mapbox::getPtr<const std::string>(hostState);
-            BMCWEB_LOG_DEBUG << "Host state: " << *s;
-            if (s != nullptr)
+            sdbusplus::message::object_path object;
+            std::vector<std::string> interfaces;
+            message.read(object, interfaces);
+            if (std::find(interfaces.begin(), interfaces.end(),
+                          SystemSummary::entryInterface()) != interfaces.end())
             {
-                // Verify Host State
-                if (*s == "xyz.openbmc_project.State.Host.HostState.Running")
-                {
-                    aResp->res.jsonValue["PowerState"] = "On";
-                    aResp->res.jsonValue["Status"]["State"] = "Enabled";
-                }
-                else
+                store.data().removeEntry(path);
+            }
+        };
+        listener.serviceChanged = [this](const std::string &name) {
+            for (const SourceObject &object : SystemSummary::sourceObjects())
+            {
+                if (name == object.service)
                 {
-                    aResp->res.jsonValue["PowerState"] = "Off";
-                    aResp->res.jsonValue["Status"]["State"] = "Disabled";
+                    invalidate();
+                    return;
                 }
             }
-        },
-        "xyz.openbmc_project.State.Host", "/xyz/openbmc_project/state/host0",
-        "org.freedesktop.DBus.Properties", "Get",
-        "xyz.openbmc_project.State.Host", "CurrentHostState");
-}
+        };
+        return listener;
+    }
 
-void getHostHealth(std::shared_ptr<AsyncResp> aResp)
-{
-    BMCWEB_LOG_DEBUG << "Get host heath information.";
-    /* By default, the Health is OK */
-    aResp->res.jsonValue["Status"]["Health"] = "OK";
-    crow::connections::systemBus->async_method_call(
-        [aResp{std::move(aResp)}] (
-            const boost::system::error_code ec,
-            const std::vector<std::pair<
-                std::string, std::vector<std::pair<
-                                 std::string, std::vector<std::string>>>>>
-                &subtree) {
-            if (ec)
-            {
-                /* No log entry */
-                return;
-            }
-            for (auto &obj : subtree)
-            {
-                const std::vector<
-                    std::pair<std::string, std::vector<std::string>>>
-                    &connections = obj.second;
+    void load(uint64_t loadGeneration)
+    {
+        BMCWEB_LOG_DEBUG << "Loading system summary";
+        // Each source, and the log entries
+        auto pending =
+            std::make_shared<size_t>(SystemSummary::sourceCount + 1);
 
-                for (auto &conn : connections)
-                {
-                    const std::string &connectionName = conn.first;
-                        crow::connections::systemBus->async_method_call(
-                        [aResp{std::move(aResp)}] (
-                            const boost::system::error_code error_code,
-                            const VariantType &severity) {
+        for (size_t i = 0; i < SystemSummary::sourceCount; i++)
+        {
+            const SourceObject &object = SystemSummary::sourceObjects()[i];
+            crow::connections::coalescedMethodCall(
+                [this, i, loadGeneration,
+                 pending](const boost::system::error_code ec,
+                          const PropertiesType &properties) {
+                    if (ec)
+                    {
+                        BMCWEB_LOG_DEBUG << "D-Bus response error " << ec;
+                    }
+                    else
+                    {
+                        store.data().sources[i] = properties;
+                    }
+                    finishSource(pending, loadGeneration);
+                },
+                object.service, object.path, "org.freedesktop.DBus.Properties",
+                "GetAll", object.interface);
+        }
+        loadEntries(pending, loadGeneration);
+    }
 
-                            if (error_code)
-                            {
-                                /* No log entry */
-                                return;
-                            }
-                            const std::string *severity_value =
+    void loadEntries(const std::shared_ptr<size_t> &pending,
+                     uint64_t loadGeneration)
+    {
+        crow::connections::cachedMethodCall(
+            [this, pending, loadGeneration](
+                const boost::system::error_code ec,
+                const std::vector<std::pair<
+                    std::string,
+                    std::vector<std::pair<std::string,
+                                          std::vector<std::string>>>>>
+                    &subtree) {
+                if (ec)
+                {
+                    /* No log entry */
+                    finishSource(pending, loadGeneration);
+                    return;
+                }
+                for (const auto &obj : subtree)
+                {
+                    for (const auto &conn : obj.second)
+                    {
+                        ++*pending;
+                        crow::connections::coalescedMethodCall(
+                            [this, pending, loadGeneration, path{obj.first}](
+                                const boost::system::error_code ec,
+                                const VariantType &severity) {
+                                const std::string *s =
                                     mapbox::getPtr<const std::string>(
                                         severity);
-                            if (severity_value == nullptr)
-                            {
-                                /* No log entry */
-                                return;
-                            }
-                            std::string entryLevel =
-                                severity_value->substr(
-                                severity_value->rfind(".") + 1);
-                            /* Value of severity is exist */
-                            /* Check to determine the value of heath */
-                            /*
-                             * Log severity level ->  Health value
-                             * Emergency              Critical
-                             * Alert                  Critical
-                             * Critical               Critical
-                             * Error                  Warning
-                             * Warning                Warning
-                             * Notice                 OK
-                             * Debug                  OK
-                             * Informational          OK
-                             */
-                            if ((entryLevel == "Error") ||
-                                (entryLevel == "Warning"))
-                            {
-                                aResp->res.jsonValue
-                                  ["Status"]["Health"] = "Warning";
-                            }
-                            /* Continue checking if have any critical event */
-                            if ((entryLevel == "Critical") ||
-                                (entryLevel == "Alert") ||
-                                (entryLevel == "Emergency"))
-                            {
-                                aResp->res.jsonValue
-                                  ["Status"]["Health"] = "Critical";
-                                return;
-                            }
-                        },
-                        connectionName, obj.first,
-                        "org.freedesktop.DBus.Properties", "Get",
-                        "xyz.openbmc_project.Logging.Entry",
-                        "Severity");
+                                if (!ec && s != nullptr)
+                                {
+                                    store.data().setEntryHealth(
+                                        path, getSeverityHealth(*s));
+                                }
+                                finishSource(pending, loadGeneration);
+                            },
+                            conn.first, obj.first,
+                            "org.freedesktop.DBus.Properties", "Get",
+                            SystemSummary::entryInterface(), "Severity");
+                    }
                 }
-            }
-        },
-        "xyz.openbmc_project.ObjectMapper",
-        "/xyz/openbmc_project/object_mapper",
-        "xyz.openbmc_project.ObjectMapper", "GetSubTree",
-        "/xyz/openbmc_project/logging", int32_t(0),
-        std::array<const char *, 1>{
-            "xyz.openbmc_project.Logging.Entry"});
+                finishSource(pending, loadGeneration);
+            },
+            "xyz.openbmc_project.ObjectMapper",
+            "/xyz/openbmc_project/object_mapper",
+            "xyz.openbmc_project.ObjectMapper", "GetSubTree",
+            "/xyz/openbmc_project/logging", int32_t(0),
+            std::array<const char *, 1>{SystemSummary::entryInterface()});
+    }
+
+    void finishSource(const std::shared_ptr<size_t> &pending,
+                      uint64_t loadGeneration)
+    {
+        if (--*pending != 0)
+        {
+            return;
+        }
+        BMCWEB_LOG_DEBUG << "System summary loaded, "
+                         << store.data().entryHealth.size() << " log entries";
+        store.finish(true, loadGeneration);
+    }
+
+    crow::connections::SignalStore<SystemSummary> store;
 };
 
+inline SystemSummaryStore &systemSummary()
+{
+    static SystemSummaryStore summary;
+    return summary;
+}
+
 /**
  * @brief Retrieves Host Name from system call.
  *
@@ -650,7 +887,7 @@ class SystemsCollection : public Node
                const std::vector<std::string> &params) override
     {
         res.jsonValue = Node::json;
-        res.end();
+        aggregator().appendMembers("/redfish/v1/Systems", res);
     }
 };
 
@@ -684,7 +921,7 @@ class SystemActionsReset : public Node
             return;
         }
 
-        auto asyncResp = std::make_shared<AsyncResp>(res);
+        auto asyncResp = AsyncResp::create(res);
 
         for (const auto &item : post.items())
         {
@@ -719,7 +956,7 @@ class SystemActionsReset : public Node
                                   "Transition.Reboot";
                     }
 
-                    crow::connections::systemBus->async_method_call(
+                    crow::connections::tracedMethodCall(
                         [asyncResp](const boost::system::error_code ec) {
                             if (ec)
                             {
@@ -772,7 +1009,7 @@ class SystemActionsReset : public Node
                     return;
                 }
 
-                crow::connections::systemBus->async_method_call(
+                crow::connections::tracedMethodCall(
                     [asyncResp](const boost::system::error_code ec) {
                         if (ec)
                         {
@@ -883,33 +1120,13 @@ class Systems : public Node
             {"ResetType@Redfish.AllowableValues",
              {"On", "ForceOff", "ForceRestart", "GracefulRestart",
               "GracefulShutdown"}}};
-        auto asyncResp = std::make_shared<AsyncResp>(res);
+        auto asyncResp = AsyncResp::create(res);
 
-        getLedGroupIdentify(
-            asyncResp,
-            [&](const bool &asserted, const std::shared_ptr<AsyncResp> &aResp) {
-                if (asserted)
-                {
-                    // If led group is asserted, then another call is needed to
-                    // get led status
-                    getLedIdentify(
-                        aResp, [](const std::string &ledStatus,
-                                  const std::shared_ptr<AsyncResp> &aResp) {
-                            if (!ledStatus.empty())
-                            {
-                                aResp->res.jsonValue["IndicatorLED"] =
-                                    ledStatus;
-                            }
-                        });
-                }
-                else
-                {
-                    aResp->res.jsonValue["IndicatorLED"] = "Off";
-                }
-            });
-        getHostState(asyncResp);
-        getHostHealth(asyncResp);
-        getComputerSystem(asyncResp);
+        // Filled in from memory, and only what $select left in
+        systemSummary().get([asyncResp, select{query_util::Select(req)}](
+                                const SystemSummary &summary) {
+            summary.render(asyncResp->res, select);
+        });
     }
 
     void doPatch(crow::Response &res, const crow::Request &req,
@@ -917,7 +1134,7 @@ class Systems : public Node
     {
         // Check if there is required param, truly entering this shall be
         // impossible
-        auto asyncResp = std::make_shared<AsyncResp>(res);
+        auto asyncResp = AsyncResp::create(res);
         if (params.size() != 1)
         {
             res.result(boost::beast::http::status::internal_server_error);
@@ -975,12 +1192,14 @@ class Systems : public Node
                     return;
                 }
 
-                getHostState(asyncResp);
-                getComputerSystem(asyncResp);
+                systemSummary().get([asyncResp](const SystemSummary &summary) {
+                    summary.renderHostState(asyncResp->res);
+                    summary.renderComputerSystem(asyncResp->res);
+                });
 
                 // Update led group
                 BMCWEB_LOG_DEBUG << "Update led group.";
-                crow::connections::systemBus->async_method_call(
+                crow::connections::tracedMethodCall(
                     [asyncResp](const boost::system::error_code ec) {
                         if (ec)
                         {
@@ -1002,7 +1221,7 @@ class Systems : public Node
                              : true)));
                 // Update identify led status
                 BMCWEB_LOG_DEBUG << "Update led SoftwareInventoryCollection.";
-                crow::connections::systemBus->async_method_call(
+                crow::connections::tracedMethodCall(
                     [asyncResp, reqLedState{*reqLedState}](
                         const boost::system::error_code ec) {
                         if (ec)
@@ -1066,12 +1285,14 @@ class Systems : public Node
                     }
                 }
 
-                auto asyncResp = std::make_shared<AsyncResp>(res);
+                auto asyncResp = AsyncResp::create(res);
                 res.jsonValue = Node::json;
                 res.jsonValue["@odata.id"] = "/redfish/v1/Systems/" + name;
 
-                getBootPolicy(asyncResp);
-                crow::connections::systemBus->async_method_call(
+                systemSummary().get([asyncResp](const SystemSummary &summary) {
+                    summary.renderBoot(asyncResp->res);
+                });
+                crow::connections::tracedMethodCall(
                     [&key, reqBootOverride, asyncResp{std::move(asyncResp)}](
                         const boost::system::error_code ec) {
                         if (ec)
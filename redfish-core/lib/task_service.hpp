@@ -0,0 +1,356 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+#pragma once
+
+#include "node.hpp"
+#include "utils/ampere-utils.hpp"
+
+#include <boost/asio/steady_timer.hpp>
+#include <boost/container/flat_map.hpp>
+#include <chrono>
+#include <crow/upload_progress.h>
+#include <dbus_singleton.hpp>
+#include <memory>
+
+namespace redfish
+{
+
+namespace task
+{
+
+constexpr const char* tasksUrl = "/redfish/v1/TaskService/Tasks";
+// Finished tasks kept for clients to look at; the oldest go first
+constexpr size_t maxFinishedTasks = 16;
+
+/**
+ * @brief Something the service does after the request asking for it has
+ *        been answered
+ *
+ * Whatever the task waits on belongs to it, and is dropped with it, so
+ * nothing is left to fire into a response that was already sent.
+ */
+struct Task
+{
+    Task(std::string id, std::string name) :
+        id(std::move(id)), name(std::move(name)),
+        startTime(std::chrono::system_clock::now())
+    {
+    }
+
+    bool finished() const
+    {
+        return endTime != std::chrono::system_clock::time_point();
+    }
+
+    // Ends the task with message; the timer is cancelled, so its handler
+    // runs and lets go of what the task waited on
+    void finish(const char* endState, const char* endStatus,
+                nlohmann::json&& message)
+    {
+        if (finished())
+        {
+            return;
+        }
+        state = endState;
+        status = endStatus;
+        endTime = std::chrono::system_clock::now();
+        messages.push_back(std::move(message));
+        if (timer != nullptr)
+        {
+            boost::system::error_code ec;
+            timer->cancel(ec);
+        }
+    }
+
+    std::string id;
+    std::string name;
+    // TaskState and TaskStatus
+    const char* state = "Running";
+    const char* status = "OK";
+    std::chrono::system_clock::time_point startTime;
+    std::chrono::system_clock::time_point endTime;
+    nlohmann::json messages = nlohmann::json::array();
+    // Shown under Oem; Task has no place for it in the version we serve
+    nlohmann::json oem = nlohmann::json::object();
+
+    std::unique_ptr<boost::asio::steady_timer> timer;
+    std::unique_ptr<sdbusplus::bus::match::match> match;
+};
+
+/**
+ * @brief The tasks there are, by Id.  Only used on the handler thread.
+ *
+ * Uploads still being received aren't tasks yet; the TaskService lists them
+ * from the crow::UploadRegistry, under the Id the task for them will have.
+ */
+class TaskStore
+{
+  public:
+    using Tasks =
+        boost::container::flat_map<std::string, std::shared_ptr<Task>>;
+
+    std::shared_ptr<Task> create(std::string id, std::string name)
+    {
+        prune();
+        auto task = std::make_shared<Task>(id, std::move(name));
+        tasks[std::move(id)] = task;
+        return task;
+    }
+
+    std::shared_ptr<Task> find(const std::string& id) const
+    {
+        auto task = tasks.find(id);
+        if (task == tasks.end())
+        {
+            return nullptr;
+        }
+        return task->second;
+    }
+
+    const Tasks& getTasks() const
+    {
+        return tasks;
+    }
+
+    void stop()
+    {
+        tasks.clear();
+    }
+
+  private:
+    // Makes room for one more finished task
+    void prune()
+    {
+        size_t finished = 0;
+        auto oldest = tasks.end();
+        for (auto it = tasks.begin(); it != tasks.end(); ++it)
+        {
+            if (!it->second->finished())
+            {
+                continue;
+            }
+            finished++;
+            if (oldest == tasks.end() ||
+                it->second->endTime < oldest->second->endTime)
+            {
+                oldest = it;
+            }
+        }
+        if (finished >= maxFinishedTasks)
+        {
+            tasks.erase(oldest);
+        }
+    }
+
+    Tasks tasks;
+};
+
+// ISO 8601, with the colon Redfish wants in the offset
+inline std::string toDateTime(std::chrono::system_clock::time_point time)
+{
+    std::string dateTime = getDateTime(time.time_since_epoch(), "%FT%T%z");
+    if (dateTime.size() > 2)
+    {
+        dateTime.insert(dateTime.end() - 2, ':');
+    }
+    return dateTime;
+}
+
+inline void fillTaskJson(const Task& task, nlohmann::json& json)
+{
+    json["@odata.type"] = "#Task.v1_2_0.Task";
+    json["@odata.id"] = std::string(tasksUrl) + "/" + task.id;
+    json["@odata.context"] = "/redfish/v1/$metadata#Task.Task";
+    json["Id"] = task.id;
+    json["Name"] = task.name;
+    json["TaskState"] = task.state;
+    json["TaskStatus"] = task.status;
+    json["StartTime"] = toDateTime(task.startTime);
+    if (task.finished())
+    {
+        json["EndTime"] = toDateTime(task.endTime);
+    }
+    json["Messages"] = task.messages;
+    if (!task.oem.empty())
+    {
+        json["Oem"]["OpenBmc"] = task.oem;
+    }
+}
+
+// An upload not handed to its handler yet, as the task it will become
+inline void fillUploadTaskJson(const crow::UploadProgress& upload,
+                               nlohmann::json& json)
+{
+    const std::string id = std::to_string(upload.id);
+    const uint64_t received = upload.received.load();
+    json["@odata.type"] = "#Task.v1_2_0.Task";
+    json["@odata.id"] = std::string(tasksUrl) + "/" + id;
+    json["@odata.context"] = "/redfish/v1/$metadata#Task.Task";
+    json["Id"] = id;
+    json["Name"] = "Upload to " + upload.url;
+    json["TaskState"] = "Running";
+    json["TaskStatus"] = "OK";
+    json["StartTime"] = toDateTime(upload.started);
+    json["Messages"] = nlohmann::json::array();
+    json["Oem"]["OpenBmc"] = {
+        {"BytesReceived", received},
+        {"BytesTotal", upload.total},
+        {"PercentComplete",
+         upload.total == 0 ? 100 : received * 100 / upload.total}};
+}
+
+} // namespace task
+
+inline task::TaskStore& taskStore()
+{
+    static task::TaskStore store;
+    return store;
+}
+
+class TaskService : public Node
+{
+  public:
+    TaskService(CrowApp& app) : Node(app, "/redfish/v1/TaskService/")
+    {
+        Node::json["@odata.type"] = "#TaskService.v1_1_1.TaskService";
+        Node::json["@odata.id"] = "/redfish/v1/TaskService";
+        Node::json["@odata.context"] =
+            "/redfish/v1/$metadata#TaskService.TaskService";
+        Node::json["Id"] = "TaskService";
+        Node::json["Name"] = "Task Service";
+        Node::json["CompletedTaskOverWritePolicy"] = "Oldest";
+        Node::json["LifeCycleEventOnTaskStateChange"] = false;
+        Node::json["ServiceEnabled"] = true;
+        Node::json["Status"] = {{"State", "Enabled"}, {"Health", "OK"}};
+
+        entityPrivileges = {
+            {boost::beast::http::verb::get, {{"Login"}}},
+            {boost::beast::http::verb::head, {{"Login"}}},
+            {boost::beast::http::verb::patch, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::put, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::delete_, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::post, {{"ConfigureManager"}}}};
+    }
+
+  private:
+    void doGet(crow::Response& res, const crow::Request& req,
+               const std::vector<std::string>& params) override
+    {
+        res.jsonValue = Node::json;
+        res.jsonValue["DateTime"] =
+            task::toDateTime(std::chrono::system_clock::now());
+        res.end();
+    }
+};
+
+class TaskCollection : public Node
+{
+  public:
+    TaskCollection(CrowApp& app) : Node(app, "/redfish/v1/TaskService/Tasks/")
+    {
+        Node::json["@odata.type"] = "#TaskCollection.TaskCollection";
+        Node::json["@odata.id"] = task::tasksUrl;
+        Node::json["@odata.context"] =
+            "/redfish/v1/$metadata#TaskCollection.TaskCollection";
+        Node::json["Name"] = "Task Collection";
+
+        entityPrivileges = {
+            {boost::beast::http::verb::get, {{"Login"}}},
+            {boost::beast::http::verb::head, {{"Login"}}},
+            {boost::beast::http::verb::patch, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::put, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::delete_, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::post, {{"ConfigureManager"}}}};
+    }
+
+  private:
+    void doGet(crow::Response& res, const crow::Request& req,
+               const std::vector<std::string>& params) override
+    {
+        res.jsonValue = Node::json;
+        nlohmann::json& members = res.jsonValue["Members"];
+        members = nlohmann::json::array();
+        const task::TaskStore::Tasks& tasks = taskStore().getTasks();
+        for (const std::pair<std::string, std::shared_ptr<task::Task>>& task :
+             tasks)
+        {
+            members.push_back(
+                {{"@odata.id", std::string(task::tasksUrl) + "/" +
+                                   task.first}});
+        }
+        for (const std::shared_ptr<const crow::UploadProgress>& upload :
+             crow::uploadRegistry().active())
+        {
+            const std::string id = std::to_string(upload->id);
+            if (tasks.find(id) == tasks.end())
+            {
+                members.push_back(
+                    {{"@odata.id", std::string(task::tasksUrl) + "/" + id}});
+            }
+        }
+        res.jsonValue["Members@odata.count"] = members.size();
+        res.end();
+    }
+};
+
+class Task : public Node
+{
+  public:
+    Task(CrowApp& app) :
+        Node(app, "/redfish/v1/TaskService/Tasks/<str>/", std::string())
+    {
+        entityPrivileges = {
+            {boost::beast::http::verb::get, {{"Login"}}},
+            {boost::beast::http::verb::head, {{"Login"}}},
+            {boost::beast::http::verb::patch, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::put, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::delete_, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::post, {{"ConfigureManager"}}}};
+    }
+
+  private:
+    void doGet(crow::Response& res, const crow::Request& req,
+               const std::vector<std::string>& params) override
+    {
+        const std::string& id = params[0];
+        std::shared_ptr<task::Task> found = taskStore().find(id);
+        if (found != nullptr)
+        {
+            task::fillTaskJson(*found, res.jsonValue);
+            res.end();
+            return;
+        }
+        char* end = nullptr;
+        uint64_t uploadId = std::strtoull(id.c_str(), &end, 10);
+        std::shared_ptr<const crow::UploadProgress> upload;
+        if (!id.empty() && *end == '\0')
+        {
+            upload = crow::uploadRegistry().find(uploadId);
+        }
+        if (upload == nullptr)
+        {
+            res.result(boost::beast::http::status::not_found);
+            messages::addMessageToErrorJson(
+                res.jsonValue, messages::resourceNotFound("Task", id));
+            res.end();
+            return;
+        }
+        task::fillUploadTaskJson(*upload, res.jsonValue);
+        res.end();
+    }
+};
+
+} // namespace redfish
@@ -0,0 +1,404 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+#pragma once
+
+#include "node.hpp"
+#include "sensors.hpp"
+#include "utils/ampere-utils.hpp"
+#include "utils/metric_ring.hpp"
+
+#include <array>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/container/flat_map.hpp>
+#include <chrono>
+#include <memory>
+
+namespace redfish
+{
+
+// How often sensors are sampled, and how many samples each keeps: an hour
+constexpr std::chrono::seconds metricSampleInterval{5};
+constexpr size_t metricSamples = 3600 / metricSampleInterval.count();
+
+/**
+ * @brief A MetricReport: the min, max and average of every sensor over the
+ *        newest samples
+ */
+struct MetricReportDefinition
+{
+    const char* id;
+    // ISO 8601 duration the report covers
+    const char* duration;
+    size_t samples;
+};
+
+constexpr std::array<MetricReportDefinition, 3> metricReports = {{
+    {"Minute", "PT1M", 60 / metricSampleInterval.count()},
+    {"TenMinutes", "PT10M", 600 / metricSampleInterval.count()},
+    {"Hour", "PT1H", metricSamples}}};
+
+/**
+ * @brief Samples the sensors Redfish shows into a MetricRing each
+ *
+ * The readings come from the SensorStore, which signals keep current, so a
+ * sample costs no D-Bus calls.  Every ring gets a sample on every tick,
+ * missing if the sensor isn't there, so the samples of all rings line up.
+ */
+class MetricSampler
+{
+  public:
+    struct Series
+    {
+        // Redfish property the readings are of
+        std::string property;
+        telemetry_util::MetricRing ring;
+    };
+    // Series by sensor path below the sensors root, "type/name"
+    using SeriesMap = boost::container::flat_map<std::string, Series>;
+
+    void start(boost::asio::io_service& io)
+    {
+        timer = std::make_unique<boost::asio::steady_timer>(io);
+        schedule();
+    }
+
+    void stop()
+    {
+        timer.reset();
+        series.clear();
+    }
+
+    const SeriesMap& getSeries() const
+    {
+        return series;
+    }
+
+    // When the newest sample was taken
+    std::chrono::system_clock::time_point getLastSample() const
+    {
+        return lastSample;
+    }
+
+  private:
+    void schedule()
+    {
+        timer->expires_from_now(metricSampleInterval);
+        timer->async_wait([this](const boost::system::error_code ec) {
+            if (ec)
+            {
+                return;
+            }
+            sensorStore().get(
+                [this](bool ok, const SensorStore::Tables& tables) {
+                    if (timer == nullptr)
+                    {
+                        return;
+                    }
+                    sample(ok, tables);
+                    schedule();
+                });
+        });
+    }
+
+    static std::string propertyOf(const SensorTypeInfo& typeInfo,
+                                  const std::string& name)
+    {
+        const std::string field = typeInfo.fieldName;
+        const char* resource = field == "Temperatures" || field == "Fans"
+                                   ? "Thermal"
+                                   : "Power";
+        return "/redfish/v1/Chassis/1/" + std::string(resource) + "#/" +
+               field + "/" + name;
+    }
+
+    // Scaled the way objectInterfacesToJson scales it
+    static bool readingOf(const SensorStore::Interfaces& interfaces,
+                          double& reading)
+    {
+        auto valueInterface =
+            interfaces.find("xyz.openbmc_project.Sensor.Value");
+        if (valueInterface == interfaces.end())
+        {
+            return false;
+        }
+        auto value = valueInterface->second.find("Value");
+        if (value == valueInterface->second.end())
+        {
+            return false;
+        }
+        const double* doubleValue =
+            mapbox::getPtr<const double>(value->second);
+        if (doubleValue != nullptr)
+        {
+            reading = *doubleValue;
+            return true;
+        }
+        const int64_t* intValue = mapbox::getPtr<const int64_t>(value->second);
+        if (intValue == nullptr)
+        {
+            return false;
+        }
+        int64_t scale = 0;
+        auto scaleValue = valueInterface->second.find("Scale");
+        if (scaleValue != valueInterface->second.end())
+        {
+            const int64_t* scaleInt =
+                mapbox::getPtr<const int64_t>(scaleValue->second);
+            if (scaleInt != nullptr)
+            {
+                scale = *scaleInt;
+            }
+        }
+        reading = *intValue * std::pow(10, scale);
+        return true;
+    }
+
+    void sample(bool ok, const SensorStore::Tables& tables)
+    {
+        lastSample = std::chrono::system_clock::now();
+        boost::container::flat_map<std::string, double> readings;
+        if (ok)
+        {
+            for (const std::pair<std::string, SensorStore::Table>& table :
+                 tables)
+            {
+                const SensorTypeInfo* typeInfo = findSensorType(table.first);
+                if (typeInfo == nullptr)
+                {
+                    continue;
+                }
+                for (const std::pair<std::string, SensorStore::Interfaces>&
+                         sensor : table.second)
+                {
+                    double reading = 0;
+                    if (!readingOf(sensor.second, reading))
+                    {
+                        continue;
+                    }
+                    const std::string key = table.first + "/" + sensor.first;
+                    readings.emplace(key, reading);
+                    if (series.find(key) == series.end())
+                    {
+                        series.emplace(
+                            key,
+                            Series{propertyOf(*typeInfo, sensor.first),
+                                   telemetry_util::MetricRing(metricSamples)});
+                    }
+                }
+            }
+        }
+
+        for (auto it = series.begin(); it != series.end();)
+        {
+            auto reading = readings.find(it->first);
+            if (reading == readings.end())
+            {
+                it->second.ring.pushMissing();
+                // A sensor gone for an hour is forgotten
+                if (!it->second.ring.hasReadings())
+                {
+                    it = series.erase(it);
+                    continue;
+                }
+            }
+            else
+            {
+                it->second.ring.push(reading->second);
+            }
+            ++it;
+        }
+    }
+
+    std::unique_ptr<boost::asio::steady_timer> timer;
+    SeriesMap series;
+    std::chrono::system_clock::time_point lastSample;
+};
+
+inline MetricSampler& metricSampler()
+{
+    static MetricSampler sampler;
+    return sampler;
+}
+
+class TelemetryService : public Node
+{
+  public:
+    TelemetryService(CrowApp& app) : Node(app, "/redfish/v1/TelemetryService/")
+    {
+        Node::json["@odata.type"] = "#TelemetryService.v1_0_0.TelemetryService";
+        Node::json["@odata.id"] = "/redfish/v1/TelemetryService";
+        Node::json["@odata.context"] =
+            "/redfish/v1/$metadata#TelemetryService.TelemetryService";
+        Node::json["Id"] = "TelemetryService";
+        Node::json["Name"] = "Telemetry Service";
+        Node::json["Status"] = {{"State", "Enabled"}, {"Health", "OK"}};
+        Node::json["MinCollectionInterval"] =
+            "PT" + std::to_string(metricSampleInterval.count()) + "S";
+        Node::json["SupportedCollectionFunctions"] = {"Minimum", "Maximum",
+                                                      "Average"};
+        staticJson = true;
+
+        entityPrivileges = {
+            {boost::beast::http::verb::get, {{"Login"}}},
+            {boost::beast::http::verb::head, {{"Login"}}},
+            {boost::beast::http::verb::patch, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::put, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::delete_, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::post, {{"ConfigureManager"}}}};
+    }
+
+  private:
+    void doGet(crow::Response& res, const crow::Request& req,
+               const std::vector<std::string>& params) override
+    {
+        res.jsonValue = Node::json;
+        res.end();
+    }
+};
+
+class MetricReportCollection : public Node
+{
+  public:
+    MetricReportCollection(CrowApp& app) :
+        Node(app, "/redfish/v1/TelemetryService/MetricReports/")
+    {
+        Node::json["@odata.type"] =
+            "#MetricReportCollection.MetricReportCollection";
+        Node::json["@odata.id"] = "/redfish/v1/TelemetryService/MetricReports";
+        Node::json["@odata.context"] = "/redfish/v1/"
+                                       "$metadata#MetricReportCollection."
+                                       "MetricReportCollection";
+        Node::json["Name"] = "Metric Report Collection";
+        nlohmann::json& members = Node::json["Members"];
+        members = nlohmann::json::array();
+        for (const MetricReportDefinition& report : metricReports)
+        {
+            members.push_back(
+                {{"@odata.id", "/redfish/v1/TelemetryService/MetricReports/" +
+                                   std::string(report.id)}});
+        }
+        Node::json["Members@odata.count"] = members.size();
+        staticJson = true;
+
+        entityPrivileges = {
+            {boost::beast::http::verb::get, {{"Login"}}},
+            {boost::beast::http::verb::head, {{"Login"}}},
+            {boost::beast::http::verb::patch, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::put, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::delete_, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::post, {{"ConfigureManager"}}}};
+    }
+
+  private:
+    void doGet(crow::Response& res, const crow::Request& req,
+               const std::vector<std::string>& params) override
+    {
+        res.jsonValue = Node::json;
+        res.end();
+    }
+};
+
+/**
+ * @brief The min, max and average of every sensor over the period of the
+ *        report, computed from the sampled readings when asked for
+ */
+class MetricReport : public Node
+{
+  public:
+    MetricReport(CrowApp& app) :
+        Node(app, "/redfish/v1/TelemetryService/MetricReports/<str>/",
+             std::string())
+    {
+        Node::json["@odata.type"] = "#MetricReport.v1_0_0.MetricReport";
+        Node::json["@odata.context"] =
+            "/redfish/v1/$metadata#MetricReport.MetricReport";
+
+        entityPrivileges = {
+            {boost::beast::http::verb::get, {{"Login"}}},
+            {boost::beast::http::verb::head, {{"Login"}}},
+            {boost::beast::http::verb::patch, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::put, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::delete_, {{"ConfigureManager"}}},
+            {boost::beast::http::verb::post, {{"ConfigureManager"}}}};
+    }
+
+  private:
+    void doGet(crow::Response& res, const crow::Request& req,
+               const std::vector<std::string>& params) override
+    {
+        const std::string& id = params[0];
+        const MetricReportDefinition* report = nullptr;
+        for (const MetricReportDefinition& definition : metricReports)
+        {
+            if (id == definition.id)
+            {
+                report = &definition;
+                break;
+            }
+        }
+        if (report == nullptr)
+        {
+            res.result(boost::beast::http::status::not_found);
+            messages::addMessageToErrorJson(
+                res.jsonValue, messages::resourceNotFound("MetricReport", id));
+            res.end();
+            return;
+        }
+
+        const MetricSampler& sampler = metricSampler();
+        std::string timestamp =
+            getDateTime(sampler.getLastSample().time_since_epoch(), "%FT%T%z");
+        if (timestamp.size() > 2)
+        {
+            timestamp.insert(timestamp.end() - 2, ':');
+        }
+
+        res.jsonValue = Node::json;
+        res.jsonValue["@odata.id"] =
+            "/redfish/v1/TelemetryService/MetricReports/" + id;
+        res.jsonValue["Id"] = id;
+        res.jsonValue["Name"] = std::string(report->duration) + " Report";
+        res.jsonValue["ReportInterval"] = report->duration;
+        res.jsonValue["Timestamp"] = timestamp;
+        nlohmann::json& values = res.jsonValue["MetricValues"];
+        values = nlohmann::json::array();
+        for (const std::pair<std::string, MetricSampler::Series>& series :
+             sampler.getSeries())
+        {
+            telemetry_util::MetricRing::Summary summary =
+                series.second.ring.summarize(report->samples);
+            if (summary.count == 0)
+            {
+                continue;
+            }
+            const std::pair<const char*, double> statistics[] = {
+                {"Minimum", summary.min},
+                {"Maximum", summary.max},
+                {"Average", summary.average}};
+            for (const std::pair<const char*, double>& statistic : statistics)
+            {
+                values.push_back(
+                    {{"MetricId", statistic.first},
+                     {"MetricValue", nlohmann::json(statistic.second).dump()},
+                     {"Timestamp", timestamp},
+                     {"MetricProperty", series.second.property}});
+            }
+        }
+        res.end();
+    }
+};
+
+} // namespace redfish
@@ -55,20 +55,35 @@ class Thermal : public Node
 
         const std::string& chassisName = params[0];
         const std::string& subNodeName = "Thermal";
-        Node::json["@odata.id"] =
-            "/redfish/v1/Chassis/" + chassisName + "/Thermal";
         res.jsonValue = Node::json;
-        auto sensorAsyncResp = std::make_shared<SensorAsyncResp>(
-            res, chassisName,
-            std::initializer_list<const char*>{
+        res.jsonValue["@odata.id"] =
+            "/redfish/v1/Chassis/" + chassisName + "/Thermal";
+
+        // Only read the sensors for the arrays $select left in
+        query_util::Select select(req);
+        std::vector<const char*> types;
+        if (select.contains("Fans"))
+        {
 #ifdef OCP_CUSTOM_FLAG // Remove Entity-Manager object
-                "/xyz/openbmc_project/sensors/fan_tach",
-                "/xyz/openbmc_project/sensors/temperature"},
-            subNodeName);
+            types.push_back("/xyz/openbmc_project/sensors/fan_tach");
+#else
+            types.push_back("/xyz/openbmc_project/sensors/fan");
+#endif // OCP_CUSTOM_FLAG
+        }
+        if (select.contains("Temperatures"))
+        {
+            types.push_back("/xyz/openbmc_project/sensors/temperature");
+        }
+        auto sensorAsyncResp = crow::allocateShared<SensorAsyncResp>(
+#ifdef OCP_CUSTOM_FLAG
+            res.arena, res, chassisName, std::move(types), subNodeName);
 #else
-                "/xyz/openbmc_project/sensors/fan",
-                "/xyz/openbmc_project/sensors/temperature"});
+            res.arena, res, chassisName, std::move(types));
 #endif // OCP_CUSTOM_FLAG
+        if (sensorAsyncResp->types.empty())
+        {
+            return;
+        }
        // TODO Need to get Chassis Redundancy information.
         getChassisData(sensorAsyncResp);
     }
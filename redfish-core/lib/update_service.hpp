@@ -16,12 +16,32 @@
 #pragma once
 
 #include "node.hpp"
+#include "task_service.hpp"
 
+#include <boost/asio/steady_timer.hpp>
 #include <boost/container/flat_map.hpp>
+#include <boost/uuid/uuid.hpp>
+#include <boost/uuid/uuid_generators.hpp>
+#include <boost/uuid/uuid_io.hpp>
+#include <dbus_utility.hpp>
+#include <experimental/filesystem>
 
 namespace redfish
 {
-static std::unique_ptr<sdbusplus::bus::match::match> fwUpdateMatcher;
+
+// Images are streamed here while they are uploaded.  It is the tmpfs
+// /tmp/images is on, so handing one to the software manager is a rename,
+// and the manager never sees an image that is still arriving.
+constexpr const char* updateStagingDirectory = "/tmp";
+// How long the software manager has to unpack and verify an image
+constexpr std::chrono::seconds updateActivationTimeout{60};
+
+// The task of the firmware update in progress, if there is one
+inline std::weak_ptr<task::Task>& updateTask()
+{
+    static std::weak_ptr<task::Task> task;
+    return task;
+}
 
 class UpdateService : public Node
 {
@@ -35,11 +55,15 @@ class UpdateService : public Node
         Node::json["Id"] = "UpdateService";
         Node::json["Description"] = "Service for Software Update";
         Node::json["Name"] = "Update Service";
+        // Takes the image as the body, or as the file of a
+        // multipart/form-data body
         Node::json["HttpPushUri"] = "/redfish/v1/UpdateService";
         // UpdateService cannot be disabled
         Node::json["ServiceEnabled"] = true;
         Node::json["FirmwareInventory"] = {
             {"@odata.id", "/redfish/v1/UpdateService/FirmwareInventory"}};
+        streamBodyToFile(updateStagingDirectory,
+                         boost::beast::http::verb::post);
 
         entityPrivileges = {
             {boost::beast::http::verb::get, {{"Login"}}},
@@ -59,7 +83,7 @@ class UpdateService : public Node
     }
     static void activateImage(const std::string &objPath)
     {
-        crow::connections::systemBus->async_method_call(
+        crow::connections::tracedMethodCall(
             [objPath](const boost::system::error_code error_code) {
                 if (error_code)
                 {
@@ -74,111 +98,134 @@ class UpdateService : public Node
                 "xyz.openbmc_project.Software.Activation.RequestedActivations."
                 "Active"));
     }
+
+    // Finishes the task once the software manager has taken the image in,
+    // which it announces by adding an Activation for it
+    static void onSoftwareAdded(const std::weak_ptr<task::Task> &weakTask,
+                                sdbusplus::message::message &m)
+    {
+        std::shared_ptr<task::Task> task = weakTask.lock();
+        if (task == nullptr || task->finished() || m.is_method_error())
+        {
+            return;
+        }
+        std::vector<std::pair<
+            std::string,
+            std::vector<std::pair<std::string,
+                                  sdbusplus::message::variant<std::string>>>>>
+            interfaces_properties;
+        sdbusplus::message::object_path objPath;
+        m.read(objPath, interfaces_properties);
+        BMCWEB_LOG_DEBUG << "obj path = " << objPath.str;
+        for (auto &interface : interfaces_properties)
+        {
+            if (interface.first == "xyz.openbmc_project.Software.Activation")
+            {
+                UpdateService::activateImage(objPath.str);
+                task->finish("Completed", "OK", messages::success());
+                return;
+            }
+        }
+    }
+
+    // The image was hashed as it came in, and is handed over as soon as it
+    // is all there.  The software manager verifies it while the client
+    // follows the task the response points to.
     void doPost(crow::Response &res, const crow::Request &req,
                 const std::vector<std::string> &params) override
     {
         BMCWEB_LOG_DEBUG << "doPost...";
 
         // Only allow one FW update at a time
-        if (fwUpdateMatcher != nullptr)
+        std::shared_ptr<task::Task> running = updateTask().lock();
+        if (running != nullptr && !running->finished())
         {
             res.addHeader("Retry-After", "30");
             res.result(boost::beast::http::status::service_unavailable);
-            res.jsonValue = messages::serviceTemporarilyUnavailable("3");
+            res.jsonValue = messages::serviceTemporarilyUnavailable("30");
             res.end();
             return;
         }
-        // Make this const static so it survives outside this method
-        static boost::asio::deadline_timer timeout(
-            *req.ioService, boost::posix_time::seconds(5));
-
-        timeout.expires_from_now(boost::posix_time::seconds(5));
-
-        timeout.async_wait([&res](const boost::system::error_code &ec) {
-            fwUpdateMatcher = nullptr;
-            if (ec == boost::asio::error::operation_aborted)
-            {
-                // expected, we were canceled before the timer completed.
-                return;
-            }
-            BMCWEB_LOG_ERROR
-                << "Timed out waiting for firmware object being created";
-            BMCWEB_LOG_ERROR
-                << "FW image may has already been uploaded to server";
-            if (ec)
-            {
-                BMCWEB_LOG_ERROR << "Async_wait failed" << ec;
-                return;
-            }
-
+        if (req.upload == nullptr)
+        {
             res.result(boost::beast::http::status::internal_server_error);
-            res.jsonValue = redfish::messages::internalError();
+            res.jsonValue = messages::internalError();
             res.end();
-        });
-
-        auto callback = [&res](sdbusplus::message::message &m) {
-            BMCWEB_LOG_DEBUG << "Match fired";
-            bool flag = false;
-
-            if (m.is_method_error())
-            {
-                BMCWEB_LOG_DEBUG << "Dbus method error!!!";
-                res.end();
-                return;
-            }
-            std::vector<std::pair<
-                std::string,
-                std::vector<std::pair<
-                    std::string, sdbusplus::message::variant<std::string>>>>>
-                interfaces_properties;
-
-            sdbusplus::message::object_path objPath;
-
-            m.read(objPath, interfaces_properties); // Read in the object path
-                                                    // that was just created
-            // std::string str_objpath = objPath.str;  // keep a copy for
-            // constructing response message
-            BMCWEB_LOG_DEBUG << "obj path = " << objPath.str; // str_objpath;
-            for (auto &interface : interfaces_properties)
-            {
-                BMCWEB_LOG_DEBUG << "interface = " << interface.first;
-
-                if (interface.first ==
-                    "xyz.openbmc_project.Software.Activation")
-                {
-                    // cancel timer only when
-                    // xyz.openbmc_project.Software.Activation interface is
-                    // added
-                    boost::system::error_code ec;
-                    timeout.cancel(ec);
-                    if (ec)
-                    {
-                        BMCWEB_LOG_ERROR << "error canceling timer " << ec;
-                    }
-                    UpdateService::activateImage(objPath.str); // str_objpath);
-                    res.jsonValue = redfish::messages::success();
-                    BMCWEB_LOG_DEBUG << "ending response";
-                    res.end();
-                    fwUpdateMatcher = nullptr;
-                }
-            }
-        };
+            return;
+        }
+        auto parameters = req.formFields.find("UpdateParameters");
+        if (parameters != req.formFields.end() &&
+            nlohmann::json::parse(parameters->second, nullptr, false)
+                .is_discarded())
+        {
+            res.result(boost::beast::http::status::bad_request);
+            res.jsonValue = messages::malformedJSON();
+            res.end();
+            return;
+        }
 
-        fwUpdateMatcher = std::make_unique<sdbusplus::bus::match::match>(
+        std::shared_ptr<task::Task> task = taskStore().create(
+            std::to_string(req.upload->id), "Firmware Update");
+        task->oem["ImageSha256"] = req.bodySha256;
+        updateTask() = task;
+        std::weak_ptr<task::Task> weakTask = task;
+        task->match = std::make_unique<sdbusplus::bus::match::match>(
             *crow::connections::systemBus,
             "interface='org.freedesktop.DBus.ObjectManager',type='signal',"
             "member='InterfacesAdded',path='/xyz/openbmc_project/software'",
-            callback);
+            [weakTask](sdbusplus::message::message &m) {
+                onSoftwareAdded(weakTask, m);
+            });
+        task->timer = std::make_unique<boost::asio::steady_timer>(
+            *req.ioService, updateActivationTimeout);
+        task->timer->async_wait(
+            [weakTask](const boost::system::error_code &ec) {
+                std::shared_ptr<task::Task> task = weakTask.lock();
+                if (task == nullptr)
+                {
+                    return;
+                }
+                // Done waiting, one way or the other
+                task->match.reset();
+                if (ec)
+                {
+                    return;
+                }
+                BMCWEB_LOG_ERROR
+                    << "Timed out waiting for firmware object being created";
+                task->finish("Exception", "Critical",
+                             messages::internalError());
+            });
 
         std::string filepath(
             "/tmp/images/" +
             boost::uuids::to_string(boost::uuids::random_generator()()));
-        BMCWEB_LOG_DEBUG << "Writing file to " << filepath;
-        std::ofstream out(filepath, std::ofstream::out | std::ofstream::binary |
-                                        std::ofstream::trunc);
-        out << req.body;
-        out.close();
-        BMCWEB_LOG_DEBUG << "file upload complete!!";
+        BMCWEB_LOG_DEBUG << "Moving " << req.bodyFile << " (sha256 "
+                         << req.bodySha256 << ") to " << filepath;
+        std::error_code ec;
+        std::experimental::filesystem::rename(req.bodyFile, filepath, ec);
+        if (ec)
+        {
+            // Not on the same filesystem
+            std::experimental::filesystem::copy_file(req.bodyFile, filepath,
+                                                     ec);
+        }
+        if (ec)
+        {
+            BMCWEB_LOG_ERROR << "Failed to move image to " << filepath << ": "
+                             << ec.message();
+            task->finish("Exception", "Critical", messages::internalError());
+            res.result(boost::beast::http::status::internal_server_error);
+            res.jsonValue = messages::internalError();
+            res.end();
+            return;
+        }
+
+        res.result(boost::beast::http::status::accepted);
+        res.addHeader("Location",
+                      std::string(task::tasksUrl) + "/" + task->id);
+        task::fillTaskJson(*task, res.jsonValue);
+        res.end();
     }
 };
 
@@ -210,11 +257,16 @@ class SoftwareInventoryCollection : public Node
     void doGet(crow::Response &res, const crow::Request &req,
                const std::vector<std::string> &params) override
     {
-        std::shared_ptr<AsyncResp> asyncResp = std::make_shared<AsyncResp>(res);
+        query_util::Paging paging;
+        if (!getPaging(req, res, paging))
+        {
+            return;
+        }
+        std::shared_ptr<AsyncResp> asyncResp = AsyncResp::create(res);
         res.jsonValue = Node::json;
 
-        crow::connections::systemBus->async_method_call(
-            [asyncResp](
+        crow::connections::cachedMethodCall(
+            [asyncResp, paging](
                 const boost::system::error_code ec,
                 const std::vector<std::pair<
                     std::string, std::vector<std::pair<
@@ -226,72 +278,88 @@ class SoftwareInventoryCollection : public Node
                         boost::beast::http::status::internal_server_error);
                     return;
                 }
-                asyncResp->res.jsonValue["Members"] = nlohmann::json::array();
-                asyncResp->res.jsonValue["Members@odata.count"] = 0;
 
+                // One member per software object and service owning it, in
+                // the mapper's order, which is by path
+                std::vector<std::pair<const std::string *, const std::string *>>
+                    objects;
                 for (auto &obj : subtree)
                 {
-                    const std::vector<
-                        std::pair<std::string, std::vector<std::string>>>
-                        &connections = obj.second;
-
-                    for (auto &conn : connections)
+                    for (auto &conn : obj.second)
                     {
-                        const std::string &connectionName = conn.first;
-                        BMCWEB_LOG_DEBUG << "connectionName = "
-                                         << connectionName;
-                        BMCWEB_LOG_DEBUG << "obj.first = " << obj.first;
-
-                        crow::connections::systemBus->async_method_call(
-                            [asyncResp](
-                                const boost::system::error_code error_code,
-                                const VariantType &activation) {
-                                BMCWEB_LOG_DEBUG
-                                    << "safe returned in lambda function";
-                                if (error_code)
-                                {
-                                    asyncResp->res.result(
-                                        boost::beast::http::status::
-                                            internal_server_error);
-                                    return;
-                                }
-
-                                const std::string *sw_inv_purpose =
-                                    mapbox::getPtr<const std::string>(
-                                        activation);
-                                if (sw_inv_purpose == nullptr)
-                                {
-                                    asyncResp->res.result(
-                                        boost::beast::http::status::
-                                            internal_server_error);
-                                    return;
-                                }
-                                std::size_t last_pos =
-                                    sw_inv_purpose->rfind(".");
-                                if (last_pos == std::string::npos)
-                                {
-                                    asyncResp->res.result(
-                                        boost::beast::http::status::
-                                            internal_server_error);
-                                    return;
-                                }
-                                nlohmann::json &members =
-                                    asyncResp->res.jsonValue["Members"];
-                                members.push_back(
-                                    {{"@odata.id", "/redfish/v1/UpdateService/"
-                                                   "FirmwareInventory/" +
-                                                       sw_inv_purpose->substr(
-                                                           last_pos + 1)}});
-                                asyncResp->res
-                                    .jsonValue["Members@odata.count"] =
-                                    members.size();
-                            },
-                            connectionName, obj.first,
-                            "org.freedesktop.DBus.Properties", "Get",
-                            "xyz.openbmc_project.Software.Activation",
-                            "Activation");
+                        objects.emplace_back(&obj.first, &conn.first);
                     }
                 }
+                std::stable_sort(objects.begin(), objects.end(),
+                                 [](const auto &left, const auto &right) {
+                                     return *left.first < *right.first;
+                                 });
+
+                // A member's id is its Purpose, so only the members on the
+                // page are read, each into its own slot
+                size_t first = paging.begin(objects.size());
+                size_t last = paging.end(objects.size());
+                nlohmann::json &members = asyncResp->res.jsonValue["Members"];
+                members = nlohmann::json::array();
+                for (size_t i = first; i < last; i++)
+                {
+                    members.push_back(nullptr);
+                }
+                asyncResp->res.jsonValue["Members@odata.count"] =
+                    objects.size();
+                paging.addNextLink(asyncResp->res.jsonValue,
+                                   "/redfish/v1/UpdateService/FirmwareInventory",
+                                   objects.size());
+
+                for (size_t i = first; i < last; i++)
+                {
+                    const std::string &connectionName = *objects[i].second;
+                    const std::string &path = *objects[i].first;
+                    BMCWEB_LOG_DEBUG << "connectionName = " << connectionName;
+                    BMCWEB_LOG_DEBUG << "obj.first = " << path;
+
+                    crow::connections::coalescedMethodCall(
+                        [asyncResp, slot{i - first}](
+                            const boost::system::error_code error_code,
+                            const VariantType &activation) {
+                            BMCWEB_LOG_DEBUG
+                                << "safe returned in lambda function";
+                            if (error_code)
+                            {
+                                asyncResp->res.result(
+                                    boost::beast::http::status::
+                                        internal_server_error);
+                                return;
+                            }
+
+                            const std::string *sw_inv_purpose =
+                                mapbox::getPtr<const std::string>(activation);
+                            if (sw_inv_purpose == nullptr)
+                            {
+                                asyncResp->res.result(
+                                    boost::beast::http::status::
+                                        internal_server_error);
+                                return;
+                            }
+                            std::size_t last_pos = sw_inv_purpose->rfind(".");
+                            if (last_pos == std::string::npos)
+                            {
+                                asyncResp->res.result(
+                                    boost::beast::http::status::
+                                        internal_server_error);
+                                return;
+                            }
+                            asyncResp->res.jsonValue["Members"][slot] = {
+                                {"@odata.id",
+                                 "/redfish/v1/UpdateService/"
+                                 "FirmwareInventory/" +
+                                     sw_inv_purpose->substr(last_pos + 1)}};
+                        },
+                        connectionName, path,
+                        "org.freedesktop.DBus.Properties", "Get",
+                        "xyz.openbmc_project.Software.Activation",
+                        "Activation");
+                }
             },
             "xyz.openbmc_project.ObjectMapper",
             "/xyz/openbmc_project/object_mapper",
@@ -332,7 +400,7 @@ class SoftwareInventory : public Node
     void doGet(crow::Response &res, const crow::Request &req,
                const std::vector<std::string> &params) override
     {
-        std::shared_ptr<AsyncResp> asyncResp = std::make_shared<AsyncResp>(res);
+        std::shared_ptr<AsyncResp> asyncResp = AsyncResp::create(res);
         res.jsonValue = Node::json;
 
         if (params.size() != 1)
@@ -350,7 +418,7 @@ class SoftwareInventory : public Node
         res.jsonValue["@odata.id"] =
             "/redfish/v1/UpdateService/FirmwareInventory/" + *sw_id;
 
-        crow::connections::systemBus->async_method_call(
+        crow::connections::cachedMethodCall(
             [asyncResp, sw_id](
                 const boost::system::error_code ec,
                 const std::vector<std::pair<
@@ -381,7 +449,7 @@ class SoftwareInventory : public Node
                         continue;
                     }
 
-                    crow::connections::systemBus->async_method_call(
+                    crow::connections::coalescedMethodCall(
                         [asyncResp,
                          sw_id](const boost::system::error_code error_code,
                                 const boost::container::flat_map<
@@ -18,11 +18,16 @@
 #include "node.hpp"
 
 #include <boost/container/flat_map.hpp>
+#include <boost/uuid/uuid.hpp>
+#include <boost/uuid/uuid_generators.hpp>
+#include <boost/uuid/uuid_io.hpp>
+#include <experimental/filesystem>
 
 namespace redfish
 {
 
-static bool fileUpload = true;
+// Uploaded files are streamed here first, on the same tmpfs as /tmp/smbios
+constexpr const char* smbiosStagingDirectory = "/tmp";
 
 class UploadService : public Node
 {
@@ -39,6 +44,8 @@ class UploadService : public Node
         Node::json["HttpPushUri"] = "/redfish/v1/AmpereComputing/UploadService";
         // TODO UploadService is always enabled
         Node::json["ServiceEnabled"] = true;
+        streamBodyToFile(smbiosStagingDirectory,
+                         boost::beast::http::verb::post);
 
         entityPrivileges = {
             {boost::beast::http::verb::get, {{"Login"}}},
@@ -61,66 +68,35 @@ class UploadService : public Node
                 const std::vector<std::string> &params) override
     {
         BMCWEB_LOG_DEBUG << "doPost...";
-        // Only allow one file upload at a time
-        if (fileUpload != true)
-        {
-            res.addHeader("Retry-After", "30");
-            res.result(boost::beast::http::status::service_unavailable);
-            res.jsonValue = messages::serviceTemporarilyUnavailable("3");
-            res.end();
-            return;
-        }
-        fileUpload = false;
-
-        // Make this const static so it survives outside this method
-        static boost::asio::deadline_timer timeout(
-            *req.ioService, boost::posix_time::seconds(5));
-
-        timeout.expires_from_now(boost::posix_time::seconds(5));
-
-        timeout.async_wait([&res](const boost::system::error_code &ec) {
-            fileUpload = true;
-            if (ec == boost::asio::error::operation_aborted)
-            {
-                // expected, we were canceled before the timer completed.
-                return;
-            }
-            BMCWEB_LOG_ERROR
-                << "Timed out waiting for writing file to server";
-            if (ec)
-            {
-                BMCWEB_LOG_ERROR << "Async_wait failed" << ec;
-                return;
-            }
-
-            res.result(boost::beast::http::status::internal_server_error);
-            res.jsonValue = redfish::messages::internalError();
-            res.end();
-        });
-
         // TODO Require D-Bus service to monitor /tmp/ folder
         // to trigger appropriate handling:
         // i.e. decode SMBIOS info, verify file integrity...
         std::string filepath(
             "/tmp/smbios/" +
             boost::uuids::to_string(boost::uuids::random_generator()()));
-        BMCWEB_LOG_DEBUG << "Writing file to " << filepath;
-        std::ofstream out(filepath, std::ofstream::out | std::ofstream::binary |
-                                        std::ofstream::trunc);
-        out << req.body;
-        out.close();
-        BMCWEB_LOG_DEBUG << "file upload complete!!";
-
-        boost::system::error_code ec;
-        timeout.cancel(ec);
+        BMCWEB_LOG_DEBUG << "Moving " << req.bodyFile << " (sha256 "
+                         << req.bodySha256 << ") to " << filepath;
+        // Renamed in whole, so nothing watching /tmp/smbios sees a partial
+        // file
+        std::error_code ec;
+        std::experimental::filesystem::rename(req.bodyFile, filepath, ec);
         if (ec)
         {
-            BMCWEB_LOG_ERROR << "error canceling timer " << ec;
-            BMCWEB_LOG_ERROR << "File may has already been uploaded to server";
+            std::experimental::filesystem::copy_file(req.bodyFile, filepath,
+                                                     ec);
         }
+        if (ec)
+        {
+            BMCWEB_LOG_ERROR << "Failed to move file to " << filepath << ": "
+                             << ec.message();
+            res.result(boost::beast::http::status::internal_server_error);
+            res.jsonValue = redfish::messages::internalError();
+            res.end();
+            return;
+        }
+        BMCWEB_LOG_DEBUG << "file upload complete!!";
         res.jsonValue = redfish::messages::success();
         res.end();
-        fileUpload = true;
     }
 };
 
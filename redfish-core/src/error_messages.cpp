@@ -15,7 +15,12 @@
 */
 #include <crow/logging.h>
 
+#include <array>
+#include <boost/utility/string_view.hpp>
+#include <cstring>
 #include <error_messages.hpp>
+#include <registries/base_message_registry.hpp>
+#include <vector>
 
 namespace redfish
 {
@@ -102,6 +107,91 @@ void addMessageToJson(nlohmann::json& target, const nlohmann::json& message,
     target[extendedInfo].push_back(message);
 }
 
+namespace
+{
+
+using namespace message_registries;
+
+/**
+ * @brief Every message of the registry as JSON, all but the Message text
+ *        filled in, or all of it if the message takes no arguments
+ *
+ * Built once; a message is then a copy of its template with the arguments
+ * put into its text, instead of a new object put together field by field.
+ */
+const std::vector<nlohmann::json>& messageTemplates()
+{
+    static const std::vector<nlohmann::json> templates = [] {
+        std::vector<nlohmann::json> built;
+        built.reserve(base::registry.size());
+        for (const MessageEntry& entry : base::registry)
+        {
+            nlohmann::json message = {
+                {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
+                {"MessageId", std::string(messageVersionPrefix) + entry.first},
+                {"Severity", entry.second.severity},
+                {"Resolution", entry.second.resolution}};
+            if (entry.second.numberOfArgs == 0)
+            {
+                message["Message"] = entry.second.message;
+            }
+            built.push_back(std::move(message));
+        }
+        return built;
+    }();
+    return templates;
+}
+
+/**
+ * @brief Puts the arguments in place of %1, %2 ... in a registry message
+ */
+std::string fillMessage(const char* format, const boost::string_view* args,
+                        size_t argCount)
+{
+    size_t length = std::strlen(format);
+    for (size_t i = 0; i < argCount; i++)
+    {
+        length += args[i].size();
+    }
+    std::string filled;
+    filled.reserve(length);
+    for (const char* c = format; *c != '\0'; c++)
+    {
+        if (*c == '%' && c[1] >= '1' && c[1] <= '9')
+        {
+            const size_t arg = static_cast<size_t>(c[1] - '1');
+            if (arg < argCount)
+            {
+                filled.append(args[arg].data(), args[arg].size());
+            }
+            c++;
+            continue;
+        }
+        filled += *c;
+    }
+    return filled;
+}
+
+template <size_t index, typename... Args>
+nlohmann::json makeMessage(const Args&... args)
+{
+    static_assert(index < base::registry.size(),
+                  "Message is not in the registry");
+    static_assert(sizeof...(Args) == base::registry[index].second.numberOfArgs,
+                  "Message takes a different number of arguments");
+    nlohmann::json message = messageTemplates()[index];
+    if (sizeof...(Args) != 0)
+    {
+        const std::array<boost::string_view, sizeof...(Args)> values = {
+            {boost::string_view(args)...}};
+        message["Message"] = fillMessage(base::registry[index].second.message,
+                                         values.data(), values.size());
+    }
+    return message;
+}
+
+} // namespace
+
 /*********************************
  * AUTOGENERATED FUNCTIONS START *
  *********************************/
@@ -115,16 +205,7 @@ void addMessageToJson(nlohmann::json& target, const nlohmann::json& message,
  */
 nlohmann::json resourceInUse()
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.ResourceInUse"},
-        {"Message", "The change to the requested resource failed because the "
-                    "resource is in "
-                    "use or in transition."},
-        {"Severity", "Warning"},
-        {"Resolution",
-         "Remove the condition and resubmit the request if the operation "
-         "failed."}};
+    return makeMessage<base::messageIndex("ResourceInUse")>();
 }
 
 /**
@@ -136,15 +217,7 @@ nlohmann::json resourceInUse()
  */
 nlohmann::json malformedJSON()
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.MalformedJSON"},
-        {"Message", "The request body submitted was malformed JSON and could "
-                    "not be parsed "
-                    "by the receiving service."},
-        {"Severity", "Critical"},
-        {"Resolution", "Ensure that the request body is valid JSON and "
-                       "resubmit the request."}};
+    return makeMessage<base::messageIndex("MalformedJSON")>();
 }
 
 /**
@@ -156,14 +229,7 @@ nlohmann::json malformedJSON()
  */
 nlohmann::json resourceMissingAtURI(const std::string& arg1)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.ResourceMissingAtURI"},
-        {"Message", "The resource at the URI " + arg1 + " was not found."},
-        {"Severity", "Critical"},
-        {"Resolution", "Place a valid resource at the URI or correct the URI "
-                       "and resubmit the "
-                       "request."}};
+    return makeMessage<base::messageIndex("ResourceMissingAtURI")>(arg1);
 }
 
 /**
@@ -177,17 +243,8 @@ nlohmann::json actionParameterValueFormatError(const std::string& arg1,
                                                const std::string& arg2,
                                                const std::string& arg3)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.ActionParameterValueFormatError"},
-        {"Message",
-         "The value " + arg1 + " for the parameter " + arg2 +
-             " in the action " + arg3 +
-             " is of a different format than the parameter can accept."},
-        {"Severity", "Warning"},
-        {"Resolution",
-         "Correct the value for the parameter in the request body and resubmit "
-         "the request if the operation failed."}};
+    return makeMessage<base::messageIndex("ActionParameterValueFormatError")>(
+        arg1, arg2, arg3);
 }
 
 /**
@@ -199,16 +256,7 @@ nlohmann::json actionParameterValueFormatError(const std::string& arg1,
  */
 nlohmann::json internalError()
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.InternalError"},
-        {"Message",
-         "The request failed due to an internal service error.  The service is "
-         "still operational."},
-        {"Severity", "Critical"},
-        {"Resolution", "Resubmit the request.  If the problem persists, "
-                       "consider resetting the "
-                       "service."}};
+    return makeMessage<base::messageIndex("InternalError")>();
 }
 
 /**
@@ -220,15 +268,7 @@ nlohmann::json internalError()
  */
 nlohmann::json unrecognizedRequestBody()
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.UnrecognizedRequestBody"},
-        {"Message",
-         "The service detected a malformed request body that it was unable to "
-         "interpret."},
-        {"Severity", "Warning"},
-        {"Resolution",
-         "Correct the request body and resubmit the request if it failed."}};
+    return makeMessage<base::messageIndex("UnrecognizedRequestBody")>();
 }
 
 /**
@@ -241,16 +281,8 @@ nlohmann::json unrecognizedRequestBody()
 nlohmann::json resourceAtUriUnauthorized(const std::string& arg1,
                                          const std::string& arg2)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.ResourceAtUriUnauthorized"},
-        {"Message", "While accessing the resource at " + arg1 +
-                        ", the service received an authorization error " +
-                        arg2 + "."},
-        {"Severity", "Critical"},
-        {"Resolution",
-         "Ensure that the appropriate access is provided for the service in "
-         "order for it to access the URI."}};
+    return makeMessage<base::messageIndex("ResourceAtUriUnauthorized")>(
+        arg1, arg2);
 }
 
 /**
@@ -263,16 +295,8 @@ nlohmann::json resourceAtUriUnauthorized(const std::string& arg1,
 nlohmann::json actionParameterUnknown(const std::string& arg1,
                                       const std::string& arg2)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.ActionParameterUnknown"},
-        {"Message", "The action " + arg1 +
-                        " was submitted with the invalid parameter " + arg2 +
-                        "."},
-        {"Severity", "Warning"},
-        {"Resolution",
-         "Correct the invalid parameter and resubmit the request if the "
-         "operation failed."}};
+    return makeMessage<base::messageIndex("ActionParameterUnknown")>(
+        arg1, arg2);
 }
 
 /**
@@ -284,14 +308,7 @@ nlohmann::json actionParameterUnknown(const std::string& arg1,
  */
 nlohmann::json resourceCannotBeDeleted()
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.ResourceCannotBeDeleted"},
-        {"Message",
-         "The delete request failed because the resource requested cannot be "
-         "deleted."},
-        {"Severity", "Critical"},
-        {"Resolution", "Do not attempt to delete a non-deletable resource."}};
+    return makeMessage<base::messageIndex("ResourceCannotBeDeleted")>();
 }
 
 /**
@@ -303,14 +320,7 @@ nlohmann::json resourceCannotBeDeleted()
  */
 nlohmann::json propertyDuplicate(const std::string& arg1)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.PropertyDuplicate"},
-        {"Message", "The property " + arg1 + " was duplicated in the request."},
-        {"Severity", "Warning"},
-        {"Resolution",
-         "Remove the duplicate property from the request body and resubmit the "
-         "request if the operation failed."}};
+    return makeMessage<base::messageIndex("PropertyDuplicate")>(arg1);
 }
 
 /**
@@ -322,14 +332,8 @@ nlohmann::json propertyDuplicate(const std::string& arg1)
  */
 nlohmann::json serviceTemporarilyUnavailable(const std::string& arg1)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.ServiceTemporarilyUnavailable"},
-        {"Message", "The service is temporarily unavailable.  Retry in " +
-                        arg1 + " seconds."},
-        {"Severity", "Critical"},
-        {"Resolution",
-         "Wait for the indicated retry duration and retry the operation."}};
+    return makeMessage<base::messageIndex("ServiceTemporarilyUnavailable")>(
+        arg1);
 }
 
 /**
@@ -343,16 +347,8 @@ nlohmann::json resourceAlreadyExists(const std::string& arg1,
                                      const std::string& arg2,
                                      const std::string& arg3)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.ResourceAlreadyExists"},
-        {"Message", "The requested resource of type " + arg1 +
-                        " with the property " + arg2 + " with the value " +
-                        arg3 + " already exists."},
-        {"Severity", "Critical"},
-        {"Resolution",
-         "Do not repeat the create operation as the resource has already been "
-         "created."}};
+    return makeMessage<base::messageIndex("ResourceAlreadyExists")>(
+        arg1, arg2, arg3);
 }
 
 /**
@@ -364,14 +360,7 @@ nlohmann::json resourceAlreadyExists(const std::string& arg1,
  */
 nlohmann::json accountForSessionNoLongerExists()
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.AccountForSessionNoLongerExists"},
-        {"Message", "The account for the current session has been removed, "
-                    "thus the current "
-                    "session has been removed as well."},
-        {"Severity", "OK"},
-        {"Resolution", "Attempt to connect with a valid account."}};
+    return makeMessage<base::messageIndex("AccountForSessionNoLongerExists")>();
 }
 
 /**
@@ -383,16 +372,8 @@ nlohmann::json accountForSessionNoLongerExists()
  */
 nlohmann::json createFailedMissingReqProperties(const std::string& arg1)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.CreateFailedMissingReqProperties"},
-        {"Message",
-         "The create operation failed because the required property " + arg1 +
-             " was missing from the request."},
-        {"Severity", "Critical"},
-        {"Resolution",
-         "Correct the body to include the required property with a valid value "
-         "and resubmit the request if the operation failed."}};
+    return makeMessage<base::messageIndex("CreateFailedMissingReqProperties")>(
+        arg1);
 }
 
 /**
@@ -405,16 +386,8 @@ nlohmann::json createFailedMissingReqProperties(const std::string& arg1)
 nlohmann::json propertyValueFormatError(const std::string& arg1,
                                         const std::string& arg2)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.PropertyValueFormatError"},
-        {"Message",
-         "The value " + arg1 + " for the property " + arg2 +
-             " is of a different format than the property can accept."},
-        {"Severity", "Warning"},
-        {"Resolution",
-         "Correct the value for the property in the request body and resubmit "
-         "the request if the operation failed."}};
+    return makeMessage<base::messageIndex("PropertyValueFormatError")>(
+        arg1, arg2);
 }
 
 /**
@@ -427,15 +400,8 @@ nlohmann::json propertyValueFormatError(const std::string& arg1,
 nlohmann::json propertyValueNotInList(const std::string& arg1,
                                       const std::string& arg2)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.PropertyValueNotInList"},
-        {"Message", "The value " + arg1 + " for the property " + arg2 +
-                        " is not in the list of acceptable values."},
-        {"Severity", "Warning"},
-        {"Resolution",
-         "Choose a value from the enumeration list that the implementation can "
-         "support and resubmit the request if the operation failed."}};
+    return makeMessage<base::messageIndex("PropertyValueNotInList")>(
+        arg1, arg2);
 }
 
 /**
@@ -447,15 +413,8 @@ nlohmann::json propertyValueNotInList(const std::string& arg1,
  */
 nlohmann::json resourceAtUriInUnknownFormat(const std::string& arg1)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.ResourceAtUriInUnknownFormat"},
-        {"Message", "The resource at " + arg1 +
-                        " is in a format not recognized by the service."},
-        {"Severity", "Critical"},
-        {"Resolution",
-         "Place an image or resource or file that is recognized by the service "
-         "at the URI."}};
+    return makeMessage<base::messageIndex("ResourceAtUriInUnknownFormat")>(
+        arg1);
 }
 
 /**
@@ -467,16 +426,7 @@ nlohmann::json resourceAtUriInUnknownFormat(const std::string& arg1)
  */
 nlohmann::json serviceInUnknownState()
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.ServiceInUnknownState"},
-        {"Message",
-         "The operation failed because the service is in an unknown state and "
-         "can no longer take incoming requests."},
-        {"Severity", "Critical"},
-        {"Resolution",
-         "Restart the service and resubmit the request if the operation "
-         "failed."}};
+    return makeMessage<base::messageIndex("ServiceInUnknownState")>();
 }
 
 /**
@@ -488,17 +438,7 @@ nlohmann::json serviceInUnknownState()
  */
 nlohmann::json eventSubscriptionLimitExceeded()
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.EventSubscriptionLimitExceeded"},
-        {"Message",
-         "The event subscription failed due to the number of simultaneous "
-         "subscriptions exceeding the limit of the implementation."},
-        {"Severity", "Critical"},
-        {"Resolution",
-         "Reduce the number of other subscriptions before trying to establish "
-         "the event subscription or increase the limit of simultaneous "
-         "subscriptions (if supported)."}};
+    return makeMessage<base::messageIndex("EventSubscriptionLimitExceeded")>();
 }
 
 /**
@@ -511,15 +451,8 @@ nlohmann::json eventSubscriptionLimitExceeded()
 nlohmann::json actionParameterMissing(const std::string& arg1,
                                       const std::string& arg2)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.ActionParameterMissing"},
-        {"Message", "The action " + arg1 + " requires the parameter " + arg2 +
-                        " to be present in the request body."},
-        {"Severity", "Critical"},
-        {"Resolution", "Supply the action with the required parameter in the "
-                       "request body when "
-                       "the request is resubmitted."}};
+    return makeMessage<base::messageIndex("ActionParameterMissing")>(
+        arg1, arg2);
 }
 
 /**
@@ -531,14 +464,8 @@ nlohmann::json actionParameterMissing(const std::string& arg1,
  */
 nlohmann::json stringValueTooLong(const std::string& arg1, const int& arg2)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.StringValueTooLong"},
-        {"Message", "The string " + arg1 + " exceeds the length limit " +
-                        std::to_string(arg2) + "."},
-        {"Severity", "Warning"},
-        {"Resolution",
-         "Resubmit the request with an appropriate string length."}};
+    return makeMessage<base::messageIndex("StringValueTooLong")>(
+        arg1, std::to_string(arg2));
 }
 
 /**
@@ -551,16 +478,8 @@ nlohmann::json stringValueTooLong(const std::string& arg1, const int& arg2)
 nlohmann::json propertyValueTypeError(const std::string& arg1,
                                       const std::string& arg2)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.PropertyValueTypeError"},
-        {"Message",
-         "The value " + arg1 + " for the property " + arg2 +
-             " is of a different type than the property can accept."},
-        {"Severity", "Warning"},
-        {"Resolution",
-         "Correct the value for the property in the request body and resubmit "
-         "the request if the operation failed."}};
+    return makeMessage<base::messageIndex("PropertyValueTypeError")>(
+        arg1, arg2);
 }
 
 /**
@@ -573,14 +492,7 @@ nlohmann::json propertyValueTypeError(const std::string& arg1,
 nlohmann::json resourceNotFound(const std::string& arg1,
                                 const std::string& arg2)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.ResourceNotFound"},
-        {"Message", "The requested resource of type " + arg1 + " named " +
-                        arg2 + " was not found."},
-        {"Severity", "Critical"},
-        {"Resolution",
-         "Provide a valid resource identifier and resubmit the request."}};
+    return makeMessage<base::messageIndex("ResourceNotFound")>(arg1, arg2);
 }
 
 /**
@@ -592,16 +504,7 @@ nlohmann::json resourceNotFound(const std::string& arg1,
  */
 nlohmann::json couldNotEstablishConnection(const std::string& arg1)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.CouldNotEstablishConnection"},
-        {"Message",
-         "The service failed to establish a Connection with the URI " + arg1 +
-             "."},
-        {"Severity", "Critical"},
-        {"Resolution", "Ensure that the URI contains a valid and reachable "
-                       "node name, protocol "
-                       "information and other URI components."}};
+    return makeMessage<base::messageIndex("CouldNotEstablishConnection")>(arg1);
 }
 
 /**
@@ -613,16 +516,7 @@ nlohmann::json couldNotEstablishConnection(const std::string& arg1)
  */
 nlohmann::json propertyNotWritable(const std::string& arg1)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.PropertyNotWritable"},
-        {"Message",
-         "The property " + arg1 +
-             " is a read only property and cannot be assigned a value."},
-        {"Severity", "Warning"},
-        {"Resolution", "Remove the property from the request body and resubmit "
-                       "the request if "
-                       "the operation failed."}};
+    return makeMessage<base::messageIndex("PropertyNotWritable")>(arg1);
 }
 
 /**
@@ -635,16 +529,8 @@ nlohmann::json propertyNotWritable(const std::string& arg1)
 nlohmann::json queryParameterValueTypeError(const std::string& arg1,
                                             const std::string& arg2)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.QueryParameterValueTypeError"},
-        {"Message",
-         "The value " + arg1 + " for the query parameter " + arg2 +
-             " is of a different type than the parameter can accept."},
-        {"Severity", "Warning"},
-        {"Resolution", "Correct the value for the query parameter in the "
-                       "request and resubmit "
-                       "the request if the operation failed."}};
+    return makeMessage<base::messageIndex("QueryParameterValueTypeError")>(
+        arg1, arg2);
 }
 
 /**
@@ -656,16 +542,7 @@ nlohmann::json queryParameterValueTypeError(const std::string& arg1,
  */
 nlohmann::json serviceShuttingDown()
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.ServiceShuttingDown"},
-        {"Message",
-         "The operation failed because the service is shutting down and can no "
-         "longer take incoming requests."},
-        {"Severity", "Critical"},
-        {"Resolution",
-         "When the service becomes available, resubmit the request if the "
-         "operation failed."}};
+    return makeMessage<base::messageIndex("ServiceShuttingDown")>();
 }
 
 /**
@@ -678,17 +555,8 @@ nlohmann::json serviceShuttingDown()
 nlohmann::json actionParameterDuplicate(const std::string& arg1,
                                         const std::string& arg2)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.ActionParameterDuplicate"},
-        {"Message",
-         "The action " + arg1 +
-             " was submitted with more than one value for the parameter " +
-             arg2 + "."},
-        {"Severity", "Warning"},
-        {"Resolution",
-         "Resubmit the action with only one instance of the parameter in the "
-         "request body if the operation failed."}};
+    return makeMessage<base::messageIndex("ActionParameterDuplicate")>(
+        arg1, arg2);
 }
 
 /**
@@ -701,15 +569,8 @@ nlohmann::json actionParameterDuplicate(const std::string& arg1,
 nlohmann::json actionParameterNotSupported(const std::string& arg1,
                                            const std::string& arg2)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.ActionParameterNotSupported"},
-        {"Message", "The parameter " + arg1 + " for the action " + arg2 +
-                        " is not supported on the target resource."},
-        {"Severity", "Warning"},
-        {"Resolution",
-         "Remove the parameter supplied and resubmit the request if the "
-         "operation failed."}};
+    return makeMessage<base::messageIndex("ActionParameterNotSupported")>(
+        arg1, arg2);
 }
 
 /**
@@ -722,14 +583,8 @@ nlohmann::json actionParameterNotSupported(const std::string& arg1,
 nlohmann::json sourceDoesNotSupportProtocol(const std::string& arg1,
                                             const std::string& arg2)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.SourceDoesNotSupportProtocol"},
-        {"Message", "The other end of the Connection at " + arg1 +
-                        " does not support the specified protocol " + arg2 +
-                        "."},
-        {"Severity", "Critical"},
-        {"Resolution", "Change protocols or URIs. "}};
+    return makeMessage<base::messageIndex("SourceDoesNotSupportProtocol")>(
+        arg1, arg2);
 }
 
 /**
@@ -741,12 +596,7 @@ nlohmann::json sourceDoesNotSupportProtocol(const std::string& arg1,
  */
 nlohmann::json accountRemoved()
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.AccountRemoved"},
-        {"Message", "The account was successfully removed."},
-        {"Severity", "OK"},
-        {"Resolution", "No resolution is required."}};
+    return makeMessage<base::messageIndex("AccountRemoved")>();
 }
 
 /**
@@ -758,15 +608,7 @@ nlohmann::json accountRemoved()
  */
 nlohmann::json accessDenied(const std::string& arg1)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.AccessDenied"},
-        {"Message", "While attempting to establish a Connection to " + arg1 +
-                        ", the service denied access."},
-        {"Severity", "Critical"},
-        {"Resolution", "Attempt to ensure that the URI is correct and that the "
-                       "service has the "
-                       "appropriate credentials."}};
+    return makeMessage<base::messageIndex("AccessDenied")>(arg1);
 }
 
 /**
@@ -778,14 +620,7 @@ nlohmann::json accessDenied(const std::string& arg1)
  */
 nlohmann::json queryNotSupported()
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.QueryNotSupported"},
-        {"Message", "Querying is not supported by the implementation."},
-        {"Severity", "Warning"},
-        {"Resolution", "Remove the query parameters and resubmit the request "
-                       "if the operation "
-                       "failed."}};
+    return makeMessage<base::messageIndex("QueryNotSupported")>();
 }
 
 /**
@@ -797,16 +632,7 @@ nlohmann::json queryNotSupported()
  */
 nlohmann::json createLimitReachedForResource()
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.CreateLimitReachedForResource"},
-        {"Message", "The create operation failed because the resource has "
-                    "reached the limit "
-                    "of possible resources."},
-        {"Severity", "Critical"},
-        {"Resolution",
-         "Either delete resources and resubmit the request if the operation "
-         "failed or do not resubmit the request."}};
+    return makeMessage<base::messageIndex("CreateLimitReachedForResource")>();
 }
 
 /**
@@ -818,13 +644,7 @@ nlohmann::json createLimitReachedForResource()
  */
 nlohmann::json generalError()
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.GeneralError"},
-        {"Message", "A general error has occurred. See ExtendedInfo for more "
-                    "information."},
-        {"Severity", "Critical"},
-        {"Resolution", "See ExtendedInfo for more information."}};
+    return makeMessage<base::messageIndex("GeneralError")>();
 }
 
 /**
@@ -836,12 +656,7 @@ nlohmann::json generalError()
  */
 nlohmann::json success()
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.Success"},
-        {"Message", "Successfully Completed Request"},
-        {"Severity", "OK"},
-        {"Resolution", "None"}};
+    return makeMessage<base::messageIndex("Success")>();
 }
 
 /**
@@ -853,12 +668,7 @@ nlohmann::json success()
  */
 nlohmann::json created()
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.Created"},
-        {"Message", "The resource has been created successfully"},
-        {"Severity", "OK"},
-        {"Resolution", "None"}};
+    return makeMessage<base::messageIndex("Created")>();
 }
 
 /**
@@ -870,16 +680,7 @@ nlohmann::json created()
  */
 nlohmann::json propertyUnknown(const std::string& arg1)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.PropertyUnknown"},
-        {"Message",
-         "The property " + arg1 +
-             " is not in the list of valid properties for the resource."},
-        {"Severity", "Warning"},
-        {"Resolution",
-         "Remove the unknown property from the request body and resubmit the "
-         "request if the operation failed."}};
+    return makeMessage<base::messageIndex("PropertyUnknown")>(arg1);
 }
 
 /**
@@ -891,14 +692,7 @@ nlohmann::json propertyUnknown(const std::string& arg1)
  */
 nlohmann::json noValidSession()
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.NoValidSession"},
-        {"Message",
-         "There is no valid session established with the implementation."},
-        {"Severity", "Critical"},
-        {"Resolution",
-         "Establish as session before attempting any operations."}};
+    return makeMessage<base::messageIndex("NoValidSession")>();
 }
 
 /**
@@ -910,14 +704,7 @@ nlohmann::json noValidSession()
  */
 nlohmann::json invalidObject(const std::string& arg1)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.InvalidObject"},
-        {"Message", "The object at " + arg1 + " is invalid."},
-        {"Severity", "Critical"},
-        {"Resolution", "Either the object is malformed or the URI is not "
-                       "correct.  Correct the "
-                       "condition and resubmit the request if it failed."}};
+    return makeMessage<base::messageIndex("InvalidObject")>(arg1);
 }
 
 /**
@@ -929,16 +716,7 @@ nlohmann::json invalidObject(const std::string& arg1)
  */
 nlohmann::json resourceInStandby()
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.ResourceInStandby"},
-        {"Message",
-         "The request could not be performed because the resource is in "
-         "standby."},
-        {"Severity", "Critical"},
-        {"Resolution",
-         "Ensure that the resource is in the correct power state and resubmit "
-         "the request."}};
+    return makeMessage<base::messageIndex("ResourceInStandby")>();
 }
 
 /**
@@ -952,17 +730,8 @@ nlohmann::json actionParameterValueTypeError(const std::string& arg1,
                                              const std::string& arg2,
                                              const std::string& arg3)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.ActionParameterValueTypeError"},
-        {"Message",
-         "The value " + arg1 + " for the parameter " + arg2 +
-             " in the action " + arg3 +
-             " is of a different type than the parameter can accept."},
-        {"Severity", "Warning"},
-        {"Resolution",
-         "Correct the value for the parameter in the request body and resubmit "
-         "the request if the operation failed."}};
+    return makeMessage<base::messageIndex("ActionParameterValueTypeError")>(
+        arg1, arg2, arg3);
 }
 
 /**
@@ -974,17 +743,7 @@ nlohmann::json actionParameterValueTypeError(const std::string& arg1,
  */
 nlohmann::json sessionLimitExceeded()
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.SessionLimitExceeded"},
-        {"Message",
-         "The session establishment failed due to the number of simultaneous "
-         "sessions exceeding the limit of the implementation."},
-        {"Severity", "Critical"},
-        {"Resolution",
-         "Reduce the number of other sessions before trying to establish the "
-         "session or increase the limit of simultaneous sessions (if "
-         "supported)."}};
+    return makeMessage<base::messageIndex("SessionLimitExceeded")>();
 }
 
 /**
@@ -996,16 +755,7 @@ nlohmann::json sessionLimitExceeded()
  */
 nlohmann::json actionNotSupported(const std::string& arg1)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.ActionNotSupported"},
-        {"Message",
-         "The action " + arg1 + " is not supported by the resource."},
-        {"Severity", "Critical"},
-        {"Resolution",
-         "The action supplied cannot be resubmitted to the implementation.  "
-         "Perhaps the action was invalid, the wrong resource was the target or "
-         "the implementation documentation may be of assistance."}};
+    return makeMessage<base::messageIndex("ActionNotSupported")>(arg1);
 }
 
 /**
@@ -1017,14 +767,8 @@ nlohmann::json actionNotSupported(const std::string& arg1)
  */
 nlohmann::json invalidIndex(const int& arg1)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.InvalidIndex"},
-        {"Message", "The index " + std::to_string(arg1) +
-                        " is not a valid offset into the array."},
-        {"Severity", "Warning"},
-        {"Resolution",
-         "Verify the index value provided is within the bounds of the array."}};
+    return makeMessage<base::messageIndex("InvalidIndex")>(
+        std::to_string(arg1));
 }
 
 /**
@@ -1036,15 +780,7 @@ nlohmann::json invalidIndex(const int& arg1)
  */
 nlohmann::json emptyJSON()
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.EmptyJSON"},
-        {"Message",
-         "The request body submitted contained an empty JSON object and the "
-         "service is unable to process it."},
-        {"Severity", "Warning"},
-        {"Resolution",
-         "Add properties in the JSON object and resubmit the request."}};
+    return makeMessage<base::messageIndex("EmptyJSON")>();
 }
 
 /**
@@ -1056,14 +792,7 @@ nlohmann::json emptyJSON()
  */
 nlohmann::json queryNotSupportedOnResource()
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.QueryNotSupportedOnResource"},
-        {"Message", "Querying is not supported on the requested resource."},
-        {"Severity", "Warning"},
-        {"Resolution", "Remove the query parameters and resubmit the request "
-                       "if the operation "
-                       "failed."}};
+    return makeMessage<base::messageIndex("QueryNotSupportedOnResource")>();
 }
 
 /**
@@ -1075,17 +804,7 @@ nlohmann::json queryNotSupportedOnResource()
  */
 nlohmann::json insufficientPrivilege()
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.InsufficientPrivilege"},
-        {"Message",
-         "There are insufficient privileges for the account or credentials "
-         "associated with the current session to perform the requested "
-         "operation."},
-        {"Severity", "Critical"},
-        {"Resolution",
-         "Either abandon the operation or change the associated access rights "
-         "and resubmit the request if the operation failed."}};
+    return makeMessage<base::messageIndex("InsufficientPrivilege")>();
 }
 
 /**
@@ -1098,13 +817,7 @@ nlohmann::json insufficientPrivilege()
 nlohmann::json propertyValueModified(const std::string& arg1,
                                      const std::string& arg2)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.PropertyValueModified"},
-        {"Message", "The property " + arg1 + " was assigned the value " + arg2 +
-                        " due to modification by the service."},
-        {"Severity", "Warning"},
-        {"Resolution", "No resolution is required."}};
+    return makeMessage<base::messageIndex("PropertyValueModified")>(arg1, arg2);
 }
 
 /**
@@ -1116,14 +829,7 @@ nlohmann::json propertyValueModified(const std::string& arg1,
  */
 nlohmann::json accountNotModified()
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.AccountNotModified"},
-        {"Message", "The account modification request failed."},
-        {"Severity", "Warning"},
-        {"Resolution",
-         "The modification may have failed due to permission issues or issues "
-         "with the request body."}};
+    return makeMessage<base::messageIndex("AccountNotModified")>();
 }
 
 /**
@@ -1136,16 +842,8 @@ nlohmann::json accountNotModified()
 nlohmann::json queryParameterValueFormatError(const std::string& arg1,
                                               const std::string& arg2)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.QueryParameterValueFormatError"},
-        {"Message",
-         "The value " + arg1 + " for the parameter " + arg2 +
-             " is of a different format than the parameter can accept."},
-        {"Severity", "Warning"},
-        {"Resolution", "Correct the value for the query parameter in the "
-                       "request and resubmit "
-                       "the request if the operation failed."}};
+    return makeMessage<base::messageIndex("QueryParameterValueFormatError")>(
+        arg1, arg2);
 }
 
 /**
@@ -1157,16 +855,7 @@ nlohmann::json queryParameterValueFormatError(const std::string& arg1,
  */
 nlohmann::json propertyMissing(const std::string& arg1)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.PropertyMissing"},
-        {"Message",
-         "The property " + arg1 +
-             " is a required property and must be included in the request."},
-        {"Severity", "Warning"},
-        {"Resolution", "Ensure that the property is in the request body and "
-                       "has a valid value "
-                       "and resubmit the request if the operation failed."}};
+    return makeMessage<base::messageIndex("PropertyMissing")>(arg1);
 }
 
 /**
@@ -1178,16 +867,7 @@ nlohmann::json propertyMissing(const std::string& arg1)
  */
 nlohmann::json resourceExhaustion(const std::string& arg1)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.ResourceExhaustion"},
-        {"Message", "The resource " + arg1 +
-                        " was unable to satisfy the request "
-                        "due to unavailability of "
-                        "resources."},
-        {"Severity", "Critical"},
-        {"Resolution",
-         "Ensure that the resources are available and resubmit the request."}};
+    return makeMessage<base::messageIndex("ResourceExhaustion")>(arg1);
 }
 
 /**
@@ -1199,12 +879,7 @@ nlohmann::json resourceExhaustion(const std::string& arg1)
  */
 nlohmann::json accountModified()
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.AccountModified"},
-        {"Message", "The account was successfully modified."},
-        {"Severity", "OK"},
-        {"Resolution", "No resolution is required."}};
+    return makeMessage<base::messageIndex("AccountModified")>();
 }
 
 /**
@@ -1218,18 +893,8 @@ nlohmann::json queryParameterOutOfRange(const std::string& arg1,
                                         const std::string& arg2,
                                         const std::string& arg3)
 {
-    return nlohmann::json{
-        {"@odata.type", "/redfish/v1/$metadata#Message.v1_0_0.Message"},
-        {"MessageId", "Base.1.2.0.QueryParameterOutOfRange"},
-        {"Message", "The value " + arg1 + " for the query parameter " + arg2 +
-                        " is out of range " + arg3 + "."},
-        {"Severity", "Warning"},
-        {"Resolution",
-         "Reduce the value for the query parameter to a value that is within "
-         "range, such as a start or count value that is within bounds of the "
-         "number of resources in a collection or a page that is within the "
-         "range "
-         "of valid pages."}};
+    return makeMessage<base::messageIndex("QueryParameterOutOfRange")>(
+        arg1, arg2, arg3);
 }
 
 /*********************************
@@ -0,0 +1,274 @@
+#include "aggregator.hpp"
+#include "utils/aggregation_utils.hpp"
+
+#include <crow/app.h>
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+using namespace redfish;
+using namespace redfish::aggregation_util;
+
+TEST(AggregationUtilTest, Prefixes)
+{
+    EXPECT_EQ(prefixOf("/redfish/v1/Chassis/node2_1"), "node2");
+    EXPECT_EQ(prefixOf("/redfish/v1/Systems/node2_system/Memory"), "node2");
+    EXPECT_EQ(prefixOf("/redfish/v1/Chassis/1"), "");
+    EXPECT_EQ(prefixOf("/redfish/v1/Chassis/node2_"), "");
+    EXPECT_EQ(prefixOf("/redfish/v1/Chassis"), "");
+    EXPECT_EQ(prefixOf("/redfish/v1/Managers/node2_bmc"), "");
+
+    EXPECT_EQ(removePrefix("/redfish/v1/Chassis/node2_1/Thermal"),
+              "/redfish/v1/Chassis/1/Thermal");
+    EXPECT_EQ(removePrefix("/redfish/v1/Chassis/1/Thermal"),
+              "/redfish/v1/Chassis/1/Thermal");
+    EXPECT_EQ(addPrefix("/redfish/v1/Chassis/1/Thermal#/Fans/0", "node2"),
+              "/redfish/v1/Chassis/node2_1/Thermal#/Fans/0");
+    EXPECT_EQ(addPrefix("/redfish/v1/Systems", "node2"),
+              "/redfish/v1/Systems");
+    EXPECT_EQ(addPrefix("/redfish/v1/Managers/bmc", "node2"),
+              "/redfish/v1/Managers/bmc");
+
+    EXPECT_TRUE(isValidPrefix("node2"));
+    EXPECT_FALSE(isValidPrefix(""));
+    EXPECT_FALSE(isValidPrefix("node_2"));
+}
+
+TEST(AggregationUtilTest, PrefixLinks)
+{
+    nlohmann::json resource = {
+        {"@odata.id", "/redfish/v1/Chassis/1"},
+        {"Links",
+         {{"ComputerSystems", {{{"@odata.id", "/redfish/v1/Systems/system"}}}},
+          {"ManagedBy", {{{"@odata.id", "/redfish/v1/Managers/bmc"}}}}}},
+        {"Name", "/redfish/v1/Chassis/1"}};
+    prefixLinks(resource, "node2");
+    EXPECT_EQ(resource["@odata.id"], "/redfish/v1/Chassis/node2_1");
+    EXPECT_EQ(resource["Links"]["ComputerSystems"][0]["@odata.id"],
+              "/redfish/v1/Systems/node2_system");
+    EXPECT_EQ(resource["Links"]["ManagedBy"][0]["@odata.id"],
+              "/redfish/v1/Managers/bmc");
+    // Only links
+    EXPECT_EQ(resource["Name"], "/redfish/v1/Chassis/1");
+}
+
+TEST(AggregationUtilTest, DotSegments)
+{
+    EXPECT_TRUE(hasDotSegment("/redfish/v1/Chassis/../Managers"));
+    EXPECT_TRUE(hasDotSegment("/redfish/v1/Chassis/1/."));
+    EXPECT_TRUE(hasDotSegment("/redfish/v1/Chassis/1/%2e%2E/%2e%2e"));
+    EXPECT_TRUE(hasDotSegment("/redfish/v1/Chassis/1/.%2e/x"));
+    EXPECT_TRUE(hasDotSegment("/redfish/v1/Chassis/1/%2E"));
+    EXPECT_FALSE(hasDotSegment("/redfish/v1/Chassis/1/Thermal"));
+    EXPECT_FALSE(hasDotSegment("/redfish/v1/Chassis/1/..."));
+    EXPECT_FALSE(hasDotSegment("/redfish/v1/Chassis/1/.x/a.b"));
+    EXPECT_FALSE(hasDotSegment("/redfish/v1/Chassis/1/%2ex"));
+}
+
+TEST(AggregationUtilTest, ForwardedQuery)
+{
+    EXPECT_EQ(forwardedQuery("/redfish/v1/Chassis/node2_1"), "");
+    EXPECT_EQ(forwardedQuery("/redfish/v1/Chassis/node2_1?"), "");
+    EXPECT_EQ(forwardedQuery("/a?$top=2&$skip=4&$filter=Id%20eq%20'1'"),
+              "?$top=2&$skip=4&$filter=Id%20eq%20'1'");
+    // Applied here
+    EXPECT_EQ(forwardedQuery("/a?$select=Id&$top=2&%24expand=.&only"),
+              "?$top=2&only");
+    EXPECT_EQ(forwardedQuery("/a?$expand=*"), "");
+}
+
+TEST(AggregatorTest, ParsesConfig)
+{
+    std::vector<Satellite> satellites;
+    std::chrono::milliseconds timeout = aggregationTimeout;
+    EXPECT_TRUE(Aggregator::parseConfig(
+        R"({"Timeout": 500, "Satellites": [
+              {"Prefix": "node2", "Host": "10.0.0.2"},
+              {"Prefix": "node3", "Host": "10.0.0.3", "Port": 8080,
+               "Tls": false, "Authorization": "Basic eDp5"}]})"_json,
+        satellites, timeout));
+    EXPECT_EQ(timeout, std::chrono::milliseconds(500));
+    ASSERT_EQ(satellites.size(), 2u);
+    EXPECT_EQ(satellites[0].endpoint.port, 443);
+    EXPECT_TRUE(satellites[0].endpoint.tls);
+    EXPECT_TRUE(satellites[0].endpoint.verifyPeer);
+    EXPECT_EQ(satellites[1].endpoint.key(), "http://10.0.0.3:8080");
+    EXPECT_EQ(satellites[1].authorization, "Basic eDp5");
+
+    for (const char* invalid :
+         {R"([])", R"({"Satellites": {}})",
+          R"({"Satellites": [{"Host": "a"}]})",
+          R"({"Satellites": [{"Prefix": "a_b", "Host": "a"}]})",
+          R"({"Satellites": [{"Prefix": "a", "Host": "a", "Port": 70000}]})",
+          R"({"Timeout": "1s", "Satellites": []})"})
+    {
+        satellites.clear();
+        EXPECT_FALSE(Aggregator::parseConfig(nlohmann::json::parse(invalid),
+                                             satellites, timeout))
+            << invalid;
+    }
+}
+
+namespace
+{
+
+// A satellite with one chassis
+class Satellite1
+{
+  public:
+    explicit Satellite1(uint16_t port) :
+        io(std::make_shared<boost::asio::io_service>()),
+        server(&app, "127.0.0.1", port, nullptr, nullptr, io)
+    {
+        BMCWEB_ROUTE(app, "/redfish/v1/Chassis")
+        ([this](const crow::Request& req, crow::Response& res) {
+            authorization = std::string(req.getHeaderValue("Authorization"));
+            res.body() = R"({"Members": [
+                {"@odata.id": "/redfish/v1/Chassis/1"}]})";
+            res.end();
+        });
+        BMCWEB_ROUTE(app, "/redfish/v1/Chassis/1/Thermal")
+        ([this](const crow::Request& req, crow::Response& res) {
+            thermalTargets.push_back(std::string(req.target()));
+            res.body() = R"({"@odata.id": "/redfish/v1/Chassis/1/Thermal",
+                "Fans": [{"@odata.id":
+                          "/redfish/v1/Chassis/1/Thermal#/Fans/0"}]})";
+            res.end();
+        });
+        app.validate();
+        server.run();
+        thread = std::thread([this] { io->run(); });
+    }
+
+    ~Satellite1()
+    {
+        server.stop();
+        thread.join();
+    }
+
+    crow::SimpleApp app;
+    std::shared_ptr<boost::asio::io_service> io;
+    crow::Server<crow::SimpleApp> server;
+    std::thread thread;
+    std::string authorization;
+    // Of the requests for Thermal
+    std::vector<std::string> thermalTargets;
+};
+
+} // namespace
+
+// Satellites answer in parallel; one that doesn't answer in time is left
+// out, and the rest still come back
+TEST(AggregatorTest, MergesAndForwards)
+{
+    constexpr uint16_t port = 45481;
+    Satellite1 satellite(port);
+
+    boost::asio::io_service silentIo;
+    boost::asio::ip::tcp::acceptor silentAcceptor(
+        silentIo, boost::asio::ip::tcp::endpoint(
+                      boost::asio::ip::address::from_string("127.0.0.1"), 0));
+    std::vector<std::unique_ptr<boost::asio::ip::tcp::socket>> silent;
+    std::function<void()> acceptSilently = [&] {
+        silent.push_back(
+            std::make_unique<boost::asio::ip::tcp::socket>(silentIo));
+        silentAcceptor.async_accept(*silent.back(),
+                                    [&](const boost::system::error_code& ec) {
+                                        if (!ec)
+                                        {
+                                            acceptSilently();
+                                        }
+                                    });
+    };
+    acceptSilently();
+    std::thread silentThread([&silentIo] { silentIo.run(); });
+
+    boost::asio::io_service io;
+    Aggregator aggregator;
+    std::vector<Satellite> satellites(2);
+    satellites[0].prefix = "node2";
+    satellites[0].endpoint = {"127.0.0.1", port, false};
+    satellites[0].authorization = "Basic eDp5";
+    satellites[1].prefix = "node3";
+    satellites[1].endpoint = {"127.0.0.1",
+                              silentAcceptor.local_endpoint().port(), false};
+    aggregator.start(io, std::move(satellites),
+                     std::chrono::milliseconds(200));
+    ASSERT_TRUE(aggregator.enabled());
+
+    crow::Response collection;
+    collection.jsonValue = {
+        {"Members", {{{"@odata.id", "/redfish/v1/Chassis/1"}}}},
+        {"Members@odata.count", 1}};
+    bool ended = false;
+    collection.setCompleteRequestHandler([&ended] { ended = true; });
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    aggregator.appendMembers("/redfish/v1/Chassis", collection);
+    io.run();
+    io.reset();
+    EXPECT_TRUE(ended);
+    EXPECT_LT(std::chrono::steady_clock::now() - start,
+              std::chrono::seconds(2));
+    EXPECT_EQ(collection.jsonValue["Members"],
+              R"([{"@odata.id": "/redfish/v1/Chassis/1"},
+                  {"@odata.id": "/redfish/v1/Chassis/node2_1"}])"_json);
+    EXPECT_EQ(collection.jsonValue["Members@odata.count"], 2);
+    EXPECT_EQ(satellite.authorization, "Basic eDp5");
+
+    boost::beast::http::request<boost::beast::http::string_body> beastReq{
+        boost::beast::http::verb::get,
+        "/redfish/v1/Chassis/node2_1/Thermal?$top=1&$select=Fans", 11};
+    crow::Request req(beastReq);
+    req.url = "/redfish/v1/Chassis/node2_1/Thermal";
+    crow::Response thermal;
+    ASSERT_TRUE(aggregator.forward(req, thermal));
+    io.run();
+    io.reset();
+    EXPECT_EQ(thermal.result(), boost::beast::http::status::ok);
+    EXPECT_EQ(thermal.jsonValue["@odata.id"],
+              "/redfish/v1/Chassis/node2_1/Thermal");
+    EXPECT_EQ(thermal.jsonValue["Fans"][0]["@odata.id"],
+              "/redfish/v1/Chassis/node2_1/Thermal#/Fans/0");
+    // $select is left for this service to apply
+    EXPECT_THAT(satellite.thermalTargets,
+                testing::ElementsAre("/redfish/v1/Chassis/1/Thermal?$top=1"));
+
+    // Never sent on with the satellite's credentials
+    for (const char* url : {"/redfish/v1/Chassis/node2_1/../../Managers",
+                            "/redfish/v1/Chassis/node2_1/%2e%2E/%2E%2e",
+                            "/redfish/v1/Chassis/node2_../Managers"})
+    {
+        req.url = url;
+        crow::Response escaped;
+        ASSERT_TRUE(aggregator.forward(req, escaped));
+        io.run();
+        io.reset();
+        EXPECT_EQ(escaped.result(), boost::beast::http::status::not_found)
+            << url;
+    }
+    EXPECT_EQ(satellite.thermalTargets.size(), 1u);
+
+    req.url = "/redfish/v1/Chassis/node3_1";
+    crow::Response unavailable;
+    ASSERT_TRUE(aggregator.forward(req, unavailable));
+    io.run();
+    io.reset();
+    EXPECT_EQ(unavailable.result(),
+              boost::beast::http::status::service_unavailable);
+
+    // Not a satellite's
+    crow::Response local;
+    req.url = "/redfish/v1/Chassis/1";
+    EXPECT_FALSE(aggregator.forward(req, local));
+    req.url = "/redfish/v1/Chassis/node4_1";
+    EXPECT_FALSE(aggregator.forward(req, local));
+
+    aggregator.stop();
+    silentIo.stop();
+    silentThread.join();
+}
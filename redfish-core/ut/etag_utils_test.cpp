@@ -0,0 +1,37 @@
+#include "utils/etag_utils.hpp"
+
+#include "gmock/gmock.h"
+
+using namespace redfish::etag_util;
+
+TEST(EtagTest, EqualDocumentsHashTheSame)
+{
+    nlohmann::json a = {{"Name", "system"}, {"Id", "system"}};
+    nlohmann::json b;
+    b["Id"] = "system";
+    b["Name"] = "system";
+    EXPECT_EQ(hash(a), hash(b));
+    EXPECT_EQ(makeEtag(a), makeEtag(b));
+}
+
+TEST(EtagTest, DifferentDocumentsHashDifferently)
+{
+    nlohmann::json base = {{"Name", "ab"}, {"Count", 1}};
+    EXPECT_NE(hash(base), hash(nlohmann::json{{"Name", "ab"}, {"Count", 2}}));
+    EXPECT_NE(hash(base),
+              hash(nlohmann::json{{"Name", "ab"}, {"Count", "1"}}));
+    EXPECT_NE(hash(nlohmann::json{{"a", "bc"}}),
+              hash(nlohmann::json{{"ab", "c"}}));
+    EXPECT_NE(hash(nlohmann::json::array({1, 2})),
+              hash(nlohmann::json::array({2, 1})));
+    EXPECT_NE(hash(nlohmann::json::object()),
+              hash(nlohmann::json::array()));
+}
+
+TEST(EtagTest, MakeEtagIsWeakAndQuoted)
+{
+    std::string etag = makeEtag(nlohmann::json{{"Name", "system"}});
+    ASSERT_EQ(etag.size(), 20u);
+    EXPECT_EQ(etag.substr(0, 3), "W/\"");
+    EXPECT_EQ(etag.back(), '"');
+}
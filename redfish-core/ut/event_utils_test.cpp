@@ -0,0 +1,69 @@
+#include "utils/event_utils.hpp"
+
+#include "gmock/gmock.h"
+
+using namespace redfish::event_util;
+
+TEST(EventFilterTest, EmptyFilterPassesEverything)
+{
+    EventFilter filter;
+    EXPECT_TRUE(filter.matches("Alert", "/redfish/v1/Systems/1"));
+}
+
+TEST(EventFilterTest, MatchesAnyTerm)
+{
+    EventFilter filter;
+    ASSERT_TRUE(filter.parse("EventType eq 'Alert' or "
+                             "OriginResource eq '/redfish/v1/Chassis/1/'"));
+    EXPECT_EQ(filter.getEventTypes(), std::vector<std::string>{"Alert"});
+    EXPECT_EQ(filter.getOrigins(),
+              std::vector<std::string>{"/redfish/v1/Chassis/1"});
+
+    EXPECT_TRUE(filter.matches("Alert", "/redfish/v1/Systems/1"));
+    EXPECT_TRUE(filter.matches("ResourceUpdated", "/redfish/v1/Chassis/1"));
+    EXPECT_TRUE(
+        filter.matches("ResourceUpdated", "/redfish/v1/Chassis/1/Thermal"));
+    EXPECT_FALSE(filter.matches("ResourceUpdated", "/redfish/v1/Chassis/10"));
+    EXPECT_FALSE(filter.matches("StatusChange", "/redfish/v1/Systems/1"));
+}
+
+TEST(EventFilterTest, RejectsWhatItDoesNotUnderstand)
+{
+    EventFilter filter;
+    EXPECT_FALSE(filter.parse(""));
+    EXPECT_FALSE(filter.parse("EventType eq Alert"));
+    EXPECT_FALSE(filter.parse("EventType ne 'Alert'"));
+    EXPECT_FALSE(filter.parse("Severity eq 'Critical'"));
+    EXPECT_FALSE(filter.parse("EventType eq 'Alert' and EventType eq 'x'"));
+    EXPECT_FALSE(filter.parse("EventType eq ''"));
+}
+
+TEST(EventQueueTest, CoalescesByKey)
+{
+    EventQueue queue;
+    queue.push("fan1", std::make_shared<const std::string>("a"));
+    queue.push("fan2", std::make_shared<const std::string>("b"));
+    queue.push("fan1", std::make_shared<const std::string>("c"));
+    queue.push("", std::make_shared<const std::string>("d"));
+    queue.push("", std::make_shared<const std::string>("e"));
+    EXPECT_EQ(queue.size(), 4u);
+    EXPECT_EQ(queue.coalesced, 1u);
+    EXPECT_EQ(queue.takeAll(), "bcde");
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(EventQueueTest, DropsOldestWhenFull)
+{
+    EventQueue queue(2);
+    queue.push("", std::make_shared<const std::string>("a"));
+    queue.push("", std::make_shared<const std::string>("b"));
+    queue.push("", std::make_shared<const std::string>("c"));
+    EXPECT_EQ(queue.dropped, 1u);
+    EXPECT_EQ(queue.takeAll(), "bc");
+}
+
+TEST(SseTest, FramesMessage)
+{
+    EXPECT_EQ(sseMessage(7, "{\"Id\":\"7\"}"),
+              "id: 7\ndata: {\"Id\":\"7\"}\n\n");
+}
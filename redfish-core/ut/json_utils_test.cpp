@@ -0,0 +1,75 @@
+#include "utils/json_utils.hpp"
+
+#include "gmock/gmock.h"
+
+using namespace redfish::json_util;
+
+TEST(ReadJsonTest, FillsTypedValues)
+{
+    crow::Response res;
+    nlohmann::json body = {{"UserName", "admin"},
+                           {"Enabled", false},
+                           {"Port", 443},
+                           {"Addresses", {"10.0.0.1", "10.0.0.2"}}};
+    std::string userName;
+    boost::optional<bool> enabled;
+    boost::optional<std::string> roleId;
+    uint16_t port = 0;
+    std::vector<std::string> addresses;
+    EXPECT_TRUE(readJson(body, res, "UserName", userName, "Enabled", enabled,
+                         "RoleId", roleId, "Port", port, "Addresses",
+                         addresses));
+    EXPECT_EQ(res.result(), boost::beast::http::status::ok);
+    EXPECT_EQ(userName, "admin");
+    ASSERT_TRUE(enabled);
+    EXPECT_FALSE(*enabled);
+    EXPECT_FALSE(roleId);
+    EXPECT_EQ(port, 443);
+    EXPECT_THAT(addresses, testing::ElementsAre("10.0.0.1", "10.0.0.2"));
+}
+
+TEST(ReadJsonTest, ReportsEveryProblemAtOnce)
+{
+    crow::Response res;
+    nlohmann::json body = {
+        {"UserName", 7}, {"Port", 70000}, {"Color", "blue"}};
+    std::string userName;
+    std::string password;
+    uint16_t port = 0;
+    EXPECT_FALSE(readJson(body, res, "UserName", userName, "Password",
+                          password, "Port", port));
+    EXPECT_EQ(res.result(), boost::beast::http::status::bad_request);
+
+    std::vector<std::string> ids;
+    for (const nlohmann::json& message :
+         res.jsonValue["error"]["@Message.ExtendedInfo"])
+    {
+        ids.push_back(message["MessageId"]);
+    }
+    EXPECT_THAT(ids, testing::UnorderedElementsAre(
+                         "Base.1.2.0.PropertyValueTypeError",
+                         "Base.1.2.0.PropertyValueTypeError",
+                         "Base.1.2.0.PropertyUnknown",
+                         "Base.1.2.0.PropertyMissing"));
+}
+
+TEST(ReadJsonTest, ChecksIntegerRange)
+{
+    crow::Response res;
+    nlohmann::json body = {{"Signed", -5}, {"Unsigned", -5}};
+    int8_t signedValue = 0;
+    boost::optional<uint32_t> unsignedValue;
+    EXPECT_FALSE(readJson(body, res, "Signed", signedValue, "Unsigned",
+                          unsignedValue));
+    EXPECT_EQ(signedValue, -5);
+    EXPECT_EQ(res.jsonValue["error"]["@Message.ExtendedInfo"].size(), 1u);
+}
+
+TEST(ReadJsonTest, RejectsBodyThatIsNotAnObject)
+{
+    crow::Response res;
+    nlohmann::json body = nlohmann::json::array();
+    std::string userName;
+    EXPECT_FALSE(readJson(body, res, "UserName", userName));
+    EXPECT_EQ(res.result(), boost::beast::http::status::bad_request);
+}
@@ -0,0 +1,37 @@
+#include "registries/base_message_registry.hpp"
+
+#include <algorithm>
+#include <string>
+
+#include "gmock/gmock.h"
+
+using namespace redfish::message_registries;
+
+TEST(MessageRegistryTest, ArgumentsMatchTheirSlots)
+{
+    for (const MessageEntry& entry : base::registry)
+    {
+        const Message& message = entry.second;
+        const std::string text = message.message;
+        size_t highest = 0;
+        for (size_t pos = text.find('%'); pos != std::string::npos;
+             pos = text.find('%', pos + 1))
+        {
+            ASSERT_LT(pos + 1, text.size()) << entry.first;
+            highest = std::max<size_t>(highest, text[pos + 1] - '0');
+        }
+        EXPECT_EQ(highest, message.numberOfArgs) << entry.first;
+        for (size_t i = 0; i < message.numberOfArgs; i++)
+        {
+            ASSERT_NE(message.paramTypes[i], nullptr) << entry.first;
+        }
+    }
+}
+
+TEST(MessageRegistryTest, FindsMessagesByName)
+{
+    constexpr size_t index = base::messageIndex("PropertyMissing");
+    static_assert(index < base::registry.size(), "PropertyMissing is missing");
+    EXPECT_STREQ(base::registry[index].first, "PropertyMissing");
+    EXPECT_EQ(base::messageIndex("NoSuchMessage"), base::registry.size());
+}
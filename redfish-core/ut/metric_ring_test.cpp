@@ -0,0 +1,72 @@
+#include "utils/metric_ring.hpp"
+
+#include "gmock/gmock.h"
+
+using redfish::telemetry_util::MetricRing;
+
+TEST(MetricRingTest, SummarizesNewestSamples)
+{
+    MetricRing ring(8);
+    ring.push(40.5);
+    ring.push(42.0);
+    ring.push(38.25);
+    ring.push(44.0);
+    EXPECT_EQ(ring.size(), 4u);
+
+    MetricRing::Summary all = ring.summarize(8);
+    EXPECT_EQ(all.count, 4u);
+    EXPECT_DOUBLE_EQ(all.min, 38.25);
+    EXPECT_DOUBLE_EQ(all.max, 44.0);
+    EXPECT_DOUBLE_EQ(all.average, 41.1875);
+
+    MetricRing::Summary newest = ring.summarize(2);
+    EXPECT_EQ(newest.count, 2u);
+    EXPECT_DOUBLE_EQ(newest.min, 38.25);
+    EXPECT_DOUBLE_EQ(newest.max, 44.0);
+}
+
+TEST(MetricRingTest, KeepsReadingsAcrossWrap)
+{
+    MetricRing ring(3);
+    for (int i = 1; i <= 10; i++)
+    {
+        ring.push(i * 1000.0);
+    }
+    EXPECT_EQ(ring.size(), 3u);
+    MetricRing::Summary summary = ring.summarize(3);
+    EXPECT_EQ(summary.count, 3u);
+    EXPECT_DOUBLE_EQ(summary.min, 8000.0);
+    EXPECT_DOUBLE_EQ(summary.max, 10000.0);
+    EXPECT_DOUBLE_EQ(summary.average, 9000.0);
+}
+
+TEST(MetricRingTest, SkipsMissingSamples)
+{
+    MetricRing ring(4);
+    ring.push(10.0);
+    ring.pushMissing();
+    ring.push(std::nan(""));
+    ring.push(20.0);
+    MetricRing::Summary summary = ring.summarize(4);
+    EXPECT_EQ(summary.count, 2u);
+    EXPECT_DOUBLE_EQ(summary.average, 15.0);
+
+    // The readings fall out; only missing samples are left
+    ring.pushMissing();
+    ring.pushMissing();
+    ring.pushMissing();
+    ring.pushMissing();
+    EXPECT_FALSE(ring.hasReadings());
+    EXPECT_EQ(ring.summarize(4).count, 0u);
+}
+
+TEST(MetricRingTest, JumpTooLargeIsMissing)
+{
+    MetricRing ring(4);
+    ring.push(1.0);
+    ring.push(5.0e6);
+    ring.push(2.0);
+    MetricRing::Summary summary = ring.summarize(4);
+    EXPECT_EQ(summary.count, 2u);
+    EXPECT_DOUBLE_EQ(summary.max, 2.0);
+}
@@ -125,3 +125,32 @@ TEST(PrivilegeTest, GetActivePrivilegeNames)
                     ::testing::Pointee(expectedPrivileges[3]),
                     ::testing::Pointee(expectedPrivileges[4])));
 }
+
+TEST(PrivilegeTest, GetPrivilegesFromUserPrivilege)
+{
+    boost::optional<Privileges> privileges =
+        getPrivilegesFromUserPrivilege("priv-operator");
+    ASSERT_TRUE(privileges);
+    EXPECT_THAT(privileges->getActivePrivilegeNames(PrivilegeType::BASE),
+                ::testing::UnorderedElementsAre(
+                    ::testing::Pointee(&"Login"[0]),
+                    ::testing::Pointee(&"ConfigureSelf"[0]),
+                    ::testing::Pointee(&"ConfigureComponents"[0])));
+
+    privileges = getPrivilegesFromUserPrivilege("priv-admin");
+    ASSERT_TRUE(privileges);
+    EXPECT_TRUE(privileges->isSupersetOf(*getPrivilegesFromUserPrivilege(
+        "priv-operator")));
+
+    EXPECT_FALSE(getPrivilegesFromUserPrivilege("priv-noaccess"));
+    EXPECT_FALSE(getPrivilegesFromUserPrivilege(""));
+}
+
+TEST(PrivilegeTest, BitsRoundTrip)
+{
+    Privileges privileges{"Login", "ConfigureUsers"};
+    Privileges copy(privileges.bits());
+
+    EXPECT_TRUE(copy.isSupersetOf(privileges));
+    EXPECT_TRUE(privileges.isSupersetOf(copy));
+}
@@ -0,0 +1,243 @@
+#include "utils/query_utils.hpp"
+
+#include "gmock/gmock.h"
+
+using namespace redfish::query_util;
+
+TEST(SelectTest, ContainsEverythingWithoutSelect)
+{
+    Select select;
+    EXPECT_TRUE(select.all());
+    EXPECT_TRUE(select.contains("BiosVersion"));
+}
+
+TEST(SelectTest, ContainsSelectedProperties)
+{
+    Select select("Name, Status/Health,,");
+    EXPECT_FALSE(select.all());
+    EXPECT_TRUE(select.contains("Name"));
+    EXPECT_TRUE(select.contains("Status"));
+    EXPECT_FALSE(select.contains("Health"));
+    EXPECT_FALSE(select.contains("BiosVersion"));
+}
+
+TEST(SelectTest, ApplyPrunesUnselectedProperties)
+{
+    nlohmann::json json = {
+        {"@odata.id", "/redfish/v1/Systems/system"},
+        {"Name", "system"},
+        {"BiosVersion", "1.0"},
+        {"Status", {{"Health", "OK"}, {"State", "Enabled"}}},
+        {"Members",
+         {{{"Id", "1"}, {"Name", "a"}}, {{"Id", "2"}, {"Name", "b"}}}}};
+
+    Select("Name,Status/Health,Members/Id").apply(json);
+
+    EXPECT_EQ(json, nlohmann::json({
+                        {"@odata.id", "/redfish/v1/Systems/system"},
+                        {"Name", "system"},
+                        {"Status", {{"Health", "OK"}}},
+                        {"Members", {{{"Id", "1"}}, {{"Id", "2"}}}},
+                    }));
+}
+
+TEST(ExpandTest, Parse)
+{
+    Expand expand;
+    EXPECT_TRUE(expand.parse("*"));
+    EXPECT_EQ(Expand::Scope::all, expand.scope);
+    EXPECT_EQ(1U, expand.levels);
+    EXPECT_EQ("", expand.nextLevel());
+
+    EXPECT_TRUE(expand.parse(".($levels=2)"));
+    EXPECT_EQ(Expand::Scope::notLinks, expand.scope);
+    EXPECT_EQ(2U, expand.levels);
+    EXPECT_EQ(".($levels=1)", expand.nextLevel());
+
+    EXPECT_TRUE(expand.parse("~"));
+    EXPECT_EQ(Expand::Scope::links, expand.scope);
+
+    EXPECT_FALSE(expand.parse(""));
+    EXPECT_FALSE(expand.parse("Members"));
+    EXPECT_FALSE(expand.parse("*($levels=0)"));
+    EXPECT_FALSE(expand.parse("*($levels=2"));
+    EXPECT_FALSE(expand.parse("*($levels=2x)"));
+    EXPECT_FALSE(expand.parse("*($levels=99)"));
+}
+
+TEST(ExpandTest, FindReferences)
+{
+    nlohmann::json json = {
+        {"@odata.id", "/redfish/v1/Systems"},
+        {"Members",
+         {{{"@odata.id", "/redfish/v1/Systems/system"}},
+          {{"@odata.id", "/redfish/v1/Systems/other"}}}},
+        {"Links", {{"Chassis", {{{"@odata.id", "/redfish/v1/Chassis/c"}}}}}},
+        {"Status", {{"Health", "OK"}}}};
+
+    std::vector<nlohmann::json*> found;
+    findReferences(json, Expand::Scope::all, found);
+    EXPECT_EQ(3U, found.size());
+
+    found.clear();
+    findReferences(json, Expand::Scope::notLinks, found);
+    ASSERT_EQ(2U, found.size());
+    EXPECT_EQ(&json["Members"][0], found[0]);
+    EXPECT_EQ(&json["Members"][1], found[1]);
+
+    found.clear();
+    findReferences(json, Expand::Scope::links, found);
+    ASSERT_EQ(1U, found.size());
+    EXPECT_EQ(&json["Links"]["Chassis"][0], found[0]);
+}
+
+TEST(PagingTest, ParseCount)
+{
+    size_t count = 7;
+    EXPECT_TRUE(Paging::parseCount("0", count));
+    EXPECT_EQ(count, 0u);
+    EXPECT_TRUE(Paging::parseCount("25", count));
+    EXPECT_EQ(count, 25u);
+
+    EXPECT_FALSE(Paging::parseCount("", count));
+    EXPECT_FALSE(Paging::parseCount("-1", count));
+    EXPECT_FALSE(Paging::parseCount("1e3", count));
+    EXPECT_FALSE(Paging::parseCount("9999999999", count));
+    EXPECT_EQ(count, 25u);
+}
+
+TEST(PagingTest, PageBounds)
+{
+    Paging all;
+    EXPECT_EQ(all.begin(10), 0u);
+    EXPECT_EQ(all.end(10), 10u);
+
+    Paging paging;
+    paging.skip = 4;
+    paging.top = 3;
+    EXPECT_EQ(paging.begin(10), 4u);
+    EXPECT_EQ(paging.end(10), 7u);
+    EXPECT_EQ(paging.begin(5), 4u);
+    EXPECT_EQ(paging.end(5), 5u);
+    EXPECT_EQ(paging.begin(2), 2u);
+    EXPECT_EQ(paging.end(2), 2u);
+}
+
+TEST(PagingTest, NextLinkOnlyWhenMoreMembers)
+{
+    Paging paging;
+    paging.skip = 2;
+    paging.top = 2;
+
+    nlohmann::json json = nlohmann::json::object();
+    paging.addNextLink(json, "/redfish/v1/Entries", 5);
+    EXPECT_EQ(json["Members@odata.nextLink"],
+              "/redfish/v1/Entries?$skip=4&$top=2");
+
+    json = nlohmann::json::object();
+    paging.addNextLink(json, "/redfish/v1/Entries", 4);
+    EXPECT_EQ(json.count("Members@odata.nextLink"), 0u);
+}
+
+TEST(PagingTest, TopIsCapped)
+{
+    boost::beast::http::request<boost::beast::http::string_body> beastReq;
+    crow::Request req(beastReq);
+    req.urlParams = crow::QueryString("/redfish/v1/Entries?$top=5000");
+    Paging paging;
+    EXPECT_EQ(paging.parse(req), nullptr);
+    EXPECT_EQ(paging.top, maxPageMembers);
+
+    Paging all;
+    EXPECT_EQ(all.end(maxPageMembers * 2), maxPageMembers);
+}
+
+TEST(PagingTest, AddMembersOnlyVisitsThePage)
+{
+    Paging paging;
+    paging.skip = 3;
+    paging.top = 2;
+
+    std::vector<size_t> visited;
+    nlohmann::json json = nlohmann::json::object();
+    paging.addMembers(json, "/redfish/v1/Entries", 6, [&visited](size_t i) {
+        visited.push_back(i);
+        return "/redfish/v1/Entries/" + std::to_string(i);
+    });
+
+    EXPECT_EQ(visited, (std::vector<size_t>{3, 4}));
+    EXPECT_EQ(json["Members"],
+              nlohmann::json::parse(R"([{"@odata.id":"/redfish/v1/Entries/3"},
+                                        {"@odata.id":"/redfish/v1/Entries/4"}])"));
+    EXPECT_EQ(json["Members@odata.count"], 6);
+    EXPECT_EQ(json["Members@odata.nextLink"],
+              "/redfish/v1/Entries?$skip=5&$top=2");
+}
+
+TEST(FilterTest, Parse)
+{
+    Filter filter;
+    EXPECT_TRUE(filter.empty());
+    EXPECT_TRUE(filter.parse("Severity eq 'Critical'"));
+    EXPECT_FALSE(filter.empty());
+    EXPECT_TRUE(filter.parse("(Id gt 3 or Id lt 1) and Status/Health ne 'OK'"));
+    EXPECT_TRUE(filter.parse("Message eq 'It''s hot'"));
+    EXPECT_FALSE(filter.parse(""));
+    EXPECT_FALSE(filter.parse("Severity"));
+    EXPECT_FALSE(filter.parse("Severity has 'Critical'"));
+    EXPECT_FALSE(filter.parse("Severity eq 'Critical"));
+    EXPECT_FALSE(filter.parse("Severity eq Critical"));
+    EXPECT_FALSE(filter.parse("(Id eq 1"));
+    EXPECT_FALSE(filter.parse("Id eq 1 and"));
+    EXPECT_FALSE(filter.parse("Id eq 1 Id eq 2"));
+    EXPECT_FALSE(filter.parse("Status//Health eq 'OK'"));
+    EXPECT_FALSE(filter.parse(std::string(100, '(') + "Id eq 1" +
+                              std::string(100, ')')));
+    EXPECT_TRUE(filter.empty());
+}
+
+TEST(FilterTest, Matches)
+{
+    nlohmann::json entry = {{"Id", "7"},
+                            {"SensorNumber", 12},
+                            {"Severity", "Critical"},
+                            {"Created", "2018-11-02T10:00:00+00:00"},
+                            {"Status", {{"Health", "OK"}}}};
+    Filter filter;
+    EXPECT_TRUE(filter.matches(entry));
+
+    const std::pair<const char*, bool> cases[] = {
+        {"Severity eq 'Critical'", true},
+        {"Severity ne 'Critical'", false},
+        {"Created gt '2018-11-01T00:00:00+00:00'", true},
+        {"Created lt '2018-11-01T00:00:00+00:00'", false},
+        {"SensorNumber ge 12 and SensorNumber le 12.0", true},
+        {"SensorNumber gt 12", false},
+        {"Severity eq 'OK' or Status/Health eq 'OK'", true},
+        {"Severity eq 'OK' or (Id eq '7' and SensorNumber lt 3)", false},
+        // Different types never compare equal
+        {"Id eq 7", false},
+        {"Id ne 7", true},
+        {"Resolved eq null", true},
+        {"Resolved eq false", false},
+        {"Status/Missing/Deeper eq null", true},
+        {"Severity/Health eq null", true},
+    };
+    for (const std::pair<const char*, bool>& test : cases)
+    {
+        ASSERT_TRUE(filter.parse(test.first)) << test.first;
+        EXPECT_EQ(filter.matches(entry), test.second) << test.first;
+    }
+}
+
+TEST(PagingTest, NextLinkKeepsOtherParameters)
+{
+    Paging paging;
+    paging.top = 2;
+    paging.keep("$filter", "Severity eq 'Critical'");
+    nlohmann::json json;
+    paging.addNextLink(json, "/redfish/v1/Entries", 5);
+    EXPECT_EQ(json["Members@odata.nextLink"],
+              "/redfish/v1/Entries?$skip=2&$top=2&$filter=Severity%20eq%20%"
+              "27Critical%27");
+}
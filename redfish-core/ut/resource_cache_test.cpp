@@ -0,0 +1,198 @@
+#include "resource_cache.hpp"
+
+#include <memory>
+#include <string>
+
+#include "gmock/gmock.h"
+
+using namespace redfish;
+
+namespace
+{
+
+std::shared_ptr<const CachedResource> makeResource(const std::string& body)
+{
+    auto resource = std::make_shared<CachedResource>();
+    resource->body = body;
+    resource->etag = "W/\"" + body + "\"";
+    return resource;
+}
+
+CachePolicy chassisPolicy()
+{
+    CachePolicy policy;
+    policy.dependencies = {
+        {"/xyz/openbmc_project/state/chassis0", false,
+         "xyz.openbmc_project.State.Chassis", "CurrentPowerState"},
+        {"/xyz/openbmc_project/inventory/fru0", true}};
+    return policy;
+}
+
+class ResourceCacheTest : public testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        cache.start();
+    }
+
+    void TearDown() override
+    {
+        cache.stop();
+    }
+
+    // Caches body as /redfish/v1/Chassis/1
+    void fill(const std::string& body)
+    {
+        uint64_t token = cache.begin(uri, chassisPolicy());
+        ASSERT_NE(token, 0u);
+        cache.complete(uri, token, makeResource(body));
+    }
+
+    const std::string uri = "/redfish/v1/Chassis/1";
+    ResourceCache cache;
+};
+
+} // namespace
+
+TEST_F(ResourceCacheTest, HitsOnceBuilt)
+{
+    EXPECT_EQ(cache.find(uri), nullptr);
+    uint64_t token = cache.begin(uri, chassisPolicy());
+    // Still being built
+    EXPECT_EQ(cache.find(uri), nullptr);
+    cache.complete(uri, token, makeResource("on"));
+    std::shared_ptr<const CachedResource> resource = cache.find(uri);
+    ASSERT_NE(resource, nullptr);
+    EXPECT_EQ(resource->body, "on");
+    EXPECT_EQ(cache.hits(), 1u);
+    EXPECT_EQ(cache.misses(), 2u);
+}
+
+TEST_F(ResourceCacheTest, DroppedByDependencies)
+{
+    fill("on");
+    // Not a property, interface or object it depends on
+    cache.propertiesChanged("/xyz/openbmc_project/state/chassis0",
+                            "xyz.openbmc_project.State.Chassis",
+                            {"LastStateChangeTime"});
+    cache.propertiesChanged("/xyz/openbmc_project/state/chassis0",
+                            "xyz.openbmc_project.Object.Enable",
+                            {"CurrentPowerState"});
+    cache.propertiesChanged("/xyz/openbmc_project/state/chassis1",
+                            "xyz.openbmc_project.State.Chassis",
+                            {"CurrentPowerState"});
+    cache.propertiesChanged("/xyz/openbmc_project/inventory/fru01",
+                            "xyz.openbmc_project.Inventory.FRU.Product",
+                            {"Name"});
+    ASSERT_NE(cache.find(uri), nullptr);
+    EXPECT_EQ(cache.invalidations(), 0u);
+
+    cache.propertiesChanged(
+        "/xyz/openbmc_project/state/chassis0",
+        "xyz.openbmc_project.State.Chassis",
+        {"RequestedPowerTransition", "CurrentPowerState"});
+    EXPECT_EQ(cache.find(uri), nullptr);
+    EXPECT_EQ(cache.size(), 0u);
+
+    // Anything below a subtree
+    fill("on");
+    cache.propertiesChanged("/xyz/openbmc_project/inventory/fru0/product",
+                            "xyz.openbmc_project.Inventory.FRU.Product",
+                            {"Name"});
+    EXPECT_EQ(cache.find(uri), nullptr);
+
+    // Objects coming and going, whatever the interface
+    fill("on");
+    cache.objectChanged("/xyz/openbmc_project/state/chassis0");
+    EXPECT_EQ(cache.find(uri), nullptr);
+    EXPECT_EQ(cache.invalidations(), 3u);
+}
+
+TEST_F(ResourceCacheTest, CollectionsIgnoreProperties)
+{
+    CachePolicy policy;
+    CacheDependency inventory;
+    inventory.path = "/xyz/openbmc_project/inventory";
+    inventory.subtree = true;
+    inventory.properties = false;
+    policy.dependencies.push_back(inventory);
+    const std::string collection = "/redfish/v1/Chassis";
+    cache.complete(collection, cache.begin(collection, std::move(policy)),
+                   makeResource("members"));
+
+    cache.propertiesChanged("/xyz/openbmc_project/inventory/system/chassis",
+                            "xyz.openbmc_project.Inventory.Item", {"Present"});
+    ASSERT_NE(cache.find(collection), nullptr);
+    cache.objectChanged("/xyz/openbmc_project/inventory/system/chassis2");
+    EXPECT_EQ(cache.find(collection), nullptr);
+}
+
+// A change while the resource is being built may have come too late for
+// some of what it read
+TEST_F(ResourceCacheTest, DiscardsResultsBuiltAcrossAChange)
+{
+    uint64_t token = cache.begin(uri, chassisPolicy());
+    cache.propertiesChanged("/xyz/openbmc_project/state/chassis0",
+                            "xyz.openbmc_project.State.Chassis",
+                            {"CurrentPowerState"});
+    cache.complete(uri, token, makeResource("stale"));
+    EXPECT_EQ(cache.find(uri), nullptr);
+
+    // Nor does an older build replace a newer one
+    uint64_t first = cache.begin(uri, chassisPolicy());
+    uint64_t second = cache.begin(uri, chassisPolicy());
+    cache.complete(uri, second, makeResource("new"));
+    cache.complete(uri, first, makeResource("old"));
+    ASSERT_NE(cache.find(uri), nullptr);
+    EXPECT_EQ(cache.find(uri)->body, "new");
+
+    cache.abandon(uri, first);
+    EXPECT_NE(cache.find(uri), nullptr);
+    cache.erase(uri);
+    EXPECT_EQ(cache.find(uri), nullptr);
+}
+
+TEST_F(ResourceCacheTest, Expires)
+{
+    CachePolicy policy;
+    policy.maxAge = std::chrono::seconds(0);
+    cache.complete(uri, cache.begin(uri, std::move(policy)),
+                   makeResource("on"));
+    EXPECT_EQ(cache.find(uri), nullptr);
+    EXPECT_EQ(cache.size(), 0u);
+}
+
+TEST_F(ResourceCacheTest, FollowsTheSignalDispatcher)
+{
+    fill("on");
+    crow::connections::signalDispatcher().notifyPropertiesChanged(
+        "/xyz/openbmc_project/state/chassis0",
+        "xyz.openbmc_project.State.Chassis", {"CurrentPowerState"});
+    EXPECT_EQ(cache.find(uri), nullptr);
+
+    fill("on");
+    const std::string other = "/redfish/v1/Chassis";
+    cache.complete(other, cache.begin(other, CachePolicy()),
+                   makeResource("members"));
+    crow::connections::signalDispatcher().notifyServiceChanged(
+        "xyz.openbmc_project.State.Chassis");
+    EXPECT_EQ(cache.size(), 0u);
+
+    cache.stop();
+    EXPECT_FALSE(cache.enabled());
+    crow::connections::signalDispatcher().notifyServiceChanged(
+        "xyz.openbmc_project.State.Chassis");
+}
+
+TEST_F(ResourceCacheTest, Metrics)
+{
+    fill("on");
+    cache.find(uri);
+    std::string metrics;
+    cache.appendMetrics(metrics);
+    EXPECT_THAT(metrics,
+                testing::HasSubstr("bmcweb_resource_cache_hits_total 1\n"));
+    EXPECT_THAT(metrics,
+                testing::HasSubstr("bmcweb_resource_cache_entries 1\n"));
+}
@@ -0,0 +1,47 @@
+#include "utils/route_tree.hpp"
+
+#include "gmock/gmock.h"
+
+using namespace redfish::route_tree;
+
+namespace
+{
+// The links as "parent -> name", for comparing
+std::vector<std::string> describe(const std::vector<std::string>& urls)
+{
+    std::vector<std::string> out;
+    for (const SubRoute& subRoute : findSubRoutes(urls))
+    {
+        out.push_back(urls[subRoute.parent] + " -> " + subRoute.name);
+        EXPECT_EQ(subRoute.name.find('/'), std::string::npos);
+    }
+    return out;
+}
+} // namespace
+
+TEST(RouteTree, LinksDirectChildrenOnly)
+{
+    std::vector<std::string> urls{
+        "/redfish/v1/", "/redfish/v1/Systems/", "/redfish/v1/Systems/<str>/",
+        "/redfish/v1/Systems/<str>/Memory/", "/redfish/v1/Managers"};
+    EXPECT_THAT(describe(urls),
+                testing::ElementsAre("/redfish/v1/ -> Systems",
+                                     "/redfish/v1/Systems/ -> <str>",
+                                     "/redfish/v1/Systems/<str>/ -> Memory",
+                                     "/redfish/v1/ -> Managers"));
+}
+
+TEST(RouteTree, ParentWithoutTrailingSlash)
+{
+    std::vector<std::string> urls{"/redfish/v1/Managers/bmc",
+                                  "/redfish/v1/Managers/bmc/LogServices/"};
+    EXPECT_THAT(describe(urls), testing::ElementsAre(
+                                    "/redfish/v1/Managers/bmc -> LogServices"));
+}
+
+TEST(RouteTree, SkipsMetadataAndEmptyUrls)
+{
+    std::vector<std::string> urls{"", "/redfish/v1/", "/redfish/v1/$metadata",
+                                  "/redfish"};
+    EXPECT_THAT(describe(urls), testing::ElementsAre("/redfish -> v1"));
+}
@@ -0,0 +1,142 @@
+#include "utils/schema_store.hpp"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+
+#include "gmock/gmock.h"
+
+using crow::webassets::StaticAsset;
+using redfish::schema_util::SchemaStore;
+
+namespace
+{
+
+class SchemaStoreTest : public ::testing::Test
+{
+  protected:
+    SchemaStoreTest() :
+        root("/tmp/schema_store_test_" + std::to_string(getpid()))
+    {
+        mkdir(root.c_str(), 0700);
+        writeFile("/index.json", "{\"Id\": \"Chassis\"}");
+        writeFile("/Chassis.json", "{\"title\": \"#Chassis.v1_7_0\"}");
+        writeFile("/index.xml", "<edmx:Edmx Version=\"4.0\"/>");
+        writeFile("/index.html", "<html></html>");
+    }
+
+    ~SchemaStoreTest() override
+    {
+        for (const char* file :
+             {"/index.json", "/Chassis.json", "/index.xml", "/index.html"})
+        {
+            std::remove((root + file).c_str());
+        }
+        rmdir(root.c_str());
+    }
+
+    void writeFile(const std::string& file, const std::string& content)
+    {
+        std::ofstream out(root + file, std::ios::binary);
+        out << content;
+    }
+
+    static std::string inflate(const SchemaStore::File& file)
+    {
+        std::string content;
+        EXPECT_TRUE(gzipInflate(file.gzipped, content));
+        EXPECT_EQ(content.size(), file.size);
+        return content;
+    }
+
+    std::string root;
+};
+
+} // namespace
+
+TEST_F(SchemaStoreTest, KeepsSchemaFilesGzipped)
+{
+    const std::array<StaticAsset, 6> assets{{
+        {"/", "/index.html", "text/html;charset=UTF-8", nullptr, 13, "\"a\"",
+         false},
+        {"/redfish/v1/$metadata", "/index.xml", "application/xml", nullptr,
+         26, "\"b\"", false},
+        {"/redfish/v1/$metadata/", "/index.xml", "application/xml", nullptr,
+         26, "\"b\"", false},
+        {"/redfish/v1/JsonSchemas/Chassis", "/index.json",
+         "application/json", nullptr, 17, "\"c\"", false},
+        {"/redfish/v1/JsonSchemas/Chassis/", "/index.json",
+         "application/json", nullptr, 17, "\"c\"", false},
+        {"/redfish/v1/JsonSchemas/Chassis/Chassis.json", "/Chassis.json",
+         "application/json", nullptr, 30, "\"d\"", false},
+    }};
+
+    SchemaStore store;
+    EXPECT_EQ(store.load(root, assets), 0u);
+    // The three schema files and the collection; not the web page
+    EXPECT_EQ(store.fileCount(), 4u);
+    EXPECT_EQ(store.find("/"), nullptr);
+
+    const SchemaStore::File* metadata = store.find("/redfish/v1/$metadata/");
+    ASSERT_NE(metadata, nullptr);
+    EXPECT_EQ(inflate(*metadata), "<edmx:Edmx Version=\"4.0\"/>");
+    EXPECT_STREQ(metadata->contentType, "application/xml");
+    EXPECT_EQ(metadata->etag,
+              redfish::etag_util::makeContentEtag(inflate(*metadata)));
+
+    const SchemaStore::File* schema =
+        store.find("/redfish/v1/JsonSchemas/Chassis/Chassis.json");
+    ASSERT_NE(schema, nullptr);
+    EXPECT_EQ(inflate(*schema), "{\"title\": \"#Chassis.v1_7_0\"}");
+    EXPECT_NE(schema->etag, metadata->etag);
+}
+
+TEST_F(SchemaStoreTest, ListsTheSchemaFilesItHas)
+{
+    const std::array<StaticAsset, 3> assets{{
+        {"/redfish/v1/JsonSchemas/Chassis", "/index.json",
+         "application/json", nullptr, 17, "\"c\"", false},
+        {"/redfish/v1/JsonSchemas/Chassis/Chassis.json", "/Chassis.json",
+         "application/json", nullptr, 30, "\"d\"", false},
+        // Listed, but not there
+        {"/redfish/v1/JsonSchemas/Missing", "/Missing/index.json",
+         "application/json", nullptr, 17, "\"e\"", false},
+    }};
+
+    SchemaStore store;
+    EXPECT_EQ(store.load(root, assets), 1u);
+    const SchemaStore::File* collection =
+        store.find("/redfish/v1/JsonSchemas/");
+    ASSERT_NE(collection, nullptr);
+    nlohmann::json json = nlohmann::json::parse(inflate(*collection));
+    EXPECT_EQ(json["@odata.id"], "/redfish/v1/JsonSchemas");
+    EXPECT_EQ(json["Members@odata.count"], 1);
+    EXPECT_EQ(json["Members"],
+              nlohmann::json::array(
+                  {{{"@odata.id", "/redfish/v1/JsonSchemas/Chassis"}}}));
+    EXPECT_EQ(store.find("/redfish/v1/JsonSchemas/Missing"), nullptr);
+}
+
+TEST_F(SchemaStoreTest, LoadsInTheBackground)
+{
+    const std::array<StaticAsset, 1> assets{{
+        {"/redfish/v1/JsonSchemas/Chassis", "/index.json",
+         "application/json", nullptr, 17, "\"c\"", false},
+    }};
+
+    redfish::schema_util::SchemaStoreLoader loader;
+    loader.start(root, assets);
+    loader.stop();
+    const SchemaStore* store = loader.get();
+    ASSERT_NE(store, nullptr);
+    const SchemaStore::File* file =
+        store->find("/redfish/v1/JsonSchemas/Chassis");
+    ASSERT_NE(file, nullptr);
+    EXPECT_EQ(inflate(*file), "{\"Id\": \"Chassis\"}");
+
+    // Nothing until a load that started is done
+    redfish::schema_util::SchemaStoreLoader idle;
+    EXPECT_EQ(idle.get(), nullptr);
+}
@@ -0,0 +1,98 @@
+#include "user_privileges.hpp"
+
+#include <string>
+
+#include "gmock/gmock.h"
+
+using crow::persistent_data::SessionStore;
+using crow::persistent_data::UserSession;
+using redfish::UserPrivilegeStore;
+
+namespace
+{
+
+UserPrivilegeStore::ManagedObjects users()
+{
+    UserPrivilegeStore::ManagedObjects objects;
+    objects.emplace_back(
+        sdbusplus::message::object_path("/xyz/openbmc_project/user/alice"),
+        UserPrivilegeStore::Interfaces{
+            {"xyz.openbmc_project.User.Attributes",
+             {{"UserPrivilege", std::string("priv-admin")},
+              {"UserEnabled", true}}}});
+    objects.emplace_back(
+        sdbusplus::message::object_path("/xyz/openbmc_project/user/bob"),
+        UserPrivilegeStore::Interfaces{
+            {"xyz.openbmc_project.User.Attributes",
+             {{"UserPrivilege", std::string("priv-user")}}}});
+    return objects;
+}
+
+bool hasNoPrivileges(const redfish::Privileges& privileges)
+{
+    return privileges.getActivePrivilegeNames(redfish::PrivilegeType::BASE)
+        .empty();
+}
+
+} // namespace
+
+// Tests that users get the privileges of their role, and that users the
+// user manager doesn't know, or with a role it doesn't know, get none
+TEST(UserPrivilegeStore, ResolvesRoles)
+{
+    UserPrivilegeStore store;
+    store.setUsers(users());
+
+    UserSession alice;
+    alice.username = "alice";
+    EXPECT_TRUE(store.get(alice).isSupersetOf(
+        redfish::Privileges{"Login", "ConfigureManager", "ConfigureUsers"}));
+    UserSession bob;
+    bob.username = "bob";
+    EXPECT_TRUE(store.get(bob).isSupersetOf(redfish::Privileges{"Login"}));
+    EXPECT_FALSE(
+        store.get(bob).isSupersetOf(redfish::Privileges{"ConfigureUsers"}));
+
+    UserSession stranger;
+    stranger.username = "mallory";
+    EXPECT_TRUE(hasNoPrivileges(store.get(stranger)));
+
+    store.update("/xyz/openbmc_project/user/bob",
+                 {{"UserPrivilege", std::string("priv-unheard-of")}});
+    EXPECT_TRUE(hasNoPrivileges(store.get(bob)));
+}
+
+// Tests that no one has privileges before the users are read, or after the
+// user manager went away
+TEST(UserPrivilegeStore, NothingBeforeLoad)
+{
+    UserPrivilegeStore store;
+    UserSession alice;
+    alice.username = "alice";
+    EXPECT_TRUE(hasNoPrivileges(store.get(alice)));
+
+    store.setUsers(users());
+    EXPECT_FALSE(hasNoPrivileges(store.get(alice)));
+
+    store.clear();
+    EXPECT_TRUE(hasNoPrivileges(store.get(alice)));
+}
+
+// Tests that a deleted user loses its privileges and its sessions
+TEST(UserPrivilegeStore, DeletedUser)
+{
+    UserPrivilegeStore store;
+    store.setUsers(users());
+    SessionStore& sessions = SessionStore::getInstance();
+    std::shared_ptr<UserSession> alice = sessions.generateUserSession("alice");
+    std::shared_ptr<UserSession> bob = sessions.generateUserSession("bob");
+    EXPECT_FALSE(hasNoPrivileges(store.get(*alice)));
+
+    store.remove("/xyz/openbmc_project/user/alice");
+    EXPECT_TRUE(hasNoPrivileges(store.get(*alice)));
+    EXPECT_EQ(sessions.loginSessionByToken(alice->sessionToken), nullptr);
+    EXPECT_EQ(sessions.getSessionByUid(alice->uniqueId), nullptr);
+    EXPECT_EQ(sessions.loginSessionByToken(bob->sessionToken), bob);
+
+    sessions.removeSession(bob);
+}
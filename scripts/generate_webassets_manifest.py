@@ -0,0 +1,151 @@
+#!/usr/bin/python3
+"""Describes the files of the web root as a C++ table, so that bmcweb can
+serve them without walking, reading and hashing the directory at startup.
+
+generate_webassets_manifest.py <web root> <output header>
+"""
+import hashlib
+import os
+import re
+import sys
+
+CONTENT_TYPES = {
+    ".css": "text/css;charset=UTF-8",
+    ".html": "text/html;charset=UTF-8",
+    ".js": "text/html;charset=UTF-8",
+    ".png": "image/png;charset=UTF-8",
+    ".woff": "application/x-font-woff",
+    ".woff2": "application/x-font-woff2",
+    ".gif": "image/gif",
+    ".ico": "image/x-icon",
+    ".ttf": "application/x-font-ttf",
+    ".svg": "image/svg+xml",
+    ".eot": "application/vnd.ms-fontobject",
+    ".xml": "application/xml",
+    ".json": "application/json",
+    ".jpg": "image/jpeg",
+    ".jpeg": "image/jpeg",
+    # dev tools don't care about map type, setting to json causes browser to
+    # show as text
+    ".map": "application/json",
+}
+
+HASH_PART = re.compile(r"^[0-9a-fA-F]{8,}$")
+
+
+def is_hashed_filename(filename):
+    """Bundlers name their output like app.3f2a9c1b.js.  Any dot separated
+    part of the name, other than the first and last, made of 8 or more hex
+    digits is taken as a content hash."""
+    parts = filename.split(".")
+    return any(HASH_PART.match(part) for part in parts[1:-1])
+
+
+def list_files(root):
+    """The regular files under root, relative to it, without hidden
+    directories or symlinked ones"""
+    files = []
+    for directory, dirs, names in os.walk(root):
+        dirs[:] = [d for d in dirs if not d.startswith(".")]
+        for name in names:
+            path = os.path.join(directory, name)
+            if os.path.isfile(path):
+                files.append("/" + os.path.relpath(path, root))
+    return files
+
+
+def c_string(value):
+    if value is None:
+        return "nullptr"
+    out = '"'
+    for byte in value.encode("utf-8"):
+        char = chr(byte)
+        if char in '"\\':
+            out += "\\" + char
+        elif 0x20 <= byte < 0x7f:
+            out += char
+        else:
+            out += "\\%03o" % byte
+    return out + '"'
+
+
+def build_manifest(root):
+    assets = {}
+    # A gzipped file sorts after the plain one, so in reverse it comes first
+    # and wins the URL they share
+    for relative in sorted(list_files(root), reverse=True):
+        webpath = relative
+        encoding = None
+        base, extension = os.path.splitext(webpath)
+        if extension == ".gz":
+            webpath = base
+            extension = os.path.splitext(webpath)[1]
+            encoding = "gzip"
+
+        urls = [webpath]
+        if os.path.basename(webpath).startswith("index."):
+            directory = os.path.dirname(webpath)
+            if directory.endswith("/"):
+                urls = [directory]
+            else:
+                urls = [directory, directory + "/"]
+
+        content_type = CONTENT_TYPES.get(extension)
+        if content_type is None:
+            sys.stderr.write("Cannot determine content-type for %s\n" %
+                             relative)
+
+        with open(os.path.join(root, relative.lstrip("/")), "rb") as f:
+            data = f.read()
+        asset = (relative, content_type, encoding, len(data),
+                 '"' + hashlib.sha1(data).hexdigest() + '"',
+                 is_hashed_filename(os.path.basename(relative)))
+        for url in urls:
+            if url not in assets:
+                assets[url] = asset
+    return assets
+
+
+def write_header(assets, output):
+    rows = []
+    for url in sorted(assets, key=lambda u: u.encode("utf-8")):
+        relative, content_type, encoding, size, etag, immutable = assets[url]
+        rows.append("    {%s, %s, %s, %s, %d, %s, %s}," % (
+            c_string(url), c_string(relative), c_string(content_type),
+            c_string(encoding), size, c_string(etag),
+            "true" if immutable else "false"))
+
+    text = ("#pragma once\n"
+            "// Generated by scripts/generate_webassets_manifest.py; "
+            "do not edit\n\n"
+            "#include <static_asset.hpp>\n\n"
+            "#include <array>\n\n"
+            "namespace crow\n{\nnamespace webassets\n{\n\n"
+            "// Sorted by url\n"
+            "constexpr std::array<StaticAsset, %d> staticAssets{{\n"
+            "%s"
+            "}};\n\n"
+            "} // namespace webassets\n} // namespace crow\n" %
+            (len(rows), "".join(row + "\n" for row in rows)))
+
+    # Leave the file alone if nothing changed, so nothing rebuilds
+    if os.path.exists(output):
+        with open(output) as f:
+            if f.read() == text:
+                return
+    with open(output, "w") as f:
+        f.write(text)
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.stderr.write(__doc__)
+        return 1
+    root, output = sys.argv[1:]
+    assets = build_manifest(root) if os.path.isdir(root) else {}
+    write_header(assets, output)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -114,7 +114,7 @@ for schema, version in schema_files.items():
 
     index_json = {
         "@odata.context": "/redfish/v1/$metadata#JsonSchemaFile.JsonSchemaFile",
-        "@odata.id": "/redfish/v1/JSONSchemas/" + schema,
+        "@odata.id": "/redfish/v1/JsonSchemas/" + schema,
         "@odata.type": "#JsonSchemaFile.v1_0_2.JsonSchemaFile",
         "Name": schema + " Schema File",
         "Schema": "#" + schema + "." + schema,
@@ -128,7 +128,7 @@ for schema, version in schema_files.items():
             {
                 "Language": "en",
                 "PublicationUri": "http://redfish.dmtf.org/schemas/v1/" + schema + ".json",
-                "Uri": "/redfish/v1/JSONSchemas/" + schema + "/" + schema + ".json"
+                "Uri": "/redfish/v1/JsonSchemas/" + schema + "/" + schema + ".json"
             }
         ],
         "Location@odata.count": 1,
@@ -140,7 +140,7 @@ for schema, version in schema_files.items():
         schema_file.write(zip_ref.read(zip_filepath))
 
 with open(os.path.join(json_schema_path, "index.json"), 'w') as index_file:
-    members = [{"@odata.id": "/redfish/v1/JsonSchemas/" + schema + "/"}
+    members = [{"@odata.id": "/redfish/v1/JsonSchemas/" + schema}
                for schema in schema_files]
 
     members.sort(key=lambda x: x["@odata.id"])
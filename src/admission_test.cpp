@@ -0,0 +1,207 @@
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <crow/admission.h>
+#include <crow/app.h>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+using crow::AdmissionControl;
+using crow::AdmissionLimits;
+
+namespace
+{
+boost::asio::ip::address client(const char* address)
+{
+    return boost::asio::ip::address::from_string(address);
+}
+
+// Serves app on a Unix socket under the global admissionControl() limits
+// given, restoring the old ones when done
+class LimitedServer
+{
+  public:
+    LimitedServer(crow::SimpleApp& app, const AdmissionLimits& limits) :
+        path("/tmp/bmcweb_admission_test." + std::to_string(getpid())),
+        oldLimits(crow::admissionControl().limits()),
+        io(std::make_shared<boost::asio::io_service>())
+    {
+        crow::admissionControl().setLimits(limits);
+        unlink(path.c_str());
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+        bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        listen(fd, 4);
+        app.validate();
+        server = std::make_unique<
+            crow::Server<crow::SimpleApp, crow::UnixSocketAdaptor>>(
+            &app, fd, nullptr, nullptr, io);
+        server->run();
+        auto runIo = io;
+        thread = std::thread([runIo] { runIo->run(); });
+    }
+
+    ~LimitedServer()
+    {
+        server->stop();
+        thread.join();
+        unlink(path.c_str());
+        crow::admissionControl().setLimits(oldLimits);
+    }
+
+    LimitedServer(const LimitedServer&) = delete;
+    LimitedServer& operator=(const LimitedServer&) = delete;
+
+    void connect(boost::asio::local::stream_protocol::socket& client)
+    {
+        client.connect(boost::asio::local::stream_protocol::endpoint(path));
+    }
+
+    // Everything the server sends on client until it closes it
+    static std::string
+        readAll(boost::asio::local::stream_protocol::socket& client)
+    {
+        std::string response;
+        boost::system::error_code ec;
+        boost::asio::read(client, boost::asio::dynamic_buffer(response), ec);
+        return response;
+    }
+
+    std::string exchange(const std::string& request)
+    {
+        boost::asio::io_service clientIo;
+        boost::asio::local::stream_protocol::socket client(clientIo);
+        connect(client);
+        boost::asio::write(client, boost::asio::buffer(request));
+        return readAll(client);
+    }
+
+  private:
+    std::string path;
+    AdmissionLimits oldLimits;
+    std::shared_ptr<boost::asio::io_service> io;
+    std::unique_ptr<crow::Server<crow::SimpleApp, crow::UnixSocketAdaptor>>
+        server;
+    std::thread thread;
+};
+
+const std::string getHello = "GET /hello HTTP/1.1\r\nHost: localhost\r\n"
+                             "Connection: close\r\n\r\n";
+} // namespace
+
+// Tests that connections are refused past the total and per client limits
+TEST(AdmissionControl, LimitsConnections)
+{
+    AdmissionControl control;
+    AdmissionLimits limits;
+    limits.maxConnections = 3;
+    limits.maxConnectionsPerClient = 2;
+    control.setLimits(limits);
+
+    EXPECT_TRUE(control.openConnection(client("10.0.0.1")));
+    EXPECT_TRUE(control.openConnection(client("10.0.0.1")));
+    EXPECT_FALSE(control.openConnection(client("10.0.0.1")));
+    EXPECT_TRUE(control.openConnection(client("10.0.0.2")));
+    EXPECT_FALSE(control.openConnection(client("10.0.0.3")));
+    EXPECT_EQ(control.openConnections(), 3u);
+    EXPECT_EQ(control.getCounters().refusedConnections, 2u);
+
+    control.closeConnection(client("10.0.0.1"));
+    EXPECT_TRUE(control.openConnection(client("10.0.0.3")));
+    EXPECT_FALSE(control.openConnection(client("10.0.0.1")));
+    control.closeConnection(client("10.0.0.2"));
+    EXPECT_TRUE(control.openConnection(client("10.0.0.1")));
+}
+
+// Tests that bulk requests are shed before the reserved part of the limits,
+// which interactive ones can still use
+TEST(AdmissionControl, ReservesCapacityForInteractive)
+{
+    AdmissionControl control;
+    AdmissionLimits limits;
+    limits.maxConnections = 10;
+    limits.maxRequestsInFlight = 3;
+    limits.reservedConnections = 2;
+    limits.reservedRequests = 1;
+    control.setLimits(limits);
+    control.openConnection(client("10.0.0.1"));
+
+    EXPECT_TRUE(control.startRequest(false));
+    EXPECT_TRUE(control.startRequest(false));
+    EXPECT_FALSE(control.startRequest(false));
+    EXPECT_TRUE(control.startRequest(true));
+    EXPECT_FALSE(control.startRequest(true));
+    EXPECT_EQ(control.requestsInFlight(), 3u);
+    EXPECT_EQ(control.getCounters().shedRequests, 2u);
+
+    control.finishRequest();
+    control.finishRequest();
+    EXPECT_TRUE(control.startRequest(false));
+
+    // Connections into the reserve only get interactive requests through
+    for (int i = 0; i < 8; i++)
+    {
+        control.openConnection(client("10.0.0.2"));
+    }
+    EXPECT_EQ(control.openConnections(), 9u);
+    EXPECT_FALSE(control.startRequest(false));
+    EXPECT_TRUE(control.startRequest(true));
+}
+
+// Tests that a shed request goes out as 503 with Retry-After, and a
+// request without Host as 400, not as the 200 the response started as
+TEST(AdmissionControl, StatusLinesOnTheWire)
+{
+    crow::SimpleApp app;
+    BMCWEB_ROUTE(app, "/hello")([] { return "hello"; });
+    AdmissionLimits limits;
+    limits.maxRequestsInFlight = 0;
+    limits.reservedRequests = 0;
+    limits.retryAfter = std::chrono::seconds(7);
+    LimitedServer server(app, limits);
+
+    std::string response = server.exchange(getHello);
+    EXPECT_EQ(response.compare(0, 12, "HTTP/1.1 503"), 0) << response;
+    EXPECT_NE(response.find("Retry-After: 7"), std::string::npos) << response;
+
+    response = server.exchange("GET /hello HTTP/1.1\r\n"
+                               "Connection: close\r\n\r\n");
+    EXPECT_EQ(response.compare(0, 12, "HTTP/1.1 400"), 0) << response;
+}
+
+// Tests that a connection over the limit is answered with 503 before it
+// sends anything, and that one under it is still served
+TEST(AdmissionControl, AnswersRefusedConnections)
+{
+    crow::SimpleApp app;
+    BMCWEB_ROUTE(app, "/hello")([] { return "hello"; });
+    AdmissionLimits limits;
+    limits.maxConnections = 1;
+    limits.reservedConnections = 0;
+    LimitedServer server(app, limits);
+
+    boost::asio::io_service clientIo;
+    boost::asio::local::stream_protocol::socket holder(clientIo);
+    server.connect(holder);
+    // The first connection is only counted once the server accepts it; it
+    // is answered once it is
+    boost::asio::local::stream_protocol::socket refused(clientIo);
+    for (int tries = 0; tries < 100 &&
+                        crow::admissionControl().openConnections() == 0;
+         tries++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    server.connect(refused);
+    std::string response = LimitedServer::readAll(refused);
+    EXPECT_EQ(response.compare(0, 12, "HTTP/1.1 503"), 0) << response;
+    EXPECT_NE(response.find("Retry-After: 5"), std::string::npos) << response;
+
+    boost::asio::write(holder, boost::asio::buffer(getHello));
+    response = LimitedServer::readAll(holder);
+    EXPECT_EQ(response.compare(0, 12, "HTTP/1.1 200"), 0) << response;
+}
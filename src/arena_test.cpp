@@ -0,0 +1,177 @@
+#include <crow/app.h>
+#include <crow/arena.h>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+TEST(Arena, AllocatesAligned)
+{
+    crow::Arena arena(64);
+    for (size_t alignment : {1, 2, 8, 16, 64})
+    {
+        arena.allocate(3, 1);
+        void* p = arena.allocate(24, alignment);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % alignment, 0u)
+            << alignment;
+    }
+    // Bigger than a block gets a block of its own
+    void* big = arena.allocate(1000);
+    EXPECT_NE(big, nullptr);
+    EXPECT_GT(arena.blockCount(), 1u);
+}
+
+// After one round the arena keeps a block that fits it, so the same round
+// again reuses the same memory
+TEST(Arena, ResetReusesMemory)
+{
+    crow::Arena arena(128);
+    std::vector<void*> first;
+    for (int i = 0; i < 20; i++)
+    {
+        first.push_back(arena.allocate(48));
+    }
+    EXPECT_GT(arena.blockCount(), 1u);
+    EXPECT_EQ(arena.bytesUsed(), 20u * 48);
+
+    arena.reset();
+    EXPECT_EQ(arena.blockCount(), 1u);
+    EXPECT_EQ(arena.bytesUsed(), 0u);
+    void* again = arena.allocate(48);
+    for (int i = 1; i < 20; i++)
+    {
+        arena.allocate(48);
+    }
+    EXPECT_EQ(arena.blockCount(), 1u);
+
+    arena.reset();
+    EXPECT_EQ(arena.allocate(48), again);
+}
+
+TEST(Arena, Allocator)
+{
+    crow::Arena arena;
+    std::vector<int, crow::ArenaAllocator<int>> numbers{
+        crow::ArenaAllocator<int>(&arena)};
+    for (int i = 0; i < 100; i++)
+    {
+        numbers.push_back(i);
+    }
+    EXPECT_EQ(numbers[99], 99);
+    EXPECT_GE(arena.bytesUsed(), 100 * sizeof(int));
+
+    // Without an arena it's the heap
+    std::vector<int, crow::ArenaAllocator<int>> heap;
+    heap.push_back(1);
+    EXPECT_EQ(heap[0], 1);
+}
+
+TEST(Arena, AllocateShared)
+{
+    crow::Arena arena;
+    std::weak_ptr<std::string> weak;
+    {
+        std::shared_ptr<std::string> text =
+            crow::allocateShared<std::string>(&arena, "arena");
+        weak = text;
+        EXPECT_EQ(*text, "arena");
+        EXPECT_GT(arena.bytesUsed(), sizeof(std::string));
+    }
+    EXPECT_TRUE(weak.expired());
+
+    std::shared_ptr<int> heap = crow::allocateShared<int>(nullptr, 5);
+    EXPECT_EQ(*heap, 5);
+}
+
+// Responses on a keep-alive connection share one arena, rewound between
+// them
+TEST(Arena, ReusedAcrossRequests)
+{
+    constexpr uint16_t port = 45462;
+    crow::SimpleApp app;
+    std::vector<void*> addresses;
+    BMCWEB_ROUTE(app, "/")
+    ([&addresses](const crow::Request&, crow::Response& res) {
+        std::shared_ptr<int> value = crow::allocateShared<int>(res.arena, 1);
+        addresses.push_back(value.get());
+        EXPECT_NE(res.arena, nullptr);
+        res.end();
+    });
+    app.validate();
+    auto io = std::make_shared<boost::asio::io_service>();
+    crow::Server<crow::SimpleApp> server(&app, "127.0.0.1", port, nullptr,
+                                         nullptr, io);
+    server.run();
+    std::thread serverThread([io] { io->run(); });
+
+    boost::asio::io_service clientIo;
+    boost::asio::ip::tcp::socket client(clientIo);
+    client.connect(boost::asio::ip::tcp::endpoint(
+        boost::asio::ip::address::from_string("127.0.0.1"), port));
+    boost::beast::flat_buffer buffer;
+    for (int i = 0; i < 2; i++)
+    {
+        boost::beast::http::request<boost::beast::http::empty_body> req{
+            boost::beast::http::verb::get, "/", 11};
+        req.set(boost::beast::http::field::host, "localhost");
+        boost::beast::http::write(client, req);
+        boost::beast::http::response<boost::beast::http::string_body> res;
+        boost::beast::http::read(client, buffer, res);
+        EXPECT_EQ(res.result_int(), 200u);
+    }
+
+    server.stop();
+    serverThread.join();
+
+    ASSERT_EQ(addresses.size(), 2u);
+    EXPECT_EQ(addresses[0], addresses[1]);
+}
+
+#ifdef BMCWEB_ENABLE_IO_THREAD_POOL
+// Handlers on the io_service given to the server run apart from the worker
+// that resets the arena, so their responses get none
+TEST(Arena, NoneWithWorkerThreads)
+{
+    constexpr uint16_t port = 45463;
+    crow::SimpleApp app;
+    std::vector<std::shared_ptr<int>> held;
+    BMCWEB_ROUTE(app, "/")
+    ([&held](const crow::Request&, crow::Response& res) {
+        EXPECT_EQ(res.arena, nullptr);
+        // Outlives the response, and the next request's reset
+        held.push_back(crow::allocateShared<int>(res.arena, 1));
+        res.end();
+    });
+    app.validate();
+    auto io = std::make_shared<boost::asio::io_service>();
+    crow::Server<crow::SimpleApp> server(&app, "127.0.0.1", port, nullptr,
+                                         nullptr, io);
+    server.setWorkerThreads(2);
+    server.run();
+    std::thread serverThread([io] { io->run(); });
+
+    boost::asio::io_service clientIo;
+    boost::asio::ip::tcp::socket client(clientIo);
+    client.connect(boost::asio::ip::tcp::endpoint(
+        boost::asio::ip::address::from_string("127.0.0.1"), port));
+    boost::beast::flat_buffer buffer;
+    for (int i = 0; i < 2; i++)
+    {
+        boost::beast::http::request<boost::beast::http::empty_body> req{
+            boost::beast::http::verb::get, "/", 11};
+        req.set(boost::beast::http::field::host, "localhost");
+        boost::beast::http::write(client, req);
+        boost::beast::http::response<boost::beast::http::string_body> res;
+        boost::beast::http::read(client, buffer, res);
+        EXPECT_EQ(res.result_int(), 200u);
+    }
+
+    server.stop();
+    serverThread.join();
+
+    ASSERT_EQ(held.size(), 2u);
+    EXPECT_EQ(*held[0], 1);
+    EXPECT_EQ(*held[1], 1);
+}
+#endif
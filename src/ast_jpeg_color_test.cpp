@@ -0,0 +1,53 @@
+#include "ast_jpeg_color.hpp"
+#include "ast_jpeg_idct.hpp"
+
+#include <array>
+
+#include <gtest/gtest.h>
+
+#ifdef AST_JPEG_SIMD
+// Tests every Y, Cb and Cr combination against the tables.  The reference
+// indexes as far as 21 below the range limit table with the darkest blues,
+// so the table gets zeros in front of it, the values it stands for.
+TEST(AstJpegColor, MatchesReference)
+{
+    std::array<unsigned char, 256 + 5 * 256 + 128> limitTable{};
+    unsigned char *limit = limitTable.data() + 512;
+    ast_video::idct::fillRangeLimitTable(limit);
+    ast_video::color::ColorTables tables;
+
+    std::array<unsigned char, 8> y{};
+    std::array<unsigned char, 8> cb{};
+    std::array<unsigned char, 8> cr{};
+    std::array<unsigned char, 32> reference{};
+    std::array<unsigned char, 32> vector{};
+    for (int i = 0; i < 8; i++)
+    {
+        reference[i * 4 + 3] = static_cast<unsigned char>(0xA0 + i);
+        vector[i * 4 + 3] = static_cast<unsigned char>(0xA0 + i);
+    }
+    for (int yValue = 0; yValue < 256; yValue++)
+    {
+        for (int cbValue = 0; cbValue < 256; cbValue++)
+        {
+            for (int crBase = 0; crBase < 256; crBase += 8)
+            {
+                for (int i = 0; i < 8; i++)
+                {
+                    y[i] = static_cast<unsigned char>(yValue);
+                    cb[i] = static_cast<unsigned char>(cbValue);
+                    cr[i] = static_cast<unsigned char>(crBase + i);
+                }
+                ast_video::color::convertReference(
+                    tables, limit, y.data(), cb.data(), cr.data(),
+                    reference.data(), 8);
+                ast_video::color::convertSimd(y.data(), cb.data(), cr.data(),
+                                              vector.data());
+                ASSERT_EQ(reference, vector)
+                    << "y " << yValue << " cb " << cbValue << " cr "
+                    << crBase;
+            }
+        }
+    }
+}
+#endif
@@ -1,5 +1,7 @@
 #include "ast_jpeg_decoder.hpp"
 
+#include <cstring>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
@@ -167,4 +169,37 @@ TEST(AstJpegDecoder, BufferLimits)
         EXPECT_EQ(d.outBuffer[i].b, 0x00) << "index:" << i;
         EXPECT_EQ(d.outBuffer[i].g, 0x00) << "index:" << i;
     }
-}
\ No newline at end of file
+}
+// Tests that decoding in bands gives the same frame as decoding serially, in
+// both chroma modes, and that every frame is timed
+TEST(AstJpegDecoder, ParallelMatchesSerial)
+{
+    ast_video::RawVideoBuffer out;
+    FILE *fp = fopen("test_resources/ubuntu_444_800x600_0chrom_0lum.bin", "rb");
+    ASSERT_NE(fp, nullptr);
+    size_t bufferlen = fread(out.buffer.data(), sizeof(char),
+                             out.buffer.size() * sizeof(long), fp);
+    fclose(fp);
+    ASSERT_GT(bufferlen, 0);
+
+    uint64_t frames = ast_video::decodeStats().frames;
+    for (ast_video::YuvMode mode :
+         {ast_video::YuvMode::YUV444, ast_video::YuvMode::YUV420})
+    {
+        ast_video::AstJpegDecoder serial;
+        serial.decode(out.buffer, 800, 600, mode, 0, 0);
+
+        ast_video::AstJpegDecoder parallel;
+        parallel.setBands(4);
+        // Twice, so that the second frame reuses the batches
+        for (int i = 0; i < 2; i++)
+        {
+            parallel.decode(out.buffer, 800, 600, mode, 0, 0);
+            ASSERT_EQ(memcmp(serial.outBuffer.data(),
+                             parallel.outBuffer.data(),
+                             serial.outBuffer.size() * sizeof(ast_video::RGB)),
+                      0);
+        }
+    }
+    EXPECT_EQ(ast_video::decodeStats().frames, frames + 6);
+}
@@ -0,0 +1,107 @@
+#include "ast_jpeg_huffman.hpp"
+
+#include <array>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using ast_video::huffman::BitReader;
+
+namespace
+{
+std::vector<uint32_t> randomWords(std::mt19937 &rng, size_t count)
+{
+    std::vector<uint32_t> words(count);
+    for (uint32_t &word : words)
+    {
+        word = static_cast<uint32_t>(rng());
+    }
+    return words;
+}
+
+// Bit n of the stream, most significant bit of each word first
+uint32_t bitAt(const std::vector<uint32_t> &words, size_t n)
+{
+    return (words[n / 32] >> (31 - n % 32)) & 1;
+}
+} // namespace
+
+TEST(AstJpegHuffman, BitReaderReadsInOrder)
+{
+    std::mt19937 rng(42);
+    std::vector<uint32_t> words = randomWords(rng, 4096);
+    BitReader bits;
+    bits.reset(words.data());
+    std::uniform_int_distribution<int> width(0, 32);
+    size_t position = 0;
+    while (position + 64 < words.size() * 32 - 64)
+    {
+        uint32_t expected = 0;
+        for (size_t i = 0; i < 32; i++)
+        {
+            expected = (expected << 1) | bitAt(words, position + i);
+        }
+        ASSERT_EQ(bits.window(), expected);
+        int k = width(rng);
+        if (k > 0)
+        {
+            ASSERT_EQ(bits.peek(k), expected >> (32 - k));
+        }
+        bits.skip(k);
+        position += static_cast<size_t>(k);
+        // Words are loaded only once fewer than 33 bits are left
+        ASSERT_EQ(bits.index(), (position + 32) / 32 + 1);
+    }
+}
+
+// Tests that decoding through the lookahead tables takes the same bits and
+// gives the same coefficients as decoding a code at a time, for random
+// streams, which hold every code, long ones and invalid ones included
+TEST(AstJpegHuffman, LookaheadMatchesReference)
+{
+    auto dcTable = std::make_unique<HuffmanTable>();
+    auto acTable = std::make_unique<HuffmanTable>();
+    ast_video::huffman::loadTable(dcTable.get(), stdDcChrominanceNrcodes,
+                                  stdDcChrominanceValues,
+                                  dcChrominanceHuffmancode);
+    ast_video::huffman::loadTable(acTable.get(), stdAcLuminanceNrcodes,
+                                  stdAcLuminanceValues,
+                                  acLuminanceHuffmancode);
+    auto dcLookahead = std::make_unique<ast_video::huffman::Lookahead>();
+    auto acLookahead = std::make_unique<ast_video::huffman::Lookahead>();
+    ast_video::huffman::buildLookahead(*dcTable, *dcLookahead);
+    ast_video::huffman::buildLookahead(*acTable, *acLookahead);
+
+    std::mt19937 rng(7);
+    // Streams biased towards zero bits decode into the short codes, and
+    // further blocks before running out
+    std::vector<uint32_t> words = randomWords(rng, 1 << 16);
+    for (size_t i = 0; i < words.size(); i += 2)
+    {
+        words[i] &= static_cast<uint32_t>(rng());
+    }
+
+    BitReader reference;
+    BitReader lookahead;
+    reference.reset(words.data());
+    lookahead.reset(words.data());
+    int16_t referenceDc = 0;
+    int16_t lookaheadDc = 0;
+    while (reference.index() + 64 < words.size())
+    {
+        std::array<int16_t, 64> referenceCoef{};
+        std::array<int16_t, 64> lookaheadCoef{};
+        ast_video::huffman::decodeBlockReference(reference, *dcTable,
+                                                 *acTable, &referenceDc,
+                                                 referenceCoef.data());
+        ast_video::huffman::decodeBlock(lookahead, *dcTable, *dcLookahead,
+                                        *acTable, *acLookahead, &lookaheadDc,
+                                        lookaheadCoef.data());
+        ASSERT_EQ(referenceCoef, lookaheadCoef);
+        ASSERT_EQ(referenceDc, lookaheadDc);
+        ASSERT_EQ(reference.window(), lookahead.window());
+        ASSERT_EQ(reference.index(), lookahead.index());
+    }
+}
@@ -0,0 +1,143 @@
+#include "ast_jpeg_idct.hpp"
+
+#include <array>
+#include <random>
+
+#include <gtest/gtest.h>
+
+#ifdef AST_JPEG_SIMD
+namespace
+{
+// A quantization table scaled the way AstJpegDecoder::loadQuantTable does
+std::array<long, 64> makeQuant(std::mt19937 &rng)
+{
+    const float scalefactorF[8] = {1.0f,         1.387039845f, 1.306562965f,
+                                   1.175875602f, 1.0f,         0.785694958f,
+                                   0.541196100f, 0.275899379f};
+    std::uniform_int_distribution<int> entry(1, 255);
+    std::array<long, 64> table{};
+    for (int row = 0; row < 8; row++)
+    {
+        for (int col = 0; col < 8; col++)
+        {
+            table[row * 8 + col] = static_cast<long>(
+                (entry(rng) * scalefactorF[row] * scalefactorF[col]) * 65536);
+        }
+    }
+    return table;
+}
+
+class AstJpegIdct : public testing::Test
+{
+  protected:
+    AstJpegIdct()
+    {
+        ast_video::idct::fillRangeLimitTable(limitTable.data() + 256);
+    }
+
+    void expectSame(const std::array<short, 64> &coef,
+                    const std::array<long, 64> &table)
+    {
+        ast_video::idct::Quant quant;
+        ast_video::idct::splitQuant(table, quant);
+        std::array<unsigned char, 64> reference{};
+        std::array<unsigned char, 64> vector{};
+        ast_video::idct::idctReference(coef.data(), table.data(),
+                                       limitTable.data() + 256 + 128,
+                                       reference.data());
+        ast_video::idct::idctSimd(coef.data(), quant, vector.data());
+        ASSERT_EQ(reference, vector);
+    }
+
+    std::array<unsigned char, 5 * 256 + 128> limitTable{};
+    std::mt19937 rng{1234};
+};
+} // namespace
+
+TEST_F(AstJpegIdct, MatchesReferenceOnDenseBlocks)
+{
+    std::uniform_int_distribution<int> value(-2048, 2047);
+    for (int n = 0; n < 2000; n++)
+    {
+        std::array<long, 64> table = makeQuant(rng);
+        std::array<short, 64> coef{};
+        for (short &c : coef)
+        {
+            c = static_cast<short>(value(rng));
+        }
+        expectSame(coef, table);
+    }
+}
+
+// Blocks like the ones the video engine sends: mostly zero, a few low
+// frequency terms, with some columns short-circuited by the reference, and
+// some with nothing but a DC term
+TEST_F(AstJpegIdct, MatchesReferenceOnSparseBlocks)
+{
+    std::uniform_int_distribution<int> value(-64, 64);
+    std::uniform_int_distribution<int> dc(-1024, 1023);
+    std::uniform_int_distribution<int> position(0, 63);
+    std::uniform_int_distribution<int> count(0, 6);
+    for (int n = 0; n < 5000; n++)
+    {
+        std::array<long, 64> table = makeQuant(rng);
+        std::array<short, 64> coef{};
+        coef[0] = static_cast<short>(dc(rng));
+        for (int i = count(rng); i > 0; i--)
+        {
+            coef[position(rng)] = static_cast<short>(value(rng));
+        }
+        expectSame(coef, table);
+    }
+}
+
+// Blocks whose AC terms are all in the first row, or all in four of the
+// columns, which skip part of the vector transform
+TEST_F(AstJpegIdct, MatchesReferenceWhenSkippingColumns)
+{
+    std::uniform_int_distribution<int> value(-256, 256);
+    std::uniform_int_distribution<int> column(0, 7);
+    std::uniform_int_distribution<int> row(0, 7);
+    std::uniform_int_distribution<int> shape(0, 2);
+    for (int n = 0; n < 5000; n++)
+    {
+        std::array<long, 64> table = makeQuant(rng);
+        std::array<short, 64> coef{};
+        coef[0] = static_cast<short>(value(rng));
+        int kind = shape(rng);
+        for (int i = 0; i < 4; i++)
+        {
+            int col = column(rng);
+            if (kind == 1)
+            {
+                col %= 4;
+            }
+            else if (kind == 2)
+            {
+                col = 4 + col % 4;
+            }
+            int r = kind == 0 ? 0 : row(rng);
+            coef[r * 8 + col] = static_cast<short>(value(rng));
+        }
+        expectSame(coef, table);
+    }
+}
+
+// The extremes of the coefficients, where the outputs wrap around the range
+// limit table
+TEST_F(AstJpegIdct, MatchesReferenceAtExtremes)
+{
+    std::uniform_int_distribution<int> pick(0, 2);
+    const short extremes[] = {-32768, 0, 32767};
+    for (int n = 0; n < 2000; n++)
+    {
+        std::array<long, 64> table = makeQuant(rng);
+        std::array<short, 64> coef{};
+        for (short &c : coef)
+        {
+            c = extremes[pick(rng)];
+        }
+        expectSame(coef, table);
+    }
+}
+#endif
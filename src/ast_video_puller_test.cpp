@@ -54,3 +54,35 @@ TEST(AstvideoPuller, BasicRead)
     d.decode(out.buffer, out.width, out.height, out.mode, out.ySelector,
              out.uvSelector);
 }
+
+// Tests that a frame is shared with its consumers, and comes back to be
+// captured into once the last of them drops it
+TEST(VideoFrameRing, SharesAndReturnsFrames)
+{
+    ast_video::VideoFrameRing ring(2);
+    int returned = 0;
+    ring.onReturn([&returned] { returned++; });
+
+    std::unique_ptr<ast_video::RawVideoBuffer> first = ring.take();
+    ASSERT_NE(first, nullptr);
+    const ast_video::RawVideoBuffer *frame = first.get();
+    std::shared_ptr<const ast_video::RawVideoBuffer> shared =
+        ring.share(std::move(first));
+    std::shared_ptr<const ast_video::RawVideoBuffer> copy = shared;
+
+    std::unique_ptr<ast_video::RawVideoBuffer> second = ring.take();
+    ASSERT_NE(second, nullptr);
+    // Every frame is out
+    EXPECT_EQ(ring.take(), nullptr);
+
+    shared.reset();
+    EXPECT_EQ(returned, 0);
+    copy.reset();
+    EXPECT_EQ(returned, 1);
+    EXPECT_EQ(ring.idle(), 1u);
+    EXPECT_EQ(ring.take().get(), frame);
+
+    ring.giveBack(std::move(second));
+    EXPECT_EQ(ring.idle(), 1u);
+    EXPECT_EQ(returned, 1);
+}
@@ -0,0 +1,153 @@
+#include <unistd.h>
+
+#include <basic_auth_cache.hpp>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using crow::persistent_data::UserSession;
+using crow::token_authorization::BasicAuthCache;
+using namespace std::chrono_literals;
+
+namespace
+{
+
+std::shared_ptr<UserSession> makeSession(const std::string& username)
+{
+    auto session = std::make_shared<UserSession>();
+    session->username = username;
+    return session;
+}
+
+std::string passwordFile()
+{
+    return "/tmp/basic_auth_cache_test_" + std::to_string(getpid());
+}
+
+void writeFile(const std::string& file, const std::string& content)
+{
+    std::ofstream out(file, std::ios::trunc);
+    out << content;
+}
+
+} // namespace
+
+// Tests that only the exact credentials that were inserted hit
+TEST(BasicAuthCache, FindsInsertedCredentials)
+{
+    BasicAuthCache cache;
+    cache.setPasswordFile(passwordFile());
+    BasicAuthCache::Stamp stamp;
+    std::shared_ptr<UserSession> root = makeSession("root");
+
+    EXPECT_EQ(cache.find("cm9vdDowcGVuQm1j", stamp), nullptr);
+    cache.insert("cm9vdDowcGVuQm1j", root, stamp);
+    EXPECT_EQ(cache.find("cm9vdDowcGVuQm1j", stamp), root);
+    EXPECT_EQ(cache.find("cm9vdDowcGVuQm1k", stamp), nullptr);
+    EXPECT_EQ(cache.find("cm9vdDowcGVuQm1", stamp), nullptr);
+
+    cache.clear();
+    EXPECT_EQ(cache.find("cm9vdDowcGVuQm1j", stamp), nullptr);
+}
+
+// Tests that entries stop hitting once they are older than the ttl
+TEST(BasicAuthCache, EntriesExpire)
+{
+    BasicAuthCache cache;
+    cache.setPasswordFile(passwordFile());
+    BasicAuthCache::Stamp stamp;
+    cache.setTtl(0s);
+    EXPECT_EQ(cache.find("cm9vdDowcGVuQm1j", stamp), nullptr);
+    cache.insert("cm9vdDowcGVuQm1j", makeSession("root"), stamp);
+    EXPECT_EQ(cache.find("cm9vdDowcGVuQm1j", stamp), nullptr);
+    EXPECT_EQ(cache.size(), 0u);
+}
+
+// Tests that changing the password file drops every entry
+TEST(BasicAuthCache, PasswordFileChangeClears)
+{
+    const std::string file = passwordFile();
+    writeFile(file, "root:x:1:\n");
+    BasicAuthCache cache;
+    cache.setPasswordFile(file);
+    BasicAuthCache::Stamp stamp;
+
+    EXPECT_EQ(cache.find("cm9vdDowcGVuQm1j", stamp), nullptr);
+    cache.insert("cm9vdDowcGVuQm1j", makeSession("root"), stamp);
+    EXPECT_NE(cache.find("cm9vdDowcGVuQm1j", stamp), nullptr);
+
+    writeFile(file, "root:y:12:\n");
+    EXPECT_EQ(cache.find("cm9vdDowcGVuQm1j", stamp), nullptr);
+
+    cache.insert("cm9vdDowcGVuQm1j", makeSession("root"), stamp);
+    std::remove(file.c_str());
+    EXPECT_EQ(cache.find("cm9vdDowcGVuQm1j", stamp), nullptr);
+}
+
+// Tests that credentials PAM accepted while the password file changed are
+// not remembered
+TEST(BasicAuthCache, DropsInsertAfterPasswordChange)
+{
+    const std::string file = passwordFile();
+    writeFile(file, "root:x:1:\n");
+    BasicAuthCache cache;
+    cache.setPasswordFile(file);
+    BasicAuthCache::Stamp stamp;
+
+    EXPECT_EQ(cache.find("cm9vdDowcGVuQm1j", stamp), nullptr);
+    // The password changes while PAM checks the old one
+    writeFile(file, "root:y:12:\n");
+    cache.insert("cm9vdDowcGVuQm1j", makeSession("root"), stamp);
+    BasicAuthCache::Stamp now;
+    EXPECT_EQ(cache.find("cm9vdDowcGVuQm1j", now), nullptr);
+    EXPECT_EQ(cache.size(), 0u);
+
+    cache.insert("cm9vdDowcGVuQm1j", makeSession("root"), now);
+    EXPECT_NE(cache.find("cm9vdDowcGVuQm1j", now), nullptr);
+    std::remove(file.c_str());
+}
+
+// Tests that the cache doesn't grow past its bound, dropping the entry
+// closest to expiring
+TEST(BasicAuthCache, Bounded)
+{
+    BasicAuthCache cache;
+    cache.setPasswordFile(passwordFile());
+    BasicAuthCache::Stamp stamp;
+    cache.setTtl(10s);
+    EXPECT_EQ(cache.find("0", stamp), nullptr);
+    cache.insert("0", makeSession("user"), stamp);
+    cache.setTtl(1min);
+    for (size_t i = 1; i < BasicAuthCache::maxEntries(); i++)
+    {
+        cache.insert(std::to_string(i), makeSession("user"), stamp);
+    }
+    EXPECT_EQ(cache.size(), BasicAuthCache::maxEntries());
+
+    cache.insert("newest", makeSession("user"), stamp);
+    EXPECT_EQ(cache.size(), BasicAuthCache::maxEntries());
+    EXPECT_EQ(cache.find("0", stamp), nullptr);
+    EXPECT_NE(cache.find("1", stamp), nullptr);
+    EXPECT_NE(cache.find("newest", stamp), nullptr);
+}
+
+// Tests that a user changing drops the entries of that user only
+TEST(BasicAuthCache, DropsEntriesOfChangedUser)
+{
+    BasicAuthCache cache;
+    cache.setPasswordFile(passwordFile());
+    BasicAuthCache::Stamp stamp;
+    EXPECT_EQ(cache.find("cm9vdDowcGVuQm1j", stamp), nullptr);
+    cache.insert("cm9vdDowcGVuQm1j", makeSession("root"), stamp);
+    cache.insert("dXNlcjpwYXNz", makeSession("user"), stamp);
+
+    cache.dropUser("root");
+    EXPECT_EQ(cache.find("cm9vdDowcGVuQm1j", stamp), nullptr);
+    EXPECT_NE(cache.find("dXNlcjpwYXNz", stamp), nullptr);
+
+    cache.dropUser("");
+    EXPECT_EQ(cache.size(), 0u);
+}
@@ -0,0 +1,82 @@
+#include <crow/buffer_budget.h>
+
+#include <boost/beast/core/flat_buffer.hpp>
+
+#include <gtest/gtest.h>
+
+using crow::BufferBudget;
+using crow::BufferShare;
+
+// Tests that shares add up in their budget, and are given back with them
+TEST(BufferBudget, SharesAddUp)
+{
+    BufferBudget budget(1000);
+    {
+        BufferShare a(budget);
+        BufferShare b(budget);
+        a.update(600);
+        b.update(300);
+        EXPECT_EQ(budget.used(), 900u);
+        EXPECT_FALSE(budget.exhausted());
+
+        b.update(500);
+        EXPECT_EQ(budget.used(), 1100u);
+        EXPECT_TRUE(budget.exhausted());
+
+        a.update(100);
+        EXPECT_EQ(budget.used(), 600u);
+        EXPECT_FALSE(budget.exhausted());
+    }
+    EXPECT_EQ(budget.used(), 0u);
+}
+
+namespace
+{
+void fill(boost::beast::flat_buffer& buffer, size_t bytes)
+{
+    buffer.commit(boost::asio::buffer_size(buffer.prepare(bytes)));
+}
+} // namespace
+
+// Tests that an idle buffer is freed once it grew big, and kept otherwise
+TEST(BufferBudget, ReleasesBigIdleBuffers)
+{
+    BufferBudget budget(1024 * 1024);
+    BufferShare share(budget);
+    boost::beast::flat_buffer buffer(8192);
+
+    fill(buffer, 512);
+    buffer.consume(buffer.size());
+    crow::releaseIdleBuffer(buffer, share);
+    EXPECT_GE(buffer.capacity(), 512u);
+    EXPECT_EQ(share.held(), buffer.capacity());
+    EXPECT_EQ(budget.used(), buffer.capacity());
+
+    fill(buffer, 6000);
+    crow::releaseIdleBuffer(buffer, share);
+    // Unread bytes are kept
+    EXPECT_EQ(buffer.size(), 6000u);
+    EXPECT_EQ(budget.used(), buffer.capacity());
+
+    buffer.consume(buffer.size());
+    crow::releaseIdleBuffer(buffer, share);
+    EXPECT_EQ(buffer.capacity(), 0u);
+    EXPECT_EQ(buffer.max_size(), 8192u);
+    EXPECT_EQ(budget.used(), 0u);
+}
+
+// Tests that past the budget, even small idle buffers are freed
+TEST(BufferBudget, ReleasesEverythingOverBudget)
+{
+    BufferBudget budget(100);
+    BufferShare share(budget);
+    boost::beast::flat_buffer buffer(8192);
+
+    fill(buffer, 512);
+    share.update(buffer.capacity());
+    EXPECT_TRUE(budget.exhausted());
+    buffer.consume(buffer.size());
+    crow::releaseIdleBuffer(buffer, share);
+    EXPECT_EQ(buffer.capacity(), 0u);
+    EXPECT_EQ(budget.used(), 0u);
+}
@@ -0,0 +1,81 @@
+#include <compression_middleware.hpp>
+#include <crow/http_request.h>
+#include <crow/http_response.h>
+#include <gzip_helper.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using namespace crow;
+using namespace crow::compression;
+
+TEST(Compression, SelectEncoding)
+{
+    EXPECT_EQ(Encoding::none, selectEncoding(""));
+    EXPECT_EQ(Encoding::none, selectEncoding("identity"));
+    EXPECT_EQ(Encoding::gzip, selectEncoding("gzip, deflate, br"));
+    EXPECT_EQ(Encoding::deflate, selectEncoding("deflate"));
+    EXPECT_EQ(Encoding::deflate, selectEncoding("gzip;q=0.5, deflate"));
+    EXPECT_EQ(Encoding::none, selectEncoding("gzip;q=0"));
+    EXPECT_EQ(Encoding::gzip, selectEncoding("*"));
+    EXPECT_EQ(Encoding::deflate, selectEncoding("gzip;q=0, *"));
+}
+
+TEST(Compression, DeflateRoundTrip)
+{
+    std::string input;
+    for (int i = 0; i < 1000; i++)
+    {
+        input += "{\"Name\": \"Sensor " + std::to_string(i) + "\"}\n";
+    }
+    std::string compressed;
+    ASSERT_TRUE(gzipDeflate(input, compressed));
+    EXPECT_LT(compressed.size(), input.size() / 5);
+    std::string output;
+    ASSERT_TRUE(gzipInflate(compressed, output));
+    EXPECT_EQ(input, output);
+}
+
+TEST(Compression, CompressesLargeJson)
+{
+    boost::beast::http::request<boost::beast::http::string_body> r;
+    r.set("Accept-Encoding", "gzip");
+    Request req{r};
+    Response res;
+    for (int i = 0; i < 200; i++)
+    {
+        res.jsonValue["Members"].push_back({{"@odata.id", "/redfish/v1/x"}});
+    }
+
+    Middleware compression;
+    Middleware::Context ctx;
+    compression.afterHandle(req, res, ctx);
+
+    EXPECT_EQ("gzip", res.getHeaderValue("Content-Encoding"));
+    EXPECT_EQ("Accept-Encoding", res.getHeaderValue("Vary"));
+    EXPECT_EQ("application/json", res.getHeaderValue("Content-Type"));
+    std::string body;
+    ASSERT_TRUE(gzipInflate(res.body(), body));
+    EXPECT_EQ(res.jsonValue.dump(2), body);
+}
+
+TEST(Compression, LeavesSmallAndEncodedBodiesAlone)
+{
+    boost::beast::http::request<boost::beast::http::string_body> r;
+    r.set("Accept-Encoding", "gzip");
+    Request req{r};
+    Middleware compression;
+    Middleware::Context ctx;
+
+    Response small;
+    small.body() = "hello";
+    compression.afterHandle(req, small, ctx);
+    EXPECT_EQ("hello", small.body());
+    EXPECT_EQ("", small.getHeaderValue("Content-Encoding"));
+
+    Response encoded;
+    encoded.body() = std::string(4096, 'a');
+    encoded.addHeader("Content-Encoding", "gzip");
+    compression.afterHandle(req, encoded, ctx);
+    EXPECT_EQ(std::string(4096, 'a'), encoded.body());
+}
@@ -0,0 +1,47 @@
+#include <console_scrollback.hpp>
+
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using crow::obmc_console::Scrollback;
+using crow::obmc_console::scrollbackSize;
+
+TEST(Scrollback, ReadsFromCursor)
+{
+    Scrollback scrollback;
+    EXPECT_EQ(scrollback.read(0), "");
+    scrollback.append("login: ", 7);
+    uint64_t cursor = scrollback.end();
+    scrollback.append("root", 4);
+
+    EXPECT_EQ(scrollback.read(0), "login: root");
+    EXPECT_EQ(scrollback.read(cursor), "root");
+    EXPECT_EQ(scrollback.read(scrollback.end()), "");
+}
+
+TEST(Scrollback, KeepsOnlyTheNewestBytes)
+{
+    Scrollback scrollback;
+    std::string old(scrollbackSize - 3, 'a');
+    scrollback.append(old.data(), old.size());
+    // Wraps around the end of the ring
+    scrollback.append("bcdefg", 6);
+
+    EXPECT_EQ(scrollback.begin(), 3u);
+    EXPECT_EQ(scrollback.end(), scrollbackSize + 3);
+    std::string held = scrollback.read(0);
+    ASSERT_EQ(held.size(), scrollbackSize);
+    EXPECT_EQ(held.substr(held.size() - 7), "abcdefg");
+    EXPECT_EQ(scrollback.read(scrollback.end() - 2), "fg");
+
+    // More than the ring holds at once
+    std::string flood(scrollbackSize + 10, 'z');
+    flood.back() = '!';
+    scrollback.append(flood.data(), flood.size());
+    held = scrollback.read(0);
+    ASSERT_EQ(held.size(), scrollbackSize);
+    EXPECT_EQ(held.back(), '!');
+    EXPECT_EQ(held.front(), 'z');
+}
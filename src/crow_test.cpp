@@ -690,6 +690,78 @@ TEST(Crow, middlewareContext)
     server.stop();
 }
 
+struct DeferringMW
+{
+    struct Context
+    {
+    };
+    template <typename AllContext>
+    void beforeHandle(Request& req, Response& res, Context&,
+                      AllContext& all_ctx)
+    {
+        all_ctx.template get<FirstMW>().v.push_back("2 before");
+        res.defer();
+    }
+
+    template <typename AllContext>
+    void afterHandle(Request&, Response&, Context&, AllContext& all_ctx)
+    {
+        all_ctx.template get<FirstMW>().v.push_back("2 after");
+    }
+};
+
+TEST(Crow, middlewareDeferred)
+{
+    using Chain = std::tuple<FirstMW, DeferringMW, ThirdMW>;
+    using ChainContext = crow::detail::Context<FirstMW, DeferringMW, ThirdMW>;
+    Chain middlewares;
+    int done = 0;
+    std::function<void()> onDone = [&done] { done++; };
+
+    {
+        boost::beast::http::request<boost::beast::http::string_body> r{};
+        Request req{r};
+        Response res;
+        ChainContext ctx;
+        crow::detail::MiddlewareResult result =
+            crow::detail::middlewareCallHelper<0, ChainContext, Chain,
+                                               FirstMW, DeferringMW, ThirdMW>(
+                middlewares, req, res, ctx, onDone);
+        EXPECT_EQ(crow::detail::MiddlewareResult::deferred, result);
+        EXPECT_EQ(2u, ctx.get<FirstMW>().v.size());
+        EXPECT_EQ(0, done);
+
+        // The rest of the chain runs once the middleware resumes
+        res.resume();
+        ASSERT_EQUAL(3, ctx.get<FirstMW>().v.size());
+        ASSERT_EQUAL("3 before", ctx.get<FirstMW>().v[2]);
+        EXPECT_EQ(1, done);
+        EXPECT_FALSE(res.isCompleted());
+    }
+
+    done = 0;
+    {
+        boost::beast::http::request<boost::beast::http::string_body> r{};
+        Request req{r};
+        Response res;
+        ChainContext ctx;
+        crow::detail::middlewareCallHelper<0, ChainContext, Chain, FirstMW,
+                                           DeferringMW, ThirdMW>(
+            middlewares, req, res, ctx, onDone);
+        // Answering the request skips the rest of the chain, and runs the
+        // after handlers of the middlewares that ran
+        res.end();
+        res.resume();
+        EXPECT_EQ(1, done);
+        auto& out = test_middleware_context_vector;
+        ASSERT_EQUAL(4, out.size());
+        ASSERT_EQUAL("1 before", out[0]);
+        ASSERT_EQUAL("2 before", out[1]);
+        ASSERT_EQUAL("2 after", out[2]);
+        ASSERT_EQUAL("1 after", out[3]);
+    }
+}
+
 TEST(Crow, bug_quick_repeated_request)
 {
     static char buf[2048];
@@ -772,8 +844,8 @@ TEST(Crow, simple_url_params)
         c.receive(asio::buffer(buf, 2048));
         c.close();
 
-        ASSERT_TRUE(lastUrlParams.get("missing") == nullptr);
-        ASSERT_TRUE(lastUrlParams.get("foobar") != nullptr);
+        ASSERT_TRUE(lastUrlParams.get("missing") == boost::none);
+        ASSERT_TRUE(lastUrlParams.get("foobar") != boost::none);
         ASSERT_TRUE(lastUrlParams.getList("missing").empty());
     }
     // check multiple presence
@@ -786,10 +858,10 @@ TEST(Crow, simple_url_params)
         c.receive(asio::buffer(buf, 2048));
         c.close();
 
-        ASSERT_TRUE(lastUrlParams.get("missing") == nullptr);
-        ASSERT_TRUE(lastUrlParams.get("foo") != nullptr);
-        ASSERT_TRUE(lastUrlParams.get("bar") != nullptr);
-        ASSERT_TRUE(lastUrlParams.get("baz") != nullptr);
+        ASSERT_TRUE(lastUrlParams.get("missing") == boost::none);
+        ASSERT_TRUE(lastUrlParams.get("foo") != boost::none);
+        ASSERT_TRUE(lastUrlParams.get("bar") != boost::none);
+        ASSERT_TRUE(lastUrlParams.get("baz") != boost::none);
     }
     // check single value
     sendmsg = "GET /params?hello=world\r\n\r\n";
@@ -801,7 +873,7 @@ TEST(Crow, simple_url_params)
         c.receive(asio::buffer(buf, 2048));
         c.close();
 
-        ASSERT_EQUAL(string(lastUrlParams.get("hello")), "world");
+        ASSERT_EQUAL(*lastUrlParams.get("hello"), "world");
     }
     // check multiple value
     sendmsg = "GET /params?hello=world&left=right&up=down\r\n\r\n";
@@ -813,9 +885,9 @@ TEST(Crow, simple_url_params)
         c.receive(asio::buffer(buf, 2048));
         c.close();
 
-        ASSERT_EQUAL(string(lastUrlParams.get("hello")), "world");
-        ASSERT_EQUAL(string(lastUrlParams.get("left")), "right");
-        ASSERT_EQUAL(string(lastUrlParams.get("up")), "down");
+        ASSERT_EQUAL(*lastUrlParams.get("hello"), "world");
+        ASSERT_EQUAL(*lastUrlParams.get("left"), "right");
+        ASSERT_EQUAL(*lastUrlParams.get("up"), "down");
     }
     // check multiple value, multiple types
     sendmsg = "GET /params?int=100&double=123.45&boolean=1\r\n\r\n";
@@ -827,11 +899,13 @@ TEST(Crow, simple_url_params)
         c.receive(asio::buffer(buf, 2048));
         c.close();
 
-        ASSERT_EQUAL(boost::lexical_cast<int>(lastUrlParams.get("int")), 100);
-        ASSERT_EQUAL(boost::lexical_cast<double>(lastUrlParams.get("double")),
-                     123.45);
-        ASSERT_EQUAL(boost::lexical_cast<bool>(lastUrlParams.get("boolean")),
-                     true);
+        ASSERT_EQUAL(boost::lexical_cast<int>(*lastUrlParams.get("int")),
+                     100);
+        ASSERT_EQUAL(
+            boost::lexical_cast<double>(*lastUrlParams.get("double")),
+            123.45);
+        ASSERT_EQUAL(
+            boost::lexical_cast<bool>(*lastUrlParams.get("boolean")), true);
     }
     // check single array value
     sendmsg = "GET /params?tmnt[]=leonardo\r\n\r\n";
@@ -844,9 +918,9 @@ TEST(Crow, simple_url_params)
         c.receive(asio::buffer(buf, 2048));
         c.close();
 
-        ASSERT_TRUE(lastUrlParams.get("tmnt") == nullptr);
+        ASSERT_TRUE(lastUrlParams.get("tmnt") == boost::none);
         ASSERT_EQUAL(lastUrlParams.getList("tmnt").size(), 1);
-        ASSERT_EQUAL(string(lastUrlParams.getList("tmnt")[0]), "leonardo");
+        ASSERT_EQUAL(lastUrlParams.getList("tmnt")[0], "leonardo");
     }
     // check multiple array value
     sendmsg =
@@ -861,9 +935,9 @@ TEST(Crow, simple_url_params)
         c.close();
 
         ASSERT_EQUAL(lastUrlParams.getList("tmnt").size(), 3);
-        ASSERT_EQUAL(string(lastUrlParams.getList("tmnt")[0]), "leonardo");
-        ASSERT_EQUAL(string(lastUrlParams.getList("tmnt")[1]), "donatello");
-        ASSERT_EQUAL(string(lastUrlParams.getList("tmnt")[2]), "raphael");
+        ASSERT_EQUAL(lastUrlParams.getList("tmnt")[0], "leonardo");
+        ASSERT_EQUAL(lastUrlParams.getList("tmnt")[1], "donatello");
+        ASSERT_EQUAL(lastUrlParams.getList("tmnt")[2], "raphael");
     }
     server.stop();
 }
@@ -943,3 +1017,255 @@ TEST(Crow, routeDynamic)
         ASSERT_EQUAL(x, 4);
     }
 }
+
+TEST(Crow, connection_pool)
+{
+    struct Dummy
+    {
+        explicit Dummy(int v) : value(v)
+        {
+        }
+        int value;
+    };
+    crow::detail::ConnectionPool<Dummy> pool(1);
+
+    Dummy* a = pool.acquire(1);
+    Dummy* b = pool.acquire(2);
+    EXPECT_EQ(1, a->value);
+    EXPECT_EQ(2, b->value);
+
+    pool.release(a);
+    // over the idle bound, so this one is freed
+    pool.release(b);
+
+    crow::detail::ConnectionPoolStats stats = pool.getStats();
+    EXPECT_EQ(2u, stats.created);
+    EXPECT_EQ(1u, stats.recycled);
+    EXPECT_EQ(1u, stats.discarded);
+    EXPECT_EQ(1u, stats.idle);
+
+    Dummy* c = pool.acquire(3);
+    EXPECT_EQ(a, c);
+    EXPECT_EQ(1u, pool.getStats().reused);
+    EXPECT_EQ(0u, pool.getStats().idle);
+    delete c;
+}
+
+TEST(Crow, date_header)
+{
+    crow::detail::DateHeader date;
+    // the epoch plus one day
+    date.update(86400);
+    boost::string_view first = date.get();
+    EXPECT_EQ("Fri, 02 Jan 1970 00:00:00 GMT", first);
+
+    date.update(86401);
+    EXPECT_EQ("Fri, 02 Jan 1970 00:00:01 GMT", date.get());
+    // the previous value is left intact for readers that still hold it
+    EXPECT_EQ("Fri, 02 Jan 1970 00:00:00 GMT", first);
+}
+
+TEST(Crow, streamBodyToFile)
+{
+    SimpleApp app;
+    BMCWEB_ROUTE(app, "/upload")
+        .streamBodyToFile("/tmp")
+        .methods("POST"_method)([] { return ""; });
+    BMCWEB_ROUTE(app, "/other").methods("POST"_method)([] { return ""; });
+    app.validate();
+
+    boost::beast::http::request<boost::beast::http::string_body> r{};
+    r.method(boost::beast::http::verb::post);
+    Request req{r};
+
+    req.url = "/upload";
+    const std::string* directory = app.findBodyFileDirectory(req);
+    ASSERT_NE(nullptr, directory);
+    EXPECT_EQ("/tmp", *directory);
+
+    req.url = "/other";
+    EXPECT_EQ(nullptr, app.findBodyFileDirectory(req));
+
+    // only for the methods of the rule
+    r.method(boost::beast::http::verb::get);
+    req.url = "/upload";
+    EXPECT_EQ(nullptr, app.findBodyFileDirectory(req));
+}
+
+TEST(Crow, trieFind)
+{
+    crow::Trie trie;
+    trie.add("/redfish/v1/Systems/system", 1);
+    trie.add("/redfish/v1/Systems/<str>", 2);
+    trie.add("/redfish/v1/Managers/bmc", 3);
+    trie.add("/redfish/v1/Chassis/<str>/Power", 4);
+    trie.add("/item/<int>", 5);
+    trie.add("/item/<double>", 6);
+    trie.add("/files/<path>", 7);
+    trie.validate();
+
+    EXPECT_EQ(1U, trie.find("/redfish/v1/Systems/system").first);
+    EXPECT_EQ(2U, trie.find("/redfish/v1/Systems/other").first);
+    EXPECT_EQ(3U, trie.find("/redfish/v1/Managers/bmc").first);
+    EXPECT_EQ(0U, trie.find("/redfish/v1/Managers/bm").first);
+    EXPECT_EQ(0U, trie.find("/redfish/v1/Managers/bmcx").first);
+    EXPECT_EQ(0U, trie.find("/redfish/v1").first);
+
+    auto found = trie.find("/redfish/v1/Chassis/chassis0/Power");
+    EXPECT_EQ(4U, found.first);
+    EXPECT_EQ("chassis0", found.second.get<std::string>(0));
+
+    // the lowest rule index wins when several rules match
+    found = trie.find("/item/42");
+    EXPECT_EQ(5U, found.first);
+    EXPECT_EQ(42, found.second.get<int64_t>(0));
+    found = trie.find("/item/4.5");
+    EXPECT_EQ(6U, found.first);
+    EXPECT_EQ(4.5, found.second.get<double>(0));
+
+    found = trie.find("/files/a/b/c");
+    EXPECT_EQ(7U, found.first);
+    EXPECT_EQ("a/b/c", found.second.get<std::string>(0));
+
+    // numbers are only parsed up to the end of the url view
+    boost::string_view url("/item/123456", 8);
+    found = trie.find(url);
+    EXPECT_EQ(5U, found.first);
+    EXPECT_EQ(12, found.second.get<int64_t>(0));
+
+    // routes added after validate() are picked up by the next lookup
+    trie.add("/late", 8);
+    EXPECT_EQ(8U, trie.find("/late").first);
+}
+
+TEST(Crow, jsonChunkWriter)
+{
+    nlohmann::json value = {
+        {"@odata.id", "/redfish/v1/Systems"},
+        {"Members", nlohmann::json::array()},
+        {"Empty", nlohmann::json::object()},
+        {"Nested", {{"a", {1, 2.5, "three", nullptr}}, {"b", true}}},
+        {"Escaped", "quote \" and \\ and \n"},
+    };
+    for (int i = 0; i < 100; i++)
+    {
+        value["Members"].push_back({{"@odata.id", "/redfish/v1/x"}});
+    }
+    std::string expected = value.dump(2);
+
+    for (size_t chunkSize : {1, 7, 100, 1024 * 1024})
+    {
+        crow::detail::JsonChunkWriter writer{nlohmann::json(value)};
+        std::string out;
+        size_t chunks = 1;
+        std::string chunk;
+        while (writer.write(chunk, chunkSize))
+        {
+            EXPECT_GE(chunk.size(), chunkSize);
+            out += chunk;
+            chunk.clear();
+            chunks++;
+        }
+        out += chunk;
+        EXPECT_EQ(expected, out);
+        EXPECT_EQ(chunkSize > expected.size(), chunks == 1);
+    }
+
+    for (const nlohmann::json& leaf :
+         {nlohmann::json(5), nlohmann::json("text"), nlohmann::json::array()})
+    {
+        crow::detail::JsonChunkWriter writer{nlohmann::json(leaf)};
+        std::string out;
+        EXPECT_FALSE(writer.write(out, 16));
+        EXPECT_EQ(leaf.dump(2), out);
+    }
+}
+
+TEST(Crow, prettyPrintJson)
+{
+    nlohmann::json value = {
+        {"@odata.id", "/redfish/v1/Systems"},
+        {"Name", "<a & 'b'>"},
+        {"Members", {{{"@odata.id", "/redfish/v1/Systems/system"}}}},
+        {"Empty", nlohmann::json::object()},
+    };
+    std::string out;
+    crow::detail::appendJsonHtml(out, value);
+    EXPECT_EQ("{\n"
+              "    &quot;@odata.id&quot;: <a href=\"/redfish/v1/Systems\">"
+              "&quot;/redfish/v1/Systems&quot;</a>,\n"
+              "    &quot;Empty&quot;: {},\n"
+              "    &quot;Members&quot;: [\n"
+              "        {\n"
+              "            &quot;@odata.id&quot;: "
+              "<a href=\"/redfish/v1/Systems/system\">"
+              "&quot;/redfish/v1/Systems/system&quot;</a>\n"
+              "        }\n"
+              "    ],\n"
+              "    &quot;Name&quot;: "
+              "&quot;&lt;a &amp; &apos;b&apos;&gt;&quot;\n"
+              "}",
+              out);
+
+    Response res;
+    res.jsonValue = value;
+    prettyPrintJson(res);
+    EXPECT_NE(std::string::npos, res.body().find("<code class=\"json\">" + out +
+                                                 "</code>"));
+}
+
+TEST(Crow, queryStringParse)
+{
+    QueryString query("/redfish/v1/Systems/?$select=Name,Id&$expand=.");
+    ASSERT_TRUE(query.get("$select"));
+    EXPECT_EQ("Name,Id", *query.get("$select"));
+    ASSERT_TRUE(query.get("$expand"));
+    EXPECT_EQ(".", *query.get("$expand"));
+    EXPECT_FALSE(query.get("missing"));
+
+    // Copies and moves keep their own copy of the query
+    QueryString copy(query);
+    QueryString moved;
+    moved = std::move(query);
+    EXPECT_EQ("Name,Id", *copy.get("$select"));
+    EXPECT_EQ("Name,Id", *moved.get("$select"));
+}
+
+TEST(Crow, queryStringValues)
+{
+    // Values run to the next '&', '=' and all, and are decoded when asked
+    // for
+    QueryString query("/redfish/v1/Systems/1/LogServices/SEL/Entries?"
+                      "$filter=Severity%20eq%20%27Critical%27+and+a=b"
+                      "&%24top=5&flag&empty=#fragment=1");
+    EXPECT_EQ("Severity eq 'Critical' and a=b", *query.get("$filter"));
+    EXPECT_EQ("5", *query.get("$top"));
+    EXPECT_EQ("", *query.get("flag"));
+    EXPECT_EQ("", *query.get("empty"));
+    EXPECT_FALSE(query.get("fragment"));
+
+    std::vector<std::string> keys;
+    for (const QueryParameter& parameter : query)
+    {
+        keys.push_back(std::string(parameter.key));
+    }
+    EXPECT_EQ((std::vector<std::string>{"$filter", "%24top", "flag", "empty"}),
+              keys);
+
+    // A bad escape ends the value
+    EXPECT_EQ("ab", *QueryString("/?v=ab%zzcd").get("v"));
+    EXPECT_EQ("ab", *QueryString("/?v=ab%2").get("v"));
+    EXPECT_TRUE(QueryString("/redfish/v1").empty());
+}
+
+TEST(Crow, queryStringManyParameters)
+{
+    std::string target = "/?";
+    for (int i = 0; i < 1000; i++)
+    {
+        target += "p" + std::to_string(i) + "=" + std::to_string(i) + "&";
+    }
+    QueryString query(target);
+    EXPECT_EQ("999", *query.get("p999"));
+    EXPECT_EQ(1001, std::distance(query.begin(), query.end()));
+}
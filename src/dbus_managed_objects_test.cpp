@@ -0,0 +1,99 @@
+#include <dbus_managed_objects.hpp>
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+using namespace crow::connections;
+
+namespace
+{
+
+// Stands in for a variant; only moved and compared
+using Value = std::string;
+
+ManagedObjects<Value> makeObjects()
+{
+    NameTable& names = nameTable();
+    ManagedObjects<Value> objects;
+    objects.addObject("/xyz/openbmc_project/logging/entry/1");
+    objects.addInterface(names.intern("xyz.openbmc_project.Logging.Entry"));
+    objects.addProperty(names.intern("Id"), "1");
+    objects.addProperty(names.intern("Severity"), "Error");
+    objects.addInterface(names.intern("xyz.openbmc_project.Object.Delete"));
+    objects.addObject("/xyz/openbmc_project/logging/entry/2");
+    objects.addInterface(names.intern("xyz.openbmc_project.Logging.Entry"));
+    objects.addProperty(names.intern("Id"), "2");
+    return objects;
+}
+
+} // namespace
+
+TEST(ManagedObjects, IteratesInReadingOrder)
+{
+    ManagedObjects<Value> objects = makeObjects();
+    ASSERT_EQ(objects.objects().size(), 2u);
+    const auto& first = *objects.objects().begin();
+    EXPECT_EQ(first.path, "/xyz/openbmc_project/logging/entry/1");
+    ASSERT_EQ(objects.interfaces(first).size(), 2u);
+
+    const auto& entry = *objects.interfaces(first).begin();
+    EXPECT_EQ(*entry.name, "xyz.openbmc_project.Logging.Entry");
+    std::string names;
+    for (const auto& property : objects.properties(entry))
+    {
+        names += *property.name + "=" + property.value + " ";
+    }
+    EXPECT_EQ(names, "Id=1 Severity=Error ");
+    EXPECT_TRUE(
+        objects.properties(*(objects.interfaces(first).begin() + 1)).empty());
+
+    const auto& second = *(objects.objects().begin() + 1);
+    EXPECT_EQ(objects.interfaces(second).size(), 1u);
+    EXPECT_EQ(objects.propertyCount(), 3u);
+}
+
+TEST(ManagedObjects, InternsNames)
+{
+    ManagedObjects<Value> objects = makeObjects();
+    const auto& first = *objects.objects().begin();
+    const auto& second = *(objects.objects().begin() + 1);
+    // One string for every object's copy of a name
+    EXPECT_EQ(objects.interfaces(first).begin()->name,
+              objects.interfaces(second).begin()->name);
+    EXPECT_EQ(nameTable().intern(std::string("Id")),
+              nameTable().intern("Id"));
+}
+
+TEST(ManagedObjects, FindsByName)
+{
+    ManagedObjects<Value> objects = makeObjects();
+    const auto* object =
+        objects.findObject("/xyz/openbmc_project/logging/entry/2");
+    ASSERT_NE(object, nullptr);
+    const auto* entry =
+        objects.find(*object, "xyz.openbmc_project.Logging.Entry");
+    ASSERT_NE(entry, nullptr);
+    const Value* id = objects.find(*entry, "Id");
+    ASSERT_NE(id, nullptr);
+    EXPECT_EQ(*id, "2");
+
+    EXPECT_EQ(objects.find(*entry, "Severity"), nullptr);
+    EXPECT_EQ(objects.find(*entry, "NeverReadAnywhere"), nullptr);
+    EXPECT_EQ(objects.find(*object, "xyz.openbmc_project.Object.Delete"),
+              nullptr);
+    EXPECT_EQ(objects.findObject("/xyz/openbmc_project/logging/entry/3"),
+              nullptr);
+}
+
+// As a GetAll reply is read: one interface of no object
+TEST(ManagedObjects, HoldsPropertiesOfNoObject)
+{
+    ManagedObjects<Value> properties;
+    EXPECT_TRUE(properties.properties().empty());
+    properties.addInterface(nullptr);
+    properties.addProperty(nameTable().intern("Message"), "hello");
+    EXPECT_EQ(properties.objects().size(), 0u);
+    ASSERT_EQ(properties.properties().size(), 1u);
+    EXPECT_EQ(properties.properties().begin()->value, "hello");
+}
@@ -0,0 +1,131 @@
+#include <dbus_monitor_compact.hpp>
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+using namespace crow::dbus_monitor;
+
+namespace
+{
+
+const std::string cpu0 = "/xyz/openbmc_project/sensors/temperature/cpu0";
+const std::string sensorValue = "xyz.openbmc_project.Sensor.Value";
+
+} // namespace
+
+TEST(DbusMonitorCompact, InternsPathsAndSendsChanges)
+{
+    CompactEncoder encoder(Format::compact);
+    std::string message;
+    std::string key;
+
+    ASSERT_TRUE(encoder.encodeProperties(
+        cpu0, sensorValue, {{"Value", 41.5}, {"MaxValue", 127}}, message,
+        key));
+    EXPECT_EQ(nlohmann::json::parse(message),
+              nlohmann::json({{"id", 1},
+                              {"path", cpu0},
+                              {"interface", sensorValue},
+                              {"properties",
+                               {{"Value", 41.5}, {"MaxValue", 127}}}}));
+    // Carries the only definition of id 1
+    EXPECT_EQ(key, "");
+
+    ASSERT_TRUE(encoder.encodeProperties(
+        cpu0, sensorValue, {{"Value", 42.0}, {"MaxValue", 127}}, message,
+        key));
+    EXPECT_EQ(nlohmann::json::parse(message),
+              nlohmann::json({{"id", 1}, {"properties", {{"Value", 42.0}}}}));
+    EXPECT_EQ(key, "1 Value");
+
+    // Nothing changed
+    EXPECT_FALSE(encoder.encodeProperties(cpu0, sensorValue,
+                                          {{"Value", 42.0}}, message, key));
+
+    ASSERT_TRUE(encoder.encodeProperties(cpu0 + "1", sensorValue,
+                                         {{"Value", 42.0}}, message, key));
+    EXPECT_EQ(nlohmann::json::parse(message)["id"], 2);
+    EXPECT_EQ(encoder.size(), 2u);
+}
+
+TEST(DbusMonitorCompact, IsSmallerThanJson)
+{
+    CompactEncoder encoder(Format::compact);
+    std::string message;
+    std::string key;
+    encoder.encodeProperties(cpu0, sensorValue, {{"Value", 41.5}}, message,
+                             key);
+    encoder.encodeProperties(cpu0, sensorValue, {{"Value", 42.5}}, message,
+                             key);
+    std::string json = nlohmann::json({{"event", "PropertiesChanged"},
+                                       {"path", cpu0},
+                                       {"interface", sensorValue},
+                                       {"properties", {{"Value", 42.5}}}})
+                           .dump();
+    EXPECT_LT(message.size() * 3, json.size());
+}
+
+TEST(DbusMonitorCompact, ResetsToFullMessages)
+{
+    CompactEncoder encoder(Format::compact);
+    std::string message;
+    std::string key;
+    encoder.encodeProperties(cpu0, sensorValue, {{"Value", 41.5}}, message,
+                             key);
+    encoder.reset();
+    EXPECT_EQ(encoder.size(), 0u);
+    ASSERT_TRUE(encoder.encodeProperties(cpu0, sensorValue, {{"Value", 41.5}},
+                                         message, key));
+    nlohmann::json parsed = nlohmann::json::parse(message);
+    EXPECT_EQ(parsed["id"], 1);
+    EXPECT_EQ(parsed["path"], cpu0);
+    EXPECT_EQ(parsed["properties"]["Value"], 41.5);
+}
+
+// Values the client got from InterfacesAdded aren't sent again
+TEST(DbusMonitorCompact, ComparesWithValuesSetElsewhere)
+{
+    CompactEncoder encoder(Format::compact);
+    encoder.setValues(cpu0, sensorValue, {{"Value", 41.5}, {"Unit", "C"}});
+    std::string message;
+    std::string key;
+    ASSERT_TRUE(encoder.encodeProperties(
+        cpu0, sensorValue, {{"Value", 43.0}, {"Unit", "C"}}, message, key));
+    nlohmann::json parsed = nlohmann::json::parse(message);
+    EXPECT_EQ(parsed["properties"], nlohmann::json({{"Value", 43.0}}));
+    // Not yet told the path
+    EXPECT_EQ(parsed["path"], cpu0);
+}
+
+TEST(DbusMonitorCompact, EncodesBinaryFormats)
+{
+    nlohmann::json expected = {{"id", 1},
+                               {"path", cpu0},
+                               {"interface", sensorValue},
+                               {"properties", {{"Value", 41.5}}}};
+    std::string message;
+    std::string key;
+
+    CompactEncoder cbor(Format::cbor);
+    EXPECT_TRUE(cbor.binary());
+    cbor.encodeProperties(cpu0, sensorValue, {{"Value", 41.5}}, message, key);
+    EXPECT_EQ(nlohmann::json::from_cbor(message), expected);
+
+    CompactEncoder msgpack(Format::msgpack);
+    msgpack.encodeProperties(cpu0, sensorValue, {{"Value", 41.5}}, message,
+                             key);
+    EXPECT_EQ(nlohmann::json::from_msgpack(message), expected);
+
+    EXPECT_FALSE(CompactEncoder(Format::compact).binary());
+}
+
+TEST(DbusMonitorCompact, ParsesFormats)
+{
+    Format format = Format::json;
+    EXPECT_TRUE(parseFormat("cbor", format));
+    EXPECT_EQ(format, Format::cbor);
+    EXPECT_TRUE(parseFormat("json", format));
+    EXPECT_EQ(format, Format::json);
+    EXPECT_FALSE(parseFormat("xml", format));
+}
@@ -0,0 +1,57 @@
+#include <dbus_signature.hpp>
+
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using crow::connections::CompiledSignature;
+using crow::connections::compileSignature;
+
+namespace
+{
+std::string codes(const CompiledSignature& signature)
+{
+    std::string ret;
+    for (const crow::connections::SignatureOp& op : signature.ops)
+    {
+        ret += op.code;
+    }
+    return ret;
+}
+} // namespace
+
+TEST(DbusSignature, CompilesNestedTypes)
+{
+    std::shared_ptr<const CompiledSignature> signature =
+        compileSignature("sa{sv}(iad)");
+    ASSERT_NE(signature, nullptr);
+    EXPECT_EQ(codes(*signature), "sa{sv(iad");
+    EXPECT_THAT(signature->types, testing::ElementsAre(0u, 1u, 5u));
+
+    // The array spans its dict entry, and the struct its members
+    EXPECT_EQ(signature->ops[1].end, 5u);
+    EXPECT_EQ(signature->ops[1].contents, "{sv}");
+    EXPECT_EQ(signature->ops[2].contents, "sv");
+    EXPECT_EQ(signature->ops[5].end, 9u);
+    EXPECT_EQ(signature->ops[5].contents, "iad");
+    EXPECT_EQ(signature->ops[7].contents, "d");
+}
+
+TEST(DbusSignature, RejectsInvalidSignatures)
+{
+    for (const char* bad : {"a", "(", "()", "(s", "s)", "{sv}", "a{vs}",
+                            "a{s}", "a{sss}", "z", "aa"})
+    {
+        EXPECT_EQ(compileSignature(bad), nullptr) << bad;
+    }
+    ASSERT_NE(compileSignature(""), nullptr);
+    EXPECT_TRUE(compileSignature("")->ops.empty());
+}
+
+TEST(DbusSignature, CachesSignatures)
+{
+    EXPECT_EQ(crow::connections::cachedSignature("a(ss)"),
+              crow::connections::cachedSignature("a(ss)"));
+}
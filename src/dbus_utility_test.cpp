@@ -0,0 +1,286 @@
+#include <dbus_utility.hpp>
+
+#include <boost/asio/io_service.hpp>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using crow::connections::MapperCache;
+using crow::connections::MethodCallCoalescer;
+using crow::connections::MethodCallStats;
+
+namespace
+{
+using Paths = std::vector<std::string>;
+
+// Stands in for sdbusplus::asio::connection, keeping every call until the
+// test answers it
+struct FakeBus
+{
+    template <typename Handler, typename... InputArgs>
+    void async_method_call(Handler&& handler, const std::string& service,
+                           const std::string& path,
+                           const std::string& interface,
+                           const std::string& method, const InputArgs&...)
+    {
+        methods.push_back(method);
+        replies.emplace_back(
+            [handler](const boost::system::error_code& ec,
+                      const Paths& paths) mutable { handler(ec, paths); });
+    }
+
+    void reply(size_t index, const Paths& paths)
+    {
+        // The handler may make another call, growing replies
+        auto handler = std::move(replies[index]);
+        handler(boost::system::error_code(), paths);
+    }
+
+    std::vector<std::string> methods;
+    std::vector<
+        std::function<void(const boost::system::error_code&, const Paths&)>>
+        replies;
+};
+} // namespace
+
+// Tests that identical calls in flight share one round trip and its reply
+TEST(MethodCallCoalescer, MergesIdenticalCalls)
+{
+    FakeBus bus;
+    MethodCallCoalescer coalescer;
+    std::vector<Paths> got;
+    auto handler = [&got](const boost::system::error_code ec,
+                          const Paths& paths) { got.push_back(paths); };
+
+    for (int i = 0; i < 3; i++)
+    {
+        coalescer.asyncMethodCall(
+            bus, handler, "xyz.openbmc_project.ObjectMapper",
+            "/xyz/openbmc_project/object_mapper",
+            "xyz.openbmc_project.ObjectMapper", "GetSubTreePaths",
+            "/xyz/openbmc_project/inventory", int32_t(0),
+            std::array<const char*, 1>{"xyz.openbmc_project.Inventory.Item"});
+    }
+    ASSERT_EQ(bus.methods.size(), 1u);
+    EXPECT_EQ(coalescer.inFlightCount(), 1u);
+
+    bus.reply(0, {"/xyz/openbmc_project/inventory/system"});
+    EXPECT_EQ(coalescer.inFlightCount(), 0u);
+    EXPECT_THAT(got, testing::ElementsAre(
+                         Paths{"/xyz/openbmc_project/inventory/system"},
+                         Paths{"/xyz/openbmc_project/inventory/system"},
+                         Paths{"/xyz/openbmc_project/inventory/system"}));
+
+    // Once answered, the same call goes to the bus again
+    coalescer.asyncMethodCall(
+        bus, handler, "xyz.openbmc_project.ObjectMapper",
+        "/xyz/openbmc_project/object_mapper",
+        "xyz.openbmc_project.ObjectMapper", "GetSubTreePaths",
+        "/xyz/openbmc_project/inventory", int32_t(0),
+        std::array<const char*, 1>{"xyz.openbmc_project.Inventory.Item"});
+    EXPECT_EQ(bus.methods.size(), 2u);
+}
+
+// Tests that calls differing in any part of the call aren't merged
+TEST(MethodCallCoalescer, KeepsDifferentCallsApart)
+{
+    FakeBus bus;
+    MethodCallCoalescer coalescer;
+    std::vector<std::string> got;
+    auto handler = [&got](const boost::system::error_code ec,
+                          const Paths& paths) { got.push_back(paths[0]); };
+
+    coalescer.asyncMethodCall(bus, handler, "service", "/path", "iface",
+                              "GetA", std::string("ab"), std::string("c"));
+    coalescer.asyncMethodCall(bus, handler, "service", "/path", "iface",
+                              "GetA", std::string("a"), std::string("bc"));
+    coalescer.asyncMethodCall(bus, handler, "service", "/path", "iface",
+                              "GetB", std::string("ab"), std::string("c"));
+    coalescer.asyncMethodCall(bus, handler, "service", "/path", "iface",
+                              "GetA", int32_t(1));
+    coalescer.asyncMethodCall(bus, handler, "service", "/path", "iface",
+                              "GetA", uint32_t(1));
+    EXPECT_EQ(bus.methods.size(), 5u);
+    EXPECT_EQ(coalescer.inFlightCount(), 5u);
+
+    for (size_t i = 0; i < bus.replies.size(); i++)
+    {
+        bus.reply(i, {std::to_string(i)});
+    }
+    EXPECT_THAT(got, testing::ElementsAre("0", "1", "2", "3", "4"));
+    EXPECT_EQ(coalescer.inFlightCount(), 0u);
+}
+
+// Tests that a handler repeating its call from the reply gets a new one
+TEST(MethodCallCoalescer, CallFromHandlerGoesOut)
+{
+    FakeBus bus;
+    MethodCallCoalescer coalescer;
+    int replies = 0;
+    std::function<void(const boost::system::error_code, const Paths&)>
+        handler = [&](const boost::system::error_code ec,
+                      const Paths& paths) {
+            if (replies++ == 0)
+            {
+                coalescer.asyncMethodCall(bus, handler, "service", "/path",
+                                          "iface", "Get");
+            }
+        };
+
+    coalescer.asyncMethodCall(bus, handler, "service", "/path", "iface",
+                              "Get");
+    bus.reply(0, {});
+    ASSERT_EQ(bus.methods.size(), 2u);
+    bus.reply(1, {});
+    EXPECT_EQ(replies, 2);
+    EXPECT_EQ(coalescer.inFlightCount(), 0u);
+}
+
+namespace
+{
+void getSubTreePaths(MapperCache& cache, FakeBus& bus,
+                     MethodCallCoalescer& coalescer,
+                     std::vector<Paths>& got)
+{
+    cache.asyncMethodCall(
+        bus, coalescer,
+        [&got](const boost::system::error_code ec, const Paths& paths) {
+            got.push_back(paths);
+        },
+        "xyz.openbmc_project.ObjectMapper",
+        "/xyz/openbmc_project/object_mapper",
+        "xyz.openbmc_project.ObjectMapper", "GetSubTreePaths",
+        "/xyz/openbmc_project/inventory", int32_t(0),
+        std::array<const char*, 1>{"xyz.openbmc_project.Inventory.Item"});
+}
+} // namespace
+
+// Tests that a repeated mapper query is answered without a bus call
+TEST(MapperCache, AnswersRepeatsFromMemory)
+{
+    boost::asio::io_service io;
+    FakeBus bus;
+    MethodCallCoalescer coalescer;
+    MapperCache cache;
+    cache.setIoService(&io);
+    std::vector<Paths> got;
+
+    getSubTreePaths(cache, bus, coalescer, got);
+    ASSERT_EQ(bus.methods.size(), 1u);
+    bus.reply(0, {"/xyz/openbmc_project/inventory/system"});
+    EXPECT_EQ(cache.size(), 1u);
+
+    getSubTreePaths(cache, bus, coalescer, got);
+    EXPECT_EQ(bus.methods.size(), 1u);
+    // Cached replies come asynchronously, like the bus ones
+    EXPECT_EQ(got.size(), 1u);
+    io.poll();
+    EXPECT_THAT(got, testing::ElementsAre(
+                         Paths{"/xyz/openbmc_project/inventory/system"},
+                         Paths{"/xyz/openbmc_project/inventory/system"}));
+    EXPECT_EQ(cache.hits(), 1u);
+    EXPECT_EQ(cache.misses(), 1u);
+}
+
+// Tests that invalidating drops what is cached, and what is being fetched
+TEST(MapperCache, InvalidateDropsEntries)
+{
+    boost::asio::io_service io;
+    FakeBus bus;
+    MethodCallCoalescer coalescer;
+    MapperCache cache;
+    cache.setIoService(&io);
+    std::vector<Paths> got;
+
+    getSubTreePaths(cache, bus, coalescer, got);
+    bus.reply(0, {"/a"});
+    cache.invalidate();
+    EXPECT_EQ(cache.size(), 0u);
+
+    getSubTreePaths(cache, bus, coalescer, got);
+    ASSERT_EQ(bus.methods.size(), 2u);
+    // The reply may predate the change, so it isn't kept
+    cache.invalidate();
+    bus.reply(1, {"/b"});
+    EXPECT_EQ(cache.size(), 0u);
+
+    getSubTreePaths(cache, bus, coalescer, got);
+    EXPECT_EQ(bus.methods.size(), 3u);
+    EXPECT_EQ(cache.misses(), 3u);
+    EXPECT_EQ(cache.invalidations(), 2u);
+}
+
+// Tests that only mapper queries are cached, and only once started
+TEST(MapperCache, PassesOtherCallsThrough)
+{
+    boost::asio::io_service io;
+    FakeBus bus;
+    MethodCallCoalescer coalescer;
+    MapperCache cache;
+    std::vector<Paths> got;
+    auto handler = [&got](const boost::system::error_code ec,
+                          const Paths& paths) { got.push_back(paths); };
+
+    getSubTreePaths(cache, bus, coalescer, got);
+    bus.reply(0, {});
+    EXPECT_EQ(cache.size(), 0u);
+
+    cache.setIoService(&io);
+    cache.asyncMethodCall(bus, coalescer, handler, "service", "/path",
+                          "iface", "Get");
+    bus.reply(1, {});
+    EXPECT_EQ(cache.size(), 0u);
+    EXPECT_EQ(cache.hits() + cache.misses(), 0u);
+    EXPECT_EQ(got.size(), 2u);
+}
+
+// Tests that each method gets its own latency, error and timeout counts
+TEST(MethodCallStats, CountsCallsByMethod)
+{
+    FakeBus bus;
+    MethodCallStats stats;
+    int answered = 0;
+    auto handler = [&answered](const boost::system::error_code ec,
+                               const Paths& paths) { answered++; };
+
+    crow::connections::tracedMethodCall(bus, stats, handler, "service",
+                                        "/a", "iface", "Get");
+    crow::connections::tracedMethodCall(bus, stats, handler, "service",
+                                        "/b", "iface", "Get");
+    crow::connections::tracedMethodCall(bus, stats, handler, "service",
+                                        "/a", "iface", "Set");
+    EXPECT_EQ(stats.size(), 2u);
+    EXPECT_EQ(answered, 0);
+
+    bus.reply(0, {});
+    bus.replies[1](boost::system::error_code(ETIMEDOUT,
+                                             boost::system::system_category()),
+                   {});
+    bus.replies[2](boost::system::error_code(EINVAL,
+                                             boost::system::system_category()),
+                   {});
+    EXPECT_EQ(answered, 3);
+
+    MethodCallStats::Method& get = stats.method("service", "iface", "Get");
+    EXPECT_EQ(get.latency.count(), 2u);
+    EXPECT_EQ(get.errors, 1u);
+    EXPECT_EQ(get.timeouts, 1u);
+    MethodCallStats::Method& set = stats.method("service", "iface", "Set");
+    EXPECT_EQ(set.latency.count(), 1u);
+    EXPECT_EQ(set.errors, 1u);
+    EXPECT_EQ(set.timeouts, 0u);
+
+    std::string out;
+    stats.appendMetrics(out);
+    EXPECT_NE(out.find("bmcweb_dbus_call_duration_seconds_count{service="
+                       "\"service\",interface=\"iface\",method=\"Get\"} 2\n"),
+              std::string::npos);
+    EXPECT_NE(out.find("bmcweb_dbus_call_timeouts_total{service=\"service\","
+                       "interface=\"iface\",method=\"Get\"} 1\n"),
+              std::string::npos);
+    EXPECT_NE(out.find("bmcweb_dbus_call_errors_total{service=\"service\","
+                       "interface=\"iface\",method=\"Set\"} 1\n"),
+              std::string::npos);
+}
@@ -0,0 +1,230 @@
+#include <crow/app.h>
+#include <crow/http2_connection.h>
+#include <map>
+#include <memory>
+
+#include <gtest/gtest.h>
+
+using crow::http2::HeaderBlock;
+using crow::http2::responseHeaders;
+
+TEST(Http2HeaderBlock, LowercasesNames)
+{
+    HeaderBlock block;
+    block.add("Content-Type", "application/json");
+    block.add("X-Auth-Token", "Abc");
+    ASSERT_EQ(block.getFields().size(), 2u);
+    EXPECT_EQ(block.getFields()[0].first, "content-type");
+    EXPECT_EQ(block.getFields()[0].second, "application/json");
+    EXPECT_EQ(block.getFields()[1].first, "x-auth-token");
+    // Values are left alone
+    EXPECT_EQ(block.getFields()[1].second, "Abc");
+}
+
+TEST(Http2HeaderBlock, NameValuesPointIntoBlock)
+{
+    HeaderBlock block;
+    block.add(":status", "200");
+    block.add("etag", "\"1\"");
+    std::vector<nghttp2_nv> nv = block.nameValues();
+    ASSERT_EQ(nv.size(), 2u);
+    EXPECT_EQ(std::string(reinterpret_cast<char*>(nv[0].name), nv[0].namelen),
+              ":status");
+    EXPECT_EQ(
+        std::string(reinterpret_cast<char*>(nv[0].value), nv[0].valuelen),
+        "200");
+    EXPECT_EQ(std::string(reinterpret_cast<char*>(nv[1].name), nv[1].namelen),
+              "etag");
+    EXPECT_EQ(nv[1].valuelen, 3u);
+}
+
+TEST(Http2HeaderBlock, ResponseHeadersDropConnectionFields)
+{
+    boost::beast::http::response<boost::beast::http::string_body> response;
+    response.result(boost::beast::http::status::not_found);
+    response.set(boost::beast::http::field::content_type, "text/plain");
+    response.set(boost::beast::http::field::connection, "Keep-Alive");
+    response.set("Keep-Alive", "timeout=15");
+    response.set(boost::beast::http::field::transfer_encoding, "chunked");
+    response.set(boost::beast::http::field::content_length, "9");
+    response.set("OData-Version", "4.0");
+
+    HeaderBlock block = responseHeaders(response.base());
+    const std::vector<std::pair<std::string, std::string>>& fields =
+        block.getFields();
+    ASSERT_EQ(fields.size(), 3u);
+    // The pseudo-header has to come first
+    EXPECT_EQ(fields[0].first, ":status");
+    EXPECT_EQ(fields[0].second, "404");
+    EXPECT_EQ(fields[1].first, "content-type");
+    EXPECT_EQ(fields[2].first, "odata-version");
+    EXPECT_EQ(fields[2].second, "4.0");
+}
+
+namespace
+{
+
+// The client end of an HTTP/2 connection, on nghttp2
+class Http2Client
+{
+  public:
+    explicit Http2Client(boost::asio::ip::tcp::socket& socket) : socket(socket)
+    {
+        nghttp2_session_callbacks* callbacks = nullptr;
+        nghttp2_session_callbacks_new(&callbacks);
+        nghttp2_session_callbacks_set_on_stream_close_callback(
+            callbacks, [](nghttp2_session* /*session*/, int32_t streamId,
+                          uint32_t errorCode, void* userData) {
+                static_cast<Http2Client*>(userData)->closed[streamId] =
+                    errorCode;
+                return 0;
+            });
+        nghttp2_session_client_new(&session, callbacks, this);
+        nghttp2_session_callbacks_del(callbacks);
+        nghttp2_submit_settings(session, NGHTTP2_FLAG_NONE, nullptr, 0);
+    }
+
+    ~Http2Client()
+    {
+        nghttp2_session_del(session);
+    }
+
+    Http2Client(const Http2Client&) = delete;
+    Http2Client& operator=(const Http2Client&) = delete;
+
+    // A request whose body never comes, if stall
+    int32_t request(const char* method, bool stall)
+    {
+        std::array<std::pair<std::string, std::string>, 4> fields{
+            {{":method", method},
+             {":path", "/"},
+             {":scheme", "https"},
+             {":authority", "localhost"}}};
+        std::vector<nghttp2_nv> nv;
+        for (std::pair<std::string, std::string>& field : fields)
+        {
+            nv.push_back({reinterpret_cast<uint8_t*>(&field.first[0]),
+                          reinterpret_cast<uint8_t*>(&field.second[0]),
+                          field.first.size(), field.second.size(),
+                          NGHTTP2_NV_FLAG_NONE});
+        }
+        nghttp2_data_provider provider{};
+        provider.read_callback =
+            [](nghttp2_session* /*session*/, int32_t /*streamId*/,
+               uint8_t* /*buf*/, size_t /*length*/, uint32_t* /*dataFlags*/,
+               nghttp2_data_source* /*source*/,
+               void* /*userData*/) -> ssize_t { return NGHTTP2_ERR_DEFERRED; };
+        return nghttp2_submit_request(session, nullptr, nv.data(), nv.size(),
+                                      stall ? &provider : nullptr, nullptr);
+    }
+
+    void send()
+    {
+        const uint8_t* data = nullptr;
+        ssize_t size;
+        while ((size = nghttp2_session_mem_send(session, &data)) > 0)
+        {
+            boost::asio::write(socket, boost::asio::buffer(
+                                           data, static_cast<size_t>(size)));
+        }
+    }
+
+    void read()
+    {
+        socket.async_read_some(
+            boost::asio::buffer(buffer),
+            [this](const boost::system::error_code& ec, std::size_t size) {
+                if (ec)
+                {
+                    return;
+                }
+                nghttp2_session_mem_recv(session, buffer.data(), size);
+                send();
+                read();
+            });
+    }
+
+    boost::asio::ip::tcp::socket& socket;
+    nghttp2_session* session = nullptr;
+    std::array<uint8_t, 16384> buffer{};
+    // Error codes of the streams closed, by id
+    std::map<int32_t, uint32_t> closed;
+};
+
+} // namespace
+
+// Tests that a stream whose request body stalls is reset when its read
+// deadline passes, while the connection goes on serving other streams
+TEST(Http2Connection, StalledStreamIsReset)
+{
+    crow::SimpleApp app;
+    BMCWEB_ROUTE(app, "/").methods("GET"_method, "POST"_method)(
+        [](const crow::Request&, crow::Response& res) { res.end(); });
+    app.validate();
+
+    crow::KeepAlivePolicy saved = crow::connectionReuse().policy();
+    crow::KeepAlivePolicy policy = saved;
+    policy.headerReadTimeout = std::chrono::milliseconds(200);
+    policy.bodyReadTimeout = std::chrono::milliseconds(200);
+    crow::connectionReuse().setPolicy(policy);
+
+    boost::asio::io_service io;
+    boost::asio::ip::tcp::acceptor acceptor(
+        io, boost::asio::ip::tcp::endpoint(
+                boost::asio::ip::address::from_string("127.0.0.1"), 0));
+    boost::asio::ip::tcp::socket clientSocket(io);
+    clientSocket.connect(acceptor.local_endpoint());
+    crow::SocketAdaptor adaptor(io, nullptr);
+    acceptor.accept(adaptor.socket());
+    boost::asio::ip::address address = clientSocket.local_endpoint().address();
+
+    // As the Connection that handed over the socket would have
+    crow::admissionControl().openConnection(address);
+    crow::serverCounters().activeConnections++;
+    std::string serverName = "test";
+    std::tuple<> middlewares;
+    crow::detail::DateHeader dateHeader;
+    crow::detail::TimerQueue timerQueue;
+    auto conn = std::make_shared<
+        crow::HTTP2Connection<crow::SocketAdaptor, crow::SimpleApp>>(
+        std::move(adaptor), io, io, &app, serverName, &middlewares,
+        dateHeader, timerQueue, address);
+    conn->start();
+
+    Http2Client client(clientSocket);
+    int32_t stalled = client.request("POST", true);
+    client.send();
+    client.read();
+
+    boost::asio::steady_timer tick(io);
+    auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    bool answered = false;
+    std::function<void()> poll = [&] {
+        timerQueue.process();
+        if (client.closed.count(stalled) != 0 && !answered)
+        {
+            // The connection is still good for another request
+            answered = true;
+            client.request("GET", false);
+            client.send();
+        }
+        if (client.closed.size() == 2 ||
+            std::chrono::steady_clock::now() > deadline)
+        {
+            clientSocket.close();
+            return;
+        }
+        tick.expires_from_now(std::chrono::milliseconds(50));
+        tick.async_wait([&](const boost::system::error_code&) { poll(); });
+    };
+    poll();
+    conn.reset();
+    io.run();
+    crow::connectionReuse().setPolicy(saved);
+
+    ASSERT_EQ(client.closed.count(stalled), 1u);
+    EXPECT_EQ(client.closed[stalled], NGHTTP2_CANCEL);
+    ASSERT_EQ(client.closed.size(), 2u);
+    EXPECT_EQ(client.closed.rbegin()->second, NGHTTP2_NO_ERROR);
+}
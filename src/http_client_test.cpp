@@ -0,0 +1,256 @@
+#include <crow/app.h>
+#include <crow/http_client.h>
+#include <ssl_key_handler.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace crow::http_client;
+
+namespace
+{
+
+namespace http = boost::beast::http;
+
+Request get(const std::string& target)
+{
+    return Request{http::verb::get, target, 11};
+}
+
+// A crow server on its own thread
+class TestServer
+{
+  public:
+    explicit TestServer(uint16_t port) :
+        io(std::make_shared<boost::asio::io_service>()),
+        server(&app, "127.0.0.1", port, nullptr, nullptr, io)
+    {
+        BMCWEB_ROUTE(app, "/")
+        ([](const crow::Request&, crow::Response& res) {
+            res.body() = "hello";
+            res.end();
+        });
+        app.validate();
+        server.run();
+        thread = std::thread([this] { io->run(); });
+    }
+
+    ~TestServer()
+    {
+        server.stop();
+        thread.join();
+    }
+
+    crow::SimpleApp app;
+    std::shared_ptr<boost::asio::io_service> io;
+    crow::Server<crow::SimpleApp> server;
+    std::thread thread;
+};
+
+} // namespace
+
+TEST(HttpClient, ReusesConnections)
+{
+    constexpr uint16_t port = 45471;
+    TestServer server(port);
+    boost::asio::io_service io;
+    Client client(io);
+    Endpoint endpoint{"127.0.0.1", port, false};
+
+    std::vector<std::string> bodies;
+    std::function<void()> next = [&] {
+        client.send(endpoint, get("/"), std::chrono::seconds(5),
+                    [&](const boost::system::error_code& ec, Response& res) {
+                        EXPECT_FALSE(ec) << ec.message();
+                        bodies.push_back(res.body());
+                        if (bodies.size() < 3)
+                        {
+                            next();
+                        }
+                    });
+    };
+    next();
+    io.run();
+
+    EXPECT_EQ(bodies, std::vector<std::string>(3, "hello"));
+    EXPECT_EQ(client.counters().connects, 1u);
+    EXPECT_EQ(client.counters().reused, 2u);
+    EXPECT_EQ(client.idleConnections(endpoint), 1u);
+}
+
+// Requests at the same time each get a connection, and are all kept for
+// later
+TEST(HttpClient, RunsRequestsInParallel)
+{
+    constexpr uint16_t port = 45472;
+    TestServer server(port);
+    boost::asio::io_service io;
+    Client client(io, 2);
+    Endpoint endpoint{"127.0.0.1", port, false};
+
+    size_t done = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        client.send(endpoint, get("/"), std::chrono::seconds(5),
+                    [&done](const boost::system::error_code& ec, Response&) {
+                        EXPECT_FALSE(ec) << ec.message();
+                        done++;
+                    });
+    }
+    io.run();
+
+    EXPECT_EQ(done, 3u);
+    EXPECT_EQ(client.counters().connects, 3u);
+    // Only as many as the pool keeps
+    EXPECT_EQ(client.idleConnections(endpoint), 2u);
+}
+
+TEST(HttpClient, TimesOut)
+{
+    boost::asio::io_service serverIo;
+    // Accepts, and then never answers
+    boost::asio::ip::tcp::acceptor acceptor(
+        serverIo, boost::asio::ip::tcp::endpoint(
+                      boost::asio::ip::address::from_string("127.0.0.1"), 0));
+    boost::asio::ip::tcp::socket silent(serverIo);
+    acceptor.async_accept(silent, [](const boost::system::error_code&) {});
+    std::thread serverThread([&serverIo] { serverIo.run(); });
+
+    boost::asio::io_service io;
+    Client client(io);
+    Endpoint endpoint{"127.0.0.1", acceptor.local_endpoint().port(), false};
+    boost::system::error_code result;
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    client.send(endpoint, get("/"), std::chrono::milliseconds(100),
+                [&result](const boost::system::error_code& ec, Response&) {
+                    result = ec;
+                });
+    io.run();
+
+    EXPECT_EQ(result, boost::asio::error::timed_out);
+    EXPECT_LT(std::chrono::steady_clock::now() - start,
+              std::chrono::seconds(2));
+    EXPECT_EQ(client.counters().timeouts, 1u);
+    EXPECT_EQ(client.idleConnections(endpoint), 0u);
+    serverThread.join();
+}
+
+// A server that closes an idle connection costs a reconnect, not an error
+TEST(HttpClient, ReconnectsWhenPooledConnectionIsClosed)
+{
+    boost::asio::io_service serverIo;
+    boost::asio::ip::tcp::acceptor acceptor(
+        serverIo, boost::asio::ip::tcp::endpoint(
+                      boost::asio::ip::address::from_string("127.0.0.1"), 0));
+    const uint16_t port = acceptor.local_endpoint().port();
+    // Answers one request per connection, claiming keep-alive, then hangs
+    // up
+    std::thread serverThread([&acceptor, &serverIo] {
+        for (int i = 0; i < 2; i++)
+        {
+            boost::asio::ip::tcp::socket socket(serverIo);
+            acceptor.accept(socket);
+            boost::beast::flat_buffer buffer;
+            http::request<http::string_body> req;
+            http::read(socket, buffer, req);
+            http::response<http::string_body> res{http::status::ok, 11};
+            res.body() = std::to_string(i);
+            res.keep_alive(true);
+            res.prepare_payload();
+            http::write(socket, res);
+            socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both);
+            socket.close();
+        }
+    });
+
+    boost::asio::io_service io;
+    Client client(io);
+    Endpoint endpoint{"127.0.0.1", port, false};
+    std::vector<std::string> bodies;
+    client.send(endpoint, get("/"), std::chrono::seconds(5),
+                [&](const boost::system::error_code& ec, Response& res) {
+                    EXPECT_FALSE(ec) << ec.message();
+                    bodies.push_back(res.body());
+                });
+    io.run();
+    io.reset();
+    // Give the close time to arrive
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    client.send(endpoint, get("/"), std::chrono::seconds(5),
+                [&](const boost::system::error_code& ec, Response& res) {
+                    EXPECT_FALSE(ec) << ec.message();
+                    bodies.push_back(res.body());
+                });
+    io.run();
+    serverThread.join();
+
+    EXPECT_EQ(bodies, (std::vector<std::string>{"0", "1"}));
+    EXPECT_EQ(client.counters().reused, 1u);
+    EXPECT_EQ(client.counters().connects, 2u);
+}
+
+#ifdef BMCWEB_ENABLE_SSL
+TEST(HttpClient, ResumesTlsSessions)
+{
+    const std::string pemFile = "http_client_test.pem";
+    ensuressl::generateSslCertificate(pemFile);
+    boost::asio::ssl::context serverContext =
+        ensuressl::getSslContext(pemFile);
+    std::remove(pemFile.c_str());
+
+    boost::asio::io_service serverIo;
+    boost::asio::ip::tcp::acceptor acceptor(
+        serverIo, boost::asio::ip::tcp::endpoint(
+                      boost::asio::ip::address::from_string("127.0.0.1"), 0));
+    const uint16_t port = acceptor.local_endpoint().port();
+    // Closes after every response, so each request needs a handshake
+    std::thread serverThread([&] {
+        for (int i = 0; i < 2; i++)
+        {
+            boost::asio::ssl::stream<boost::asio::ip::tcp::socket> stream(
+                serverIo, serverContext);
+            acceptor.accept(stream.next_layer());
+            boost::system::error_code ec;
+            stream.handshake(boost::asio::ssl::stream_base::server, ec);
+            ASSERT_FALSE(ec) << ec.message();
+            boost::beast::flat_buffer buffer;
+            http::request<http::string_body> req;
+            http::read(stream, buffer, req, ec);
+            http::response<http::string_body> res{http::status::ok, 11};
+            res.body() = "secure";
+            res.keep_alive(false);
+            res.prepare_payload();
+            http::write(stream, res, ec);
+            stream.shutdown(ec);
+        }
+    });
+
+    boost::asio::io_service io;
+    Client client(io);
+    // The certificate is self-signed
+    Endpoint endpoint{"127.0.0.1", port, true, false};
+    std::vector<std::string> bodies;
+    for (int i = 0; i < 2; i++)
+    {
+        client.send(endpoint, get("/"), std::chrono::seconds(5),
+                    [&](const boost::system::error_code& ec, Response& res) {
+                        EXPECT_FALSE(ec) << ec.message();
+                        bodies.push_back(res.body());
+                    });
+        io.run();
+        io.reset();
+    }
+    serverThread.join();
+
+    EXPECT_EQ(bodies, std::vector<std::string>(2, "secure"));
+    EXPECT_EQ(client.counters().connects, 2u);
+    EXPECT_EQ(client.counters().resumed, 1u);
+}
+#endif
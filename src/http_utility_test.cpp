@@ -0,0 +1,57 @@
+#include <crow/http_request.h>
+
+#include <http_utility.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using http_helpers::ByteRange;
+using http_helpers::parseByteRange;
+
+TEST(ParseByteRange, ReadsSingleRanges)
+{
+    uint64_t first = 0;
+    uint64_t length = 0;
+    EXPECT_EQ(parseByteRange("bytes=0-99", 1000, first, length),
+              ByteRange::satisfiable);
+    EXPECT_EQ(first, 0u);
+    EXPECT_EQ(length, 100u);
+
+    // Open ended, and past the end, run to the end of the file
+    EXPECT_EQ(parseByteRange("bytes=900-", 1000, first, length),
+              ByteRange::satisfiable);
+    EXPECT_EQ(first, 900u);
+    EXPECT_EQ(length, 100u);
+    EXPECT_EQ(parseByteRange("bytes=990-5000", 1000, first, length),
+              ByteRange::satisfiable);
+    EXPECT_EQ(length, 10u);
+
+    // Suffix ranges count from the end
+    EXPECT_EQ(parseByteRange("bytes=-10", 1000, first, length),
+              ByteRange::satisfiable);
+    EXPECT_EQ(first, 990u);
+    EXPECT_EQ(length, 10u);
+    EXPECT_EQ(parseByteRange("bytes=-5000", 1000, first, length),
+              ByteRange::satisfiable);
+    EXPECT_EQ(first, 0u);
+    EXPECT_EQ(length, 1000u);
+}
+
+TEST(ParseByteRange, RejectsOthers)
+{
+    uint64_t first = 0;
+    uint64_t length = 0;
+    EXPECT_EQ(parseByteRange("bytes=1000-", 1000, first, length),
+              ByteRange::unsatisfiable);
+    EXPECT_EQ(parseByteRange("bytes=-0", 1000, first, length),
+              ByteRange::unsatisfiable);
+
+    for (const char* ignored :
+         {"", "items=0-1", "bytes=", "bytes=-", "bytes=5-3", "bytes=a-3",
+          "bytes=0-1,5-6", "bytes=99999999999999999999-"})
+    {
+        EXPECT_EQ(parseByteRange(ignored, 1000, first, length),
+                  ByteRange::none)
+            << ignored;
+    }
+}
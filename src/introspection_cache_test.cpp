@@ -0,0 +1,153 @@
+#include <introspection_cache.hpp>
+
+#include <boost/asio/io_service.hpp>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using crow::connections::IntrospectedObject;
+using crow::connections::IntrospectionCache;
+using crow::connections::MethodCallCoalescer;
+
+namespace
+{
+constexpr const char* xml =
+    "<node>"
+    "<interface name=\"xyz.openbmc_project.State.Host\">"
+    "<method name=\"Reset\">"
+    "<arg name=\"delay\" type=\"u\" direction=\"in\"/>"
+    "<arg name=\"ok\" type=\"b\" direction=\"out\"/>"
+    "</method>"
+    "<signal name=\"Changed\"><arg name=\"state\" type=\"s\"/></signal>"
+    "<property name=\"CurrentHostState\" type=\"s\" access=\"read\"/>"
+    "</interface>"
+    "<node name=\"child0\"/>"
+    "<node name=\"child1\"/>"
+    "</node>";
+
+// Stands in for sdbusplus::asio::connection, keeping every Introspect call
+// until the test answers it
+struct FakeBus
+{
+    template <typename Handler>
+    void async_method_call(Handler&& handler, const std::string& service,
+                           const std::string& path,
+                           const std::string& interface,
+                           const std::string& method)
+    {
+        paths.push_back(path);
+        replies.emplace_back(
+            [handler](const boost::system::error_code& ec,
+                      const std::string& xml) { handler(ec, xml); });
+    }
+
+    void reply(size_t index, const std::string& xml)
+    {
+        auto handler = std::move(replies[index]);
+        handler(boost::system::error_code(), xml);
+    }
+
+    std::vector<std::string> paths;
+    std::vector<std::function<void(const boost::system::error_code&,
+                                   const std::string&)>>
+        replies;
+};
+} // namespace
+
+TEST(IntrospectionCache, ParsesTables)
+{
+    IntrospectedObject object;
+    ASSERT_TRUE(crow::connections::parseIntrospection(xml, object));
+    EXPECT_THAT(object.children, testing::ElementsAre("child0", "child1"));
+    ASSERT_EQ(object.interfaces.size(), 1u);
+
+    const crow::connections::IntrospectedInterface* interface =
+        object.findInterface("xyz.openbmc_project.State.Host");
+    ASSERT_NE(interface, nullptr);
+    ASSERT_EQ(interface->methods.size(), 1u);
+    EXPECT_EQ(interface->methods[0].name, "Reset");
+    ASSERT_EQ(interface->methods[0].args.size(), 2u);
+    EXPECT_EQ(interface->methods[0].args[0].type, "u");
+    EXPECT_EQ(interface->methods[0].args[0].direction, "in");
+    EXPECT_EQ(interface->methods[0].args[1].direction, "out");
+    ASSERT_EQ(interface->signals.size(), 1u);
+    EXPECT_EQ(interface->signals[0].args[0].name, "state");
+    ASSERT_EQ(interface->properties.size(), 1u);
+    EXPECT_EQ(interface->properties[0].name, "CurrentHostState");
+    EXPECT_EQ(interface->properties[0].type, "s");
+
+    EXPECT_EQ(object.findInterface("org.freedesktop.DBus.Properties"),
+              nullptr);
+
+    IntrospectedObject bad;
+    EXPECT_FALSE(crow::connections::parseIntrospection("not xml", bad));
+}
+
+// Tests that a second lookup is answered from memory, without the bus
+TEST(IntrospectionCache, AnswersRepeatsFromMemory)
+{
+    boost::asio::io_service io;
+    FakeBus bus;
+    MethodCallCoalescer coalescer;
+    IntrospectionCache cache;
+    cache.setIoService(&io);
+
+    std::vector<std::shared_ptr<const IntrospectedObject>> got;
+    auto handler =
+        [&got](const boost::system::error_code& ec,
+               const std::shared_ptr<const IntrospectedObject>& object) {
+            got.push_back(object);
+        };
+
+    cache.introspect(bus, coalescer, "xyz.openbmc_project.State.Host",
+                     "/xyz/openbmc_project/state/host0", handler);
+    ASSERT_EQ(bus.paths.size(), 1u);
+    bus.reply(0, xml);
+    ASSERT_EQ(got.size(), 1u);
+    ASSERT_NE(got[0], nullptr);
+
+    cache.introspect(bus, coalescer, "xyz.openbmc_project.State.Host",
+                     "/xyz/openbmc_project/state/host0", handler);
+    EXPECT_EQ(bus.paths.size(), 1u);
+    io.run();
+    ASSERT_EQ(got.size(), 2u);
+    EXPECT_EQ(got[1], got[0]);
+    EXPECT_EQ(cache.hits(), 1u);
+    EXPECT_EQ(cache.misses(), 1u);
+}
+
+// Tests that a change to an object drops it and the objects above it, and
+// that a service restarting drops everything of that service
+TEST(IntrospectionCache, InvalidationDropsAffectedEntries)
+{
+    boost::asio::io_service io;
+    FakeBus bus;
+    MethodCallCoalescer coalescer;
+    IntrospectionCache cache;
+    cache.setIoService(&io);
+    auto handler = [](const boost::system::error_code& ec,
+                      const std::shared_ptr<const IntrospectedObject>&) {};
+
+    const std::vector<std::string> paths{
+        "/", "/xyz/openbmc_project", "/xyz/openbmc_project/state",
+        "/xyz/openbmc_project/state/host0", "/xyz/openbmc_project/sensors"};
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        cache.introspect(bus, coalescer, "a.service", paths[i], handler);
+        bus.reply(i, xml);
+    }
+    cache.introspect(bus, coalescer, "b.service", "/", handler);
+    bus.reply(paths.size(), xml);
+    EXPECT_EQ(cache.size(), paths.size() + 1);
+
+    cache.invalidatePath("/xyz/openbmc_project/state/host0");
+    // Only the sibling subtree is left; the roots of both services went too
+    EXPECT_EQ(cache.size(), 1u);
+
+    cache.invalidateService("b.service");
+    EXPECT_EQ(cache.size(), 1u);
+    cache.invalidateService("a.service");
+    EXPECT_EQ(cache.size(), 0u);
+}
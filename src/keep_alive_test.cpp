@@ -0,0 +1,86 @@
+#include <crow/keep_alive.h>
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+using crow::CloseReason;
+using crow::ConnectionReuse;
+using crow::KeepAlivePolicy;
+using std::chrono::seconds;
+
+TEST(KeepAlive, ParsesPolicy)
+{
+    KeepAlivePolicy policy;
+    ASSERT_TRUE(crow::parseKeepAlivePolicy("idle=30,requests=1000", policy));
+    EXPECT_EQ(policy.idleTimeout, seconds(30));
+    EXPECT_EQ(policy.maxRequests, 1000u);
+    // Left at the defaults
+    EXPECT_EQ(policy.headerReadTimeout, seconds(5));
+    EXPECT_EQ(policy.bodyReadTimeout, seconds(60));
+
+    ASSERT_TRUE(crow::parseKeepAlivePolicy("header=2,body=120", policy));
+    EXPECT_EQ(policy.headerReadTimeout, seconds(2));
+    EXPECT_EQ(policy.bodyReadTimeout, seconds(120));
+    EXPECT_EQ(policy.idleTimeout, seconds(30));
+}
+
+TEST(KeepAlive, RejectsBadPolicies)
+{
+    KeepAlivePolicy policy;
+    EXPECT_FALSE(crow::parseKeepAlivePolicy("idle=30,linger=5", policy));
+    EXPECT_FALSE(crow::parseKeepAlivePolicy("idle=0", policy));
+    EXPECT_FALSE(crow::parseKeepAlivePolicy("idle=-1", policy));
+    EXPECT_FALSE(crow::parseKeepAlivePolicy("idle=5s", policy));
+    EXPECT_FALSE(crow::parseKeepAlivePolicy("idle", policy));
+    EXPECT_FALSE(crow::parseKeepAlivePolicy("requests=", policy));
+    // Nothing of a rejected list is applied
+    EXPECT_EQ(policy.idleTimeout, seconds(15));
+}
+
+TEST(KeepAlive, CountsReuse)
+{
+    ConnectionReuse reuse;
+    reuse.requestStarted(false);
+    reuse.requestStarted(true);
+    reuse.requestStarted(true);
+    reuse.connectionClosed(3, 1500, CloseReason::idleTimeout);
+    reuse.requestStarted(false);
+    reuse.connectionClosed(1, 200, CloseReason::noKeepAlive);
+    reuse.connectionClosed(200, 90000, CloseReason::maxRequests);
+
+    EXPECT_EQ(reuse.requests(false), 2u);
+    EXPECT_EQ(reuse.requests(true), 2u);
+    EXPECT_EQ(reuse.closedConnections(CloseReason::idleTimeout), 1u);
+    EXPECT_EQ(reuse.closedConnections(CloseReason::client), 0u);
+
+    std::string out;
+    reuse.appendMetrics(out);
+    EXPECT_NE(out.find("bmcweb_http_requests_total{connection=\"reused\"} 2\n"),
+              std::string::npos);
+    EXPECT_NE(out.find("bmcweb_connection_requests_bucket{le=\"1\"} 1\n"),
+              std::string::npos);
+    // Cumulative
+    EXPECT_NE(out.find("bmcweb_connection_requests_bucket{le=\"4\"} 2\n"),
+              std::string::npos);
+    EXPECT_NE(out.find("bmcweb_connection_requests_bucket{le=\"128\"} 2\n"),
+              std::string::npos);
+    EXPECT_NE(out.find("bmcweb_connection_requests_bucket{le=\"+Inf\"} 3\n"),
+              std::string::npos);
+    EXPECT_NE(out.find("bmcweb_connection_requests_sum 204\n"),
+              std::string::npos);
+    EXPECT_NE(out.find("bmcweb_connection_bytes_sum 91700\n"),
+              std::string::npos);
+    EXPECT_NE(out.find("bmcweb_connections_closed_total"
+                       "{reason=\"max_requests\"} 1\n"),
+              std::string::npos);
+}
+
+TEST(KeepAlive, SetsPolicy)
+{
+    ConnectionReuse reuse;
+    KeepAlivePolicy policy;
+    policy.maxRequests = 100;
+    reuse.setPolicy(policy);
+    EXPECT_EQ(reuse.policy().maxRequests, 100u);
+}
@@ -0,0 +1,70 @@
+#include <kvm_dirty_tiles.hpp>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using crow::kvm::DirtyRect;
+using crow::kvm::DirtyTileTracker;
+
+namespace
+{
+constexpr unsigned width = 100;
+constexpr unsigned height = 50;
+
+bool operator==(const DirtyRect &a, const DirtyRect &b)
+{
+    return a.x == b.x && a.y == b.y && a.width == b.width &&
+           a.height == b.height;
+}
+} // namespace
+
+// Tests that the first frame, and every full update, is sent whole, and
+// that an unchanged frame sends nothing
+TEST(DirtyTileTracker, FullAndUnchangedFrames)
+{
+    std::vector<ast_video::RGB> frame(width * height, ast_video::RGB{});
+    DirtyTileTracker tracker;
+
+    std::vector<DirtyRect> rects =
+        tracker.update(frame.data(), width, height, true);
+    ASSERT_EQ(rects.size(), 1u);
+    EXPECT_TRUE(rects[0] == (DirtyRect{0, 0, width, height}));
+
+    EXPECT_TRUE(tracker.update(frame.data(), width, height, true).empty());
+
+    rects = tracker.update(frame.data(), width, height, false);
+    ASSERT_EQ(rects.size(), 1u);
+    EXPECT_TRUE(rects[0] == (DirtyRect{0, 0, width, height}));
+}
+
+// Tests that changed tiles are sent as rectangles, joined across a row and
+// down successive rows, and clipped to the frame
+TEST(DirtyTileTracker, SendsChangedTiles)
+{
+    std::vector<ast_video::RGB> frame(width * height, ast_video::RGB{});
+    DirtyTileTracker tracker;
+    tracker.update(frame.data(), width, height, true);
+
+    // Tiles (1, 0), (2, 0), (1, 1) and (2, 1)
+    frame[5 * width + 20].r = 1;
+    frame[5 * width + 40].r = 1;
+    frame[20 * width + 20].g = 1;
+    frame[20 * width + 40].g = 1;
+    // The last tile of the first row, which is 4 pixels wide
+    frame[99].b = 1;
+    // The bottom row of tiles is 2 pixels high
+    frame[49 * width + 70].b = 1;
+    std::vector<DirtyRect> rects =
+        tracker.update(frame.data(), width, height, true);
+    ASSERT_EQ(rects.size(), 3u);
+    EXPECT_TRUE(rects[0] == (DirtyRect{16, 0, 32, 32}));
+    EXPECT_TRUE(rects[1] == (DirtyRect{96, 0, 4, 16}));
+    EXPECT_TRUE(rects[2] == (DirtyRect{64, 48, 16, 2}));
+
+    std::vector<uint8_t> pixels =
+        crow::kvm::rawPixels(frame.data(), width, rects[1]);
+    ASSERT_EQ(pixels.size(), 4u * 16 * 4);
+    EXPECT_EQ(pixels[3 * 4], 1);
+    EXPECT_EQ(pixels[0], 0);
+}
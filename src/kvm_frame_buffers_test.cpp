@@ -0,0 +1,82 @@
+#include <kvm_frame_buffers.hpp>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using crow::kvm::DirtyRect;
+using crow::kvm::EncodedUpdate;
+using crow::kvm::FrameBufferPool;
+
+namespace
+{
+std::string join(const EncodedUpdate& update)
+{
+    std::string joined;
+    for (const boost::asio::const_buffer& buffer : update.buffers)
+    {
+        joined.append(static_cast<const char*>(buffer.data()),
+                      buffer.size());
+    }
+    return joined;
+}
+} // namespace
+
+// Tests that the buffers of an update make the same bytes as a
+// FramebufferUpdate serialized in one piece
+TEST(KvmFrameBuffers, EncodesRawUpdate)
+{
+    constexpr unsigned width = 4;
+    std::vector<ast_video::RGB> frame(width * 2);
+    for (size_t i = 0; i < frame.size(); i++)
+    {
+        frame[i].b = static_cast<unsigned char>(i);
+        frame[i].g = static_cast<unsigned char>(i + 16);
+        frame[i].r = static_cast<unsigned char>(i + 32);
+    }
+    std::vector<DirtyRect> rects{DirtyRect{1, 0, 2, 1},
+                                 DirtyRect{3, 1, 1, 1}};
+    FrameBufferPool pool;
+    std::shared_ptr<const EncodedUpdate> update =
+        crow::kvm::encodeRawUpdate(frame.data(), width, rects, pool);
+
+    std::string expected("\x00\x00\x00\x02", 4);
+    expected += std::string("\x00\x01\x00\x00\x00\x02\x00\x01"
+                            "\x00\x00\x00\x00",
+                            12);
+    expected += std::string("\x01\x11\x21\x00\x02\x12\x22\x00", 8);
+    expected += std::string("\x00\x03\x00\x01\x00\x01\x00\x01"
+                            "\x00\x00\x00\x00",
+                            12);
+    expected += std::string("\x07\x17\x27\x00", 4);
+    EXPECT_EQ(join(*update), expected);
+    // The message header goes out with the first rectangle header
+    ASSERT_EQ(update->buffers.size(), 4u);
+    EXPECT_EQ(update->buffers[0].size(), 16u);
+
+    update = crow::kvm::encodeRawUpdate(frame.data(), width, {}, pool);
+    EXPECT_EQ(join(*update), std::string("\x00\x00\x00\x00", 4));
+}
+
+// Tests that a buffer is reused once the last update holding it is gone
+TEST(KvmFrameBuffers, ReusesBuffers)
+{
+    FrameBufferPool pool;
+    std::shared_ptr<FrameBufferPool::Buffer> first = pool.acquire(1000);
+    const uint8_t* data = first->data();
+    EXPECT_EQ(pool.idle(), 0u);
+    first.reset();
+    EXPECT_EQ(pool.idle(), 1u);
+
+    std::shared_ptr<FrameBufferPool::Buffer> second = pool.acquire(500);
+    EXPECT_EQ(second->data(), data);
+    EXPECT_EQ(second->size(), 500u);
+    EXPECT_EQ(pool.idle(), 0u);
+
+    // Buffers still out when the pool goes away are freed on their own
+    auto other = std::make_unique<FrameBufferPool>();
+    std::shared_ptr<FrameBufferPool::Buffer> orphan = other->acquire(10);
+    other.reset();
+    orphan.reset();
+}
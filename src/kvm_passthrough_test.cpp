@@ -0,0 +1,50 @@
+#include <kvm_passthrough.hpp>
+
+#include <cstring>
+#include <string>
+
+#include <gtest/gtest.h>
+
+using crow::kvm::PassthroughFrame;
+using crow::kvm::PassthroughHeader;
+
+// Tests that a frame is the header, then the stream as the engine gave it
+TEST(KvmPassthrough, FramesStream)
+{
+    auto video = std::make_shared<ast_video::RawVideoBuffer>();
+    video->buffer = {0x04030201, 0x08070605, 0x0c0b0a09};
+    video->length = 10;
+    video->width = 800;
+    video->height = 600;
+    video->mode = ast_video::YuvMode::YUV420;
+    video->ySelector = 4;
+    video->uvSelector = 7;
+    const uint32_t* stream = video->buffer.data();
+
+    std::shared_ptr<const PassthroughFrame> frame =
+        crow::kvm::encodePassthroughFrame(video);
+    video.reset();
+
+    ASSERT_EQ(sizeof(PassthroughHeader), 12u);
+    ASSERT_EQ(frame->buffers.size(), 2u);
+    std::string header(static_cast<const char*>(frame->buffers[0].data()),
+                       frame->buffers[0].size());
+    EXPECT_EQ(header, std::string("\x01\x01\x04\x07\x03\x20\x02\x58"
+                                  "\x00\x00\x00\x0a",
+                                  12));
+    // Not copied, and only the bytes the engine wrote
+    EXPECT_EQ(frame->buffers[1].data(), static_cast<const void*>(stream));
+    EXPECT_EQ(frame->buffers[1].size(), 10u);
+}
+
+// Tests that a length past the end of the buffer is cut to it
+TEST(KvmPassthrough, ClampsLength)
+{
+    auto video = std::make_shared<ast_video::RawVideoBuffer>();
+    video->buffer.resize(2);
+    video->length = 100;
+    std::shared_ptr<const PassthroughFrame> frame =
+        crow::kvm::encodePassthroughFrame(video);
+    EXPECT_EQ(frame->buffers[1].size(), 8u);
+    EXPECT_EQ(frame->header.length, 8u);
+}
@@ -0,0 +1,72 @@
+#include <kvm_rate_control.hpp>
+
+#include <gtest/gtest.h>
+
+using crow::kvm::RateController;
+using std::chrono::milliseconds;
+
+namespace
+{
+// Sends a frame at now, and gets the next request after roundTrip
+RateController::clock::time_point
+    cycle(RateController& rate, RateController::clock::time_point now,
+          milliseconds roundTrip, size_t buffered = 0)
+{
+    rate.sent(now);
+    now += roundTrip;
+    rate.requested(now, buffered);
+    return now;
+}
+} // namespace
+
+// Tests that a fast link gets frames as fast as it asks, at full quality
+TEST(KvmRateControl, FastLinkIsNotPaced)
+{
+    RateController rate;
+    RateController::clock::time_point now;
+    for (int i = 0; i < 20; i++)
+    {
+        now = cycle(rate, now, milliseconds(20));
+        EXPECT_TRUE(rate.ready(now, 0));
+    }
+    EXPECT_EQ(rate.frameInterval().count(), 0);
+    EXPECT_EQ(rate.targetQuality(), RateController::maxQuality());
+}
+
+// Tests that a slow round trip spaces frames and lowers the quality, and
+// that both recover once the link is fast again
+TEST(KvmRateControl, SlowLinkBacksOffAndRecovers)
+{
+    RateController rate;
+    RateController::clock::time_point now;
+    for (int i = 0; i < 10; i++)
+    {
+        now = cycle(rate, now, milliseconds(400));
+    }
+    EXPECT_GE(rate.frameInterval(), milliseconds(400));
+    EXPECT_LE(rate.frameInterval(), RateController::maxInterval());
+    EXPECT_LT(rate.targetQuality(), RateController::maxQuality());
+    // The next frame has to wait out the interval
+    EXPECT_FALSE(rate.ready(now, 0));
+    EXPECT_TRUE(rate.ready(now + rate.frameInterval(), 0));
+
+    int lowQuality = rate.targetQuality();
+    for (int i = 0; i < 100; i++)
+    {
+        now = cycle(rate, now + rate.frameInterval(), milliseconds(10));
+    }
+    EXPECT_LT(rate.frameInterval(), milliseconds(1));
+    EXPECT_GT(rate.targetQuality(), lowQuality);
+}
+
+// Tests that bytes piling up in the queue hold frames back even when the
+// round trip looks fine
+TEST(KvmRateControl, BacklogHoldsFrames)
+{
+    RateController rate;
+    RateController::clock::time_point now;
+    EXPECT_FALSE(rate.ready(now, RateController::maxBuffered() + 1));
+    now = cycle(rate, now, milliseconds(10), RateController::maxBuffered() + 1);
+    EXPECT_GT(rate.frameInterval().count(), 0);
+    EXPECT_EQ(rate.targetQuality(), RateController::maxQuality() - 1);
+}
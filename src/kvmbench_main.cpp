@@ -0,0 +1,229 @@
+#include <ast_jpeg_decoder.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <kvm_dirty_tiles.hpp>
+#include <kvm_frame_buffers.hpp>
+#include <new>
+#include <string>
+#include <vector>
+
+// Replays recorded video engine frames through the KVM path, and reports
+// how fast each stage goes.  Frames are named like the ones in
+// src/test_resources: <what>_<444|420>_<width>x<height>_<uv>chrom_<y>lum.bin.
+// Frames not named so are taken as 444, 800x600, tables 0.  Stage times are
+// taken on a separate, serial run, and add up to more than the decode: they
+// include a clock read around each stage of each tile.
+//
+// kvmbench [-n iterations] [-b bands] [frame.bin...], from src/ for the
+// default frames
+
+namespace
+{
+std::atomic<uint64_t> allocations{0};
+} // namespace
+
+void* operator new(std::size_t size)
+{
+    allocations++;
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+using clock = std::chrono::steady_clock;
+
+struct Frame
+{
+    std::string path;
+    ast_video::RawVideoBuffer video;
+};
+
+// Reads the mode, size and tables out of the name of a recorded frame
+void parseName(const std::string& path, ast_video::RawVideoBuffer& video)
+{
+    video.mode = ast_video::YuvMode::YUV444;
+    video.width = 800;
+    video.height = 600;
+    video.ySelector = 0;
+    video.uvSelector = 0;
+
+    std::string name = path.substr(path.find_last_of('/') + 1);
+    size_t pos = name.find("_420_");
+    if (pos != std::string::npos)
+    {
+        video.mode = ast_video::YuvMode::YUV420;
+    }
+    else
+    {
+        pos = name.find("_444_");
+    }
+    if (pos == std::string::npos)
+    {
+        return;
+    }
+    unsigned long width = 0;
+    unsigned long height = 0;
+    int uv = 0;
+    int y = 0;
+    if (std::sscanf(name.c_str() + pos + 5, "%lux%lu_%dchrom_%dlum", &width,
+                    &height, &uv, &y) == 4)
+    {
+        video.width = width;
+        video.height = height;
+        video.uvSelector = uv;
+        video.ySelector = y;
+    }
+}
+
+bool load(const std::string& path, Frame& frame)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    std::vector<char> bytes((std::istreambuf_iterator<char>(file)),
+                            std::istreambuf_iterator<char>());
+    frame.path = path;
+    // The decoder can read a little past the end of a frame
+    frame.video.buffer.assign(bytes.size() / sizeof(uint32_t) + 16, 0);
+    std::memcpy(frame.video.buffer.data(), bytes.data(), bytes.size());
+    frame.video.length = bytes.size();
+    parseName(path, frame.video);
+    return true;
+}
+
+double microseconds(std::chrono::nanoseconds d, int iterations)
+{
+    return std::chrono::duration<double, std::micro>(d).count() / iterations;
+}
+
+void run(Frame& frame, int iterations, size_t bands)
+{
+    ast_video::RawVideoBuffer& video = frame.video;
+    ast_video::AstJpegDecoder decoder;
+    decoder.setBands(bands);
+    // The first decode builds the tables
+    decoder.decode(video.buffer, video.width, video.height, video.mode,
+                   video.ySelector, video.uvSelector);
+
+    uint64_t allocationsBefore = allocations;
+    clock::time_point start = clock::now();
+    for (int i = 0; i < iterations; i++)
+    {
+        decoder.decode(video.buffer, video.width, video.height, video.mode,
+                       video.ySelector, video.uvSelector);
+    }
+    clock::duration decodeTime = clock::now() - start;
+    uint64_t decodeAllocations = allocations - allocationsBefore;
+
+    ast_video::StageTimes stages;
+    decoder.profileStages(&stages);
+    for (int i = 0; i < iterations; i++)
+    {
+        decoder.decode(video.buffer, video.width, video.height, video.mode,
+                       video.ySelector, video.uvSelector);
+    }
+    decoder.profileStages(nullptr);
+
+    // What /kvmws does with a decoded frame when all of it is sent
+    crow::kvm::DirtyTileTracker tiles;
+    crow::kvm::FrameBufferPool pool;
+    allocationsBefore = allocations;
+    start = clock::now();
+    for (int i = 0; i < iterations; i++)
+    {
+        std::vector<crow::kvm::DirtyRect> rects = tiles.update(
+            decoder.outBuffer.data(), static_cast<unsigned>(video.width),
+            static_cast<unsigned>(video.height), false);
+        std::shared_ptr<const crow::kvm::EncodedUpdate> update =
+            crow::kvm::encodeRawUpdate(decoder.outBuffer.data(),
+                                       static_cast<unsigned>(video.width),
+                                       rects, pool);
+    }
+    clock::duration serializeTime = clock::now() - start;
+    uint64_t serializeAllocations = allocations - allocationsBefore;
+
+    double frameTime = microseconds(decodeTime, iterations);
+    std::cout << frame.path << ": "
+              << (video.mode == ast_video::YuvMode::YUV420 ? "420 " : "444 ")
+              << video.width << "x" << video.height << "\n"
+              << std::fixed << std::setprecision(1) << "  decode     "
+              << std::setw(9) << frameTime << " us/frame  " << std::setw(7)
+              << 1e6 / frameTime << " frames/s  "
+              << static_cast<double>(decodeAllocations) / iterations
+              << " allocations/frame\n"
+              << "  huffman    " << std::setw(9)
+              << microseconds(stages.entropy, iterations) << " us/frame\n"
+              << "  idct       " << std::setw(9)
+              << microseconds(stages.idct, iterations) << " us/frame\n"
+              << "  color      " << std::setw(9)
+              << microseconds(stages.color, iterations) << " us/frame\n"
+              << "  serialize  " << std::setw(9)
+              << microseconds(serializeTime, iterations) << " us/frame  "
+              << static_cast<double>(serializeAllocations) / iterations
+              << " allocations/frame\n";
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int iterations = 100;
+    size_t bands = 0;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "-n" && i + 1 < argc)
+        {
+            iterations = std::max(std::atoi(argv[++i]), 1);
+        }
+        else if (arg == "-b" && i + 1 < argc)
+        {
+            bands = static_cast<size_t>(std::atoi(argv[++i]));
+        }
+        else
+        {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.empty())
+    {
+        paths = {"test_resources/ubuntu_444_800x600_0chrom_0lum.bin",
+                 "test_resources/aspeedbluescreen.bin",
+                 "test_resources/aspeedblackscreen.bin"};
+    }
+
+    for (const std::string& path : paths)
+    {
+        Frame frame;
+        if (!load(path, frame))
+        {
+            std::cerr << "Can't read " << path << "\n";
+            return 1;
+        }
+        run(frame, iterations, bands);
+    }
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include <crow/app.h>
+
+#include <load_generator.hpp>
+#include <memory>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+using crow::load_generator::LatencyHistogram;
+using std::chrono::microseconds;
+
+TEST(LatencyHistogram, Empty)
+{
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.count(), 0u);
+    EXPECT_EQ(histogram.percentile(0.5).count(), 0);
+}
+
+TEST(LatencyHistogram, ExactForShortLatencies)
+{
+    LatencyHistogram histogram;
+    for (int us = 1; us <= 50; us++)
+    {
+        histogram.add(microseconds(us));
+    }
+    EXPECT_EQ(histogram.count(), 50u);
+    EXPECT_EQ(histogram.percentile(0.5).count(), 25);
+    EXPECT_EQ(histogram.percentile(0.99).count(), 50);
+    EXPECT_EQ(histogram.percentile(1.0).count(), 50);
+    EXPECT_EQ(histogram.max().count(), 50);
+}
+
+// Past 64us a percentile may be up to one bucket, 1/32, over
+TEST(LatencyHistogram, PercentilesWithinABucket)
+{
+    LatencyHistogram histogram;
+    for (int us = 1; us <= 100000; us++)
+    {
+        histogram.add(microseconds(us));
+    }
+    for (double fraction : {0.5, 0.9, 0.99, 0.999})
+    {
+        double exact = fraction * 100000;
+        double got =
+            static_cast<double>(histogram.percentile(fraction).count());
+        EXPECT_GE(got, exact) << fraction;
+        EXPECT_LE(got, exact * (1 + 1.0 / 32)) << fraction;
+    }
+    EXPECT_EQ(histogram.percentile(1.0).count(), 100000);
+}
+
+TEST(LatencyHistogram, Merge)
+{
+    LatencyHistogram fast;
+    LatencyHistogram slow;
+    for (int i = 0; i < 99; i++)
+    {
+        fast.add(microseconds(10));
+    }
+    slow.add(microseconds(5000000));
+    fast.merge(slow);
+    EXPECT_EQ(fast.count(), 100u);
+    EXPECT_EQ(fast.percentile(0.99).count(), 10);
+    EXPECT_EQ(fast.percentile(0.999).count(), 5000000);
+}
+
+TEST(LoadGenerator, DrivesAServer)
+{
+    constexpr uint16_t port = 45461;
+    crow::SimpleApp app;
+    BMCWEB_ROUTE(app, "/")([] { return "A"; });
+    app.validate();
+    auto io = std::make_shared<boost::asio::io_service>();
+    crow::Server<crow::SimpleApp> server(&app, "127.0.0.1", port, nullptr,
+                                         nullptr, io);
+    server.run();
+    std::thread serverThread([io] { io->run(); });
+
+    crow::load_generator::Options options;
+    options.port = port;
+    options.connections = 2;
+    options.duration = std::chrono::milliseconds(200);
+    crow::load_generator::Target target;
+    target.target = "/";
+
+    for (bool keepAlive : {true, false})
+    {
+        options.keepAlive = keepAlive;
+        crow::load_generator::Result result =
+            crow::load_generator::run(options, target);
+        EXPECT_GT(result.requests, 0u) << keepAlive;
+        EXPECT_EQ(result.errors, 0u) << keepAlive;
+        EXPECT_EQ(result.latency.count(), result.requests);
+        EXPECT_GT(result.requestsPerSecond(), 0);
+    }
+
+    // Answers that aren't 2xx or 3xx count as errors
+    options.keepAlive = true;
+    target.target = "/missing";
+    crow::load_generator::Result result =
+        crow::load_generator::run(options, target);
+    EXPECT_GT(result.requests, 0u);
+    EXPECT_EQ(result.errors, result.requests);
+
+    server.stop();
+    serverThread.join();
+}
@@ -0,0 +1,111 @@
+#include <crow/logging.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using crow::LogLevel;
+using crow::LogRing;
+
+TEST(LogRing, PopsInOrderAndRefusesWhenFull)
+{
+    LogRing ring;
+    for (size_t i = 0; i < LogRing::capacity; i++)
+    {
+        ASSERT_TRUE(ring.push(std::to_string(i), LogLevel::Info));
+    }
+    EXPECT_FALSE(ring.push("lost", LogLevel::Info));
+
+    std::string message;
+    LogLevel level;
+    ASSERT_TRUE(ring.pop(message, level));
+    EXPECT_EQ(message, "0");
+    EXPECT_EQ(level, LogLevel::Info);
+    // The freed slot takes the next record
+    EXPECT_TRUE(ring.push("again", LogLevel::Error));
+    for (size_t i = 1; i < LogRing::capacity; i++)
+    {
+        ASSERT_TRUE(ring.pop(message, level));
+        EXPECT_EQ(message, std::to_string(i));
+    }
+    ASSERT_TRUE(ring.pop(message, level));
+    EXPECT_EQ(message, "again");
+    EXPECT_EQ(level, LogLevel::Error);
+    EXPECT_FALSE(ring.pop(message, level));
+}
+
+// Tests that records pushed from several threads all come out once
+TEST(LogRing, TakesConcurrentProducers)
+{
+    LogRing ring;
+    constexpr size_t perThread = 200;
+    std::vector<std::thread> producers;
+    for (size_t t = 0; t < 4; t++)
+    {
+        producers.emplace_back([&ring, t] {
+            for (size_t i = 0; i < perThread; i++)
+            {
+                ring.push(std::to_string(t), LogLevel::Debug);
+            }
+        });
+    }
+    for (std::thread& producer : producers)
+    {
+        producer.join();
+    }
+    std::vector<size_t> counts(4);
+    std::string message;
+    LogLevel level;
+    while (ring.pop(message, level))
+    {
+        counts[std::stoul(message)]++;
+    }
+    EXPECT_THAT(counts, testing::Each(perThread));
+}
+
+// The writer sleeps while idle and wakes for the next record, and for stop()
+TEST(AsyncLogHandler, WakesForRecords)
+{
+    int pipeFds[2];
+    ASSERT_EQ(pipe(pipeFds), 0);
+    int savedStderr = dup(STDERR_FILENO);
+    dup2(pipeFds[1], STDERR_FILENO);
+
+    crow::AsyncLogHandler handler;
+    handler.start();
+    std::string read;
+    for (int i = 0; i < 3; i++)
+    {
+        // Long enough for the writer to be asleep
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        handler.log("record\n", LogLevel::Error);
+        pollfd readable{pipeFds[0], POLLIN, 0};
+        ASSERT_EQ(poll(&readable, 1, 5000), 1);
+        char buffer[64];
+        ssize_t n = ::read(pipeFds[0], buffer, sizeof(buffer));
+        ASSERT_GT(n, 0);
+        read.append(buffer, static_cast<size_t>(n));
+    }
+    handler.stop();
+
+    dup2(savedStderr, STDERR_FILENO);
+    close(savedStderr);
+    close(pipeFds[0]);
+    close(pipeFds[1]);
+    EXPECT_EQ(read, "record\nrecord\nrecord\n");
+}
+
+TEST(LogLevel, ParsesNames)
+{
+    LogLevel level = LogLevel::Debug;
+    EXPECT_TRUE(crow::parseLogLevel("WARNING", level));
+    EXPECT_EQ(level, LogLevel::Warning);
+    EXPECT_FALSE(crow::parseLogLevel("verbose", level));
+    EXPECT_FALSE(crow::parseLogLevel(nullptr, level));
+    EXPECT_EQ(level, LogLevel::Warning);
+}
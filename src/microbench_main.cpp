@@ -0,0 +1,249 @@
+#include <crow/app.h>
+
+#include <benchmark/benchmark.h>
+#include <dbus_monitor.hpp>
+#include <image_upload.hpp>
+#include <openbmc_dbus_rest.hpp>
+#include <privileges.hpp>
+#include <redfish.hpp>
+#include <redfish_v1.hpp>
+#include <server_metrics.hpp>
+#include <string>
+#include <token_authorization_middleware.hpp>
+#include <vector>
+#include <web_kvm.hpp>
+#include <webassets.hpp>
+#include <webserver_common.hpp>
+
+// Times the small functions every request goes through, on inputs like the
+// ones they see.  Run as microbench [--benchmark_filter=<regex>]; the other
+// options are Google Benchmark's.
+
+namespace
+{
+
+// The route patterns bmcweb has, registered in the order
+// src/webserver_main.cpp registers them
+const std::vector<std::string>& bmcwebRoutes()
+{
+    static const std::vector<std::string> routes = [] {
+        CrowApp app;
+#ifdef BMCWEB_ENABLE_KVM
+        crow::kvm::requestRoutes(app);
+#endif
+#ifdef BMCWEB_ENABLE_REDFISH
+        crow::redfish::requestRoutes(app);
+#endif
+#ifdef BMCWEB_ENABLE_DBUS_REST
+        crow::dbus_monitor::requestRoutes(app);
+        crow::image_upload::requestRoutes(app);
+        crow::openbmc_mapper::requestRoutes(app);
+#endif
+        crow::server_metrics::requestRoutes(app);
+        crow::token_authorization::requestRoutes(app);
+#ifdef BMCWEB_ENABLE_STATIC_HOSTING
+        crow::webassets::requestRoutes(app);
+#endif
+        redfish::RedfishService redfish(app);
+        std::vector<std::string> patterns;
+        for (const std::string* route : app.getAllRoutes())
+        {
+            patterns.push_back(*route);
+        }
+        return patterns;
+    }();
+    return routes;
+}
+
+// A trie holding the routes the way the router does
+const crow::Trie& bmcwebTrie()
+{
+    static const crow::Trie trie = [] {
+        crow::Trie built;
+        // The router's first two rule indexes are special
+        unsigned ruleIndex = 2;
+        for (const std::string& route : bmcwebRoutes())
+        {
+            built.add(route, ruleIndex);
+            if (route.size() > 2 && route.back() == '/')
+            {
+                built.add(route.substr(0, route.size() - 1), ruleIndex);
+            }
+            ruleIndex++;
+        }
+        built.validate();
+        return built;
+    }();
+    return trie;
+}
+
+void trieFind(benchmark::State& state, const char* url)
+{
+    const crow::Trie& trie = bmcwebTrie();
+    state.SetLabel(std::to_string(bmcwebRoutes().size()) + " routes");
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(trie.find(url));
+    }
+}
+BENCHMARK_CAPTURE(trieFind, serviceRoot, "/redfish/v1/");
+BENCHMARK_CAPTURE(trieFind, thermal, "/redfish/v1/Chassis/1/Thermal/");
+BENCHMARK_CAPTURE(trieFind, selEntry,
+                  "/redfish/v1/Systems/1/LogServices/SEL/Entries/1234");
+BENCHMARK_CAPTURE(trieFind, account,
+                  "/redfish/v1/AccountService/Accounts/operator");
+BENCHMARK_CAPTURE(trieFind, staticAsset, "/js/app.min.js");
+BENCHMARK_CAPTURE(trieFind, miss, "/redfish/v1/NotARoute/At/All");
+
+std::string manyParameters()
+{
+    std::string url = "/redfish/v1/Systems/1/LogServices/SEL/Entries?";
+    for (int i = 0; i < 40; i++)
+    {
+        url += "param" + std::to_string(i) + "=value%20" + std::to_string(i) +
+               "&";
+    }
+    return url + "$top=50";
+}
+
+void queryString(benchmark::State& state, std::string url)
+{
+    for (auto _ : state)
+    {
+        crow::QueryString query(url);
+        benchmark::DoNotOptimize(query.get("$top"));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                            static_cast<int64_t>(url.size()));
+}
+BENCHMARK_CAPTURE(queryString, paging,
+                  std::string("/redfish/v1/Systems/1/LogServices/SEL/"
+                              "Entries?$top=50&$skip=100"));
+BENCHMARK_CAPTURE(queryString, filter,
+                  std::string("/redfish/v1/Systems/1/LogServices/SEL/"
+                              "Entries?$filter=Severity%20eq%20%27Critical%27"
+                              "%20and%20Created%20gt%20%272019-06-01T00:00:00"
+                              "%2B00:00%27&$select=Id,Message,Created&$top=50"));
+BENCHMARK_CAPTURE(queryString, manyParameters, manyParameters());
+
+std::string basicCredentials(const std::string& user,
+                             const std::string& password)
+{
+    const std::string plain = user + ":" + password;
+    return crow::utility::base64encode(plain.data(), plain.size());
+}
+
+void base64Decode(benchmark::State& state, std::string encoded)
+{
+    std::string decoded;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(
+            crow::utility::base64Decode(encoded, decoded));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                            static_cast<int64_t>(encoded.size()));
+}
+BENCHMARK_CAPTURE(base64Decode, basicAuth,
+                  basicCredentials("root", "0penBmc"));
+BENCHMARK_CAPTURE(base64Decode, longPassword,
+                  basicCredentials(std::string(32, 'u'),
+                                   std::string(128, 'p')));
+
+// A Thermal response as the browser is sent it, about 16KB of JSON
+std::string thermalJson()
+{
+    nlohmann::json thermal = {
+        {"@odata.id", "/redfish/v1/Chassis/1/Thermal"},
+        {"@odata.type", "#Thermal.v1_4_0.Thermal"},
+        {"Id", "Thermal"},
+        {"Name", "Thermal"}};
+    nlohmann::json& temperatures = thermal["Temperatures"];
+    for (int i = 0; i < 44; i++)
+    {
+        temperatures.push_back(
+            {{"@odata.id", "/redfish/v1/Chassis/1/Thermal#/Temperatures/" +
+                               std::to_string(i)},
+             {"Name", "CPU " + std::to_string(i) + " \"Core\" <Die>"},
+             {"ReadingCelsius", 40.5 + i},
+             {"UpperThresholdNonCritical", 85},
+             {"UpperThresholdCritical", 95},
+             {"Status", {{"State", "Enabled"}, {"Health", "OK"}}}});
+    }
+    return thermal.dump(4);
+}
+
+void escapeHtml(benchmark::State& state, std::string text)
+{
+    std::string escaped;
+    for (auto _ : state)
+    {
+        escaped.clear();
+        crow::appendEscapedHtml(escaped, text);
+        benchmark::DoNotOptimize(escaped.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                            static_cast<int64_t>(text.size()));
+}
+BENCHMARK_CAPTURE(escapeHtml, thermal, thermalJson());
+
+void privilegesSuperset(benchmark::State& state)
+{
+    const redfish::Privileges admin =
+        *redfish::getPrivilegesFromUserPrivilege("priv-admin");
+    const redfish::Privileges required{"ConfigureManager"};
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(admin.isSupersetOf(required));
+    }
+}
+BENCHMARK(privilegesSuperset);
+
+// What a Node checks before calling its handler, for a user who needs
+// the second of two alternatives
+void methodAllowed(benchmark::State& state)
+{
+    const redfish::OperationMap operations = {
+        {boost::beast::http::verb::get, {{"Login"}}},
+        {boost::beast::http::verb::patch,
+         {{"ConfigureManager"}, {"ConfigureComponents"}}}};
+    const redfish::Privileges operatorPrivileges =
+        *redfish::getPrivilegesFromUserPrivilege("priv-operator");
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(redfish::isMethodAllowedWithPrivileges(
+            boost::beast::http::verb::patch, operations, operatorPrivileges));
+    }
+}
+BENCHMARK(methodAllowed);
+
+// A browser's cookies for the BMC's host, with the session cookie last
+std::string longCookies()
+{
+    std::string cookies;
+    for (int i = 0; i < 30; i++)
+    {
+        cookies += "_analytics_" + std::to_string(i) + "=GA1.2." +
+                   std::string(64, 'a' + i % 26) + "; ";
+    }
+    return cookies + "SESSION=" + std::string(20, 'x');
+}
+
+void sessionCookie(benchmark::State& state, std::string cookies)
+{
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(
+            crow::token_authorization::Middleware::findSessionCookie(
+                cookies));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                            static_cast<int64_t>(cookies.size()));
+}
+BENCHMARK_CAPTURE(sessionCookie, short,
+                  std::string("SESSION=") + std::string(20, 'x'));
+BENCHMARK_CAPTURE(sessionCookie, long, longCookies());
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,167 @@
+#include <crow/multipart_parser.h>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using crow::multipart::Parser;
+using crow::multipart::Part;
+
+namespace
+{
+
+struct CollectedPart
+{
+    Part part;
+    std::string data;
+    bool ended = false;
+};
+
+// Feeds body to a parser in pieces of at most pieceSize
+bool parseInPieces(const std::string& boundary, const std::string& body,
+                   size_t pieceSize, std::vector<CollectedPart>& parts,
+                   bool* done = nullptr)
+{
+    Parser parser(boundary);
+    parser.onPartBegin = [&parts](const Part& part) {
+        parts.push_back({part, "", false});
+        return true;
+    };
+    parser.onPartData = [&parts](const char* data, size_t size) {
+        parts.back().data.append(data, size);
+        return true;
+    };
+    parser.onPartEnd = [&parts] {
+        parts.back().ended = true;
+        return true;
+    };
+    for (size_t offset = 0; offset < body.size(); offset += pieceSize)
+    {
+        if (!parser.feed(&body[offset],
+                         std::min(pieceSize, body.size() - offset)))
+        {
+            return false;
+        }
+    }
+    if (done != nullptr)
+    {
+        *done = parser.done();
+    }
+    return true;
+}
+
+const std::string updateBody =
+    "preamble\r\n"
+    "--XyZ\r\n"
+    "Content-Disposition: form-data; name=\"UpdateParameters\"\r\n"
+    "Content-Type: application/json\r\n"
+    "\r\n"
+    "{\"Targets\": []}\r\n"
+    "--XyZ\r\n"
+    "content-disposition: form-data; name=\"UpdateFile\"; "
+    "filename=\"image.tar\"\r\n"
+    "Content-Type: application/octet-stream\r\n"
+    "\r\n"
+    "\r\n--Xy not the end\r\n-XyZ\r\n"
+    "--XyZ--\r\n"
+    "epilogue";
+
+} // namespace
+
+TEST(MultipartParser, BoundaryOf)
+{
+    EXPECT_EQ(crow::multipart::boundaryOf(
+                  "multipart/form-data; boundary=----abc123"),
+              "----abc123");
+    EXPECT_EQ(crow::multipart::boundaryOf(
+                  "Multipart/Form-Data;charset=utf-8; Boundary=\"a b\""),
+              "a b");
+    EXPECT_EQ(crow::multipart::boundaryOf("multipart/form-data"), "");
+    EXPECT_EQ(crow::multipart::boundaryOf("multipart/form-data; boundary="),
+              "");
+    EXPECT_EQ(crow::multipart::boundaryOf("application/octet-stream"), "");
+    EXPECT_EQ(crow::multipart::boundaryOf("multipart/mixed; boundary=abc"),
+              "");
+    EXPECT_EQ(crow::multipart::boundaryOf("multipart/form-data; boundary=" +
+                                          std::string(71, 'a')),
+              "");
+}
+
+// The parts come out the same however the body is split
+TEST(MultipartParser, SplitsParts)
+{
+    for (size_t pieceSize : {1, 2, 3, 7, 64, 4096})
+    {
+        std::vector<CollectedPart> parts;
+        bool done = false;
+        ASSERT_TRUE(parseInPieces("XyZ", updateBody, pieceSize, parts, &done))
+            << pieceSize;
+        EXPECT_TRUE(done);
+        ASSERT_EQ(parts.size(), 2u) << pieceSize;
+
+        EXPECT_EQ(parts[0].part.name, "UpdateParameters");
+        EXPECT_EQ(parts[0].part.filename, "");
+        EXPECT_EQ(parts[0].part.contentType, "application/json");
+        EXPECT_EQ(parts[0].data, "{\"Targets\": []}");
+        EXPECT_TRUE(parts[0].ended);
+
+        EXPECT_EQ(parts[1].part.name, "UpdateFile");
+        EXPECT_EQ(parts[1].part.filename, "image.tar");
+        EXPECT_EQ(parts[1].data, "\r\n--Xy not the end\r\n-XyZ");
+        EXPECT_TRUE(parts[1].ended);
+    }
+}
+
+TEST(MultipartParser, BodyWithoutPreamble)
+{
+    std::vector<CollectedPart> parts;
+    bool done = false;
+    ASSERT_TRUE(parseInPieces("b",
+                              "--b\r\nContent-Disposition: form-data; "
+                              "name=a\r\n\r\n1\r\n--b--",
+                              5, parts, &done));
+    EXPECT_TRUE(done);
+    ASSERT_EQ(parts.size(), 1u);
+    EXPECT_EQ(parts[0].part.name, "a");
+    EXPECT_EQ(parts[0].data, "1");
+}
+
+TEST(MultipartParser, TruncatedBodyIsNotDone)
+{
+    std::vector<CollectedPart> parts;
+    bool done = true;
+    ASSERT_TRUE(parseInPieces("XyZ", updateBody.substr(0, 200), 16, parts,
+                              &done));
+    EXPECT_FALSE(done);
+}
+
+TEST(MultipartParser, RejectsMalformedBodies)
+{
+    std::vector<CollectedPart> parts;
+    // No Content-Disposition
+    EXPECT_FALSE(parseInPieces(
+        "b", "--b\r\nContent-Type: text/plain\r\n\r\nx\r\n--b--", 4, parts));
+    // Not a form field
+    EXPECT_FALSE(parseInPieces(
+        "b", "--b\r\nContent-Disposition: attachment; name=a\r\n\r\n", 4,
+        parts));
+    // Garbage after a delimiter
+    EXPECT_FALSE(parseInPieces("b", "--bxx\r\n", 4, parts));
+    // Headers that never end
+    EXPECT_FALSE(parseInPieces(
+        "b", "--b\r\nX: " + std::string(crow::multipart::maxPartHeaderBytes,
+                                        'x'),
+        1024, parts));
+}
+
+// A handler refusing a part stops the parse for good
+TEST(MultipartParser, HandlerStopsParse)
+{
+    Parser parser("XyZ");
+    parser.onPartBegin = [](const Part& part) {
+        return part.filename.empty();
+    };
+    EXPECT_FALSE(parser.feed(updateBody.data(), updateBody.size()));
+    EXPECT_FALSE(parser.done());
+    EXPECT_FALSE(parser.feed("--XyZ--", 7));
+}
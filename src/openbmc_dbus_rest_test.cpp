@@ -0,0 +1,117 @@
+#include "openbmc_dbus_rest.hpp"
+
+#include <boost/asio/io_service.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace
+{
+
+// Stands in for the app the batch sends its operations through.  Gets
+// answer at once, sets answer later, calls fail, and it notes how deep
+// handle() calls nest.
+struct FakeApp
+{
+    boost::asio::io_service& io;
+    std::vector<std::string> handled;
+    int depth = 0;
+    int maxDepth = 0;
+
+    void handle(const crow::Request& req, crow::Response& res)
+    {
+        depth++;
+        maxDepth = std::max(maxDepth, depth);
+        handled.push_back(std::string(req.url));
+        if (req.method() == "GET"_method)
+        {
+            res.jsonValue = std::string(req.url);
+            res.end();
+        }
+        else if (req.method() == "PUT"_method)
+        {
+            std::string url(req.url);
+            io.post([&res, url]() {
+                res.jsonValue = url;
+                res.end();
+            });
+        }
+        else
+        {
+            res.result(boost::beast::http::status::not_found);
+            res.end();
+        }
+        depth--;
+    }
+};
+
+using Transaction = crow::openbmc_mapper::BatchTransaction<FakeApp>;
+
+nlohmann::json runBatch(FakeApp& app, std::vector<Transaction::Operation>&& ops)
+{
+    boost::beast::http::request<boost::beast::http::string_body> beastReq;
+    crow::Request req(beastReq);
+    req.ioService = &app.io;
+    crow::Response res;
+    bool ended = false;
+    res.setCompleteRequestHandler([&ended]() { ended = true; });
+    std::make_shared<Transaction>(app, req, res, std::move(ops))->start();
+    app.io.run();
+    EXPECT_TRUE(ended);
+    return res.jsonValue;
+}
+
+} // namespace
+
+TEST(OpenBmcDbusBatch, ResultsInOrder)
+{
+    boost::asio::io_service io;
+    FakeApp app{io};
+    std::vector<Transaction::Operation> ops;
+    ops.push_back({boost::beast::http::verb::put, "/xyz/a", "{}"});
+    ops.push_back({boost::beast::http::verb::get, "/xyz/b", ""});
+    ops.push_back({boost::beast::http::verb::post, "/xyz/c", "[]"});
+    ops.push_back({boost::beast::http::verb::put, "/xyz/d", "{}"});
+    ops.push_back({boost::beast::http::verb::get, "/xyz/e", ""});
+
+    nlohmann::json reply = runBatch(app, std::move(ops));
+    EXPECT_EQ(reply["status"], "ok");
+    const nlohmann::json& data = reply["data"];
+    ASSERT_EQ(data.size(), 5u);
+    EXPECT_EQ(data[0]["status"], 200);
+    EXPECT_EQ(data[0]["data"], "/xyz/a");
+    EXPECT_EQ(data[1]["data"], "/xyz/b");
+    EXPECT_EQ(data[2]["status"], 404);
+    EXPECT_EQ(data[3]["data"], "/xyz/d");
+    EXPECT_EQ(data[4]["status"], 200);
+    EXPECT_EQ(data[4]["data"], "/xyz/e");
+}
+
+// Operations answered at once start the next from the io_service, not from
+// inside the one that finished
+TEST(OpenBmcDbusBatch, SynchronousOperationsDontNest)
+{
+    boost::asio::io_service io;
+    FakeApp app{io};
+    std::vector<Transaction::Operation> ops;
+    for (size_t i = 0; i < crow::openbmc_mapper::maxBatchOperations; i++)
+    {
+        ops.push_back({i % 3 == 2 ? boost::beast::http::verb::post
+                                  : boost::beast::http::verb::get,
+                       "/xyz/" + std::to_string(i), ""});
+    }
+
+    nlohmann::json reply = runBatch(app, std::move(ops));
+    const nlohmann::json& data = reply["data"];
+    ASSERT_EQ(data.size(), crow::openbmc_mapper::maxBatchOperations);
+    EXPECT_EQ(app.handled.size(), crow::openbmc_mapper::maxBatchOperations);
+    EXPECT_EQ(app.maxDepth, 1);
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        EXPECT_EQ(data[i]["status"], i % 3 == 2 ? 404 : 200) << i;
+    }
+    EXPECT_EQ(data[1000]["data"], "/xyz/1000");
+}
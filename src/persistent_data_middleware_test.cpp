@@ -0,0 +1,46 @@
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <persistent_data_middleware.hpp>
+#include <sstream>
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using crow::persistent_data::writeFileAtomically;
+
+namespace
+{
+
+std::string readFile(const std::string& path)
+{
+    std::ifstream in(path);
+    std::stringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+} // namespace
+
+// Tests that the file is replaced as a whole, and readable only by its owner
+TEST(PersistentData, WriteFileAtomically)
+{
+    const std::string path =
+        "/tmp/persistent_data_test_" + std::to_string(getpid());
+    ASSERT_TRUE(writeFileAtomically(path, "{\"revision\": 1}"));
+    EXPECT_EQ(readFile(path), "{\"revision\": 1}");
+
+    ASSERT_TRUE(writeFileAtomically(path, "{}"));
+    EXPECT_EQ(readFile(path), "{}");
+    EXPECT_NE(access((path + ".tmp").c_str(), F_OK), 0);
+
+    struct stat info;
+    ASSERT_EQ(stat(path.c_str(), &info), 0);
+    EXPECT_EQ(info.st_mode & 0777, 0600u);
+    unlink(path.c_str());
+
+    // The old file is left alone when the new one can't be written
+    EXPECT_FALSE(writeFileAtomically("/nonexistent/dir/file", "{}"));
+}
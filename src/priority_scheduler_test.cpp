@@ -0,0 +1,122 @@
+#include <crow/priority_scheduler.h>
+
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using crow::Priority;
+
+// Tests that queued work runs most urgent first, in order within a priority
+TEST(PriorityScheduler, RunsMostUrgentFirst)
+{
+    boost::asio::io_service io;
+    std::vector<std::string> ran;
+    auto task = [&ran](const char* name) {
+        return [&ran, name] { ran.push_back(name); };
+    };
+
+    crow::postWithPriority(io, Priority::bulk, task("bulk1"));
+    crow::postWithPriority(io, Priority::bulk, task("bulk2"));
+    crow::postWithPriority(io, Priority::control, task("control"));
+    crow::postWithPriority(io, Priority::interactive, task("key1"));
+    crow::postWithPriority(io, Priority::interactive, task("key2"));
+    EXPECT_EQ(boost::asio::use_service<crow::PriorityScheduler>(io).size(),
+              5u);
+    EXPECT_TRUE(ran.empty());
+
+    io.run();
+    EXPECT_THAT(ran, testing::ElementsAre("key1", "key2", "control", "bulk1",
+                                          "bulk2"));
+}
+
+// Tests that a bulk slice yields to interactive work posted meanwhile
+TEST(PriorityScheduler, InteractiveOvertakesSlices)
+{
+    boost::asio::io_service io;
+    std::vector<std::string> ran;
+    int slices = 0;
+    std::function<void()> slice = [&] {
+        ran.push_back("slice");
+        if (++slices < 3)
+        {
+            crow::postWithPriority(io, Priority::bulk, slice);
+        }
+        if (slices == 1)
+        {
+            crow::postWithPriority(io, Priority::interactive,
+                                   [&ran] { ran.push_back("key"); });
+        }
+    };
+
+    crow::postWithPriority(io, Priority::bulk, slice);
+    io.run();
+    EXPECT_THAT(ran, testing::ElementsAre("slice", "key", "slice", "slice"));
+}
+
+// Tests that bulk work still runs under a steady stream of urgent work
+TEST(PriorityScheduler, BulkIsNotStarved)
+{
+    boost::asio::io_service io;
+    int urgent = 0;
+    int bulkRanAfter = -1;
+    std::function<void()> keystroke = [&] {
+        if (++urgent < 100)
+        {
+            crow::postWithPriority(io, Priority::interactive, keystroke);
+        }
+    };
+
+    crow::postWithPriority(io, Priority::bulk,
+                           [&] { bulkRanAfter = urgent; });
+    crow::postWithPriority(io, Priority::interactive, keystroke);
+    io.run();
+    EXPECT_EQ(urgent, 100);
+    EXPECT_EQ(bulkRanAfter, static_cast<int>(crow::schedulerMaxPassedOver));
+}
+
+// Tests that control and bulk work both run under steady interactive work
+TEST(PriorityScheduler, ControlIsNotStarved)
+{
+    boost::asio::io_service io;
+    int urgent = 0;
+    int controlRanAfter = -1;
+    int bulkRanAfter = -1;
+    std::function<void()> keystroke = [&] {
+        if (++urgent < 100)
+        {
+            crow::postWithPriority(io, Priority::interactive, keystroke);
+        }
+    };
+
+    crow::postWithPriority(io, Priority::bulk,
+                           [&] { bulkRanAfter = urgent; });
+    crow::postWithPriority(io, Priority::control,
+                           [&] { controlRanAfter = urgent; });
+    crow::postWithPriority(io, Priority::interactive, keystroke);
+    io.run();
+    EXPECT_EQ(urgent, 100);
+    EXPECT_EQ(controlRanAfter, static_cast<int>(crow::schedulerMaxPassedOver));
+    EXPECT_EQ(bulkRanAfter, static_cast<int>(crow::schedulerMaxPassedOver));
+}
+
+// Tests which requests are taken for bulk work
+TEST(PriorityScheduler, RequestPriority)
+{
+    EXPECT_EQ(crow::requestPriority("/login", 40), Priority::control);
+    EXPECT_EQ(crow::requestPriority("/redfish/v1/Systems/system", 0),
+              Priority::control);
+    EXPECT_EQ(crow::requestPriority("/redfish/v1/UpdateService", 1 << 20),
+              Priority::bulk);
+    EXPECT_EQ(crow::requestPriority("/redfish/v1/Chassis?$expand=.", 0),
+              Priority::bulk);
+    EXPECT_EQ(crow::requestPriority("/xyz/openbmc_project/enumerate", 0),
+              Priority::bulk);
+    EXPECT_EQ(crow::requestPriority(
+                  "/redfish/v1/Systems/system/LogServices/EventLog/Entries/",
+                  0),
+              Priority::bulk);
+    EXPECT_EQ(crow::requestPriority("/redfish/v1/Entries/1?$top=1", 0),
+              Priority::control);
+}
@@ -0,0 +1,82 @@
+#include <crow/server_metrics.h>
+
+#include <thread>
+
+#include <gtest/gtest.h>
+
+using crow::LatencyHistogram;
+using crow::RequestPhase;
+using crow::RouteMetrics;
+using std::chrono::microseconds;
+
+// Tests that a duration lands in the first bucket whose bound covers it
+TEST(ServerMetrics, HistogramBuckets)
+{
+    LatencyHistogram histogram;
+    histogram.record(microseconds(0));
+    histogram.record(microseconds(100));
+    histogram.record(microseconds(101));
+    histogram.record(microseconds(10000000));
+    histogram.record(microseconds(10000001));
+
+    EXPECT_EQ(histogram.bucket(0), 2);
+    EXPECT_EQ(histogram.bucket(1), 1);
+    EXPECT_EQ(histogram.bucket(LatencyHistogram::boundedBuckets() - 1), 1);
+    EXPECT_EQ(histogram.bucket(LatencyHistogram::boundedBuckets()), 1);
+    EXPECT_EQ(histogram.count(), 5);
+    EXPECT_EQ(histogram.sumMicroseconds(), 20000202);
+}
+
+// Tests that only the phases a request went through are recorded
+TEST(ServerMetrics, TimerRecordsEnteredPhases)
+{
+    crow::RequestTimer timer;
+    RouteMetrics metrics;
+    EXPECT_FALSE(timer.running());
+
+    timer.start();
+    EXPECT_TRUE(timer.running());
+    timer.enter(RequestPhase::auth);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    timer.enter(RequestPhase::write);
+    timer.finish(metrics);
+    EXPECT_FALSE(timer.running());
+
+    EXPECT_EQ(metrics.phases[0].count(), 1);
+    EXPECT_EQ(metrics.phases[1].count(), 1);
+    EXPECT_EQ(metrics.phases[2].count(), 0);
+    EXPECT_EQ(metrics.phases[3].count(), 1);
+    EXPECT_GE(metrics.phases[1].sumMicroseconds(), 2000);
+}
+
+// Tests the Prometheus text of a route: cumulative buckets, escaped labels
+TEST(ServerMetrics, PrometheusText)
+{
+    RouteMetrics metrics;
+    metrics.phases[2].record(microseconds(200));
+    metrics.phases[2].record(microseconds(20000000));
+
+    std::string out;
+    crow::appendRouteMetrics(out, "/a\"b", metrics);
+
+    const std::string labels = "{route=\"/a\\\"b\",phase=\"handler\"";
+    EXPECT_NE(out.find("bmcweb_request_duration_seconds_bucket" + labels +
+                       ",le=\"0.000100\"} 0\n"),
+              std::string::npos);
+    EXPECT_NE(out.find("bmcweb_request_duration_seconds_bucket" + labels +
+                       ",le=\"0.000250\"} 1\n"),
+              std::string::npos);
+    EXPECT_NE(out.find("bmcweb_request_duration_seconds_bucket" + labels +
+                       ",le=\"10.000000\"} 1\n"),
+              std::string::npos);
+    EXPECT_NE(out.find("bmcweb_request_duration_seconds_bucket" + labels +
+                       ",le=\"+Inf\"} 2\n"),
+              std::string::npos);
+    EXPECT_NE(out.find("bmcweb_request_duration_seconds_sum" + labels +
+                       "} 20.000200\n"),
+              std::string::npos);
+    EXPECT_NE(out.find("bmcweb_request_duration_seconds_count" + labels +
+                       "} 2\n"),
+              std::string::npos);
+    EXPECT_EQ(out.find("phase=\"parse\""), std::string::npos);
+}
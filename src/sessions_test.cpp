@@ -0,0 +1,92 @@
+#include <cctype>
+#include <sessions.hpp>
+#include <set>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using crow::persistent_data::PersistenceType;
+using crow::persistent_data::SessionStore;
+using crow::persistent_data::TokenEqual;
+using crow::persistent_data::TokenGenerator;
+using crow::persistent_data::UserSession;
+
+// Tests that a session is found by its token and its unique id, and by
+// neither once removed
+TEST(SessionStore, IndexesByTokenAndUid)
+{
+    SessionStore& store = SessionStore::getInstance();
+    std::shared_ptr<UserSession> session = store.generateUserSession("root");
+    std::shared_ptr<UserSession> other =
+        store.generateUserSession("root", PersistenceType::SINGLE_REQUEST);
+    EXPECT_NE(session->uniqueId, other->uniqueId);
+
+    EXPECT_EQ(store.loginSessionByToken(session->sessionToken), session);
+    EXPECT_EQ(store.getSessionByUid(session->uniqueId), session);
+    EXPECT_EQ(store.getSessionByUid(other->uniqueId), other);
+    EXPECT_EQ(store.loginSessionByToken(session->uniqueId), nullptr);
+    EXPECT_EQ(store.getSessionByUid(session->sessionToken), nullptr);
+
+    store.removeSession(session);
+    EXPECT_EQ(store.loginSessionByToken(session->sessionToken), nullptr);
+    EXPECT_EQ(store.getSessionByUid(session->uniqueId), nullptr);
+    EXPECT_EQ(store.getSessionByUid(other->uniqueId), other);
+
+    // Removing twice is harmless
+    store.removeSession(session);
+    store.removeSession(other);
+    EXPECT_EQ(store.getSessionByUid(other->uniqueId), nullptr);
+}
+
+// Tests that sessions expire once idle for the timeout, and that using one
+// pushes its expiry back
+TEST(SessionStore, Expiry)
+{
+    SessionStore& store = SessionStore::getInstance();
+    std::chrono::seconds timeout(store.getTimeoutInSeconds());
+    std::shared_ptr<UserSession> idle = store.generateUserSession("root");
+    std::shared_ptr<UserSession> used = store.generateUserSession("root");
+    std::chrono::steady_clock::time_point start = idle->lastUpdated;
+
+    store.expireSessions(start + timeout - std::chrono::seconds(1));
+    EXPECT_EQ(store.getSessionByUid(idle->uniqueId), idle);
+
+    // Pretend used was logged into half way through
+    used->lastUpdated = start + timeout / 2;
+    store.expireSessions(start + timeout);
+    EXPECT_EQ(store.getSessionByUid(idle->uniqueId), nullptr);
+    EXPECT_EQ(store.getSessionByUid(used->uniqueId), used);
+
+    store.expireSessions(start + timeout / 2 + timeout);
+    EXPECT_EQ(store.getSessionByUid(used->uniqueId), nullptr);
+    EXPECT_EQ(store.loginSessionByToken(used->sessionToken), nullptr);
+}
+
+TEST(SessionStore, TokenEqual)
+{
+    TokenEqual equal;
+    EXPECT_TRUE(equal("abcdef", "abcdef"));
+    EXPECT_FALSE(equal("abcdef", "abcdeg"));
+    EXPECT_FALSE(equal("abcdef", "abcde"));
+    EXPECT_TRUE(equal("", ""));
+}
+
+// Tests that tokens have the requested length, use only alphanumerics, and
+// draw on the whole alphabet
+TEST(SessionStore, TokenGenerator)
+{
+    TokenGenerator generator;
+    std::set<char> seen;
+    for (int i = 0; i < 100; i++)
+    {
+        std::string token = generator.generate(20);
+        ASSERT_EQ(token.size(), 20u);
+        for (char c : token)
+        {
+            ASSERT_TRUE(std::isalnum(static_cast<unsigned char>(c)));
+            seen.insert(c);
+        }
+    }
+    EXPECT_EQ(seen.size(), 62u);
+    EXPECT_NE(generator.generate(20), generator.generate(20));
+}
@@ -0,0 +1,148 @@
+#include <signal_store.hpp>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+using crow::connections::SignalDispatcher;
+using crow::connections::SignalStore;
+
+namespace
+{
+
+// A store of the names of the objects under /test, whose loads finish when
+// the test says
+class TestStore
+{
+  public:
+    TestStore() :
+        store(listener(), [this](uint64_t generation) {
+            loads.push_back(generation);
+        })
+    {
+    }
+
+    SignalDispatcher::Listener listener()
+    {
+        SignalDispatcher::Listener listener;
+        listener.objectChanged = [this](const std::string& path) {
+            if (path.compare(0, 6, "/test/") == 0)
+            {
+                store.invalidate();
+            }
+        };
+        return listener;
+    }
+
+    // Finishes the last load, having read names
+    void finish(bool ok, const std::vector<std::string>& names)
+    {
+        store.data() = names;
+        store.finish(ok, loads.back());
+    }
+
+    std::vector<uint64_t> loads;
+    SignalStore<std::vector<std::string>> store;
+};
+
+struct Result
+{
+    bool called = false;
+    bool ok = false;
+    std::vector<std::string> names;
+};
+
+std::function<void(bool, const std::vector<std::string>&)>
+    record(Result& result)
+{
+    return [&result](bool ok, const std::vector<std::string>& names) {
+        result.called = true;
+        result.ok = ok;
+        result.names = names;
+    };
+}
+
+} // namespace
+
+TEST(SignalStore, LoadsOnceForEveryoneWaiting)
+{
+    TestStore test;
+    EXPECT_TRUE(test.loads.empty());
+    Result first;
+    Result second;
+    test.store.get(record(first));
+    test.store.get(record(second));
+    ASSERT_EQ(test.loads.size(), 1u);
+    EXPECT_FALSE(first.called);
+
+    test.finish(true, {"a"});
+    EXPECT_TRUE(first.ok);
+    EXPECT_THAT(second.names, testing::ElementsAre("a"));
+    EXPECT_TRUE(test.store.ready());
+
+    // Served from memory now
+    Result third;
+    test.store.get(record(third));
+    EXPECT_THAT(third.names, testing::ElementsAre("a"));
+    EXPECT_EQ(test.loads.size(), 1u);
+    test.store.stop();
+}
+
+TEST(SignalStore, ChangeDuringLoadIsNotKept)
+{
+    TestStore test;
+    Result waiting;
+    test.store.get(record(waiting));
+    // Subscribed before the load, so this isn't missed
+    crow::connections::signalDispatcher().notifyObjectChanged("/test/b");
+    test.finish(true, {"a"});
+
+    // Those waiting get what was read; the next request loads again
+    EXPECT_TRUE(waiting.ok);
+    EXPECT_THAT(waiting.names, testing::ElementsAre("a"));
+    EXPECT_FALSE(test.store.ready());
+    EXPECT_TRUE(test.store.data().empty());
+    Result next;
+    test.store.get(record(next));
+    ASSERT_EQ(test.loads.size(), 2u);
+    EXPECT_NE(test.loads[0], test.loads[1]);
+    test.finish(true, {"a", "b"});
+    EXPECT_THAT(next.names, testing::ElementsAre("a", "b"));
+    EXPECT_TRUE(test.store.ready());
+    test.store.stop();
+}
+
+TEST(SignalStore, DroppedByChangeOrFailure)
+{
+    TestStore test;
+    Result result;
+    test.store.get(record(result));
+    test.finish(false, {});
+    EXPECT_TRUE(result.called);
+    EXPECT_FALSE(result.ok);
+    EXPECT_FALSE(test.store.ready());
+
+    test.store.get(record(result));
+    test.finish(true, {"a"});
+    crow::connections::signalDispatcher().notifyObjectChanged("/other/a");
+    EXPECT_TRUE(test.store.ready());
+    crow::connections::signalDispatcher().notifyObjectChanged("/test/a");
+    EXPECT_FALSE(test.store.ready());
+    EXPECT_TRUE(test.store.data().empty());
+
+    test.store.stop();
+}
+
+TEST(SignalStore, StopUnsubscribes)
+{
+    {
+        TestStore test;
+        Result result;
+        test.store.get(record(result));
+        test.finish(true, {"a"});
+        test.store.stop();
+        EXPECT_FALSE(test.store.ready());
+    }
+    // Would call the store that's gone
+    crow::connections::signalDispatcher().notifyObjectChanged("/test/a");
+}
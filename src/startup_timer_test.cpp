@@ -0,0 +1,21 @@
+#include <startup_timer.hpp>
+
+#include <thread>
+
+#include <gtest/gtest.h>
+
+TEST(StartupTimer, TimesEachPhase)
+{
+    crow::StartupTimer timer;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    timer.phase("first");
+    timer.phase("second");
+
+    ASSERT_EQ(timer.phaseTimes().size(), 2u);
+    EXPECT_EQ(timer.phaseTimes()[0].first, "first");
+    EXPECT_GE(timer.phaseTimes()[0].second, 20u);
+    // From the end of the one before, not from the start
+    EXPECT_LT(timer.phaseTimes()[1].second, 20u);
+    EXPECT_GE(timer.sinceStart(), 20u);
+    EXPECT_GE(crow::StartupTimer::sinceBoot(), timer.sinceStart());
+}
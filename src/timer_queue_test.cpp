@@ -0,0 +1,86 @@
+#include <crow/timer_queue.h>
+
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using crow::detail::TimerQueue;
+using namespace std::chrono_literals;
+
+// Tests that timers fire once their own timeout has elapsed, and not before
+TEST(TimerQueue, FiresAfterTimeout)
+{
+    TimerQueue::clock::time_point start = TimerQueue::clock::now();
+    TimerQueue queue(start);
+    std::vector<int> fired;
+
+    queue.add([&fired] { fired.push_back(1); }, 1s);
+    queue.add([&fired] { fired.push_back(2); }, 250ms);
+    queue.add([&fired] { fired.push_back(3); }, 10min);
+    EXPECT_EQ(queue.size(), 3u);
+
+    queue.process(start + 200ms);
+    EXPECT_TRUE(fired.empty());
+
+    queue.process(start + 300ms);
+    EXPECT_THAT(fired, testing::ElementsAre(2));
+
+    queue.process(start + 1s);
+    EXPECT_THAT(fired, testing::ElementsAre(2, 1));
+
+    // Has to cascade down from the coarser levels of the wheel
+    queue.process(start + 10min - 100ms);
+    EXPECT_THAT(fired, testing::ElementsAre(2, 1));
+    queue.process(start + 10min);
+    EXPECT_THAT(fired, testing::ElementsAre(2, 1, 3));
+    EXPECT_EQ(queue.size(), 0u);
+}
+
+// Tests that cancelled and stale timer ids are handled
+TEST(TimerQueue, Cancel)
+{
+    TimerQueue::clock::time_point start = TimerQueue::clock::now();
+    TimerQueue queue(start);
+    int fired = 0;
+
+    TimerQueue::TimerId first = queue.add([&fired] { fired++; }, 1s);
+    queue.cancel(first);
+    EXPECT_EQ(queue.size(), 0u);
+
+    // Reuses the slot of the cancelled timer; the old id must not cancel it
+    TimerQueue::TimerId second = queue.add([&fired] { fired++; }, 1s);
+    EXPECT_NE(first, second);
+    queue.cancel(first);
+    queue.cancel(0);
+    EXPECT_EQ(queue.size(), 1u);
+
+    queue.process(start + 5s);
+    EXPECT_EQ(fired, 1);
+    queue.cancel(second);
+    EXPECT_EQ(queue.size(), 0u);
+}
+
+// Tests that callbacks may add and cancel timers
+TEST(TimerQueue, ReentrantCallbacks)
+{
+    TimerQueue::clock::time_point start = TimerQueue::clock::now();
+    TimerQueue queue(start);
+    std::vector<int> fired;
+    TimerQueue::TimerId victim =
+        queue.add([&fired] { fired.push_back(2); }, 600ms);
+
+    queue.add(
+        [&] {
+            fired.push_back(1);
+            queue.cancel(victim);
+            queue.add([&fired] { fired.push_back(3); }, 0ms);
+        },
+        500ms);
+
+    queue.process(start + 500ms);
+    EXPECT_THAT(fired, testing::ElementsAre(1));
+    queue.process(start + 1s);
+    EXPECT_THAT(fired, testing::ElementsAre(1, 3));
+    EXPECT_EQ(queue.size(), 0u);
+}
@@ -319,4 +319,81 @@ TEST(TokenAuthentication, TestSuccessfulLogin)
     }
 
     app.stop();
-}
\ No newline at end of file
+}
+TEST(TokenAuthentication, PerfectHashSetFindsEveryKeyAndNothingElse)
+{
+    std::vector<std::string> keys;
+    for (int i = 0; i < 500; i++)
+    {
+        keys.push_back("/static/js/file" + std::to_string(i) + ".js");
+    }
+    crow::token_authorization::PerfectHashSet set;
+    set.build(keys);
+    for (const std::string& key : keys)
+    {
+        EXPECT_TRUE(set.contains(key));
+    }
+    EXPECT_FALSE(set.contains("/static/js/file500.js"));
+    EXPECT_FALSE(set.contains(""));
+
+    crow::token_authorization::PerfectHashSet empty;
+    empty.build({});
+    EXPECT_FALSE(empty.contains("/"));
+}
+
+TEST(TokenAuthentication, WhitelistMatchesMethodAndUrl)
+{
+    crow::token_authorization::Whitelist whitelist;
+    whitelist.build({"/index.html"});
+    EXPECT_TRUE(whitelist.contains("GET"_method, "/redfish/v1/"));
+    EXPECT_TRUE(whitelist.contains("GET"_method, "/index.html"));
+    EXPECT_FALSE(whitelist.contains("GET"_method, "/redfish/v1/Systems"));
+    EXPECT_FALSE(whitelist.contains("POST"_method, "/index.html"));
+    EXPECT_TRUE(whitelist.contains("POST"_method, "/login"));
+    EXPECT_FALSE(whitelist.contains("DELETE"_method, "/login"));
+}
+
+// Tests that a client on the Unix socket without credentials is let in only
+// as a user the user manager knows, and keeps one session per connection
+TEST(TokenAuthentication, LocalUserNeedsKnownUser)
+{
+    redfish::UserPrivilegeStore& users = redfish::userPrivilegeStore();
+    users.clear();
+    token_authorization::Middleware middleware;
+    boost::beast::http::request<boost::beast::http::string_body> r{
+        boost::beast::http::verb::get, "/redfish/v1/Systems", 11};
+    std::shared_ptr<void> connectionSession;
+
+    auto authenticate = [&](const std::string& localUser) {
+        crow::Request req{r};
+        req.url = "/redfish/v1/Systems";
+        req.localUser = localUser;
+        req.localSession = &connectionSession;
+        crow::Response res;
+        token_authorization::Middleware::Context ctx;
+        middleware.beforeHandle(req, res, ctx);
+        return ctx.session;
+    };
+
+    // Before the users are read, no one is known
+    EXPECT_EQ(authenticate("alice"), nullptr);
+
+    redfish::UserPrivilegeStore::ManagedObjects objects;
+    objects.emplace_back(
+        sdbusplus::message::object_path("/xyz/openbmc_project/user/alice"),
+        redfish::UserPrivilegeStore::Interfaces{
+            {"xyz.openbmc_project.User.Attributes",
+             {{"UserPrivilege", std::string("priv-admin")}}}});
+    users.setUsers(objects);
+
+    EXPECT_EQ(authenticate("mallory"), nullptr);
+    std::shared_ptr<persistent_data::UserSession> first =
+        authenticate("alice");
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(first->username, "alice");
+    EXPECT_EQ(authenticate("alice"), first);
+
+    users.remove("/xyz/openbmc_project/user/alice");
+    EXPECT_EQ(authenticate("alice"), nullptr);
+    users.clear();
+}
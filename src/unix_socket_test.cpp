@@ -0,0 +1,228 @@
+#include <dirent.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <crow/app.h>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+
+// A listening Unix socket, the way systemd would hand one over
+int listenOn(const std::string& path)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    if (fd < 0 ||
+        bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) !=
+            0 ||
+        listen(fd, 4) != 0)
+    {
+        return -1;
+    }
+    return fd;
+}
+
+// Turns away requests without an X-Allow header, as the auth middleware
+// turns away requests without credentials
+struct AllowHeaderMiddleware
+{
+    struct Context
+    {
+    };
+
+    void beforeHandle(crow::Request& req, crow::Response& res, Context&)
+    {
+        if (req.getHeaderValue("X-Allow").empty())
+        {
+            uploadsWhenRejected = crow::uploadRegistry().active().size();
+            res.result(boost::beast::http::status::unauthorized);
+            res.end();
+        }
+    }
+
+    void afterHandle(crow::Request&, crow::Response&, Context&)
+    {
+        afterHandles++;
+    }
+
+    int afterHandles = 0;
+    size_t uploadsWhenRejected = 0;
+};
+
+size_t filesIn(const std::string& directory)
+{
+    size_t count = 0;
+    DIR* dir = opendir(directory.c_str());
+    while (dir != nullptr)
+    {
+        dirent* entry = readdir(dir);
+        if (entry == nullptr)
+        {
+            closedir(dir);
+            break;
+        }
+        if (entry->d_name[0] != '.')
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+} // namespace
+
+TEST(UnixSocket, UserNameOf)
+{
+    EXPECT_EQ(crow::userNameOf(0), "root");
+}
+
+// Admission control counts local clients by the uid they run as
+TEST(UnixSocket, ClientAddressIsPerUid)
+{
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    boost::asio::io_service io;
+    crow::UnixSocketAdaptor adaptor(io, nullptr);
+    adaptor.socketCls.assign(boost::asio::local::stream_protocol(), fds[0]);
+
+    boost::system::error_code ec;
+    boost::asio::ip::address address = adaptor.remoteAddress(ec);
+    EXPECT_FALSE(ec);
+    boost::asio::ip::address_v6::bytes_type expected{};
+    expected[0] = 0x01;
+    uint32_t uid = getuid();
+    expected[12] = static_cast<unsigned char>(uid >> 24);
+    expected[13] = static_cast<unsigned char>(uid >> 16);
+    expected[14] = static_cast<unsigned char>(uid >> 8);
+    expected[15] = static_cast<unsigned char>(uid);
+    EXPECT_EQ(address, boost::asio::ip::address(
+                           boost::asio::ip::address_v6(expected)));
+    EXPECT_EQ(adaptor.localUser(), crow::userNameOf(getuid()));
+    close(fds[1]);
+}
+
+// Requests over the socket carry the user the client runs as
+TEST(UnixSocket, RequestsCarryPeerUser)
+{
+    const std::string path =
+        "/tmp/bmcweb_unix_socket_test." + std::to_string(getpid());
+    unlink(path.c_str());
+    int fd = listenOn(path);
+    ASSERT_GE(fd, 0);
+
+    crow::SimpleApp app;
+    BMCWEB_ROUTE(app, "/whoami")
+    ([](const crow::Request& req) { return "user:" + req.localUser; });
+    app.validate();
+    auto io = std::make_shared<boost::asio::io_service>();
+    crow::Server<crow::SimpleApp, crow::UnixSocketAdaptor> server(
+        &app, fd, nullptr, nullptr, io);
+    server.run();
+    std::thread serverThread([io] { io->run(); });
+
+    boost::asio::io_service clientIo;
+    boost::asio::local::stream_protocol::socket client(clientIo);
+    client.connect(boost::asio::local::stream_protocol::endpoint(path));
+    const std::string request = "GET /whoami HTTP/1.1\r\nHost: localhost\r\n"
+                                "Connection: close\r\n\r\n";
+    boost::asio::write(client, boost::asio::buffer(request));
+    std::string response;
+    boost::system::error_code ec;
+    boost::asio::read(client, boost::asio::dynamic_buffer(response), ec);
+
+    server.stop();
+    serverThread.join();
+    unlink(path.c_str());
+
+    EXPECT_EQ(response.compare(0, 12, "HTTP/1.1 200"), 0) << response;
+    EXPECT_NE(response.find("user:" + crow::userNameOf(getuid())),
+              std::string::npos)
+        << response;
+}
+
+// A body that goes to a file is only read once the middlewares let its
+// request through on the headers
+TEST(UnixSocket, BodyFileAfterMiddlewares)
+{
+    const std::string path =
+        "/tmp/bmcweb_unix_socket_test." + std::to_string(getpid());
+    unlink(path.c_str());
+    int fd = listenOn(path);
+    ASSERT_GE(fd, 0);
+    char directoryTemplate[] = "/tmp/bmcweb_upload_test.XXXXXX";
+    ASSERT_NE(mkdtemp(directoryTemplate), nullptr);
+    const std::string directory = directoryTemplate;
+
+    using App = crow::App<AllowHeaderMiddleware>;
+    App app;
+    std::string uploaded;
+    size_t uploads = 0;
+    BMCWEB_ROUTE(app, "/upload")
+        .streamBodyToFile(directory)
+        .methods("POST"_method)(
+            [&uploaded, &uploads, &directory](const crow::Request& req) {
+                uploaded = req.bodyFile;
+                uploads = crow::uploadRegistry().active().size();
+                return std::to_string(filesIn(directory));
+            });
+    app.validate();
+    auto io = std::make_shared<boost::asio::io_service>();
+    std::tuple<AllowHeaderMiddleware> middlewares;
+    crow::Server<App, crow::UnixSocketAdaptor, AllowHeaderMiddleware> server(
+        &app, fd, &middlewares, nullptr, io);
+    server.run();
+    std::thread serverThread([io] { io->run(); });
+
+    // Should the body be waited for, the wait is short
+    crow::KeepAlivePolicy oldPolicy = crow::connectionReuse().policy();
+    crow::KeepAlivePolicy policy = oldPolicy;
+    policy.bodyReadTimeout = std::chrono::seconds(1);
+    crow::connectionReuse().setPolicy(policy);
+
+    auto post = [&path](const std::string& headers,
+                        const std::string& body) {
+        boost::asio::io_service clientIo;
+        boost::asio::local::stream_protocol::socket client(clientIo);
+        client.connect(boost::asio::local::stream_protocol::endpoint(path));
+        const std::string request = "POST /upload HTTP/1.1\r\n"
+                                    "Host: localhost\r\n" +
+                                    headers +
+                                    "Content-Length: 5\r\n"
+                                    "Connection: close\r\n\r\n" +
+                                    body;
+        boost::asio::write(client, boost::asio::buffer(request));
+        std::string response;
+        boost::system::error_code ec;
+        boost::asio::read(client, boost::asio::dynamic_buffer(response), ec);
+        return response;
+    };
+
+    // Turned away without the body ever being sent
+    std::string rejected = post("", "");
+    std::string accepted = post("X-Allow: yes\r\n", "hello");
+    crow::connectionReuse().setPolicy(oldPolicy);
+
+    server.stop();
+    serverThread.join();
+    unlink(path.c_str());
+    size_t left = filesIn(directory);
+    rmdir(directory.c_str());
+
+    EXPECT_EQ(rejected.compare(0, 12, "HTTP/1.1 401"), 0) << rejected;
+    EXPECT_EQ(accepted.compare(0, 12, "HTTP/1.1 200"), 0) << accepted;
+    // The one file, while the handler ran
+    EXPECT_EQ(accepted.substr(accepted.size() - 1), "1") << accepted;
+    EXPECT_EQ(uploaded.compare(0, directory.size(), directory), 0);
+    EXPECT_EQ(left, 0u);
+    EXPECT_EQ(std::get<0>(middlewares).afterHandles, 2);
+    // Only the upload that was let through was ever listed
+    EXPECT_EQ(std::get<0>(middlewares).uploadsWhenRejected, 0u);
+    EXPECT_EQ(uploads, 1u);
+    EXPECT_TRUE(crow::uploadRegistry().active().empty());
+}
@@ -132,9 +132,9 @@ TEST(Webassets, EtagIsSane)
             auto etag = this_string.substr(6);
             // ETAG should not be blank
             EXPECT_NE(etag, "");
-            // SHa1 is 20 characters long
-            EXPECT_EQ(etag.size(), 40);
-            EXPECT_THAT(etag, MatchesRegex("^[a-f0-9]+$"));
+            // SHa1 is 20 bytes long, hex encoded and quoted
+            EXPECT_EQ(etag.size(), 42);
+            EXPECT_THAT(etag, MatchesRegex("^\"[a-f0-9]+\"$"));
         }
 
         headers.push_back(this_string);
@@ -143,3 +143,37 @@ TEST(Webassets, EtagIsSane)
 
     server.stop();
 }
+
+TEST(Webassets, EtagMatches)
+{
+    std::string etag = "\"aaf4c61ddcc5e8a2dabede0f3b482cd9aea9434d\"";
+    EXPECT_TRUE(webassets::etagMatches(etag, etag));
+    EXPECT_TRUE(webassets::etagMatches("*", etag));
+    EXPECT_TRUE(webassets::etagMatches("\"abc\", W/" + etag, etag));
+    EXPECT_TRUE(webassets::etagMatches(etag, "W/" + etag));
+    EXPECT_FALSE(webassets::etagMatches("\"abc\"", etag));
+    EXPECT_FALSE(webassets::etagMatches("", etag));
+}
+
+// Tests that the manifest finds exactly the URLs it lists
+TEST(Webassets, FindAsset)
+{
+    constexpr std::array<webassets::StaticAsset, 3> assets{{
+        {"/", "/index.html.gz", "text/html;charset=UTF-8", "gzip", 10,
+         "\"a\"", false},
+        {"/app.3f2a9c1b.js", "/app.3f2a9c1b.js", "text/html;charset=UTF-8",
+         nullptr, 20, "\"b\"", true},
+        {"/redfish/v1/odata", "/redfish/v1/odata/index.json",
+         "application/json", nullptr, 30, "\"c\"", false},
+    }};
+
+    const webassets::StaticAsset* asset = webassets::findAsset(assets, "/");
+    ASSERT_NE(asset, nullptr);
+    EXPECT_STREQ(asset->file, "/index.html.gz");
+    asset = webassets::findAsset(assets, "/redfish/v1/odata");
+    ASSERT_NE(asset, nullptr);
+    EXPECT_EQ(asset->size, 30u);
+    EXPECT_EQ(webassets::findAsset(assets, "/app"), nullptr);
+    EXPECT_EQ(webassets::findAsset(assets, "/redfish/v1/odata/"), nullptr);
+    EXPECT_EQ(webassets::findAsset(assets, "/zzz"), nullptr);
+}
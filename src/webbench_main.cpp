@@ -0,0 +1,645 @@
+#include <crow/app.h>
+#include <systemd/sd-bus.h>
+
+#include <algorithm>
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <dbus_monitor.hpp>
+#include <dbus_singleton.hpp>
+#include <dbus_utility.hpp>
+#include <fstream>
+#include <future>
+#include <image_upload.hpp>
+#include <iomanip>
+#include <iostream>
+#include <load_generator.hpp>
+#include <map>
+#include <memory>
+#include <openbmc_dbus_rest.hpp>
+#include <persistent_data_middleware.hpp>
+#include <redfish.hpp>
+#include <redfish_v1.hpp>
+#include <sdbusplus/asio/connection.hpp>
+#include <sdbusplus/asio/object_server.hpp>
+#include <sdbusplus/server/manager.hpp>
+#include <security_headers_middleware.hpp>
+#include <server_metrics.hpp>
+#include <signal_dispatcher.hpp>
+#include <string>
+#include <thread>
+#include <token_authorization_middleware.hpp>
+#include <vector>
+#include <webassets.hpp>
+#include <webserver_common.hpp>
+
+// Serves the routes of bmcweb from this process, with the D-Bus services
+// they read mocked from memory, and measures them under load from clients
+// in this process too.  The mocks and bmcweb's own D-Bus connection go on
+// the user bus, so run it as
+//
+//   dbus-run-session -- webbench [-c connections] [-d seconds]
+//       [-m keepalive|close|both] [-s scenario]... [-u user:password]
+//       [-a static-url] [-p port] [-j results.jsonl]
+//
+// from a scratch directory: sessions are written there, as bmcweb writes
+// them to its working directory.  Each scenario runs for -d seconds after a
+// second of warm up, in each connection mode.  -j appends one JSON object
+// per run, for tracking the numbers over time.  The RSS reported is the
+// process's, so it includes the mocks and the clients; both stay about the
+// same size however long a run is.  login only runs with -u, as it goes
+// through PAM with a real account.
+
+namespace
+{
+
+constexpr const char* benchUser = "root";
+// About what a two socket server shows
+constexpr size_t temperatureSensors = 32;
+constexpr size_t fanSensors = 12;
+constexpr size_t selEntries = 500;
+
+struct MockObject
+{
+    std::string path;
+    std::string service;
+    std::vector<std::string> interfaces;
+};
+
+using SubTree =
+    std::map<std::string, std::map<std::string, std::vector<std::string>>>;
+
+// The ObjectMapper, over a fixed set of objects
+class MockMapper
+{
+  public:
+    void add(MockObject object)
+    {
+        objects.push_back(std::move(object));
+    }
+
+    void serve(sdbusplus::asio::object_server& server)
+    {
+        std::shared_ptr<sdbusplus::asio::dbus_interface> mapper =
+            server.add_interface("/xyz/openbmc_project/object_mapper",
+                                 "xyz.openbmc_project.ObjectMapper");
+        mapper->register_method(
+            "GetSubTree",
+            [this](const std::string& root, int32_t depth,
+                   const std::vector<std::string>& interfaces) -> SubTree {
+                return subTree(root, depth, interfaces);
+            });
+        mapper->register_method(
+            "GetSubTreePaths",
+            [this](const std::string& root, int32_t depth,
+                   const std::vector<std::string>& interfaces)
+                -> std::vector<std::string> {
+                std::vector<std::string> paths;
+                for (const std::pair<const std::string,
+                                     SubTree::mapped_type>& object :
+                     subTree(root, depth, interfaces))
+                {
+                    paths.push_back(object.first);
+                }
+                return paths;
+            });
+        mapper->register_method(
+            "GetObject",
+            [this](const std::string& path,
+                   const std::vector<std::string>& interfaces)
+                -> SubTree::mapped_type {
+                SubTree found = subTree(path, -1, interfaces);
+                auto it = found.find(path);
+                return it == found.end() ? SubTree::mapped_type()
+                                         : it->second;
+            });
+        mapper->initialize();
+    }
+
+  private:
+    // Depth -1 only takes root itself, 0 everything under it
+    SubTree subTree(const std::string& root, int32_t depth,
+                    const std::vector<std::string>& interfaces) const
+    {
+        std::string prefix = root == "/" ? "" : root;
+        SubTree result;
+        for (const MockObject& object : objects)
+        {
+            if (object.path.compare(0, prefix.size(), prefix) != 0)
+            {
+                continue;
+            }
+            const std::string below = object.path.substr(prefix.size());
+            const int32_t levels = static_cast<int32_t>(
+                std::count(below.begin(), below.end(), '/'));
+            if ((depth < 0 && !below.empty()) ||
+                (depth >= 0 && (below.empty() || below[0] != '/' ||
+                                (depth > 0 && levels > depth))))
+            {
+                continue;
+            }
+            std::vector<std::string> matched;
+            for (const std::string& interface : object.interfaces)
+            {
+                if (interfaces.empty() ||
+                    std::find(interfaces.begin(), interfaces.end(),
+                              interface) != interfaces.end())
+                {
+                    matched.push_back(interface);
+                }
+            }
+            if (!matched.empty())
+            {
+                std::vector<std::string>& served =
+                    result[object.path][object.service];
+                served.insert(served.end(), matched.begin(), matched.end());
+            }
+        }
+        return result;
+    }
+
+    std::vector<MockObject> objects;
+};
+
+// A connection to the user bus, which the mocks are served on
+std::shared_ptr<sdbusplus::asio::connection>
+    connectUserBus(boost::asio::io_service& io)
+{
+    sd_bus* bus = nullptr;
+    if (sd_bus_open_user(&bus) < 0)
+    {
+        return nullptr;
+    }
+    auto connection = std::make_shared<sdbusplus::asio::connection>(io, bus);
+    sd_bus_unref(bus);
+    return connection;
+}
+
+/**
+ * @brief The services the benchmarked routes call: the mapper, a sensor
+ *        daemon, the logging service and the user manager
+ *
+ * Each has a connection of its own, so each has its own well known name,
+ * as they would on a BMC.
+ */
+class MockServices
+{
+  public:
+    bool start(boost::asio::io_service& io)
+    {
+        const std::string sensorService = "xyz.openbmc_project.Bench.Sensors";
+        auto mapperBus = connectUserBus(io);
+        auto sensorBus = connectUserBus(io);
+        auto loggingBus = connectUserBus(io);
+        auto userBus = connectUserBus(io);
+        if (mapperBus == nullptr || sensorBus == nullptr ||
+            loggingBus == nullptr || userBus == nullptr)
+        {
+            return false;
+        }
+        connections = {mapperBus, sensorBus, loggingBus, userBus};
+
+        sensorBus->request_name(sensorService.c_str());
+        servers.push_back(
+            std::make_unique<sdbusplus::asio::object_server>(sensorBus));
+        addManager(*sensorBus, "/xyz/openbmc_project/sensors");
+        for (size_t i = 0; i < temperatureSensors; i++)
+        {
+            addSensor(*servers.back(), sensorService, "temperature",
+                      "Temp" + std::to_string(i), 40.0 + i % 20, 0, 125);
+        }
+        for (size_t i = 0; i < fanSensors; i++)
+        {
+            addSensor(*servers.back(), sensorService, "fan_tach",
+                      "Fan" + std::to_string(i), 6000.0 + 100 * i, 0, 20000);
+        }
+
+        loggingBus->request_name("xyz.openbmc_project.Logging");
+        servers.push_back(
+            std::make_unique<sdbusplus::asio::object_server>(loggingBus));
+        addManager(*loggingBus, "/xyz/openbmc_project/logging");
+        const uint64_t now = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch())
+                .count());
+        for (size_t i = 1; i <= selEntries; i++)
+        {
+            addLogEntry(*servers.back(), static_cast<uint32_t>(i),
+                        now - (selEntries - i) * 60000);
+        }
+
+        userBus->request_name("xyz.openbmc_project.User.Manager");
+        servers.push_back(
+            std::make_unique<sdbusplus::asio::object_server>(userBus));
+        addManager(*userBus, "/xyz/openbmc_project/user");
+        std::shared_ptr<sdbusplus::asio::dbus_interface> user =
+            servers.back()->add_interface(
+                std::string("/xyz/openbmc_project/user/") + benchUser,
+                "xyz.openbmc_project.User.Attributes");
+        user->register_property("UserPrivilege", std::string("priv-admin"));
+        user->register_property("UserEnabled", true);
+        user->register_property("UserLockedForFailedAttempt", false);
+        user->register_property(
+            "UserGroups", std::vector<std::string>{"redfish", "web", "ipmi"});
+        user->initialize();
+        interfaces.push_back(user);
+        mapper.add({std::string("/xyz/openbmc_project/user/") + benchUser,
+                    "xyz.openbmc_project.User.Manager",
+                    {"xyz.openbmc_project.User.Attributes"}});
+
+        // Last, so every object is in it before anything can ask
+        mapperBus->request_name("xyz.openbmc_project.ObjectMapper");
+        servers.push_back(
+            std::make_unique<sdbusplus::asio::object_server>(mapperBus));
+        mapper.serve(*servers.back());
+        return true;
+    }
+
+    void stop()
+    {
+        interfaces.clear();
+        managers.clear();
+        servers.clear();
+        connections.clear();
+    }
+
+  private:
+    // So GetManagedObjects can be called on path
+    void addManager(sdbusplus::bus::bus& bus, const char* path)
+    {
+        managers.push_back(
+            std::make_unique<sdbusplus::server::manager::manager>(bus, path));
+    }
+
+    void addSensor(sdbusplus::asio::object_server& server,
+                   const std::string& service, const std::string& type,
+                   const std::string& name, double value, double min,
+                   double max)
+    {
+        const std::string path =
+            "/xyz/openbmc_project/sensors/" + type + "/" + name;
+        std::shared_ptr<sdbusplus::asio::dbus_interface> sensor =
+            server.add_interface(path, "xyz.openbmc_project.Sensor.Value");
+        sensor->register_property("Value", value);
+        sensor->register_property("MinValue", min);
+        sensor->register_property("MaxValue", max);
+        sensor->register_property("Scale", int64_t(0));
+        sensor->initialize();
+        std::shared_ptr<sdbusplus::asio::dbus_interface> warning =
+            server.add_interface(
+                path, "xyz.openbmc_project.Sensor.Threshold.Warning");
+        warning->register_property("WarningHigh", max * 0.8);
+        warning->register_property("WarningLow", min);
+        warning->initialize();
+        std::shared_ptr<sdbusplus::asio::dbus_interface> critical =
+            server.add_interface(
+                path, "xyz.openbmc_project.Sensor.Threshold.Critical");
+        critical->register_property("CriticalHigh", max * 0.9);
+        critical->register_property("CriticalLow", min);
+        critical->initialize();
+        interfaces.insert(interfaces.end(), {sensor, warning, critical});
+        mapper.add({path,
+                    service,
+                    {"xyz.openbmc_project.Sensor.Value",
+                     "xyz.openbmc_project.Sensor.Threshold.Warning",
+                     "xyz.openbmc_project.Sensor.Threshold.Critical"}});
+    }
+
+    void addLogEntry(sdbusplus::asio::object_server& server, uint32_t id,
+                     uint64_t timestamp)
+    {
+        const std::string path =
+            "/xyz/openbmc_project/logging/entry/" + std::to_string(id);
+        std::shared_ptr<sdbusplus::asio::dbus_interface> entry =
+            server.add_interface(path, "xyz.openbmc_project.Logging.Entry");
+        entry->register_property("Id", id);
+        entry->register_property("Timestamp", timestamp);
+        entry->register_property(
+            "Severity",
+            std::string(id % 10 == 0
+                            ? "xyz.openbmc_project.Logging.Entry.Level.Error"
+                            : "xyz.openbmc_project.Logging.Entry.Level."
+                              "Information"));
+        entry->register_property(
+            "Message", "Processor " + std::to_string(id % 2) +
+                           " temperature sensor crossed a threshold");
+        entry->register_property(
+            "AdditionalData",
+            std::vector<std::string>{"_PID=" + std::to_string(1000 + id)});
+        entry->register_property("Resolved", false);
+        entry->initialize();
+        interfaces.push_back(entry);
+        mapper.add(
+            {path, "xyz.openbmc_project.Logging",
+             {"xyz.openbmc_project.Logging.Entry"}});
+    }
+
+    MockMapper mapper;
+    std::vector<std::shared_ptr<sdbusplus::asio::connection>> connections;
+    std::vector<std::unique_ptr<sdbusplus::asio::object_server>> servers;
+    std::vector<std::unique_ptr<sdbusplus::server::manager::manager>>
+        managers;
+    std::vector<std::shared_ptr<sdbusplus::asio::dbus_interface>> interfaces;
+};
+
+struct Scenario
+{
+    std::string name;
+    crow::load_generator::Target target;
+};
+
+// VmRSS and VmHWM, in kB
+std::pair<uint64_t, uint64_t> readRss()
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    uint64_t rss = 0;
+    uint64_t peak = 0;
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, 6, "VmRSS:") == 0)
+        {
+            rss = std::strtoull(line.c_str() + 6, nullptr, 10);
+        }
+        else if (line.compare(0, 6, "VmHWM:") == 0)
+        {
+            peak = std::strtoull(line.c_str() + 6, nullptr, 10);
+        }
+    }
+    return {rss, peak};
+}
+
+// Waits for the server to take connections
+bool waitForServer(uint16_t port)
+{
+    boost::asio::io_service io;
+    for (int attempt = 0; attempt < 100; attempt++)
+    {
+        boost::asio::ip::tcp::socket socket(io);
+        boost::system::error_code ec;
+        socket.connect(
+            boost::asio::ip::tcp::endpoint(
+                boost::asio::ip::address::from_string("127.0.0.1"), port),
+            ec);
+        if (!ec)
+        {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+void report(const std::string& scenario, const char* mode,
+            const crow::load_generator::Options& options,
+            const crow::load_generator::Result& result, std::ostream* json)
+{
+    std::pair<uint64_t, uint64_t> rss = readRss();
+    const crow::load_generator::LatencyHistogram& latency = result.latency;
+    std::cout << std::left << std::setw(14) << scenario << std::setw(11)
+              << mode << std::right << std::setw(6) << options.connections
+              << std::setw(10) << result.requests << std::setw(8)
+              << result.errors << std::fixed << std::setprecision(1)
+              << std::setw(11) << result.requestsPerSecond() << std::setw(10)
+              << latency.percentile(0.5).count() << std::setw(10)
+              << latency.percentile(0.99).count() << std::setw(10)
+              << latency.percentile(0.999).count() << std::setw(10)
+              << rss.first << "\n";
+    if (json != nullptr)
+    {
+        nlohmann::json line = {
+            {"scenario", scenario},
+            {"mode", mode},
+            {"connections", options.connections},
+            {"seconds", std::chrono::duration<double>(result.elapsed).count()},
+            {"requests", result.requests},
+            {"errors", result.errors},
+            {"requestsPerSecond", result.requestsPerSecond()},
+            {"p50Us", latency.percentile(0.5).count()},
+            {"p99Us", latency.percentile(0.99).count()},
+            {"p999Us", latency.percentile(0.999).count()},
+            {"maxUs", latency.max().count()},
+            {"rssKb", rss.first},
+            {"peakRssKb", rss.second},
+            {"time", std::chrono::duration_cast<std::chrono::seconds>(
+                         std::chrono::system_clock::now().time_since_epoch())
+                         .count()}};
+        *json << line.dump() << "\n";
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    crow::load_generator::Options options;
+    options.port = 18081;
+    std::string modes = "both";
+    std::vector<std::string> selected;
+    std::string credentials;
+    std::string staticUrl = "/";
+    std::string jsonPath;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            std::cerr << "Missing value for " << arg << "\n";
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "-c")
+        {
+            options.connections =
+                static_cast<size_t>(std::max(std::atoi(value.c_str()), 1));
+        }
+        else if (arg == "-d")
+        {
+            options.duration =
+                std::chrono::seconds(std::max(std::atoi(value.c_str()), 1));
+        }
+        else if (arg == "-m")
+        {
+            modes = value;
+        }
+        else if (arg == "-s")
+        {
+            selected.push_back(value);
+        }
+        else if (arg == "-u")
+        {
+            credentials = value;
+        }
+        else if (arg == "-a")
+        {
+            staticUrl = value;
+        }
+        else if (arg == "-p")
+        {
+            options.port = static_cast<uint16_t>(std::atoi(value.c_str()));
+        }
+        else if (arg == "-j")
+        {
+            jsonPath = value;
+        }
+        else
+        {
+            std::cerr << "Unknown option " << arg << "\n";
+            return 1;
+        }
+    }
+    if (modes != "keepalive" && modes != "close" && modes != "both")
+    {
+        std::cerr << "-m takes keepalive, close or both\n";
+        return 1;
+    }
+    crow::logger::setLogLevel(crow::LogLevel::Critical);
+
+    boost::asio::io_service mockIo;
+    MockServices mocks;
+    if (!mocks.start(mockIo))
+    {
+        std::cerr << "Can't connect to the user bus; run webbench under "
+                     "dbus-run-session\n";
+        return 1;
+    }
+    std::thread mockThread([&mockIo] { mockIo.run(); });
+
+    // Set up as src/webserver_main.cpp does, without TLS
+    auto io = std::make_shared<boost::asio::io_service>();
+    CrowApp app(io);
+    crow::redfish::requestRoutes(app);
+    crow::dbus_monitor::requestRoutes(app);
+    crow::image_upload::requestRoutes(app);
+    crow::openbmc_mapper::requestRoutes(app);
+    crow::server_metrics::requestRoutes(app);
+    crow::token_authorization::requestRoutes(app);
+    crow::webassets::requestRoutes(app);
+    crow::token_authorization::whitelist().build(crow::webassets::routes);
+    app.bindaddr("127.0.0.1").port(options.port);
+#ifdef BMCWEB_ENABLE_IO_THREAD_POOL
+    app.workerThreads(std::thread::hardware_concurrency());
+#endif
+
+    crow::connections::systemBus = connectUserBus(*io);
+    crow::connections::mapperCache().start(*crow::connections::systemBus, *io);
+    crow::connections::introspectionCache().start(
+        *crow::connections::systemBus, *io);
+    crow::connections::signalDispatcher().start(*crow::connections::systemBus);
+    crow::token_authorization::basicAuthCache().start();
+    redfish::userPrivilegeStore().start(*crow::connections::systemBus);
+    redfish::metricSampler().start(*io);
+    crow::persistent_data::SessionStore::getInstance().startExpiryTimer(*io);
+    app.getMiddleware<crow::persistent_data::Middleware>().startWriter(*io);
+    redfish::RedfishService redfish(app);
+    app.run();
+
+    // The session store belongs to the handler thread
+    std::promise<std::string> token;
+    io->post([&token] {
+        token.set_value(crow::persistent_data::SessionStore::getInstance()
+                            .generateUserSession(benchUser)
+                            ->sessionToken);
+    });
+    std::thread serverThread([io] { io->run(); });
+    const std::string authToken = token.get_future().get();
+
+    std::vector<Scenario> scenarios;
+    scenarios.push_back({"service_root", {}});
+    scenarios.back().target.target = "/redfish/v1/";
+    scenarios.push_back({"thermal", {}});
+    scenarios.back().target.target = "/redfish/v1/Chassis/1/Thermal";
+    scenarios.back().target.headers = {{"X-Auth-Token", authToken}};
+    scenarios.push_back({"sel_page", {}});
+    scenarios.back().target.target =
+        "/redfish/v1/Systems/1/LogServices/SEL/Entries?$top=50";
+    scenarios.back().target.headers = {{"X-Auth-Token", authToken}};
+    scenarios.push_back({"static", {}});
+    scenarios.back().target.target = staticUrl;
+    size_t colon = credentials.find(':');
+    if (colon != std::string::npos)
+    {
+        scenarios.push_back({"login", {}});
+        scenarios.back().target.method = boost::beast::http::verb::post;
+        scenarios.back().target.target = "/login";
+        scenarios.back().target.headers = {
+            {"Content-Type", "application/json"}};
+        scenarios.back().target.body =
+            nlohmann::json{{"username", credentials.substr(0, colon)},
+                           {"password", credentials.substr(colon + 1)}}
+                .dump();
+    }
+
+    std::unique_ptr<std::ofstream> json;
+    if (!jsonPath.empty())
+    {
+        json = std::make_unique<std::ofstream>(jsonPath, std::ios::app);
+    }
+    int status = 0;
+    if (!waitForServer(options.port))
+    {
+        std::cerr << "The server didn't start on port " << options.port
+                  << "\n";
+        status = 1;
+    }
+    else
+    {
+        std::cout << std::left << std::setw(14) << "scenario" << std::setw(11)
+                  << "mode" << std::right << std::setw(6) << "conns"
+                  << std::setw(10) << "requests" << std::setw(8) << "errors"
+                  << std::setw(11) << "req/s" << std::setw(10) << "p50 us"
+                  << std::setw(10) << "p99 us" << std::setw(10) << "p999 us"
+                  << std::setw(10) << "rss kB"
+                  << "\n";
+    }
+    for (const Scenario& scenario : scenarios)
+    {
+        if (status != 0 ||
+            (!selected.empty() &&
+             std::find(selected.begin(), selected.end(), scenario.name) ==
+                 selected.end()))
+        {
+            continue;
+        }
+        for (bool keepAlive : {true, false})
+        {
+            if (modes != "both" && (modes == "close") == keepAlive)
+            {
+                continue;
+            }
+            options.keepAlive = keepAlive;
+            // Fills the caches the first requests would otherwise fill
+            crow::load_generator::Options warmUp = options;
+            warmUp.duration = std::chrono::seconds(1);
+            crow::load_generator::run(warmUp, scenario.target);
+            report(scenario.name, keepAlive ? "keepalive" : "close", options,
+                   crow::load_generator::run(options, scenario.target),
+                   json.get());
+        }
+    }
+
+    app.stop();
+    serverThread.join();
+    crow::persistent_data::SessionStore::getInstance().stopExpiryTimer();
+    app.getMiddleware<crow::persistent_data::Middleware>().stopWriter();
+    pamWorkerPool().stop();
+    redfish::metricSampler().stop();
+    redfish::sensorStore().stop();
+    redfish::systemSummary().stop();
+    redfish::inventoryStore().stop();
+    redfish::networkSnapshot().stop();
+    redfish::eventDispatcher().stop();
+    redfish::selEntryIndex().stop();
+    redfish::biosEntryIndex().stop();
+    redfish::taskStore().stop();
+    redfish::userPrivilegeStore().stop();
+    crow::connections::mapperCache().stop();
+    crow::connections::introspectionCache().stop();
+    crow::connections::signalDispatcher().stop();
+    crow::token_authorization::basicAuthCache().stop();
+    crow::connections::systemBus.reset();
+    mockIo.stop();
+    mockThread.join();
+    mocks.stop();
+    return status;
+}
@@ -5,6 +5,7 @@
 #include <boost/asio.hpp>
 #include <dbus_monitor.hpp>
 #include <dbus_singleton.hpp>
+#include <dbus_utility.hpp>
 #include <image_upload.hpp>
 #include <memory>
 #include <openbmc_dbus_rest.hpp>
@@ -15,8 +16,12 @@
 #include <sdbusplus/bus.hpp>
 #include <sdbusplus/server.hpp>
 #include <security_headers_middleware.hpp>
+#include <server_metrics.hpp>
+#include <signal_dispatcher.hpp>
 #include <ssl_key_handler.hpp>
+#include <startup_timer.hpp>
 #include <string>
+#include <thread>
 #include <token_authorization_middleware.hpp>
 #include <web_kvm.hpp>
 #include <webassets.hpp>
@@ -27,26 +32,39 @@ constexpr int defaultPort = 18080;
 template <typename... Middlewares>
 void setupSocket(crow::Crow<Middlewares...>& app)
 {
-    int listenFd = sd_listen_fds(0);
-    if (1 == listenFd)
+    // systemd may pass a TCP socket for the network, a Unix socket for
+    // clients on the BMC itself, or both
+    int listenFds = sd_listen_fds(0);
+    bool haveInet = false;
+    bool haveLocal = false;
+    if (listenFds > 0)
     {
         BMCWEB_LOG_INFO << "attempting systemd socket activation";
-        if (sd_is_socket_inet(SD_LISTEN_FDS_START, AF_UNSPEC, SOCK_STREAM, 1,
-                              0))
+    }
+    for (int fd = SD_LISTEN_FDS_START; fd < SD_LISTEN_FDS_START + listenFds;
+         fd++)
+    {
+        if (!haveInet &&
+            sd_is_socket_inet(fd, AF_UNSPEC, SOCK_STREAM, 1, 0) > 0)
+        {
+            BMCWEB_LOG_INFO << "Starting webserver on socket handle " << fd;
+            app.socket(fd);
+            haveInet = true;
+        }
+        else if (!haveLocal && sd_is_socket_unix(fd, SOCK_STREAM, 1, nullptr,
+                                                 0) > 0)
         {
-            BMCWEB_LOG_INFO << "Starting webserver on socket handle "
-                            << SD_LISTEN_FDS_START;
-            app.socket(SD_LISTEN_FDS_START);
+            BMCWEB_LOG_INFO << "Serving local clients on socket handle "
+                            << fd;
+            app.localSocket(fd);
+            haveLocal = true;
         }
         else
         {
-            BMCWEB_LOG_INFO
-                << "bad incoming socket, starting webserver on port "
-                << defaultPort;
-            app.port(defaultPort);
+            BMCWEB_LOG_INFO << "bad incoming socket " << fd << ", ignoring it";
         }
     }
-    else
+    if (!haveInet)
     {
         BMCWEB_LOG_INFO << "Starting webserver on port " << defaultPort;
         app.port(defaultPort);
@@ -55,27 +73,41 @@ void setupSocket(crow::Crow<Middlewares...>& app)
 
 int main(int argc, char** argv)
 {
-    crow::logger::setLogLevel(crow::LogLevel::DEBUG);
+    crow::startupTimer();
+    crow::LogLevel logLevel = crow::LogLevel::Info;
+    const char* logLevelName = getenv("BMCWEB_LOG_LEVEL");
+    if (logLevelName != nullptr && !crow::parseLogLevel(logLevelName, logLevel))
+    {
+        std::cerr << "Unknown BMCWEB_LOG_LEVEL " << logLevelName << "\n";
+    }
+    crow::logger::setLogLevel(logLevel);
+    crow::asyncLogHandler().start();
+    crow::logger::setHandler(&crow::asyncLogHandler());
+    crow::startupTimer().phase("logging");
 
     auto io = std::make_shared<boost::asio::io_service>();
     CrowApp app(io);
 
+    // For example BMCWEB_KEEPALIVE=idle=30,requests=1000
+    crow::KeepAlivePolicy keepAlive;
+    const char* keepAliveSpec = getenv("BMCWEB_KEEPALIVE");
+    if (keepAliveSpec != nullptr &&
+        !crow::parseKeepAlivePolicy(keepAliveSpec, keepAlive))
+    {
+        BMCWEB_LOG_ERROR << "Invalid BMCWEB_KEEPALIVE " << keepAliveSpec;
+    }
+    app.keepAlivePolicy(keepAlive);
+
 #ifdef BMCWEB_ENABLE_SSL
     std::string sslPemFile("server.pem");
     std::cout << "Building SSL Context\n";
 
-    ensuressl::ensureOpensslKeyPresentAndValid(sslPemFile);
+    // Generates a missing or invalid certificate in the background
     std::cout << "SSL Enabled\n";
     auto sslContext = ensuressl::getSslContext(sslPemFile);
     app.ssl(std::move(sslContext));
+    crow::startupTimer().phase("ssl");
 #endif
-    // Static assets need to be initialized before Authorization, because auth
-    // needs to build the whitelist from the static routes
-
-#ifdef BMCWEB_ENABLE_STATIC_HOSTING
-    crow::webassets::requestRoutes(app);
-#endif
-
 #ifdef BMCWEB_ENABLE_KVM
     crow::kvm::requestRoutes(app);
 #endif
@@ -90,17 +122,98 @@ int main(int argc, char** argv)
     crow::openbmc_mapper::requestRoutes(app);
 #endif
 
+    crow::server_metrics::requestRoutes(app);
     crow::token_authorization::requestRoutes(app);
 
+    // Static assets take every path no other route does, so they go last
+#ifdef BMCWEB_ENABLE_STATIC_HOSTING
+    crow::webassets::requestRoutes(app);
+#endif
+    // Authentication lets the static files through
+    crow::token_authorization::whitelist().build(crow::webassets::routes);
+    crow::startupTimer().phase("routes");
+
     BMCWEB_LOG_INFO << "bmcweb (" << __DATE__ << ": " << __TIME__ << ')';
     setupSocket(app);
+#ifdef BMCWEB_ENABLE_IO_THREAD_POOL
+    app.workerThreads(std::thread::hardware_concurrency());
+#endif
 
     crow::connections::systemBus =
         std::make_shared<sdbusplus::asio::connection>(*io);
+    crow::startupTimer().phase("dbus connection");
+    crow::connections::mapperCache().start(*crow::connections::systemBus, *io);
+    crow::connections::introspectionCache().start(
+        *crow::connections::systemBus, *io);
+    crow::connections::signalDispatcher().start(*crow::connections::systemBus);
+    redfish::resourceCache().start();
+    crow::token_authorization::basicAuthCache().start();
+    redfish::userPrivilegeStore().start(*crow::connections::systemBus);
+    redfish::metricSampler().start(*io);
+    crow::persistent_data::SessionStore::getInstance().startExpiryTimer(*io);
+    app.getMiddleware<crow::persistent_data::Middleware>().startWriter(*io);
+    crow::startupTimer().phase("dbus subscriptions");
+    // Before the Redfish routes, which depend on whether there are
+    // satellites
+    redfish::aggregator().start(*io);
+    // Loads the schema store on a thread of its own
     redfish::RedfishService redfish(app);
+    crow::startupTimer().phase("redfish");
 
     app.run();
+    // The first thing the loop does; connections waiting in the listen
+    // queue are accepted right after
+    io->post([] { crow::startupTimer().ready(); });
     io->run();
 
+#ifdef BMCWEB_ENABLE_SSL
+    BMCWEB_LOG_INFO << "TLS handshakes: "
+                    << crow::tlsHandshakeCounters().full << " full, "
+                    << crow::tlsHandshakeCounters().resumed << " resumed";
+    ensuressl::certificateGenerator().stop();
+#endif
+    BMCWEB_LOG_INFO << "Websocket messages: "
+                    << crow::websocket::queueCounters().queued << " queued, "
+                    << crow::websocket::queueCounters().coalesced
+                    << " coalesced, "
+                    << crow::websocket::queueCounters().batched << " batched, "
+                    << crow::websocket::queueCounters().dropped << " dropped, "
+                    << crow::websocket::queueCounters().disconnected
+                    << " clients disconnected";
+#ifdef BMCWEB_ENABLE_KVM
+    if (ast_video::decodeStats().frames != 0)
+    {
+        BMCWEB_LOG_INFO << "KVM frames: " << ast_video::decodeStats().frames
+                        << " decoded, "
+                        << ast_video::decodeStats().totalMicroseconds /
+                               ast_video::decodeStats().frames
+                        << " us average, "
+                        << ast_video::decodeStats().maxMicroseconds
+                        << " us max";
+    }
+    ast_video::bandWorkerPool().stop();
+    crow::kvm::passthroughViewers().stop();
+#endif
+    pamWorkerPool().stop();
+    crow::persistent_data::SessionStore::getInstance().stopExpiryTimer();
+    app.getMiddleware<crow::persistent_data::Middleware>().stopWriter();
+    redfish::metricSampler().stop();
+    redfish::aggregator().stop();
+    redfish::sensorStore().stop();
+    redfish::systemSummary().stop();
+    redfish::inventoryStore().stop();
+    redfish::networkSnapshot().stop();
+    redfish::eventDispatcher().stop();
+    redfish::selEntryIndex().stop();
+    redfish::biosEntryIndex().stop();
+    redfish::taskStore().stop();
+    redfish::schemaStoreLoader().stop();
+    redfish::userPrivilegeStore().stop();
+    crow::connections::mapperCache().stop();
+    crow::connections::introspectionCache().stop();
+    redfish::resourceCache().stop();
+    crow::connections::signalDispatcher().stop();
+    crow::token_authorization::basicAuthCache().stop();
     crow::connections::systemBus.reset();
+    crow::asyncLogHandler().stop();
 }
@@ -0,0 +1,167 @@
+#include <crow/websocket_queue.h>
+
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using crow::websocket::OutboundMessage;
+using crow::websocket::OutboundQueue;
+using crow::websocket::OverflowPolicy;
+using crow::websocket::QueueLimits;
+
+namespace
+{
+OutboundMessage message(const std::string& payload,
+                        const std::string& key = std::string())
+{
+    OutboundMessage m;
+    m.payload = std::make_shared<const std::string>(payload);
+    m.key = key;
+    return m;
+}
+
+// Writes out everything queued, in order
+std::vector<std::string> drain(OutboundQueue& queue)
+{
+    std::vector<std::string> written;
+    const OutboundMessage* m;
+    while ((m = queue.startWrite()) != nullptr)
+    {
+        written.push_back(*m->payload);
+        queue.finishWrite();
+    }
+    return written;
+}
+} // namespace
+
+TEST(OutboundQueue, WritesInOrderOneAtATime)
+{
+    OutboundQueue queue;
+    // Past the initial capacity of the ring
+    for (int i = 0; i < 20; i++)
+    {
+        ASSERT_TRUE(queue.push(message(std::to_string(i))));
+    }
+    const OutboundMessage* m = queue.startWrite();
+    ASSERT_NE(m, nullptr);
+    EXPECT_EQ(*m->payload, "0");
+    EXPECT_EQ(queue.startWrite(), nullptr);
+    queue.finishWrite();
+
+    std::vector<std::string> written = drain(queue);
+    ASSERT_EQ(written.size(), 19u);
+    EXPECT_EQ(written.front(), "1");
+    EXPECT_EQ(written.back(), "19");
+    EXPECT_EQ(queue.bytes(), 0u);
+}
+
+TEST(OutboundQueue, DropOldestKeepsUnderCap)
+{
+    OutboundQueue queue(QueueLimits{10, OverflowPolicy::dropOldest});
+    ASSERT_TRUE(queue.push(message("aaaa")));
+    // Being written, so it neither counts nor gets dropped
+    ASSERT_NE(queue.startWrite(), nullptr);
+    ASSERT_TRUE(queue.push(message("bbbb")));
+    ASSERT_TRUE(queue.push(message("cccc")));
+    ASSERT_TRUE(queue.push(message("dddd")));
+    EXPECT_EQ(queue.bytes(), 8u);
+    // Too big to ever fit
+    ASSERT_TRUE(queue.push(message("eeeeeeeeeeee")));
+    queue.finishWrite();
+
+    EXPECT_THAT(drain(queue), testing::ElementsAre("cccc", "dddd"));
+}
+
+TEST(OutboundQueue, CoalesceReplacesQueuedUpdate)
+{
+    OutboundQueue queue(QueueLimits{1024, OverflowPolicy::coalesce});
+    ASSERT_TRUE(queue.push(message("a=1", "a")));
+    ASSERT_TRUE(queue.push(message("b=1", "b")));
+    ASSERT_TRUE(queue.push(message("event")));
+    ASSERT_TRUE(queue.push(message("a=22", "a")));
+    EXPECT_EQ(queue.size(), 3u);
+    EXPECT_EQ(queue.bytes(), 12u);
+
+    // Once a is being written, a newer a goes behind it
+    const OutboundMessage* m = queue.startWrite();
+    ASSERT_NE(m, nullptr);
+    EXPECT_EQ(*m->payload, "a=22");
+    queue.finishWrite();
+    ASSERT_TRUE(queue.push(message("a=3", "a")));
+
+    EXPECT_THAT(drain(queue), testing::ElementsAre("b=1", "event", "a=3"));
+}
+
+TEST(OutboundQueue, DisconnectRefusesOverflow)
+{
+    OutboundQueue queue(QueueLimits{8, OverflowPolicy::disconnect});
+    ASSERT_TRUE(queue.push(message("aaaa")));
+    ASSERT_TRUE(queue.push(message("bbbb")));
+    EXPECT_FALSE(queue.push(message("c")));
+    EXPECT_THAT(drain(queue), testing::ElementsAre("aaaa", "bbbb"));
+}
+
+TEST(OutboundQueue, BatchesPendingMessages)
+{
+    QueueLimits limits;
+    limits.batchBytes = 8;
+    OutboundQueue queue(limits);
+    ASSERT_TRUE(queue.push(message("ab")));
+    ASSERT_TRUE(queue.push(message("cd")));
+    ASSERT_TRUE(queue.push(message("ef")));
+    ASSERT_TRUE(queue.push(message("ghijk")));
+    OutboundMessage binary = message("xy");
+    binary.binary = true;
+    ASSERT_TRUE(queue.push(std::move(binary)));
+    ASSERT_TRUE(queue.push(message("lm")));
+
+    // Stops at the batch size, and at a change of frame type
+    EXPECT_THAT(drain(queue),
+                testing::ElementsAre("abcdef", "ghijk", "xy", "lm"));
+    EXPECT_EQ(queue.bytes(), 0u);
+}
+
+TEST(OutboundQueue, CountsAndKeepsScatteredMessages)
+{
+    QueueLimits limits;
+    limits.batchBytes = 64;
+    OutboundQueue queue(limits);
+    auto owner = std::make_shared<const std::string>("headerpixels");
+    OutboundMessage scattered;
+    scattered.buffers.emplace_back(owner->data(), 6);
+    scattered.buffers.emplace_back(owner->data() + 6, 6);
+    scattered.owner = owner;
+    ASSERT_TRUE(queue.push(message("ab")));
+    ASSERT_TRUE(queue.push(std::move(scattered)));
+    ASSERT_TRUE(queue.push(message("cd")));
+    EXPECT_EQ(queue.bytes(), 16u);
+
+    // A message of several buffers is written on its own, as it came
+    const OutboundMessage* m = queue.startWrite();
+    ASSERT_NE(m, nullptr);
+    EXPECT_EQ(*m->payload, "ab");
+    queue.finishWrite();
+    m = queue.startWrite();
+    ASSERT_NE(m, nullptr);
+    EXPECT_EQ(m->payload, nullptr);
+    EXPECT_EQ(m->size(), 12u);
+    EXPECT_EQ(m->buffers.size(), 2u);
+    queue.finishWrite();
+    EXPECT_THAT(drain(queue), testing::ElementsAre("cd"));
+    EXPECT_EQ(queue.bytes(), 0u);
+}
+
+TEST(OutboundQueue, PendingBytesCountsTheWrite)
+{
+    OutboundQueue queue;
+    ASSERT_TRUE(queue.push(message("abc")));
+    ASSERT_TRUE(queue.push(message("de")));
+    EXPECT_EQ(queue.pendingBytes(), 5u);
+    ASSERT_NE(queue.startWrite(), nullptr);
+    EXPECT_EQ(queue.bytes(), 2u);
+    EXPECT_EQ(queue.pendingBytes(), 5u);
+    queue.finishWrite();
+    EXPECT_EQ(queue.pendingBytes(), 2u);
+}
@@ -0,0 +1,96 @@
+#include <crow/app.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+
+// A client that has upgraded /ws, and reads nothing until it is told to
+struct Client
+{
+    Client(boost::asio::io_service& io, uint16_t port) : ws(io)
+    {
+        ws.next_layer().connect(boost::asio::ip::tcp::endpoint(
+            boost::asio::ip::address::from_string("127.0.0.1"), port));
+        ws.handshake("localhost", "/ws");
+        ws.control_callback([this](boost::beast::websocket::frame_type kind,
+                                   boost::beast::string_view) {
+            if (kind == boost::beast::websocket::frame_type::ping)
+            {
+                pings++;
+            }
+        });
+    }
+
+    // Answers pings for as long as the io_service runs
+    void read()
+    {
+        ws.async_read(buffer, [this](const boost::system::error_code& ec,
+                                     std::size_t) {
+            if (!ec)
+            {
+                buffer.consume(buffer.size());
+                read();
+            }
+        });
+    }
+
+    boost::beast::websocket::stream<boost::asio::ip::tcp::socket> ws;
+    boost::beast::flat_buffer buffer;
+    int pings = 0;
+};
+
+bool waitFor(const std::atomic<int>& value, int expected)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (value != expected && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return value == expected;
+}
+
+} // namespace
+
+// Tests that a client that answers pings is kept, and one that doesn't is
+// cut off once the pong is late
+TEST(Websocket, PingsClients)
+{
+    constexpr uint16_t port = 45471;
+    crow::SimpleApp app;
+    std::atomic<int> opened{0};
+    std::atomic<int> closed{0};
+    BMCWEB_ROUTE(app, "/ws")
+        .websocket()
+        .ping(std::chrono::milliseconds(200), std::chrono::milliseconds(300))
+        .onopen([&opened](crow::websocket::Connection&) { opened++; })
+        .onclose([&closed](crow::websocket::Connection&, const std::string&) {
+            closed++;
+        });
+    app.validate();
+    auto io = std::make_shared<boost::asio::io_service>();
+    crow::Server<crow::SimpleApp> server(&app, "127.0.0.1", port, nullptr,
+                                         nullptr, io);
+    server.run();
+    std::thread serverThread([io] { io->run(); });
+
+    boost::asio::io_service clientIo;
+    Client silent(clientIo, port);
+    ASSERT_TRUE(waitFor(opened, 1));
+    // Never reads, so the ping goes unanswered
+    EXPECT_TRUE(waitFor(closed, 1));
+
+    Client answering(clientIo, port);
+    ASSERT_TRUE(waitFor(opened, 2));
+    answering.read();
+    clientIo.run_for(std::chrono::milliseconds(1500));
+    EXPECT_GE(answering.pings, 3);
+    EXPECT_EQ(closed, 1);
+
+    server.stop();
+    serverThread.join();
+}